@@ -167,6 +167,7 @@ app_parse_args(int argc, char **argv)
 		{"acl", 0, 0, 0},
 		{"lpm", 0, 0, 0},
 		{"lpm-ipv6", 0, 0, 0},
+		{"run-spec", 0, 0, 0},
 		{NULL, 0, 0, 0}
 	};
 	uint32_t lcores[3], n_lcores, lcore_id, pipeline_type_provided;
@@ -201,6 +202,7 @@ app_parse_args(int argc, char **argv)
 	argvopt = argv;
 
 	app.pipeline_type = e_APP_PIPELINE_HASH_KEY16_LRU;
+	app.pipeline_run_spec = 0;
 	pipeline_type_provided = 0;
 
 	while ((opt = getopt_long(argc, argvopt, "p:",
@@ -214,6 +216,11 @@ app_parse_args(int argc, char **argv)
 			break;
 
 		case 0: /* long options */
+			if (!strcmp(lgopts[option_index].name, "run-spec")) {
+				app.pipeline_run_spec = 1;
+				break;
+			}
+
 			if (!pipeline_type_provided) {
 				uint32_t i;
 
@@ -85,6 +85,7 @@ struct app_params {
 
 	/* App behavior */
 	uint32_t pipeline_type;
+	uint32_t pipeline_run_spec;
 } __rte_cache_aligned;
 
 extern struct app_params app;
@@ -123,7 +124,10 @@ void app_main_loop_rx(void);
 void app_main_loop_rx_metadata(void);
 uint64_t test_hash(void *key, uint32_t key_size, uint64_t seed);
 
+struct rte_pipeline;
+
 void app_main_loop_worker(void);
+void app_main_loop_pipeline_run(struct rte_pipeline *p);
 void app_main_loop_worker_pipeline_stub(void);
 void app_main_loop_worker_pipeline_hash(void);
 void app_main_loop_worker_pipeline_acl(void);
@@ -137,6 +141,10 @@ void app_main_loop_tx(void);
 #define APP_FLUSH 0x3FF
 #endif
 
+#ifndef APP_STATS_PERIOD
+#define APP_STATS_PERIOD 10 /* seconds */
+#endif
+
 #define APP_METADATA_OFFSET(offset) (sizeof(struct rte_mbuf) + (offset))
 
 #endif /* _MAIN_H_ */
@@ -69,6 +69,9 @@ app_main_loop_worker_pipeline_lpm_ipv6(void) {
 	if (p == NULL)
 		rte_panic("Unable to configure the pipeline\n");
 
+	if (app.pipeline_run_spec && rte_pipeline_run_spec_set(p, 0))
+		rte_panic("Unable to set the pipeline run spec\n");
+
 	/* Input port configuration */
 	for (i = 0; i < app.n_ports; i++) {
 		struct rte_port_ring_reader_params port_ring_params = {
@@ -186,15 +189,5 @@ app_main_loop_worker_pipeline_lpm_ipv6(void) {
 		rte_panic("Pipeline consistency check failed\n");
 
 	/* Run-time */
-#if APP_FLUSH == 0
-	for ( ; ; )
-		rte_pipeline_run(p);
-#else
-	for (i = 0; ; i++) {
-		rte_pipeline_run(p);
-
-		if ((i & APP_FLUSH) == 0)
-			rte_pipeline_flush(p);
-	}
-#endif
+	app_main_loop_pipeline_run(p);
 }
@@ -71,6 +71,7 @@
 #include <rte_lpm.h>
 #include <rte_lpm6.h>
 #include <rte_malloc.h>
+#include <rte_pipeline.h>
 
 #include "main.h"
 
@@ -135,6 +136,48 @@ app_main_loop_worker(void) {
 	}
 }
 
+void
+app_main_loop_pipeline_run(struct rte_pipeline *p) {
+	uint64_t n_pkts = 0, n_cycles = 0, time_next;
+	uint32_t i;
+
+	RTE_LOG(INFO, USER1, "Core %u is running the pipeline (%s run)\n",
+		rte_lcore_id(), app.pipeline_run_spec ? "specialized" : "generic");
+
+	time_next = rte_rdtsc() + APP_STATS_PERIOD * rte_get_tsc_hz();
+
+	for (i = 0; ; i++) {
+		uint64_t time_start, time_end;
+		int n;
+
+		time_start = rte_rdtsc();
+		n = rte_pipeline_run(p);
+		time_end = rte_rdtsc();
+
+		if (n > 0) {
+			n_pkts += n;
+			n_cycles += time_end - time_start;
+		}
+
+#if APP_FLUSH != 0
+		if ((i & APP_FLUSH) == 0)
+			rte_pipeline_flush(p);
+#endif
+
+		if (time_end >= time_next) {
+			if (n_pkts)
+				RTE_LOG(INFO, USER1, "Pipeline run: %" PRIu64
+					" packets, %.1f cycles/packet\n",
+					n_pkts, (double) n_cycles / n_pkts);
+
+			n_pkts = 0;
+			n_cycles = 0;
+			time_next = time_end +
+				APP_STATS_PERIOD * rte_get_tsc_hz();
+		}
+	}
+}
+
 void
 app_main_loop_tx(void) {
 	uint32_t i;
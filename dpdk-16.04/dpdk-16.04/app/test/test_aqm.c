@@ -0,0 +1,230 @@
+/*-
+ *   BSD LICENSE
+ *
+ *   Copyright(c) 2016 Intel Corporation. All rights reserved.
+ *   All rights reserved.
+ *
+ *   Redistribution and use in source and binary forms, with or without
+ *   modification, are permitted provided that the following conditions
+ *   are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ *     * Neither the name of Intel Corporation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *   OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <inttypes.h>
+
+#include "test.h"
+
+#include <rte_sched.h>
+#include <rte_aqm.h>
+
+/*
+ * The queue is simulated with a time unit of one byte at the port rate,
+ * as seen by the AQM algorithms when run by the hierarchical scheduler.
+ */
+#define SIM_PKT_LEN          1000     /* Time to send one packet */
+#define SIM_QSIZE            1024     /* Tail drop limit (packets) */
+#define SIM_N_PKTS           400000   /* Arrivals per run */
+
+#define PIE_QDELAY_REF       (20 * SIM_PKT_LEN)
+#define PIE_T_UPDATE         PIE_QDELAY_REF
+#define PIE_MAX_BURST        (10 * PIE_QDELAY_REF)
+#define CODEL_TARGET         (20 * SIM_PKT_LEN)
+#define CODEL_INTERVAL       (10 * CODEL_TARGET)
+#define DQ_THRESHOLD         16
+
+struct sim_result {
+	double avg_qlen;   /* Over the second half of the run */
+	double drop_rate;
+};
+
+static int
+taildrop_enqueue(void *cfg, void *data, uint32_t qlen, uint16_t qr,
+	uint64_t time)
+{
+	RTE_SET_USED(cfg);
+	RTE_SET_USED(data);
+	RTE_SET_USED(qlen);
+	RTE_SET_USED(qr);
+	RTE_SET_USED(time);
+
+	return 0;
+}
+
+/**
+ * Feed a single server queue with packets arriving every arrival_time,
+ * using f_enqueue to decide which ones are dropped.
+ */
+static void
+aqm_sim(rte_sched_aqm_enqueue_t f_enqueue, void *cfg, void *data,
+	uint32_t arrival_time, struct sim_result *res)
+{
+	uint64_t time = 0, next_departure = 0, qlen_sum = 0;
+	uint32_t qlen = 0, n_dropped = 0, i;
+	uint16_t qr = 0;
+
+	for (i = 0; i < SIM_N_PKTS; i++) {
+		time += arrival_time;
+
+		/* Packets sent since the previous arrival */
+		while (qlen != 0 && next_departure <= time) {
+			qlen--;
+			qr++;
+			next_departure += SIM_PKT_LEN;
+		}
+
+		if (f_enqueue(cfg, data, qlen, qr, time) != 0 ||
+			qlen >= SIM_QSIZE) {
+			n_dropped++;
+		} else {
+			if (qlen == 0)
+				next_departure = time + SIM_PKT_LEN;
+			qlen++;
+		}
+
+		if (i >= SIM_N_PKTS / 2)
+			qlen_sum += qlen;
+	}
+
+	res->avg_qlen = (double) qlen_sum / (SIM_N_PKTS - SIM_N_PKTS / 2);
+	res->drop_rate = (double) n_dropped / SIM_N_PKTS;
+}
+
+static void
+sim_print(const char *name, uint32_t arrival_time, struct sim_result *res)
+{
+	printf("%-9s load %3u%%: average queue %7.1f packets, "
+		"drop rate %5.2f%%\n", name,
+		SIM_PKT_LEN * 100 / arrival_time, res->avg_qlen,
+		res->drop_rate * 100.0);
+}
+
+static int
+test_aqm_invalid_parameters(void)
+{
+	struct rte_pie_config pie_cfg;
+	struct rte_codel_config codel_cfg;
+
+	TEST_ASSERT_FAIL(rte_pie_rt_data_init(NULL),
+		"rte_pie_rt_data_init should have failed\n");
+	TEST_ASSERT_FAIL(rte_pie_config_init(NULL, 1, 1, 1, 1),
+		"rte_pie_config_init should have failed\n");
+	TEST_ASSERT_FAIL(rte_pie_config_init(&pie_cfg, 0, 1, 1, 1),
+		"rte_pie_config_init accepted qdelay_ref 0\n");
+	TEST_ASSERT_FAIL(rte_pie_config_init(&pie_cfg, 1, 0, 1, 1),
+		"rte_pie_config_init accepted t_update 0\n");
+	TEST_ASSERT_FAIL(rte_pie_config_init(&pie_cfg, 1, 1, 1, 0),
+		"rte_pie_config_init accepted dq_threshold 0\n");
+
+	TEST_ASSERT_FAIL(rte_codel_rt_data_init(NULL),
+		"rte_codel_rt_data_init should have failed\n");
+	TEST_ASSERT_FAIL(rte_codel_config_init(NULL, 1, 2, 1),
+		"rte_codel_config_init should have failed\n");
+	TEST_ASSERT_FAIL(rte_codel_config_init(&codel_cfg, 0, 2, 1),
+		"rte_codel_config_init accepted target 0\n");
+	TEST_ASSERT_FAIL(rte_codel_config_init(&codel_cfg, 2, 2, 1),
+		"rte_codel_config_init accepted interval <= target\n");
+	TEST_ASSERT_FAIL(rte_codel_config_init(&codel_cfg, 1, 2, 0),
+		"rte_codel_config_init accepted dq_threshold 0\n");
+
+	return 0;
+}
+
+/**
+ * Unresponsive traffic above the queue service rate: tail drop fills the
+ * queue, while PIE and CoDel keep the queueing delay down.
+ */
+static int
+test_aqm_overload(void)
+{
+	static const uint32_t load_light = 2 * SIM_PKT_LEN;
+	static const uint32_t load_over = SIM_PKT_LEN * 10 / 11;
+	static const uint32_t load_double = SIM_PKT_LEN / 2;
+	struct rte_pie_config pie_cfg;
+	struct rte_codel_config codel_cfg;
+	struct rte_pie pie;
+	struct rte_codel codel;
+	struct sim_result res;
+
+	TEST_ASSERT_SUCCESS(rte_pie_config_init(&pie_cfg, PIE_QDELAY_REF,
+		PIE_T_UPDATE, PIE_MAX_BURST, DQ_THRESHOLD),
+		"PIE config failed\n");
+	TEST_ASSERT_SUCCESS(rte_codel_config_init(&codel_cfg, CODEL_TARGET,
+		CODEL_INTERVAL, DQ_THRESHOLD), "CoDel config failed\n");
+
+	aqm_sim(taildrop_enqueue, NULL, NULL, load_over, &res);
+	sim_print("Tail drop", load_over, &res);
+	TEST_ASSERT(res.avg_qlen > SIM_QSIZE * 9 / 10,
+		"Tail drop queue not full\n");
+
+	/* No drop at light load */
+	rte_pie_rt_data_init(&pie);
+	aqm_sim(rte_sched_aqm_pie, &pie_cfg, &pie, load_light, &res);
+	sim_print("PIE", load_light, &res);
+	TEST_ASSERT(res.drop_rate == 0, "PIE dropped at light load\n");
+
+	rte_codel_rt_data_init(&codel);
+	aqm_sim(rte_sched_aqm_codel, &codel_cfg, &codel, load_light, &res);
+	sim_print("CoDel", load_light, &res);
+	TEST_ASSERT(res.drop_rate == 0, "CoDel dropped at light load\n");
+
+	/* Queueing delay kept close to the target when overloaded */
+	rte_pie_rt_data_init(&pie);
+	aqm_sim(rte_sched_aqm_pie, &pie_cfg, &pie, load_over, &res);
+	sim_print("PIE", load_over, &res);
+	TEST_ASSERT(res.avg_qlen < 3 * PIE_QDELAY_REF / SIM_PKT_LEN,
+		"PIE queueing delay not controlled\n");
+
+	rte_pie_rt_data_init(&pie);
+	aqm_sim(rte_sched_aqm_pie, &pie_cfg, &pie, load_double, &res);
+	sim_print("PIE", load_double, &res);
+	TEST_ASSERT(res.avg_qlen < 3 * PIE_QDELAY_REF / SIM_PKT_LEN,
+		"PIE queueing delay not controlled\n");
+
+	/* Built for responsive traffic, CoDel only keeps unresponsive
+	 * traffic in a saw tooth a few times the target high */
+	rte_codel_rt_data_init(&codel);
+	aqm_sim(rte_sched_aqm_codel, &codel_cfg, &codel, load_over, &res);
+	sim_print("CoDel", load_over, &res);
+	TEST_ASSERT(res.avg_qlen < SIM_QSIZE / 4,
+		"CoDel queueing delay not controlled\n");
+
+	return 0;
+}
+
+static int
+test_aqm(void)
+{
+	if (test_aqm_invalid_parameters() < 0)
+		return -1;
+
+	return test_aqm_overload();
+}
+
+static struct test_command aqm_cmd = {
+	.command = "aqm_autotest",
+	.callback = test_aqm,
+};
+REGISTER_TEST_COMMAND(aqm_cmd);
@@ -227,6 +227,21 @@ testsuite_setup(void)
 		}
 	}
 
+	/* Create 2 OpenSSL devices if required */
+	if (gbl_cryptodev_type == RTE_CRYPTODEV_OPENSSL_PMD) {
+		nb_devs = rte_cryptodev_count_devtype(
+				RTE_CRYPTODEV_OPENSSL_PMD);
+		if (nb_devs < 2) {
+			for (i = nb_devs; i < 2; i++) {
+				TEST_ASSERT_SUCCESS(rte_eal_vdev_init(
+					CRYPTODEV_NAME_OPENSSL_PMD, NULL),
+					"Failed to create instance %u of"
+					" pmd : %s",
+					i, CRYPTODEV_NAME_OPENSSL_PMD);
+			}
+		}
+	}
+
 	/* Create 2 Snow3G devices if required */
 	if (gbl_cryptodev_type == RTE_CRYPTODEV_SNOW3G_PMD) {
 		nb_devs = rte_cryptodev_count_devtype(RTE_CRYPTODEV_SNOW3G_PMD);
@@ -2049,6 +2064,125 @@ test_AES_CBC_HMAC_AES_XCBC_decrypt_digest_verify(void)
 	return TEST_SUCCESS;
 }
 
+/* ***** AES CTR Tests ***** */
+
+/* NIST SP 800-38A, F.5.1 CTR-AES128.Encrypt */
+static uint8_t aes_ctr_key[] = {
+	0x2B, 0x7E, 0x15, 0x16, 0x28, 0xAE, 0xD2, 0xA6,
+	0xAB, 0xF7, 0x15, 0x88, 0x09, 0xCF, 0x4F, 0x3C
+};
+
+static uint8_t aes_ctr_iv[] = {
+	0xF0, 0xF1, 0xF2, 0xF3, 0xF4, 0xF5, 0xF6, 0xF7,
+	0xF8, 0xF9, 0xFA, 0xFB, 0xFC, 0xFD, 0xFE, 0xFF
+};
+
+static const uint8_t aes_ctr_plaintext[] = {
+	0x6B, 0xC1, 0xBE, 0xE2, 0x2E, 0x40, 0x9F, 0x96,
+	0xE9, 0x3D, 0x7E, 0x11, 0x73, 0x93, 0x17, 0x2A,
+	0xAE, 0x2D, 0x8A, 0x57, 0x1E, 0x03, 0xAC, 0x9C,
+	0x9E, 0xB7, 0x6F, 0xAC, 0x45, 0xAF, 0x8E, 0x51,
+	0x30, 0xC8, 0x1C, 0x46, 0xA3, 0x5C, 0xE4, 0x11,
+	0xE5, 0xFB, 0xC1, 0x19, 0x1A, 0x0A, 0x52, 0xEF,
+	0xF6, 0x9F, 0x24, 0x45, 0xDF, 0x4F, 0x9B, 0x17,
+	0xAD, 0x2B, 0x41, 0x7B, 0xE6, 0x6C, 0x37, 0x10
+};
+
+static const uint8_t aes_ctr_ciphertext[] = {
+	0x87, 0x4D, 0x61, 0x91, 0xB6, 0x20, 0xE3, 0x26,
+	0x1B, 0xEF, 0x68, 0x64, 0x99, 0x0D, 0xB6, 0xCE,
+	0x98, 0x06, 0xF6, 0x6B, 0x79, 0x70, 0xFD, 0xFF,
+	0x86, 0x17, 0x18, 0x7B, 0xB9, 0xFF, 0xFD, 0xFF,
+	0x5A, 0xE4, 0xDF, 0x3E, 0xDB, 0xD5, 0xD3, 0x5E,
+	0x5B, 0x4F, 0x09, 0x02, 0x0D, 0xB0, 0x3E, 0xAB,
+	0x1E, 0x03, 0x1D, 0xDA, 0x2F, 0xBE, 0x03, 0xD1,
+	0x79, 0x21, 0x70, 0xA0, 0xF3, 0x00, 0x9C, 0xEE
+};
+
+static int
+test_AES_CTR_cipher(enum rte_crypto_cipher_operation op,
+		const uint8_t *input, const uint8_t *output)
+{
+	struct crypto_testsuite_params *ts_params = &testsuite_params;
+	struct crypto_unittest_params *ut_params = &unittest_params;
+
+	/* Generate test mbuf data */
+	ut_params->ibuf = setup_test_string(ts_params->mbuf_pool,
+			(const char *)input, sizeof(aes_ctr_plaintext), 0);
+
+	/* Setup Cipher Parameters */
+	ut_params->cipher_xform.type = RTE_CRYPTO_SYM_XFORM_CIPHER;
+	ut_params->cipher_xform.next = NULL;
+
+	ut_params->cipher_xform.cipher.algo = RTE_CRYPTO_CIPHER_AES_CTR;
+	ut_params->cipher_xform.cipher.op = op;
+	ut_params->cipher_xform.cipher.key.data = aes_ctr_key;
+	ut_params->cipher_xform.cipher.key.length = sizeof(aes_ctr_key);
+
+	/* Create Crypto session*/
+	ut_params->sess =
+		rte_cryptodev_sym_session_create(ts_params->valid_devs[0],
+						&ut_params->cipher_xform);
+	TEST_ASSERT_NOT_NULL(ut_params->sess, "Session creation failed");
+
+	/* Generate Crypto op data structure */
+	ut_params->op = rte_crypto_op_alloc(ts_params->op_mpool,
+			RTE_CRYPTO_OP_TYPE_SYMMETRIC);
+	TEST_ASSERT_NOT_NULL(ut_params->op,
+			"Failed to allocate symmetric crypto operation struct");
+
+	/* Set crypto operation data parameters */
+	rte_crypto_op_attach_sym_session(ut_params->op, ut_params->sess);
+
+	struct rte_crypto_sym_op *sym_op = ut_params->op->sym;
+
+	/* set crypto operation source mbuf */
+	sym_op->m_src = ut_params->ibuf;
+
+	sym_op->cipher.iv.data = (uint8_t *)rte_pktmbuf_prepend(
+			ut_params->ibuf, sizeof(aes_ctr_iv));
+	TEST_ASSERT_NOT_NULL(sym_op->cipher.iv.data, "no room to prepend iv");
+	sym_op->cipher.iv.phys_addr = rte_pktmbuf_mtophys(ut_params->ibuf);
+	sym_op->cipher.iv.length = sizeof(aes_ctr_iv);
+
+	rte_memcpy(sym_op->cipher.iv.data, aes_ctr_iv, sizeof(aes_ctr_iv));
+
+	sym_op->cipher.data.offset = sizeof(aes_ctr_iv);
+	sym_op->cipher.data.length = sizeof(aes_ctr_plaintext);
+
+	/* Process crypto operation */
+	TEST_ASSERT_NOT_NULL(process_crypto_request(ts_params->valid_devs[0],
+			ut_params->op), "failed to process sym crypto op");
+
+	TEST_ASSERT_EQUAL(ut_params->op->status, RTE_CRYPTO_OP_STATUS_SUCCESS,
+			"crypto op processing failed");
+
+	ut_params->obuf = ut_params->op->sym->m_src;
+
+	/* Validate obuf */
+	TEST_ASSERT_BUFFERS_ARE_EQUAL(
+			rte_pktmbuf_mtod(ut_params->obuf, uint8_t *) +
+			sizeof(aes_ctr_iv), output,
+			sizeof(aes_ctr_plaintext),
+			"Output data not as expected");
+
+	return TEST_SUCCESS;
+}
+
+static int
+test_AES_CTR_encrypt(void)
+{
+	return test_AES_CTR_cipher(RTE_CRYPTO_CIPHER_OP_ENCRYPT,
+			aes_ctr_plaintext, aes_ctr_ciphertext);
+}
+
+static int
+test_AES_CTR_decrypt(void)
+{
+	return test_AES_CTR_cipher(RTE_CRYPTO_CIPHER_OP_DECRYPT,
+			aes_ctr_ciphertext, aes_ctr_plaintext);
+}
+
 /* ***** Snow3G Tests ***** */
 static int
 create_snow3g_hash_session(uint8_t dev_id,
@@ -3804,6 +3938,82 @@ test_multi_session(void)
 	return TEST_SUCCESS;
 }
 
+static int
+test_multi_session_bulk(void)
+{
+	struct crypto_testsuite_params *ts_params = &testsuite_params;
+	struct crypto_unittest_params *ut_params = &unittest_params;
+
+	struct rte_cryptodev_info dev_info;
+	struct rte_cryptodev_sym_session **sessions;
+	struct rte_crypto_sym_xform **xforms;
+	unsigned nb_sessions;
+	unsigned i;
+
+	test_AES_CBC_HMAC_SHA512_decrypt_create_session_params(ut_params);
+
+	rte_cryptodev_info_get(ts_params->valid_devs[0], &dev_info);
+	nb_sessions = dev_info.sym.max_nb_sessions;
+
+	sessions = rte_malloc(NULL,
+			sizeof(struct rte_cryptodev_sym_session *) *
+			(nb_sessions + 1), 0);
+	xforms = rte_malloc(NULL,
+			sizeof(struct rte_crypto_sym_xform *) *
+			(nb_sessions + 1), 0);
+	TEST_ASSERT(sessions != NULL && xforms != NULL,
+			"Failed to allocate session arrays");
+
+	for (i = 0; i < nb_sessions + 1; i++)
+		xforms[i] = &ut_params->auth_xform;
+
+	/* Create all the sessions of the device at once */
+	TEST_ASSERT_SUCCESS(rte_cryptodev_sym_session_create_bulk(
+			ts_params->valid_devs[0], xforms, sessions,
+			nb_sessions), "Bulk session creation failed");
+
+	/* Attempt to send a request on each session */
+	for (i = 0; i < nb_sessions; i++) {
+		TEST_ASSERT_SUCCESS(test_AES_CBC_HMAC_SHA512_decrypt_perform(
+				sessions[i], ut_params, ts_params),
+				"Failed to perform decrypt on request "
+				"number %u.", i);
+		if (ut_params->op)
+			rte_crypto_op_free(ut_params->op);
+		if (ut_params->obuf) {
+			rte_pktmbuf_free(ut_params->obuf);
+			ut_params->obuf = 0;
+		}
+	}
+
+	/* No session left, no session is created by the next bulk */
+	TEST_ASSERT_FAIL(rte_cryptodev_sym_session_create_bulk(
+			ts_params->valid_devs[0], xforms, &sessions[nb_sessions],
+			1), "Bulk session creation succeeded unexpectedly!");
+
+	rte_cryptodev_sym_session_cache_flush(ts_params->valid_devs[0]);
+
+	TEST_ASSERT_SUCCESS(rte_cryptodev_sym_session_free_bulk(
+			ts_params->valid_devs[0], sessions, nb_sessions),
+			"Bulk session free failed");
+
+	/* All the sessions are back, with the cache flushed */
+	TEST_ASSERT_SUCCESS(rte_cryptodev_sym_session_create_bulk(
+			ts_params->valid_devs[0], xforms, sessions,
+			nb_sessions), "Bulk session creation failed");
+	TEST_ASSERT_SUCCESS(test_AES_CBC_HMAC_SHA512_decrypt_perform(
+			sessions[nb_sessions - 1], ut_params, ts_params),
+			"Failed to perform decrypt after cache flush");
+	TEST_ASSERT_SUCCESS(rte_cryptodev_sym_session_free_bulk(
+			ts_params->valid_devs[0], sessions, nb_sessions),
+			"Bulk session free failed");
+
+	rte_free(xforms);
+	rte_free(sessions);
+
+	return TEST_SUCCESS;
+}
+
 static int
 test_not_in_place_crypto(void)
 {
@@ -4259,6 +4469,8 @@ static struct unit_test_suite cryptodev_qat_testsuite  = {
 				test_queue_pair_descriptor_setup),
 		TEST_CASE_ST(ut_setup, ut_teardown,
 				test_multi_session),
+		TEST_CASE_ST(ut_setup, ut_teardown,
+				test_multi_session_bulk),
 
 		TEST_CASE_ST(ut_setup, ut_teardown,
 				test_AES_CBC_HMAC_SHA1_encrypt_digest_oop),
@@ -4442,6 +4654,81 @@ static struct unit_test_suite cryptodev_aesni_gcm_testsuite  = {
 	}
 };
 
+static struct unit_test_suite cryptodev_openssl_testsuite  = {
+	.suite_name = "Crypto Device OpenSSL Unit Test Suite",
+	.setup = testsuite_setup,
+	.teardown = testsuite_teardown,
+	.unit_test_cases = {
+		TEST_CASE_ST(ut_setup, ut_teardown,
+			test_multi_session),
+		TEST_CASE_ST(ut_setup, ut_teardown,
+			test_multi_session_bulk),
+
+		TEST_CASE_ST(ut_setup, ut_teardown,
+			test_AES_CBC_HMAC_SHA1_encrypt_digest_oop),
+		TEST_CASE_ST(ut_setup, ut_teardown,
+			test_AES_CBC_HMAC_SHA1_decrypt_digest_oop_ver),
+
+		TEST_CASE_ST(ut_setup, ut_teardown,
+			test_AES_CBC_HMAC_SHA1_encrypt_digest),
+		TEST_CASE_ST(ut_setup, ut_teardown,
+			test_AES_CBC_HMAC_SHA1_decrypt_digest_verify),
+
+		TEST_CASE_ST(ut_setup, ut_teardown,
+			test_AES_CBC_HMAC_SHA256_encrypt_digest),
+		TEST_CASE_ST(ut_setup, ut_teardown,
+			test_AES_CBC_HMAC_SHA256_decrypt_digest_verify),
+
+		TEST_CASE_ST(ut_setup, ut_teardown,
+			test_AES_CBC_HMAC_SHA512_encrypt_digest),
+		TEST_CASE_ST(ut_setup, ut_teardown,
+			test_AES_CBC_HMAC_SHA512_decrypt_digest_verify),
+
+		TEST_CASE_ST(ut_setup, ut_teardown,
+			test_AES_CBC_HMAC_SHA1_encrypt_digest_sessionless),
+
+		TEST_CASE_ST(ut_setup, ut_teardown,
+			test_AES_CTR_encrypt),
+		TEST_CASE_ST(ut_setup, ut_teardown,
+			test_AES_CTR_decrypt),
+		TEST_CASE_ST(ut_setup, ut_teardown, test_stats),
+
+		/** AES GCM Authenticated Encryption */
+		TEST_CASE_ST(ut_setup, ut_teardown,
+			test_mb_AES_GCM_authenticated_encryption_test_case_1),
+		TEST_CASE_ST(ut_setup, ut_teardown,
+			test_mb_AES_GCM_authenticated_encryption_test_case_2),
+		TEST_CASE_ST(ut_setup, ut_teardown,
+			test_mb_AES_GCM_authenticated_encryption_test_case_3),
+		TEST_CASE_ST(ut_setup, ut_teardown,
+			test_mb_AES_GCM_authenticated_encryption_test_case_4),
+		TEST_CASE_ST(ut_setup, ut_teardown,
+			test_mb_AES_GCM_authenticated_encryption_test_case_5),
+		TEST_CASE_ST(ut_setup, ut_teardown,
+			test_mb_AES_GCM_authenticated_encryption_test_case_6),
+		TEST_CASE_ST(ut_setup, ut_teardown,
+			test_mb_AES_GCM_authenticated_encryption_test_case_7),
+
+		/** AES GCM Authenticated Decryption */
+		TEST_CASE_ST(ut_setup, ut_teardown,
+			test_mb_AES_GCM_authenticated_decryption_test_case_1),
+		TEST_CASE_ST(ut_setup, ut_teardown,
+			test_mb_AES_GCM_authenticated_decryption_test_case_2),
+		TEST_CASE_ST(ut_setup, ut_teardown,
+			test_mb_AES_GCM_authenticated_decryption_test_case_3),
+		TEST_CASE_ST(ut_setup, ut_teardown,
+			test_mb_AES_GCM_authenticated_decryption_test_case_4),
+		TEST_CASE_ST(ut_setup, ut_teardown,
+			test_mb_AES_GCM_authenticated_decryption_test_case_5),
+		TEST_CASE_ST(ut_setup, ut_teardown,
+			test_mb_AES_GCM_authenticated_decryption_test_case_6),
+		TEST_CASE_ST(ut_setup, ut_teardown,
+			test_mb_AES_GCM_authenticated_decryption_test_case_7),
+
+		TEST_CASES_END() /**< NULL terminate unit test array */
+	}
+};
+
 static struct unit_test_suite cryptodev_sw_snow3g_testsuite  = {
 	.suite_name = "Crypto Device SW Snow3G Unit Test Suite",
 	.setup = testsuite_setup,
@@ -4551,6 +4838,19 @@ static struct test_command cryptodev_aesni_gcm_cmd = {
 	.callback = test_cryptodev_aesni_gcm,
 };
 
+static int
+test_cryptodev_openssl(void)
+{
+	gbl_cryptodev_type = RTE_CRYPTODEV_OPENSSL_PMD;
+
+	return unit_test_suite_runner(&cryptodev_openssl_testsuite);
+}
+
+static struct test_command cryptodev_openssl_cmd = {
+	.command = "cryptodev_openssl_autotest",
+	.callback = test_cryptodev_openssl,
+};
+
 static int
 test_cryptodev_null(void)
 {
@@ -4580,5 +4880,6 @@ static struct test_command cryptodev_sw_snow3g_cmd = {
 REGISTER_TEST_COMMAND(cryptodev_qat_cmd);
 REGISTER_TEST_COMMAND(cryptodev_aesni_mb_cmd);
 REGISTER_TEST_COMMAND(cryptodev_aesni_gcm_cmd);
+REGISTER_TEST_COMMAND(cryptodev_openssl_cmd);
 REGISTER_TEST_COMMAND(cryptodev_null_cmd);
 REGISTER_TEST_COMMAND(cryptodev_sw_snow3g_cmd);
@@ -39,6 +39,9 @@
 #include <rte_cryptodev.h>
 #include <rte_cycles.h>
 #include <rte_hexdump.h>
+#ifdef RTE_LIBRTE_PMD_CRYPTO_SCHEDULER
+#include <rte_cryptodev_scheduler.h>
+#endif
 
 #include "test.h"
 #include "test_cryptodev.h"
@@ -148,6 +151,21 @@ testsuite_setup(void)
 		}
 	}
 
+	/* Create 2 OpenSSL devices if required */
+	if (gbl_cryptodev_preftest_devtype == RTE_CRYPTODEV_OPENSSL_PMD) {
+		nb_devs = rte_cryptodev_count_devtype(RTE_CRYPTODEV_OPENSSL_PMD);
+		if (nb_devs < 2) {
+			for (i = nb_devs; i < 2; i++) {
+				ret = rte_eal_vdev_init(
+					CRYPTODEV_NAME_OPENSSL_PMD, NULL);
+
+				TEST_ASSERT(ret == 0,
+					"Failed to create instance %u of pmd : %s",
+					i, CRYPTODEV_NAME_OPENSSL_PMD);
+			}
+		}
+	}
+
 	nb_devs = rte_cryptodev_count();
 	if (nb_devs < 1) {
 		RTE_LOG(ERR, USER1, "No crypto devices found?");
@@ -1864,7 +1882,7 @@ test_perf_AES_CBC_HMAC_SHA256_encrypt_digest_vary_req_size(uint16_t dev_num)
 	uint32_t b, num_sent, num_received;
 	uint64_t failed_polls, retries, start_cycles, end_cycles;
 	const uint64_t mhz = rte_get_tsc_hz()/1000000;
-	double throughput, mmps;
+	double throughput, mmps, cycles_per_byte;
 
 	struct rte_crypto_op *c_ops[DEFAULT_BURST_SIZE];
 	struct rte_crypto_op *proc_ops[DEFAULT_BURST_SIZE];
@@ -1907,7 +1925,7 @@ test_perf_AES_CBC_HMAC_SHA256_encrypt_digest_vary_req_size(uint16_t dev_num)
 			"AES128_CBC_SHA256_HMAC requests with a constant burst "
 			"size of %u while varying payload sizes", DEFAULT_BURST_SIZE);
 	printf("\nDev No\tQP No\tReq Size(B)\tNum Sent\tNum Received\t"
-			"Mrps\tThoughput(Gbps)");
+			"Mrps\tThoughput(Gbps)\tCycles/Byte");
 	printf("\tRetries (Attempted a burst, but the device was busy)");
 	for (index = 0; index < MAX_PACKET_SIZE_INDEX; index++) {
 		num_sent = 0;
@@ -2004,11 +2022,15 @@ test_perf_AES_CBC_HMAC_SHA256_encrypt_digest_vary_req_size(uint16_t dev_num)
 		mmps = ((double)num_received * mhz) /
 				(end_cycles - start_cycles);
 		throughput = (mmps * data_params[index].length * 8) / 1000;
+		cycles_per_byte = (double)(end_cycles - start_cycles) /
+				((double)num_received *
+				data_params[index].length);
 
 		printf("\n%u\t%u\t%u\t\t%u\t%u", dev_num, 0,
 				data_params[index].length,
 				num_sent, num_received);
-		printf("\t%.2f\t%.2f", mmps, throughput);
+		printf("\t%.2f\t%.2f\t\t%.2f", mmps, throughput,
+				cycles_per_byte);
 		printf("\t\t%"PRIu64, retries);
 		for (b = 0; b < DEFAULT_BURST_SIZE ; b++) {
 			rte_pktmbuf_free(c_ops[b]->sym->m_src);
@@ -2063,6 +2085,14 @@ perftest_qat_cryptodev(void /*argv __rte_unused, int argc __rte_unused*/)
 	return unit_test_suite_runner(&cryptodev_testsuite);
 }
 
+static int
+perftest_openssl_cryptodev(void)
+{
+	gbl_cryptodev_preftest_devtype = RTE_CRYPTODEV_OPENSSL_PMD;
+
+	return unit_test_suite_runner(&cryptodev_testsuite);
+}
+
 static struct test_command cryptodev_aesni_mb_perf_cmd = {
 	.command = "cryptodev_aesni_mb_perftest",
 	.callback = perftest_aesni_mb_cryptodev,
@@ -2073,5 +2103,554 @@ static struct test_command cryptodev_qat_perf_cmd = {
 	.callback = perftest_qat_cryptodev,
 };
 
+static struct test_command cryptodev_openssl_perf_cmd = {
+	.command = "cryptodev_openssl_perftest",
+	.callback = perftest_openssl_cryptodev,
+};
+
 REGISTER_TEST_COMMAND(cryptodev_aesni_mb_perf_cmd);
 REGISTER_TEST_COMMAND(cryptodev_qat_perf_cmd);
+REGISTER_TEST_COMMAND(cryptodev_openssl_perf_cmd);
+
+#ifdef RTE_LIBRTE_PMD_CRYPTO_SCHEDULER
+
+/* ***** Crypto scheduler tests ***** */
+
+#define SCHED_NB_SLAVES			(2)
+#define SCHED_NB_OPS			(256)
+#define SCHED_NB_ROUNDS			(2000)
+#define SCHED_QP_NB_DESC		(128)
+#define SCHED_BURST_SIZE		(32)
+#define SCHED_SMALL_PKT_LEN		(64)
+#define SCHED_LARGE_PKT_LEN		(1024)
+#define SCHED_GCM_KEY_LEN		(16)
+#define SCHED_GCM_IV_LEN		(16)
+#define SCHED_GCM_AAD_LEN		(12)
+#define SCHED_GCM_DIGEST_LEN		(16)
+
+struct crypto_sched_params {
+	enum rte_cryptodev_type slave_type;
+	const char *slave_name;
+	uint8_t slaves[SCHED_NB_SLAVES];
+	uint8_t scheduler_id;
+	enum rte_cryptodev_scheduler_mode mode;
+	unsigned nb_workers;
+
+	struct rte_crypto_sym_xform cipher_xform;
+	struct rte_crypto_sym_xform auth_xform;
+	struct rte_crypto_op *ops[SCHED_NB_OPS];
+};
+
+static struct crypto_sched_params sched_params;
+
+static uint8_t sched_gcm_key[SCHED_GCM_KEY_LEN];
+static uint8_t sched_gcm_aad[RTE_ALIGN_CEIL(SCHED_GCM_AAD_LEN, 16)];
+
+static int
+sched_dev_configure(uint8_t dev_id)
+{
+	struct rte_cryptodev_info info;
+	struct rte_cryptodev_config conf;
+
+	rte_cryptodev_info_get(dev_id, &info);
+
+	conf.nb_queue_pairs = 1;
+	conf.socket_id = SOCKET_ID_ANY;
+	conf.session_mp.nb_objs = info.sym.max_nb_sessions;
+	conf.session_mp.cache_size = 0;
+
+	return rte_cryptodev_configure(dev_id, &conf);
+}
+
+static int
+sched_testsuite_setup(void)
+{
+	struct crypto_testsuite_params *ts_params = &testsuite_params;
+	struct crypto_sched_params *s = &sched_params;
+	struct rte_cryptodev_qp_conf qp_conf;
+	struct rte_cryptodev_info info;
+	unsigned i, nb_devs, nb_slaves = 0;
+	int scheduler_found = 0;
+
+	ts_params->mbuf_mp = rte_mempool_lookup("CRYPTO_PERF_MBUFPOOL");
+	if (ts_params->mbuf_mp == NULL) {
+		/* Not already created so create */
+		ts_params->mbuf_mp = rte_pktmbuf_pool_create(
+				"CRYPTO_PERF_MBUFPOOL",
+				NUM_MBUFS, MBUF_CACHE_SIZE, 0, MBUF_SIZE,
+				rte_socket_id());
+		if (ts_params->mbuf_mp == NULL) {
+			RTE_LOG(ERR, USER1, "Can't create CRYPTO_PERF_MBUFPOOL\n");
+			return TEST_FAILED;
+		}
+	}
+
+	ts_params->op_mpool = rte_crypto_op_pool_create("CRYPTO_OP_POOL",
+			RTE_CRYPTO_OP_TYPE_SYMMETRIC,
+			NUM_MBUFS, MBUF_CACHE_SIZE,
+			DEFAULT_NUM_XFORMS *
+			sizeof(struct rte_crypto_sym_xform),
+			rte_socket_id());
+	if (ts_params->op_mpool == NULL) {
+		RTE_LOG(ERR, USER1, "Can't create CRYPTO_OP_POOL\n");
+		return TEST_FAILED;
+	}
+
+	/* Create the slaves and the scheduler if required */
+	nb_devs = rte_cryptodev_count_devtype(s->slave_type);
+	for (i = nb_devs; i < SCHED_NB_SLAVES; i++)
+		TEST_ASSERT_SUCCESS(rte_eal_vdev_init(s->slave_name, NULL),
+				"Failed to create instance %u of pmd : %s",
+				i, s->slave_name);
+
+	if (rte_cryptodev_count_devtype(RTE_CRYPTODEV_SCHEDULER_PMD) == 0)
+		TEST_ASSERT_SUCCESS(rte_eal_vdev_init(
+				CRYPTODEV_NAME_SCHEDULER_PMD, NULL),
+				"Failed to create pmd : %s",
+				CRYPTODEV_NAME_SCHEDULER_PMD);
+
+	nb_devs = rte_cryptodev_count();
+	for (i = 0; i < nb_devs; i++) {
+		rte_cryptodev_info_get(i, &info);
+		if (info.dev_type == s->slave_type &&
+				nb_slaves < SCHED_NB_SLAVES)
+			s->slaves[nb_slaves++] = i;
+		else if (info.dev_type == RTE_CRYPTODEV_SCHEDULER_PMD &&
+				!scheduler_found) {
+			s->scheduler_id = i;
+			scheduler_found = 1;
+		}
+	}
+	TEST_ASSERT(nb_slaves == SCHED_NB_SLAVES && scheduler_found,
+			"Crypto devices not found");
+
+	/* The slaves are configured by the application */
+	for (i = 0; i < SCHED_NB_SLAVES; i++) {
+		TEST_ASSERT_SUCCESS(sched_dev_configure(s->slaves[i]),
+				"Failed to configure slave %u", s->slaves[i]);
+		TEST_ASSERT_SUCCESS(rte_cryptodev_scheduler_slave_attach(
+				s->scheduler_id, s->slaves[i]),
+				"Failed to attach slave %u", s->slaves[i]);
+	}
+
+	TEST_ASSERT(rte_cryptodev_scheduler_slave_attach(s->scheduler_id,
+			s->slaves[0]) == -EEXIST,
+			"Slave attached twice");
+	TEST_ASSERT(rte_cryptodev_scheduler_slaves_get(s->scheduler_id,
+			NULL) == SCHED_NB_SLAVES,
+			"Wrong number of slaves");
+
+	/* The scheduler sets up the queue pairs of its slaves */
+	TEST_ASSERT_SUCCESS(sched_dev_configure(s->scheduler_id),
+			"Failed to configure scheduler %u", s->scheduler_id);
+
+	qp_conf.nb_descriptors = SCHED_QP_NB_DESC;
+	TEST_ASSERT_SUCCESS(rte_cryptodev_queue_pair_setup(s->scheduler_id,
+			0, &qp_conf, rte_cryptodev_socket_id(s->scheduler_id)),
+			"Failed to setup queue pair 0 on scheduler %u",
+			s->scheduler_id);
+
+	/* Session parameters: AES GCM, except on the null slaves */
+	if (s->slave_type != RTE_CRYPTODEV_NULL_PMD) {
+		s->cipher_xform.type = RTE_CRYPTO_SYM_XFORM_CIPHER;
+		s->cipher_xform.next = &s->auth_xform;
+		s->cipher_xform.cipher.algo = RTE_CRYPTO_CIPHER_AES_GCM;
+		s->cipher_xform.cipher.op = RTE_CRYPTO_CIPHER_OP_ENCRYPT;
+		s->cipher_xform.cipher.key.data = sched_gcm_key;
+		s->cipher_xform.cipher.key.length = SCHED_GCM_KEY_LEN;
+
+		s->auth_xform.type = RTE_CRYPTO_SYM_XFORM_AUTH;
+		s->auth_xform.next = NULL;
+		s->auth_xform.auth.algo = RTE_CRYPTO_AUTH_AES_GCM;
+		s->auth_xform.auth.op = RTE_CRYPTO_AUTH_OP_GENERATE;
+		s->auth_xform.auth.digest_length = SCHED_GCM_DIGEST_LEN;
+		s->auth_xform.auth.add_auth_data_length = SCHED_GCM_AAD_LEN;
+	} else {
+		s->cipher_xform.type = RTE_CRYPTO_SYM_XFORM_CIPHER;
+		s->cipher_xform.next = &s->auth_xform;
+		s->cipher_xform.cipher.algo = RTE_CRYPTO_CIPHER_NULL;
+		s->cipher_xform.cipher.op = RTE_CRYPTO_CIPHER_OP_ENCRYPT;
+
+		s->auth_xform.type = RTE_CRYPTO_SYM_XFORM_AUTH;
+		s->auth_xform.next = NULL;
+		s->auth_xform.auth.algo = RTE_CRYPTO_AUTH_NULL;
+		s->auth_xform.auth.op = RTE_CRYPTO_AUTH_OP_GENERATE;
+	}
+
+	return TEST_SUCCESS;
+}
+
+static void
+sched_testsuite_teardown(void)
+{
+	struct crypto_sched_params *s = &sched_params;
+	unsigned i;
+
+	for (i = 0; i < SCHED_NB_SLAVES; i++)
+		rte_cryptodev_scheduler_slave_detach(s->scheduler_id,
+				s->slaves[i]);
+}
+
+static int
+sched_ut_setup(void)
+{
+	struct crypto_sched_params *s = &sched_params;
+	unsigned i;
+
+	TEST_ASSERT_SUCCESS(rte_cryptodev_scheduler_mode_set(s->scheduler_id,
+			s->mode), "Failed to set scheduling mode %u", s->mode);
+	TEST_ASSERT_SUCCESS(rte_cryptodev_scheduler_pkt_size_threshold_set(
+			s->scheduler_id, SCHED_LARGE_PKT_LEN),
+			"Failed to set packet size threshold");
+
+	TEST_ASSERT_SUCCESS(rte_cryptodev_start(s->scheduler_id),
+			"Failed to start scheduler %u", s->scheduler_id);
+
+	/* The slave queue pairs exist once the scheduler is started */
+	rte_cryptodev_stats_reset(s->scheduler_id);
+	for (i = 0; i < SCHED_NB_SLAVES; i++)
+		rte_cryptodev_stats_reset(s->slaves[i]);
+
+	return TEST_SUCCESS;
+}
+
+static void
+sched_ut_teardown(void)
+{
+	struct crypto_sched_params *s = &sched_params;
+	unsigned i;
+
+	for (i = 0; i < SCHED_NB_OPS; i++) {
+		if (s->ops[i] == NULL)
+			continue;
+		rte_pktmbuf_free(s->ops[i]->sym->m_src);
+		rte_crypto_op_free(s->ops[i]);
+		s->ops[i] = NULL;
+	}
+
+	rte_cryptodev_stop(s->scheduler_id);
+}
+
+/** Create an operation on a packet of len bytes */
+static struct rte_crypto_op *
+sched_op_create(struct rte_cryptodev_sym_session *sess, uint32_t len)
+{
+	struct crypto_testsuite_params *ts_params = &testsuite_params;
+	struct rte_crypto_op *op;
+	struct rte_mbuf *m;
+
+	m = setup_test_string(ts_params->mbuf_mp,
+			(const uint8_t *)plaintext_quote, len, 0);
+	if (m == NULL)
+		return NULL;
+
+	op = rte_crypto_op_alloc(ts_params->op_mpool,
+			RTE_CRYPTO_OP_TYPE_SYMMETRIC);
+	if (op == NULL) {
+		rte_pktmbuf_free(m);
+		return NULL;
+	}
+	rte_crypto_op_attach_sym_session(op, sess);
+
+	op->sym->m_src = m;
+	op->sym->cipher.data.offset = 0;
+	op->sym->cipher.data.length = len;
+	op->sym->auth.data.offset = 0;
+	op->sym->auth.data.length = len;
+
+	if (sched_params.slave_type != RTE_CRYPTODEV_NULL_PMD) {
+		op->sym->auth.digest.data = (uint8_t *)rte_pktmbuf_append(m,
+				SCHED_GCM_DIGEST_LEN);
+		op->sym->auth.digest.phys_addr =
+				rte_pktmbuf_mtophys_offset(m, len);
+		op->sym->auth.digest.length = SCHED_GCM_DIGEST_LEN;
+
+		op->sym->cipher.iv.data = (uint8_t *)rte_pktmbuf_prepend(m,
+				SCHED_GCM_IV_LEN);
+		memset(op->sym->cipher.iv.data, 0, SCHED_GCM_IV_LEN);
+		op->sym->cipher.iv.data[15] = 1;
+		op->sym->cipher.iv.phys_addr = rte_pktmbuf_mtophys(m);
+		op->sym->cipher.iv.length = SCHED_GCM_IV_LEN;
+
+		op->sym->auth.aad.data = sched_gcm_aad;
+		op->sym->auth.aad.phys_addr = rte_mem_virt2phy(sched_gcm_aad);
+		op->sym->auth.aad.length = SCHED_GCM_AAD_LEN;
+
+		op->sym->cipher.data.offset = SCHED_GCM_IV_LEN;
+		op->sym->auth.data.offset = SCHED_GCM_IV_LEN;
+	}
+
+	return op;
+}
+
+/**
+ * Process SCHED_NB_ROUNDS times SCHED_NB_OPS operations on a device,
+ * checking they are all processed and returned in order.
+ */
+static int
+test_perf_scheduler_run(uint8_t dev_id, const char *label)
+{
+	struct crypto_sched_params *s = &sched_params;
+	struct rte_crypto_op *proc_ops[SCHED_BURST_SIZE];
+	struct rte_cryptodev_sym_session *sess;
+	uint64_t total = (uint64_t)SCHED_NB_OPS * SCHED_NB_ROUNDS;
+	uint64_t num_sent = 0, num_received = 0;
+	uint64_t start_cycles, end_cycles;
+	uint32_t i, n;
+	int ret = TEST_SUCCESS;
+
+	sess = rte_cryptodev_sym_session_create(dev_id, &s->cipher_xform);
+	TEST_ASSERT_NOT_NULL(sess, "Session creation failed");
+
+	for (i = 0; i < SCHED_NB_OPS; i++) {
+		s->ops[i] = sched_op_create(sess, (i & 1) ?
+				SCHED_LARGE_PKT_LEN : SCHED_SMALL_PKT_LEN);
+		if (s->ops[i] == NULL) {
+			printf("Failed to create crypto op %u\n", i);
+			ret = TEST_FAILED;
+			goto exit;
+		}
+	}
+
+	start_cycles = rte_rdtsc_precise();
+	while (num_received < total) {
+		/* Only the operations already dequeued are sent again */
+		n = RTE_MIN((uint64_t)SCHED_BURST_SIZE, total - num_sent);
+		n = RTE_MIN(n, SCHED_NB_OPS - (num_sent % SCHED_NB_OPS));
+		n = RTE_MIN(n, SCHED_NB_OPS - (num_sent - num_received));
+		if (n)
+			num_sent += rte_cryptodev_enqueue_burst(dev_id, 0,
+					&s->ops[num_sent % SCHED_NB_OPS], n);
+
+		n = rte_cryptodev_dequeue_burst(dev_id, 0, proc_ops,
+				SCHED_BURST_SIZE);
+		for (i = 0; i < n; i++, num_received++) {
+			struct rte_crypto_op *op = proc_ops[i];
+
+			if (op != s->ops[num_received % SCHED_NB_OPS] ||
+					op->status !=
+					RTE_CRYPTO_OP_STATUS_SUCCESS ||
+					op->sym->session != sess) {
+				printf("Crypto op %"PRIu64" returned out of "
+						"order or failed\n",
+						num_received);
+				ret = TEST_FAILED;
+				goto exit;
+			}
+		}
+	}
+	end_cycles = rte_rdtsc_precise();
+
+	printf("%-28s %"PRIu64" ops, %.1f cycles/op\n", label, num_received,
+			(double)(end_cycles - start_cycles) / num_received);
+
+exit:
+	for (i = 0; i < SCHED_NB_OPS; i++) {
+		if (s->ops[i] == NULL)
+			continue;
+		rte_pktmbuf_free(s->ops[i]->sym->m_src);
+		rte_crypto_op_free(s->ops[i]);
+		s->ops[i] = NULL;
+	}
+	rte_cryptodev_sym_session_free(dev_id, sess);
+
+	return ret;
+}
+
+static int
+test_perf_scheduler_single_slave(void)
+{
+	struct crypto_sched_params *s = &sched_params;
+
+	/* The scheduler started the slave and set up its queue pair */
+	return test_perf_scheduler_run(s->slaves[0], "single slave");
+}
+
+static int
+test_perf_scheduler_mode(const char *label)
+{
+	struct crypto_sched_params *s = &sched_params;
+	struct rte_cryptodev_stats stats[SCHED_NB_SLAVES];
+	uint64_t total = (uint64_t)SCHED_NB_OPS * SCHED_NB_ROUNDS;
+	unsigned i;
+
+	TEST_ASSERT_SUCCESS(test_perf_scheduler_run(s->scheduler_id, label),
+			"Scheduler run failed");
+
+	for (i = 0; i < SCHED_NB_SLAVES; i++) {
+		memset(&stats[i], 0, sizeof(stats[i]));
+		rte_cryptodev_stats_get(s->slaves[i], &stats[i]);
+		printf("  slave %u: %"PRIu64" ops\n", s->slaves[i],
+				stats[i].enqueued_count);
+	}
+
+	TEST_ASSERT(stats[0].enqueued_count + stats[1].enqueued_count ==
+			total, "Operations lost by the slaves");
+
+	switch (s->mode) {
+	case RTE_CRYPTODEV_SCHEDULER_MODE_ROUND_ROBIN:
+	case RTE_CRYPTODEV_SCHEDULER_MODE_MULTICORE:
+		TEST_ASSERT(stats[0].enqueued_count &&
+				stats[1].enqueued_count,
+				"Operations not distributed to all the slaves");
+		break;
+	case RTE_CRYPTODEV_SCHEDULER_MODE_PKT_SIZE:
+		/* Half of the packets are large */
+		TEST_ASSERT(stats[0].enqueued_count == total / 2,
+				"Large packets not sent to the first slave");
+		break;
+	case RTE_CRYPTODEV_SCHEDULER_MODE_FAILOVER:
+		TEST_ASSERT(stats[0].enqueued_count >= stats[1].enqueued_count,
+				"Operations not sent to the primary slave");
+		break;
+	}
+
+	return TEST_SUCCESS;
+}
+
+static int
+test_perf_scheduler_round_robin(void)
+{
+	sched_params.mode = RTE_CRYPTODEV_SCHEDULER_MODE_ROUND_ROBIN;
+	return test_perf_scheduler_mode("scheduler, round robin");
+}
+
+static int
+test_perf_scheduler_pkt_size(void)
+{
+	sched_params.mode = RTE_CRYPTODEV_SCHEDULER_MODE_PKT_SIZE;
+	return test_perf_scheduler_mode("scheduler, packet size");
+}
+
+static int
+test_perf_scheduler_failover(void)
+{
+	sched_params.mode = RTE_CRYPTODEV_SCHEDULER_MODE_FAILOVER;
+	return test_perf_scheduler_mode("scheduler, failover");
+}
+
+static int
+test_perf_scheduler_multicore(void)
+{
+	if (sched_params.nb_workers < SCHED_NB_SLAVES) {
+		printf("Not enough lcores for the multi-core mode, "
+				"skipping\n");
+		return TEST_SUCCESS;
+	}
+
+	return test_perf_scheduler_mode("scheduler, multi-core");
+}
+
+static int
+sched_ut_setup_round_robin(void)
+{
+	sched_params.mode = RTE_CRYPTODEV_SCHEDULER_MODE_ROUND_ROBIN;
+	return sched_ut_setup();
+}
+
+static int
+sched_ut_setup_pkt_size(void)
+{
+	sched_params.mode = RTE_CRYPTODEV_SCHEDULER_MODE_PKT_SIZE;
+	return sched_ut_setup();
+}
+
+static int
+sched_ut_setup_failover(void)
+{
+	sched_params.mode = RTE_CRYPTODEV_SCHEDULER_MODE_FAILOVER;
+	return sched_ut_setup();
+}
+
+static int
+sched_ut_setup_multicore(void)
+{
+	struct crypto_sched_params *s = &sched_params;
+	unsigned lcores[SCHED_NB_SLAVES];
+	unsigned lcore_id;
+
+	/* A slave lcore per slave device, round robin mode otherwise */
+	s->nb_workers = 0;
+	RTE_LCORE_FOREACH_SLAVE(lcore_id) {
+		if (s->nb_workers == SCHED_NB_SLAVES)
+			break;
+		lcores[s->nb_workers++] = lcore_id;
+	}
+
+	s->mode = RTE_CRYPTODEV_SCHEDULER_MODE_ROUND_ROBIN;
+	if (s->nb_workers == SCHED_NB_SLAVES) {
+		TEST_ASSERT_SUCCESS(rte_cryptodev_scheduler_worker_lcores_set(
+				s->scheduler_id, lcores, s->nb_workers),
+				"Failed to set the worker lcores");
+		s->mode = RTE_CRYPTODEV_SCHEDULER_MODE_MULTICORE;
+	}
+
+	return sched_ut_setup();
+}
+
+static struct unit_test_suite cryptodev_scheduler_testsuite  = {
+	.suite_name = "Crypto Scheduler Performance Test Suite",
+	.setup = sched_testsuite_setup,
+	.teardown = sched_testsuite_teardown,
+	.unit_test_cases = {
+		TEST_CASE_ST(sched_ut_setup_round_robin, sched_ut_teardown,
+				test_perf_scheduler_single_slave),
+		TEST_CASE_ST(sched_ut_setup_round_robin, sched_ut_teardown,
+				test_perf_scheduler_round_robin),
+		TEST_CASE_ST(sched_ut_setup_pkt_size, sched_ut_teardown,
+				test_perf_scheduler_pkt_size),
+		TEST_CASE_ST(sched_ut_setup_failover, sched_ut_teardown,
+				test_perf_scheduler_failover),
+		TEST_CASE_ST(sched_ut_setup_multicore, sched_ut_teardown,
+				test_perf_scheduler_multicore),
+		TEST_CASES_END() /**< NULL terminate unit test array */
+	}
+};
+
+static int
+perftest_scheduler_null_cryptodev(void)
+{
+	sched_params.slave_type = RTE_CRYPTODEV_NULL_PMD;
+	sched_params.slave_name = CRYPTODEV_NAME_NULL_PMD;
+
+	return unit_test_suite_runner(&cryptodev_scheduler_testsuite);
+}
+
+static int
+perftest_scheduler_aesni_gcm_cryptodev(void)
+{
+	sched_params.slave_type = RTE_CRYPTODEV_AESNI_GCM_PMD;
+	sched_params.slave_name = CRYPTODEV_NAME_AESNI_GCM_PMD;
+
+	return unit_test_suite_runner(&cryptodev_scheduler_testsuite);
+}
+
+static int
+perftest_scheduler_openssl_cryptodev(void)
+{
+	sched_params.slave_type = RTE_CRYPTODEV_OPENSSL_PMD;
+	sched_params.slave_name = CRYPTODEV_NAME_OPENSSL_PMD;
+
+	return unit_test_suite_runner(&cryptodev_scheduler_testsuite);
+}
+
+static struct test_command cryptodev_scheduler_null_perf_cmd = {
+	.command = "cryptodev_scheduler_null_perftest",
+	.callback = perftest_scheduler_null_cryptodev,
+};
+
+static struct test_command cryptodev_scheduler_aesni_gcm_perf_cmd = {
+	.command = "cryptodev_scheduler_aesni_gcm_perftest",
+	.callback = perftest_scheduler_aesni_gcm_cryptodev,
+};
+
+static struct test_command cryptodev_scheduler_openssl_perf_cmd = {
+	.command = "cryptodev_scheduler_openssl_perftest",
+	.callback = perftest_scheduler_openssl_cryptodev,
+};
+
+REGISTER_TEST_COMMAND(cryptodev_scheduler_null_perf_cmd);
+REGISTER_TEST_COMMAND(cryptodev_scheduler_aesni_gcm_perf_cmd);
+REGISTER_TEST_COMMAND(cryptodev_scheduler_openssl_perf_cmd);
+
+#endif /* RTE_LIBRTE_PMD_CRYPTO_SCHEDULER */
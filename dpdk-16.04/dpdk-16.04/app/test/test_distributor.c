@@ -447,6 +447,77 @@ test_flush_with_worker_shutdown(struct rte_distributor *d,
 	return 0;
 }
 
+/* Test an ordered distributor: send BIG_BATCH packets with different tags,
+ * possibly processed out of order across the workers, and check that they
+ * are all returned in the order in which they were passed in.
+ */
+static int
+sanity_test_ordered(struct rte_distributor *d, struct rte_mempool *p)
+{
+	struct rte_mbuf *many_bufs[BIG_BATCH], *return_bufs[BIG_BATCH];
+	unsigned num_sent = 0, num_returned = 0;
+	unsigned i;
+
+	printf("=== Sanity test of ordered distributor ===\n");
+
+	clear_packet_count();
+	if (rte_mempool_get_bulk(p, (void *)many_bufs, BIG_BATCH) != 0) {
+		printf("line %d: Error getting mbufs from pool\n", __LINE__);
+		return -1;
+	}
+	for (i = 0; i < BIG_BATCH; i++)
+		many_bufs[i]->hash.usr = i;
+
+	while (num_sent < BIG_BATCH) {
+		unsigned burst = RTE_MIN((unsigned)BURST, BIG_BATCH - num_sent);
+
+		num_sent += rte_distributor_process(d, &many_bufs[num_sent],
+				burst);
+		num_returned += rte_distributor_returned_pkts(d,
+				&return_bufs[num_returned],
+				BIG_BATCH - num_returned);
+	}
+	rte_distributor_flush(d);
+	num_returned += rte_distributor_returned_pkts(d,
+			&return_bufs[num_returned], BIG_BATCH - num_returned);
+
+	if (num_returned != BIG_BATCH) {
+		printf("line %d: Number returned (%u) is not the same as "
+				"number sent\n", __LINE__, num_returned);
+		return -1;
+	}
+	for (i = 0; i < BIG_BATCH; i++) {
+		if (return_bufs[i] != many_bufs[i]) {
+			printf("line %d: packet #%u returned out of order\n",
+					__LINE__, i);
+			return -1;
+		}
+	}
+
+	for (i = 0; i < rte_lcore_count() - 1; i++)
+		printf("Worker %u handled %u packets\n", i,
+				worker_stats[i].handled_packets);
+	printf("Sanity test of ordered returned packets done\n\n");
+
+	rte_mempool_put_bulk(p, (void *)many_bufs, BIG_BATCH);
+	return 0;
+}
+
+static
+int test_error_distributor_create_window(void)
+{
+	struct rte_distributor *d = NULL;
+
+	d = rte_distributor_create_ordered("test_window", rte_socket_id(),
+			rte_lcore_count() - 1, BURST + 1);
+	if (d != NULL || rte_errno != EINVAL) {
+		printf("ERROR: No error on create_ordered() with window size "
+				"not a power of two\n");
+		return -1;
+	}
+	return 0;
+}
+
 static
 int test_error_distributor_create_name(void)
 {
@@ -506,6 +577,7 @@ static int
 test_distributor(void)
 {
 	static struct rte_distributor *d;
+	static struct rte_distributor *d_ordered;
 	static struct rte_mempool *p;
 
 	if (rte_lcore_count() < 2) {
@@ -563,8 +635,30 @@ test_distributor(void)
 		printf("Not enough cores to run tests for worker shutdown\n");
 	}
 
+	if (d_ordered == NULL) {
+		d_ordered = rte_distributor_create_ordered(
+				"Test_dist_ordered", rte_socket_id(),
+				rte_lcore_count() - 1, BIG_BATCH / 4);
+		if (d_ordered == NULL) {
+			printf("Error creating ordered distributor\n");
+			return -1;
+		}
+	} else {
+		rte_distributor_flush(d_ordered);
+		rte_distributor_clear_returns(d_ordered);
+	}
+
+	rte_eal_mp_remote_launch(handle_work, d_ordered, SKIP_MASTER);
+	if (sanity_test_ordered(d_ordered, p) < 0) {
+		rte_distributor_clear_returns(d_ordered);
+		quit_workers(d_ordered, p);
+		return -1;
+	}
+	quit_workers(d_ordered, p);
+
 	if (test_error_distributor_create_numworkers() == -1 ||
-			test_error_distributor_create_name() == -1) {
+			test_error_distributor_create_name() == -1 ||
+			test_error_distributor_create_window() == -1) {
 		printf("rte_distributor_create parameter check tests failed");
 		return -1;
 	}
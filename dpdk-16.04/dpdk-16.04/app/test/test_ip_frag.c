@@ -0,0 +1,863 @@
+/*-
+ *   BSD LICENSE
+ *
+ *   Copyright(c) 2016 Intel Corporation. All rights reserved.
+ *   All rights reserved.
+ *
+ *   Redistribution and use in source and binary forms, with or without
+ *   modification, are permitted provided that the following conditions
+ *   are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ *     * Neither the name of Intel Corporation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *   OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include <rte_atomic.h>
+#include <rte_common.h>
+#include <rte_cycles.h>
+#include <rte_ether.h>
+#include <rte_ip.h>
+#include <rte_ip_frag.h>
+#include <rte_launch.h>
+#include <rte_lcore.h>
+#include <rte_mbuf.h>
+#include <rte_random.h>
+#include <rte_ring.h>
+
+#include "test.h"
+
+/*
+ * Large datagram test
+ * ===================
+ *
+ * Datagrams with more fragments than a table entry can hold are received
+ * in random order and must be reassembled in offset order, the extra
+ * fragments going to overflow blocks, without leaking any mbuf. A datagram
+ * with more fragments than RTE_LIBRTE_IP_FRAG_MAX_FRAG is dropped, and so
+ * are the datagrams that cannot get an overflow block.
+ *
+ * Bulk reassembly test
+ * ====================
+ *
+ * Fragments mixed with packets that are not fragmented go through the table
+ * a burst at a time. The packets must come out as they are, and the
+ * datagrams reassembled, whatever burst their fragments are in.
+ *
+ * Fragmentation test
+ * ==================
+ *
+ * A JUMBO_LEN bytes IPv4 and IPv6 packet, in a chain of small mbufs, is
+ * fragmented for a JUMBO_MTU MTU with the bulk functions. The fragment
+ * headers and the software or offloaded checksums are checked, then the
+ * fragments are reassembled and the payload compared to the original one.
+ *
+ * Shared reassembly table test
+ * ============================
+ *
+ * The fragments of NB_DGRAMS IPv4 datagrams are shuffled and sprayed
+ * randomly over the rings of up to MAX_WORKERS lcores, like RSS would do
+ * for fragments that have no L4 header. Each lcore reassembles the
+ * fragments of its ring into one shared table. Every datagram must be
+ * reassembled, whatever lcores its fragments went to, and all the mbufs
+ * must be back in the pool at the end. The completion rate and the
+ * throughput are reported for one lcore and for all the worker lcores.
+ */
+
+#define MAX_WORKERS		8
+#define NB_DGRAMS		8192
+#define FRAGS_PER_DGRAM		4
+#define FRAG_PAYLOAD		64
+#define NB_FRAGS		(NB_DGRAMS * FRAGS_PER_DGRAM)
+#define NB_MBUFS		(NB_FRAGS + 1024)
+#define RING_SIZE		(2 * NB_FRAGS)
+#define BURST_SIZE		32
+
+#define TBL_BUCKET_ENTRIES	8
+#define TBL_BUCKETS		(NB_DGRAMS / 4)
+#define TBL_TTL_SEC		10
+
+#define JUMBO_LEN		9000
+#define JUMBO_MTU		1500
+#define JUMBO_FRAGS		8
+
+#define DGRAM_LEN		(sizeof(struct ether_hdr) + \
+	sizeof(struct ipv4_hdr) + FRAGS_PER_DGRAM * FRAG_PAYLOAD)
+
+static struct rte_mempool *frag_pool;
+static struct rte_mbuf *frags[NB_FRAGS];
+
+static struct {
+	struct rte_ip_frag_tbl *tbl;
+	struct rte_ring *ring[MAX_WORKERS];
+	unsigned lcore[MAX_WORKERS];
+	volatile int start;
+	rte_atomic32_t completed;
+	rte_atomic32_t bad;
+} frag_test;
+
+static struct rte_ip_frag_death_row death_row[MAX_WORKERS];
+
+/* build fragment frag of datagram id, made of nb_frags fragments */
+static struct rte_mbuf *
+ip_frag_build(uint16_t id, uint16_t frag, uint16_t nb_frags)
+{
+	struct rte_mbuf *m;
+	struct ether_hdr *eth;
+	struct ipv4_hdr *ip;
+	uint16_t ofs;
+	char *p;
+
+	m = rte_pktmbuf_alloc(frag_pool);
+	if (m == NULL)
+		return NULL;
+
+	p = rte_pktmbuf_append(m, sizeof(*eth) + sizeof(*ip) + FRAG_PAYLOAD);
+	if (p == NULL) {
+		rte_pktmbuf_free(m);
+		return NULL;
+	}
+
+	eth = (struct ether_hdr *)p;
+	memset(eth, 0, sizeof(*eth));
+	eth->ether_type = rte_cpu_to_be_16(ETHER_TYPE_IPv4);
+
+	ofs = frag * FRAG_PAYLOAD / IPV4_HDR_OFFSET_UNITS;
+	if (frag != nb_frags - 1)
+		ofs |= IPV4_HDR_MF_FLAG;
+
+	ip = (struct ipv4_hdr *)(eth + 1);
+	memset(ip, 0, sizeof(*ip));
+	ip->version_ihl = 0x45;
+	ip->total_length = rte_cpu_to_be_16(sizeof(*ip) + FRAG_PAYLOAD);
+	ip->packet_id = rte_cpu_to_be_16(id);
+	ip->fragment_offset = rte_cpu_to_be_16(ofs);
+	ip->time_to_live = 64;
+	ip->next_proto_id = IPPROTO_UDP;
+	ip->src_addr = rte_cpu_to_be_32(IPv4(10, 0, 0, 1));
+	ip->dst_addr = rte_cpu_to_be_32(IPv4(10, 0, 0, 2));
+
+	memset(ip + 1, (uint8_t)(id + frag), FRAG_PAYLOAD);
+
+	m->l2_len = sizeof(*eth);
+	m->l3_len = sizeof(*ip);
+
+	return m;
+}
+
+static int
+ip_frag_pool_init(void)
+{
+	if (frag_pool == NULL) {
+		frag_pool = rte_pktmbuf_pool_create("ip_frag_test_pool",
+			NB_MBUFS, 0, 0, RTE_PKTMBUF_HEADROOM + 256,
+			SOCKET_ID_ANY);
+		TEST_ASSERT_NOT_NULL(frag_pool, "cannot create mbuf pool");
+	}
+
+	return 0;
+}
+
+/* shuffle the first n fragments */
+static void
+ip_frag_shuffle(unsigned n)
+{
+	struct rte_mbuf *m;
+	unsigned i, j;
+
+	for (i = n - 1; i > 0; i--) {
+		j = rte_rand() % (i + 1);
+		m = frags[i];
+		frags[i] = frags[j];
+		frags[j] = m;
+	}
+}
+
+/*
+ * Send the fragments of nb_dgrams datagrams of nb_frags fragments each,
+ * in random order or interleaved, return the number of datagrams
+ * reassembled.
+ */
+static int
+ip_frag_large_run(struct rte_ip_frag_tbl *tbl, unsigned nb_dgrams,
+	unsigned nb_frags, int shuffle)
+{
+	struct rte_ip_frag_death_row *dr = &death_row[0];
+	struct rte_mbuf *m, *seg;
+	struct ipv4_hdr *ip;
+	unsigned i, k, n, completed;
+	uint8_t *p;
+
+	n = nb_dgrams * nb_frags;
+	for (i = 0; i != n; i++) {
+		if (shuffle)
+			frags[i] = ip_frag_build(i / nb_frags, i % nb_frags,
+				nb_frags);
+		else
+			frags[i] = ip_frag_build(i % nb_dgrams, i / nb_dgrams,
+				nb_frags);
+		TEST_ASSERT_NOT_NULL(frags[i], "cannot build fragment %u", i);
+	}
+	if (shuffle)
+		ip_frag_shuffle(n);
+
+	completed = 0;
+	for (i = 0; i != n; i++) {
+		ip = rte_pktmbuf_mtod_offset(frags[i], struct ipv4_hdr *,
+			sizeof(struct ether_hdr));
+		m = rte_ipv4_frag_reassemble_packet(tbl, dr, frags[i],
+			rte_rdtsc(), ip);
+		if (dr->cnt >= IP_FRAG_DEATH_ROW_LEN)
+			rte_ip_frag_free_death_row(dr, 0);
+		if (m == NULL)
+			continue;
+
+		TEST_ASSERT_EQUAL(m->pkt_len, sizeof(struct ether_hdr) +
+			sizeof(struct ipv4_hdr) + nb_frags * FRAG_PAYLOAD,
+			"bad reassembled length %u", m->pkt_len);
+		TEST_ASSERT_EQUAL(m->nb_segs, nb_frags,
+			"bad number of segments %u", m->nb_segs);
+		ip = rte_pktmbuf_mtod_offset(m, struct ipv4_hdr *, m->l2_len);
+		TEST_ASSERT_EQUAL(rte_be_to_cpu_16(ip->total_length),
+			sizeof(*ip) + nb_frags * FRAG_PAYLOAD,
+			"bad reassembled IP length");
+
+		/* each segment holds one fragment, in offset order */
+		p = (uint8_t *)(ip + 1);
+		for (k = 0, seg = m; seg != NULL; k++, seg = seg->next) {
+			TEST_ASSERT_EQUAL(*p, (uint8_t)(rte_be_to_cpu_16(
+				ip->packet_id) + k), "fragment %u misplaced", k);
+			if (seg->next != NULL)
+				p = rte_pktmbuf_mtod(seg->next, uint8_t *);
+		}
+
+		completed++;
+		rte_pktmbuf_free(m);
+	}
+	rte_ip_frag_free_death_row(dr, 0);
+
+	return completed;
+}
+
+/*
+ * Destroy a table, freeing the fragments of its incomplete datagrams
+ * first: fragments received after their datagram was dropped remain
+ * in a new entry.
+ */
+static void
+ip_frag_table_free(struct rte_ip_frag_tbl *tbl)
+{
+	rte_ip_frag_table_del_expired_entries(tbl, &death_row[0], UINT64_MAX);
+	rte_ip_frag_free_death_row(&death_row[0], 0);
+	rte_ip_frag_table_destroy(tbl);
+}
+
+static int
+test_ip_frag_large(void)
+{
+	struct rte_ip_frag_tbl *tbl;
+	unsigned avail;
+	int n;
+
+	if (ip_frag_pool_init() != 0)
+		return -1;
+	avail = rte_mempool_count(frag_pool);
+
+	tbl = rte_ip_frag_table_create(64, 4, 64, rte_get_tsc_hz(),
+		SOCKET_ID_ANY);
+	TEST_ASSERT_NOT_NULL(tbl, "cannot create table");
+
+	/* one overflow block each: jumbo frames over a 1500 bytes MTU */
+	n = ip_frag_large_run(tbl, 64, 7, 1);
+	TEST_ASSERT_EQUAL(n, 64, "%d/64 datagrams of 7 fragments", n);
+
+	/* several overflow blocks per datagram */
+	n = ip_frag_large_run(tbl, 8, 45, 1);
+	TEST_ASSERT_EQUAL(n, 8, "%d/8 datagrams of 45 fragments", n);
+
+	n = ip_frag_large_run(tbl, 1, IP_MAX_FRAG_NUM, 1);
+	TEST_ASSERT_EQUAL(n, 1, "datagram of max fragments not reassembled");
+
+	TEST_ASSERT_EQUAL(rte_mempool_count(frag_pool), avail, "mbufs leaked");
+
+	/* too many fragments */
+	n = ip_frag_large_run(tbl, 1, IP_MAX_FRAG_NUM + 1, 0);
+	TEST_ASSERT_EQUAL(n, 0, "datagram of too many fragments reassembled");
+	ip_frag_table_free(tbl);
+
+	/*
+	 * 8 overflow blocks for 5 interleaved datagrams needing 2 each:
+	 * all take their first block, 3 get their second one, the 4th is
+	 * dropped, freeing its block for the 5th.
+	 */
+	tbl = rte_ip_frag_table_create(8, 4, 8, rte_get_tsc_hz(),
+		SOCKET_ID_ANY);
+	TEST_ASSERT_NOT_NULL(tbl, "cannot create table");
+	n = ip_frag_large_run(tbl, 5, IP_INLINE_FRAG_NUM +
+		2 * IP_FRAG_EXT_NUM, 0);
+	TEST_ASSERT_EQUAL(n, 4, "%d/5 datagrams without enough overflow "
+		"blocks", n);
+	ip_frag_table_free(tbl);
+
+	TEST_ASSERT_EQUAL(rte_mempool_count(frag_pool), NB_MBUFS,
+		"mbufs leaked");
+
+	return 0;
+}
+
+static int
+test_ip_frag_bulk(void)
+{
+	struct rte_ip_frag_tbl *tbl;
+	struct rte_mbuf *m;
+	unsigned avail, i, j, n, nb_out, nb_whole, nb_dgram;
+
+	avail = rte_mempool_count(frag_pool);
+
+	tbl = rte_ip_frag_table_create(64, 4, 64, rte_get_tsc_hz(),
+		SOCKET_ID_ANY);
+	TEST_ASSERT_NOT_NULL(tbl, "cannot create table");
+
+	/* 64 datagrams of 7 fragments and 64 single fragment packets */
+	n = 0;
+	for (i = 0; i != 64; i++) {
+		for (j = 0; j != 7; j++)
+			frags[n++] = ip_frag_build(i, j, 7);
+		frags[n++] = ip_frag_build(64 + i, 0, 1);
+	}
+	for (i = 0; i != n; i++)
+		TEST_ASSERT_NOT_NULL(frags[i], "cannot build fragment %u", i);
+	ip_frag_shuffle(n);
+
+	nb_whole = 0;
+	nb_dgram = 0;
+	for (i = 0; i < n; i += BURST_SIZE) {
+		nb_out = rte_ipv4_frag_reassemble_bulk(tbl, &death_row[0],
+			&frags[i], RTE_MIN(n - i, (unsigned)BURST_SIZE),
+			rte_rdtsc(), &frags[i]);
+		TEST_ASSERT_EQUAL(death_row[0].cnt, 0, "death row not freed");
+
+		for (j = 0; j != nb_out; j++) {
+			m = frags[i + j];
+			if (m->nb_segs == 1) {
+				TEST_ASSERT_EQUAL(m->pkt_len,
+					sizeof(struct ether_hdr) +
+					sizeof(struct ipv4_hdr) + FRAG_PAYLOAD,
+					"bad packet length %u", m->pkt_len);
+				nb_whole++;
+			} else {
+				TEST_ASSERT_EQUAL(m->pkt_len,
+					sizeof(struct ether_hdr) +
+					sizeof(struct ipv4_hdr) +
+					7 * FRAG_PAYLOAD,
+					"bad reassembled length %u",
+					m->pkt_len);
+				nb_dgram++;
+			}
+			rte_pktmbuf_free(m);
+		}
+	}
+
+	rte_ip_frag_table_destroy(tbl);
+
+	TEST_ASSERT_EQUAL(nb_whole, 64, "%u/64 packets out", nb_whole);
+	TEST_ASSERT_EQUAL(nb_dgram, 64, "%u/64 datagrams reassembled",
+		nb_dgram);
+	TEST_ASSERT_EQUAL(rte_mempool_count(frag_pool), avail, "mbufs leaked");
+
+	return 0;
+}
+
+/* build a JUMBO_LEN bytes packet, each byte set to its offset */
+static struct rte_mbuf *
+ip_frag_build_jumbo(int ipv6)
+{
+	struct rte_mbuf *m, *seg, *prev;
+	struct ipv4_hdr *ip4;
+	struct ipv6_hdr *ip6;
+	uint8_t *p;
+	uint32_t i, len, ofs;
+
+	m = NULL;
+	prev = NULL;
+	for (ofs = 0; ofs != JUMBO_LEN; ofs += len) {
+		seg = rte_pktmbuf_alloc(frag_pool);
+		if (seg == NULL) {
+			rte_pktmbuf_free(m);
+			return NULL;
+		}
+		len = RTE_MIN(rte_pktmbuf_tailroom(seg), JUMBO_LEN - ofs);
+		p = (uint8_t *)rte_pktmbuf_append(seg, len);
+		for (i = 0; i != len; i++)
+			p[i] = (uint8_t)(ofs + i);
+
+		if (m == NULL) {
+			m = seg;
+		} else {
+			prev->next = seg;
+			m->nb_segs++;
+			m->pkt_len += len;
+		}
+		prev = seg;
+	}
+
+	if (ipv6) {
+		ip6 = rte_pktmbuf_mtod(m, struct ipv6_hdr *);
+		memset(ip6, 0, sizeof(*ip6));
+		ip6->vtc_flow = rte_cpu_to_be_32(6 << 28);
+		ip6->payload_len = rte_cpu_to_be_16(JUMBO_LEN - sizeof(*ip6));
+		ip6->proto = IPPROTO_UDP;
+		ip6->hop_limits = 64;
+		ip6->src_addr[15] = 1;
+		ip6->dst_addr[15] = 2;
+	} else {
+		ip4 = rte_pktmbuf_mtod(m, struct ipv4_hdr *);
+		memset(ip4, 0, sizeof(*ip4));
+		ip4->version_ihl = 0x45;
+		ip4->total_length = rte_cpu_to_be_16(JUMBO_LEN);
+		ip4->packet_id = rte_cpu_to_be_16(0x1234);
+		ip4->time_to_live = 64;
+		ip4->next_proto_id = IPPROTO_UDP;
+		ip4->src_addr = rte_cpu_to_be_32(IPv4(10, 0, 0, 1));
+		ip4->dst_addr = rte_cpu_to_be_32(IPv4(10, 0, 0, 2));
+		ip4->hdr_checksum = rte_ipv4_cksum(ip4);
+	}
+
+	return m;
+}
+
+/* check the payload of a reassembled jumbo packet */
+static int
+ip_frag_check_jumbo(const struct rte_mbuf *m, uint32_t hlen)
+{
+	const uint8_t *p;
+	uint32_t i, ofs, skip;
+
+	TEST_ASSERT_EQUAL(m->pkt_len, JUMBO_LEN, "bad reassembled length %u",
+		m->pkt_len);
+
+	skip = hlen;
+	ofs = hlen;
+	for (; m != NULL; m = m->next) {
+		p = rte_pktmbuf_mtod(m, const uint8_t *);
+		for (i = 0; i != m->data_len; i++) {
+			if (skip != 0) {
+				skip--;
+				continue;
+			}
+			TEST_ASSERT_EQUAL(p[i], (uint8_t)ofs,
+				"bad payload at offset %u", ofs);
+			ofs++;
+		}
+	}
+	TEST_ASSERT_EQUAL(ofs, JUMBO_LEN, "short payload");
+
+	return 0;
+}
+
+static int
+test_ip_frag_fragment_ipv4(struct rte_ip_frag_tbl *tbl, uint32_t flags)
+{
+	struct rte_mbuf *out[JUMBO_FRAGS];
+	struct rte_mbuf *in, *m;
+	struct ipv4_hdr *ip;
+	uint32_t i, len;
+	uint16_t cksum, fofs;
+	int32_t n;
+
+	in = ip_frag_build_jumbo(0);
+	TEST_ASSERT_NOT_NULL(in, "cannot build packet");
+
+	/* the same fragments as rte_ipv4_fragment_packet() */
+	n = rte_ipv4_fragment_packet(in, out, JUMBO_FRAGS, JUMBO_MTU,
+		frag_pool, frag_pool);
+	TEST_ASSERT_EQUAL(n, 7, "%d fragments instead of 7", n);
+	for (i = 0; i != (uint32_t)n; i++) {
+		TEST_ASSERT_EQUAL(out[i]->pkt_len, (i != 6 ? JUMBO_MTU :
+			JUMBO_LEN - 6 * (JUMBO_MTU - sizeof(*ip))),
+			"bad fragment %u length %u", i, out[i]->pkt_len);
+		rte_pktmbuf_free(out[i]);
+	}
+
+	n = rte_ipv4_fragment_packet_bulk(in, out, JUMBO_FRAGS - 2,
+		JUMBO_MTU, frag_pool, frag_pool, flags);
+	TEST_ASSERT_EQUAL(n, -EINVAL, "fragments do not fit, got %d", n);
+
+	n = rte_ipv4_fragment_packet_bulk(in, out, JUMBO_FRAGS, JUMBO_MTU,
+		frag_pool, frag_pool, flags);
+	rte_pktmbuf_free(in);
+	TEST_ASSERT_EQUAL(n, 7, "%d fragments instead of 7", n);
+
+	m = NULL;
+	len = 0;
+	for (i = 0; i != (uint32_t)n; i++) {
+		ip = rte_pktmbuf_mtod(out[i], struct ipv4_hdr *);
+		fofs = rte_be_to_cpu_16(ip->fragment_offset);
+
+		TEST_ASSERT_EQUAL(rte_be_to_cpu_16(ip->total_length),
+			out[i]->pkt_len, "bad total length");
+		TEST_ASSERT_EQUAL((fofs & IPV4_HDR_OFFSET_MASK) *
+			IPV4_HDR_OFFSET_UNITS, len, "bad fragment offset");
+		TEST_ASSERT_EQUAL(((fofs & IPV4_HDR_MF_FLAG) != 0), (i != 6),
+			"bad MF flag");
+		TEST_ASSERT_EQUAL(out[i]->l3_len, sizeof(*ip), "bad l3_len");
+
+		cksum = ip->hdr_checksum;
+		if (flags & RTE_IP_FRAG_TX_CKSUM_OFFLOAD) {
+			TEST_ASSERT_EQUAL(out[i]->ol_flags,
+				(PKT_TX_IPV4 | PKT_TX_IP_CKSUM),
+				"bad offload flags");
+			TEST_ASSERT_EQUAL(cksum, 0, "checksum not left to NIC");
+		} else {
+			TEST_ASSERT_EQUAL(out[i]->ol_flags, 0,
+				"bad offload flags");
+			ip->hdr_checksum = 0;
+			TEST_ASSERT_EQUAL(cksum, rte_ipv4_cksum(ip),
+				"bad checksum");
+		}
+		len += out[i]->pkt_len - sizeof(*ip);
+
+		out[i]->l2_len = 0;
+		m = rte_ipv4_frag_reassemble_packet(tbl, &death_row[0],
+			out[i], rte_rdtsc(), ip);
+		TEST_ASSERT((m == NULL) == (i != 6),
+			"bad reassembly of fragment %u", i);
+	}
+	TEST_ASSERT_EQUAL(len, JUMBO_LEN - sizeof(*ip), "bad fragments length");
+
+	if (ip_frag_check_jumbo(m, sizeof(*ip)) != 0) {
+		rte_pktmbuf_free(m);
+		return -1;
+	}
+	rte_pktmbuf_free(m);
+
+	return 0;
+}
+
+static int
+test_ip_frag_fragment_ipv6(struct rte_ip_frag_tbl *tbl, uint32_t flags)
+{
+	struct rte_mbuf *out[JUMBO_FRAGS];
+	struct rte_mbuf *in, *m;
+	struct ipv6_hdr *ip;
+	struct ipv6_extension_fragment *fh;
+	uint32_t i, len;
+	int32_t n;
+
+	in = ip_frag_build_jumbo(1);
+	TEST_ASSERT_NOT_NULL(in, "cannot build packet");
+
+	n = rte_ipv6_fragment_packet_bulk(in, out, JUMBO_FRAGS, JUMBO_MTU,
+		frag_pool, frag_pool, flags);
+	rte_pktmbuf_free(in);
+	TEST_ASSERT_EQUAL(n, 7, "%d fragments instead of 7", n);
+
+	m = NULL;
+	len = 0;
+	for (i = 0; i != (uint32_t)n; i++) {
+		ip = rte_pktmbuf_mtod(out[i], struct ipv6_hdr *);
+		fh = rte_ipv6_frag_get_ipv6_fragment_header(ip);
+		TEST_ASSERT_NOT_NULL(fh, "no fragment header");
+
+		TEST_ASSERT(out[i]->pkt_len <= JUMBO_MTU, "fragment too long");
+		TEST_ASSERT_EQUAL(rte_be_to_cpu_16(ip->payload_len),
+			out[i]->pkt_len - sizeof(*ip), "bad payload length");
+		TEST_ASSERT_EQUAL(fh->next_header, IPPROTO_UDP,
+			"bad next header");
+		TEST_ASSERT_EQUAL(RTE_IPV6_GET_FO(
+			rte_be_to_cpu_16(fh->frag_data)) << 3, len,
+			"bad fragment offset");
+		TEST_ASSERT_EQUAL(RTE_IPV6_GET_MF(
+			rte_be_to_cpu_16(fh->frag_data)), (i != 6),
+			"bad MF flag");
+		TEST_ASSERT_EQUAL(out[i]->ol_flags,
+			((flags & RTE_IP_FRAG_TX_CKSUM_OFFLOAD) ?
+			PKT_TX_IPV6 : 0), "bad offload flags");
+		len += out[i]->pkt_len - sizeof(*ip) - sizeof(*fh);
+
+		out[i]->l2_len = 0;
+		m = rte_ipv6_frag_reassemble_packet(tbl, &death_row[0],
+			out[i], rte_rdtsc(), ip, fh);
+		TEST_ASSERT((m == NULL) == (i != 6),
+			"bad reassembly of fragment %u", i);
+	}
+	TEST_ASSERT_EQUAL(len, JUMBO_LEN - sizeof(*ip), "bad fragments length");
+
+	if (ip_frag_check_jumbo(m, sizeof(*ip)) != 0) {
+		rte_pktmbuf_free(m);
+		return -1;
+	}
+	rte_pktmbuf_free(m);
+
+	return 0;
+}
+
+static int
+test_ip_frag_fragment(void)
+{
+	struct rte_ip_frag_tbl *tbl;
+	unsigned avail;
+	int ret;
+
+	avail = rte_mempool_count(frag_pool);
+
+	tbl = rte_ip_frag_table_create(16, 4, 16, rte_get_tsc_hz(),
+		SOCKET_ID_ANY);
+	TEST_ASSERT_NOT_NULL(tbl, "cannot create table");
+
+	ret = test_ip_frag_fragment_ipv4(tbl, 0);
+	if (ret == 0)
+		ret = test_ip_frag_fragment_ipv4(tbl,
+			RTE_IP_FRAG_TX_CKSUM_OFFLOAD);
+	if (ret == 0)
+		ret = test_ip_frag_fragment_ipv6(tbl, 0);
+	if (ret == 0)
+		ret = test_ip_frag_fragment_ipv6(tbl,
+			RTE_IP_FRAG_TX_CKSUM_OFFLOAD);
+
+	rte_ip_frag_table_destroy(tbl);
+	if (ret != 0)
+		return ret;
+
+	TEST_ASSERT_EQUAL(rte_mempool_count(frag_pool), avail, "mbufs leaked");
+
+	return 0;
+}
+
+static int
+test_ip_frag(void)
+{
+	if (ip_frag_pool_init() != 0)
+		return -1;
+
+	if (test_ip_frag_fragment() != 0)
+		return -1;
+
+	if (test_ip_frag_bulk() != 0)
+		return -1;
+
+	return test_ip_frag_large();
+}
+
+static int
+ip_frag_worker(void *arg)
+{
+	uintptr_t w = (uintptr_t)arg;
+	struct rte_ip_frag_death_row *dr = &death_row[w];
+	struct rte_ring *r = frag_test.ring[w];
+	struct rte_mbuf *pkts[BURST_SIZE];
+	struct rte_mbuf *m;
+	struct ipv4_hdr *ip;
+	uint64_t tms;
+	unsigned i, n;
+
+	while (frag_test.start == 0)
+		rte_pause();
+
+	for (;;) {
+		n = rte_ring_sc_dequeue_burst(r, (void **)pkts, BURST_SIZE);
+		if (n == 0)
+			break;
+
+		tms = rte_rdtsc();
+		for (i = 0; i < n; i++) {
+			ip = rte_pktmbuf_mtod_offset(pkts[i], struct ipv4_hdr *,
+				sizeof(struct ether_hdr));
+			m = rte_ipv4_frag_reassemble_packet(frag_test.tbl, dr,
+				pkts[i], tms, ip);
+			if (m == NULL)
+				continue;
+
+			if (m->pkt_len != DGRAM_LEN ||
+					m->nb_segs != FRAGS_PER_DGRAM)
+				rte_atomic32_inc(&frag_test.bad);
+			rte_atomic32_inc(&frag_test.completed);
+			rte_pktmbuf_free(m);
+		}
+
+		rte_ip_frag_free_death_row(dr, 0);
+	}
+
+	return 0;
+}
+
+/* spray all the fragments over n_workers lcores and reassemble them */
+static int
+test_ip_frag_shared_run(unsigned n_workers)
+{
+	uint64_t start, cycles;
+	uintptr_t w;
+	unsigned i, completed;
+
+	frag_test.tbl = rte_ip_frag_table_create_shared(TBL_BUCKETS,
+		TBL_BUCKET_ENTRIES, NB_DGRAMS,
+		rte_get_tsc_hz() * TBL_TTL_SEC, SOCKET_ID_ANY);
+	TEST_ASSERT_NOT_NULL(frag_test.tbl, "cannot create shared table");
+
+	for (i = 0; i < NB_FRAGS; i++) {
+		frags[i] = ip_frag_build(i / FRAGS_PER_DGRAM,
+			i % FRAGS_PER_DGRAM, FRAGS_PER_DGRAM);
+		TEST_ASSERT_NOT_NULL(frags[i], "cannot build fragment %u", i);
+	}
+
+	/* shuffle, then spray over the worker rings */
+	ip_frag_shuffle(NB_FRAGS);
+	for (i = 0; i < NB_FRAGS; i++)
+		TEST_ASSERT_SUCCESS(rte_ring_sp_enqueue(
+			frag_test.ring[rte_rand() % n_workers], frags[i]),
+			"cannot enqueue fragment");
+
+	frag_test.start = 0;
+	rte_atomic32_clear(&frag_test.completed);
+	rte_atomic32_clear(&frag_test.bad);
+
+	for (w = 1; w < n_workers; w++)
+		rte_eal_remote_launch(ip_frag_worker, (void *)w,
+			frag_test.lcore[w]);
+
+	start = rte_rdtsc();
+	frag_test.start = 1;
+	ip_frag_worker((void *)0);
+	for (w = 1; w < n_workers; w++)
+		rte_eal_wait_lcore(frag_test.lcore[w]);
+	cycles = rte_rdtsc() - start;
+
+	completed = rte_atomic32_read(&frag_test.completed);
+	printf("%u lcore(s): %u/%u datagrams reassembled (%.2f%%), "
+		"%.2f Mfrags/s, %" PRIu64 " cycles/frag\n",
+		n_workers, completed, NB_DGRAMS,
+		completed * 100.0 / NB_DGRAMS,
+		(double)NB_FRAGS * rte_get_tsc_hz() / cycles / 1e6,
+		cycles / NB_FRAGS);
+	rte_ip_frag_table_statistics_dump(stdout, frag_test.tbl);
+
+	TEST_ASSERT_EQUAL(frag_test.tbl->use_entries, 0,
+		"%u entries still in use", frag_test.tbl->use_entries);
+	rte_ip_frag_table_destroy(frag_test.tbl);
+	frag_test.tbl = NULL;
+
+	TEST_ASSERT_EQUAL(completed, NB_DGRAMS, "datagrams not reassembled");
+	TEST_ASSERT_EQUAL(rte_atomic32_read(&frag_test.bad), 0,
+		"bad reassembled datagrams");
+	TEST_ASSERT_EQUAL(rte_mempool_count(frag_pool), NB_MBUFS,
+		"mbufs leaked");
+
+	return 0;
+}
+
+/* leave incomplete datagrams in a shared table, then delete them */
+static int
+test_ip_frag_shared_expire(void)
+{
+	struct rte_ip_frag_death_row *dr = &death_row[0];
+	struct rte_ip_frag_tbl *tbl;
+	struct ipv4_hdr *ip;
+	struct rte_mbuf *m;
+	unsigned avail, i;
+
+	avail = rte_mempool_count(frag_pool);
+
+	tbl = rte_ip_frag_table_create_shared(TBL_BUCKETS, TBL_BUCKET_ENTRIES,
+		NB_DGRAMS, rte_get_tsc_hz() * TBL_TTL_SEC, SOCKET_ID_ANY);
+	TEST_ASSERT_NOT_NULL(tbl, "cannot create shared table");
+
+	for (i = 0; i < BURST_SIZE * (FRAGS_PER_DGRAM - 1); i++) {
+		m = ip_frag_build(i / (FRAGS_PER_DGRAM - 1),
+			i % (FRAGS_PER_DGRAM - 1), FRAGS_PER_DGRAM);
+		TEST_ASSERT_NOT_NULL(m, "cannot build fragment %u", i);
+		ip = rte_pktmbuf_mtod_offset(m, struct ipv4_hdr *, m->l2_len);
+		m = rte_ipv4_frag_reassemble_packet(tbl, dr, m, rte_rdtsc(),
+			ip);
+		TEST_ASSERT_NULL(m, "incomplete datagram reassembled");
+	}
+	TEST_ASSERT_EQUAL(tbl->use_entries, BURST_SIZE,
+		"%u entries in use", tbl->use_entries);
+
+	/* not timed out yet */
+	rte_ip_frag_table_del_expired_entries(tbl, dr, rte_rdtsc());
+	TEST_ASSERT_EQUAL(tbl->use_entries, BURST_SIZE,
+		"%u entries in use", tbl->use_entries);
+
+	rte_ip_frag_table_del_expired_entries(tbl, dr, UINT64_MAX);
+	rte_ip_frag_free_death_row(dr, 0);
+	TEST_ASSERT_EQUAL(tbl->use_entries, 0,
+		"%u entries still in use", tbl->use_entries);
+	rte_ip_frag_table_destroy(tbl);
+
+	TEST_ASSERT_EQUAL(rte_mempool_count(frag_pool), avail, "mbufs leaked");
+
+	return 0;
+}
+
+static int
+test_ip_frag_shared(void)
+{
+	char name[RTE_RING_NAMESIZE];
+	unsigned lcore_id, n_workers;
+	int ret;
+
+	if (ip_frag_pool_init() != 0)
+		return -1;
+
+	n_workers = 0;
+	RTE_LCORE_FOREACH(lcore_id) {
+		if (n_workers == MAX_WORKERS)
+			break;
+		frag_test.lcore[n_workers] = lcore_id;
+		snprintf(name, sizeof(name), "ip_frag_test_%u", n_workers);
+		frag_test.ring[n_workers] = rte_ring_create(name, RING_SIZE,
+			SOCKET_ID_ANY, RING_F_SP_ENQ | RING_F_SC_DEQ);
+		if (frag_test.ring[n_workers] == NULL)
+			break;
+		n_workers++;
+	}
+
+	ret = -1;
+	if (n_workers != 0 && rte_get_master_lcore() == frag_test.lcore[0]) {
+		ret = test_ip_frag_shared_expire();
+		if (ret == 0)
+			ret = test_ip_frag_shared_run(1);
+		if (ret == 0 && n_workers > 1)
+			ret = test_ip_frag_shared_run(n_workers);
+		else if (n_workers == 1)
+			printf("only one lcore, multi-lcore run skipped\n");
+	}
+
+	while (n_workers != 0)
+		rte_ring_free(frag_test.ring[--n_workers]);
+
+	return ret;
+}
+
+static struct test_command ip_frag_cmd = {
+	.command = "ip_frag_autotest",
+	.callback = test_ip_frag,
+};
+REGISTER_TEST_COMMAND(ip_frag_cmd);
+
+static struct test_command ip_frag_shared_cmd = {
+	.command = "ip_frag_shared_autotest",
+	.callback = test_ip_frag_shared,
+};
+REGISTER_TEST_COMMAND(ip_frag_shared_cmd);
@@ -0,0 +1,392 @@
+/*-
+ *   BSD LICENSE
+ *
+ *   Copyright(c) 2016 Intel Corporation. All rights reserved.
+ *   All rights reserved.
+ *
+ *   Redistribution and use in source and binary forms, with or without
+ *   modification, are permitted provided that the following conditions
+ *   are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ *     * Neither the name of Intel Corporation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *   OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+
+#include "test.h"
+
+#include <rte_cycles.h>
+#include <rte_ether.h>
+#include <rte_ip.h>
+#include <rte_ip_frag.h>
+#include <rte_mbuf.h>
+#include <rte_random.h>
+
+/*
+ * Reassembly of NB_FLOWS IPv4 datagrams of FRAGS_PER_DGRAM fragments, all
+ * received interleaved, so that every fragment looks up a cold entry in a
+ * table much larger than the caches. The fragments go through the table
+ * one at a time, then BURST at a time with the bulk function.
+ *
+ * Fragmentation of a JUMBO_LEN bytes IPv4 packet, in a chain of default
+ * size mbufs, for a JUMBO_MTU MTU, with
+ * rte_ipv4_fragment_packet(), then with rte_ipv4_fragment_packet_bulk()
+ * computing the checksums in software and leaving them to the NIC. The
+ * fragments are freed as they are produced, like a TX queue would do.
+ */
+
+#define NB_FLOWS		16384
+#define FRAGS_PER_DGRAM		4
+#define FRAG_PAYLOAD		64
+#define NB_FRAGS		(NB_FLOWS * FRAGS_PER_DGRAM)
+#define NB_MBUFS		(NB_FRAGS + 1024)
+#define BURST			32
+#define N_ROUNDS		4
+
+#define TBL_BUCKET_ENTRIES	4
+
+#define JUMBO_LEN		9000
+#define JUMBO_MTU		1500
+#define JUMBO_FRAGS		8
+#define JUMBO_ITER		(1 << 17)
+
+#define DGRAM_LEN		(sizeof(struct ether_hdr) + \
+	sizeof(struct ipv4_hdr) + FRAGS_PER_DGRAM * FRAG_PAYLOAD)
+
+static struct rte_mempool *perf_pool;
+static struct rte_mbuf *perf_frags[NB_FRAGS];
+static struct rte_ip_frag_death_row perf_dr;
+
+/* build all the fragments, interleaved in random order */
+static int
+perf_frags_build(void)
+{
+	struct rte_mbuf *m;
+	struct ether_hdr *eth;
+	struct ipv4_hdr *ip;
+	uint16_t ofs;
+	uint32_t i, j, id, frag;
+
+	for (i = 0; i != NB_FRAGS; i++) {
+		id = i / FRAGS_PER_DGRAM;
+		frag = i % FRAGS_PER_DGRAM;
+
+		m = rte_pktmbuf_alloc(perf_pool);
+		if (m == NULL)
+			return -1;
+		eth = (struct ether_hdr *)rte_pktmbuf_append(m,
+			sizeof(*eth) + sizeof(*ip) + FRAG_PAYLOAD);
+		if (eth == NULL) {
+			rte_pktmbuf_free(m);
+			return -1;
+		}
+		memset(eth, 0, sizeof(*eth) + sizeof(*ip));
+		eth->ether_type = rte_cpu_to_be_16(ETHER_TYPE_IPv4);
+
+		ofs = frag * FRAG_PAYLOAD / IPV4_HDR_OFFSET_UNITS;
+		if (frag != FRAGS_PER_DGRAM - 1)
+			ofs |= IPV4_HDR_MF_FLAG;
+
+		ip = (struct ipv4_hdr *)(eth + 1);
+		ip->version_ihl = 0x45;
+		ip->total_length = rte_cpu_to_be_16(sizeof(*ip) + FRAG_PAYLOAD);
+		ip->packet_id = rte_cpu_to_be_16((uint16_t)id);
+		ip->fragment_offset = rte_cpu_to_be_16(ofs);
+		ip->time_to_live = 64;
+		ip->next_proto_id = IPPROTO_UDP;
+		ip->src_addr = rte_cpu_to_be_32(IPv4(10, 0, 0, 1));
+		ip->dst_addr = rte_cpu_to_be_32(IPv4(10, 0, 0, 2));
+
+		m->l2_len = sizeof(*eth);
+		m->l3_len = sizeof(*ip);
+		perf_frags[i] = m;
+	}
+
+	for (i = NB_FRAGS - 1; i > 0; i--) {
+		j = rte_rand() % (i + 1);
+		m = perf_frags[i];
+		perf_frags[i] = perf_frags[j];
+		perf_frags[j] = m;
+	}
+
+	return 0;
+}
+
+/* reassemble all the fragments, one at a time or in bursts */
+static int
+perf_reassemble(struct rte_ip_frag_tbl *tbl, int bulk, uint64_t *cycles)
+{
+	struct rte_mbuf *out[BURST];
+	struct rte_mbuf *m;
+	struct ipv4_hdr *ip;
+	uint64_t start, tms;
+	uint32_t i, j, n, completed, bad;
+
+	if (perf_frags_build() != 0) {
+		printf("Error building fragments\n");
+		return -1;
+	}
+
+	completed = 0;
+	bad = 0;
+	start = rte_rdtsc();
+
+	for (i = 0; i != NB_FRAGS; i += BURST) {
+		tms = rte_rdtsc();
+		if (bulk) {
+			n = rte_ipv4_frag_reassemble_bulk(tbl, &perf_dr,
+				&perf_frags[i], BURST, tms, out);
+		} else {
+			n = 0;
+			for (j = 0; j != BURST; j++) {
+				m = perf_frags[i + j];
+				ip = rte_pktmbuf_mtod_offset(m,
+					struct ipv4_hdr *, m->l2_len);
+				m = rte_ipv4_frag_reassemble_packet(tbl,
+					&perf_dr, m, tms, ip);
+				if (m != NULL)
+					out[n++] = m;
+			}
+			rte_ip_frag_free_death_row(&perf_dr, 3);
+		}
+
+		for (j = 0; j != n; j++) {
+			bad += (out[j]->pkt_len != DGRAM_LEN);
+			rte_pktmbuf_free(out[j]);
+		}
+		completed += n;
+	}
+
+	*cycles += rte_rdtsc() - start;
+
+	if (completed != NB_FLOWS || bad != 0) {
+		printf("Error: %u/%u datagrams reassembled, %u bad\n",
+			completed, NB_FLOWS, bad);
+		return -1;
+	}
+
+	return 0;
+}
+
+static int
+test_ip_frag_perf(void)
+{
+	struct rte_ip_frag_tbl *tbl;
+	uint64_t cycles[2];
+	uint32_t r;
+	int bulk;
+
+	if (perf_pool == NULL) {
+		perf_pool = rte_pktmbuf_pool_create("ip_frag_perf_pool",
+			NB_MBUFS, 256, 0, RTE_PKTMBUF_HEADROOM + 256,
+			SOCKET_ID_ANY);
+		if (perf_pool == NULL) {
+			printf("Error creating mbuf pool\n");
+			return -1;
+		}
+	}
+
+	tbl = rte_ip_frag_table_create(NB_FLOWS, TBL_BUCKET_ENTRIES, NB_FLOWS,
+		rte_get_tsc_hz(), SOCKET_ID_ANY);
+	if (tbl == NULL) {
+		printf("Error creating table\n");
+		return -1;
+	}
+
+	cycles[0] = 0;
+	cycles[1] = 0;
+	for (r = 0; r != N_ROUNDS; r++) {
+		for (bulk = 0; bulk != 2; bulk++) {
+			if (perf_reassemble(tbl, bulk, &cycles[bulk]) != 0) {
+				rte_ip_frag_table_destroy(tbl);
+				return -1;
+			}
+		}
+	}
+
+	rte_ip_frag_table_destroy(tbl);
+
+	printf("IPv4 reassembly, %u flows, %u fragments each:\n",
+		NB_FLOWS, FRAGS_PER_DGRAM);
+	printf("  single: %.1f cycles/frag, %.2f Mfrags/s\n",
+		(double)cycles[0] / (N_ROUNDS * NB_FRAGS),
+		(double)N_ROUNDS * NB_FRAGS * rte_get_tsc_hz() / cycles[0] / 1e6);
+	printf("  bulk:   %.1f cycles/frag, %.2f Mfrags/s\n",
+		(double)cycles[1] / (N_ROUNDS * NB_FRAGS),
+		(double)N_ROUNDS * NB_FRAGS * rte_get_tsc_hz() / cycles[1] / 1e6);
+
+	return 0;
+}
+
+static struct rte_mempool *direct_pool;
+static struct rte_mempool *indirect_pool;
+
+static int
+perf_fragment_pools_init(void)
+{
+	if (direct_pool == NULL)
+		direct_pool = rte_pktmbuf_pool_create("ip_frag_direct_pool",
+			4095, 256, 0, RTE_MBUF_DEFAULT_BUF_SIZE,
+			SOCKET_ID_ANY);
+	if (indirect_pool == NULL)
+		indirect_pool = rte_pktmbuf_pool_create("ip_frag_indirect_pool",
+			4095, 256, 0, 0, SOCKET_ID_ANY);
+
+	if (direct_pool == NULL || indirect_pool == NULL) {
+		printf("Error creating mbuf pools\n");
+		return -1;
+	}
+
+	return 0;
+}
+
+/* jumbo packet in a chain of default size mbufs, as scattered RX gives */
+static struct rte_mbuf *
+perf_jumbo_build(void)
+{
+	struct rte_mbuf *m, *seg, *prev;
+	uint32_t len, ofs;
+
+	m = NULL;
+	prev = NULL;
+	for (ofs = 0; ofs != JUMBO_LEN; ofs += len) {
+		seg = rte_pktmbuf_alloc(direct_pool);
+		if (seg == NULL) {
+			rte_pktmbuf_free(m);
+			return NULL;
+		}
+		len = RTE_MIN(rte_pktmbuf_tailroom(seg), JUMBO_LEN - ofs);
+		rte_pktmbuf_append(seg, len);
+
+		if (m == NULL) {
+			m = seg;
+		} else {
+			prev->next = seg;
+			m->nb_segs++;
+			m->pkt_len += len;
+		}
+		prev = seg;
+	}
+
+	return m;
+}
+
+/* fragment the jumbo packet JUMBO_ITER times, mode -1 for the old function */
+static int
+perf_fragment(struct rte_mbuf *m, int32_t mode, uint64_t *cycles)
+{
+	struct rte_mbuf *out[JUMBO_FRAGS];
+	uint64_t start;
+	uint32_t i;
+	int32_t j, n;
+
+	start = rte_rdtsc();
+
+	for (i = 0; i != JUMBO_ITER; i++) {
+		if (mode < 0)
+			n = rte_ipv4_fragment_packet(m, out, JUMBO_FRAGS,
+				JUMBO_MTU, direct_pool, indirect_pool);
+		else
+			n = rte_ipv4_fragment_packet_bulk(m, out, JUMBO_FRAGS,
+				JUMBO_MTU, direct_pool, indirect_pool, mode);
+		if (n <= 0) {
+			printf("Error: fragmentation failed (%d)\n", n);
+			return -1;
+		}
+		for (j = 0; j != n; j++)
+			rte_pktmbuf_free(out[j]);
+	}
+
+	*cycles = rte_rdtsc() - start;
+	return 0;
+}
+
+static int
+test_ip_fragment_perf(void)
+{
+	static const struct {
+		const char *name;
+		int32_t mode;
+	} modes[] = {
+		{ "rte_ipv4_fragment_packet", -1 },
+		{ "bulk, software checksum", 0 },
+		{ "bulk, checksum offload", RTE_IP_FRAG_TX_CKSUM_OFFLOAD },
+	};
+	struct rte_mbuf *m;
+	struct ipv4_hdr *ip;
+	uint64_t cycles;
+	uint32_t i, nb_frags;
+	int ret;
+
+	if (perf_fragment_pools_init() != 0)
+		return -1;
+
+	m = perf_jumbo_build();
+	if (m == NULL) {
+		printf("Error building jumbo packet\n");
+		return -1;
+	}
+	ip = rte_pktmbuf_mtod(m, struct ipv4_hdr *);
+	memset(ip, 0, sizeof(*ip));
+	ip->version_ihl = 0x45;
+	ip->total_length = rte_cpu_to_be_16(JUMBO_LEN);
+	ip->time_to_live = 64;
+	ip->next_proto_id = IPPROTO_UDP;
+	ip->src_addr = rte_cpu_to_be_32(IPv4(10, 0, 0, 1));
+	ip->dst_addr = rte_cpu_to_be_32(IPv4(10, 0, 0, 2));
+
+	nb_frags = (JUMBO_LEN - sizeof(*ip) + JUMBO_MTU - sizeof(*ip) - 1) /
+		(JUMBO_MTU - sizeof(*ip));
+
+	printf("IPv4 fragmentation, %u bytes to %u bytes MTU, %u fragments:\n",
+		JUMBO_LEN, JUMBO_MTU, nb_frags);
+
+	ret = 0;
+	for (i = 0; i != RTE_DIM(modes) && ret == 0; i++) {
+		ret = perf_fragment(m, modes[i].mode, &cycles);
+		if (ret != 0)
+			break;
+		printf("  %-26s %.1f cycles/pkt, %.2f Mpps, %.2f Mfrags/s\n",
+			modes[i].name, (double)cycles / JUMBO_ITER,
+			(double)JUMBO_ITER * rte_get_tsc_hz() / cycles / 1e6,
+			(double)JUMBO_ITER * nb_frags * rte_get_tsc_hz() /
+			cycles / 1e6);
+	}
+
+	rte_pktmbuf_free(m);
+	return ret;
+}
+
+static struct test_command ip_fragment_perf_cmd = {
+	.command = "ip_fragment_perf_autotest",
+	.callback = test_ip_fragment_perf,
+};
+REGISTER_TEST_COMMAND(ip_fragment_perf_cmd);
+
+static struct test_command ip_frag_perf_cmd = {
+	.command = "ip_frag_perf_autotest",
+	.callback = test_ip_frag_perf,
+};
+REGISTER_TEST_COMMAND(ip_frag_perf_cmd);
@@ -580,6 +580,17 @@ test_kni(void)
 		goto fail;
 	}
 
+	/* test of allocating KNI with too many queues */
+	snprintf(conf.name, sizeof(conf.name), TEST_KNI_PORT);
+	conf.nb_queues = RTE_KNI_MAX_QUEUES + 1;
+	kni = rte_kni_alloc(mp, &conf, &ops);
+	if (kni) {
+		ret = -1;
+		printf("Unexpectedly allocate a KNI device successfully "
+					"with %u queues\n", conf.nb_queues);
+		goto fail;
+	}
+
 	/* test of releasing NULL kni context */
 	ret = rte_kni_release(NULL);
 	if (ret == 0) {
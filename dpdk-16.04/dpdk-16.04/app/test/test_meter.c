@@ -466,6 +466,87 @@ tm_test_trtcm_color_aware_check(void)
 	return 0;
 }
 
+#define TM_TEST_BURST_N_METERS 4
+#define TM_TEST_BURST_N_PKTS   32
+
+/**
+ * functional test for the burst metering functions: a burst spread over
+ * a few meters gets the same colors as the one packet at a time functions
+ */
+static inline int
+tm_test_burst_check(void)
+{
+	struct rte_meter_srtcm sm[TM_TEST_BURST_N_METERS];
+	struct rte_meter_srtcm sm_ref[TM_TEST_BURST_N_METERS];
+	struct rte_meter_trtcm tm[TM_TEST_BURST_N_METERS];
+	struct rte_meter_trtcm tm_ref[TM_TEST_BURST_N_METERS];
+	struct rte_meter_srtcm *sm_burst[TM_TEST_BURST_N_PKTS];
+	struct rte_meter_trtcm *tm_burst[TM_TEST_BURST_N_PKTS];
+	enum rte_meter_color color[TM_TEST_BURST_N_PKTS];
+	enum rte_meter_color color_in[TM_TEST_BURST_N_PKTS];
+	uint32_t pkt_len[TM_TEST_BURST_N_PKTS];
+	uint64_t time;
+	uint32_t i, k;
+#define BURST_CHECK_MSG "burst_check"
+
+	for (i = 0; i < TM_TEST_BURST_N_METERS; i++) {
+		if (rte_meter_srtcm_config(&sm[i], &sparams) != 0)
+			melog(BURST_CHECK_MSG);
+		if (rte_meter_trtcm_config(&tm[i], &tparams) != 0)
+			melog(BURST_CHECK_MSG);
+	}
+	memcpy(sm_ref, sm, sizeof(sm));
+	memcpy(tm_ref, tm, sizeof(tm));
+
+	for (i = 0; i < TM_TEST_BURST_N_PKTS; i++) {
+		sm_burst[i] = &sm[i % TM_TEST_BURST_N_METERS];
+		tm_burst[i] = &tm[i % TM_TEST_BURST_N_METERS];
+		pkt_len[i] = 64 + 100 * i;
+		color_in[i] = (enum rte_meter_color) (i % e_RTE_METER_COLORS);
+	}
+
+	/* Each pass consumes credits, so that all colors show up */
+	for (k = 0; k < 4; k++) {
+		time = rte_get_tsc_cycles();
+
+		rte_meter_srtcm_color_blind_check_burst(sm_burst, time, pkt_len,
+			color, TM_TEST_BURST_N_PKTS);
+		for (i = 0; i < TM_TEST_BURST_N_PKTS; i++)
+			if (color[i] != rte_meter_srtcm_color_blind_check(
+				&sm_ref[i % TM_TEST_BURST_N_METERS], time,
+				pkt_len[i]))
+				melog(BURST_CHECK_MSG);
+
+		memcpy(color, color_in, sizeof(color));
+		rte_meter_srtcm_color_aware_check_burst(sm_burst, time, pkt_len,
+			color, TM_TEST_BURST_N_PKTS);
+		for (i = 0; i < TM_TEST_BURST_N_PKTS; i++)
+			if (color[i] != rte_meter_srtcm_color_aware_check(
+				&sm_ref[i % TM_TEST_BURST_N_METERS], time,
+				pkt_len[i], color_in[i]))
+				melog(BURST_CHECK_MSG);
+
+		rte_meter_trtcm_color_blind_check_burst(tm_burst, time, pkt_len,
+			color, TM_TEST_BURST_N_PKTS);
+		for (i = 0; i < TM_TEST_BURST_N_PKTS; i++)
+			if (color[i] != rte_meter_trtcm_color_blind_check(
+				&tm_ref[i % TM_TEST_BURST_N_METERS], time,
+				pkt_len[i]))
+				melog(BURST_CHECK_MSG);
+
+		memcpy(color, color_in, sizeof(color));
+		rte_meter_trtcm_color_aware_check_burst(tm_burst, time, pkt_len,
+			color, TM_TEST_BURST_N_PKTS);
+		for (i = 0; i < TM_TEST_BURST_N_PKTS; i++)
+			if (color[i] != rte_meter_trtcm_color_aware_check(
+				&tm_ref[i % TM_TEST_BURST_N_METERS], time,
+				pkt_len[i], color_in[i]))
+				melog(BURST_CHECK_MSG);
+	}
+
+	return 0;
+}
+
 /**
  * test main entrance for library meter
  */
@@ -490,6 +571,9 @@ test_meter(void)
 	if(tm_test_trtcm_color_aware_check()!= 0)
 		return -1;
 
+	if (tm_test_burst_check() != 0)
+		return -1;
+
 	return 0;
 
 }
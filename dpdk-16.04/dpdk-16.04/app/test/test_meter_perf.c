@@ -0,0 +1,227 @@
+/*-
+ *   BSD LICENSE
+ *
+ *   Copyright(c) 2016 Intel Corporation. All rights reserved.
+ *   All rights reserved.
+ *
+ *   Redistribution and use in source and binary forms, with or without
+ *   modification, are permitted provided that the following conditions
+ *   are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ *     * Neither the name of Intel Corporation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *   OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <inttypes.h>
+
+#include "test.h"
+
+#include <rte_cycles.h>
+#include <rte_malloc.h>
+#include <rte_random.h>
+#include <rte_meter.h>
+
+#define BURST        32
+#define N_BURSTS     (1 << 15)
+#define N_PKT_LEN    64
+#define METERS_SMALL 16
+#define METERS_LARGE (1 << 16)
+
+static struct rte_meter_srtcm_params sparams = {
+	.cir = 1000000,
+	.cbs = 16384,
+	.ebs = 16384,
+};
+
+static struct rte_meter_trtcm_params tparams = {
+	.cir = 1000000,
+	.pir = 2000000,
+	.cbs = 16384,
+	.pbs = 16384,
+};
+
+/* Meter index, length and input color of each packet of the test traffic */
+static uint32_t pkt_meter[N_BURSTS * BURST];
+static uint32_t pkt_len[N_PKT_LEN];
+static enum rte_meter_color pkt_color_in[N_PKT_LEN];
+
+static void
+init_traffic(uint32_t n_meters)
+{
+	uint32_t i;
+
+	for (i = 0; i < N_BURSTS * BURST; i++)
+		pkt_meter[i] = rte_rand() % n_meters;
+
+	for (i = 0; i < N_PKT_LEN; i++) {
+		pkt_len[i] = 64 + rte_rand() % 1455;
+		pkt_color_in[i] = (enum rte_meter_color)
+			(rte_rand() % e_RTE_METER_COLORS);
+	}
+}
+
+static int
+test_srtcm_perf(uint32_t n_meters)
+{
+	struct rte_meter_srtcm *m;
+	struct rte_meter_srtcm *burst_m[BURST];
+	enum rte_meter_color color[BURST];
+	uint64_t start, single_cycles, burst_cycles, n_green = 0;
+	uint32_t i, j;
+
+	m = rte_zmalloc(NULL, n_meters * sizeof(*m), RTE_CACHE_LINE_SIZE);
+	if (m == NULL) {
+		printf("Error allocating %u srTCM meters\n", n_meters);
+		return -1;
+	}
+	for (i = 0; i < n_meters; i++)
+		if (rte_meter_srtcm_config(&m[i], &sparams) != 0) {
+			rte_free(m);
+			return -1;
+		}
+
+	init_traffic(n_meters);
+
+	/* One packet at a time */
+	start = rte_rdtsc();
+	for (i = 0; i < N_BURSTS; i++) {
+		uint64_t time = rte_rdtsc();
+
+		for (j = 0; j < BURST; j++)
+			n_green += rte_meter_srtcm_color_blind_check(
+				&m[pkt_meter[i * BURST + j]], time,
+				pkt_len[j]) == e_RTE_METER_GREEN;
+	}
+	single_cycles = rte_rdtsc() - start;
+
+	/* Burst */
+	start = rte_rdtsc();
+	for (i = 0; i < N_BURSTS; i++) {
+		uint64_t time = rte_rdtsc();
+
+		for (j = 0; j < BURST; j++)
+			burst_m[j] = &m[pkt_meter[i * BURST + j]];
+
+		rte_meter_srtcm_color_blind_check_burst(burst_m, time, pkt_len,
+			color, BURST);
+		for (j = 0; j < BURST; j++)
+			n_green += color[j] == e_RTE_METER_GREEN;
+	}
+	burst_cycles = rte_rdtsc() - start;
+
+	printf("srTCM color blind, %6u meters: %.1f cycles/pkt single, "
+		"%.1f cycles/pkt burst (%" PRIu64 " green)\n", n_meters,
+		(double) single_cycles / (N_BURSTS * BURST),
+		(double) burst_cycles / (N_BURSTS * BURST), n_green);
+
+	rte_free(m);
+	return 0;
+}
+
+static int
+test_trtcm_perf(uint32_t n_meters)
+{
+	struct rte_meter_trtcm *m;
+	struct rte_meter_trtcm *burst_m[BURST];
+	enum rte_meter_color color[BURST];
+	uint64_t start, single_cycles, burst_cycles, n_green = 0;
+	uint32_t i, j;
+
+	m = rte_zmalloc(NULL, n_meters * sizeof(*m), RTE_CACHE_LINE_SIZE);
+	if (m == NULL) {
+		printf("Error allocating %u trTCM meters\n", n_meters);
+		return -1;
+	}
+	for (i = 0; i < n_meters; i++)
+		if (rte_meter_trtcm_config(&m[i], &tparams) != 0) {
+			rte_free(m);
+			return -1;
+		}
+
+	init_traffic(n_meters);
+
+	/* One packet at a time */
+	start = rte_rdtsc();
+	for (i = 0; i < N_BURSTS; i++) {
+		uint64_t time = rte_rdtsc();
+
+		for (j = 0; j < BURST; j++)
+			n_green += rte_meter_trtcm_color_aware_check(
+				&m[pkt_meter[i * BURST + j]], time,
+				pkt_len[j], pkt_color_in[j]) ==
+				e_RTE_METER_GREEN;
+	}
+	single_cycles = rte_rdtsc() - start;
+
+	/* Burst */
+	start = rte_rdtsc();
+	for (i = 0; i < N_BURSTS; i++) {
+		uint64_t time = rte_rdtsc();
+
+		for (j = 0; j < BURST; j++)
+			burst_m[j] = &m[pkt_meter[i * BURST + j]];
+
+		memcpy(color, pkt_color_in, sizeof(color));
+		rte_meter_trtcm_color_aware_check_burst(burst_m, time, pkt_len,
+			color, BURST);
+		for (j = 0; j < BURST; j++)
+			n_green += color[j] == e_RTE_METER_GREEN;
+	}
+	burst_cycles = rte_rdtsc() - start;
+
+	printf("trTCM color aware, %6u meters: %.1f cycles/pkt single, "
+		"%.1f cycles/pkt burst (%" PRIu64 " green)\n", n_meters,
+		(double) single_cycles / (N_BURSTS * BURST),
+		(double) burst_cycles / (N_BURSTS * BURST), n_green);
+
+	rte_free(m);
+	return 0;
+}
+
+static int
+test_meter_perf(void)
+{
+	RTE_BUILD_BUG_ON(BURST > N_PKT_LEN);
+
+	if (test_srtcm_perf(METERS_SMALL) < 0)
+		return -1;
+
+	if (test_srtcm_perf(METERS_LARGE) < 0)
+		return -1;
+
+	if (test_trtcm_perf(METERS_SMALL) < 0)
+		return -1;
+
+	if (test_trtcm_perf(METERS_LARGE) < 0)
+		return -1;
+
+	return 0;
+}
+
+static struct test_command meter_perf_cmd = {
+	.command = "meter_perf_autotest",
+	.callback = test_meter_perf,
+};
+REGISTER_TEST_COMMAND(meter_perf_cmd);
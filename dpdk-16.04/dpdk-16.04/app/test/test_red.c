@@ -1850,6 +1850,86 @@ test_invalid_parameters(void)
 	return 0;
 }
 
+#define BULK_N_PKTS          32
+#define BULK_N_BURSTS        100000
+
+static uint32_t bulk_tlevel[] = {0, 8, 24, 64, 160};
+
+/**
+ * check that the bulk enqueue gives the same verdicts as the per packet
+ * enqueue, and compare their performance
+ */
+static int
+test_bulk(void)
+{
+	struct rte_red_config config;
+	struct rte_red red_pkt, red_bulk;
+	uint64_t cycles_pkt, cycles_bulk, start, ts;
+	uint64_t mask_pkt, mask_bulk;
+	uint32_t rand_seed, rand_val;
+	uint32_t i, j, k, q;
+
+	init_port_ts(rte_get_tsc_hz());
+
+	if (rte_red_config_init(&config, 9, 32, 128, 10) != 0) {
+		printf("%i: rte_red_config_init failed!\n", __LINE__);
+		return -1;
+	}
+
+	printf("\nbulk enqueue of %u packets: queue size, cycles per packet "
+		"(per packet enqueue, bulk enqueue)\n", BULK_N_PKTS);
+
+	for (i = 0; i < RTE_DIM(bulk_tlevel); i++) {
+		rte_red_rt_data_init(&red_pkt);
+		rte_red_rt_data_init(&red_bulk);
+		rte_red_set_avg_int(&config, &red_pkt, bulk_tlevel[i]);
+		rte_red_set_avg_int(&config, &red_bulk, bulk_tlevel[i]);
+		cycles_pkt = 0;
+		cycles_bulk = 0;
+
+		/* The queue is back to the same size for every burst */
+		for (j = 0; j < BULK_N_BURSTS; j++) {
+			ts = get_port_ts();
+			rand_seed = rte_red_rand_seed;
+			rand_val = rte_red_rand_val;
+
+			start = rte_rdtsc();
+			mask_pkt = 0;
+			for (k = 0, q = bulk_tlevel[i]; k < BULK_N_PKTS; k++) {
+				if (rte_red_enqueue(&config, &red_pkt, q, ts) == 0)
+					q++;
+				else
+					mask_pkt |= 1LLU << k;
+			}
+			cycles_pkt += rte_rdtsc() - start;
+
+			rte_red_rand_seed = rand_seed;
+			rte_red_rand_val = rand_val;
+
+			start = rte_rdtsc();
+			mask_bulk = rte_red_enqueue_bulk(&config, &red_bulk,
+				bulk_tlevel[i], ts, BULK_N_PKTS);
+			cycles_bulk += rte_rdtsc() - start;
+
+			if (mask_bulk != mask_pkt ||
+			    red_bulk.avg != red_pkt.avg ||
+			    red_bulk.count != red_pkt.count) {
+				printf("%i: bulk enqueue mismatch at queue size %u: "
+					"mask 0x%" PRIx64 " instead of 0x%" PRIx64 "\n",
+					__LINE__, bulk_tlevel[i], mask_bulk,
+					mask_pkt);
+				return -1;
+			}
+		}
+
+		printf("%-12u%-12.2lf%-12.2lf\n", bulk_tlevel[i],
+		       (double) cycles_pkt / (BULK_N_BURSTS * BULK_N_PKTS),
+		       (double) cycles_bulk / (BULK_N_BURSTS * BULK_N_PKTS));
+	}
+
+	return 0;
+}
+
 static int
 test_red(void)
 {
@@ -1860,6 +1940,9 @@ test_red(void)
 	if (test_invalid_parameters() < 0)
 		return -1;
 
+	if (test_bulk() < 0)
+		return -1;
+
 	run_tests(func_tests, RTE_DIM(func_tests), &num_tests, &num_pass);
 	run_tests(perf_tests, RTE_DIM(perf_tests), &num_tests, &num_pass);
 
@@ -35,15 +35,18 @@
 #include <stdio.h>
 #include <string.h>
 #include <stdint.h>
+#include <inttypes.h>
 #include <unistd.h>
 
 #include "test.h"
 
 #include <rte_cycles.h>
+#include <rte_random.h>
 #include <rte_ether.h>
 #include <rte_ip.h>
 #include <rte_byteorder.h>
 #include <rte_sched.h>
+#include <rte_aqm.h>
 
 
 #define SUBPORT         0
@@ -85,7 +88,7 @@ static struct rte_sched_port_params port_param = {
 	.n_pipe_profiles = 1,
 };
 
-#define NB_MBUF          32
+#define NB_MBUF          64
 #define MBUF_DATA_SZ     (2048 + RTE_PKTMBUF_HEADROOM)
 #define MEMPOOL_CACHE_SZ 0
 #define SOCKET           0
@@ -213,8 +216,745 @@ test_sched(void)
 	return 0;
 }
 
+static struct rte_sched_subport_params subport_param_tc_layout[] = {
+	{
+		.tb_rate = 1250000000,
+		.tb_size = 1000000,
+
+		.tc_rate = {1250000000, 1250000000, 1250000000, 1250000000,
+			1250000000, 1250000000, 1250000000, 1250000000,
+			1250000000},
+		.tc_period = 10,
+	},
+};
+
+static struct rte_sched_pipe_params pipe_profile_tc_layout[] = {
+	{ /* Profile #0 */
+		.tb_rate = 305175,
+		.tb_size = 1000000,
+
+		.tc_rate = {305175, 305175, 305175, 305175, 305175, 305175,
+			305175, 305175, 305175},
+		.tc_period = 40,
+
+		.wrr_weights = {1, 1, 1, 1,  1, 1, 1, 1,  1, 2, 4, 8},
+	},
+};
+
+/* 8 strict priority TCs of 1 queue each, plus a best effort TC of 4 queues */
+static struct rte_sched_port_params port_param_tc_layout = {
+	.socket = 0, /* computed */
+	.rate = 0, /* computed */
+	.mtu = 1522,
+	.frame_overhead = RTE_SCHED_FRAME_OVERHEAD_DEFAULT,
+	.n_subports_per_port = 1,
+	.n_pipes_per_subport = 1024,
+	.qsize = {64, 64, 64, 64, 64, 64, 64, 64, 64},
+	.n_queues_per_tc = {1, 1, 1, 1, 1, 1, 1, 1, 4},
+	.pipe_profiles = pipe_profile_tc_layout,
+	.n_pipe_profiles = 1,
+};
+
+#define TC_LAYOUT_TC_HIGH   1
+#define TC_LAYOUT_TC_LOW    8
+#define TC_LAYOUT_QUEUE_LOW 2
+
+/**
+ * test port with a non default traffic class layout
+ */
+static int
+test_sched_tc_layout(void)
+{
+	struct rte_mempool *mp = NULL;
+	struct rte_sched_port *port = NULL;
+	struct rte_sched_port_params bad_param;
+	struct rte_sched_queue_stats queue_stats;
+	uint16_t qlen;
+	uint32_t pipe;
+	struct rte_mbuf *in_mbufs[10];
+	struct rte_mbuf *out_mbufs[10];
+	int i;
+
+	int err;
+
+	mp = create_mempool();
+	TEST_ASSERT_NOT_NULL(mp, "Error creating mempool\n");
+
+	port_param_tc_layout.socket = 0;
+	port_param_tc_layout.rate = (uint64_t) 10000 * 1000 * 1000 / 8;
+
+	/* Invalid layouts: 3 queues in a TC, more than 16 queues in total */
+	bad_param = port_param_tc_layout;
+	bad_param.n_queues_per_tc[8] = 3;
+	port = rte_sched_port_config(&bad_param);
+	TEST_ASSERT_NULL(port, "Port config accepted 3 queues per TC\n");
+
+	bad_param = port_param_tc_layout;
+	bad_param.n_queues_per_tc[9] = 4;
+	bad_param.n_queues_per_tc[10] = 4;
+	bad_param.qsize[9] = 64;
+	bad_param.qsize[10] = 64;
+	port = rte_sched_port_config(&bad_param);
+	TEST_ASSERT_NULL(port, "Port config accepted 20 queues per pipe\n");
+
+	port = rte_sched_port_config(&port_param_tc_layout);
+	TEST_ASSERT_NOT_NULL(port, "Error config sched port\n");
+
+	err = rte_sched_subport_config(port, SUBPORT, subport_param_tc_layout);
+	TEST_ASSERT_SUCCESS(err, "Error config sched, err=%d\n", err);
+
+	for (pipe = 0; pipe < port_param_tc_layout.n_pipes_per_subport; pipe++) {
+		err = rte_sched_pipe_config(port, SUBPORT, pipe, 0);
+		TEST_ASSERT_SUCCESS(err, "Error config sched pipe %u, err=%d\n",
+			pipe, err);
+	}
+
+	/* Low priority packets are enqueued first */
+	for (i = 0; i < 10; i++) {
+		in_mbufs[i] = rte_pktmbuf_alloc(mp);
+		TEST_ASSERT_NOT_NULL(in_mbufs[i], "Packet allocation failed\n");
+		in_mbufs[i]->pkt_len = 60;
+		in_mbufs[i]->data_len = 60;
+		if (i < 5)
+			rte_sched_port_pkt_write(in_mbufs[i], SUBPORT, PIPE,
+				TC_LAYOUT_TC_LOW, TC_LAYOUT_QUEUE_LOW,
+				e_RTE_METER_GREEN);
+		else
+			rte_sched_port_pkt_write(in_mbufs[i], SUBPORT, PIPE,
+				TC_LAYOUT_TC_HIGH, 0, e_RTE_METER_GREEN);
+	}
+
+	err = rte_sched_port_enqueue(port, in_mbufs, 10);
+	TEST_ASSERT_EQUAL(err, 10, "Wrong enqueue, err=%d\n", err);
+
+	err = rte_sched_port_dequeue(port, out_mbufs, 10);
+	TEST_ASSERT_EQUAL(err, 10, "Wrong dequeue, err=%d\n", err);
+
+	/* ... and dequeued last */
+	for (i = 0; i < 10; i++) {
+		uint32_t subport, traffic_class, queue;
+
+		rte_sched_port_pkt_read_tree_path(out_mbufs[i],
+				&subport, &pipe, &traffic_class, &queue);
+
+		TEST_ASSERT_EQUAL(subport, SUBPORT, "Wrong subport\n");
+		TEST_ASSERT_EQUAL(pipe, PIPE, "Wrong pipe\n");
+		if (i < 5) {
+			TEST_ASSERT_EQUAL(traffic_class, TC_LAYOUT_TC_HIGH,
+				"Wrong traffic_class\n");
+			TEST_ASSERT_EQUAL(queue, 0, "Wrong queue\n");
+		} else {
+			TEST_ASSERT_EQUAL(traffic_class, TC_LAYOUT_TC_LOW,
+				"Wrong traffic_class\n");
+			TEST_ASSERT_EQUAL(queue, TC_LAYOUT_QUEUE_LOW,
+				"Wrong queue\n");
+		}
+
+		rte_pktmbuf_free(out_mbufs[i]);
+	}
+
+	/* Queue IDs beyond the last queue of the TC stay within the TC */
+	in_mbufs[0] = rte_pktmbuf_alloc(mp);
+	TEST_ASSERT_NOT_NULL(in_mbufs[0], "Packet allocation failed\n");
+	in_mbufs[0]->pkt_len = 60;
+	in_mbufs[0]->data_len = 60;
+	rte_sched_port_pkt_write(in_mbufs[0], SUBPORT, PIPE, TC_LAYOUT_TC_HIGH,
+		3, e_RTE_METER_GREEN);
+
+	err = rte_sched_port_enqueue(port, in_mbufs, 1);
+	TEST_ASSERT_EQUAL(err, 1, "Wrong enqueue, err=%d\n", err);
+
+	err = rte_sched_queue_read_stats(port,
+		PIPE * RTE_SCHED_QUEUES_PER_PIPE + TC_LAYOUT_TC_HIGH,
+		&queue_stats, &qlen);
+	TEST_ASSERT_SUCCESS(err, "Error reading queue stats, err=%d\n", err);
+	TEST_ASSERT_EQUAL(qlen, 1, "Packet not in the queue of its TC\n");
+
+	err = rte_sched_port_dequeue(port, out_mbufs, 1);
+	TEST_ASSERT_EQUAL(err, 1, "Wrong dequeue, err=%d\n", err);
+	rte_pktmbuf_free(out_mbufs[0]);
+
+	rte_sched_port_free(port);
+
+	return 0;
+}
+
+static struct rte_sched_pipe_params pipe_profile_group[] = {
+	{ /* Profile #0 */
+		.tb_rate = 1250000000,
+		.tb_size = 1000000,
+
+		.tc_rate = {1250000000, 1250000000, 1250000000, 1250000000},
+		.tc_period = 10,
+
+		.wrr_weights = {1, 1, 1, 1,  1, 1, 1, 1,  1, 1, 1, 1,  1, 1, 1, 1},
+	},
+};
+
+static struct rte_sched_port_group_params group_param = {
+	.name = "group_0",
+	.socket = 0,
+	.rate = 2048000, /* 2000 packets of 1 KB per second */
+	.tb_size = 4096,
+	.credits_grant = 2048,
+};
+
+#define GROUP_N_PORTS       2
+#define GROUP_PKTS_PER_PORT 12
+#define GROUP_PKT_LEN       (1024 - RTE_SCHED_FRAME_OVERHEAD_DEFAULT)
+#define GROUP_TEST_MS       100
+
+/**
+ * test ports sharing the rate of one output port
+ */
+static int
+test_sched_port_group(void)
+{
+	struct rte_mempool *mp = NULL;
+	struct rte_sched_port_group *group = NULL;
+	struct rte_sched_port *ports[GROUP_N_PORTS];
+	struct rte_sched_port_params param = port_param;
+	struct rte_mbuf *mbufs[GROUP_PKTS_PER_PORT];
+	uint32_t n_queued[GROUP_N_PORTS];
+	uint64_t n_bytes, n_bytes_expected, hz, start;
+	uint32_t p;
+	int i, n;
+
+	int err;
+
+	mp = create_mempool();
+	TEST_ASSERT_NOT_NULL(mp, "Error creating mempool\n");
+
+	group = rte_sched_port_group_create(&group_param);
+	TEST_ASSERT_NOT_NULL(group, "Error creating port group\n");
+
+	param.socket = 0;
+	param.rate = (uint64_t) 10000 * 1000 * 1000 / 8;
+	param.n_pipes_per_subport = 1024;
+	param.pipe_profiles = pipe_profile_group;
+
+	for (p = 0; p < GROUP_N_PORTS; p++) {
+		ports[p] = rte_sched_port_config(&param);
+		TEST_ASSERT_NOT_NULL(ports[p], "Error config sched port\n");
+
+		err = rte_sched_subport_config(ports[p], SUBPORT, subport_param);
+		TEST_ASSERT_SUCCESS(err, "Error config sched, err=%d\n", err);
+
+		err = rte_sched_pipe_config(ports[p], SUBPORT, PIPE, 0);
+		TEST_ASSERT_SUCCESS(err, "Error config sched pipe, err=%d\n", err);
+
+		err = rte_sched_port_group_add(group, ports[p]);
+		TEST_ASSERT_SUCCESS(err, "Error adding port to group, err=%d\n",
+			err);
+
+		for (i = 0; i < GROUP_PKTS_PER_PORT; i++) {
+			mbufs[i] = rte_pktmbuf_alloc(mp);
+			TEST_ASSERT_NOT_NULL(mbufs[i], "Packet allocation failed\n");
+			rte_sched_port_pkt_write(mbufs[i], SUBPORT, PIPE, TC,
+				QUEUE, e_RTE_METER_GREEN);
+			mbufs[i]->pkt_len = GROUP_PKT_LEN;
+			mbufs[i]->data_len = GROUP_PKT_LEN;
+		}
+
+		err = rte_sched_port_enqueue(ports[p], mbufs, GROUP_PKTS_PER_PORT);
+		TEST_ASSERT_EQUAL(err, GROUP_PKTS_PER_PORT,
+			"Wrong enqueue, err=%d\n", err);
+		n_queued[p] = GROUP_PKTS_PER_PORT;
+	}
+
+	err = rte_sched_port_group_add(group, ports[0]);
+	TEST_ASSERT_FAIL(err, "Port added twice to the group\n");
+
+	/* Keep all the ports backlogged, the output rate is the group one */
+	hz = rte_get_tsc_hz();
+	n_bytes = 0;
+	start = rte_get_tsc_cycles();
+	while (rte_get_tsc_cycles() - start < hz * GROUP_TEST_MS / 1000) {
+		for (p = 0; p < GROUP_N_PORTS; p++) {
+			n = rte_sched_port_dequeue(ports[p], mbufs,
+				GROUP_PKTS_PER_PORT);
+			n_bytes += n * (GROUP_PKT_LEN +
+				RTE_SCHED_FRAME_OVERHEAD_DEFAULT);
+			n_queued[p] -= n - rte_sched_port_enqueue(ports[p],
+				mbufs, n);
+		}
+	}
+
+	n_bytes_expected = (uint64_t) group_param.rate * GROUP_TEST_MS / 1000;
+	printf("Port group: %" PRIu64 " bytes sent, %" PRIu64 " expected\n",
+		n_bytes, n_bytes_expected);
+	TEST_ASSERT(n_bytes <= n_bytes_expected + group_param.tb_size +
+		GROUP_N_PORTS * (group_param.credits_grant +
+		GROUP_PKT_LEN + RTE_SCHED_FRAME_OVERHEAD_DEFAULT),
+		"Port group rate exceeded\n");
+	TEST_ASSERT(n_bytes >= n_bytes_expected * 8 / 10,
+		"Port group rate not reached\n");
+
+	/* Drain the ports at the group rate before freeing them */
+	start = rte_get_tsc_cycles();
+	for (p = 0; p < GROUP_N_PORTS; p++) {
+		while (n_queued[p] != 0 &&
+		       rte_get_tsc_cycles() - start < hz) {
+			n = rte_sched_port_dequeue(ports[p], mbufs,
+				GROUP_PKTS_PER_PORT);
+			for (i = 0; i < n; i++)
+				rte_pktmbuf_free(mbufs[i]);
+			n_queued[p] -= n;
+		}
+		TEST_ASSERT_EQUAL(n_queued[p], 0, "Port %u not drained\n", p);
+
+		rte_sched_port_free(ports[p]);
+	}
+	rte_sched_port_group_free(group);
+
+	return 0;
+}
+
+#define RUNTIME_N_PIPES 1024
+
+/**
+ * test changing the port configuration while packets are queued
+ */
+static int
+test_sched_runtime_config(void)
+{
+	struct rte_mempool *mp = NULL;
+	struct rte_sched_port *port = NULL;
+	struct rte_sched_port_params param = port_param;
+	struct rte_sched_subport_params subport_new = subport_param[0];
+	struct rte_sched_pipe_params profile_new = pipe_profile_group[0];
+	static uint32_t pipe_ids[RUNTIME_N_PIPES];
+	static int32_t pipe_profiles[RUNTIME_N_PIPES];
+	struct rte_mbuf *in_mbufs[10];
+	struct rte_mbuf *out_mbufs[10];
+	uint32_t pipe, profile_id;
+	int i;
+
+	int err;
+
+	mp = create_mempool();
+	TEST_ASSERT_NOT_NULL(mp, "Error creating mempool\n");
+
+	param.socket = 0;
+	param.rate = (uint64_t) 10000 * 1000 * 1000 / 8;
+	param.n_pipes_per_subport = RUNTIME_N_PIPES;
+
+	port = rte_sched_port_config(&param);
+	TEST_ASSERT_NOT_NULL(port, "Error config sched port\n");
+
+	err = rte_sched_subport_config(port, SUBPORT, subport_param);
+	TEST_ASSERT_SUCCESS(err, "Error config sched, err=%d\n", err);
+
+	for (pipe = 0; pipe < RUNTIME_N_PIPES; pipe++) {
+		pipe_ids[pipe] = pipe;
+		pipe_profiles[pipe] = 0;
+	}
+
+	err = rte_sched_pipe_config_bulk(port, SUBPORT, pipe_ids,
+		pipe_profiles, RUNTIME_N_PIPES);
+	TEST_ASSERT_SUCCESS(err, "Error bulk config pipes, err=%d\n", err);
+
+	for (i = 0; i < 10; i++) {
+		in_mbufs[i] = rte_pktmbuf_alloc(mp);
+		TEST_ASSERT_NOT_NULL(in_mbufs[i], "Packet allocation failed\n");
+		prepare_pkt(in_mbufs[i]);
+	}
+
+	err = rte_sched_port_enqueue(port, in_mbufs, 10);
+	TEST_ASSERT_EQUAL(err, 10, "Wrong enqueue, err=%d\n", err);
+
+	/* New speed tier */
+	err = rte_sched_port_pipe_profile_add(port, &profile_new, &profile_id);
+	TEST_ASSERT_SUCCESS(err, "Error adding pipe profile, err=%d\n", err);
+	TEST_ASSERT_EQUAL(profile_id, 1, "Wrong pipe profile ID %u\n",
+		profile_id);
+
+	/* Invalid pipe: no pipe is changed */
+	pipe_ids[RUNTIME_N_PIPES - 1] = RUNTIME_N_PIPES;
+	for (pipe = 0; pipe < RUNTIME_N_PIPES; pipe++)
+		pipe_profiles[pipe] = profile_id;
+	err = rte_sched_pipe_config_bulk(port, SUBPORT, pipe_ids,
+		pipe_profiles, RUNTIME_N_PIPES);
+	TEST_ASSERT_FAIL(err, "Bulk config accepted an invalid pipe\n");
+	pipe_ids[RUNTIME_N_PIPES - 1] = RUNTIME_N_PIPES - 1;
+
+	/* Move all the pipes to the new tier */
+	err = rte_sched_pipe_config_bulk(port, SUBPORT, pipe_ids,
+		pipe_profiles, RUNTIME_N_PIPES);
+	TEST_ASSERT_SUCCESS(err, "Error bulk config pipes, err=%d\n", err);
+
+	/* Change the tier rates and the subport rates */
+	profile_new.tb_rate /= 2;
+	for (i = 0; i < RTE_SCHED_TRAFFIC_CLASSES_PER_PIPE; i++)
+		profile_new.tc_rate[i] /= 2;
+	err = rte_sched_port_pipe_profile_update(port, profile_id,
+		&profile_new);
+	TEST_ASSERT_SUCCESS(err, "Error updating pipe profile, err=%d\n", err);
+
+	profile_new.tb_size = 0;
+	err = rte_sched_port_pipe_profile_update(port, profile_id,
+		&profile_new);
+	TEST_ASSERT_FAIL(err, "Pipe profile update accepted tb_size 0\n");
+
+	subport_new.tb_rate /= 2;
+	for (i = 0; i < RTE_SCHED_TRAFFIC_CLASSES_PER_PIPE; i++)
+		subport_new.tc_rate[i] /= 2;
+	err = rte_sched_subport_config(port, SUBPORT, &subport_new);
+	TEST_ASSERT_SUCCESS(err, "Error reconfig subport, err=%d\n", err);
+
+	/* The queued packets are still there */
+	err = rte_sched_port_dequeue(port, out_mbufs, 10);
+	TEST_ASSERT_EQUAL(err, 10, "Wrong dequeue, err=%d\n", err);
+
+	for (i = 0; i < 10; i++)
+		rte_pktmbuf_free(out_mbufs[i]);
+
+	rte_sched_port_free(port);
+
+	return 0;
+}
+
+struct aqm_test_cfg {
+	uint32_t qlen_max;
+	uint32_t n_calls;
+};
+
+/* Tail drop at qlen_max, with a per queue count of the packets seen */
+static int
+aqm_test_enqueue(void *cfg, void *data, uint32_t qlen, uint16_t qr,
+	uint64_t time)
+{
+	struct aqm_test_cfg *c = cfg;
+	uint64_t *n_pkts = data;
+
+	RTE_SET_USED(qr);
+	RTE_SET_USED(time);
+
+	c->n_calls++;
+	(*n_pkts)++;
+
+	return qlen >= c->qlen_max || *n_pkts != c->n_calls;
+}
+
+#define AQM_N_PKTS 10
+
+/**
+ * test the AQM hook of a traffic class
+ */
+static int
+test_sched_aqm(void)
+{
+	struct rte_mempool *mp = NULL;
+	struct rte_sched_port *port = NULL;
+	struct rte_sched_port_params param = port_param;
+	struct aqm_test_cfg aqm_cfg = { .qlen_max = 4, .n_calls = 0 };
+	struct rte_pie_config pie_cfg;
+	struct rte_mbuf *in_mbufs[AQM_N_PKTS];
+	struct rte_mbuf *out_mbufs[2 * AQM_N_PKTS];
+	int i;
+
+	int err;
+
+	mp = create_mempool();
+	TEST_ASSERT_NOT_NULL(mp, "Error creating mempool\n");
+
+	param.socket = 0;
+	param.rate = (uint64_t) 10000 * 1000 * 1000 / 8;
+	param.n_pipes_per_subport = 1024;
+
+	port = rte_sched_port_config(&param);
+	TEST_ASSERT_NOT_NULL(port, "Error config sched port\n");
+
+	err = rte_sched_subport_config(port, SUBPORT, subport_param);
+	TEST_ASSERT_SUCCESS(err, "Error config sched, err=%d\n", err);
+
+	err = rte_sched_pipe_config(port, SUBPORT, PIPE, 0);
+	TEST_ASSERT_SUCCESS(err, "Error config sched pipe, err=%d\n", err);
+
+	err = rte_sched_port_aqm_set(port, RTE_SCHED_TRAFFIC_CLASSES_PER_PIPE,
+		aqm_test_enqueue, &aqm_cfg);
+	TEST_ASSERT_FAIL(err, "AQM hook attached to an invalid TC\n");
+
+	err = rte_sched_port_aqm_set(port, TC, aqm_test_enqueue, NULL);
+	TEST_ASSERT_FAIL(err, "AQM hook attached without config\n");
+
+	err = rte_sched_port_aqm_set(port, TC, aqm_test_enqueue, &aqm_cfg);
+	TEST_ASSERT_SUCCESS(err, "Error attaching AQM hook, err=%d\n", err);
+
+	/* The hook drops the packets above its own queue limit */
+	for (i = 0; i < AQM_N_PKTS; i++) {
+		in_mbufs[i] = rte_pktmbuf_alloc(mp);
+		TEST_ASSERT_NOT_NULL(in_mbufs[i], "Packet allocation failed\n");
+		prepare_pkt(in_mbufs[i]);
+	}
+
+	err = rte_sched_port_enqueue(port, in_mbufs, AQM_N_PKTS);
+	TEST_ASSERT_EQUAL(err, (int) aqm_cfg.qlen_max,
+		"Wrong enqueue, err=%d\n", err);
+	TEST_ASSERT_EQUAL(aqm_cfg.n_calls, AQM_N_PKTS,
+		"Wrong AQM hook calls %u\n", aqm_cfg.n_calls);
+
+	/* Back to the plain queue once detached */
+	err = rte_sched_port_aqm_set(port, TC, NULL, NULL);
+	TEST_ASSERT_SUCCESS(err, "Error detaching AQM hook, err=%d\n", err);
+
+	for (i = 0; i < AQM_N_PKTS; i++) {
+		in_mbufs[i] = rte_pktmbuf_alloc(mp);
+		TEST_ASSERT_NOT_NULL(in_mbufs[i], "Packet allocation failed\n");
+		prepare_pkt(in_mbufs[i]);
+	}
+
+	err = rte_sched_port_enqueue(port, in_mbufs, AQM_N_PKTS);
+	TEST_ASSERT_EQUAL(err, AQM_N_PKTS, "Wrong enqueue, err=%d\n", err);
+
+	err = rte_sched_port_dequeue(port, out_mbufs, 2 * AQM_N_PKTS);
+	TEST_ASSERT_EQUAL(err, AQM_N_PKTS + (int) aqm_cfg.qlen_max,
+		"Wrong dequeue, err=%d\n", err);
+	for (i = 0; i < err; i++)
+		rte_pktmbuf_free(out_mbufs[i]);
+
+	/* PIE lets a short burst through */
+	err = rte_pie_config_init(&pie_cfg, param.rate / 1000, param.rate / 1000,
+		param.rate / 100, 16);
+	TEST_ASSERT_SUCCESS(err, "Error config PIE, err=%d\n", err);
+
+	err = rte_sched_port_aqm_set(port, TC, rte_sched_aqm_pie, &pie_cfg);
+	TEST_ASSERT_SUCCESS(err, "Error attaching AQM hook, err=%d\n", err);
+
+	for (i = 0; i < AQM_N_PKTS; i++) {
+		in_mbufs[i] = rte_pktmbuf_alloc(mp);
+		TEST_ASSERT_NOT_NULL(in_mbufs[i], "Packet allocation failed\n");
+		prepare_pkt(in_mbufs[i]);
+	}
+
+	err = rte_sched_port_enqueue(port, in_mbufs, AQM_N_PKTS);
+	TEST_ASSERT_EQUAL(err, AQM_N_PKTS, "Wrong enqueue, err=%d\n", err);
+
+	err = rte_sched_port_dequeue(port, out_mbufs, 2 * AQM_N_PKTS);
+	TEST_ASSERT_EQUAL(err, AQM_N_PKTS, "Wrong dequeue, err=%d\n", err);
+	for (i = 0; i < err; i++)
+		rte_pktmbuf_free(out_mbufs[i]);
+
+	rte_sched_port_free(port);
+
+	return 0;
+}
+
+static int
+test_sched_all(void)
+{
+	if (test_sched() < 0)
+		return -1;
+
+	if (test_sched_tc_layout() < 0)
+		return -1;
+
+	if (test_sched_port_group() < 0)
+		return -1;
+
+	if (test_sched_aqm() < 0)
+		return -1;
+
+	return test_sched_runtime_config();
+}
+
 static struct test_command sched_cmd = {
 	.command = "sched_autotest",
-	.callback = test_sched,
+	.callback = test_sched_all,
 };
 REGISTER_TEST_COMMAND(sched_cmd);
+
+#define PERF_RATE           4000000000U
+#define PERF_N_PIPES        4096
+#define PERF_N_MBUFS        8192
+#define PERF_N_PKTS_QUEUED  4096
+#define PERF_BURST          32
+#define PERF_N_BURSTS       (1 << 16)
+#define PERF_N_PATHS        (1 << 16)
+
+static struct rte_sched_subport_params subport_param_perf[] = {
+	{
+		.tb_rate = PERF_RATE,
+		.tb_size = 1000000,
+
+		.tc_rate = {PERF_RATE, PERF_RATE, PERF_RATE, PERF_RATE,
+			PERF_RATE, PERF_RATE, PERF_RATE, PERF_RATE,
+			PERF_RATE, PERF_RATE, PERF_RATE, PERF_RATE,
+			PERF_RATE, PERF_RATE, PERF_RATE, PERF_RATE},
+		.tc_period = 10,
+	},
+};
+
+static struct rte_sched_pipe_params pipe_profile_perf[] = {
+	{ /* Profile #0 */
+		.tb_rate = PERF_RATE,
+		.tb_size = 1000000,
+
+		.tc_rate = {PERF_RATE, PERF_RATE, PERF_RATE, PERF_RATE,
+			PERF_RATE, PERF_RATE, PERF_RATE, PERF_RATE,
+			PERF_RATE, PERF_RATE, PERF_RATE, PERF_RATE,
+			PERF_RATE, PERF_RATE, PERF_RATE, PERF_RATE},
+		.tc_period = 40,
+
+		.wrr_weights = {1, 1, 1, 1,  1, 1, 1, 1,  1, 1, 1, 1,  1, 1, 1, 1},
+	},
+};
+
+static struct {
+	const char *name;
+	uint8_t n_queues_per_tc[RTE_SCHED_TRAFFIC_CLASSES_MAX];
+} perf_layouts[] = {
+	{"4 TCs x 4 queues", {0}},
+	{"8 TCs x 1 queue + 1 TC x 4 queues",
+		{1, 1, 1, 1, 1, 1, 1, 1, 4}},
+	{"16 TCs x 1 queue",
+		{1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1}},
+};
+
+/* Tree path of each packet of the test traffic */
+static uint32_t perf_pipe[PERF_N_PATHS];
+static uint8_t perf_tc[PERF_N_PATHS];
+static uint8_t perf_queue[PERF_N_PATHS];
+
+static void
+perf_init_traffic(const uint8_t *n_queues_per_tc)
+{
+	uint32_t n_tcs, i;
+
+	for (n_tcs = 0; n_tcs < RTE_SCHED_TRAFFIC_CLASSES_MAX; n_tcs++)
+		if (n_queues_per_tc[n_tcs] == 0)
+			break;
+
+	for (i = 0; i < PERF_N_PATHS; i++) {
+		perf_pipe[i] = rte_rand() % PERF_N_PIPES;
+		if (n_tcs == 0) {
+			perf_tc[i] = rte_rand() %
+				RTE_SCHED_TRAFFIC_CLASSES_PER_PIPE;
+			perf_queue[i] = rte_rand() %
+				RTE_SCHED_QUEUES_PER_TRAFFIC_CLASS;
+		} else {
+			perf_tc[i] = rte_rand() % n_tcs;
+			perf_queue[i] = rte_rand() %
+				n_queues_per_tc[perf_tc[i]];
+		}
+	}
+}
+
+static inline void
+perf_pkt_write(struct rte_mbuf *pkt, uint32_t path)
+{
+	path &= PERF_N_PATHS - 1;
+	rte_sched_port_pkt_write(pkt, SUBPORT, perf_pipe[path],
+		perf_tc[path], perf_queue[path], e_RTE_METER_GREEN);
+}
+
+static int
+test_sched_perf_layout(struct rte_mempool *mp, uint32_t layout)
+{
+	struct rte_sched_port_params params = port_param;
+	struct rte_sched_port *port;
+	struct rte_mbuf *pkts[PERF_BURST];
+	uint64_t start, enq_cycles = 0, deq_cycles = 0, n_deq = 0;
+	uint32_t n_in_flight, path, pipe, i, j;
+	int n, err;
+
+	params.name = "sched_perf";
+	params.rate = PERF_RATE;
+	params.n_pipes_per_subport = PERF_N_PIPES;
+	params.pipe_profiles = pipe_profile_perf;
+	for (i = 0; i < RTE_SCHED_TRAFFIC_CLASSES_MAX; i++)
+		params.qsize[i] = 64;
+	memcpy(params.n_queues_per_tc, perf_layouts[layout].n_queues_per_tc,
+		sizeof(params.n_queues_per_tc));
+
+	port = rte_sched_port_config(&params);
+	TEST_ASSERT_NOT_NULL(port, "Error config sched port\n");
+
+	err = rte_sched_subport_config(port, SUBPORT, subport_param_perf);
+	TEST_ASSERT_SUCCESS(err, "Error config sched, err=%d\n", err);
+
+	for (pipe = 0; pipe < PERF_N_PIPES; pipe++) {
+		err = rte_sched_pipe_config(port, SUBPORT, pipe, 0);
+		TEST_ASSERT_SUCCESS(err, "Error config sched pipe %u, err=%d\n",
+			pipe, err);
+	}
+
+	perf_init_traffic(perf_layouts[layout].n_queues_per_tc);
+
+	/* Fill the port */
+	path = 0;
+	n_in_flight = 0;
+	for (i = 0; i < PERF_N_PKTS_QUEUED / PERF_BURST; i++) {
+		err = rte_pktmbuf_alloc_bulk(mp, pkts, PERF_BURST);
+		TEST_ASSERT_SUCCESS(err, "Packet allocation failed\n");
+		for (j = 0; j < PERF_BURST; j++) {
+			pkts[j]->pkt_len = 60;
+			pkts[j]->data_len = 60;
+			perf_pkt_write(pkts[j], path++);
+		}
+		n_in_flight += rte_sched_port_enqueue(port, pkts, PERF_BURST);
+	}
+
+	/* Each dequeued packet is sent back to another queue */
+	for (i = 0; i < PERF_N_BURSTS; i++) {
+		start = rte_rdtsc();
+		n = rte_sched_port_dequeue(port, pkts, PERF_BURST);
+		deq_cycles += rte_rdtsc() - start;
+		n_deq += n;
+
+		for (j = 0; j < (uint32_t) n; j++)
+			perf_pkt_write(pkts[j], path++);
+
+		start = rte_rdtsc();
+		n_in_flight -= n - rte_sched_port_enqueue(port, pkts, n);
+		enq_cycles += rte_rdtsc() - start;
+	}
+
+	/* Drain the port */
+	for (i = 0; n_in_flight != 0 && i < PERF_N_BURSTS; i++) {
+		n = rte_sched_port_dequeue(port, pkts, PERF_BURST);
+		for (j = 0; j < (uint32_t) n; j++)
+			rte_pktmbuf_free(pkts[j]);
+		n_in_flight -= n;
+	}
+
+	rte_sched_port_free(port);
+
+	TEST_ASSERT_EQUAL(n_in_flight, 0, "Packets left in the port\n");
+	TEST_ASSERT(n_deq != 0, "No packet dequeued\n");
+
+	printf("%-34s: %5.1f cycles/pkt enqueue, %5.1f cycles/pkt dequeue\n",
+		perf_layouts[layout].name, (double) enq_cycles / n_deq,
+		(double) deq_cycles / n_deq);
+
+	return 0;
+}
+
+/**
+ * enqueue and dequeue cost of the default and non default traffic class
+ * layouts, over many pipes so that their contexts are not cached
+ */
+static int
+test_sched_perf(void)
+{
+	struct rte_mempool *mp;
+	uint32_t i;
+
+	mp = rte_mempool_lookup("test_sched_perf");
+	if (!mp)
+		mp = rte_pktmbuf_pool_create("test_sched_perf", PERF_N_MBUFS,
+			MEMPOOL_CACHE_SZ, 0, MBUF_DATA_SZ, SOCKET);
+	TEST_ASSERT_NOT_NULL(mp, "Error creating mempool\n");
+
+	for (i = 0; i < RTE_DIM(perf_layouts); i++)
+		if (test_sched_perf_layout(mp, i) < 0)
+			return -1;
+
+	return 0;
+}
+
+static struct test_command sched_perf_cmd = {
+	.command = "sched_perf_autotest",
+	.callback = test_sched_perf,
+};
+REGISTER_TEST_COMMAND(sched_perf_cmd);
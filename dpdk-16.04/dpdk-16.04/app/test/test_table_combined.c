@@ -69,6 +69,7 @@ combined_table_test table_tests_combined[] = {
 	test_table_hash16ext,
 	test_table_hash32lru,
 	test_table_hash32ext,
+	test_table_hash_cuckoo_combined,
 };
 
 unsigned n_table_tests_combined = RTE_DIM(table_tests_combined);
@@ -786,3 +787,70 @@ test_table_hash32ext(void)
 
 	return 0;
 }
+
+int
+test_table_hash_cuckoo_combined(void)
+{
+	int status, i;
+
+	/* Traffic flow */
+	struct rte_table_hash_cuckoo_params cuckoo_params = {
+		.key_size = 32,
+		.n_keys = 1<<16,
+		.f_hash = pipeline_test_hash,
+		.seed = 0,
+		.key_offset = APP_METADATA_OFFSET(32),
+		.name = "CUCKOO_HASH",
+	};
+
+	uint8_t key_cuckoo[32];
+	uint32_t *kcuckoo = (uint32_t *) key_cuckoo;
+
+	memset(key_cuckoo, 0, sizeof(key_cuckoo));
+	kcuckoo[0] = 0xadadadad;
+
+	struct table_packets table_packets;
+
+	printf("--------------\n");
+	printf("RUNNING TEST - %s\n", __func__);
+	printf("--------------\n");
+	for (i = 0; i < 50; i++)
+		table_packets.hit_packet[i] = 0xadadadad;
+
+	for (i = 0; i < 50; i++)
+		table_packets.miss_packet[i] = 0xbdadadad;
+
+	table_packets.n_hit_packets = 50;
+	table_packets.n_miss_packets = 50;
+
+	status = test_table_type(&rte_table_hash_cuckoo_dosig_ops,
+		(void *)&cuckoo_params, (void *)key_cuckoo, &table_packets,
+		NULL, 0);
+	VERIFY(status, CHECK_TABLE_OK);
+
+	/* Invalid parameters */
+	cuckoo_params.key_size = 0;
+
+	status = test_table_type(&rte_table_hash_cuckoo_dosig_ops,
+		(void *)&cuckoo_params, (void *)key_cuckoo, &table_packets,
+		NULL, 0);
+	VERIFY(status, CHECK_TABLE_TABLE_CONFIG);
+
+	cuckoo_params.key_size = 32;
+	cuckoo_params.n_keys = 0;
+
+	status = test_table_type(&rte_table_hash_cuckoo_dosig_ops,
+		(void *)&cuckoo_params, (void *)key_cuckoo, &table_packets,
+		NULL, 0);
+	VERIFY(status, CHECK_TABLE_TABLE_CONFIG);
+
+	cuckoo_params.n_keys = 1<<16;
+	cuckoo_params.f_hash = NULL;
+
+	status = test_table_type(&rte_table_hash_cuckoo_dosig_ops,
+		(void *)&cuckoo_params, (void *)key_cuckoo, &table_packets,
+		NULL, 0);
+	VERIFY(status, CHECK_TABLE_TABLE_CONFIG);
+
+	return 0;
+}
@@ -47,6 +47,7 @@ int test_table_hash16ext(void);
 int test_table_hash32unoptimized(void);
 int test_table_hash32lru(void);
 int test_table_hash32ext(void);
+int test_table_hash_cuckoo_combined(void);
 
 /* Extern variables */
 typedef int (*combined_table_test)(void);
@@ -33,6 +33,9 @@
 
 #include <string.h>
 #include <rte_pipeline.h>
+#include <rte_pipeline_group.h>
+#include <rte_launch.h>
+#include <rte_cycles.h>
 #include <rte_log.h>
 #include <inttypes.h>
 #include <rte_hexdump.h>
@@ -527,6 +530,561 @@ fail:
 
 }
 
+struct entry_stats_test_entry {
+	struct rte_pipeline_table_entry head;
+	uint64_t data;
+};
+
+static int
+entry_stats_test_enqueue(uint32_t key, uint32_t len)
+{
+	struct rte_mbuf *m;
+	uint32_t *k32;
+
+	m = rte_pktmbuf_alloc(pool);
+	if (m == NULL)
+		return -1;
+
+	if (rte_pktmbuf_append(m, len) == NULL) {
+		rte_pktmbuf_free(m);
+		return -1;
+	}
+
+	k32 = (uint32_t *) RTE_MBUF_METADATA_UINT8_PTR(m,
+		APP_METADATA_OFFSET(32));
+	k32[0] = key;
+	k32[1] = 0;
+
+	return rte_ring_enqueue(rings_rx[0], m);
+}
+
+static int
+test_pipeline_entry_stats(void)
+{
+	struct rte_pipeline_params pipeline_params = {
+		.name = "PIPELINE_ENTRY_STATS",
+		.socket_id = 0,
+	};
+	struct rte_port_ring_reader_params port_ring_reader_params = {
+		.ring = rings_rx[0],
+	};
+	struct rte_pipeline_port_in_params port_in_params = {
+		.ops = &rte_port_ring_reader_ops,
+		.arg_create = (void *) &port_ring_reader_params,
+		.f_action = NULL,
+		.burst_size = RTE_PORT_IN_BURST_SIZE_MAX,
+	};
+	struct rte_port_ring_writer_params port_ring_writer_params = {
+		.ring = rings_tx[0],
+		.tx_burst_sz = BURST_SIZE,
+	};
+	struct rte_pipeline_port_out_params port_out_params = {
+		.ops = &rte_port_ring_writer_ops,
+		.arg_create = (void *) &port_ring_writer_params,
+		.f_action = NULL,
+		.arg_ah = NULL,
+	};
+	struct rte_table_hash_key8_ext_params hash_params = {
+		.n_entries = 1 << 10,
+		.n_entries_ext = 1 << 4,
+		.f_hash = pipeline_test_hash,
+		.seed = 0,
+		.signature_offset = APP_METADATA_OFFSET(0),
+		.key_offset = APP_METADATA_OFFSET(32),
+		.key_mask = NULL,
+	};
+	struct rte_pipeline_table_params table_params = {
+		.ops = &rte_table_hash_key8_ext_dosig_ops,
+		.arg_create = &hash_params,
+		.f_action_hit = NULL,
+		.f_action_miss = NULL,
+		.arg_ah = NULL,
+		.action_data_size = sizeof(uint64_t),
+		.entry_stats_en = 1,
+	};
+	/* Keys of the input packets: 0xA and 0xB hit, 0xC misses */
+	static const uint32_t pkt_keys[] = {
+		0xA, 0xA, 0xA, 0xB, 0xB, 0xA, 0xC, 0xC};
+	static const uint32_t pkt_lens[] = {
+		64, 128, 256, 64, 512, 1024, 100, 200};
+	struct entry_stats_test_entry entry, entry_out;
+	struct rte_pipeline_table_entry *entries[3];
+	struct rte_pipeline_table_entry_stats stats[3];
+	struct rte_pipeline_table_entry *default_entry_ptr;
+	uint32_t port_in, port_out, table, key[2], i;
+	void *objs[RING_TX_SIZE];
+	int key_found, n;
+
+	p = rte_pipeline_create(&pipeline_params);
+	if (p == NULL)
+		return -1;
+
+	if (rte_pipeline_port_in_create(p, &port_in_params, &port_in) ||
+		rte_pipeline_port_out_create(p, &port_out_params, &port_out) ||
+		rte_pipeline_table_create(p, &table_params, &table) ||
+		rte_pipeline_port_in_connect_to_table(p, port_in, table) ||
+		rte_pipeline_port_in_enable(p, port_in))
+		goto fail;
+
+	/* Entries */
+	memset(&entry, 0, sizeof(entry));
+	entry.head.action = RTE_PIPELINE_ACTION_DROP;
+	if (rte_pipeline_table_default_entry_add(p, table, &entry.head,
+		&default_entry_ptr))
+		goto fail;
+	entries[2] = default_entry_ptr;
+
+	entry.head.action = RTE_PIPELINE_ACTION_PORT;
+	entry.head.port_id = port_out;
+	for (i = 0; i < 2; i++) {
+		key[0] = 0xA + i;
+		key[1] = 0;
+		entry.data = 0xA + i;
+		if (rte_pipeline_table_entry_add(p, table, key, &entry.head,
+			&key_found, &entries[i]))
+			goto fail;
+	}
+
+	/* Traffic */
+	for (i = 0; i < RTE_DIM(pkt_keys); i++)
+		if (entry_stats_test_enqueue(pkt_keys[i], pkt_lens[i]))
+			goto fail;
+
+	rte_pipeline_run(p);
+	rte_pipeline_flush(p);
+
+	n = rte_ring_sc_dequeue_burst(rings_tx[0], objs, RING_TX_SIZE);
+	for (i = 0; i < (uint32_t) n; i++)
+		rte_pktmbuf_free((struct rte_mbuf *) objs[i]);
+	if (n != 6)
+		goto fail;
+
+	/* Read */
+	if (rte_pipeline_table_entry_stats_read(p, table, entries, 3, stats,
+		0))
+		goto fail;
+
+	if ((stats[0].n_pkts != 4) ||
+		(stats[0].n_bytes != 64 + 128 + 256 + 1024) ||
+		(stats[1].n_pkts != 2) ||
+		(stats[1].n_bytes != 64 + 512) ||
+		(stats[2].n_pkts != 2) ||
+		(stats[2].n_bytes != 100 + 200))
+		goto fail;
+
+	/* The action data is not changed by the counters */
+	if ((((struct entry_stats_test_entry *) entries[0])->data != 0xA) ||
+		(((struct entry_stats_test_entry *) entries[1])->data != 0xB))
+		goto fail;
+
+	/* Clear */
+	if (rte_pipeline_table_entry_stats_read(p, table, entries, 3, NULL,
+		1))
+		goto fail;
+
+	if (rte_pipeline_table_entry_stats_read(p, table, entries, 3, stats,
+		0))
+		goto fail;
+
+	for (i = 0; i < 3; i++)
+		if ((stats[i].n_pkts != 0) || (stats[i].n_bytes != 0))
+			goto fail;
+
+	/* Delete, only the user part of the entry is copied out */
+	key[0] = 0xB;
+	memset(&entry_out, 0, sizeof(entry_out));
+	if (rte_pipeline_table_entry_delete(p, table, key, &key_found,
+		&entry_out.head) || (key_found == 0) || (entry_out.data != 0xB))
+		goto fail;
+
+	/* No entry stats on a table created without them */
+	table_params.entry_stats_en = 0;
+	if (rte_pipeline_table_create(p, &table_params, &table))
+		goto fail;
+
+	if (rte_pipeline_table_entry_stats_read(p, table, entries, 1, stats,
+		0) == 0)
+		goto fail;
+
+	cleanup_pipeline();
+	return 0;
+
+fail:
+	cleanup_pipeline();
+	return -1;
+}
+
+static int
+test_pipeline_run_spec(void)
+{
+	struct rte_pipeline_params pipeline_params = {
+		.name = "PIPELINE_RUN_SPEC",
+		.socket_id = 0,
+	};
+	struct rte_port_ring_reader_params port_ring_reader_params = {
+		.ring = rings_rx[0],
+	};
+	struct rte_pipeline_port_in_params port_in_params = {
+		.ops = &rte_port_ring_reader_ops,
+		.arg_create = (void *) &port_ring_reader_params,
+		.f_action = NULL,
+		.burst_size = RTE_PORT_IN_BURST_SIZE_MAX,
+	};
+	struct rte_port_ring_writer_params port_ring_writer_params = {
+		.tx_burst_sz = BURST_SIZE,
+	};
+	struct rte_pipeline_port_out_params port_out_params = {
+		.ops = &rte_port_ring_writer_ops,
+		.arg_create = (void *) &port_ring_writer_params,
+		.f_action = NULL,
+		.arg_ah = NULL,
+	};
+	struct rte_table_hash_key8_ext_params hash_params = {
+		.n_entries = 1 << 10,
+		.n_entries_ext = 1 << 4,
+		.f_hash = pipeline_test_hash,
+		.seed = 0,
+		.signature_offset = APP_METADATA_OFFSET(0),
+		.key_offset = APP_METADATA_OFFSET(32),
+		.key_mask = NULL,
+	};
+	struct rte_pipeline_table_params table_params = {
+		.ops = &rte_table_hash_key8_ext_dosig_ops,
+		.arg_create = &hash_params,
+		.f_action_hit = NULL,
+		.f_action_miss = NULL,
+		.arg_ah = NULL,
+		.action_data_size = 0,
+	};
+	/* Keys of the input packets: 0xA goes to output port 0, 0xB to
+	output port 1, 0xD is dropped on hit and 0xC on miss */
+	static const uint32_t pkt_keys[] = {
+		0xA, 0xA, 0xB, 0xA, 0xD, 0xC, 0xB, 0xA};
+	static const uint32_t port_keys[][2] = {{0xA, 0}, {0xB, 1}};
+	struct rte_pipeline_table_entry entry, *entry_ptr;
+	uint32_t port_in, port_out[2], table, key[2], i;
+	void *objs[RING_TX_SIZE];
+	int key_found, n[2];
+
+	p = rte_pipeline_create(&pipeline_params);
+	if (p == NULL)
+		return -1;
+
+	if (rte_pipeline_run_spec_set(p, RTE_PIPELINE_RUN_SPEC_ALL + 1) == 0)
+		goto fail;
+
+	if (rte_pipeline_run_spec_set(p, 0))
+		goto fail;
+
+	/* Features out of the spec */
+	table_params.f_action_hit =
+		(rte_pipeline_table_action_handler_hit) table_action_stub_hit;
+	if (rte_pipeline_table_create(p, &table_params, &table) == 0)
+		goto fail;
+	table_params.f_action_hit = NULL;
+
+	table_params.entry_stats_en = 1;
+	if (rte_pipeline_table_create(p, &table_params, &table) == 0)
+		goto fail;
+	table_params.entry_stats_en = 0;
+
+	/* Ports and table */
+	if (rte_pipeline_port_in_create(p, &port_in_params, &port_in))
+		goto fail;
+
+	for (i = 0; i < 2; i++) {
+		port_ring_writer_params.ring = rings_tx[i];
+		if (rte_pipeline_port_out_create(p, &port_out_params,
+			&port_out[i]))
+			goto fail;
+	}
+
+	if (rte_pipeline_table_create(p, &table_params, &table) ||
+		rte_pipeline_port_in_connect_to_table(p, port_in, table) ||
+		rte_pipeline_port_in_enable(p, port_in))
+		goto fail;
+
+	/* The spec cannot be changed once the pipeline has ports */
+	if (rte_pipeline_run_spec_set(p, RTE_PIPELINE_RUN_SPEC_ALL) == 0)
+		goto fail;
+
+	/* Entries */
+	memset(&entry, 0, sizeof(entry));
+	entry.action = RTE_PIPELINE_ACTION_TABLE;
+	entry.table_id = table;
+	if (rte_pipeline_table_default_entry_add(p, table, &entry,
+		&entry_ptr) == 0)
+		goto fail;
+
+	entry.action = RTE_PIPELINE_ACTION_DROP;
+	if (rte_pipeline_table_default_entry_add(p, table, &entry,
+		&entry_ptr))
+		goto fail;
+
+	key[0] = 0xD;
+	key[1] = 0;
+	if (rte_pipeline_table_entry_add(p, table, key, &entry, &key_found,
+		&entry_ptr))
+		goto fail;
+
+	entry.action = RTE_PIPELINE_ACTION_PORT_META;
+	if (rte_pipeline_table_entry_add(p, table, key, &entry, &key_found,
+		&entry_ptr) == 0)
+		goto fail;
+
+	entry.action = RTE_PIPELINE_ACTION_PORT;
+	for (i = 0; i < 2; i++) {
+		key[0] = port_keys[i][0];
+		entry.port_id = port_out[port_keys[i][1]];
+		if (rte_pipeline_table_entry_add(p, table, key, &entry,
+			&key_found, &entry_ptr))
+			goto fail;
+	}
+
+	if (rte_pipeline_check(p))
+		goto fail;
+
+	/* Traffic */
+	for (i = 0; i < RTE_DIM(pkt_keys); i++)
+		if (entry_stats_test_enqueue(pkt_keys[i], 64))
+			goto fail;
+
+	rte_pipeline_run(p);
+	rte_pipeline_flush(p);
+
+	/* Each output port gets its packets in order */
+	for (i = 0; i < 2; i++) {
+		int j;
+
+		n[i] = rte_ring_sc_dequeue_burst(rings_tx[i], objs,
+			RING_TX_SIZE);
+		for (j = 0; j < n[i]; j++) {
+			struct rte_mbuf *m = (struct rte_mbuf *) objs[j];
+
+			if (RTE_MBUF_METADATA_UINT32(m,
+				APP_METADATA_OFFSET(32)) != port_keys[i][0])
+				n[i] = -1;
+			rte_pktmbuf_free(m);
+		}
+	}
+
+	if ((n[0] != 4) || (n[1] != 2))
+		goto fail;
+
+	cleanup_pipeline();
+	return 0;
+
+fail:
+	cleanup_pipeline();
+	return -1;
+}
+
+static volatile int group_shard_quit;
+
+static int
+group_shard_main(void *arg)
+{
+	struct rte_pipeline_group *g = arg;
+	struct rte_pipeline *shard = rte_pipeline_group_shard(g, 1);
+
+	while (group_shard_quit == 0) {
+		rte_pipeline_group_run(g, 1);
+		rte_pipeline_flush(shard);
+	}
+
+	return rte_pipeline_group_stop(g, 1);
+}
+
+static int
+group_send(uint32_t shard_id, uint32_t key)
+{
+	struct rte_mbuf *m;
+	uint32_t *k32;
+
+	m = rte_pktmbuf_alloc(pool);
+	if (m == NULL)
+		return -1;
+
+	k32 = (uint32_t *) RTE_MBUF_METADATA_UINT8_PTR(m,
+		APP_METADATA_OFFSET(32));
+	k32[0] = key;
+	k32[1] = 0;
+
+	return rte_ring_enqueue(rings_rx[shard_id], m);
+}
+
+/* Wait for the packets sent by a shard, for up to 100 ms when it runs on
+ * another lcore */
+static int
+group_receive(uint32_t shard_id, int wait)
+{
+	void *objs[RING_TX_SIZE];
+	uint64_t timeout = rte_get_timer_cycles() + rte_get_timer_hz() / 10;
+	int n, i;
+
+	do {
+		n = rte_ring_sc_dequeue_burst(rings_tx[shard_id], objs,
+			RING_TX_SIZE);
+	} while (wait && (n == 0) && (rte_get_timer_cycles() < timeout));
+
+	for (i = 0; i < n; i++)
+		rte_pktmbuf_free((struct rte_mbuf *) objs[i]);
+
+	return n;
+}
+
+static int
+test_pipeline_group(int shared)
+{
+	struct rte_pipeline_group_params group_params = {
+		.name = "PIPELINE_GROUP",
+		.socket_id = 0,
+		.offset_port_id = 0,
+		.n_shards = N_PORTS,
+	};
+	struct rte_port_ring_reader_params port_in_ring_params[N_PORTS];
+	struct rte_port_ring_writer_params port_out_ring_params[N_PORTS];
+	void *port_in_args[N_PORTS], *port_out_args[N_PORTS];
+	struct rte_pipeline_port_in_params port_in_params = {
+		.ops = &rte_port_ring_reader_ops,
+		.f_action = NULL,
+		.burst_size = BURST_SIZE,
+	};
+	struct rte_pipeline_port_out_params port_out_params = {
+		.ops = &rte_port_ring_writer_ops,
+		.f_action = NULL,
+		.arg_ah = NULL,
+	};
+	struct rte_table_hash_key8_ext_params hash_params = {
+		.n_entries = 1 << 10,
+		.n_entries_ext = 1 << 4,
+		.f_hash = pipeline_test_hash,
+		.seed = 0,
+		.signature_offset = APP_METADATA_OFFSET(0),
+		.key_offset = APP_METADATA_OFFSET(32),
+		.key_mask = NULL,
+	};
+	struct rte_pipeline_table_params table_params = {
+		.ops = &rte_table_hash_key8_ext_dosig_ops,
+		.arg_create = &hash_params,
+		.f_action_hit = NULL,
+		.f_action_miss = NULL,
+		.arg_ah = NULL,
+		.action_data_size = 0,
+	};
+	struct rte_pipeline_table_entry entry, *entry_ptr[N_PORTS];
+	struct rte_pipeline_group *g;
+	uint32_t port_in, port_out, table, key[2], i;
+	unsigned lcore_id;
+	int key_found;
+
+	RTE_LOG(INFO, PIPELINE, "%s: **** Running %s table test\n",
+		__func__, shared ? "shared" : "replicated");
+
+	g = rte_pipeline_group_create(&group_params);
+	if (g == NULL)
+		return -1;
+
+	/* One input and one output ring per shard */
+	for (i = 0; i < N_PORTS; i++) {
+		port_in_ring_params[i].ring = rings_rx[i];
+		port_in_args[i] = &port_in_ring_params[i];
+		port_out_ring_params[i].ring = rings_tx[i];
+		port_out_ring_params[i].tx_burst_sz = BURST_SIZE;
+		port_out_args[i] = &port_out_ring_params[i];
+	}
+
+	if (rte_pipeline_group_port_in_create(g, &port_in_params,
+			port_in_args, &port_in) ||
+		rte_pipeline_group_port_out_create(g, &port_out_params,
+			port_out_args, &port_out) ||
+		rte_pipeline_group_table_create(g, &table_params, shared,
+			&table) ||
+		rte_pipeline_group_port_in_connect_to_table(g, port_in,
+			table) ||
+		rte_pipeline_group_port_in_enable(g, port_in) ||
+		rte_pipeline_group_check(g))
+		goto fail;
+
+	/* Lookup miss drops, key 0xA goes to the output port */
+	entry.action = RTE_PIPELINE_ACTION_DROP;
+	if (rte_pipeline_group_table_default_entry_add(g, table, &entry,
+		entry_ptr))
+		goto fail;
+
+	entry.action = RTE_PIPELINE_ACTION_PORT;
+	entry.port_id = port_out;
+	key[0] = 0xA;
+	key[1] = 0;
+	if (rte_pipeline_group_table_entry_add(g, table, key, &entry,
+		&key_found, entry_ptr) || key_found)
+		goto fail;
+
+	if (shared && (entry_ptr[0] != entry_ptr[1]))
+		goto fail;
+	if ((shared == 0) && (entry_ptr[0] == entry_ptr[1]))
+		goto fail;
+
+	/* Run all the shards from this lcore */
+	for (i = 0; i < N_PORTS; i++) {
+		if (group_send(i, 0xA) || group_send(i, 0xC))
+			goto fail;
+
+		rte_pipeline_group_run(g, i);
+		rte_pipeline_group_stop(g, i);
+
+		if (group_receive(i, 0) != 1)
+			goto fail;
+	}
+
+	/* Update the table while shard 1 runs on another lcore */
+	lcore_id = rte_get_next_lcore(-1, 1, 0);
+	if (lcore_id < RTE_MAX_LCORE) {
+		group_shard_quit = 0;
+		rte_eal_remote_launch(group_shard_main, g, lcore_id);
+
+		key[0] = 0xB;
+		if (rte_pipeline_group_table_entry_add(g, table, key, &entry,
+			&key_found, entry_ptr) || key_found)
+			goto fail_wait;
+
+		if (group_send(1, 0xB) || (group_receive(1, 1) != 1))
+			goto fail_wait;
+
+		key[0] = 0xA;
+		if (rte_pipeline_group_table_entry_delete(g, table, key,
+			&key_found, NULL) || (key_found == 0))
+			goto fail_wait;
+
+		if (group_send(1, 0xA) || group_send(1, 0xB) ||
+			(group_receive(1, 1) != 1))
+			goto fail_wait;
+
+		group_shard_quit = 1;
+		if (rte_eal_wait_lcore(lcore_id) != 0)
+			goto fail;
+	}
+
+	/* A table that cannot be created in all the shards is in none */
+	if (rte_pipeline_table_create(rte_pipeline_group_shard(g, N_PORTS - 1),
+			&table_params, &i) ||
+		(rte_pipeline_group_table_create(g, &table_params, shared,
+			&i) == 0) ||
+		rte_pipeline_table_create(rte_pipeline_group_shard(g, 0),
+			&table_params, &i) || (i != table + 1))
+		goto fail;
+
+	rte_pipeline_group_free(g);
+	return 0;
+
+fail_wait:
+	group_shard_quit = 1;
+	rte_eal_wait_lcore(lcore_id);
+fail:
+	rte_pipeline_group_free(g);
+	return -1;
+}
+
 int
 test_table_pipeline(void)
 {
@@ -596,5 +1154,23 @@ test_table_pipeline(void)
 		return -1;
 	}
 
+	if (test_pipeline_entry_stats()) {
+		RTE_LOG(INFO, PIPELINE, "%s: Pipeline table entry stats test "
+			"failed.\n", __func__);
+		return -1;
+	}
+
+	if (test_pipeline_run_spec()) {
+		RTE_LOG(INFO, PIPELINE, "%s: Pipeline run spec test failed.\n",
+			__func__);
+		return -1;
+	}
+
+	if (test_pipeline_group(0) || test_pipeline_group(1)) {
+		RTE_LOG(INFO, PIPELINE, "%s: Pipeline group test failed.\n",
+			__func__);
+		return -1;
+	}
+
 	return 0;
 }
@@ -31,12 +31,16 @@
  *   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <rte_cycles.h>
+
 #include "test_table_ports.h"
 #include "test_table.h"
 
 port_test port_tests[] = {
 	test_port_ring_reader,
 	test_port_ring_writer,
+	test_port_ring_writer_zc,
+	test_port_ring_writer_perf,
 };
 
 unsigned n_port_tests = RTE_DIM(port_tests);
@@ -218,3 +222,239 @@ test_port_ring_writer(void)
 
 	return 0;
 }
+
+int
+test_port_ring_writer_zc(void)
+{
+	struct rte_port_ring_writer_zc_nodrop_params params;
+	struct rte_mbuf *mbuf[RTE_PORT_IN_BURST_SIZE_MAX];
+	struct rte_mbuf *res_mbuf[RTE_PORT_IN_BURST_SIZE_MAX];
+	struct rte_ring *ring_mp, *ring_small;
+	int status, received_pkts, i;
+	void *port;
+
+	/* Invalid params */
+	port = rte_port_ring_writer_zc_ops.f_create(NULL, 0);
+	if (port != NULL)
+		return -1;
+
+	status = rte_port_ring_writer_zc_ops.f_free(port);
+	if (status >= 0)
+		return -2;
+
+	params.ring = NULL;
+	params.tx_burst_sz = RTE_PORT_IN_BURST_SIZE_MAX;
+	params.n_retries = 0;
+	port = rte_port_ring_writer_zc_ops.f_create(&params, 0);
+	if (port != NULL)
+		return -3;
+
+	params.ring = RING_TX;
+	params.tx_burst_sz = RTE_PORT_IN_BURST_SIZE_MAX + 1;
+	port = rte_port_ring_writer_zc_ops.f_create(&params, 0);
+	if (port != NULL)
+		return -4;
+
+	/* Multi producer ring */
+	ring_mp = rte_ring_lookup("TEST_PORT_RING_MP");
+	if (ring_mp == NULL)
+		ring_mp = rte_ring_create("TEST_PORT_RING_MP", 16, 0, 0);
+	if (ring_mp == NULL)
+		return -5;
+
+	params.ring = ring_mp;
+	params.tx_burst_sz = 8;
+	port = rte_port_ring_writer_zc_ops.f_create(&params, 0);
+	if (port != NULL)
+		return -6;
+
+	/* Create and free */
+	params.ring = RING_TX;
+	params.tx_burst_sz = 8;
+	port = rte_port_ring_writer_zc_ops.f_create(&params, 0);
+	if (port == NULL)
+		return -7;
+
+	status = rte_port_ring_writer_zc_ops.f_free(port);
+	if (status != 0)
+		return -8;
+
+	/* -- Traffic TX -- */
+	port = rte_port_ring_writer_zc_ops.f_create(&params, 0);
+	if (port == NULL)
+		return -9;
+
+	/* Single packet, only visible after flush */
+	mbuf[0] = rte_pktmbuf_alloc(pool);
+	rte_port_ring_writer_zc_ops.f_tx(port, mbuf[0]);
+	if (rte_ring_count(RING_TX) != 0)
+		return -10;
+
+	rte_port_ring_writer_zc_ops.f_flush(port);
+	received_pkts = rte_ring_sc_dequeue_burst(RING_TX,
+		(void **)res_mbuf, RTE_PORT_IN_BURST_SIZE_MAX);
+	if ((received_pkts != 1) || (res_mbuf[0] != mbuf[0]))
+		return -11;
+
+	rte_pktmbuf_free(res_mbuf[0]);
+
+	/* Multiple packets, visible once a burst is complete */
+	for (i = 0; i < 12; i++) {
+		mbuf[i] = rte_pktmbuf_alloc(pool);
+		rte_port_ring_writer_zc_ops.f_tx(port, mbuf[i]);
+	}
+
+	if (rte_ring_count(RING_TX) != 8)
+		return -12;
+
+	rte_port_ring_writer_zc_ops.f_flush(port);
+	received_pkts = rte_ring_sc_dequeue_burst(RING_TX,
+		(void **)res_mbuf, RTE_PORT_IN_BURST_SIZE_MAX);
+	if (received_pkts != 12)
+		return -13;
+
+	for (i = 0; i < 12; i++) {
+		if (res_mbuf[i] != mbuf[i])
+			return -14;
+		rte_pktmbuf_free(res_mbuf[i]);
+	}
+
+	/* TX bulk, in order, with holes in the packet mask */
+	for (i = 0; i < RTE_PORT_IN_BURST_SIZE_MAX; i++)
+		mbuf[i] = rte_pktmbuf_alloc(pool);
+	rte_port_ring_writer_zc_ops.f_tx_bulk(port, mbuf, (uint64_t)-3);
+	rte_port_ring_writer_zc_ops.f_tx_bulk(port, mbuf, (uint64_t)2);
+	rte_port_ring_writer_zc_ops.f_flush(port);
+
+	received_pkts = rte_ring_sc_dequeue_burst(RING_TX,
+		(void **)res_mbuf, RTE_PORT_IN_BURST_SIZE_MAX);
+	if (received_pkts != RTE_PORT_IN_BURST_SIZE_MAX)
+		return -15;
+
+	for (i = 0; i < RTE_PORT_IN_BURST_SIZE_MAX; i++) {
+		struct rte_mbuf *expected = (i == 0) ? mbuf[0] :
+			(i == RTE_PORT_IN_BURST_SIZE_MAX - 1) ? mbuf[1] :
+			mbuf[i + 1];
+
+		if (res_mbuf[i] != expected)
+			return -16;
+		rte_pktmbuf_free(res_mbuf[i]);
+	}
+
+	rte_port_ring_writer_zc_ops.f_free(port);
+
+	/* Ring full: the packets that do not fit are dropped */
+	ring_small = rte_ring_lookup("TEST_PORT_RING_SMALL");
+	if (ring_small == NULL)
+		ring_small = rte_ring_create("TEST_PORT_RING_SMALL", 16, 0,
+			RING_F_SP_ENQ | RING_F_SC_DEQ);
+	if (ring_small == NULL)
+		return -17;
+
+	for (i = 0; i < 2; i++) {
+		struct rte_port_out_ops *ops = (i == 0) ?
+			&rte_port_ring_writer_zc_ops :
+			&rte_port_ring_writer_zc_nodrop_ops;
+		int j;
+
+		params.ring = ring_small;
+		params.tx_burst_sz = 8;
+		params.n_retries = 4;
+		port = ops->f_create(&params, 0);
+		if (port == NULL)
+			return -18;
+
+		for (j = 0; j < 32; j++)
+			mbuf[j] = rte_pktmbuf_alloc(pool);
+		ops->f_tx_bulk(port, mbuf, RTE_LEN2MASK(32, uint64_t));
+		ops->f_free(port);
+
+		received_pkts = rte_ring_sc_dequeue_burst(ring_small,
+			(void **)res_mbuf, RTE_PORT_IN_BURST_SIZE_MAX);
+		if (received_pkts != 15)
+			return -19;
+
+		for (j = 0; j < received_pkts; j++) {
+			if (res_mbuf[j] != mbuf[j])
+				return -20;
+			rte_pktmbuf_free(res_mbuf[j]);
+		}
+	}
+
+	return 0;
+}
+
+#define PORT_PERF_N_PKTS                                   (1 << 20)
+#define PORT_PERF_BURST_SIZE                               32
+
+/*
+ * Cycles per packet of a ring output port fed one packet at a time, as done
+ * by the pipeline for the packets hitting a table, with the ring drained by
+ * the same core in bursts.
+ */
+static int
+test_port_ring_writer_perf_run(const char *name, struct rte_port_out_ops *ops)
+{
+	struct rte_port_ring_writer_nodrop_params params = {
+		.ring = RING_TX,
+		.tx_burst_sz = PORT_PERF_BURST_SIZE,
+		.n_retries = 0,
+	};
+	struct rte_mbuf *mbuf[PORT_PERF_BURST_SIZE];
+	void *res[PORT_PERF_BURST_SIZE];
+	uint64_t cycles = 0;
+	uint32_t i, j, n_pkts = 0;
+	void *port;
+
+	port = ops->f_create(&params, 0);
+	if (port == NULL)
+		return -1;
+
+	for (i = 0; i < PORT_PERF_BURST_SIZE; i++) {
+		mbuf[i] = rte_pktmbuf_alloc(pool);
+		if (mbuf[i] == NULL)
+			return -2;
+	}
+
+	for (i = 0; i < PORT_PERF_N_PKTS / PORT_PERF_BURST_SIZE; i++) {
+		uint64_t start = rte_rdtsc();
+
+		for (j = 0; j < PORT_PERF_BURST_SIZE; j++)
+			ops->f_tx(port, mbuf[j]);
+
+		cycles += rte_rdtsc() - start;
+
+		n_pkts += rte_ring_sc_dequeue_burst(RING_TX, res,
+			PORT_PERF_BURST_SIZE);
+	}
+
+	ops->f_free(port);
+	for (i = 0; i < PORT_PERF_BURST_SIZE; i++)
+		rte_pktmbuf_free(mbuf[i]);
+
+	if (n_pkts != PORT_PERF_N_PKTS)
+		return -3;
+
+	printf("  %-24s %.1f cycles/pkt\n", name,
+		(double) cycles / PORT_PERF_N_PKTS);
+	return 0;
+}
+
+int
+test_port_ring_writer_perf(void)
+{
+	printf("Ring output ports, %u packets, burst size %u:\n",
+		PORT_PERF_N_PKTS, PORT_PERF_BURST_SIZE);
+
+	if (test_port_ring_writer_perf_run("ring_writer",
+			&rte_port_ring_writer_ops) ||
+		test_port_ring_writer_perf_run("ring_writer_nodrop",
+			&rte_port_ring_writer_nodrop_ops) ||
+		test_port_ring_writer_perf_run("ring_writer_zc",
+			&rte_port_ring_writer_zc_ops) ||
+		test_port_ring_writer_perf_run("ring_writer_zc_nodrop",
+			&rte_port_ring_writer_zc_nodrop_ops))
+		return -1;
+
+	return 0;
+}
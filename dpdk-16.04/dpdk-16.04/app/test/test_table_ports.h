@@ -34,6 +34,8 @@
 /* Test prototypes */
 int test_port_ring_reader(void);
 int test_port_ring_writer(void);
+int test_port_ring_writer_zc(void);
+int test_port_ring_writer_perf(void);
 
 /* Extern variables */
 typedef int (*port_test)(void);
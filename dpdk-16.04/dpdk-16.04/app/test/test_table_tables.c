@@ -46,6 +46,7 @@ table_test table_tests[] = {
 	test_table_lpm_ipv6,
 	test_table_hash_lru,
 	test_table_hash_ext,
+	test_table_hash_cuckoo,
 };
 
 #define PREPARE_PACKET(mbuf, value) do {				\
@@ -942,3 +943,181 @@ test_table_hash_ext(void)
 
 	return 0;
 }
+
+int
+test_table_hash_cuckoo(void)
+{
+	int status, i;
+	uint64_t expected_mask = 0, result_mask;
+	struct rte_mbuf *mbufs[RTE_PORT_IN_BURST_SIZE_MAX];
+	void *table;
+	char *entries[RTE_PORT_IN_BURST_SIZE_MAX];
+	char entry;
+	void *entry_ptr;
+	int key_found;
+	uint32_t entry_size = 1;
+
+	/* Initialize params and create tables, with a 48-byte key */
+	struct rte_table_hash_cuckoo_params cuckoo_params = {
+		.key_size = 48,
+		.n_keys = 1 << 16,
+		.f_hash = pipeline_test_hash,
+		.seed = 0,
+		.key_offset = APP_METADATA_OFFSET(32),
+		.name = "CUCKOO",
+	};
+
+	table = rte_table_hash_cuckoo_dosig_ops.f_create(NULL, 0, entry_size);
+	if (table != NULL)
+		return -1;
+
+	cuckoo_params.key_size = 0;
+
+	table = rte_table_hash_cuckoo_dosig_ops.f_create(&cuckoo_params,
+		0, entry_size);
+	if (table != NULL)
+		return -2;
+
+	cuckoo_params.key_size = 48;
+	cuckoo_params.n_keys = 0;
+
+	table = rte_table_hash_cuckoo_dosig_ops.f_create(&cuckoo_params,
+		0, entry_size);
+	if (table != NULL)
+		return -3;
+
+	cuckoo_params.n_keys = 1 << 16;
+	cuckoo_params.f_hash = NULL;
+
+	table = rte_table_hash_cuckoo_dosig_ops.f_create(&cuckoo_params,
+		0, entry_size);
+	if (table != NULL)
+		return -4;
+
+	cuckoo_params.f_hash = pipeline_test_hash;
+	cuckoo_params.name = NULL;
+
+	table = rte_table_hash_cuckoo_dosig_ops.f_create(&cuckoo_params,
+		0, entry_size);
+	if (table != NULL)
+		return -5;
+
+	cuckoo_params.name = "CUCKOO";
+
+	table = rte_table_hash_cuckoo_dosig_ops.f_create(&cuckoo_params,
+		0, entry_size);
+	if (table == NULL)
+		return -6;
+
+	/* Free */
+	status = rte_table_hash_cuckoo_dosig_ops.f_free(table);
+	if (status < 0)
+		return -7;
+
+	status = rte_table_hash_cuckoo_dosig_ops.f_free(NULL);
+	if (status == 0)
+		return -8;
+
+	/* Add */
+	uint8_t key_cuckoo[48];
+	uint32_t *kcuckoo = (uint32_t *) &key_cuckoo;
+
+	memset(key_cuckoo, 0, 48);
+	kcuckoo[0] = rte_be_to_cpu_32(0xadadadad);
+
+	table = rte_table_hash_cuckoo_dosig_ops.f_create(&cuckoo_params,
+		0, entry_size);
+	if (table == NULL)
+		return -9;
+
+	entry = 'A';
+	status = rte_table_hash_cuckoo_dosig_ops.f_add(NULL, &key_cuckoo,
+		&entry, &key_found, &entry_ptr);
+	if (status == 0)
+		return -10;
+
+	status = rte_table_hash_cuckoo_dosig_ops.f_add(table, NULL, &entry,
+		&key_found, &entry_ptr);
+	if (status == 0)
+		return -11;
+
+	status = rte_table_hash_cuckoo_dosig_ops.f_add(table, &key_cuckoo,
+		NULL, &key_found, &entry_ptr);
+	if (status == 0)
+		return -12;
+
+	status = rte_table_hash_cuckoo_dosig_ops.f_add(table, &key_cuckoo,
+		&entry, &key_found, &entry_ptr);
+	if ((status != 0) || (key_found != 0) || (*(char *) entry_ptr != 'A'))
+		return -13;
+
+	entry = 'B';
+	status = rte_table_hash_cuckoo_dosig_ops.f_add(table, &key_cuckoo,
+		&entry, &key_found, &entry_ptr);
+	if ((status != 0) || (key_found != 1) || (*(char *) entry_ptr != 'B'))
+		return -14;
+
+	/* Delete */
+	status = rte_table_hash_cuckoo_dosig_ops.f_delete(NULL, &key_cuckoo,
+		&key_found, NULL);
+	if (status == 0)
+		return -15;
+
+	status = rte_table_hash_cuckoo_dosig_ops.f_delete(table, NULL,
+		&key_found, NULL);
+	if (status == 0)
+		return -16;
+
+	status = rte_table_hash_cuckoo_dosig_ops.f_delete(table, &key_cuckoo,
+		&key_found, &entry);
+	if ((status != 0) || (key_found != 1) || (entry != 'B'))
+		return -17;
+
+	status = rte_table_hash_cuckoo_dosig_ops.f_delete(table, &key_cuckoo,
+		&key_found, NULL);
+	if ((status != 0) || (key_found != 0))
+		return -18;
+
+	/* Traffic flow */
+	entry = 'A';
+	status = rte_table_hash_cuckoo_dosig_ops.f_add(table, &key_cuckoo,
+		&entry, &key_found, &entry_ptr);
+	if (status < 0)
+		return -19;
+
+	for (i = 0; i < RTE_PORT_IN_BURST_SIZE_MAX; i++) {
+		if (i % 2 == 0) {
+			expected_mask |= (uint64_t)1 << i;
+			PREPARE_PACKET(mbufs[i], 0xadadadad);
+		} else
+			PREPARE_PACKET(mbufs[i], 0xadadadab);
+
+		/* Key bytes beyond the 32 bytes set by PREPARE_PACKET */
+		memset(RTE_MBUF_METADATA_UINT8_PTR(mbufs[i],
+			APP_METADATA_OFFSET(64)), 0, 16);
+	}
+
+	rte_table_hash_cuckoo_dosig_ops.f_lookup(table, mbufs, -1,
+		&result_mask, (void **)entries);
+	if (result_mask != expected_mask)
+		return -20;
+
+	for (i = 0; i < RTE_PORT_IN_BURST_SIZE_MAX; i += 2)
+		if (*entries[i] != 'A')
+			return -21;
+
+	/* Partial burst */
+	expected_mask = 0x5;
+	rte_table_hash_cuckoo_dosig_ops.f_lookup(table, mbufs, 0xf,
+		&result_mask, (void **)entries);
+	if (result_mask != expected_mask)
+		return -22;
+
+	/* Free resources */
+	for (i = 0; i < RTE_PORT_IN_BURST_SIZE_MAX; i++)
+		rte_pktmbuf_free(mbufs[i]);
+
+	status = rte_table_hash_cuckoo_dosig_ops.f_free(table);
+
+	return 0;
+}
@@ -41,6 +41,7 @@ int test_table_acl(void);
 int test_table_hash_unoptimized(void);
 int test_table_hash_lru(void);
 int test_table_hash_ext(void);
+int test_table_hash_cuckoo(void);
 int test_table_stub(void);
 
 /* Extern variables */
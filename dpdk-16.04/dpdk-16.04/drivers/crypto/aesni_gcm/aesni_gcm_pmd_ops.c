@@ -318,6 +318,15 @@ aesni_gcm_pmd_session_clear(struct rte_cryptodev *dev __rte_unused, void *sess)
 		memset(sess, 0, sizeof(struct aesni_gcm_session));
 }
 
+/** Copy a session, its expanded keys being plain data */
+static int
+aesni_gcm_pmd_session_copy(struct rte_cryptodev *dev __rte_unused, void *dst,
+		const void *src)
+{
+	memcpy(dst, src, sizeof(struct aesni_gcm_session));
+	return 0;
+}
+
 struct rte_cryptodev_ops aesni_gcm_pmd_ops = {
 		.dev_configure		= aesni_gcm_pmd_config,
 		.dev_start		= aesni_gcm_pmd_start,
@@ -337,7 +346,8 @@ struct rte_cryptodev_ops aesni_gcm_pmd_ops = {
 
 		.session_get_size	= aesni_gcm_pmd_session_get_size,
 		.session_configure	= aesni_gcm_pmd_session_configure,
-		.session_clear		= aesni_gcm_pmd_session_clear
+		.session_clear		= aesni_gcm_pmd_session_clear,
+		.session_copy		= aesni_gcm_pmd_session_copy
 };
 
 struct rte_cryptodev_ops *rte_aesni_gcm_pmd_ops = &aesni_gcm_pmd_ops;
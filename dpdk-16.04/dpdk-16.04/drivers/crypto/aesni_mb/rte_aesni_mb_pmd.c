@@ -318,7 +318,9 @@ get_session(struct aesni_mb_qp *qp, struct rte_crypto_op *op)
 				sess, op->sym->xform) != 0)) {
 			rte_mempool_put(qp->sess_mp, _sess);
 			sess = NULL;
-		}
+		} else
+			/* Returned to the mempool once the op is processed */
+			op->sym->session = _sess;
 	}
 
 	return sess;
@@ -448,6 +448,15 @@ aesni_mb_pmd_session_clear(struct rte_cryptodev *dev __rte_unused, void *sess)
 		memset(sess, 0, sizeof(struct aesni_mb_session));
 }
 
+/** Copy a session, its expanded keys being plain data */
+static int
+aesni_mb_pmd_session_copy(struct rte_cryptodev *dev __rte_unused, void *dst,
+		const void *src)
+{
+	memcpy(dst, src, sizeof(struct aesni_mb_session));
+	return 0;
+}
+
 struct rte_cryptodev_ops aesni_mb_pmd_ops = {
 		.dev_configure		= aesni_mb_pmd_config,
 		.dev_start		= aesni_mb_pmd_start,
@@ -467,7 +476,8 @@ struct rte_cryptodev_ops aesni_mb_pmd_ops = {
 
 		.session_get_size	= aesni_mb_pmd_session_get_size,
 		.session_configure	= aesni_mb_pmd_session_configure,
-		.session_clear		= aesni_mb_pmd_session_clear
+		.session_clear		= aesni_mb_pmd_session_clear,
+		.session_copy		= aesni_mb_pmd_session_copy
 };
 
 struct rte_cryptodev_ops *rte_aesni_mb_pmd_ops = &aesni_mb_pmd_ops;
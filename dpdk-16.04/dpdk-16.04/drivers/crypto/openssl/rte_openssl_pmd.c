@@ -0,0 +1,799 @@
+/*-
+ *   BSD LICENSE
+ *
+ *   Copyright(c) 2016 Intel Corporation. All rights reserved.
+ *
+ *   Redistribution and use in source and binary forms, with or without
+ *   modification, are permitted provided that the following conditions
+ *   are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ *     * Neither the name of Intel Corporation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *   OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <string.h>
+
+#include <rte_common.h>
+#include <rte_config.h>
+#include <rte_cryptodev.h>
+#include <rte_cryptodev_pmd.h>
+#include <rte_dev.h>
+#include <rte_malloc.h>
+#include <rte_cpuflags.h>
+
+#include "rte_openssl_pmd_private.h"
+
+/** IV length of the AES CBC and CTR modes */
+#define OPENSSL_AES_IV_LENGTH	16
+
+/**
+ * Global static parameter used to create a unique name for each OpenSSL
+ * crypto device.
+ */
+static unsigned unique_name_id;
+
+static inline int
+create_unique_device_name(char *name, size_t size)
+{
+	int ret;
+
+	if (name == NULL)
+		return -EINVAL;
+
+	ret = snprintf(name, size, "%s_%u", CRYPTODEV_NAME_OPENSSL_PMD,
+			unique_name_id++);
+	if (ret < 0)
+		return ret;
+	return 0;
+}
+
+/*
+ *------------------------------------------------------------------------------
+ * Session Prepare
+ *------------------------------------------------------------------------------
+ */
+
+/** Get xform chain order */
+static enum openssl_chain_order
+openssl_get_chain_order(const struct rte_crypto_sym_xform *xform)
+{
+	if (xform == NULL)
+		return OPENSSL_CHAIN_NOT_SUPPORTED;
+
+	if (xform->next == NULL) {
+		if (xform->type == RTE_CRYPTO_SYM_XFORM_CIPHER &&
+				xform->cipher.algo != RTE_CRYPTO_CIPHER_AES_GCM)
+			return OPENSSL_CHAIN_ONLY_CIPHER;
+		if (xform->type == RTE_CRYPTO_SYM_XFORM_AUTH &&
+				xform->auth.algo != RTE_CRYPTO_AUTH_AES_GCM)
+			return OPENSSL_CHAIN_ONLY_AUTH;
+		return OPENSSL_CHAIN_NOT_SUPPORTED;
+	}
+
+	if (xform->next->next != NULL)
+		return OPENSSL_CHAIN_NOT_SUPPORTED;
+
+	if (xform->type == RTE_CRYPTO_SYM_XFORM_CIPHER &&
+			xform->next->type == RTE_CRYPTO_SYM_XFORM_AUTH) {
+		if (xform->cipher.algo == RTE_CRYPTO_CIPHER_AES_GCM)
+			return OPENSSL_CHAIN_COMBINED;
+		return OPENSSL_CHAIN_CIPHER_AUTH;
+	}
+
+	if (xform->type == RTE_CRYPTO_SYM_XFORM_AUTH &&
+			xform->next->type == RTE_CRYPTO_SYM_XFORM_CIPHER) {
+		if (xform->auth.algo == RTE_CRYPTO_AUTH_AES_GCM)
+			return OPENSSL_CHAIN_COMBINED;
+		return OPENSSL_CHAIN_AUTH_CIPHER;
+	}
+
+	return OPENSSL_CHAIN_NOT_SUPPORTED;
+}
+
+/** Get the OpenSSL cipher of an algorithm and key length */
+static const EVP_CIPHER *
+openssl_get_cipher(enum rte_crypto_cipher_algorithm algo, size_t key_length)
+{
+	switch (algo) {
+	case RTE_CRYPTO_CIPHER_AES_CBC:
+		switch (key_length) {
+		case 16:
+			return EVP_aes_128_cbc();
+		case 24:
+			return EVP_aes_192_cbc();
+		case 32:
+			return EVP_aes_256_cbc();
+		}
+		break;
+	case RTE_CRYPTO_CIPHER_AES_CTR:
+		switch (key_length) {
+		case 16:
+			return EVP_aes_128_ctr();
+		case 24:
+			return EVP_aes_192_ctr();
+		case 32:
+			return EVP_aes_256_ctr();
+		}
+		break;
+	case RTE_CRYPTO_CIPHER_AES_GCM:
+		switch (key_length) {
+		case 16:
+			return EVP_aes_128_gcm();
+		case 24:
+			return EVP_aes_192_gcm();
+		case 32:
+			return EVP_aes_256_gcm();
+		}
+		break;
+	default:
+		break;
+	}
+
+	return NULL;
+}
+
+/** Set session cipher parameters */
+static int
+openssl_set_session_cipher_parameters(struct openssl_session *sess,
+		const struct rte_crypto_sym_xform *xform)
+{
+	const EVP_CIPHER *cipher;
+
+	/* Select cipher direction */
+	switch (xform->cipher.op) {
+	case RTE_CRYPTO_CIPHER_OP_ENCRYPT:
+		sess->cipher.encrypt = 1;
+		break;
+	case RTE_CRYPTO_CIPHER_OP_DECRYPT:
+		sess->cipher.encrypt = 0;
+		break;
+	default:
+		OPENSSL_LOG_ERR("Unsupported cipher operation parameter");
+		return -EINVAL;
+	}
+
+	cipher = openssl_get_cipher(xform->cipher.algo,
+			xform->cipher.key.length);
+	if (cipher == NULL) {
+		OPENSSL_LOG_ERR("Unsupported cipher algorithm or key length");
+		return -EINVAL;
+	}
+	sess->cipher.algo = xform->cipher.algo;
+
+	/* Expand the key once, the operations only set their IV */
+	sess->cipher.ctx = EVP_CIPHER_CTX_new();
+	if (sess->cipher.ctx == NULL)
+		return -ENOMEM;
+
+	if (EVP_CipherInit_ex(sess->cipher.ctx, cipher, NULL,
+			xform->cipher.key.data, NULL,
+			sess->cipher.encrypt) != 1) {
+		OPENSSL_LOG_ERR("Failed to set the cipher key");
+		return -EINVAL;
+	}
+
+	/* The data to cipher is a whole number of blocks, never padded */
+	EVP_CIPHER_CTX_set_padding(sess->cipher.ctx, 0);
+
+	return 0;
+}
+
+/** Set session authentication parameters */
+static int
+openssl_set_session_auth_parameters(struct openssl_session *sess,
+		const struct rte_crypto_sym_xform *xform)
+{
+	const EVP_MD *md;
+
+	switch (xform->auth.algo) {
+	case RTE_CRYPTO_AUTH_SHA1_HMAC:
+		md = EVP_sha1();
+		break;
+	case RTE_CRYPTO_AUTH_SHA256_HMAC:
+		md = EVP_sha256();
+		break;
+	case RTE_CRYPTO_AUTH_SHA512_HMAC:
+		md = EVP_sha512();
+		break;
+	default:
+		OPENSSL_LOG_ERR("Unsupported authentication algorithm");
+		return -EINVAL;
+	}
+
+	if (xform->auth.digest_length == 0 ||
+			xform->auth.digest_length > (unsigned)EVP_MD_size(md)) {
+		OPENSSL_LOG_ERR("Invalid digest length %u",
+				xform->auth.digest_length);
+		return -EINVAL;
+	}
+
+	sess->auth.algo = xform->auth.algo;
+	sess->auth.operation = xform->auth.op;
+	sess->auth.digest_length = xform->auth.digest_length;
+
+	/* Hash the HMAC key pads once, the operations copy the context */
+	sess->auth.pkey = EVP_PKEY_new_mac_key(EVP_PKEY_HMAC, NULL,
+			xform->auth.key.data, (int)xform->auth.key.length);
+	sess->auth.ctx = EVP_MD_CTX_new();
+	if (sess->auth.pkey == NULL || sess->auth.ctx == NULL)
+		return -ENOMEM;
+
+	if (EVP_DigestSignInit(sess->auth.ctx, NULL, md, NULL,
+			sess->auth.pkey) != 1) {
+		OPENSSL_LOG_ERR("Failed to set the HMAC key");
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+/** Set session authenticated encryption parameters, AES GCM */
+static int
+openssl_set_session_aead_parameters(struct openssl_session *sess,
+		const struct rte_crypto_sym_xform *xform)
+{
+	const struct rte_crypto_sym_xform *cipher_xform, *auth_xform;
+	int ret;
+
+	if (xform->type == RTE_CRYPTO_SYM_XFORM_CIPHER) {
+		cipher_xform = xform;
+		auth_xform = xform->next;
+	} else {
+		auth_xform = xform;
+		cipher_xform = xform->next;
+	}
+
+	if (cipher_xform->cipher.algo != RTE_CRYPTO_CIPHER_AES_GCM ||
+			auth_xform->auth.algo != RTE_CRYPTO_AUTH_AES_GCM) {
+		OPENSSL_LOG_ERR("Both xforms of a GCM chain must be AES GCM");
+		return -EINVAL;
+	}
+
+	ret = openssl_set_session_cipher_parameters(sess, cipher_xform);
+	if (ret != 0)
+		return ret;
+
+	/* Authenticated encryption or authenticated decryption only */
+	if (sess->cipher.encrypt != (xform == cipher_xform)) {
+		OPENSSL_LOG_ERR("xform chain and cipher operation are an "
+				"invalid selection");
+		return -EINVAL;
+	}
+
+	if (auth_xform->auth.digest_length == 0 ||
+			auth_xform->auth.digest_length > 16) {
+		OPENSSL_LOG_ERR("Invalid digest length %u",
+				auth_xform->auth.digest_length);
+		return -EINVAL;
+	}
+
+	sess->auth.algo = RTE_CRYPTO_AUTH_AES_GCM;
+	sess->auth.operation = sess->cipher.encrypt ?
+			RTE_CRYPTO_AUTH_OP_GENERATE : RTE_CRYPTO_AUTH_OP_VERIFY;
+	sess->auth.digest_length = auth_xform->auth.digest_length;
+
+	return 0;
+}
+
+/** Parse crypto xform chain and set private session parameters */
+int
+openssl_set_session_parameters(struct openssl_session *sess,
+		const struct rte_crypto_sym_xform *xform)
+{
+	int ret = 0;
+
+	memset(sess, 0, sizeof(*sess));
+
+	sess->chain_order = openssl_get_chain_order(xform);
+	switch (sess->chain_order) {
+	case OPENSSL_CHAIN_ONLY_CIPHER:
+		ret = openssl_set_session_cipher_parameters(sess, xform);
+		break;
+	case OPENSSL_CHAIN_ONLY_AUTH:
+		ret = openssl_set_session_auth_parameters(sess, xform);
+		break;
+	case OPENSSL_CHAIN_CIPHER_AUTH:
+		ret = openssl_set_session_cipher_parameters(sess, xform);
+		if (ret == 0)
+			ret = openssl_set_session_auth_parameters(sess,
+					xform->next);
+		break;
+	case OPENSSL_CHAIN_AUTH_CIPHER:
+		ret = openssl_set_session_auth_parameters(sess, xform);
+		if (ret == 0)
+			ret = openssl_set_session_cipher_parameters(sess,
+					xform->next);
+		break;
+	case OPENSSL_CHAIN_COMBINED:
+		ret = openssl_set_session_aead_parameters(sess, xform);
+		break;
+	default:
+		OPENSSL_LOG_ERR("Unsupported operation chain order parameter");
+		return -EINVAL;
+	}
+
+	if (ret != 0)
+		openssl_reset_session(sess);
+
+	return ret;
+}
+
+/** Copy a session, duplicating its contexts instead of setting their keys */
+int
+openssl_copy_session(struct openssl_session *dst,
+		const struct openssl_session *src)
+{
+	memcpy(dst, src, sizeof(*dst));
+
+	/* The HMAC context holds its own reference to the key */
+	dst->auth.pkey = NULL;
+	dst->cipher.ctx = NULL;
+	dst->auth.ctx = NULL;
+
+	if (src->cipher.ctx != NULL) {
+		dst->cipher.ctx = EVP_CIPHER_CTX_new();
+		if (dst->cipher.ctx == NULL ||
+				EVP_CIPHER_CTX_copy(dst->cipher.ctx,
+					src->cipher.ctx) != 1)
+			goto error;
+	}
+
+	if (src->auth.ctx != NULL) {
+		dst->auth.ctx = EVP_MD_CTX_new();
+		if (dst->auth.ctx == NULL ||
+				EVP_MD_CTX_copy_ex(dst->auth.ctx,
+					src->auth.ctx) != 1)
+			goto error;
+	}
+
+	return 0;
+
+error:
+	openssl_reset_session(dst);
+	return -ENOMEM;
+}
+
+/** Free the OpenSSL contexts of a session and clear its key material */
+void
+openssl_reset_session(struct openssl_session *sess)
+{
+	EVP_CIPHER_CTX_free(sess->cipher.ctx);
+	EVP_MD_CTX_free(sess->auth.ctx);
+	EVP_PKEY_free(sess->auth.pkey);
+
+	memset(sess, 0, sizeof(*sess));
+}
+
+/** Get the session of an operation, set up if session-less */
+static struct openssl_session *
+openssl_get_session(struct openssl_qp *qp, struct rte_crypto_op *op)
+{
+	struct openssl_session *sess = NULL;
+
+	if (op->sym->sess_type == RTE_CRYPTO_SYM_OP_WITH_SESSION) {
+		if (unlikely(op->sym->session == NULL ||
+				op->sym->session->dev_type !=
+				RTE_CRYPTODEV_OPENSSL_PMD))
+			return NULL;
+
+		sess = (struct openssl_session *)op->sym->session->_private;
+	} else {
+		void *_sess;
+
+		if (rte_mempool_get(qp->sess_mp, &_sess))
+			return NULL;
+
+		sess = (struct openssl_session *)
+			((struct rte_cryptodev_sym_session *)_sess)->_private;
+
+		if (unlikely(openssl_set_session_parameters(sess,
+				op->sym->xform) != 0)) {
+			rte_mempool_put(qp->sess_mp, _sess);
+			return NULL;
+		}
+		op->sym->session = _sess;
+	}
+
+	return sess;
+}
+
+/*
+ *------------------------------------------------------------------------------
+ * Process Operations
+ *------------------------------------------------------------------------------
+ */
+
+/** Check the data of an operation is in the first segment of a mbuf */
+static inline int
+openssl_check_data(const struct rte_mbuf *m, uint32_t offset,
+		uint32_t length)
+{
+	if ((uint64_t)offset + length > rte_pktmbuf_data_len(m))
+		return -1;
+	return 0;
+}
+
+/** Cipher the data of an operation, AES CBC or CTR */
+static int
+process_openssl_cipher_op(struct openssl_qp *qp, struct rte_crypto_op *op)
+{
+	struct rte_crypto_sym_op *sym = op->sym;
+	struct rte_mbuf *m_dst = sym->m_dst ? sym->m_dst : sym->m_src;
+	uint32_t offset = sym->cipher.data.offset;
+	uint32_t length = sym->cipher.data.length;
+	uint8_t *src, *dst;
+	int len = 0, final_len;
+
+	if (openssl_check_data(sym->m_src, offset, length) != 0 ||
+			openssl_check_data(m_dst, offset, length) != 0 ||
+			sym->cipher.iv.length != OPENSSL_AES_IV_LENGTH) {
+		op->status = RTE_CRYPTO_OP_STATUS_INVALID_ARGS;
+		return -1;
+	}
+
+	src = rte_pktmbuf_mtod_offset(sym->m_src, uint8_t *, offset);
+	dst = rte_pktmbuf_mtod_offset(m_dst, uint8_t *, offset);
+
+	if (EVP_CipherInit_ex(qp->cipher_ctx, NULL, NULL, NULL,
+			sym->cipher.iv.data, -1) != 1 ||
+			EVP_CipherUpdate(qp->cipher_ctx, dst, &len, src,
+				length) != 1 ||
+			EVP_CipherFinal_ex(qp->cipher_ctx, dst + len,
+				&final_len) != 1) {
+		op->status = RTE_CRYPTO_OP_STATUS_ERROR;
+		return -1;
+	}
+
+	return 0;
+}
+
+/** Generate or verify the HMAC digest of an operation on a mbuf */
+static int
+process_openssl_auth_op(struct openssl_qp *qp, struct rte_crypto_op *op,
+		struct openssl_session *sess, struct rte_mbuf *m)
+{
+	struct rte_crypto_sym_op *sym = op->sym;
+	uint8_t digest[EVP_MAX_MD_SIZE];
+	size_t digest_length = sizeof(digest);
+	uint8_t *src;
+
+	if (openssl_check_data(m, sym->auth.data.offset,
+			sym->auth.data.length) != 0 ||
+			sym->auth.digest.data == NULL) {
+		op->status = RTE_CRYPTO_OP_STATUS_INVALID_ARGS;
+		return -1;
+	}
+
+	src = rte_pktmbuf_mtod_offset(m, uint8_t *, sym->auth.data.offset);
+
+	if (EVP_MD_CTX_copy_ex(qp->auth_ctx, sess->auth.ctx) != 1 ||
+			EVP_DigestSignUpdate(qp->auth_ctx, src,
+				sym->auth.data.length) != 1 ||
+			EVP_DigestSignFinal(qp->auth_ctx, digest,
+				&digest_length) != 1) {
+		op->status = RTE_CRYPTO_OP_STATUS_ERROR;
+		return -1;
+	}
+
+	if (sess->auth.operation == RTE_CRYPTO_AUTH_OP_VERIFY) {
+		if (memcmp(digest, sym->auth.digest.data,
+				sess->auth.digest_length) != 0) {
+			op->status = RTE_CRYPTO_OP_STATUS_AUTH_FAILED;
+			return -1;
+		}
+	} else
+		memcpy(sym->auth.digest.data, digest,
+				sess->auth.digest_length);
+
+	return 0;
+}
+
+/** Authenticated encryption or decryption of an operation, AES GCM */
+static int
+process_openssl_combined_op(struct openssl_qp *qp, struct rte_crypto_op *op,
+		struct openssl_session *sess)
+{
+	struct rte_crypto_sym_op *sym = op->sym;
+	struct rte_mbuf *m_dst = sym->m_dst ? sym->m_dst : sym->m_src;
+	uint32_t offset = sym->cipher.data.offset;
+	uint32_t length = sym->cipher.data.length;
+	uint8_t *src, *dst;
+	int len = 0, final_len;
+
+	/* A 16 bytes IV is the J0 block, the IV followed by the counter 1 */
+	if (openssl_check_data(sym->m_src, offset, length) != 0 ||
+			openssl_check_data(m_dst, offset, length) != 0 ||
+			(sym->cipher.iv.length != OPENSSL_GCM_IV_LENGTH &&
+			sym->cipher.iv.length != OPENSSL_AES_IV_LENGTH) ||
+			sym->auth.digest.data == NULL) {
+		op->status = RTE_CRYPTO_OP_STATUS_INVALID_ARGS;
+		return -1;
+	}
+
+	src = rte_pktmbuf_mtod_offset(sym->m_src, uint8_t *, offset);
+	dst = rte_pktmbuf_mtod_offset(m_dst, uint8_t *, offset);
+
+	if (EVP_CipherInit_ex(qp->cipher_ctx, NULL, NULL, NULL,
+			sym->cipher.iv.data, -1) != 1)
+		goto error;
+
+	if (sym->auth.aad.length > 0 &&
+			EVP_CipherUpdate(qp->cipher_ctx, NULL, &len,
+				sym->auth.aad.data,
+				sym->auth.aad.length) != 1)
+		goto error;
+
+	len = 0;
+	if (length > 0 && EVP_CipherUpdate(qp->cipher_ctx, dst, &len, src,
+			length) != 1)
+		goto error;
+
+	if (!sess->cipher.encrypt) {
+		if (EVP_CIPHER_CTX_ctrl(qp->cipher_ctx, EVP_CTRL_GCM_SET_TAG,
+				sess->auth.digest_length,
+				sym->auth.digest.data) != 1)
+			goto error;
+
+		if (EVP_CipherFinal_ex(qp->cipher_ctx, dst + len,
+				&final_len) != 1) {
+			op->status = RTE_CRYPTO_OP_STATUS_AUTH_FAILED;
+			return -1;
+		}
+	} else if (EVP_CipherFinal_ex(qp->cipher_ctx, dst + len,
+				&final_len) != 1 ||
+			EVP_CIPHER_CTX_ctrl(qp->cipher_ctx,
+				EVP_CTRL_GCM_GET_TAG,
+				sess->auth.digest_length,
+				sym->auth.digest.data) != 1)
+		goto error;
+
+	return 0;
+
+error:
+	op->status = RTE_CRYPTO_OP_STATUS_ERROR;
+	return -1;
+}
+
+/**
+ * Process a crypto operation, the queue pair cipher context being loaded
+ * with the cipher key of its session
+ */
+static void
+process_openssl_crypto_op(struct openssl_qp *qp, struct rte_crypto_op *op,
+		struct openssl_session *sess)
+{
+	struct rte_mbuf *m_dst =
+			op->sym->m_dst ? op->sym->m_dst : op->sym->m_src;
+
+	op->status = RTE_CRYPTO_OP_STATUS_SUCCESS;
+
+	switch (sess->chain_order) {
+	case OPENSSL_CHAIN_ONLY_CIPHER:
+		process_openssl_cipher_op(qp, op);
+		break;
+	case OPENSSL_CHAIN_ONLY_AUTH:
+		process_openssl_auth_op(qp, op, sess, op->sym->m_src);
+		break;
+	case OPENSSL_CHAIN_CIPHER_AUTH:
+		/* The digest is computed on the output of the cipher */
+		if (process_openssl_cipher_op(qp, op) == 0)
+			process_openssl_auth_op(qp, op, sess, m_dst);
+		break;
+	case OPENSSL_CHAIN_AUTH_CIPHER:
+		if (process_openssl_auth_op(qp, op, sess, op->sym->m_src) == 0)
+			process_openssl_cipher_op(qp, op);
+		break;
+	case OPENSSL_CHAIN_COMBINED:
+		process_openssl_combined_op(qp, op, sess);
+		break;
+	default:
+		op->status = RTE_CRYPTO_OP_STATUS_ERROR;
+		break;
+	}
+}
+
+/** Load the cipher context of a session in a queue pair */
+static inline int
+openssl_qp_load_session(struct openssl_qp *qp, struct openssl_session *sess)
+{
+	if (sess->cipher.ctx == NULL)
+		return 0;
+
+	if (EVP_CIPHER_CTX_copy(qp->cipher_ctx, sess->cipher.ctx) != 1)
+		return -1;
+
+	return 0;
+}
+
+/*
+ *------------------------------------------------------------------------------
+ * PMD Framework
+ *------------------------------------------------------------------------------
+ */
+
+/** Enqueue burst */
+static uint16_t
+openssl_pmd_enqueue_burst(void *queue_pair, struct rte_crypto_op **ops,
+		uint16_t nb_ops)
+{
+	struct openssl_qp *qp = queue_pair;
+	struct openssl_session *sess, *cur_sess = NULL;
+	unsigned nb_free;
+	uint16_t i;
+
+	/* Do not process operations the processed ring has no room for */
+	nb_free = rte_ring_free_count(qp->processed_ops);
+	if (nb_ops > nb_free)
+		nb_ops = nb_free;
+
+	for (i = 0; i < nb_ops; i++) {
+		struct rte_crypto_op *op = ops[i];
+
+		sess = openssl_get_session(qp, op);
+		if (unlikely(sess == NULL)) {
+			op->status = RTE_CRYPTO_OP_STATUS_INVALID_ARGS;
+			qp->qp_stats.enqueue_err_count++;
+			break;
+		}
+
+		/*
+		 * The consecutive operations of a session are processed with
+		 * the cipher context loaded for the first one, so the cost of
+		 * setting up the context is paid once per run of operations
+		 * instead of once per operation.
+		 */
+		if (sess != cur_sess &&
+				openssl_qp_load_session(qp, sess) != 0) {
+			op->status = RTE_CRYPTO_OP_STATUS_ERROR;
+			cur_sess = NULL;
+		} else {
+			cur_sess = sess;
+			process_openssl_crypto_op(qp, op, sess);
+		}
+
+		/* Free session if a session-less crypto op */
+		if (op->sym->sess_type == RTE_CRYPTO_SYM_OP_SESSIONLESS) {
+			openssl_reset_session(sess);
+			rte_mempool_put(qp->sess_mp, op->sym->session);
+			op->sym->session = NULL;
+			cur_sess = NULL;
+		}
+	}
+
+	rte_ring_enqueue_burst(qp->processed_ops, (void **)ops, i);
+	qp->qp_stats.enqueued_count += i;
+
+	return i;
+}
+
+/** Dequeue burst */
+static uint16_t
+openssl_pmd_dequeue_burst(void *queue_pair, struct rte_crypto_op **ops,
+		uint16_t nb_ops)
+{
+	struct openssl_qp *qp = queue_pair;
+	unsigned nb_dequeued;
+
+	nb_dequeued = rte_ring_dequeue_burst(qp->processed_ops,
+			(void **)ops, nb_ops);
+	qp->qp_stats.dequeued_count += nb_dequeued;
+
+	return nb_dequeued;
+}
+
+static int cryptodev_openssl_uninit(const char *name);
+
+/** Create OpenSSL crypto device */
+static int
+cryptodev_openssl_create(const char *name,
+		struct rte_crypto_vdev_init_params *init_params)
+{
+	struct rte_cryptodev *dev;
+	char crypto_dev_name[RTE_CRYPTODEV_NAME_MAX_LEN];
+	struct openssl_private *internals;
+
+	/* create a unique device name */
+	if (create_unique_device_name(crypto_dev_name,
+			RTE_CRYPTODEV_NAME_MAX_LEN) != 0) {
+		OPENSSL_LOG_ERR("failed to create unique cryptodev name");
+		return -EINVAL;
+	}
+
+	dev = rte_cryptodev_pmd_virtual_dev_init(crypto_dev_name,
+			sizeof(struct openssl_private),
+			init_params->socket_id);
+	if (dev == NULL) {
+		OPENSSL_LOG_ERR("failed to create cryptodev vdev");
+		goto init_error;
+	}
+
+	dev->dev_type = RTE_CRYPTODEV_OPENSSL_PMD;
+	dev->dev_ops = rte_openssl_pmd_ops;
+
+	/* register rx/tx burst functions for data path */
+	dev->dequeue_burst = openssl_pmd_dequeue_burst;
+	dev->enqueue_burst = openssl_pmd_enqueue_burst;
+
+	dev->feature_flags = RTE_CRYPTODEV_FF_SYMMETRIC_CRYPTO |
+			RTE_CRYPTODEV_FF_SYM_OPERATION_CHAINING;
+
+	/* OpenSSL uses the AES instructions when the CPU has them */
+	if (rte_cpu_get_flag_enabled(RTE_CPUFLAG_AES))
+		dev->feature_flags |= RTE_CRYPTODEV_FF_CPU_AESNI;
+
+	internals = dev->data->dev_private;
+
+	internals->max_nb_queue_pairs = init_params->max_nb_queue_pairs;
+	internals->max_nb_sessions = init_params->max_nb_sessions;
+
+	return 0;
+
+init_error:
+	OPENSSL_LOG_ERR("driver %s: create failed", name);
+
+	cryptodev_openssl_uninit(crypto_dev_name);
+	return -EFAULT;
+}
+
+/** Initialise OpenSSL crypto device */
+static int
+cryptodev_openssl_init(const char *name, const char *input_args)
+{
+	struct rte_crypto_vdev_init_params init_params = {
+		RTE_CRYPTODEV_VDEV_DEFAULT_MAX_NB_QUEUE_PAIRS,
+		RTE_CRYPTODEV_VDEV_DEFAULT_MAX_NB_SESSIONS,
+		rte_socket_id()
+	};
+
+	rte_cryptodev_parse_vdev_init_params(&init_params, input_args);
+
+	RTE_LOG(INFO, PMD, "Initialising %s on NUMA node %d\n", name,
+			init_params.socket_id);
+	RTE_LOG(INFO, PMD, "  Max number of queue pairs = %d\n",
+			init_params.max_nb_queue_pairs);
+	RTE_LOG(INFO, PMD, "  Max number of sessions = %d\n",
+			init_params.max_nb_sessions);
+
+	return cryptodev_openssl_create(name, &init_params);
+}
+
+/** Uninitialise OpenSSL crypto device */
+static int
+cryptodev_openssl_uninit(const char *name)
+{
+	if (name == NULL)
+		return -EINVAL;
+
+	OPENSSL_LOG_INFO("Closing OpenSSL crypto device %s on numa socket %u",
+			name, rte_socket_id());
+
+	return 0;
+}
+
+static struct rte_driver cryptodev_openssl_pmd_drv = {
+	.name = CRYPTODEV_NAME_OPENSSL_PMD,
+	.type = PMD_VDEV,
+	.init = cryptodev_openssl_init,
+	.uninit = cryptodev_openssl_uninit
+};
+
+PMD_REGISTER_DRIVER(cryptodev_openssl_pmd_drv);
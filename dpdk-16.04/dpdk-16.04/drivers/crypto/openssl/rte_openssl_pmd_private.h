@@ -0,0 +1,169 @@
+/*-
+ *   BSD LICENSE
+ *
+ *   Copyright(c) 2016 Intel Corporation. All rights reserved.
+ *
+ *   Redistribution and use in source and binary forms, with or without
+ *   modification, are permitted provided that the following conditions
+ *   are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ *     * Neither the name of Intel Corporation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *   OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _RTE_OPENSSL_PMD_PRIVATE_H_
+#define _RTE_OPENSSL_PMD_PRIVATE_H_
+
+#include <openssl/evp.h>
+
+#define OPENSSL_LOG_ERR(fmt, args...) \
+	RTE_LOG(ERR, CRYPTODEV, "[%s] %s() line %u: " fmt "\n",  \
+			CRYPTODEV_NAME_OPENSSL_PMD, \
+			__func__, __LINE__, ## args)
+
+#ifdef RTE_LIBRTE_PMD_OPENSSL_DEBUG
+#define OPENSSL_LOG_INFO(fmt, args...) \
+	RTE_LOG(INFO, CRYPTODEV, "[%s] %s() line %u: " fmt "\n", \
+			CRYPTODEV_NAME_OPENSSL_PMD, \
+			__func__, __LINE__, ## args)
+
+#define OPENSSL_LOG_DBG(fmt, args...) \
+	RTE_LOG(DEBUG, CRYPTODEV, "[%s] %s() line %u: " fmt "\n", \
+			CRYPTODEV_NAME_OPENSSL_PMD, \
+			__func__, __LINE__, ## args)
+#else
+#define OPENSSL_LOG_INFO(fmt, args...)
+#define OPENSSL_LOG_DBG(fmt, args...)
+#endif
+
+/* EVP_MD_CTX_create() and EVP_MD_CTX_destroy() were renamed in 1.1.0 */
+#if OPENSSL_VERSION_NUMBER < 0x10100000L
+#define EVP_MD_CTX_new		EVP_MD_CTX_create
+#define EVP_MD_CTX_free		EVP_MD_CTX_destroy
+#endif
+
+/** Length of the GCM IV given to OpenSSL, the J0 counter is not passed */
+#define OPENSSL_GCM_IV_LENGTH	12
+
+/** private data structure for each OpenSSL crypto device */
+struct openssl_private {
+	unsigned max_nb_queue_pairs;
+	/**< Max number of queue pairs supported by device */
+	unsigned max_nb_sessions;
+	/**< Max number of sessions supported by device */
+};
+
+/** OpenSSL crypto queue pair */
+struct openssl_qp {
+	uint16_t id;
+	/**< Queue Pair Identifier */
+	char name[RTE_CRYPTODEV_NAME_LEN];
+	/**< Unique Queue Pair Name */
+	struct rte_ring *processed_ops;
+	/**< Ring for placing processed operations */
+	struct rte_mempool *sess_mp;
+	/**< Session Mempool */
+	EVP_CIPHER_CTX *cipher_ctx;
+	/**< Cipher context of the session being processed, with its key */
+	EVP_MD_CTX *auth_ctx;
+	/**< HMAC context of the operation being processed */
+	struct rte_cryptodev_stats qp_stats;
+	/**< Queue pair statistics */
+} __rte_cache_aligned;
+
+/** Order of the cipher and authentication of a session */
+enum openssl_chain_order {
+	OPENSSL_CHAIN_ONLY_CIPHER,
+	OPENSSL_CHAIN_ONLY_AUTH,
+	OPENSSL_CHAIN_CIPHER_AUTH,
+	OPENSSL_CHAIN_AUTH_CIPHER,
+	OPENSSL_CHAIN_COMBINED,
+	/**< Authenticated encryption, AES GCM */
+	OPENSSL_CHAIN_NOT_SUPPORTED
+};
+
+/** OpenSSL crypto private session structure */
+struct openssl_session {
+	enum openssl_chain_order chain_order;
+	/**< Chain order */
+
+	struct {
+		enum rte_crypto_cipher_algorithm algo;
+		/**< Cipher algorithm */
+		int encrypt;
+		/**< 1 to encrypt, 0 to decrypt */
+		EVP_CIPHER_CTX *ctx;
+		/**< Cipher context with the expanded key, copied to the queue
+		 * pair context once per run of operations of the session */
+	} cipher;
+
+	struct {
+		enum rte_crypto_auth_algorithm algo;
+		/**< Authentication algorithm */
+		enum rte_crypto_auth_operation operation;
+		/**< Generate or verify the digest */
+		uint16_t digest_length;
+		/**< Digest length */
+		EVP_PKEY *pkey;
+		/**< HMAC key */
+		EVP_MD_CTX *ctx;
+		/**< HMAC context with the key set, copied for each operation */
+	} auth;
+} __rte_cache_aligned;
+
+/**
+ * Setup OpenSSL session parameters
+ * @param	sess	OpenSSL session structure
+ * @param	xform	crypto transform chain
+ *
+ * @return
+ * - On success returns 0
+ * - On failure returns error code < 0
+ */
+extern int
+openssl_set_session_parameters(struct openssl_session *sess,
+		const struct rte_crypto_sym_xform *xform);
+
+/**
+ * Copy an OpenSSL session, the keys of its contexts being already set
+ * @param	dst	OpenSSL session structure to set up
+ * @param	src	configured OpenSSL session structure
+ *
+ * @return
+ * - On success returns 0
+ * - On failure returns error code < 0
+ */
+extern int
+openssl_copy_session(struct openssl_session *dst,
+		const struct openssl_session *src);
+
+/**
+ * Free the OpenSSL contexts of a session
+ * @param	sess	OpenSSL session structure
+ */
+extern void
+openssl_reset_session(struct openssl_session *sess);
+
+/** device specific operations function pointer structure */
+extern struct rte_cryptodev_ops *rte_openssl_pmd_ops;
+
+#endif /* _RTE_OPENSSL_PMD_PRIVATE_H_ */
@@ -0,0 +1,295 @@
+/*-
+ *   BSD LICENSE
+ *
+ *   Copyright(c) 2016 Intel Corporation. All rights reserved.
+ *
+ *   Redistribution and use in source and binary forms, with or without
+ *   modification, are permitted provided that the following conditions
+ *   are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ *     * Neither the name of Intel Corporation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *   OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <rte_common.h>
+#include <rte_lcore.h>
+#include <rte_cryptodev_pmd.h>
+#include <rte_mempool.h>
+
+#include "rte_cryptodev_scheduler.h"
+#include "scheduler_pmd_private.h"
+
+/** Get a scheduler device from its identifier */
+static struct rte_cryptodev *
+scheduler_get_dev(uint8_t scheduler_id)
+{
+	struct rte_cryptodev *dev;
+
+	if (!rte_cryptodev_pmd_is_valid_dev(scheduler_id)) {
+		CRYPTO_SCHEDULER_LOG_ERR("Invalid device id %u", scheduler_id);
+		return NULL;
+	}
+
+	dev = rte_cryptodev_pmd_get_dev(scheduler_id);
+	if (dev->dev_type != RTE_CRYPTODEV_SCHEDULER_PMD) {
+		CRYPTO_SCHEDULER_LOG_ERR("Device %u is not a scheduler",
+				scheduler_id);
+		return NULL;
+	}
+
+	return dev;
+}
+
+/** Check the slaves of a scheduler can be changed */
+static int
+scheduler_check_stopped(struct rte_cryptodev *dev, int no_session)
+{
+	if (dev->data->dev_started) {
+		CRYPTO_SCHEDULER_LOG_ERR("Scheduler %u must be stopped",
+				dev->data->dev_id);
+		return -EBUSY;
+	}
+
+	/* The scheduler sessions hold one session per slave */
+	if (no_session && dev->data->session_pool != NULL &&
+			!rte_mempool_full(dev->data->session_pool)) {
+		CRYPTO_SCHEDULER_LOG_ERR("Scheduler %u has sessions in use",
+				dev->data->dev_id);
+		return -EBUSY;
+	}
+
+	return 0;
+}
+
+int
+rte_cryptodev_scheduler_slave_attach(uint8_t scheduler_id, uint8_t slave_id)
+{
+	struct rte_cryptodev *dev = scheduler_get_dev(scheduler_id);
+	struct scheduler_private *internals;
+	struct rte_cryptodev *slave;
+	uint32_t i;
+	int ret;
+
+	if (dev == NULL)
+		return -EINVAL;
+
+	ret = scheduler_check_stopped(dev, 1);
+	if (ret < 0)
+		return ret;
+
+	if (!rte_cryptodev_pmd_is_valid_dev(slave_id)) {
+		CRYPTO_SCHEDULER_LOG_ERR("Invalid slave id %u", slave_id);
+		return -EINVAL;
+	}
+
+	slave = rte_cryptodev_pmd_get_dev(slave_id);
+	if (slave->dev_type == RTE_CRYPTODEV_SCHEDULER_PMD) {
+		CRYPTO_SCHEDULER_LOG_ERR("Slave %u is a scheduler", slave_id);
+		return -EINVAL;
+	}
+
+	internals = dev->data->dev_private;
+	if (internals->nb_slaves == RTE_CRYPTODEV_SCHEDULER_MAX_NB_SLAVES) {
+		CRYPTO_SCHEDULER_LOG_ERR("Too many slaves");
+		return -ENOSPC;
+	}
+
+	for (i = 0; i < internals->nb_slaves; i++)
+		if (internals->slaves[i] == slave_id) {
+			CRYPTO_SCHEDULER_LOG_ERR("Slave %u already attached",
+					slave_id);
+			return -EEXIST;
+		}
+
+	internals->slaves[internals->nb_slaves++] = slave_id;
+
+	ret = scheduler_update_capabilities(dev);
+	if (ret < 0) {
+		internals->nb_slaves--;
+		return ret;
+	}
+
+	return 0;
+}
+
+int
+rte_cryptodev_scheduler_slave_detach(uint8_t scheduler_id, uint8_t slave_id)
+{
+	struct rte_cryptodev *dev = scheduler_get_dev(scheduler_id);
+	struct scheduler_private *internals;
+	uint32_t i;
+	int ret;
+
+	if (dev == NULL)
+		return -EINVAL;
+
+	ret = scheduler_check_stopped(dev, 1);
+	if (ret < 0)
+		return ret;
+
+	internals = dev->data->dev_private;
+	for (i = 0; i < internals->nb_slaves; i++)
+		if (internals->slaves[i] == slave_id)
+			break;
+
+	if (i == internals->nb_slaves) {
+		CRYPTO_SCHEDULER_LOG_ERR("Slave %u not attached", slave_id);
+		return -ENOENT;
+	}
+
+	/* Keep the other slaves in attach order */
+	for (; i < internals->nb_slaves - 1; i++)
+		internals->slaves[i] = internals->slaves[i + 1];
+	internals->nb_slaves--;
+
+	return scheduler_update_capabilities(dev);
+}
+
+int
+rte_cryptodev_scheduler_slaves_get(uint8_t scheduler_id, uint8_t *slaves)
+{
+	struct rte_cryptodev *dev = scheduler_get_dev(scheduler_id);
+	struct scheduler_private *internals;
+	uint32_t i;
+
+	if (dev == NULL)
+		return -EINVAL;
+
+	internals = dev->data->dev_private;
+	if (slaves != NULL)
+		for (i = 0; i < internals->nb_slaves; i++)
+			slaves[i] = internals->slaves[i];
+
+	return internals->nb_slaves;
+}
+
+int
+rte_cryptodev_scheduler_mode_set(uint8_t scheduler_id,
+	enum rte_cryptodev_scheduler_mode mode)
+{
+	struct rte_cryptodev *dev = scheduler_get_dev(scheduler_id);
+	struct scheduler_private *internals;
+	int ret;
+
+	if (dev == NULL)
+		return -EINVAL;
+
+	ret = scheduler_check_stopped(dev, 0);
+	if (ret < 0)
+		return ret;
+
+	switch (mode) {
+	case RTE_CRYPTODEV_SCHEDULER_MODE_ROUND_ROBIN:
+	case RTE_CRYPTODEV_SCHEDULER_MODE_PKT_SIZE:
+	case RTE_CRYPTODEV_SCHEDULER_MODE_FAILOVER:
+	case RTE_CRYPTODEV_SCHEDULER_MODE_MULTICORE:
+		break;
+	default:
+		CRYPTO_SCHEDULER_LOG_ERR("Invalid scheduling mode %u", mode);
+		return -EINVAL;
+	}
+
+	internals = dev->data->dev_private;
+	internals->mode = mode;
+
+	return 0;
+}
+
+int
+rte_cryptodev_scheduler_mode_get(uint8_t scheduler_id)
+{
+	struct rte_cryptodev *dev = scheduler_get_dev(scheduler_id);
+	struct scheduler_private *internals;
+
+	if (dev == NULL)
+		return -EINVAL;
+
+	internals = dev->data->dev_private;
+
+	return internals->mode;
+}
+
+int
+rte_cryptodev_scheduler_pkt_size_threshold_set(uint8_t scheduler_id,
+	uint32_t threshold)
+{
+	struct rte_cryptodev *dev = scheduler_get_dev(scheduler_id);
+	struct scheduler_private *internals;
+	int ret;
+
+	if (dev == NULL)
+		return -EINVAL;
+
+	ret = scheduler_check_stopped(dev, 0);
+	if (ret < 0)
+		return ret;
+
+	internals = dev->data->dev_private;
+	internals->pkt_size_threshold = threshold;
+
+	return 0;
+}
+
+int
+rte_cryptodev_scheduler_worker_lcores_set(uint8_t scheduler_id,
+	const unsigned *lcores, uint32_t nb_lcores)
+{
+	struct rte_cryptodev *dev = scheduler_get_dev(scheduler_id);
+	struct scheduler_private *internals;
+	uint32_t i, j;
+	int ret;
+
+	if (dev == NULL)
+		return -EINVAL;
+
+	if (nb_lcores > RTE_CRYPTODEV_SCHEDULER_MAX_NB_SLAVES ||
+			(nb_lcores > 0 && lcores == NULL)) {
+		CRYPTO_SCHEDULER_LOG_ERR("Invalid worker lcores");
+		return -EINVAL;
+	}
+
+	for (i = 0; i < nb_lcores; i++) {
+		if (lcores[i] >= RTE_MAX_LCORE ||
+				!rte_lcore_is_enabled(lcores[i])) {
+			CRYPTO_SCHEDULER_LOG_ERR("Lcore %u is not enabled",
+					lcores[i]);
+			return -EINVAL;
+		}
+		for (j = 0; j < i; j++)
+			if (lcores[j] == lcores[i]) {
+				CRYPTO_SCHEDULER_LOG_ERR("Lcore %u set twice",
+						lcores[i]);
+				return -EINVAL;
+			}
+	}
+
+	ret = scheduler_check_stopped(dev, 0);
+	if (ret < 0)
+		return ret;
+
+	internals = dev->data->dev_private;
+	for (i = 0; i < nb_lcores; i++)
+		internals->worker_lcores[i] = lcores[i];
+	internals->nb_workers = nb_lcores;
+
+	return 0;
+}
@@ -0,0 +1,204 @@
+/*-
+ *   BSD LICENSE
+ *
+ *   Copyright(c) 2016 Intel Corporation. All rights reserved.
+ *
+ *   Redistribution and use in source and binary forms, with or without
+ *   modification, are permitted provided that the following conditions
+ *   are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ *     * Neither the name of Intel Corporation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *   OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _RTE_CRYPTODEV_SCHEDULER_H_
+#define _RTE_CRYPTODEV_SCHEDULER_H_
+
+/**
+ * @file rte_cryptodev_scheduler.h
+ *
+ * RTE Crypto Scheduler Device
+ *
+ * The scheduler is a virtual crypto device which aggregates several other
+ * (slave) crypto devices. The operations enqueued on a queue pair of the
+ * scheduler are distributed to the same queue pair of the slaves, according
+ * to the scheduling mode, and are dequeued from the scheduler in the order
+ * they were enqueued. In multi-core mode, the slaves are run by worker lcores
+ * so that the software crypto PMDs do not process the operations on the
+ * lcore enqueuing them.
+ *
+ * The slaves must be configured with rte_cryptodev_configure() by the
+ * application, with at least as many queue pairs as the scheduler. Their
+ * queue pairs are set up by the scheduler when it is started, with the
+ * configuration of the scheduler queue pairs.
+ */
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Maximum number of slaves attached to a scheduler */
+#define RTE_CRYPTODEV_SCHEDULER_MAX_NB_SLAVES	8
+
+/** Default packet size threshold of the packet size mode */
+#define RTE_CRYPTODEV_SCHEDULER_PKT_SIZE_THRESHOLD_DEFAULT	512
+
+/** Scheduling modes */
+enum rte_cryptodev_scheduler_mode {
+	RTE_CRYPTODEV_SCHEDULER_MODE_ROUND_ROBIN = 0,
+	/**< Each burst of operations is sent to the next slave, in a round
+	 * robin fashion. This is the default mode. */
+	RTE_CRYPTODEV_SCHEDULER_MODE_PKT_SIZE,
+	/**< The operations on packets at least as long as the packet size
+	 * threshold are sent to the first slave, the other operations are sent
+	 * to the second slave. Requires two slaves. */
+	RTE_CRYPTODEV_SCHEDULER_MODE_FAILOVER,
+	/**< The operations are sent to the first (primary) slave, the
+	 * operations it has no room for are sent to the second (backup) slave.
+	 * Requires two slaves. */
+	RTE_CRYPTODEV_SCHEDULER_MODE_MULTICORE,
+	/**< Each slave is run by a worker lcore, which takes the operations
+	 * from a ring and enqueues them on the slave in bulk. The bursts of
+	 * operations are sent to the slaves in a round robin fashion. The
+	 * worker lcores are set with
+	 * rte_cryptodev_scheduler_worker_lcores_set(). */
+};
+
+/**
+ * Attach a crypto device to a scheduler as a slave.
+ *
+ * The scheduler must be stopped and have no session in use. The slave must
+ * not be a scheduler.
+ *
+ * @param scheduler_id
+ *   The scheduler device identifier.
+ * @param slave_id
+ *   The slave device identifier.
+ * @return
+ *   0 on success, negative errno value otherwise.
+ */
+int
+rte_cryptodev_scheduler_slave_attach(uint8_t scheduler_id, uint8_t slave_id);
+
+/**
+ * Detach a slave from a scheduler.
+ *
+ * The scheduler must be stopped and have no session in use.
+ *
+ * @param scheduler_id
+ *   The scheduler device identifier.
+ * @param slave_id
+ *   The slave device identifier.
+ * @return
+ *   0 on success, negative errno value otherwise.
+ */
+int
+rte_cryptodev_scheduler_slave_detach(uint8_t scheduler_id, uint8_t slave_id);
+
+/**
+ * Get the slaves of a scheduler.
+ *
+ * @param scheduler_id
+ *   The scheduler device identifier.
+ * @param slaves
+ *   Array of RTE_CRYPTODEV_SCHEDULER_MAX_NB_SLAVES entries where the device
+ *   identifiers of the slaves are written, in the order they were attached.
+ *   Can be NULL.
+ * @return
+ *   The number of slaves on success, negative errno value otherwise.
+ */
+int
+rte_cryptodev_scheduler_slaves_get(uint8_t scheduler_id, uint8_t *slaves);
+
+/**
+ * Set the scheduling mode of a scheduler.
+ *
+ * The scheduler must be stopped.
+ *
+ * @param scheduler_id
+ *   The scheduler device identifier.
+ * @param mode
+ *   The scheduling mode.
+ * @return
+ *   0 on success, negative errno value otherwise.
+ */
+int
+rte_cryptodev_scheduler_mode_set(uint8_t scheduler_id,
+	enum rte_cryptodev_scheduler_mode mode);
+
+/**
+ * Get the scheduling mode of a scheduler.
+ *
+ * @param scheduler_id
+ *   The scheduler device identifier.
+ * @return
+ *   The scheduling mode on success, negative errno value otherwise.
+ */
+int
+rte_cryptodev_scheduler_mode_get(uint8_t scheduler_id);
+
+/**
+ * Set the packet size threshold of the packet size mode.
+ *
+ * The scheduler must be stopped.
+ *
+ * @param scheduler_id
+ *   The scheduler device identifier.
+ * @param threshold
+ *   Packet length, in bytes, from which the operations are sent to the first
+ *   slave.
+ * @return
+ *   0 on success, negative errno value otherwise.
+ */
+int
+rte_cryptodev_scheduler_pkt_size_threshold_set(uint8_t scheduler_id,
+	uint32_t threshold);
+
+/**
+ * Set the worker lcores of the multi-core mode.
+ *
+ * The scheduler must be stopped. The worker lcore i runs the slave i, so
+ * there must be as many worker lcores as slaves when the scheduler is
+ * started in multi-core mode. The worker lcores must be enabled, waiting
+ * for work and not used to enqueue or dequeue operations. They are launched
+ * when the scheduler is started, and are waiting again once it is stopped.
+ *
+ * @param scheduler_id
+ *   The scheduler device identifier.
+ * @param lcores
+ *   Array of nb_lcores lcore identifiers.
+ * @param nb_lcores
+ *   Number of worker lcores, up to RTE_CRYPTODEV_SCHEDULER_MAX_NB_SLAVES.
+ * @return
+ *   0 on success, negative errno value otherwise.
+ */
+int
+rte_cryptodev_scheduler_worker_lcores_set(uint8_t scheduler_id,
+	const unsigned *lcores, uint32_t nb_lcores);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _RTE_CRYPTODEV_SCHEDULER_H_ */
@@ -0,0 +1,594 @@
+/*-
+ *   BSD LICENSE
+ *
+ *   Copyright(c) 2016 Intel Corporation. All rights reserved.
+ *
+ *   Redistribution and use in source and binary forms, with or without
+ *   modification, are permitted provided that the following conditions
+ *   are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ *     * Neither the name of Intel Corporation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *   OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <rte_common.h>
+#include <rte_config.h>
+#include <rte_cryptodev_pmd.h>
+#include <rte_dev.h>
+#include <rte_malloc.h>
+
+#include "scheduler_pmd_private.h"
+
+/**
+ * Global static parameter used to create a unique name for each crypto device.
+ */
+static unsigned unique_name_id;
+
+static inline int
+create_unique_device_name(char *name, size_t size)
+{
+	int ret;
+
+	if (name == NULL)
+		return -EINVAL;
+
+	ret = snprintf(name, size, "%s_%u", CRYPTODEV_NAME_SCHEDULER_PMD,
+			unique_name_id++);
+	if (ret < 0)
+		return ret;
+	return 0;
+}
+
+/** Schedule an operation to a slave, switching to the slave session */
+static inline void
+scheduler_slave_schedule(struct scheduler_qp *qp, uint32_t slave,
+		struct rte_crypto_op *op)
+{
+	struct scheduler_slave_qp *sqp = &qp->slaves[slave];
+
+	if (op->sym->sess_type == RTE_CRYPTO_SYM_OP_WITH_SESSION) {
+		struct scheduler_session *sess =
+			(struct scheduler_session *)op->sym->session->_private;
+
+		op->sym->session = sess->sessions[slave];
+	}
+
+	sqp->backlog[sqp->tail & qp->order_mask] = op;
+	sqp->tail++;
+}
+
+/** Number of operations a slave can still be given */
+static inline uint32_t
+scheduler_slave_room(struct scheduler_slave_qp *sqp)
+{
+	return sqp->capacity - sqp->nb_inflight - (sqp->tail - sqp->head);
+}
+
+/**
+ * Enqueue the backlog of a slave, without exceeding the room of the slave
+ * queue pair. Some software PMDs lose the operations they have no room for,
+ * so the slaves are only offered what they can hold.
+ */
+static inline void
+scheduler_slave_flush(struct scheduler_qp *qp, struct scheduler_slave_qp *sqp)
+{
+	while (sqp->head != sqp->tail) {
+		uint32_t pos = sqp->head & qp->order_mask;
+		uint32_t n = RTE_MIN(sqp->tail - sqp->head,
+				qp->order_mask + 1 - pos);
+		uint16_t n_enq;
+
+		n = RTE_MIN(n, sqp->capacity - sqp->nb_inflight);
+		n = RTE_MIN(n, (uint32_t)UINT16_MAX);
+		if (n == 0)
+			break;
+
+		n_enq = rte_cryptodev_enqueue_burst(sqp->dev_id, sqp->qp_id,
+				&sqp->backlog[pos], n);
+		sqp->head += n_enq;
+		sqp->nb_inflight += n_enq;
+
+		if (n_enq < n) {
+			struct rte_crypto_op *op =
+				sqp->backlog[sqp->head & qp->order_mask];
+
+			/*
+			 * The slave refused an invalid operation: it is
+			 * complete, the order buffer returns it with its
+			 * error status.
+			 */
+			if (op->status == RTE_CRYPTO_OP_STATUS_NOT_PROCESSED)
+				break;
+			sqp->head++;
+		}
+	}
+}
+
+/** Pass the backlog of a slave to its worker lcore, multi-core mode */
+static inline void
+scheduler_slave_flush_ring(struct scheduler_qp *qp,
+		struct scheduler_slave_qp *sqp)
+{
+	while (sqp->head != sqp->tail) {
+		uint32_t pos = sqp->head & qp->order_mask;
+		uint32_t n = RTE_MIN(sqp->tail - sqp->head,
+				qp->order_mask + 1 - pos);
+		uint32_t n_enq;
+
+		n_enq = rte_ring_sp_enqueue_burst(sqp->ring,
+				(void **)&sqp->backlog[pos], n);
+		sqp->head += n_enq;
+		if (n_enq < n)
+			break;
+	}
+}
+
+/** Dequeue the processed operations of a slave */
+static inline void
+scheduler_slave_drain(struct scheduler_slave_qp *sqp)
+{
+	struct rte_crypto_op *ops[SCHEDULER_DRAIN_BURST_SIZE];
+	uint16_t n;
+
+	/*
+	 * The operations are already in the order buffer, only the number
+	 * of operations returned by the slave matters.
+	 */
+	while (sqp->nb_inflight) {
+		n = rte_cryptodev_dequeue_burst(sqp->dev_id, sqp->qp_id,
+				ops, SCHEDULER_DRAIN_BURST_SIZE);
+		sqp->nb_inflight -= n;
+		if (n < SCHEDULER_DRAIN_BURST_SIZE)
+			break;
+	}
+}
+
+static inline __attribute__((always_inline)) uint16_t
+scheduler_enqueue_burst(void *queue_pair, struct rte_crypto_op **ops,
+		uint16_t nb_ops, enum rte_cryptodev_scheduler_mode mode)
+{
+	struct scheduler_qp *qp = queue_pair;
+	uint32_t n_free, i;
+
+	n_free = qp->order_capacity - (qp->order_tail - qp->order_head);
+	if (nb_ops > n_free)
+		nb_ops = n_free;
+
+	/* Record the operations in the order buffer */
+	for (i = 0; i < nb_ops; i++) {
+		struct rte_crypto_op *op = ops[i];
+		struct scheduler_order_entry *e =
+			&qp->order[(qp->order_tail + i) & qp->order_mask];
+
+		if (op->sym->sess_type == RTE_CRYPTO_SYM_OP_WITH_SESSION) {
+			if (unlikely(op->sym->session == NULL ||
+					op->sym->session->dev_type !=
+					RTE_CRYPTODEV_SCHEDULER_PMD)) {
+				op->status = RTE_CRYPTO_OP_STATUS_INVALID_ARGS;
+				qp->qp_stats.enqueue_err_count++;
+				break;
+			}
+			e->session = op->sym->session;
+		} else
+			e->session = NULL;
+
+		op->status = RTE_CRYPTO_OP_STATUS_NOT_PROCESSED;
+		e->op = op;
+	}
+	nb_ops = i;
+	qp->order_tail += nb_ops;
+	qp->qp_stats.enqueued_count += nb_ops;
+
+	/* Schedule them to the slaves */
+	switch (mode) {
+	case RTE_CRYPTODEV_SCHEDULER_MODE_ROUND_ROBIN:
+	case RTE_CRYPTODEV_SCHEDULER_MODE_MULTICORE:
+	{
+		uint32_t slave = qp->next_slave;
+
+		for (i = 0; i < nb_ops; i++) {
+			if (mode == RTE_CRYPTODEV_SCHEDULER_MODE_MULTICORE) {
+				struct scheduler_order_entry *e =
+					&qp->order[(qp->order_tail - nb_ops +
+						i) & qp->order_mask];
+
+				e->slave = slave;
+				e->seq = qp->slaves[slave].tail;
+			}
+			scheduler_slave_schedule(qp, slave, ops[i]);
+		}
+
+		if (nb_ops)
+			qp->next_slave = (slave + 1 == qp->nb_slaves) ?
+					0 : slave + 1;
+
+		if (mode == RTE_CRYPTODEV_SCHEDULER_MODE_MULTICORE)
+			scheduler_slave_flush_ring(qp, &qp->slaves[slave]);
+		else
+			scheduler_slave_flush(qp, &qp->slaves[slave]);
+		break;
+	}
+
+	case RTE_CRYPTODEV_SCHEDULER_MODE_PKT_SIZE:
+		for (i = 0; i < nb_ops; i++)
+			scheduler_slave_schedule(qp,
+				(ops[i]->sym->m_src->pkt_len <
+					qp->pkt_size_threshold),
+				ops[i]);
+
+		scheduler_slave_flush(qp, &qp->slaves[0]);
+		scheduler_slave_flush(qp, &qp->slaves[1]);
+		break;
+
+	case RTE_CRYPTODEV_SCHEDULER_MODE_FAILOVER:
+	{
+		uint32_t n_primary = scheduler_slave_room(&qp->slaves[0]);
+
+		if (n_primary > nb_ops)
+			n_primary = nb_ops;
+
+		for (i = 0; i < n_primary; i++)
+			scheduler_slave_schedule(qp, 0, ops[i]);
+		for (; i < nb_ops; i++)
+			scheduler_slave_schedule(qp, 1, ops[i]);
+
+		scheduler_slave_flush(qp, &qp->slaves[0]);
+		scheduler_slave_flush(qp, &qp->slaves[1]);
+		break;
+	}
+	}
+
+	return nb_ops;
+}
+
+/** Enqueue burst, round robin mode */
+static uint16_t
+scheduler_enqueue_burst_rr(void *queue_pair, struct rte_crypto_op **ops,
+		uint16_t nb_ops)
+{
+	return scheduler_enqueue_burst(queue_pair, ops, nb_ops,
+			RTE_CRYPTODEV_SCHEDULER_MODE_ROUND_ROBIN);
+}
+
+/** Enqueue burst, packet size mode */
+static uint16_t
+scheduler_enqueue_burst_pkt_size(void *queue_pair, struct rte_crypto_op **ops,
+		uint16_t nb_ops)
+{
+	return scheduler_enqueue_burst(queue_pair, ops, nb_ops,
+			RTE_CRYPTODEV_SCHEDULER_MODE_PKT_SIZE);
+}
+
+/** Enqueue burst, failover mode */
+static uint16_t
+scheduler_enqueue_burst_failover(void *queue_pair, struct rte_crypto_op **ops,
+		uint16_t nb_ops)
+{
+	return scheduler_enqueue_burst(queue_pair, ops, nb_ops,
+			RTE_CRYPTODEV_SCHEDULER_MODE_FAILOVER);
+}
+
+/** Enqueue burst, multi-core mode */
+static uint16_t
+scheduler_enqueue_burst_multicore(void *queue_pair,
+		struct rte_crypto_op **ops, uint16_t nb_ops)
+{
+	return scheduler_enqueue_burst(queue_pair, ops, nb_ops,
+			RTE_CRYPTODEV_SCHEDULER_MODE_MULTICORE);
+}
+
+/**
+ * Return the completed operations in enqueue order, stopping at the oldest
+ * operation still being processed. In multi-core mode, an operation is
+ * complete once counted by the worker lcore of its slave, not as soon as
+ * the slave writes its status.
+ */
+static inline __attribute__((always_inline)) uint16_t
+scheduler_order_drain(struct scheduler_qp *qp, struct rte_crypto_op **ops,
+		uint16_t nb_ops, enum rte_cryptodev_scheduler_mode mode)
+{
+	uint16_t n = 0;
+
+	while (n < nb_ops && qp->order_head != qp->order_tail) {
+		struct scheduler_order_entry *e =
+			&qp->order[qp->order_head & qp->order_mask];
+		struct rte_crypto_op *op = e->op;
+
+		if (mode == RTE_CRYPTODEV_SCHEDULER_MODE_MULTICORE) {
+			if ((int32_t)(qp->slaves[e->slave].nb_done -
+					e->seq) <= 0)
+				break;
+		} else if (op->status == RTE_CRYPTO_OP_STATUS_NOT_PROCESSED)
+			break;
+
+		if (e->session != NULL)
+			op->sym->session = e->session;
+
+		ops[n++] = op;
+		qp->order_head++;
+	}
+
+	qp->qp_stats.dequeued_count += n;
+
+	return n;
+}
+
+/** Dequeue burst */
+static uint16_t
+scheduler_dequeue_burst(void *queue_pair, struct rte_crypto_op **ops,
+		uint16_t nb_ops)
+{
+	struct scheduler_qp *qp = queue_pair;
+	uint32_t i;
+
+	for (i = 0; i < qp->nb_slaves; i++) {
+		scheduler_slave_drain(&qp->slaves[i]);
+		scheduler_slave_flush(qp, &qp->slaves[i]);
+	}
+
+	return scheduler_order_drain(qp, ops, nb_ops,
+			RTE_CRYPTODEV_SCHEDULER_MODE_ROUND_ROBIN);
+}
+
+/** Dequeue burst, multi-core mode */
+static uint16_t
+scheduler_dequeue_burst_multicore(void *queue_pair,
+		struct rte_crypto_op **ops, uint16_t nb_ops)
+{
+	struct scheduler_qp *qp = queue_pair;
+	uint32_t i;
+	uint16_t n;
+
+	for (i = 0; i < qp->nb_slaves; i++)
+		scheduler_slave_flush_ring(qp, &qp->slaves[i]);
+
+	/*
+	 * The worker lcores dequeue the operations from the slaves and count
+	 * them once complete. The operations are read after their count.
+	 */
+	n = scheduler_order_drain(qp, ops, nb_ops,
+			RTE_CRYPTODEV_SCHEDULER_MODE_MULTICORE);
+	rte_smp_rmb();
+
+	return n;
+}
+
+/**
+ * Publish the completion of the next n operations of a worker queue pair,
+ * in ring order. The writes of the slave to the operations must be visible
+ * before their count.
+ */
+static inline void
+scheduler_worker_done(struct scheduler_worker_qp *wqp, uint32_t n)
+{
+	rte_smp_wmb();
+	*wqp->nb_done += n;
+}
+
+/**
+ * Main loop of the worker lcores of the multi-core mode: take the operations
+ * scheduled to the slave from the ring of each queue pair and enqueue them
+ * on the slave in bulk, then dequeue the processed ones. The scheduler queue
+ * pairs return the operations from their order buffer, so the worker only
+ * counts the operations it dequeues. The slave queue pairs return the
+ * operations in enqueue order, so the count follows the ring order; an
+ * operation refused by the slave is only counted once the operations
+ * enqueued before it are.
+ */
+int
+scheduler_worker_loop(void *arg)
+{
+	struct scheduler_worker *w = arg;
+	struct rte_crypto_op *ops[SCHEDULER_WORKER_BURST_SIZE];
+	uint16_t q, n, n_enq;
+
+	while (!w->stop) {
+		for (q = 0; q < w->nb_qps; q++) {
+			struct scheduler_worker_qp *wqp = &w->qps[q];
+
+			if (wqp->nb_inflight) {
+				n = rte_cryptodev_dequeue_burst(w->dev_id,
+						wqp->qp_id, ops,
+						SCHEDULER_WORKER_BURST_SIZE);
+				wqp->nb_inflight -= n;
+				if (n)
+					scheduler_worker_done(wqp, n);
+			}
+
+			if (wqp->nb_pending == 0) {
+				wqp->nb_pending = rte_ring_sc_dequeue_burst(
+						wqp->ring,
+						(void **)wqp->pending,
+						SCHEDULER_WORKER_BURST_SIZE);
+				wqp->first_pending = 0;
+			}
+
+			while (wqp->first_pending < wqp->nb_pending) {
+				if (wqp->refused) {
+					if (wqp->nb_inflight)
+						break;
+					wqp->refused = 0;
+					wqp->first_pending++;
+					scheduler_worker_done(wqp, 1);
+					continue;
+				}
+
+				n = RTE_MIN((uint32_t)(wqp->nb_pending -
+						wqp->first_pending),
+						wqp->capacity -
+						wqp->nb_inflight);
+				if (n == 0)
+					break;
+
+				n_enq = rte_cryptodev_enqueue_burst(w->dev_id,
+						wqp->qp_id,
+						&wqp->pending[wqp->first_pending],
+						n);
+				wqp->first_pending += n_enq;
+				wqp->nb_inflight += n_enq;
+
+				if (n_enq < n) {
+					struct rte_crypto_op *op = wqp->pending[
+						wqp->first_pending];
+
+					/*
+					 * Invalid operation, counted once
+					 * the operations before it are
+					 */
+					if (op->status ==
+						RTE_CRYPTO_OP_STATUS_NOT_PROCESSED)
+						break;
+					wqp->refused = 1;
+				}
+			}
+
+			if (wqp->first_pending == wqp->nb_pending)
+				wqp->nb_pending = 0;
+		}
+	}
+
+	return 0;
+}
+
+/** Set the burst functions of a scheduler for its scheduling mode */
+void
+scheduler_set_burst_functions(struct rte_cryptodev *dev)
+{
+	struct scheduler_private *internals = dev->data->dev_private;
+
+	switch (internals->mode) {
+	case RTE_CRYPTODEV_SCHEDULER_MODE_PKT_SIZE:
+		dev->enqueue_burst = scheduler_enqueue_burst_pkt_size;
+		break;
+	case RTE_CRYPTODEV_SCHEDULER_MODE_FAILOVER:
+		dev->enqueue_burst = scheduler_enqueue_burst_failover;
+		break;
+	case RTE_CRYPTODEV_SCHEDULER_MODE_MULTICORE:
+		dev->enqueue_burst = scheduler_enqueue_burst_multicore;
+		dev->dequeue_burst = scheduler_dequeue_burst_multicore;
+		return;
+	case RTE_CRYPTODEV_SCHEDULER_MODE_ROUND_ROBIN:
+	default:
+		dev->enqueue_burst = scheduler_enqueue_burst_rr;
+		break;
+	}
+	dev->dequeue_burst = scheduler_dequeue_burst;
+}
+
+static int cryptodev_scheduler_uninit(const char *name);
+
+/** Create crypto device */
+static int
+cryptodev_scheduler_create(const char *name,
+		struct rte_crypto_vdev_init_params *init_params)
+{
+	struct rte_cryptodev *dev;
+	char crypto_dev_name[RTE_CRYPTODEV_NAME_MAX_LEN];
+	struct scheduler_private *internals;
+
+	/* create a unique device name */
+	if (create_unique_device_name(crypto_dev_name,
+			RTE_CRYPTODEV_NAME_MAX_LEN) != 0) {
+		CRYPTO_SCHEDULER_LOG_ERR("failed to create unique cryptodev "
+				"name");
+		return -EINVAL;
+	}
+
+	dev = rte_cryptodev_pmd_virtual_dev_init(crypto_dev_name,
+			sizeof(struct scheduler_private),
+			init_params->socket_id);
+	if (dev == NULL) {
+		CRYPTO_SCHEDULER_LOG_ERR("failed to create cryptodev vdev");
+		goto init_error;
+	}
+
+	dev->dev_type = RTE_CRYPTODEV_SCHEDULER_PMD;
+	dev->dev_ops = scheduler_pmd_ops;
+
+	internals = dev->data->dev_private;
+
+	internals->max_nb_qpairs = init_params->max_nb_queue_pairs;
+	internals->max_nb_sessions = init_params->max_nb_sessions;
+	internals->mode = RTE_CRYPTODEV_SCHEDULER_MODE_ROUND_ROBIN;
+	internals->pkt_size_threshold =
+			RTE_CRYPTODEV_SCHEDULER_PKT_SIZE_THRESHOLD_DEFAULT;
+
+	/* register rx/tx burst functions for data path */
+	scheduler_set_burst_functions(dev);
+
+	/* the feature flags are those of the slaves, set on attach */
+	dev->feature_flags = RTE_CRYPTODEV_FF_SYMMETRIC_CRYPTO;
+
+	return 0;
+
+init_error:
+	CRYPTO_SCHEDULER_LOG_ERR("driver %s: cryptodev_scheduler_create failed",
+			name);
+	cryptodev_scheduler_uninit(crypto_dev_name);
+
+	return -EFAULT;
+}
+
+/** Initialise scheduler crypto device */
+static int
+cryptodev_scheduler_init(const char *name,
+		const char *input_args)
+{
+	struct rte_crypto_vdev_init_params init_params = {
+		RTE_CRYPTODEV_VDEV_DEFAULT_MAX_NB_QUEUE_PAIRS,
+		RTE_CRYPTODEV_VDEV_DEFAULT_MAX_NB_SESSIONS,
+		rte_socket_id()
+	};
+
+	rte_cryptodev_parse_vdev_init_params(&init_params, input_args);
+
+	RTE_LOG(INFO, PMD, "Initialising %s on NUMA node %d\n", name,
+			init_params.socket_id);
+	RTE_LOG(INFO, PMD, "  Max number of queue pairs = %d\n",
+			init_params.max_nb_queue_pairs);
+	RTE_LOG(INFO, PMD, "  Max number of sessions = %d\n",
+			init_params.max_nb_sessions);
+
+	return cryptodev_scheduler_create(name, &init_params);
+}
+
+/** Uninitialise scheduler crypto device */
+static int
+cryptodev_scheduler_uninit(const char *name)
+{
+	if (name == NULL)
+		return -EINVAL;
+
+	RTE_LOG(INFO, PMD, "Closing scheduler crypto device %s on numa "
+			"socket %u\n", name, rte_socket_id());
+
+	return 0;
+}
+
+static struct rte_driver cryptodev_scheduler_pmd_drv = {
+	.name = CRYPTODEV_NAME_SCHEDULER_PMD,
+	.type = PMD_VDEV,
+	.init = cryptodev_scheduler_init,
+	.uninit = cryptodev_scheduler_uninit
+};
+
+PMD_REGISTER_DRIVER(cryptodev_scheduler_pmd_drv);
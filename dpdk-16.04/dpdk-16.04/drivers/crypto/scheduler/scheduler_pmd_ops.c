@@ -0,0 +1,658 @@
+/*-
+ *   BSD LICENSE
+ *
+ *   Copyright(c) 2016 Intel Corporation. All rights reserved.
+ *
+ *   Redistribution and use in source and binary forms, with or without
+ *   modification, are permitted provided that the following conditions
+ *   are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ *     * Neither the name of Intel Corporation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *   OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <string.h>
+
+#include <rte_common.h>
+#include <rte_malloc.h>
+#include <rte_launch.h>
+#include <rte_lcore.h>
+#include <rte_cryptodev_pmd.h>
+
+#include "scheduler_pmd_private.h"
+
+static const struct rte_cryptodev_capabilities scheduler_pmd_no_capabilities[] = {
+	RTE_CRYPTODEV_END_OF_CAPABILITIES_LIST()
+};
+
+/** Check two capabilities are for the same operation and algorithm */
+static int
+scheduler_capability_match(const struct rte_cryptodev_capabilities *a,
+		const struct rte_cryptodev_capabilities *b)
+{
+	if (a->op != b->op || a->sym.xform_type != b->sym.xform_type)
+		return 0;
+
+	if (a->sym.xform_type == RTE_CRYPTO_SYM_XFORM_AUTH)
+		return a->sym.auth.algo == b->sym.auth.algo;
+
+	return a->sym.cipher.algo == b->sym.cipher.algo;
+}
+
+/** Build the capabilities common to all the slaves of a scheduler */
+int
+scheduler_update_capabilities(struct rte_cryptodev *dev)
+{
+	struct scheduler_private *internals = dev->data->dev_private;
+	const struct rte_cryptodev_capabilities *cap;
+	struct rte_cryptodev_capabilities *caps;
+	struct rte_cryptodev_info info;
+	uint32_t i, n = 0;
+
+	rte_free(internals->capabilities);
+	internals->capabilities = NULL;
+
+	dev->feature_flags = RTE_CRYPTODEV_FF_SYMMETRIC_CRYPTO;
+	if (internals->nb_slaves == 0)
+		return 0;
+
+	/*
+	 * Keep the capabilities of the first slave with an algorithm supported
+	 * by all the other slaves.
+	 */
+	rte_cryptodev_info_get(internals->slaves[0], &info);
+	for (cap = info.capabilities;
+			cap->op != RTE_CRYPTO_OP_TYPE_UNDEFINED; cap++)
+		n++;
+
+	caps = rte_zmalloc_socket("Scheduler Crypto PMD Capabilities",
+			(n + 1) * sizeof(*caps), 0, dev->data->socket_id);
+	if (caps == NULL) {
+		CRYPTO_SCHEDULER_LOG_ERR("Failed to allocate capabilities");
+		return -ENOMEM;
+	}
+
+	n = 0;
+	for (cap = info.capabilities;
+			cap->op != RTE_CRYPTO_OP_TYPE_UNDEFINED; cap++) {
+		for (i = 1; i < internals->nb_slaves; i++) {
+			const struct rte_cryptodev_capabilities *s_cap;
+			struct rte_cryptodev_info s_info;
+
+			rte_cryptodev_info_get(internals->slaves[i], &s_info);
+			for (s_cap = s_info.capabilities;
+					s_cap->op != RTE_CRYPTO_OP_TYPE_UNDEFINED;
+					s_cap++)
+				if (scheduler_capability_match(cap, s_cap))
+					break;
+
+			if (s_cap->op == RTE_CRYPTO_OP_TYPE_UNDEFINED)
+				break;
+		}
+
+		if (i == internals->nb_slaves)
+			caps[n++] = *cap;
+	}
+	caps[n].op = RTE_CRYPTO_OP_TYPE_UNDEFINED;
+	internals->capabilities = caps;
+
+	dev->feature_flags = info.feature_flags;
+	for (i = 1; i < internals->nb_slaves; i++) {
+		rte_cryptodev_info_get(internals->slaves[i], &info);
+		dev->feature_flags &= info.feature_flags;
+	}
+
+	return 0;
+}
+
+/** Configure device */
+static int
+scheduler_pmd_config(__rte_unused struct rte_cryptodev *dev)
+{
+	return 0;
+}
+
+/** Free the memory of the slave queue pairs of a queue pair */
+static void
+scheduler_pmd_qp_free_slaves(struct scheduler_qp *qp)
+{
+	uint32_t i;
+
+	for (i = 0; i < RTE_CRYPTODEV_SCHEDULER_MAX_NB_SLAVES; i++) {
+		rte_free(qp->slaves[i].backlog);
+		rte_ring_free(qp->slaves[i].ring);
+		memset(&qp->slaves[i], 0, sizeof(qp->slaves[i]));
+	}
+}
+
+/** Set up the order buffer and the slave backlogs of a queue pair */
+static int
+scheduler_pmd_qp_init(struct rte_cryptodev *dev, struct scheduler_qp *qp)
+{
+	struct scheduler_private *internals = dev->data->dev_private;
+	uint32_t capacity, ring_size, size, i;
+
+	/*
+	 * A queue pair of n descriptors holds n - 1 operations. In multi-core
+	 * mode, as many operations can wait in the ring to the worker lcore.
+	 */
+	capacity = qp->conf.nb_descriptors - 1;
+	ring_size = rte_align32pow2(qp->conf.nb_descriptors);
+	if (internals->mode == RTE_CRYPTODEV_SCHEDULER_MODE_MULTICORE)
+		capacity += ring_size - 1;
+	size = rte_align32pow2(capacity * internals->nb_slaves);
+
+	rte_free(qp->order);
+	qp->order = rte_zmalloc_socket("Scheduler Crypto PMD Order Buffer",
+			size * sizeof(*qp->order), RTE_CACHE_LINE_SIZE,
+			qp->socket_id);
+	if (qp->order == NULL)
+		return -ENOMEM;
+
+	qp->nb_slaves = internals->nb_slaves;
+	qp->next_slave = 0;
+	qp->pkt_size_threshold = internals->pkt_size_threshold;
+	qp->order_mask = size - 1;
+	qp->order_capacity = capacity * internals->nb_slaves;
+	qp->order_head = 0;
+	qp->order_tail = 0;
+
+	scheduler_pmd_qp_free_slaves(qp);
+	for (i = 0; i < internals->nb_slaves; i++) {
+		struct scheduler_slave_qp *sqp = &qp->slaves[i];
+
+		sqp->dev_id = internals->slaves[i];
+		sqp->qp_id = qp->id;
+		sqp->capacity = capacity;
+		sqp->backlog = rte_zmalloc_socket(
+				"Scheduler Crypto PMD Slave Backlog",
+				size * sizeof(*sqp->backlog),
+				RTE_CACHE_LINE_SIZE, qp->socket_id);
+		if (sqp->backlog == NULL)
+			return -ENOMEM;
+
+		if (internals->mode == RTE_CRYPTODEV_SCHEDULER_MODE_MULTICORE) {
+			char name[RTE_RING_NAMESIZE];
+
+			snprintf(name, sizeof(name), "sched_%u_qp_%u_slave_%u",
+					dev->data->dev_id, qp->id, i);
+			sqp->ring = rte_ring_create(name, ring_size,
+					qp->socket_id,
+					RING_F_SP_ENQ | RING_F_SC_DEQ);
+			if (sqp->ring == NULL)
+				return -ENOMEM;
+		}
+	}
+
+	return 0;
+}
+
+/** Stop and free the worker lcores */
+static void
+scheduler_pmd_workers_stop(struct scheduler_private *internals)
+{
+	uint32_t i;
+
+	if (internals->workers == NULL)
+		return;
+
+	for (i = 0; i < internals->nb_slaves; i++) {
+		struct scheduler_worker *w = &internals->workers[i];
+
+		if (w->stop)
+			continue;
+		w->stop = 1;
+		rte_eal_wait_lcore(w->lcore_id);
+	}
+
+	for (i = 0; i < internals->nb_slaves; i++)
+		rte_free(internals->workers[i].qps);
+	rte_free(internals->workers);
+	internals->workers = NULL;
+}
+
+/** Launch a worker lcore per slave, multi-core mode */
+static int
+scheduler_pmd_workers_start(struct rte_cryptodev *dev)
+{
+	struct scheduler_private *internals = dev->data->dev_private;
+	uint32_t i;
+	uint16_t q;
+
+	internals->workers = rte_zmalloc_socket("Scheduler Crypto PMD Workers",
+			internals->nb_slaves * sizeof(*internals->workers),
+			RTE_CACHE_LINE_SIZE, dev->data->socket_id);
+	if (internals->workers == NULL)
+		return -ENOMEM;
+
+	for (i = 0; i < internals->nb_slaves; i++) {
+		struct scheduler_worker *w = &internals->workers[i];
+
+		w->lcore_id = internals->worker_lcores[i];
+		w->dev_id = internals->slaves[i];
+		w->nb_qps = dev->data->nb_queue_pairs;
+		w->stop = 1;
+		w->qps = rte_zmalloc_socket("Scheduler Crypto PMD Worker QPs",
+				w->nb_qps * sizeof(*w->qps),
+				RTE_CACHE_LINE_SIZE,
+				rte_lcore_to_socket_id(w->lcore_id));
+		if (w->qps == NULL)
+			goto error;
+
+		for (q = 0; q < w->nb_qps; q++) {
+			struct scheduler_qp *qp = dev->data->queue_pairs[q];
+
+			w->qps[q].ring = qp->slaves[i].ring;
+			w->qps[q].nb_done = &qp->slaves[i].nb_done;
+			w->qps[q].qp_id = q;
+			w->qps[q].capacity = qp->conf.nb_descriptors - 1;
+		}
+	}
+
+	for (i = 0; i < internals->nb_slaves; i++) {
+		struct scheduler_worker *w = &internals->workers[i];
+
+		w->stop = 0;
+		if (rte_eal_remote_launch(scheduler_worker_loop, w,
+				w->lcore_id) != 0) {
+			CRYPTO_SCHEDULER_LOG_ERR("Worker lcore %u is busy",
+					w->lcore_id);
+			w->stop = 1;
+			goto error;
+		}
+	}
+
+	return 0;
+
+error:
+	scheduler_pmd_workers_stop(internals);
+	return -EBUSY;
+}
+
+/** Start device */
+static int
+scheduler_pmd_start(struct rte_cryptodev *dev)
+{
+	struct scheduler_private *internals = dev->data->dev_private;
+	uint32_t i;
+	uint16_t qp_id;
+	int ret;
+
+	if (internals->nb_slaves == 0) {
+		CRYPTO_SCHEDULER_LOG_ERR("No slave attached");
+		return -EINVAL;
+	}
+
+	if ((internals->mode == RTE_CRYPTODEV_SCHEDULER_MODE_PKT_SIZE ||
+			internals->mode == RTE_CRYPTODEV_SCHEDULER_MODE_FAILOVER) &&
+			internals->nb_slaves != 2) {
+		CRYPTO_SCHEDULER_LOG_ERR("Scheduling mode %u requires two "
+				"slaves, %u attached", internals->mode,
+				internals->nb_slaves);
+		return -EINVAL;
+	}
+
+	if (internals->mode == RTE_CRYPTODEV_SCHEDULER_MODE_MULTICORE) {
+		if (internals->nb_workers != internals->nb_slaves) {
+			CRYPTO_SCHEDULER_LOG_ERR("Multi-core mode requires a "
+					"worker lcore per slave, %u set for "
+					"%u slaves", internals->nb_workers,
+					internals->nb_slaves);
+			return -EINVAL;
+		}
+
+		for (i = 0; i < internals->nb_workers; i++)
+			if (internals->worker_lcores[i] == rte_lcore_id()) {
+				CRYPTO_SCHEDULER_LOG_ERR("Worker lcore %u "
+						"starts the scheduler",
+						rte_lcore_id());
+				return -EINVAL;
+			}
+	}
+
+	/* Set up the queue pairs of the slaves like the scheduler ones */
+	for (qp_id = 0; qp_id < dev->data->nb_queue_pairs; qp_id++) {
+		struct scheduler_qp *qp = dev->data->queue_pairs[qp_id];
+
+		if (qp == NULL) {
+			CRYPTO_SCHEDULER_LOG_ERR("Queue pair %u not set up",
+					qp_id);
+			return -EINVAL;
+		}
+
+		for (i = 0; i < internals->nb_slaves; i++) {
+			ret = rte_cryptodev_queue_pair_setup(
+					internals->slaves[i], qp_id,
+					&qp->conf, qp->socket_id);
+			if (ret < 0) {
+				CRYPTO_SCHEDULER_LOG_ERR("Failed to set up "
+						"queue pair %u of slave %u",
+						qp_id, internals->slaves[i]);
+				return ret;
+			}
+		}
+
+		ret = scheduler_pmd_qp_init(dev, qp);
+		if (ret < 0) {
+			CRYPTO_SCHEDULER_LOG_ERR("Failed to allocate queue "
+					"pair %u order buffer", qp_id);
+			return ret;
+		}
+	}
+
+	for (i = 0; i < internals->nb_slaves; i++) {
+		ret = rte_cryptodev_start(internals->slaves[i]);
+		if (ret < 0) {
+			CRYPTO_SCHEDULER_LOG_ERR("Failed to start slave %u",
+					internals->slaves[i]);
+			while (i-- > 0)
+				rte_cryptodev_stop(internals->slaves[i]);
+			return ret;
+		}
+	}
+
+	if (internals->mode == RTE_CRYPTODEV_SCHEDULER_MODE_MULTICORE) {
+		ret = scheduler_pmd_workers_start(dev);
+		if (ret < 0) {
+			for (i = 0; i < internals->nb_slaves; i++)
+				rte_cryptodev_stop(internals->slaves[i]);
+			return ret;
+		}
+	}
+
+	scheduler_set_burst_functions(dev);
+
+	return 0;
+}
+
+/** Stop device */
+static void
+scheduler_pmd_stop(struct rte_cryptodev *dev)
+{
+	struct scheduler_private *internals = dev->data->dev_private;
+	uint32_t i;
+
+	/* The worker lcores use the slaves until they are stopped */
+	scheduler_pmd_workers_stop(internals);
+
+	for (i = 0; i < internals->nb_slaves; i++) {
+		struct rte_cryptodev *slave =
+			rte_cryptodev_pmd_get_dev(internals->slaves[i]);
+
+		if (slave->data->dev_started)
+			rte_cryptodev_stop(internals->slaves[i]);
+	}
+}
+
+/** Close device */
+static int
+scheduler_pmd_close(struct rte_cryptodev *dev)
+{
+	struct scheduler_private *internals = dev->data->dev_private;
+
+	rte_free(internals->capabilities);
+	internals->capabilities = NULL;
+
+	return 0;
+}
+
+/** Get device statistics */
+static void
+scheduler_pmd_stats_get(struct rte_cryptodev *dev,
+		struct rte_cryptodev_stats *stats)
+{
+	int qp_id;
+
+	for (qp_id = 0; qp_id < dev->data->nb_queue_pairs; qp_id++) {
+		struct scheduler_qp *qp = dev->data->queue_pairs[qp_id];
+
+		stats->enqueued_count += qp->qp_stats.enqueued_count;
+		stats->dequeued_count += qp->qp_stats.dequeued_count;
+
+		stats->enqueue_err_count += qp->qp_stats.enqueue_err_count;
+		stats->dequeue_err_count += qp->qp_stats.dequeue_err_count;
+	}
+}
+
+/** Reset device statistics */
+static void
+scheduler_pmd_stats_reset(struct rte_cryptodev *dev)
+{
+	int qp_id;
+
+	for (qp_id = 0; qp_id < dev->data->nb_queue_pairs; qp_id++) {
+		struct scheduler_qp *qp = dev->data->queue_pairs[qp_id];
+
+		memset(&qp->qp_stats, 0, sizeof(qp->qp_stats));
+	}
+}
+
+
+/** Get device info */
+static void
+scheduler_pmd_info_get(struct rte_cryptodev *dev,
+		struct rte_cryptodev_info *dev_info)
+{
+	struct scheduler_private *internals = dev->data->dev_private;
+	uint32_t i;
+
+	if (dev_info == NULL)
+		return;
+
+	dev_info->dev_type = dev->dev_type;
+	dev_info->max_nb_queue_pairs = internals->max_nb_qpairs;
+	dev_info->sym.max_nb_sessions = internals->max_nb_sessions;
+	dev_info->feature_flags = dev->feature_flags;
+	dev_info->capabilities = internals->capabilities ?
+			internals->capabilities :
+			scheduler_pmd_no_capabilities;
+
+	/* The scheduler cannot do more than any of its slaves */
+	for (i = 0; i < internals->nb_slaves; i++) {
+		struct rte_cryptodev_info s_info;
+
+		rte_cryptodev_info_get(internals->slaves[i], &s_info);
+		if (s_info.max_nb_queue_pairs < dev_info->max_nb_queue_pairs)
+			dev_info->max_nb_queue_pairs =
+					s_info.max_nb_queue_pairs;
+		if (s_info.sym.max_nb_sessions <
+				dev_info->sym.max_nb_sessions)
+			dev_info->sym.max_nb_sessions =
+					s_info.sym.max_nb_sessions;
+	}
+}
+
+/** Release queue pair */
+static int
+scheduler_pmd_qp_release(struct rte_cryptodev *dev, uint16_t qp_id)
+{
+	struct scheduler_qp *qp = dev->data->queue_pairs[qp_id];
+
+	if (qp != NULL) {
+		scheduler_pmd_qp_free_slaves(qp);
+		rte_free(qp->order);
+		rte_free(qp);
+		dev->data->queue_pairs[qp_id] = NULL;
+	}
+	return 0;
+}
+
+/** Setup a queue pair */
+static int
+scheduler_pmd_qp_setup(struct rte_cryptodev *dev, uint16_t qp_id,
+		const struct rte_cryptodev_qp_conf *qp_conf,
+		 int socket_id)
+{
+	struct scheduler_private *internals = dev->data->dev_private;
+	struct scheduler_qp *qp;
+
+	if (qp_id >= internals->max_nb_qpairs) {
+		CRYPTO_SCHEDULER_LOG_ERR("Invalid qp_id %u, greater than "
+				"maximum number of queue pairs supported (%u).",
+				qp_id, internals->max_nb_qpairs);
+		return (-EINVAL);
+	}
+
+	if (qp_conf->nb_descriptors < 2) {
+		CRYPTO_SCHEDULER_LOG_ERR("Invalid number of descriptors %u",
+				qp_conf->nb_descriptors);
+		return (-EINVAL);
+	}
+
+	/* Free memory prior to re-allocation if needed. */
+	if (dev->data->queue_pairs[qp_id] != NULL)
+		scheduler_pmd_qp_release(dev, qp_id);
+
+	/* Allocate the queue pair data structure. */
+	qp = rte_zmalloc_socket("Scheduler Crypto PMD Queue Pair", sizeof(*qp),
+					RTE_CACHE_LINE_SIZE, socket_id);
+	if (qp == NULL) {
+		CRYPTO_SCHEDULER_LOG_ERR("Failed to allocate queue pair "
+				"memory");
+		return (-ENOMEM);
+	}
+
+	/*
+	 * The order buffer and the slave queue pairs depend on the slaves,
+	 * they are set up when the device is started.
+	 */
+	qp->id = qp_id;
+	qp->socket_id = socket_id;
+	qp->conf = *qp_conf;
+	dev->data->queue_pairs[qp_id] = qp;
+
+	return 0;
+}
+
+/** Start queue pair */
+static int
+scheduler_pmd_qp_start(__rte_unused struct rte_cryptodev *dev,
+		__rte_unused uint16_t queue_pair_id)
+{
+	return -ENOTSUP;
+}
+
+/** Stop queue pair */
+static int
+scheduler_pmd_qp_stop(__rte_unused struct rte_cryptodev *dev,
+		__rte_unused uint16_t queue_pair_id)
+{
+	return -ENOTSUP;
+}
+
+/** Return the number of allocated queue pairs */
+static uint32_t
+scheduler_pmd_qp_count(struct rte_cryptodev *dev)
+{
+	return dev->data->nb_queue_pairs;
+}
+
+/** Returns the size of the scheduler crypto session structure */
+static unsigned
+scheduler_pmd_session_get_size(struct rte_cryptodev *dev __rte_unused)
+{
+	return sizeof(struct scheduler_session);
+}
+
+/** Free the slave sessions of a scheduler session */
+static void
+scheduler_pmd_session_free_slaves(struct rte_cryptodev *dev,
+		struct scheduler_session *sess)
+{
+	struct scheduler_private *internals = dev->data->dev_private;
+	uint32_t i;
+
+	for (i = 0; i < internals->nb_slaves; i++)
+		if (sess->sessions[i] != NULL) {
+			rte_cryptodev_sym_session_free(internals->slaves[i],
+					sess->sessions[i]);
+			sess->sessions[i] = NULL;
+		}
+}
+
+/** Configure a scheduler session, creating a session on every slave */
+static void *
+scheduler_pmd_session_configure(struct rte_cryptodev *dev,
+		struct rte_crypto_sym_xform *xform, void *sess)
+{
+	struct scheduler_private *internals = dev->data->dev_private;
+	struct scheduler_session *s = sess;
+	uint32_t i;
+
+	if (unlikely(sess == NULL)) {
+		CRYPTO_SCHEDULER_LOG_ERR("invalid session struct");
+		return NULL;
+	}
+
+	if (internals->nb_slaves == 0) {
+		CRYPTO_SCHEDULER_LOG_ERR("no slave attached");
+		return NULL;
+	}
+
+	memset(s, 0, sizeof(*s));
+	for (i = 0; i < internals->nb_slaves; i++) {
+		s->sessions[i] = rte_cryptodev_sym_session_create(
+				internals->slaves[i], xform);
+		if (s->sessions[i] == NULL) {
+			CRYPTO_SCHEDULER_LOG_ERR("failed to create session "
+					"on slave %u", internals->slaves[i]);
+			scheduler_pmd_session_free_slaves(dev, s);
+			return NULL;
+		}
+	}
+
+	return sess;
+}
+
+/** Clear the memory of session so it doesn't leave key material behind */
+static void
+scheduler_pmd_session_clear(struct rte_cryptodev *dev, void *sess)
+{
+	if (sess) {
+		scheduler_pmd_session_free_slaves(dev, sess);
+		memset(sess, 0, sizeof(struct scheduler_session));
+	}
+}
+
+struct rte_cryptodev_ops scheduler_ops = {
+		.dev_configure		= scheduler_pmd_config,
+		.dev_start		= scheduler_pmd_start,
+		.dev_stop		= scheduler_pmd_stop,
+		.dev_close		= scheduler_pmd_close,
+
+		.stats_get		= scheduler_pmd_stats_get,
+		.stats_reset		= scheduler_pmd_stats_reset,
+
+		.dev_infos_get		= scheduler_pmd_info_get,
+
+		.queue_pair_setup	= scheduler_pmd_qp_setup,
+		.queue_pair_release	= scheduler_pmd_qp_release,
+		.queue_pair_start	= scheduler_pmd_qp_start,
+		.queue_pair_stop	= scheduler_pmd_qp_stop,
+		.queue_pair_count	= scheduler_pmd_qp_count,
+
+		.session_get_size	= scheduler_pmd_session_get_size,
+		.session_configure	= scheduler_pmd_session_configure,
+		.session_clear		= scheduler_pmd_session_clear
+};
+
+struct rte_cryptodev_ops *scheduler_pmd_ops = &scheduler_ops;
@@ -0,0 +1,216 @@
+/*-
+ *   BSD LICENSE
+ *
+ *   Copyright(c) 2016 Intel Corporation. All rights reserved.
+ *
+ *   Redistribution and use in source and binary forms, with or without
+ *   modification, are permitted provided that the following conditions
+ *   are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ *     * Neither the name of Intel Corporation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *   OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _SCHEDULER_PMD_PRIVATE_H_
+#define _SCHEDULER_PMD_PRIVATE_H_
+
+#include "rte_config.h"
+#include "rte_cryptodev_scheduler.h"
+
+#define CRYPTO_SCHEDULER_LOG_ERR(fmt, args...) \
+	RTE_LOG(ERR, CRYPTODEV, "[%s] %s() line %u: " fmt "\n",  \
+			CRYPTODEV_NAME_SCHEDULER_PMD, \
+			__func__, __LINE__, ## args)
+
+#ifdef RTE_LIBRTE_PMD_CRYPTO_SCHEDULER_DEBUG
+#define CRYPTO_SCHEDULER_LOG_INFO(fmt, args...) \
+	RTE_LOG(INFO, CRYPTODEV, "[%s] %s() line %u: " fmt "\n", \
+			CRYPTODEV_NAME_SCHEDULER_PMD, \
+			__func__, __LINE__, ## args)
+#else
+#define CRYPTO_SCHEDULER_LOG_INFO(fmt, args...)
+#endif
+
+/** Number of operations dequeued at once from a slave */
+#define SCHEDULER_DRAIN_BURST_SIZE	32
+
+/** Number of operations taken at once from its rings by a worker lcore */
+#define SCHEDULER_WORKER_BURST_SIZE	32
+
+/** private data structure for each scheduler crypto device */
+struct scheduler_private {
+	unsigned max_nb_qpairs;		/**< Max number of queue pairs */
+	unsigned max_nb_sessions;	/**< Max number of sessions */
+
+	enum rte_cryptodev_scheduler_mode mode;
+	/**< Scheduling mode */
+	uint32_t pkt_size_threshold;
+	/**< Packet size threshold of the packet size mode */
+
+	uint32_t nb_slaves;
+	/**< Number of attached slaves */
+	uint8_t slaves[RTE_CRYPTODEV_SCHEDULER_MAX_NB_SLAVES];
+	/**< Device identifiers of the attached slaves */
+
+	struct rte_cryptodev_capabilities *capabilities;
+	/**< Capabilities common to all the slaves */
+
+	uint32_t nb_workers;
+	/**< Number of worker lcores of the multi-core mode */
+	unsigned worker_lcores[RTE_CRYPTODEV_SCHEDULER_MAX_NB_SLAVES];
+	/**< Worker lcore of each slave in multi-core mode */
+	struct scheduler_worker *workers;
+	/**< Running worker lcores */
+};
+
+/** Queue pair of a slave, as seen from a worker lcore */
+struct scheduler_worker_qp {
+	struct rte_ring *ring;
+	/**< Operations scheduled to the slave queue pair */
+	uint16_t qp_id;
+	/**< Slave queue pair identifier */
+	uint16_t nb_pending;
+	/**< Number of operations taken from the ring */
+	uint16_t first_pending;
+	/**< Index of the first operation not enqueued on the slave yet */
+	uint32_t nb_inflight;
+	/**< Number of operations enqueued on the slave and not dequeued yet */
+	uint32_t capacity;
+	/**< Maximum number of operations in flight on the slave queue pair */
+	uint8_t refused;
+	/**< Set when the first pending operation was refused by the slave */
+	volatile uint32_t *nb_done;
+	/**< Completion count of the scheduler queue pair, see
+	 * scheduler_slave_qp */
+	struct rte_crypto_op *pending[SCHEDULER_WORKER_BURST_SIZE];
+	/**< Operations taken from the ring */
+};
+
+/** Worker lcore of the multi-core mode, running one slave */
+struct scheduler_worker {
+	unsigned lcore_id;
+	/**< Worker lcore identifier */
+	uint8_t dev_id;
+	/**< Slave device identifier */
+	volatile int stop;
+	/**< Set to stop the worker lcore */
+	uint16_t nb_qps;
+	/**< Number of queue pairs */
+	struct scheduler_worker_qp *qps;
+	/**< Queue pairs of the slave */
+} __rte_cache_aligned;
+
+/** Queue pair of a slave, as seen from a scheduler queue pair */
+struct scheduler_slave_qp {
+	uint8_t dev_id;
+	/**< Slave device identifier */
+	uint16_t qp_id;
+	/**< Slave queue pair identifier */
+	uint32_t nb_inflight;
+	/**< Number of operations enqueued on the slave and not dequeued yet */
+	uint32_t capacity;
+	/**< Maximum number of operations in flight on the slave queue pair */
+
+	uint32_t head;
+	/**< Backlog index of the next operation to enqueue on the slave */
+	uint32_t tail;
+	/**< Backlog index where the next operation is scheduled */
+	struct rte_crypto_op **backlog;
+	/**< Operations scheduled to the slave and not enqueued on it yet,
+	 * sized as the order buffer */
+	struct rte_ring *ring;
+	/**< Ring to the worker lcore of the slave in multi-core mode */
+
+	volatile uint32_t nb_done __rte_cache_aligned;
+	/**< Number of operations passed in the ring and complete, in ring
+	 * order, published by the worker lcore in multi-core mode */
+};
+
+/** Entry of the order buffer */
+struct scheduler_order_entry {
+	struct rte_crypto_op *op;
+	/**< Operation, in enqueue order */
+	struct rte_cryptodev_sym_session *session;
+	/**< Scheduler session of the operation, restored on dequeue */
+	uint32_t slave;
+	/**< Slave of the operation, multi-core mode */
+	uint32_t seq;
+	/**< Backlog index of the operation in its slave, multi-core mode */
+};
+
+/** Scheduler crypto queue pair */
+struct scheduler_qp {
+	uint16_t id;
+	/**< Queue Pair Identifier */
+	int socket_id;
+	/**< Socket the queue pair memory is allocated on */
+	struct rte_cryptodev_qp_conf conf;
+	/**< Configuration of the queue pair, applied to the slaves */
+
+	uint32_t nb_slaves;
+	/**< Number of slaves */
+	uint32_t next_slave;
+	/**< Slave of the next burst in round robin mode */
+	uint32_t pkt_size_threshold;
+	/**< Packet size threshold of the packet size mode */
+
+	uint32_t order_mask;
+	/**< Order buffer size - 1 */
+	uint32_t order_capacity;
+	/**< Maximum number of operations in the order buffer */
+	uint32_t order_head;
+	/**< Order buffer index of the oldest operation */
+	uint32_t order_tail;
+	/**< Order buffer index of the next enqueued operation */
+	struct scheduler_order_entry *order;
+	/**< Operations in flight, in enqueue order */
+
+	struct scheduler_slave_qp slaves[RTE_CRYPTODEV_SCHEDULER_MAX_NB_SLAVES];
+	/**< Slave queue pairs */
+
+	struct rte_cryptodev_stats qp_stats;
+	/**< Queue pair statistics */
+} __rte_cache_aligned;
+
+/** Scheduler crypto private session structure */
+struct scheduler_session {
+	struct rte_cryptodev_sym_session *sessions[
+			RTE_CRYPTODEV_SCHEDULER_MAX_NB_SLAVES];
+	/**< Session of each slave, in slave order */
+};
+
+/** Set the burst functions of a scheduler for its scheduling mode */
+extern void
+scheduler_set_burst_functions(struct rte_cryptodev *dev);
+
+/** Build the capabilities common to all the slaves of a scheduler */
+extern int
+scheduler_update_capabilities(struct rte_cryptodev *dev);
+
+/** Main loop of the worker lcores of the multi-core mode */
+extern int
+scheduler_worker_loop(void *arg);
+
+/** device specific operations function pointer structure */
+extern struct rte_cryptodev_ops *scheduler_pmd_ops;
+
+#endif /* _SCHEDULER_PMD_PRIVATE_H_ */
@@ -317,6 +317,15 @@ snow3g_pmd_session_clear(struct rte_cryptodev *dev __rte_unused, void *sess)
 		memset(sess, 0, sizeof(struct snow3g_session));
 }
 
+/** Copy a session, its expanded keys being plain data */
+static int
+snow3g_pmd_session_copy(struct rte_cryptodev *dev __rte_unused, void *dst,
+		const void *src)
+{
+	memcpy(dst, src, sizeof(struct snow3g_session));
+	return 0;
+}
+
 struct rte_cryptodev_ops snow3g_pmd_ops = {
 		.dev_configure      = snow3g_pmd_config,
 		.dev_start          = snow3g_pmd_start,
@@ -336,7 +345,8 @@ struct rte_cryptodev_ops snow3g_pmd_ops = {
 
 		.session_get_size   = snow3g_pmd_session_get_size,
 		.session_configure  = snow3g_pmd_session_configure,
-		.session_clear      = snow3g_pmd_session_clear
+		.session_clear      = snow3g_pmd_session_clear,
+		.session_copy       = snow3g_pmd_session_copy
 };
 
 struct rte_cryptodev_ops *rte_snow3g_pmd_ops = &snow3g_pmd_ops;
@@ -33,9 +33,6 @@
 #include <unistd.h>
 #include <pthread.h>
 #include <stdbool.h>
-#ifdef RTE_LIBRTE_VHOST_NUMA
-#include <numaif.h>
-#endif
 
 #include <rte_mbuf.h>
 #include <rte_ethdev.h>
@@ -50,12 +47,18 @@
 
 #define ETH_VHOST_IFACE_ARG		"iface"
 #define ETH_VHOST_QUEUES_ARG		"queues"
+#define ETH_VHOST_DEQUEUE_ZERO_COPY	"dequeue-zero-copy"
+#define ETH_VHOST_NOTIFY_PKTS_ARG	"notify-pkts"
+#define ETH_VHOST_NOTIFY_USEC_ARG	"notify-usec"
 
 static const char *drivername = "VHOST PMD";
 
 static const char *valid_arguments[] = {
 	ETH_VHOST_IFACE_ARG,
 	ETH_VHOST_QUEUES_ARG,
+	ETH_VHOST_DEQUEUE_ZERO_COPY,
+	ETH_VHOST_NOTIFY_PKTS_ARG,
+	ETH_VHOST_NOTIFY_USEC_ARG,
 	NULL
 };
 
@@ -88,7 +91,10 @@ struct vhost_queue {
 struct pmd_internal {
 	char *dev_name;
 	char *iface_name;
+	uint64_t flags;
 	uint16_t max_queues;
+	uint16_t notify_pkts;
+	uint16_t notify_usec;
 
 	volatile uint16_t once;
 };
@@ -229,9 +235,7 @@ new_device(struct virtio_net *dev)
 	struct pmd_internal *internal;
 	struct vhost_queue *vq;
 	unsigned i;
-#ifdef RTE_LIBRTE_VHOST_NUMA
-	int newnode, ret;
-#endif
+	int newnode;
 
 	if (dev == NULL) {
 		RTE_LOG(INFO, PMD, "Invalid argument\n");
@@ -247,16 +251,10 @@ new_device(struct virtio_net *dev)
 	eth_dev = list->eth_dev;
 	internal = eth_dev->data->dev_private;
 
-#ifdef RTE_LIBRTE_VHOST_NUMA
-	ret  = get_mempolicy(&newnode, NULL, 0, dev,
-			MPOL_F_NODE | MPOL_F_ADDR);
-	if (ret < 0) {
-		RTE_LOG(ERR, PMD, "Unknown numa node\n");
-		return -1;
-	}
-
-	eth_dev->data->numa_node = newnode;
-#endif
+	/* The device has been moved to the numa node of the guest memory. */
+	newnode = rte_vhost_get_numa_node(dev);
+	if (newnode >= 0)
+		eth_dev->data->numa_node = newnode;
 
 	for (i = 0; i < eth_dev->data->nb_rx_queues; i++) {
 		vq = eth_dev->data->rx_queues[i];
@@ -275,8 +273,18 @@ new_device(struct virtio_net *dev)
 		vq->port = eth_dev->data->port_id;
 	}
 
-	for (i = 0; i < dev->virt_qp_nb * VIRTIO_QNUM; i++)
+	/*
+	 * Only the notifications of the guest TX virtqueues are coalesced:
+	 * their pending notification is checked by each RX burst, which the
+	 * application keeps polling. The guest RX virtqueues are only touched
+	 * by TX bursts, which stop with the traffic.
+	 */
+	for (i = 0; i < dev->virt_qp_nb * VIRTIO_QNUM; i++) {
 		rte_vhost_enable_guest_notification(dev, i, 0);
+		if (internal->notify_pkts != 0 && (i & 1) == VIRTIO_TXQ)
+			rte_vhost_guest_notify_coalesce(dev, i,
+				internal->notify_pkts, internal->notify_usec);
+	}
 
 	dev->flags |= VIRTIO_DEV_RUNNING;
 	dev->priv = eth_dev;
@@ -484,7 +492,8 @@ eth_dev_start(struct rte_eth_dev *dev)
 	int ret = 0;
 
 	if (rte_atomic16_cmpset(&internal->once, 0, 1)) {
-		ret = rte_vhost_driver_register(internal->iface_name);
+		ret = rte_vhost_driver_register_flags(internal->iface_name,
+						      internal->flags);
 		if (ret)
 			return ret;
 	}
@@ -689,7 +698,8 @@ static const struct eth_dev_ops ops = {
 
 static int
 eth_dev_vhost_create(const char *name, char *iface_name, int16_t queues,
-		     const unsigned numa_node)
+		     const unsigned numa_node, uint64_t flags,
+		     uint16_t notify_pkts, uint16_t notify_usec)
 {
 	struct rte_eth_dev_data *data = NULL;
 	struct pmd_internal *internal = NULL;
@@ -761,6 +771,9 @@ eth_dev_vhost_create(const char *name, char *iface_name, int16_t queues,
 	data->nb_rx_queues = queues;
 	data->nb_tx_queues = queues;
 	internal->max_queues = queues;
+	internal->flags = flags;
+	internal->notify_pkts = notify_pkts;
+	internal->notify_usec = notify_usec;
 	data->dev_link = pmd_link;
 	data->mac_addrs = eth_addr;
 
@@ -827,6 +840,21 @@ open_queues(const char *key __rte_unused, const char *value, void *extra_args)
 	return 0;
 }
 
+static inline int
+open_int(const char *key __rte_unused, const char *value, void *extra_args)
+{
+	uint16_t *n = extra_args;
+
+	if (value == NULL || extra_args == NULL)
+		return -EINVAL;
+
+	*n = (uint16_t)strtoul(value, NULL, 0);
+	if (*n == USHRT_MAX && errno == ERANGE)
+		return -1;
+
+	return 0;
+}
+
 static int
 rte_pmd_vhost_devinit(const char *name, const char *params)
 {
@@ -834,6 +862,10 @@ rte_pmd_vhost_devinit(const char *name, const char *params)
 	int ret = 0;
 	char *iface_name;
 	uint16_t queues;
+	uint64_t flags = 0;
+	uint16_t dequeue_zero_copy = 0;
+	uint16_t notify_pkts = 0;
+	uint16_t notify_usec = 0;
 
 	RTE_LOG(INFO, PMD, "Initializing pmd_vhost for %s\n", name);
 
@@ -860,7 +892,35 @@ rte_pmd_vhost_devinit(const char *name, const char *params)
 	} else
 		queues = 1;
 
-	eth_dev_vhost_create(name, iface_name, queues, rte_socket_id());
+	if (rte_kvargs_count(kvlist, ETH_VHOST_DEQUEUE_ZERO_COPY) == 1) {
+		ret = rte_kvargs_process(kvlist, ETH_VHOST_DEQUEUE_ZERO_COPY,
+					 &open_int, &dequeue_zero_copy);
+		if (ret < 0)
+			goto out_free;
+
+		if (dequeue_zero_copy)
+			flags |= RTE_VHOST_USER_DEQUEUE_ZERO_COPY;
+	}
+
+	if (rte_kvargs_count(kvlist, ETH_VHOST_NOTIFY_PKTS_ARG) == 1) {
+		ret = rte_kvargs_process(kvlist, ETH_VHOST_NOTIFY_PKTS_ARG,
+					 &open_int, &notify_pkts);
+		if (ret < 0)
+			goto out_free;
+
+		/* the default delay, when only the packets are given */
+		notify_usec = 100;
+	}
+
+	if (rte_kvargs_count(kvlist, ETH_VHOST_NOTIFY_USEC_ARG) == 1) {
+		ret = rte_kvargs_process(kvlist, ETH_VHOST_NOTIFY_USEC_ARG,
+					 &open_int, &notify_usec);
+		if (ret < 0)
+			goto out_free;
+	}
+
+	eth_dev_vhost_create(name, iface_name, queues, rte_socket_id(), flags,
+			     notify_pkts, notify_usec);
 
 out_free:
 	rte_kvargs_free(kvlist);
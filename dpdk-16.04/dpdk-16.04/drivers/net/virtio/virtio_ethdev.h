@@ -65,6 +65,11 @@
 	 1u << VIRTIO_NET_F_MRG_RXBUF	  |	\
 	 1ULL << VIRTIO_F_VERSION_1)
 
+/*
+ * Device initialization, shared with virtio-user
+ */
+int eth_virtio_dev_init(struct rte_eth_dev *eth_dev);
+
 /*
  * CQ function prototype
  */
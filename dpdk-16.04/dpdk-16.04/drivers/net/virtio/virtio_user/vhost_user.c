@@ -0,0 +1,444 @@
+/*-
+ *   BSD LICENSE
+ *
+ *   Copyright(c) 2016 Intel Corporation. All rights reserved.
+ *
+ *   Redistribution and use in source and binary forms, with or without
+ *   modification, are permitted provided that the following conditions
+ *   are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ *     * Neither the name of Intel Corporation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *   OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include <limits.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include <rte_memory.h>
+#include <rte_log.h>
+
+#include "vhost.h"
+#include "../virtio_logs.h"
+
+/* The vhost-user requests answered by the backend */
+#define VHOST_USER_NEED_REPLY(req) \
+	((req) == VHOST_USER_GET_FEATURES || \
+	 (req) == VHOST_USER_GET_PROTOCOL_FEATURES || \
+	 (req) == VHOST_USER_GET_QUEUE_NUM || \
+	 (req) == VHOST_USER_GET_VRING_BASE)
+
+static int
+vhost_user_write(int fd, void *buf, int len, int *fds, int fd_num)
+{
+	int r;
+	struct msghdr msgh;
+	struct iovec iov;
+	size_t fd_size = fd_num * sizeof(int);
+	char control[CMSG_SPACE(fd_size)];
+	struct cmsghdr *cmsg;
+
+	memset(&msgh, 0, sizeof(msgh));
+	memset(control, 0, sizeof(control));
+
+	iov.iov_base = (uint8_t *)buf;
+	iov.iov_len = len;
+
+	msgh.msg_iov = &iov;
+	msgh.msg_iovlen = 1;
+
+	if (fd_num > 0) {
+		msgh.msg_control = control;
+		msgh.msg_controllen = sizeof(control);
+
+		cmsg = CMSG_FIRSTHDR(&msgh);
+		cmsg->cmsg_len = CMSG_LEN(fd_size);
+		cmsg->cmsg_level = SOL_SOCKET;
+		cmsg->cmsg_type = SCM_RIGHTS;
+		memcpy(CMSG_DATA(cmsg), fds, fd_size);
+	}
+
+	do {
+		r = sendmsg(fd, &msgh, 0);
+	} while (r < 0 && errno == EINTR);
+
+	return r;
+}
+
+static int
+vhost_user_read(int fd, struct vhost_user_msg *msg)
+{
+	uint32_t valid_flags = VHOST_USER_REPLY_MASK | VHOST_USER_VERSION;
+	int ret, sz_hdr = VHOST_USER_HDR_SIZE, sz_payload;
+
+	ret = recv(fd, (void *)msg, sz_hdr, 0);
+	if (ret < sz_hdr) {
+		PMD_DRV_LOG(ERR, "Failed to recv msg hdr: %d instead of %d.",
+			    ret, sz_hdr);
+		return -1;
+	}
+
+	/* validate msg flags */
+	if (msg->flags != valid_flags) {
+		PMD_DRV_LOG(ERR, "Failed to recv msg: flags %x instead of %x.",
+			    msg->flags, valid_flags);
+		return -1;
+	}
+
+	sz_payload = msg->size;
+	if ((size_t)sz_payload > VHOST_USER_PAYLOAD_SIZE) {
+		PMD_DRV_LOG(ERR, "Failed to recv msg: payload size %d.",
+			    sz_payload);
+		return -1;
+	}
+
+	if (sz_payload) {
+		ret = recv(fd, (void *)((char *)msg + sz_hdr), sz_payload, 0);
+		if (ret < sz_payload) {
+			PMD_DRV_LOG(ERR,
+				"Failed to recv msg payload: %d instead of %d.",
+				ret, msg->size);
+			return -1;
+		}
+	}
+
+	return 0;
+}
+
+struct hugepage_file_info {
+	uint64_t addr;            /**< virtual addr */
+	size_t   size;            /**< the file size */
+	uint64_t offset;          /**< offset of the mapping in the file */
+	char     path[PATH_MAX];  /**< path to backing file */
+};
+
+/* Whether [start, end) is part of the DPDK memory */
+static int
+in_memseg(uint64_t start, uint64_t end)
+{
+	const struct rte_memseg *ms = rte_eal_get_physmem_layout();
+	unsigned int i;
+
+	for (i = 0; i < RTE_MAX_MEMSEG && ms[i].addr != NULL; i++) {
+		if (start >= ms[i].addr_64 && end <= ms[i].addr_64 + ms[i].len)
+			return 1;
+	}
+
+	return 0;
+}
+
+/*
+ * Finds the files backing the DPDK memory, i.e. the hugepage files mapped
+ * in the memory segments, in /proc/self/maps. Each one becomes a memory
+ * region shared with the backend, so there can be at most
+ * VHOST_MEMORY_MAX_NREGIONS of them.
+ */
+static int
+get_hugepage_file_info(struct hugepage_file_info huges[], int max)
+{
+	int idx = 0;
+	FILE *f;
+	char buf[BUFSIZ], *path, *end;
+	uint64_t v_start, v_end, offset;
+
+	f = fopen("/proc/self/maps", "r");
+	if (f == NULL) {
+		PMD_DRV_LOG(ERR, "cannot open /proc/self/maps");
+		return -1;
+	}
+
+	while (fgets(buf, sizeof(buf), f) != NULL) {
+		if (sscanf(buf, "%" SCNx64 "-%" SCNx64 " %*s %" SCNx64,
+			   &v_start, &v_end, &offset) < 3)
+			continue;
+
+		path = strchr(buf, '/');
+		if (path == NULL || !in_memseg(v_start, v_end))
+			continue;
+
+		end = strchr(path, '\n');
+		if (end != NULL)
+			*end = '\0';
+
+		/* one file mapped in several pieces */
+		if (idx > 0 && strcmp(path, huges[idx - 1].path) == 0 &&
+		    huges[idx - 1].addr + huges[idx - 1].size == v_start &&
+		    huges[idx - 1].offset + huges[idx - 1].size == offset) {
+			huges[idx - 1].size += v_end - v_start;
+			continue;
+		}
+
+		if (idx >= max) {
+			PMD_DRV_LOG(ERR,
+				"more than %d hugepage files, use larger "
+				"hugepages or less memory", max);
+			goto error;
+		}
+
+		huges[idx].addr = v_start;
+		huges[idx].size = v_end - v_start;
+		huges[idx].offset = offset;
+		snprintf(huges[idx].path, PATH_MAX, "%s", path);
+		idx++;
+	}
+
+	fclose(f);
+	return idx;
+
+error:
+	fclose(f);
+	return -1;
+}
+
+/*
+ * The memory regions are the hugepage files of the process. The backend
+ * sees the virtual addresses of the process as guest physical addresses,
+ * which are the addresses the driver writes in the descriptors.
+ */
+static int
+prepare_vhost_memory_user(struct vhost_user_msg *msg, int fds[])
+{
+	int i, num;
+	struct hugepage_file_info huges[VHOST_MEMORY_MAX_NREGIONS];
+	struct vhost_memory_region mr;
+
+	num = get_hugepage_file_info(huges, VHOST_MEMORY_MAX_NREGIONS);
+	if (num < 0)
+		return -1;
+	if (num == 0) {
+		PMD_DRV_LOG(ERR,
+			"no hugepage file found, virtio-user needs hugepages");
+		return -1;
+	}
+
+	for (i = 0; i < num; ++i) {
+		mr.guest_phys_addr = huges[i].addr;
+		mr.userspace_addr = huges[i].addr;
+		mr.memory_size = huges[i].size;
+		mr.mmap_offset = huges[i].offset;
+		msg->payload.memory.regions[i] = mr;
+		fds[i] = open(huges[i].path, O_RDWR);
+		if (fds[i] < 0) {
+			PMD_DRV_LOG(ERR, "cannot open %s: %s",
+				    huges[i].path, strerror(errno));
+			while (i-- > 0)
+				close(fds[i]);
+			return -1;
+		}
+	}
+
+	msg->payload.memory.nregions = num;
+	msg->payload.memory.padding = 0;
+
+	return 0;
+}
+
+static const char * const vhost_msg_strings[] = {
+	[VHOST_USER_SET_OWNER] = "VHOST_USER_SET_OWNER",
+	[VHOST_USER_RESET_OWNER] = "VHOST_USER_RESET_OWNER",
+	[VHOST_USER_SET_FEATURES] = "VHOST_USER_SET_FEATURES",
+	[VHOST_USER_GET_FEATURES] = "VHOST_USER_GET_FEATURES",
+	[VHOST_USER_SET_VRING_CALL] = "VHOST_USER_SET_VRING_CALL",
+	[VHOST_USER_SET_VRING_NUM] = "VHOST_USER_SET_VRING_NUM",
+	[VHOST_USER_SET_VRING_BASE] = "VHOST_USER_SET_VRING_BASE",
+	[VHOST_USER_GET_VRING_BASE] = "VHOST_USER_GET_VRING_BASE",
+	[VHOST_USER_SET_VRING_ADDR] = "VHOST_USER_SET_VRING_ADDR",
+	[VHOST_USER_SET_VRING_KICK] = "VHOST_USER_SET_VRING_KICK",
+	[VHOST_USER_SET_MEM_TABLE] = "VHOST_USER_SET_MEM_TABLE",
+	[VHOST_USER_GET_PROTOCOL_FEATURES] = "VHOST_USER_GET_PROTOCOL_FEATURES",
+	[VHOST_USER_SET_PROTOCOL_FEATURES] = "VHOST_USER_SET_PROTOCOL_FEATURES",
+	[VHOST_USER_GET_QUEUE_NUM] = "VHOST_USER_GET_QUEUE_NUM",
+	[VHOST_USER_SET_VRING_ENABLE] = "VHOST_USER_SET_VRING_ENABLE",
+};
+
+/*
+ * Sends a vhost-user request, and reads its reply for the GET requests.
+ * The argument depends on the request: a uint64_t for the features, a
+ * struct vhost_vring_state, vhost_vring_addr or vhost_vring_file for the
+ * vrings, nothing for the memory table which is built here.
+ */
+int
+vhost_user_sock(int vhostfd, enum vhost_user_request req, void *arg)
+{
+	struct vhost_user_msg msg;
+	struct vhost_vring_file *file = NULL;
+	int fds[VHOST_MEMORY_MAX_NREGIONS];
+	int fd_num = 0;
+	int i, len, ret;
+
+	PMD_DRV_LOG(INFO, "%s", vhost_msg_strings[req] != NULL ?
+		    vhost_msg_strings[req] : "unknown request");
+
+	memset(&msg, 0, sizeof(msg));
+	msg.request = req;
+	msg.flags = VHOST_USER_VERSION;
+	msg.size = 0;
+
+	switch (req) {
+	case VHOST_USER_GET_FEATURES:
+	case VHOST_USER_GET_PROTOCOL_FEATURES:
+	case VHOST_USER_GET_QUEUE_NUM:
+		break;
+
+	case VHOST_USER_SET_FEATURES:
+	case VHOST_USER_SET_PROTOCOL_FEATURES:
+		msg.payload.u64 = *((uint64_t *)arg);
+		msg.size = sizeof(msg.payload.u64);
+		break;
+
+	case VHOST_USER_SET_OWNER:
+	case VHOST_USER_RESET_OWNER:
+		break;
+
+	case VHOST_USER_SET_MEM_TABLE:
+		if (prepare_vhost_memory_user(&msg, fds) < 0)
+			return -1;
+		fd_num = msg.payload.memory.nregions;
+		msg.size = sizeof(msg.payload.memory.nregions);
+		msg.size += sizeof(msg.payload.memory.padding);
+		msg.size += fd_num * sizeof(struct vhost_memory_region);
+		break;
+
+	case VHOST_USER_SET_VRING_NUM:
+	case VHOST_USER_SET_VRING_BASE:
+	case VHOST_USER_GET_VRING_BASE:
+	case VHOST_USER_SET_VRING_ENABLE:
+		memcpy(&msg.payload.state, arg, sizeof(msg.payload.state));
+		msg.size = sizeof(msg.payload.state);
+		break;
+
+	case VHOST_USER_SET_VRING_ADDR:
+		memcpy(&msg.payload.addr, arg, sizeof(msg.payload.addr));
+		msg.size = sizeof(msg.payload.addr);
+		break;
+
+	case VHOST_USER_SET_VRING_KICK:
+	case VHOST_USER_SET_VRING_CALL:
+		file = arg;
+		msg.payload.u64 = file->index & VHOST_USER_VRING_IDX_MASK;
+		msg.size = sizeof(msg.payload.u64);
+		if (file->fd >= 0)
+			fds[fd_num++] = file->fd;
+		else
+			msg.payload.u64 |= VHOST_USER_VRING_NOFD_MASK;
+		break;
+
+	default:
+		PMD_DRV_LOG(ERR, "unsupported vhost-user request %d", req);
+		return -1;
+	}
+
+	len = VHOST_USER_HDR_SIZE + msg.size;
+	ret = vhost_user_write(vhostfd, &msg, len, fds, fd_num);
+
+	/* the backend has its own references to the memory files now */
+	if (req == VHOST_USER_SET_MEM_TABLE)
+		for (i = 0; i < fd_num; ++i)
+			close(fds[i]);
+
+	if (ret < 0) {
+		RTE_LOG(ERR, PMD, "%s failed: %s\n",
+			vhost_msg_strings[req], strerror(errno));
+		return -1;
+	}
+
+	if (!VHOST_USER_NEED_REPLY(req))
+		return 0;
+
+	if (vhost_user_read(vhostfd, &msg) < 0)
+		return -1;
+
+	if (req != msg.request) {
+		PMD_DRV_LOG(ERR, "received unexpected msg type");
+		return -1;
+	}
+
+	switch (req) {
+	case VHOST_USER_GET_FEATURES:
+	case VHOST_USER_GET_PROTOCOL_FEATURES:
+	case VHOST_USER_GET_QUEUE_NUM:
+		if (msg.size != sizeof(msg.payload.u64)) {
+			PMD_DRV_LOG(ERR, "received bad msg size");
+			return -1;
+		}
+		*((uint64_t *)arg) = msg.payload.u64;
+		break;
+	case VHOST_USER_GET_VRING_BASE:
+		if (msg.size != sizeof(msg.payload.state)) {
+			PMD_DRV_LOG(ERR, "received bad msg size");
+			return -1;
+		}
+		memcpy(arg, &msg.payload.state, sizeof(msg.payload.state));
+		break;
+	default:
+		break;
+	}
+
+	return 0;
+}
+
+/**
+ * Connects to the unix socket of a vhost-user backend.
+ *
+ * @return
+ *   - (-1) if fail;
+ *   - (>=0) if success, the fd of the connection.
+ */
+int
+vhost_user_setup(const char *path)
+{
+	int fd;
+	int flag;
+	struct sockaddr_un un;
+
+	fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (fd < 0) {
+		PMD_DRV_LOG(ERR, "socket() error, %s", strerror(errno));
+		return -1;
+	}
+
+	flag = fcntl(fd, F_GETFD);
+	if (flag < 0 || fcntl(fd, F_SETFD, flag | FD_CLOEXEC) < 0)
+		PMD_DRV_LOG(WARNING, "fcntl failed, %s", strerror(errno));
+
+	memset(&un, 0, sizeof(un));
+	un.sun_family = AF_UNIX;
+	snprintf(un.sun_path, sizeof(un.sun_path), "%s", path);
+	if (connect(fd, (struct sockaddr *)&un, sizeof(un)) < 0) {
+		PMD_DRV_LOG(ERR, "connect to %s error, %s",
+			    path, strerror(errno));
+		close(fd);
+		return -1;
+	}
+
+	return fd;
+}
@@ -0,0 +1,433 @@
+/*-
+ *   BSD LICENSE
+ *
+ *   Copyright(c) 2016 Intel Corporation. All rights reserved.
+ *
+ *   Redistribution and use in source and binary forms, with or without
+ *   modification, are permitted provided that the following conditions
+ *   are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ *     * Neither the name of Intel Corporation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *   OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+
+#include <rte_atomic.h>
+
+#include "vhost.h"
+#include "virtio_user_dev.h"
+#include "../virtio_ethdev.h"
+#include "../virtqueue.h"
+
+/* Features handled by virtio-user itself, never sent to the backend */
+#define VIRTIO_USER_CQ_FEATURES			\
+	(1ULL << VIRTIO_NET_F_CTRL_VQ		|	\
+	 1ULL << VIRTIO_NET_F_CTRL_RX		|	\
+	 1ULL << VIRTIO_NET_F_CTRL_VLAN		|	\
+	 1ULL << VIRTIO_NET_F_GUEST_ANNOUNCE	|	\
+	 1ULL << VIRTIO_NET_F_MQ		|	\
+	 1ULL << VIRTIO_NET_F_CTRL_MAC_ADDR)
+
+static int
+virtio_user_kick_queue(struct virtio_user_dev *dev, uint32_t queue_sel)
+{
+	int kickfd;
+	struct vhost_vring_file file;
+	struct vhost_vring_state state;
+	struct vring *vring = &dev->vrings[queue_sel];
+	struct vhost_vring_addr addr = {
+		.index = queue_sel,
+		.desc_user_addr = (uint64_t)(uintptr_t)vring->desc,
+		.avail_user_addr = (uint64_t)(uintptr_t)vring->avail,
+		.used_user_addr = (uint64_t)(uintptr_t)vring->used,
+		.log_guest_addr = 0,
+		.flags = 0, /* disable log */
+	};
+
+	state.index = queue_sel;
+	state.num = vring->num;
+	if (vhost_user_sock(dev->vhostfd, VHOST_USER_SET_VRING_NUM, &state) < 0)
+		return -1;
+
+	state.num = 0; /* no reservation */
+	if (vhost_user_sock(dev->vhostfd, VHOST_USER_SET_VRING_BASE,
+			    &state) < 0)
+		return -1;
+
+	if (vhost_user_sock(dev->vhostfd, VHOST_USER_SET_VRING_ADDR, &addr) < 0)
+		return -1;
+
+	/*
+	 * The kick fd is set last, the backend starts the device once all
+	 * the vrings have one.
+	 */
+	kickfd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+	if (kickfd < 0) {
+		PMD_DRV_LOG(ERR, "kickfd error, %s", strerror(errno));
+		return -1;
+	}
+	dev->kickfds[queue_sel] = kickfd;
+
+	file.index = queue_sel;
+	file.fd = kickfd;
+	if (vhost_user_sock(dev->vhostfd, VHOST_USER_SET_VRING_KICK, &file) < 0)
+		return -1;
+
+	return 0;
+}
+
+/*
+ * Enables the first pairs queue pairs on the backend, disables the other
+ * ones. Returns the status of the control queue command.
+ */
+static virtio_net_ctrl_ack
+virtio_user_enable_queue_pairs(struct virtio_user_dev *dev, uint16_t pairs)
+{
+	struct vhost_vring_state state;
+	uint32_t i;
+
+	if (pairs == 0 || pairs > dev->max_queue_pairs) {
+		PMD_DRV_LOG(ERR, "cannot enable %u queue pairs out of %u",
+			    pairs, dev->max_queue_pairs);
+		return VIRTIO_NET_ERR;
+	}
+
+	/* Not started yet, the pairs are enabled when the device starts */
+	if (dev->nr_vrings == 0) {
+		dev->queue_pairs = pairs;
+		return VIRTIO_NET_OK;
+	}
+
+	if (pairs > dev->nr_vrings / 2) {
+		PMD_DRV_LOG(ERR, "only %u queue pairs are set up",
+			    dev->nr_vrings / 2);
+		return VIRTIO_NET_ERR;
+	}
+
+	if (!(dev->protocol_features & (1ULL << VHOST_USER_PROTOCOL_F_MQ))) {
+		dev->queue_pairs = pairs;
+		return VIRTIO_NET_OK;
+	}
+
+	for (i = 0; i < dev->nr_vrings; ++i) {
+		state.index = i;
+		state.num = i / 2 < pairs;
+		if (vhost_user_sock(dev->vhostfd, VHOST_USER_SET_VRING_ENABLE,
+				    &state) < 0)
+			return VIRTIO_NET_ERR;
+	}
+
+	dev->queue_pairs = pairs;
+	return VIRTIO_NET_OK;
+}
+
+int
+virtio_user_start_device(struct virtio_user_dev *dev)
+{
+	uint64_t features;
+	struct vhost_vring_file file;
+	uint32_t i, nr_vrings;
+
+	/*
+	 * Only the queue pairs set up by the application are given to the
+	 * backend, it would wait forever for the other ones.
+	 */
+	for (nr_vrings = 0; nr_vrings < dev->max_queue_pairs * 2; nr_vrings += 2)
+		if (dev->vrings[nr_vrings].desc == NULL ||
+		    dev->vrings[nr_vrings + 1].desc == NULL)
+			break;
+	if (nr_vrings == 0) {
+		PMD_DRV_LOG(ERR, "no queue pair is set up");
+		return -1;
+	}
+	if (dev->queue_pairs > nr_vrings / 2)
+		dev->queue_pairs = nr_vrings / 2;
+	dev->nr_vrings = nr_vrings;
+
+	/*
+	 * Step 0: the backend creates the queues on their call fd. It is not
+	 * read, the driver polls the used rings.
+	 */
+	for (i = 0; i < nr_vrings; ++i) {
+		dev->callfds[i] = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+		if (dev->callfds[i] < 0) {
+			PMD_DRV_LOG(ERR, "callfd error, %s", strerror(errno));
+			goto error;
+		}
+		file.index = i;
+		file.fd = dev->callfds[i];
+		if (vhost_user_sock(dev->vhostfd, VHOST_USER_SET_VRING_CALL,
+				    &file) < 0)
+			goto error;
+	}
+
+	/* Step 1: set the features the backend has to know about */
+	features = dev->features & dev->backend_features &
+		~VIRTIO_USER_CQ_FEATURES;
+	if (dev->backend_features & (1ULL << VHOST_USER_F_PROTOCOL_FEATURES))
+		features |= 1ULL << VHOST_USER_F_PROTOCOL_FEATURES;
+	if (vhost_user_sock(dev->vhostfd, VHOST_USER_SET_FEATURES,
+			    &features) < 0)
+		goto error;
+	PMD_DRV_LOG(INFO, "set features: %" PRIx64, features);
+
+	/* Step 2: share the memory regions */
+	if (vhost_user_sock(dev->vhostfd, VHOST_USER_SET_MEM_TABLE, NULL) < 0)
+		goto error;
+
+	/* Step 3: set up and kick the vrings */
+	for (i = 0; i < nr_vrings; ++i)
+		if (virtio_user_kick_queue(dev, i) < 0)
+			goto error;
+
+	/* Step 4: enable the queue pairs in use */
+	if (virtio_user_enable_queue_pairs(dev, dev->queue_pairs) !=
+	    VIRTIO_NET_OK)
+		goto error;
+
+	dev->started = 1;
+	return 0;
+
+error:
+	PMD_DRV_LOG(ERR, "failed to start device on %s", dev->path);
+	virtio_user_stop_device(dev);
+	return -1;
+}
+
+int
+virtio_user_stop_device(struct virtio_user_dev *dev)
+{
+	struct vhost_vring_state state;
+	uint32_t i;
+
+	for (i = 0; i < dev->max_queue_pairs * 2; ++i) {
+		if (dev->kickfds[i] >= 0) {
+			state.index = i;
+			state.num = 0;
+			vhost_user_sock(dev->vhostfd,
+					VHOST_USER_GET_VRING_BASE, &state);
+			close(dev->kickfds[i]);
+			dev->kickfds[i] = -1;
+		}
+		if (dev->callfds[i] >= 0) {
+			close(dev->callfds[i]);
+			dev->callfds[i] = -1;
+		}
+	}
+
+	dev->nr_vrings = 0;
+	dev->started = 0;
+	return 0;
+}
+
+static inline void
+parse_mac(struct virtio_user_dev *dev, const char *mac)
+{
+	int i, r;
+	uint32_t tmp[ETHER_ADDR_LEN];
+
+	if (mac == NULL)
+		return;
+
+	r = sscanf(mac, "%x:%x:%x:%x:%x:%x", &tmp[0],
+			&tmp[1], &tmp[2], &tmp[3], &tmp[4], &tmp[5]);
+	if (r == ETHER_ADDR_LEN) {
+		for (i = 0; i < ETHER_ADDR_LEN; ++i)
+			dev->mac_addr[i] = (uint8_t)tmp[i];
+		dev->mac_specified = 1;
+	} else {
+		/* ignore the wrong mac, use random mac */
+		PMD_DRV_LOG(ERR, "wrong format of mac: %s", mac);
+	}
+}
+
+int
+virtio_user_dev_init(struct virtio_user_dev *dev, char *path, int queues,
+		     int cq, int queue_size, const char *mac)
+{
+	uint64_t queue_num;
+	uint32_t i;
+
+	snprintf(dev->path, PATH_MAX, "%s", path);
+	dev->max_queue_pairs = queues;
+	dev->queue_pairs = 1; /* mq disabled by default */
+	dev->queue_size = queue_size;
+	dev->cq = cq;
+	dev->mac_specified = 0;
+	dev->nr_vrings = 0;
+	dev->started = 0;
+	parse_mac(dev, mac);
+
+	for (i = 0; i < VIRTIO_USER_MAX_VRINGS; ++i) {
+		dev->kickfds[i] = -1;
+		dev->callfds[i] = -1;
+	}
+
+	dev->vhostfd = vhost_user_setup(dev->path);
+	if (dev->vhostfd < 0) {
+		PMD_INIT_LOG(ERR, "backend set up fails");
+		return -1;
+	}
+
+	if (vhost_user_sock(dev->vhostfd, VHOST_USER_SET_OWNER, NULL) < 0) {
+		PMD_INIT_LOG(ERR, "set_owner fails: %s", strerror(errno));
+		goto error;
+	}
+
+	if (vhost_user_sock(dev->vhostfd, VHOST_USER_GET_FEATURES,
+			    &dev->backend_features) < 0) {
+		PMD_INIT_LOG(ERR, "get_features failed: %s", strerror(errno));
+		goto error;
+	}
+
+	dev->protocol_features = 0;
+	if (dev->backend_features & (1ULL << VHOST_USER_F_PROTOCOL_FEATURES)) {
+		if (vhost_user_sock(dev->vhostfd,
+				    VHOST_USER_GET_PROTOCOL_FEATURES,
+				    &dev->protocol_features) < 0)
+			goto error;
+
+		/* the only protocol feature needed */
+		dev->protocol_features &= 1ULL << VHOST_USER_PROTOCOL_F_MQ;
+		if (vhost_user_sock(dev->vhostfd,
+				    VHOST_USER_SET_PROTOCOL_FEATURES,
+				    &dev->protocol_features) < 0)
+			goto error;
+	}
+
+	if (queues > 1) {
+		if (!(dev->protocol_features &
+		      (1ULL << VHOST_USER_PROTOCOL_F_MQ)) ||
+		    vhost_user_sock(dev->vhostfd, VHOST_USER_GET_QUEUE_NUM,
+				    &queue_num) < 0 ||
+		    queue_num < (uint64_t)queues) {
+			PMD_INIT_LOG(ERR, "backend does not have %d queue pairs",
+				     queues);
+			goto error;
+		}
+	}
+
+	/*
+	 * The device of the driver is the backend, plus the control queue
+	 * and the MAC address emulated here.
+	 */
+	dev->device_features = dev->backend_features;
+	if (dev->mac_specified)
+		dev->device_features |= 1ULL << VIRTIO_NET_F_MAC;
+	if (cq)
+		dev->device_features |= VIRTIO_USER_CQ_FEATURES;
+	else
+		dev->device_features &= ~VIRTIO_USER_CQ_FEATURES;
+
+	return 0;
+
+error:
+	close(dev->vhostfd);
+	dev->vhostfd = -1;
+	return -1;
+}
+
+void
+virtio_user_dev_uninit(struct virtio_user_dev *dev)
+{
+	if (dev->started)
+		virtio_user_stop_device(dev);
+
+	if (dev->vhostfd >= 0) {
+		close(dev->vhostfd);
+		dev->vhostfd = -1;
+	}
+}
+
+/*
+ * Runs a control queue command: only the change of the number of queue
+ * pairs matters to the backend, the other ones are acknowledged.
+ */
+static uint32_t
+virtio_user_handle_ctrl_msg(struct virtio_user_dev *dev, struct vring *vring,
+			    uint16_t idx_hdr)
+{
+	struct virtio_net_ctrl_hdr *hdr;
+	virtio_net_ctrl_ack status = VIRTIO_NET_OK;
+	uint16_t i, idx_data, idx_status;
+	uint32_t n_descs = 0;
+
+	/* locate desc for header, data, and status */
+	idx_data = vring->desc[idx_hdr].next;
+	n_descs++;
+
+	i = idx_data;
+	while (vring->desc[i].flags == VRING_DESC_F_NEXT) {
+		i = vring->desc[i].next;
+		n_descs++;
+	}
+
+	/* locate desc for status */
+	idx_status = i;
+	n_descs++;
+
+	hdr = (void *)(uintptr_t)vring->desc[idx_hdr].addr;
+	if (hdr->class == VIRTIO_NET_CTRL_MQ &&
+	    hdr->cmd == VIRTIO_NET_CTRL_MQ_VQ_PAIRS_SET) {
+		uint16_t queues;
+
+		queues = *(uint16_t *)(uintptr_t)vring->desc[idx_data].addr;
+		status = virtio_user_enable_queue_pairs(dev, queues);
+	}
+
+	/* Update status */
+	*(virtio_net_ctrl_ack *)(uintptr_t)vring->desc[idx_status].addr = status;
+
+	return n_descs;
+}
+
+void
+virtio_user_handle_cq(struct virtio_user_dev *dev, uint16_t queue_idx)
+{
+	uint16_t avail_idx, desc_idx;
+	struct vring_used_elem *uep;
+	uint32_t n_descs;
+	struct vring *vring = &dev->vrings[queue_idx];
+
+	/* Consume avail ring, using used ring idx as first one */
+	while (vring->used->idx != vring->avail->idx) {
+		avail_idx = (vring->used->idx) & (vring->num - 1);
+		desc_idx = vring->avail->ring[avail_idx];
+
+		n_descs = virtio_user_handle_ctrl_msg(dev, vring, desc_idx);
+
+		/* Update used ring */
+		uep = &vring->used->ring[avail_idx];
+		uep->id = desc_idx;
+		uep->len = n_descs;
+
+		rte_smp_wmb();
+		vring->used->idx++;
+	}
+}
@@ -64,6 +64,16 @@ struct rte_mbuf;
 #define rte_packet_prefetch(p)  do {} while(0)
 #endif
 
+/*
+ * The buffer addresses written in the descriptors are physical addresses
+ * for a PCI device, and virtual addresses for virtio-user: the virtqueue
+ * offset selects the matching rte_mbuf field.
+ */
+#define VIRTIO_MBUF_ADDR(mb, vq) \
+	(*(uint64_t *)((uintptr_t)(mb) + (vq)->offset))
+#define VIRTIO_MBUF_DATA_DMA_ADDR(mb, vq) \
+	(VIRTIO_MBUF_ADDR(mb, vq) + (mb)->data_off)
+
 #define VIRTQUEUE_MAX_NAME_SZ 32
 
 #define VTNET_SQ_RQ_QUEUE_IDX 0
@@ -183,6 +193,7 @@ struct virtqueue {
 	 */
 	uint16_t vq_used_cons_idx;
 	uint16_t vq_avail_idx;
+	uint16_t offset; /**< offset of the buffer address in rte_mbuf. */
 	uint64_t mbuf_initializer; /**< value to init mbufs. */
 	phys_addr_t virtio_net_hdr_mem; /**< hdr for each xmit packet */
 
@@ -118,6 +118,9 @@ static uint16_t nb_txd = RTE_TEST_TX_DESC_DEFAULT;
 /* ethernet addresses of ports */
 static struct ether_addr ports_eth_addr[RTE_MAX_ETHPORTS];
 
+/* fragmentation flags of each port, checksum offload if the port has it */
+static uint32_t ports_frag_flags[RTE_MAX_ETHPORTS];
+
 #ifndef IPv4_BYTES
 #define IPv4_BYTES_FMT "%" PRIu8 ".%" PRIu8 ".%" PRIu8 ".%" PRIu8
 #define IPv4_BYTES(addr) \
@@ -304,11 +307,12 @@ l3fwd_simple_forward(struct rte_mbuf *m, struct lcore_queue_conf *qconf,
 			qconf->tx_mbufs[port_out].m_table[len] = m;
 			len2 = 1;
 		} else {
-			len2 = rte_ipv4_fragment_packet(m,
+			len2 = rte_ipv4_fragment_packet_bulk(m,
 				&qconf->tx_mbufs[port_out].m_table[len],
 				(uint16_t)(MBUF_TABLE_SIZE - len),
 				IPV4_MTU_DEFAULT,
-				rxq->direct_pool, rxq->indirect_pool);
+				rxq->direct_pool, rxq->indirect_pool,
+				ports_frag_flags[port_out]);
 
 			/* Free input packet */
 			rte_pktmbuf_free(m);
@@ -340,11 +344,12 @@ l3fwd_simple_forward(struct rte_mbuf *m, struct lcore_queue_conf *qconf,
 			qconf->tx_mbufs[port_out].m_table[len] = m;
 			len2 = 1;
 		} else {
-			len2 = rte_ipv6_fragment_packet(m,
+			len2 = rte_ipv6_fragment_packet_bulk(m,
 				&qconf->tx_mbufs[port_out].m_table[len],
 				(uint16_t)(MBUF_TABLE_SIZE - len),
 				IPV6_MTU_DEFAULT,
-				rxq->direct_pool, rxq->indirect_pool);
+				rxq->direct_pool, rxq->indirect_pool,
+				ports_frag_flags[port_out]);
 
 			/* Free input packet */
 			rte_pktmbuf_free(m);
@@ -904,6 +909,11 @@ main(int argc, char **argv)
 		print_ethaddr(" Address:", &ports_eth_addr[portid]);
 		printf("\n");
 
+		/* let the NIC compute the checksums of the fragments */
+		rte_eth_dev_info_get(portid, &dev_info);
+		if (dev_info.tx_offload_capa & DEV_TX_OFFLOAD_IPV4_CKSUM)
+			ports_frag_flags[portid] = RTE_IP_FRAG_TX_CKSUM_OFFLOAD;
+
 		/* init one TX queue per couple (lcore,port) */
 		queueid = 0;
 		for (lcore_id = 0; lcore_id < RTE_MAX_LCORE; lcore_id++) {
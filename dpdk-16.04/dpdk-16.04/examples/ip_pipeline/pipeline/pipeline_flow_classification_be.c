@@ -516,16 +516,14 @@ static void *pipeline_fc_init(struct pipeline_params *params,
 			.seed = 0,
 		};
 
-		struct rte_table_hash_ext_params
+		struct rte_table_hash_cuckoo_params
 			table_hash_params = {
 			.key_size = p_fc->key_size,
 			.n_keys = p_fc->n_flows,
-			.n_buckets = p_fc->n_flows / 4,
-			.n_buckets_ext = p_fc->n_flows / 4,
 			.f_hash = hash_func[(p_fc->key_size / 8) - 1],
 			.seed = 0,
-			.signature_offset = p_fc->hash_offset,
 			.key_offset = p_fc->key_offset,
+			.name = params->name,
 		};
 
 		struct rte_pipeline_table_params table_params = {
@@ -564,7 +562,9 @@ static void *pipeline_fc_init(struct pipeline_params *params,
 			break;
 
 		default:
-			table_params.ops = &rte_table_hash_ext_ops;
+			/* Any key size, the key signature is computed on
+			lookup */
+			table_params.ops = &rte_table_hash_cuckoo_dosig_ops;
 			table_params.arg_create = &table_hash_params;
 		}
 
@@ -178,12 +178,13 @@ pipeline_port_out_params_get_ops(struct pipeline_port_out_params  *p)
 		return &rte_port_ethdev_writer_ops;
 	case PIPELINE_PORT_OUT_ETHDEV_WRITER_NODROP:
 		return &rte_port_ethdev_writer_nodrop_ops;
+	/* Single writer SWQs are written in place */
 	case PIPELINE_PORT_OUT_RING_WRITER:
-		return &rte_port_ring_writer_ops;
+		return &rte_port_ring_writer_zc_ops;
 	case PIPELINE_PORT_OUT_RING_MULTI_WRITER:
 		return &rte_port_ring_multi_writer_ops;
 	case PIPELINE_PORT_OUT_RING_WRITER_NODROP:
-		return &rte_port_ring_writer_nodrop_ops;
+		return &rte_port_ring_writer_zc_nodrop_ops;
 	case PIPELINE_PORT_OUT_RING_MULTI_WRITER_NODROP:
 		return &rte_port_ring_multi_writer_nodrop_ops;
 	case PIPELINE_PORT_OUT_RING_WRITER_IPV4_RAS:
@@ -103,7 +103,7 @@
 #define	MIN_FLOW_TTL	1
 #define	DEF_FLOW_TTL	MS_PER_S
 
-#define MAX_FRAG_NUM RTE_LIBRTE_IP_FRAG_MAX_FRAG
+#define INLINE_FRAG_NUM RTE_LIBRTE_IP_FRAG_INLINE_FRAG
 
 /* Should be power of two. */
 #define	IP_FRAG_TBL_BUCKET_ENTRIES	16
@@ -338,20 +338,15 @@ send_single_packet(struct rte_mbuf *m, uint8_t port)
 	return 0;
 }
 
+/* send a packet, reassembled or not, to its destination port */
 static inline void
-reassemble(struct rte_mbuf *m, uint8_t portid, uint32_t queue,
-	struct lcore_queue_conf *qconf, uint64_t tms)
+forward(struct rte_mbuf *m, uint8_t portid, struct rx_queue *rxq)
 {
 	struct ether_hdr *eth_hdr;
-	struct rte_ip_frag_tbl *tbl;
-	struct rte_ip_frag_death_row *dr;
-	struct rx_queue *rxq;
 	void *d_addr_bytes;
 	uint32_t next_hop_ipv4;
 	uint8_t next_hop_ipv6, dst_port;
 
-	rxq = &qconf->rx_queue_list[queue];
-
 	eth_hdr = rte_pktmbuf_mtod(m, struct ether_hdr *);
 
 	dst_port = portid;
@@ -362,32 +357,6 @@ reassemble(struct rte_mbuf *m, uint8_t portid, uint32_t queue,
 		uint32_t ip_dst;
 
 		ip_hdr = (struct ipv4_hdr *)(eth_hdr + 1);
-
-		 //判断此报文是否是分片
-		if (rte_ipv4_frag_pkt_is_fragmented(ip_hdr)) {
-			struct rte_mbuf *mo;
-
-			tbl = rxq->frag_tbl;
-			dr = &qconf->death_row;
-
-			/* prepare mbuf: setup l2_len/l3_len. */
-			m->l2_len = sizeof(*eth_hdr);
-			m->l3_len = sizeof(*ip_hdr);
-
-			/* process this fragment. */
-			mo = rte_ipv4_frag_reassemble_packet(tbl, dr, m, tms, ip_hdr);
-			if (mo == NULL)
-				/* no packet to send out. */
-				return;
-
-			/* we have our packet reassembled. */
-			if (mo != m) {
-				m = mo;
-				eth_hdr = rte_pktmbuf_mtod(m,
-					struct ether_hdr *);
-				ip_hdr = (struct ipv4_hdr *)(eth_hdr + 1);
-			}
-		}
 		ip_dst = rte_be_to_cpu_32(ip_hdr->dst_addr);
 
 		/* Find destination port */
@@ -399,34 +368,10 @@ reassemble(struct rte_mbuf *m, uint8_t portid, uint32_t queue,
 		eth_hdr->ether_type = rte_be_to_cpu_16(ETHER_TYPE_IPv4);
 	} else if (RTE_ETH_IS_IPV6_HDR(m->packet_type)) {
 		/* if packet is IPv6 */
-		struct ipv6_extension_fragment *frag_hdr;
 		struct ipv6_hdr *ip_hdr;
 
 		ip_hdr = (struct ipv6_hdr *)(eth_hdr + 1);
 
-		frag_hdr = rte_ipv6_frag_get_ipv6_fragment_header(ip_hdr);
-
-		if (frag_hdr != NULL) {
-			struct rte_mbuf *mo;
-
-			tbl = rxq->frag_tbl;
-			dr  = &qconf->death_row;
-
-			/* prepare mbuf: setup l2_len/l3_len. */
-			m->l2_len = sizeof(*eth_hdr);
-			m->l3_len = sizeof(*ip_hdr) + sizeof(*frag_hdr);
-
-			mo = rte_ipv6_frag_reassemble_packet(tbl, dr, m, tms, ip_hdr, frag_hdr);
-			if (mo == NULL)
-				return;
-
-			if (mo != m) {
-				m = mo;
-				eth_hdr = rte_pktmbuf_mtod(m, struct ether_hdr *);
-				ip_hdr = (struct ipv6_hdr *)(eth_hdr + 1);
-			}
-		}
-
 		/* Find destination port */
 		if (rte_lpm6_lookup(rxq->lpm6, ip_hdr->dst_addr, &next_hop_ipv6) == 0 &&
 				(enabled_port_mask & 1 << next_hop_ipv6) != 0) {
@@ -447,11 +392,86 @@ reassemble(struct rte_mbuf *m, uint8_t portid, uint32_t queue,
 	send_single_packet(m, dst_port);
 }
 
+/*
+ * Sort a received packet: IPv4 and IPv6 fragments are set up for
+ * reassembly and kept aside, other packets are forwarded right away.
+ */
+static inline void
+classify(struct rte_mbuf *m, uint8_t portid, struct rx_queue *rxq,
+	struct rte_mbuf **frag4, uint32_t *nb_frag4,
+	struct rte_mbuf **frag6, uint32_t *nb_frag6)
+{
+	struct ether_hdr *eth_hdr;
+
+	eth_hdr = rte_pktmbuf_mtod(m, struct ether_hdr *);
+
+	if (RTE_ETH_IS_IPV4_HDR(m->packet_type)) {
+		struct ipv4_hdr *ip_hdr;
+
+		ip_hdr = (struct ipv4_hdr *)(eth_hdr + 1);
+
+		 //判断此报文是否是分片
+		if (rte_ipv4_frag_pkt_is_fragmented(ip_hdr)) {
+			/* prepare mbuf: setup l2_len/l3_len. */
+			m->l2_len = sizeof(*eth_hdr);
+			m->l3_len = sizeof(*ip_hdr);
+			frag4[(*nb_frag4)++] = m;
+			return;
+		}
+	} else if (RTE_ETH_IS_IPV6_HDR(m->packet_type)) {
+		struct ipv6_extension_fragment *frag_hdr;
+		struct ipv6_hdr *ip_hdr;
+
+		ip_hdr = (struct ipv6_hdr *)(eth_hdr + 1);
+
+		frag_hdr = rte_ipv6_frag_get_ipv6_fragment_header(ip_hdr);
+
+		if (frag_hdr != NULL) {
+			/* prepare mbuf: setup l2_len/l3_len. */
+			m->l2_len = sizeof(*eth_hdr);
+			m->l3_len = sizeof(*ip_hdr) + sizeof(*frag_hdr);
+			frag6[(*nb_frag6)++] = m;
+			return;
+		}
+	}
+
+	forward(m, portid, rxq);
+}
+
+/*
+ * Reassemble the fragments of a burst and forward the complete packets.
+ * The bulk functions look all the fragments up in the table at once and
+ * free the death row themselves.
+ */
+static inline void
+reassemble(uint8_t portid, uint32_t queue, struct lcore_queue_conf *qconf,
+	uint64_t tms, struct rte_mbuf **frag4, uint32_t nb_frag4,
+	struct rte_mbuf **frag6, uint32_t nb_frag6)
+{
+	struct rx_queue *rxq;
+	uint32_t i, n;
+
+	rxq = &qconf->rx_queue_list[queue];
+
+	n = rte_ipv4_frag_reassemble_bulk(rxq->frag_tbl, &qconf->death_row,
+		frag4, nb_frag4, tms, frag4);
+	for (i = 0; i != n; i++)
+		forward(frag4[i], portid, rxq);
+
+	n = rte_ipv6_frag_reassemble_bulk(rxq->frag_tbl, &qconf->death_row,
+		frag6, nb_frag6, tms, frag6);
+	for (i = 0; i != n; i++)
+		forward(frag6[i], portid, rxq);
+}
+
 /* main processing loop */
 static int
 main_loop(__attribute__((unused)) void *dummy)
 {
 	struct rte_mbuf *pkts_burst[MAX_PKT_BURST];
+	struct rte_mbuf *frag4[MAX_PKT_BURST], *frag6[MAX_PKT_BURST];
+	uint32_t nb_frag4, nb_frag6;
+	struct rx_queue *rxq;
 	unsigned lcore_id;
 	uint64_t diff_tsc, cur_tsc, prev_tsc;
 	int i, j, nb_rx;
@@ -505,33 +525,37 @@ main_loop(__attribute__((unused)) void *dummy)
 		 */
 		for (i = 0; i < qconf->n_rx_queue; ++i) {
 
-			portid = qconf->rx_queue_list[i].portid;
+			rxq = &qconf->rx_queue_list[i];
+			portid = rxq->portid;
 
 			nb_rx = rte_eth_rx_burst(portid, 0, pkts_burst,
 				MAX_PKT_BURST);
 
+			nb_frag4 = 0;
+			nb_frag6 = 0;
+
 			/* Prefetch first packets */
 			for (j = 0; j < PREFETCH_OFFSET && j < nb_rx; j++) {
 				rte_prefetch0(rte_pktmbuf_mtod(
 						pkts_burst[j], void *));
 			}
 
-			/* Prefetch and forward already prefetched packets */
+			/* Prefetch and sort already prefetched packets */
 			for (j = 0; j < (nb_rx - PREFETCH_OFFSET); j++) {
 				rte_prefetch0(rte_pktmbuf_mtod(pkts_burst[
 					j + PREFETCH_OFFSET], void *));
-				reassemble(pkts_burst[j], portid,
-					i, qconf, cur_tsc);
+				classify(pkts_burst[j], portid, rxq,
+					frag4, &nb_frag4, frag6, &nb_frag6);
 			}
 
-			/* Forward remaining prefetched packets */
+			/* Sort remaining prefetched packets */
 			for (; j < nb_rx; j++) {
-				reassemble(pkts_burst[j], portid,
-					i, qconf, cur_tsc);
+				classify(pkts_burst[j], portid, rxq,
+					frag4, &nb_frag4, frag6, &nb_frag6);
 			}
 
-			rte_ip_frag_free_death_row(&qconf->death_row,
-				PREFETCH_OFFSET);
+			reassemble(portid, i, qconf, cur_tsc,
+				frag4, nb_frag4, frag6, nb_frag6);
 		}
 	}
 }
@@ -896,12 +920,14 @@ setup_queue_tbl(struct rx_queue *rxq, uint32_t lcore, uint32_t queue)
 	}
 
 	/*
-	 * At any given moment up to <max_flow_num * (MAX_FRAG_NUM)>
-	 * mbufs could be stored int the fragment table.
+	 * At any given moment up to <max_flow_num * (INLINE_FRAG_NUM)>
+	 * mbufs could be stored int the fragment table, plus
+	 * <max_flow_num * IP_FRAG_EXT_NUM> in its overflow blocks.
 	 * Plus, each TX queue can hold up to <max_flow_num> packets.
 	 */
 
-	nb_mbuf = RTE_MAX(max_flow_num, 2UL * MAX_PKT_BURST) * MAX_FRAG_NUM;
+	nb_mbuf = RTE_MAX(max_flow_num, 2UL * MAX_PKT_BURST) *
+		(INLINE_FRAG_NUM + IP_FRAG_EXT_NUM);
 	nb_mbuf *= (port_conf.rxmode.max_rx_pkt_len + BUF_SIZE - 1) / BUF_SIZE;
 	nb_mbuf *= 2; /* ipv4 and ipv6 */
 	nb_mbuf += RTE_TEST_RX_DESC_DEFAULT + RTE_TEST_TX_DESC_DEFAULT;
@@ -603,6 +603,9 @@ static int
 rte_cryptodev_sym_session_pool_create(struct rte_cryptodev *dev,
 		unsigned nb_objs, unsigned obj_cache_size, int socket_id);
 
+static void
+rte_cryptodev_sym_session_cache_free(struct rte_cryptodev *dev);
+
 int
 rte_cryptodev_configure(uint8_t dev_id, struct rte_cryptodev_config *config)
 {
@@ -727,6 +730,10 @@ rte_cryptodev_close(uint8_t dev_id)
 	}
 
 	RTE_FUNC_PTR_OR_ERR_RET(*dev->dev_ops->dev_close, -ENOTSUP);
+
+	/* Clear the key material of the cached sessions */
+	rte_cryptodev_sym_session_cache_free(dev);
+
 	retval = (*dev->dev_ops->dev_close)(dev);
 
 	if (retval < 0)
@@ -959,6 +966,246 @@ rte_cryptodev_sym_session_init(struct rte_mempool *mp,
 		(*dev->dev_ops->session_initialize)(mp, sess->_private);
 }
 
+/** Maximum size of the signature of a cached transform chain */
+#define RTE_CRYPTODEV_SYM_SESSION_SIG_MAX	512
+
+/** Session cache entry, a private session and its transform chain */
+struct rte_cryptodev_sym_session_cache_entry {
+	uint32_t sig_len;
+	/**< Length of the signature, 0 if the entry is free */
+	uint32_t hash;
+	/**< Hash of the signature */
+	uint8_t sig[RTE_CRYPTODEV_SYM_SESSION_SIG_MAX];
+	/**< Signature of the transform chain, with the keys */
+	void *priv;
+	/**< Private session configured with the transform chain */
+};
+
+/**
+ * Direct mapped cache of the private sessions configured on a device, so a
+ * session with the keys of a cached one is copied instead of expanding its
+ * keys again.
+ */
+struct rte_cryptodev_sym_session_cache {
+	rte_spinlock_t lock;
+	/**< Serializes the session creations using the cache */
+	struct rte_cryptodev_sym_session_cache_entry
+		entries[RTE_CRYPTODEV_SYM_SESSION_CACHE_SIZE];
+	/**< Cache entries, indexed by signature hash */
+};
+
+static int
+rte_cryptodev_sym_session_cache_create(struct rte_cryptodev *dev,
+		unsigned priv_sess_size, int socket_id)
+{
+	struct rte_cryptodev_sym_session_cache *cache;
+	unsigned priv_size = RTE_ALIGN_CEIL(priv_sess_size, RTE_CACHE_LINE_SIZE);
+	uint8_t *priv;
+	unsigned i;
+
+	if (RTE_CRYPTODEV_SYM_SESSION_CACHE_SIZE == 0 ||
+			dev->dev_ops->session_copy == NULL ||
+			dev->data->session_cache != NULL)
+		return 0;
+
+	RTE_BUILD_BUG_ON(!rte_is_power_of_2(
+			RTE_CRYPTODEV_SYM_SESSION_CACHE_SIZE));
+
+	cache = rte_zmalloc_socket("cryptodev_session_cache", sizeof(*cache) +
+			RTE_CRYPTODEV_SYM_SESSION_CACHE_SIZE * priv_size,
+			RTE_CACHE_LINE_SIZE, socket_id);
+	if (cache == NULL) {
+		CDEV_LOG_ERR("%s session cache allocation failed",
+				dev->data->name);
+		return -ENOMEM;
+	}
+
+	rte_spinlock_init(&cache->lock);
+
+	priv = (uint8_t *)RTE_PTR_ALIGN_CEIL(cache + 1, RTE_CACHE_LINE_SIZE);
+	for (i = 0; i < RTE_CRYPTODEV_SYM_SESSION_CACHE_SIZE; i++)
+		cache->entries[i].priv = priv + i * priv_size;
+
+	dev->data->session_cache = cache;
+	return 0;
+}
+
+static void
+rte_cryptodev_sym_session_cache_clear(struct rte_cryptodev *dev,
+		struct rte_cryptodev_sym_session_cache_entry *entry)
+{
+	if (entry->sig_len == 0)
+		return;
+
+	dev->dev_ops->session_clear(dev, entry->priv);
+	memset(entry->sig, 0, entry->sig_len);
+	entry->sig_len = 0;
+}
+
+static void
+rte_cryptodev_sym_session_cache_free(struct rte_cryptodev *dev)
+{
+	struct rte_cryptodev_sym_session_cache *cache =
+			dev->data->session_cache;
+	unsigned i;
+
+	if (cache == NULL)
+		return;
+
+	for (i = 0; i < RTE_CRYPTODEV_SYM_SESSION_CACHE_SIZE; i++)
+		rte_cryptodev_sym_session_cache_clear(dev, &cache->entries[i]);
+
+	rte_free(cache);
+	dev->data->session_cache = NULL;
+}
+
+void
+rte_cryptodev_sym_session_cache_flush(uint8_t dev_id)
+{
+	struct rte_cryptodev *dev;
+	struct rte_cryptodev_sym_session_cache *cache;
+	unsigned i;
+
+	if (!rte_cryptodev_pmd_is_valid_dev(dev_id)) {
+		CDEV_LOG_ERR("Invalid dev_id=%" PRIu8, dev_id);
+		return;
+	}
+
+	dev = &rte_crypto_devices[dev_id];
+	cache = dev->data->session_cache;
+	if (cache == NULL)
+		return;
+
+	rte_spinlock_lock(&cache->lock);
+	for (i = 0; i < RTE_CRYPTODEV_SYM_SESSION_CACHE_SIZE; i++)
+		rte_cryptodev_sym_session_cache_clear(dev, &cache->entries[i]);
+	rte_spinlock_unlock(&cache->lock);
+}
+
+/**
+ * Write the signature of a transform chain: the parameters and the keys of
+ * its transforms. Returns the length of the signature, 0 if it does not fit.
+ */
+static uint32_t
+rte_cryptodev_sym_xform_sig(const struct rte_crypto_sym_xform *xform,
+		uint8_t *sig)
+{
+	uint32_t params[6];
+	const uint8_t *key;
+	size_t key_len;
+	uint32_t len = 0;
+
+	for (; xform != NULL; xform = xform->next) {
+		memset(params, 0, sizeof(params));
+		params[0] = xform->type;
+
+		if (xform->type == RTE_CRYPTO_SYM_XFORM_CIPHER) {
+			params[1] = xform->cipher.algo;
+			params[2] = xform->cipher.op;
+			key = xform->cipher.key.data;
+			key_len = xform->cipher.key.length;
+		} else if (xform->type == RTE_CRYPTO_SYM_XFORM_AUTH) {
+			params[1] = xform->auth.algo;
+			params[2] = xform->auth.op;
+			params[3] = xform->auth.digest_length;
+			params[4] = xform->auth.add_auth_data_length;
+			key = xform->auth.key.data;
+			key_len = xform->auth.key.length;
+		} else
+			return 0;
+
+		params[5] = key_len;
+
+		if (len + sizeof(params) + key_len >
+				RTE_CRYPTODEV_SYM_SESSION_SIG_MAX ||
+				(key == NULL && key_len != 0))
+			return 0;
+
+		memcpy(&sig[len], params, sizeof(params));
+		len += sizeof(params);
+		if (key_len != 0)
+			memcpy(&sig[len], key, key_len);
+		len += key_len;
+	}
+
+	return len;
+}
+
+/** FNV-1a hash of a transform chain signature */
+static uint32_t
+rte_cryptodev_sym_xform_sig_hash(const uint8_t *sig, uint32_t len)
+{
+	uint32_t hash = 2166136261u;
+	uint32_t i;
+
+	for (i = 0; i < len; i++) {
+		hash ^= sig[i];
+		hash *= 16777619u;
+	}
+
+	return hash;
+}
+
+/**
+ * Configure the private data of a session, copying it from the session
+ * cache of the device when it holds the same transform chain.
+ */
+static int
+rte_cryptodev_sym_session_configure(struct rte_cryptodev *dev,
+		struct rte_crypto_sym_xform *xform,
+		struct rte_cryptodev_sym_session *sess)
+{
+	struct rte_cryptodev_sym_session_cache *cache =
+			dev->data->session_cache;
+	struct rte_cryptodev_sym_session_cache_entry *entry;
+	uint8_t sig[RTE_CRYPTODEV_SYM_SESSION_SIG_MAX];
+	uint32_t sig_len = 0, hash;
+	int ret = 0;
+
+	if (cache != NULL)
+		sig_len = rte_cryptodev_sym_xform_sig(xform, sig);
+
+	if (sig_len == 0) {
+		if (dev->dev_ops->session_configure(dev, xform,
+				sess->_private) == NULL)
+			return -EINVAL;
+		return 0;
+	}
+
+	hash = rte_cryptodev_sym_xform_sig_hash(sig, sig_len);
+	entry = &cache->entries[hash & (RTE_CRYPTODEV_SYM_SESSION_CACHE_SIZE
+			- 1)];
+
+	rte_spinlock_lock(&cache->lock);
+
+	if (entry->sig_len == sig_len && entry->hash == hash &&
+			memcmp(entry->sig, sig, sig_len) == 0 &&
+			dev->dev_ops->session_copy(dev, sess->_private,
+				entry->priv) == 0)
+		goto unlock;
+
+	if (dev->dev_ops->session_configure(dev, xform,
+			sess->_private) == NULL) {
+		ret = -EINVAL;
+		goto unlock;
+	}
+
+	/* Replace the entry with the new transform chain */
+	rte_cryptodev_sym_session_cache_clear(dev, entry);
+	if (dev->dev_ops->session_copy(dev, entry->priv,
+			sess->_private) == 0) {
+		memcpy(entry->sig, sig, sig_len);
+		entry->sig_len = sig_len;
+		entry->hash = hash;
+	}
+
+unlock:
+	rte_spinlock_unlock(&cache->lock);
+	memset(sig, 0, sig_len);
+
+	return ret;
+}
+
 static int
 rte_cryptodev_sym_session_pool_create(struct rte_cryptodev *dev,
 		unsigned nb_objs, unsigned obj_cache_size, int socket_id)
@@ -1018,7 +1265,9 @@ rte_cryptodev_sym_session_pool_create(struct rte_cryptodev *dev,
 	}
 
 	CDEV_LOG_DEBUG("%s mempool created!", mp_name);
-	return 0;
+
+	return rte_cryptodev_sym_session_cache_create(dev, priv_sess_size,
+			socket_id);
 }
 
 struct rte_cryptodev_sym_session *
@@ -1045,8 +1294,7 @@ rte_cryptodev_sym_session_create(uint8_t dev_id,
 	sess = (struct rte_cryptodev_sym_session *)_sess;
 
 	RTE_FUNC_PTR_OR_ERR_RET(*dev->dev_ops->session_configure, NULL);
-	if (dev->dev_ops->session_configure(dev, xform, sess->_private) ==
-			NULL) {
+	if (rte_cryptodev_sym_session_configure(dev, xform, sess) != 0) {
 		CDEV_LOG_ERR("dev_id %d failed to configure session details",
 				dev_id);
 
@@ -1085,6 +1333,108 @@ rte_cryptodev_sym_session_free(uint8_t dev_id,
 	return NULL;
 }
 
+int
+rte_cryptodev_sym_session_create_bulk(uint8_t dev_id,
+		struct rte_crypto_sym_xform **xforms,
+		struct rte_cryptodev_sym_session **sessions,
+		unsigned nb_sessions)
+{
+	struct rte_cryptodev *dev;
+	unsigned i, j;
+
+	if (!rte_cryptodev_pmd_is_valid_dev(dev_id)) {
+		CDEV_LOG_ERR("Invalid dev_id=%d", dev_id);
+		return -EINVAL;
+	}
+
+	if (xforms == NULL || sessions == NULL) {
+		CDEV_LOG_ERR("Invalid xforms or sessions array");
+		return -EINVAL;
+	}
+
+	if (nb_sessions == 0)
+		return 0;
+
+	dev = &rte_crypto_devices[dev_id];
+
+	RTE_FUNC_PTR_OR_ERR_RET(*dev->dev_ops->session_configure, -ENOTSUP);
+	RTE_FUNC_PTR_OR_ERR_RET(*dev->dev_ops->session_clear, -ENOTSUP);
+
+	/* Allocate all the session structures from the session pool at once */
+	if (dev->data->session_pool == NULL ||
+			rte_mempool_get_bulk(dev->data->session_pool,
+				(void **)sessions, nb_sessions)) {
+		CDEV_LOG_ERR("Couldn't get %u objects from session mempool",
+				nb_sessions);
+		return -ENOMEM;
+	}
+
+	for (i = 0; i < nb_sessions; i++) {
+		if (rte_cryptodev_sym_session_configure(dev, xforms[i],
+				sessions[i]) != 0) {
+			CDEV_LOG_ERR("dev_id %d failed to configure session "
+					"%u details", dev_id, i);
+
+			/* Clear the sessions configured so far */
+			for (j = 0; j < i; j++)
+				dev->dev_ops->session_clear(dev,
+						sessions[j]->_private);
+
+			/* Return sessions to mempool */
+			rte_mempool_put_bulk(dev->data->session_pool,
+					(void **)sessions, nb_sessions);
+			return -EINVAL;
+		}
+	}
+
+	return 0;
+}
+
+int
+rte_cryptodev_sym_session_free_bulk(uint8_t dev_id,
+		struct rte_cryptodev_sym_session **sessions,
+		unsigned nb_sessions)
+{
+	struct rte_cryptodev *dev;
+	unsigned i;
+
+	if (!rte_cryptodev_pmd_is_valid_dev(dev_id)) {
+		CDEV_LOG_ERR("Invalid dev_id=%d", dev_id);
+		return -EINVAL;
+	}
+
+	if (sessions == NULL) {
+		CDEV_LOG_ERR("Invalid sessions array");
+		return -EINVAL;
+	}
+
+	if (nb_sessions == 0)
+		return 0;
+
+	dev = &rte_crypto_devices[dev_id];
+
+	/* Check the sessions belong to this device type and mempool */
+	for (i = 0; i < nb_sessions; i++) {
+		if (sessions[i] == NULL ||
+				sessions[i]->dev_type != dev->dev_type ||
+				sessions[i]->mp != sessions[0]->mp) {
+			CDEV_LOG_ERR("Session %u does not belong to dev_id %d",
+					i, dev_id);
+			return -EINVAL;
+		}
+	}
+
+	/* Let device implementation clear session material */
+	RTE_FUNC_PTR_OR_ERR_RET(*dev->dev_ops->session_clear, -ENOTSUP);
+	for (i = 0; i < nb_sessions; i++)
+		dev->dev_ops->session_clear(dev, sessions[i]->_private);
+
+	/* Return sessions to mempool */
+	rte_mempool_put_bulk(sessions[0]->mp, (void **)sessions, nb_sessions);
+
+	return 0;
+}
+
 /** Initialise rte_crypto_op mempool element */
 static void
 rte_crypto_op_init(struct rte_mempool *mempool,
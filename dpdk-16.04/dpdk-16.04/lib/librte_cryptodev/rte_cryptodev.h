@@ -59,6 +59,10 @@ extern "C" {
 /**< Intel QAT Symmetric Crypto PMD device name */
 #define CRYPTODEV_NAME_SNOW3G_PMD	("cryptodev_snow3g_pmd")
 /**< SNOW 3G PMD device name */
+#define CRYPTODEV_NAME_SCHEDULER_PMD	("cryptodev_scheduler_pmd")
+/**< Scheduler PMD device name */
+#define CRYPTODEV_NAME_OPENSSL_PMD	("cryptodev_openssl_pmd")
+/**< OpenSSL PMD device name */
 
 /** Crypto device type */
 enum rte_cryptodev_type {
@@ -67,6 +71,8 @@ enum rte_cryptodev_type {
 	RTE_CRYPTODEV_AESNI_MB_PMD,	/**< AES-NI multi buffer PMD */
 	RTE_CRYPTODEV_QAT_SYM_PMD,	/**< QAT PMD Symmetric Crypto */
 	RTE_CRYPTODEV_SNOW3G_PMD,	/**< SNOW 3G PMD */
+	RTE_CRYPTODEV_SCHEDULER_PMD,	/**< Scheduler PMD */
+	RTE_CRYPTODEV_OPENSSL_PMD,	/**< OpenSSL PMD */
 };
 
 extern const char **rte_cyptodev_names;
@@ -718,6 +724,8 @@ struct rte_cryptodev {
  * This structure is safe to place in shared memory to be common among
  * different processes in a multi-process configuration.
  */
+struct rte_cryptodev_sym_session_cache;
+
 struct rte_cryptodev_data {
 	uint8_t dev_id;
 	/**< Device ID for this instance */
@@ -738,6 +746,9 @@ struct rte_cryptodev_data {
 
 	void *dev_private;
 	/**< PMD-specific private data */
+
+	struct rte_cryptodev_sym_session_cache *session_cache;
+	/**< Configured sessions, looked up by transform chain */
 } __rte_cache_aligned;
 
 extern struct rte_cryptodev *rte_cryptodevs;
@@ -888,6 +899,67 @@ extern struct rte_cryptodev_sym_session *
 rte_cryptodev_sym_session_free(uint8_t dev_id,
 		struct rte_cryptodev_sym_session *session);
 
+/**
+ * Initialise several sessions for symmetric cryptographic operations.
+ *
+ * The sessions are taken from the session mempool of the device with a
+ * single bulk get, then each session is configured with its transform
+ * chain. Either all the sessions are created, or none of them.
+ *
+ * When the PMD supports it, the device keeps a cache of the last configured
+ * transform chains, with their keys: a session created with the same
+ * transform chain as a cached one is copied from it instead of expanding
+ * its keys again. The size of the cache is set by
+ * CONFIG_RTE_CRYPTODEV_SYM_SESSION_CACHE_SIZE.
+ *
+ * @param	dev_id		The device identifier.
+ * @param	xforms		Array of *nb_sessions* crypto transform chains.
+ * @param	sessions	Array of *nb_sessions* pointers, filled with the
+ *				created sessions, sessions[i] being configured
+ *				with xforms[i].
+ * @param	nb_sessions	Number of sessions to create.
+ *
+ * @return
+ *   - 0: Success, all the sessions are created.
+ *   - -EINVAL: Invalid parameters, or a transform chain is not supported.
+ *   - -ENOMEM: Not enough free sessions in the session mempool.
+ *   - -ENOTSUP: The device does not support sessions.
+ */
+extern int
+rte_cryptodev_sym_session_create_bulk(uint8_t dev_id,
+		struct rte_crypto_sym_xform **xforms,
+		struct rte_cryptodev_sym_session **sessions,
+		unsigned nb_sessions);
+
+/**
+ * Free several sessions, previously allocated by
+ * *rte_cryptodev_sym_session_create* or
+ * *rte_cryptodev_sym_session_create_bulk*, with a single mempool bulk put.
+ *
+ * @param	dev_id		The device identifier.
+ * @param	sessions	Array of *nb_sessions* session pointers.
+ * @param	nb_sessions	Number of sessions to free.
+ *
+ * @return
+ *   - 0: Success, all the sessions are freed.
+ *   - -EINVAL: Invalid parameters, or a session does not belong to the
+ *     device. No session is freed.
+ */
+extern int
+rte_cryptodev_sym_session_free_bulk(uint8_t dev_id,
+		struct rte_cryptodev_sym_session **sessions,
+		unsigned nb_sessions);
+
+/**
+ * Flush the session cache of a device, so that it keeps no copy of the keys
+ * of the transform chains it was configured with, e.g. after a rekey. The
+ * sessions already created are not affected.
+ *
+ * @param	dev_id		The device identifier.
+ */
+extern void
+rte_cryptodev_sym_session_cache_flush(uint8_t dev_id);
+
 
 #ifdef __cplusplus
 }
@@ -410,6 +410,25 @@ typedef void * (*cryptodev_sym_configure_session_t)(struct rte_cryptodev *dev,
 typedef void (*cryptodev_sym_free_session_t)(struct rte_cryptodev *dev,
 		void *session_private);
 
+/**
+ * Copy a configured Crypto session to another session of the device, without
+ * parsing the xforms and expanding the keys again.
+ *
+ * The source is either a session of the device session mempool, or a copy
+ * kept by the session cache of the device, which is not initialized by
+ * *session_initialize*.
+ *
+ * @param	dev		Crypto device pointer
+ * @param	dst		Pointer to the private session to configure
+ * @param	src		Pointer to the configured private session
+ *
+ * @return
+ *  - Returns 0 on success.
+ *  - Returns a negative value on failure.
+ */
+typedef int (*cryptodev_sym_copy_session_t)(struct rte_cryptodev *dev,
+		void *dst, const void *src);
+
 
 /** Crypto device operations function pointer table */
 struct rte_cryptodev_ops {
@@ -444,6 +463,8 @@ struct rte_cryptodev_ops {
 	/**< Configure a Crypto session. */
 	cryptodev_sym_free_session_t session_clear;
 	/**< Clear a Crypto sessions private data. */
+	cryptodev_sym_copy_session_t session_copy;
+	/**< Copy a Crypto session, optional, enables the session cache. */
 };
 
 
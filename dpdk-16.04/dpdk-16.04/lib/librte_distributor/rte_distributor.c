@@ -61,6 +61,10 @@
 #define RTE_DISTRIB_MAX_RETURNS 128
 #define RTE_DISTRIB_RETURNS_MASK (RTE_DISTRIB_MAX_RETURNS - 1)
 
+/* marks a reorder window slot whose packet was not handed back by its worker,
+ * i.e. the worker dropped or consumed it. Such slots are skipped on return. */
+#define RTE_DISTRIB_SEQN_DROPPED ((struct rte_mbuf *)(uintptr_t)1)
+
 /**
  * Maximum number of workers allowed.
  * Be aware of increasing the limit, becaus it is limited by how we track
@@ -92,6 +96,18 @@ struct rte_distributor_returned_pkts {
 	struct rte_mbuf *mbufs[RTE_DISTRIB_MAX_RETURNS];
 };
 
+/* state used in ordered mode to hand packets back in ingress order */
+struct rte_distributor_order {
+	uint32_t window_size;    /**< Number of slots in the reorder window */
+	uint32_t window_mask;    /**< window_size - 1 */
+	uint32_t next_seqn;      /**< Sequence number for the next new packet */
+	uint32_t head_seqn;      /**< Oldest sequence number not yet returned */
+	uint64_t worker_mask;    /**< Workers holding a sequenced packet */
+	uint32_t worker_seqn[RTE_DISTRIB_MAX_WORKERS];
+		/**< Sequence number of the packet held by each worker */
+	struct rte_mbuf **window; /**< Completed packets, indexed by seqn */
+};
+
 struct rte_distributor {
 	TAILQ_ENTRY(rte_distributor) next;    /**< Next in list. */
 
@@ -111,6 +127,8 @@ struct rte_distributor {
 	union rte_distributor_buffer bufs[RTE_DISTRIB_MAX_WORKERS];
 
 	struct rte_distributor_returned_pkts returns;
+
+	struct rte_distributor_order order; /**< Ordered mode state */
 };
 
 TAILQ_HEAD(rte_distributor_list, rte_distributor);
@@ -203,6 +221,38 @@ store_return(uintptr_t oldbuf, struct rte_distributor *d,
 	*ret_count += (*ret_count != RTE_DISTRIB_RETURNS_MASK) & !!(oldbuf);
 }
 
+/* in ordered mode, records the completion of the packet held by a worker in
+ * the reorder window. A NULL oldbuf means the worker did not hand the packet
+ * back, so its slot is marked as dropped to avoid stalling the window.
+ */
+static inline void
+order_complete(struct rte_distributor *d, unsigned wkr, uintptr_t oldbuf)
+{
+	struct rte_distributor_order *o = &d->order;
+
+	if (!(o->worker_mask & (1UL << wkr)))
+		return;
+
+	o->window[o->worker_seqn[wkr] & o->window_mask] = oldbuf ?
+			(struct rte_mbuf *)oldbuf : RTE_DISTRIB_SEQN_DROPPED;
+	o->worker_mask &= ~(1UL << wkr);
+}
+
+/* in ordered mode, notes the sequence number of a packet given to a worker */
+static inline void
+order_assign(struct rte_distributor *d, unsigned wkr, int64_t pktval)
+{
+	struct rte_mbuf *mb = (void *)((uintptr_t)(pktval >>
+			RTE_DISTRIB_FLAG_BITS));
+
+	d->order.worker_seqn[wkr] = mb->seqn;
+	d->order.worker_mask |= (1UL << wkr);
+}
+
+static int
+distributor_process(struct rte_distributor *d,
+		struct rte_mbuf **mbufs, unsigned num_mbufs);
+
 static inline void
 handle_worker_shutdown(struct rte_distributor *d, unsigned wkr)
 {
@@ -231,10 +281,11 @@ handle_worker_shutdown(struct rte_distributor *d, unsigned wkr)
 					RTE_DISTRIB_FLAG_BITS));
 		}
 		/* recursive call.
-		 * Note that the tags were set before first level call
-		 * to rte_distributor_process.
+		 * Note that the tags, and in ordered mode the sequence
+		 * numbers, were set before first level call to
+		 * rte_distributor_process.
 		 */
-		rte_distributor_process(d, pkts, i);
+		distributor_process(d, pkts, i);
 		bl->count = bl->start = 0;
 	}
 }
@@ -250,6 +301,7 @@ process_returns(struct rte_distributor *d)
 	unsigned flushed = 0;
 	unsigned ret_start = d->returns.start,
 			ret_count = d->returns.count;
+	const int ordered = d->order.window != NULL;
 
 	for (wkr = 0; wkr < d->num_workers; wkr++) {
 
@@ -258,21 +310,29 @@ process_returns(struct rte_distributor *d)
 
 		if (data & RTE_DISTRIB_GET_BUF) {
 			flushed++;
-			if (d->backlog[wkr].count)
+			oldbuf = data >> RTE_DISTRIB_FLAG_BITS;
+			if (ordered)
+				order_complete(d, wkr, oldbuf);
+			if (d->backlog[wkr].count) {
 				d->bufs[wkr].bufptr64 =
 						backlog_pop(&d->backlog[wkr]);
-			else {
+				if (ordered)
+					order_assign(d, wkr,
+						d->bufs[wkr].bufptr64);
+			} else {
 				d->bufs[wkr].bufptr64 = RTE_DISTRIB_GET_BUF;
 				d->in_flight_tags[wkr] = 0;
 				d->in_flight_bitmask &= ~(1UL << wkr);
 			}
-			oldbuf = data >> RTE_DISTRIB_FLAG_BITS;
 		} else if (data & RTE_DISTRIB_RETURN_BUF) {
-			handle_worker_shutdown(d, wkr);
 			oldbuf = data >> RTE_DISTRIB_FLAG_BITS;
+			if (ordered)
+				order_complete(d, wkr, oldbuf);
+			handle_worker_shutdown(d, wkr);
 		}
 
-		store_return(oldbuf, d, &ret_start, &ret_count);
+		if (!ordered)
+			store_return(oldbuf, d, &ret_start, &ret_count);
 	}
 
 	d->returns.start = ret_start;
@@ -281,9 +341,10 @@ process_returns(struct rte_distributor *d)
 	return flushed;
 }
 
-/* process a set of packets to distribute them to workers */
-int
-rte_distributor_process(struct rte_distributor *d,
+/* distribute a set of packets to workers. In ordered mode the packets must
+ * already carry their sequence numbers. */
+static int
+distributor_process(struct rte_distributor *d,
 		struct rte_mbuf **mbufs, unsigned num_mbufs)
 {
 	unsigned next_idx = 0;
@@ -293,9 +354,7 @@ rte_distributor_process(struct rte_distributor *d,
 	uint32_t new_tag = 0;
 	unsigned ret_start = d->returns.start,
 			ret_count = d->returns.count;
-
-	if (unlikely(num_mbufs == 0))
-		return process_returns(d);
+	const int ordered = d->order.window != NULL;
 
 	while (next_idx < num_mbufs || next_mb != NULL) {
 
@@ -345,6 +404,10 @@ rte_distributor_process(struct rte_distributor *d,
 		if ((data & RTE_DISTRIB_GET_BUF) &&
 				(d->backlog[wkr].count || next_mb)) {
 
+			oldbuf = data >> RTE_DISTRIB_FLAG_BITS;
+			if (ordered)
+				order_complete(d, wkr, oldbuf);
+
 			if (d->backlog[wkr].count)
 				d->bufs[wkr].bufptr64 =
 						backlog_pop(&d->backlog[wkr]);
@@ -355,14 +418,19 @@ rte_distributor_process(struct rte_distributor *d,
 				d->in_flight_bitmask |= (1UL << wkr);
 				next_mb = NULL;
 			}
-			oldbuf = data >> RTE_DISTRIB_FLAG_BITS;
+			if (ordered)
+				order_assign(d, wkr, d->bufs[wkr].bufptr64);
 		} else if (data & RTE_DISTRIB_RETURN_BUF) {
-			handle_worker_shutdown(d, wkr);
 			oldbuf = data >> RTE_DISTRIB_FLAG_BITS;
+			if (ordered)
+				order_complete(d, wkr, oldbuf);
+			handle_worker_shutdown(d, wkr);
 		}
 
-		/* store returns in a circular buffer */
-		store_return(oldbuf, d, &ret_start, &ret_count);
+		/* store returns in a circular buffer, unless they are
+		 * held in the reorder window */
+		if (!ordered)
+			store_return(oldbuf, d, &ret_start, &ret_count);
 
 		if (++wkr == d->num_workers)
 			wkr = 0;
@@ -375,9 +443,14 @@ rte_distributor_process(struct rte_distributor *d,
 
 			int64_t oldbuf = d->bufs[wkr].bufptr64 >>
 					RTE_DISTRIB_FLAG_BITS;
-			store_return(oldbuf, d, &ret_start, &ret_count);
+			if (ordered)
+				order_complete(d, wkr, oldbuf);
+			else
+				store_return(oldbuf, d, &ret_start, &ret_count);
 
 			d->bufs[wkr].bufptr64 = backlog_pop(&d->backlog[wkr]);
+			if (ordered)
+				order_assign(d, wkr, d->bufs[wkr].bufptr64);
 		}
 
 	d->returns.start = ret_start;
@@ -385,16 +458,76 @@ rte_distributor_process(struct rte_distributor *d,
 	return num_mbufs;
 }
 
+/* process a set of packets to distribute them to workers */
+int
+rte_distributor_process(struct rte_distributor *d,
+		struct rte_mbuf **mbufs, unsigned num_mbufs)
+{
+	struct rte_distributor_order *o = &d->order;
+	unsigned i;
+
+	if (unlikely(num_mbufs == 0))
+		return process_returns(d);
+
+	if (o->window != NULL) {
+		/* only accept as many packets as fit in the reorder window,
+		 * and stamp them with their sequence numbers. */
+		unsigned free_slots = o->window_size -
+				(o->next_seqn - o->head_seqn);
+
+		if (num_mbufs > free_slots) {
+			num_mbufs = free_slots;
+			if (num_mbufs == 0) {
+				/* window full: only gather completions */
+				process_returns(d);
+				return 0;
+			}
+		}
+		for (i = 0; i < num_mbufs; i++)
+			mbufs[i]->seqn = o->next_seqn++;
+	}
+
+	return distributor_process(d, mbufs, num_mbufs);
+}
+
+/* return to the caller, in ingress order, the completed packets at the head
+ * of the reorder window */
+static int
+order_returned_pkts(struct rte_distributor_order *o,
+		struct rte_mbuf **mbufs, unsigned max_mbufs)
+{
+	unsigned retval = 0;
+
+	while (retval < max_mbufs && o->head_seqn != o->next_seqn) {
+		const unsigned idx = o->head_seqn & o->window_mask;
+		struct rte_mbuf *mb = o->window[idx];
+
+		if (mb == NULL)
+			break;
+		if (mb != RTE_DISTRIB_SEQN_DROPPED)
+			mbufs[retval++] = mb;
+		o->window[idx] = NULL;
+		o->head_seqn++;
+	}
+
+	return retval;
+}
+
 /* return to the caller, packets returned from workers */
 int
 rte_distributor_returned_pkts(struct rte_distributor *d,
 		struct rte_mbuf **mbufs, unsigned max_mbufs)
 {
 	struct rte_distributor_returned_pkts *returns = &d->returns;
-	unsigned retval = (max_mbufs < returns->count) ?
-			max_mbufs : returns->count;
+	unsigned retval;
 	unsigned i;
 
+	if (d->order.window != NULL)
+		return order_returned_pkts(&d->order, mbufs, max_mbufs);
+
+	retval = (max_mbufs < returns->count) ?
+			max_mbufs : returns->count;
+
 	for (i = 0; i < retval; i++) {
 		unsigned idx = (returns->start + i) & RTE_DISTRIB_RETURNS_MASK;
 		mbufs[i] = returns->mbufs[idx];
@@ -437,17 +570,27 @@ rte_distributor_flush(struct rte_distributor *d)
 void
 rte_distributor_clear_returns(struct rte_distributor *d)
 {
+	struct rte_distributor_order *o = &d->order;
+
+	/* in ordered mode, discard the completed packets at the head of the
+	 * window; packets still held by workers keep their slots */
+	while (o->window != NULL && o->head_seqn != o->next_seqn &&
+			o->window[o->head_seqn & o->window_mask] != NULL)
+		o->window[o->head_seqn++ & o->window_mask] = NULL;
+
 	d->returns.start = d->returns.count = 0;
 #ifndef __OPTIMIZE__
 	memset(d->returns.mbufs, 0, sizeof(d->returns.mbufs));
 #endif
 }
 
-/* creates a distributor instance */
-struct rte_distributor *
-rte_distributor_create(const char *name,
+/* creates a distributor instance, with a reorder window of window_size
+ * packets in ordered mode or no window when window_size is 0 */
+static struct rte_distributor *
+distributor_create(const char *name,
 		unsigned socket_id,
-		unsigned num_workers)
+		unsigned num_workers,
+		unsigned window_size)
 {
 	struct rte_distributor *d;
 	struct rte_distributor_list *distributor_list;
@@ -466,7 +609,9 @@ rte_distributor_create(const char *name,
 	}
 
 	snprintf(mz_name, sizeof(mz_name), RTE_DISTRIB_PREFIX"%s", name);
-	mz = rte_memzone_reserve(mz_name, sizeof(*d), socket_id, NO_FLAGS);
+	mz = rte_memzone_reserve(mz_name, sizeof(*d) +
+			window_size * sizeof(d->order.window[0]),
+			socket_id, NO_FLAGS);
 	if (mz == NULL) {
 		rte_errno = ENOMEM;
 		return NULL;
@@ -476,6 +621,13 @@ rte_distributor_create(const char *name,
 	snprintf(d->name, sizeof(d->name), "%s", name);
 	d->num_workers = num_workers;
 
+	if (window_size != 0) {
+		/* the window immediately follows the distributor structure */
+		d->order.window = (struct rte_mbuf **)(d + 1);
+		d->order.window_size = window_size;
+		d->order.window_mask = window_size - 1;
+	}
+
 	distributor_list = RTE_TAILQ_CAST(rte_distributor_tailq.head,
 					  rte_distributor_list);
 
@@ -485,3 +637,28 @@ rte_distributor_create(const char *name,
 
 	return d;
 }
+
+/* creates a distributor instance */
+struct rte_distributor *
+rte_distributor_create(const char *name,
+		unsigned socket_id,
+		unsigned num_workers)
+{
+	return distributor_create(name, socket_id, num_workers, 0);
+}
+
+/* creates a distributor instance returning packets in ingress order */
+struct rte_distributor *
+rte_distributor_create_ordered(const char *name,
+		unsigned socket_id,
+		unsigned num_workers,
+		unsigned window_size)
+{
+	if (window_size == 0 || !rte_is_power_of_2(window_size) ||
+			window_size > RTE_DISTRIBUTOR_MAX_WINDOW_SIZE) {
+		rte_errno = EINVAL;
+		return NULL;
+	}
+
+	return distributor_create(name, socket_id, num_workers, window_size);
+}
@@ -47,6 +47,8 @@ extern "C" {
 #endif
 
 #define RTE_DISTRIBUTOR_NAMESIZE 32 /**< Length of name for instance */
+#define RTE_DISTRIBUTOR_MAX_WINDOW_SIZE (1 << 16)
+/**< Maximum size of the reorder window of an ordered distributor */
 
 struct rte_distributor;
 struct rte_mbuf;
@@ -71,6 +73,39 @@ struct rte_distributor *
 rte_distributor_create(const char *name, unsigned socket_id,
 		unsigned num_workers);
 
+/**
+ * Function to create a new distributor instance in ordered mode
+ *
+ * An ordered distributor stamps each packet passed to
+ * rte_distributor_process() with a sequence number in the mbuf seqn field,
+ * and rte_distributor_returned_pkts() gives the packets returned by workers
+ * back in that same order. Packets are tracked in a fixed-size reorder
+ * window, so no separate rte_reorder buffer is needed.
+ *
+ * A packet for which the worker does not return a buffer, i.e. it passes a
+ * NULL oldpkt when requesting or returning, is considered dropped and is
+ * skipped on return. Once the window is full, rte_distributor_process()
+ * only accepts new packets after earlier ones have been retrieved through
+ * rte_distributor_returned_pkts().
+ *
+ * @param name
+ *   The name to be given to the distributor instance.
+ * @param socket_id
+ *   The NUMA node on which the memory is to be allocated
+ * @param num_workers
+ *   The maximum number of workers that will request packets from this
+ *   distributor
+ * @param window_size
+ *   The number of packets tracked in the reorder window. Must be a power
+ *   of two, no larger than RTE_DISTRIBUTOR_MAX_WINDOW_SIZE.
+ * @return
+ *   The newly created distributor instance, or NULL on error with rte_errno
+ *   set appropriately
+ */
+struct rte_distributor *
+rte_distributor_create_ordered(const char *name, unsigned socket_id,
+		unsigned num_workers, unsigned window_size);
+
 /*  *** APIS to be called on the distributor lcore ***  */
 /*
  * The following APIs are the public APIs which are designed for use on a
@@ -100,7 +135,9 @@ rte_distributor_create(const char *name, unsigned socket_id,
  * @param num_mbufs
  *   The number of mbufs in the mbufs array
  * @return
- *   The number of mbufs processed.
+ *   The number of mbufs processed. For an ordered distributor this may be
+ *   less than num_mbufs when the reorder window is full, in which case the
+ *   remaining mbufs should be passed again in a later call.
  */
 int
 rte_distributor_process(struct rte_distributor *d,
@@ -109,6 +146,9 @@ rte_distributor_process(struct rte_distributor *d,
 /**
  * Get a set of mbufs that have been returned to the distributor by workers
  *
+ * For an ordered distributor the mbufs are returned in the order in which
+ * they were passed to rte_distributor_process().
+ *
  * This should only be called on the same lcore as rte_distributor_process()
  *
  * @param d
@@ -68,6 +68,11 @@
  */
 #define RTE_KNI_NAMESIZE 32
 
+/**
+ * Maximum number of queues of a KNI device.
+ */
+#define RTE_KNI_MAX_QUEUES 16
+
 #define RTE_CACHE_LINE_MIN_SIZE 64
 
 /*
@@ -125,6 +130,16 @@ struct rte_kni_mbuf {
 	void *next;
 };
 
+/*
+ * FIFOs of a queue of a KNI device.
+ */
+struct rte_kni_queue_info {
+	phys_addr_t tx_phys;
+	phys_addr_t rx_phys;
+	phys_addr_t alloc_phys;
+	phys_addr_t free_phys;
+};
+
 /*
  * Struct used to create a KNI device. Passed to the kernel in IOCTL call
  */
@@ -132,10 +147,8 @@ struct rte_kni_mbuf {
 struct rte_kni_device_info {
 	char name[RTE_KNI_NAMESIZE];  /**< Network device name for KNI */
 
-	phys_addr_t tx_phys;
-	phys_addr_t rx_phys;
-	phys_addr_t alloc_phys;
-	phys_addr_t free_phys;
+	uint16_t nb_queues;           /**< Number of queues */
+	struct rte_kni_queue_info queues[RTE_KNI_MAX_QUEUES];
 
 	/* Used by Ethtool */
 	phys_addr_t req_phys;
@@ -39,6 +39,37 @@
 #include <exec-env/rte_kni_common.h>
 #define KNI_KTHREAD_RESCHEDULE_INTERVAL 5 /* us */
 
+struct kni_dev;
+
+/**
+ * A queue of a kni device: its fifos, the statistics of its packets and,
+ * in multiple kernel thread mode, its kernel thread.
+ */
+struct kni_queue {
+	struct kni_dev *kni;
+	unsigned id;                 /* Queue index */
+	struct task_struct *pthread;
+
+	/* queue for packets to be sent out */
+	void *tx_q;
+
+	/* queue for the packets received */
+	void *rx_q;
+
+	/* queue for the allocated mbufs those can be used to save sk buffs */
+	void *alloc_q;
+
+	/* free queue for the mbufs to be freed */
+	void *free_q;
+
+	unsigned long rx_packets;
+	unsigned long rx_bytes;
+	unsigned long rx_dropped;
+	unsigned long tx_packets;
+	unsigned long tx_bytes;
+	unsigned long tx_dropped;
+};
+
 /**
  * A structure describing the private information for a kni device.
  */
@@ -52,7 +83,6 @@ struct kni_dev {
 	uint16_t group_id;           /* Group ID of a group of KNI devices */
 	unsigned core_id;            /* Core ID to bind */
 	char name[RTE_KNI_NAMESIZE]; /* Network device name */
-	struct task_struct *pthread;
 
 	/* wait queue for req/resp */
 	wait_queue_head_t wq;
@@ -66,17 +96,9 @@ struct kni_dev {
 	struct net_device *lad_dev;
 	struct pci_dev *pci_dev;
 
-	/* queue for packets to be sent out */
-	void *tx_q;
-
-	/* queue for the packets received */
-	void *rx_q;
-
-	/* queue for the allocated mbufs those can be used to save sk buffs */
-	void *alloc_q;
-
-	/* free queue for the mbufs to be freed */
-	void *free_q;
+	/* packet queues */
+	unsigned nb_queues;
+	struct kni_queue queues[RTE_KNI_MAX_QUEUES];
 
 	/* request queue */
 	void *req_q;
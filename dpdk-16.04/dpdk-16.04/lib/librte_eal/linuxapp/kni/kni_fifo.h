@@ -29,48 +29,65 @@
 
 /**
  * Adds num elements into the fifo. Return the number actually written
+ *
+ * The elements are copied in bulk, in at most two parts when wrapping
+ * around the end of the buffer, and the write index is updated once.
  */
 static inline unsigned
 kni_fifo_put(struct rte_kni_fifo *fifo, void **data, unsigned num)
 {
-	unsigned i = 0;
 	unsigned fifo_write = fifo->write;
 	unsigned fifo_read = fifo->read;
-	unsigned new_write = fifo_write;
+	unsigned mask = fifo->len - 1;
+	void **buffer = (void **)(uintptr_t)fifo->buffer;
+	unsigned n, first;
+
+	/* One entry is always left empty: write == read means empty */
+	n = min((fifo_read - fifo_write - 1) & mask, num);
+	if (n == 0)
+		return 0;
 
-	for (i = 0; i < num; i++) {
-		new_write = (new_write + 1) & (fifo->len - 1);
+	first = min(fifo->len - fifo_write, n);
+	memcpy(buffer + fifo_write, data, first * sizeof(void *));
+	memcpy(buffer, data + first, (n - first) * sizeof(void *));
 
-		if (new_write == fifo_read)
-			break;
-		fifo->buffer[fifo_write] = data[i];
-		fifo_write = new_write;
-	}
-	fifo->write = fifo_write;
+	/* The elements are written before they are published */
+	smp_wmb();
+	fifo->write = (fifo_write + n) & mask;
 
-	return i;
+	return n;
 }
 
 /**
  * Get up to num elements from the fifo. Return the number actully read
+ *
+ * The elements are copied in bulk, in at most two parts when wrapping
+ * around the end of the buffer, and the read index is updated once.
  */
 static inline unsigned
 kni_fifo_get(struct rte_kni_fifo *fifo, void **data, unsigned num)
 {
-	unsigned i = 0;
-	unsigned new_read = fifo->read;
+	unsigned fifo_read = fifo->read;
 	unsigned fifo_write = fifo->write;
+	unsigned mask = fifo->len - 1;
+	void **buffer = (void **)(uintptr_t)fifo->buffer;
+	unsigned n, first;
+
+	/* The elements are read after the write index publishing them */
+	smp_rmb();
+	n = min((fifo_write - fifo_read) & mask, num);
+	if (n == 0)
+		return 0;
 
-	for (i = 0; i < num; i++) {
-		if (new_read == fifo_write)
-			break;
+	first = min(fifo->len - fifo_read, n);
+	memcpy(data, buffer + fifo_read, first * sizeof(void *));
+	memcpy(data + first, buffer, (n - first) * sizeof(void *));
 
-		data[i] = fifo->buffer[new_read];
-		new_read = (new_read + 1) & (fifo->len - 1);
-	}
-	fifo->read = new_read;
+	/* The elements are read before their entries are given back */
+	smp_mb();
+	fifo->read = (fifo_read + n) & mask;
 
-	return i;
+	return n;
 }
 
 /**
@@ -44,7 +44,7 @@ MODULE_DESCRIPTION("Kernel Module for managing kni devices");
 
 #define KNI_MAX_DEVICES 32
 
-extern void kni_net_rx(struct kni_dev *kni);
+extern void kni_net_rx(struct kni_queue *q);
 extern void kni_net_init(struct net_device *dev);
 extern void kni_net_config_lo_mode(char *lo_str);
 extern void kni_net_poll_resp(struct kni_dev *kni);
@@ -62,6 +62,7 @@ static int kni_ioctl(struct inode *inode, unsigned int ioctl_num,
 static int kni_compat_ioctl(struct inode *inode, unsigned int ioctl_num,
 						unsigned long ioctl_param);
 static int kni_dev_remove(struct kni_dev *dev);
+static void kni_dev_stop_threads(struct kni_dev *dev);
 
 static int __init kni_parse_kthread_mode(void);
 
@@ -267,11 +268,8 @@ kni_release(struct inode *inode, struct file *file)
 
 	down_write(&knet->kni_list_lock);
 	list_for_each_entry_safe(dev, n, &knet->kni_list_head, list) {
-		/* Stop kernel thread for multiple mode */
-		if (multiple_kthread_on && dev->pthread != NULL) {
-			kthread_stop(dev->pthread);
-			dev->pthread = NULL;
-		}
+		/* Stop kernel threads for multiple mode */
+		kni_dev_stop_threads(dev);
 
 #ifdef RTE_KNI_VHOST
 		kni_vhost_backend_release(dev);
@@ -296,6 +294,9 @@ kni_thread_single(void *data)
 	struct kni_net *knet = data;
 	int j;
 	struct kni_dev *dev;
+#ifndef RTE_KNI_VHOST
+	unsigned i;
+#endif
 
 	while (!kthread_should_stop()) {
 		down_read(&knet->kni_list_lock);
@@ -304,7 +305,8 @@ kni_thread_single(void *data)
 #ifdef RTE_KNI_VHOST
 				kni_chk_vhost_rx(dev);
 #else
-				kni_net_rx(dev);
+				for (i = 0; i < dev->nb_queues; i++)
+					kni_net_rx(&dev->queues[i]);
 #endif
 				kni_net_poll_resp(dev);
 			}
@@ -320,20 +322,26 @@ kni_thread_single(void *data)
 	return 0;
 }
 
+/*
+ * Kernel thread of a queue in multiple kernel thread mode. The requests of
+ * the device are polled by the thread of its first queue.
+ */
 static int
 kni_thread_multiple(void *param)
 {
 	int j;
-	struct kni_dev *dev = (struct kni_dev *)param;
+	struct kni_queue *q = (struct kni_queue *)param;
+	struct kni_dev *dev = q->kni;
 
 	while (!kthread_should_stop()) {
 		for (j = 0; j < KNI_RX_LOOP_NUM; j++) {
 #ifdef RTE_KNI_VHOST
 			kni_chk_vhost_rx(dev);
 #else
-			kni_net_rx(dev);
+			kni_net_rx(q);
 #endif
-			kni_net_poll_resp(dev);
+			if (q->id == 0)
+				kni_net_poll_resp(dev);
 		}
 #ifdef RTE_KNI_PREEMPT_DEFAULT
 		schedule_timeout_interruptible(usecs_to_jiffies( \
@@ -344,6 +352,22 @@ kni_thread_multiple(void *param)
 	return 0;
 }
 
+static void
+kni_dev_stop_threads(struct kni_dev *dev)
+{
+	unsigned i;
+
+	if (!multiple_kthread_on)
+		return;
+
+	for (i = 0; i < dev->nb_queues; i++) {
+		if (dev->queues[i].pthread != NULL) {
+			kthread_stop(dev->queues[i].pthread);
+			dev->queues[i].pthread = NULL;
+		}
+	}
+}
+
 static int
 kni_dev_remove(struct kni_dev *dev)
 {
@@ -398,6 +422,8 @@ kni_ioctl_create(struct net *net,
 	struct net_device *net_dev = NULL;
 	struct net_device *lad_dev = NULL;
 	struct kni_dev *kni, *dev, *n;
+	struct kni_queue *q;
+	unsigned nb_queues, i;
 
 	printk(KERN_INFO "KNI: Creating kni...\n");
 	/* Check the buffer size, to avoid warning */
@@ -411,14 +437,30 @@ kni_ioctl_create(struct net *net,
 		return -EIO;
 	}
 
+	nb_queues = dev_info.nb_queues;
+	if (nb_queues == 0 || nb_queues > RTE_KNI_MAX_QUEUES) {
+		KNI_ERR("Invalid number of queues %u\n", nb_queues);
+		return -EINVAL;
+	}
+#ifdef RTE_KNI_VHOST
+	if (nb_queues > 1) {
+		KNI_ERR("Multiple queues are not supported with vhost\n");
+		return -EINVAL;
+	}
+#endif
+
 	/**
-	 * Check if the cpu core id is valid for binding,
-	 * for multiple kernel thread mode.
+	 * Check if the cpu core ids are valid for binding,
+	 * for multiple kernel thread mode: the thread of queue i
+	 * is bound to core core_id + i.
 	 */
-	if (multiple_kthread_on && dev_info.force_bind &&
-				!cpu_online(dev_info.core_id)) {
-		KNI_ERR("cpu %u is not online\n", dev_info.core_id);
-		return -EINVAL;
+	for (i = 0; i < nb_queues; i++) {
+		if (multiple_kthread_on && dev_info.force_bind &&
+				!cpu_online(dev_info.core_id + i)) {
+			KNI_ERR("cpu %u is not online\n",
+				dev_info.core_id + i);
+			return -EINVAL;
+		}
 	}
 
 	/* Check if it has been created */
@@ -431,11 +473,12 @@ kni_ioctl_create(struct net *net,
 	}
 	up_read(&knet->kni_list_lock);
 
-	net_dev = alloc_netdev(sizeof(struct kni_dev), dev_info.name,
+	net_dev = alloc_netdev_mqs(sizeof(struct kni_dev), dev_info.name,
 #ifdef NET_NAME_UNKNOWN
 							NET_NAME_UNKNOWN,
 #endif
-							kni_net_init);
+							kni_net_init,
+							nb_queues, nb_queues);
 	if (net_dev == NULL) {
 		KNI_ERR("error allocating device \"%s\"\n", dev_info.name);
 		return -EBUSY;
@@ -451,10 +494,16 @@ kni_ioctl_create(struct net *net,
 	strncpy(kni->name, dev_info.name, RTE_KNI_NAMESIZE);
 
 	/* Translate user space info into kernel space info */
-	kni->tx_q = phys_to_virt(dev_info.tx_phys);
-	kni->rx_q = phys_to_virt(dev_info.rx_phys);
-	kni->alloc_q = phys_to_virt(dev_info.alloc_phys);
-	kni->free_q = phys_to_virt(dev_info.free_phys);
+	kni->nb_queues = nb_queues;
+	for (i = 0; i < nb_queues; i++) {
+		q = &kni->queues[i];
+		q->kni = kni;
+		q->id = i;
+		q->tx_q = phys_to_virt(dev_info.queues[i].tx_phys);
+		q->rx_q = phys_to_virt(dev_info.queues[i].rx_phys);
+		q->alloc_q = phys_to_virt(dev_info.queues[i].alloc_phys);
+		q->free_q = phys_to_virt(dev_info.queues[i].free_phys);
+	}
 
 	kni->req_q = phys_to_virt(dev_info.req_phys);
 	kni->resp_q = phys_to_virt(dev_info.resp_phys);
@@ -470,14 +519,22 @@ kni_ioctl_create(struct net *net,
 #endif
 	kni->mbuf_size = dev_info.mbuf_size;
 
-	KNI_PRINT("tx_phys:      0x%016llx, tx_q addr:      0x%p\n",
-		(unsigned long long) dev_info.tx_phys, kni->tx_q);
-	KNI_PRINT("rx_phys:      0x%016llx, rx_q addr:      0x%p\n",
-		(unsigned long long) dev_info.rx_phys, kni->rx_q);
-	KNI_PRINT("alloc_phys:   0x%016llx, alloc_q addr:   0x%p\n",
-		(unsigned long long) dev_info.alloc_phys, kni->alloc_q);
-	KNI_PRINT("free_phys:    0x%016llx, free_q addr:    0x%p\n",
-		(unsigned long long) dev_info.free_phys, kni->free_q);
+	for (i = 0; i < nb_queues; i++) {
+		q = &kni->queues[i];
+		KNI_PRINT("queue %u:\n", i);
+		KNI_PRINT("tx_phys:      0x%016llx, tx_q addr:      0x%p\n",
+			(unsigned long long) dev_info.queues[i].tx_phys,
+			q->tx_q);
+		KNI_PRINT("rx_phys:      0x%016llx, rx_q addr:      0x%p\n",
+			(unsigned long long) dev_info.queues[i].rx_phys,
+			q->rx_q);
+		KNI_PRINT("alloc_phys:   0x%016llx, alloc_q addr:   0x%p\n",
+			(unsigned long long) dev_info.queues[i].alloc_phys,
+			q->alloc_q);
+		KNI_PRINT("free_phys:    0x%016llx, free_q addr:    0x%p\n",
+			(unsigned long long) dev_info.queues[i].free_phys,
+			q->free_q);
+	}
 	KNI_PRINT("req_phys:     0x%016llx, req_q addr:     0x%p\n",
 		(unsigned long long) dev_info.req_phys, kni->req_q);
 	KNI_PRINT("resp_phys:    0x%016llx, resp_q addr:    0x%p\n",
@@ -555,20 +612,30 @@ kni_ioctl_create(struct net *net,
 #endif
 
 	/**
-	 * Create a new kernel thread for multiple mode, set its core affinity,
-	 * and finally wake it up.
+	 * Create a new kernel thread per queue for multiple mode, set its
+	 * core affinity, and finally wake it up.
 	 */
-	if (multiple_kthread_on) {
-		kni->pthread = kthread_create(kni_thread_multiple,
-					      (void *)kni,
-					      "kni_%s", kni->name);
-		if (IS_ERR(kni->pthread)) {
+	for (i = 0; multiple_kthread_on && i < nb_queues; i++) {
+		struct task_struct *pthread;
+
+		q = &kni->queues[i];
+		if (i == 0)
+			pthread = kthread_create(kni_thread_multiple,
+						 (void *)q,
+						 "kni_%s", kni->name);
+		else
+			pthread = kthread_create(kni_thread_multiple,
+						 (void *)q,
+						 "kni_%s.%u", kni->name, i);
+		if (IS_ERR(pthread)) {
+			kni_dev_stop_threads(kni);
 			kni_dev_remove(kni);
 			return -ECANCELED;
 		}
 		if (dev_info.force_bind)
-			kthread_bind(kni->pthread, kni->core_id);
-		wake_up_process(kni->pthread);
+			kthread_bind(pthread, kni->core_id + i);
+		q->pthread = pthread;
+		wake_up_process(pthread);
 	}
 
 	down_write(&knet->kni_list_lock);
@@ -605,10 +672,7 @@ kni_ioctl_release(struct net *net,
 		if (strncmp(dev->name, dev_info.name, RTE_KNI_NAMESIZE) != 0)
 			continue;
 
-		if (multiple_kthread_on && dev->pthread != NULL) {
-			kthread_stop(dev->pthread);
-			dev->pthread = NULL;
-		}
+		kni_dev_stop_threads(dev);
 
 #ifdef RTE_KNI_VHOST
 		kni_vhost_backend_release(dev);
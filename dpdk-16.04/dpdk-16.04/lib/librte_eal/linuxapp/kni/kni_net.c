@@ -47,12 +47,12 @@
 #define KNI_WAIT_RESPONSE_TIMEOUT 300 /* 3 seconds */
 
 /* typedef for rx function */
-typedef void (*kni_net_rx_t)(struct kni_dev *kni);
+typedef void (*kni_net_rx_t)(struct kni_queue *q);
 
 static int kni_net_tx(struct sk_buff *skb, struct net_device *dev);
-static void kni_net_rx_normal(struct kni_dev *kni);
-static void kni_net_rx_lo_fifo(struct kni_dev *kni);
-static void kni_net_rx_lo_fifo_skb(struct kni_dev *kni);
+static void kni_net_rx_normal(struct kni_queue *q);
+static void kni_net_rx_lo_fifo(struct kni_queue *q);
+static void kni_net_rx_lo_fifo_skb(struct kni_queue *q);
 static int kni_net_process_request(struct kni_dev *kni,
 			struct rte_kni_request *req);
 
@@ -78,7 +78,7 @@ kni_net_open(struct net_device *dev)
 		 */
 		random_ether_addr(dev->dev_addr);
 
-	netif_start_queue(dev);
+	netif_tx_start_all_queues(dev);
 
 	memset(&req, 0, sizeof(req));
 	req.req_id = RTE_KNI_REQ_CFG_NETWORK_IF;
@@ -97,7 +97,7 @@ kni_net_release(struct net_device *dev)
 	struct rte_kni_request req;
 	struct kni_dev *kni = netdev_priv(dev);
 
-	netif_stop_queue(dev); /* can't transmit any more */
+	netif_tx_stop_all_queues(dev); /* can't transmit any more */
 
 	memset(&req, 0, sizeof(req));
 	req.req_id = RTE_KNI_REQ_CFG_NETWORK_IF;
@@ -126,8 +126,9 @@ kni_net_config(struct net_device *dev, struct ifmap *map)
  * RX: normal working mode
  */
 static void
-kni_net_rx_normal(struct kni_dev *kni)
+kni_net_rx_normal(struct kni_queue *q)
 {
+	struct kni_dev *kni = q->kni;
 	unsigned ret;
 	uint32_t len;
 	unsigned i, num_rx, num_fq;
@@ -139,7 +140,7 @@ kni_net_rx_normal(struct kni_dev *kni)
 	struct net_device *dev = kni->net_dev;
 
 	/* Get the number of free entries in free_q */
-	num_fq = kni_fifo_free_count(kni->free_q);
+	num_fq = kni_fifo_free_count(q->free_q);
 	if (num_fq == 0) {
 		/* No room on the free_q, bail out */
 		return;
@@ -149,7 +150,7 @@ kni_net_rx_normal(struct kni_dev *kni)
 	num_rx = min(num_fq, (unsigned)MBUF_BURST_SZ);
 
 	/* Burst dequeue from rx_q */
-	num_rx = kni_fifo_get(kni->rx_q, (void **)va, num_rx);
+	num_rx = kni_fifo_get(q->rx_q, (void **)va, num_rx);
 	if (num_rx == 0)
 		return;
 
@@ -164,7 +165,7 @@ kni_net_rx_normal(struct kni_dev *kni)
 		if (!skb) {
 			KNI_ERR("Out of mem, dropping pkts\n");
 			/* Update statistics */
-			kni->stats.rx_dropped++;
+			q->rx_dropped++;
 		}
 		else {
 			/* Align IP on 16B boundary */
@@ -173,18 +174,19 @@ kni_net_rx_normal(struct kni_dev *kni)
 			skb->dev = dev;
 			skb->protocol = eth_type_trans(skb, dev);
 			skb->ip_summed = CHECKSUM_UNNECESSARY;
+			skb_record_rx_queue(skb, q->id);
 
 			/* Call netif interface */
 			netif_rx_ni(skb);
 
 			/* Update statistics */
-			kni->stats.rx_bytes += len;
-			kni->stats.rx_packets++;
+			q->rx_bytes += len;
+			q->rx_packets++;
 		}
 	}
 
 	/* Burst enqueue mbufs into free_q */
-	ret = kni_fifo_put(kni->free_q, (void **)va, num_rx);
+	ret = kni_fifo_put(q->free_q, (void **)va, num_rx);
 	if (ret != num_rx)
 		/* Failing should not happen */
 		KNI_ERR("Fail to enqueue entries into free_q\n");
@@ -194,8 +196,9 @@ kni_net_rx_normal(struct kni_dev *kni)
  * RX: loopback with enqueue/dequeue fifos.
  */
 static void
-kni_net_rx_lo_fifo(struct kni_dev *kni)
+kni_net_rx_lo_fifo(struct kni_queue *q)
 {
+	struct kni_dev *kni = q->kni;
 	unsigned ret;
 	uint32_t len;
 	unsigned i, num, num_rq, num_tq, num_aq, num_fq;
@@ -208,16 +211,16 @@ kni_net_rx_lo_fifo(struct kni_dev *kni)
 	void *alloc_data_kva;
 
 	/* Get the number of entries in rx_q */
-	num_rq = kni_fifo_count(kni->rx_q);
+	num_rq = kni_fifo_count(q->rx_q);
 
 	/* Get the number of free entrie in tx_q */
-	num_tq = kni_fifo_free_count(kni->tx_q);
+	num_tq = kni_fifo_free_count(q->tx_q);
 
 	/* Get the number of entries in alloc_q */
-	num_aq = kni_fifo_count(kni->alloc_q);
+	num_aq = kni_fifo_count(q->alloc_q);
 
 	/* Get the number of free entries in free_q */
-	num_fq = kni_fifo_free_count(kni->free_q);
+	num_fq = kni_fifo_free_count(q->free_q);
 
 	/* Calculate the number of entries to be dequeued from rx_q */
 	num = min(num_rq, num_tq);
@@ -230,12 +233,12 @@ kni_net_rx_lo_fifo(struct kni_dev *kni)
 		return;
 
 	/* Burst dequeue from rx_q */
-	ret = kni_fifo_get(kni->rx_q, (void **)va, num);
+	ret = kni_fifo_get(q->rx_q, (void **)va, num);
 	if (ret == 0)
 		return; /* Failing should not happen */
 
 	/* Dequeue entries from alloc_q */
-	ret = kni_fifo_get(kni->alloc_q, (void **)alloc_va, num);
+	ret = kni_fifo_get(q->alloc_q, (void **)alloc_va, num);
 	if (ret) {
 		num = ret;
 		/* Copy mbufs */
@@ -254,19 +257,19 @@ kni_net_rx_lo_fifo(struct kni_dev *kni)
 			alloc_kva->pkt_len = len;
 			alloc_kva->data_len = len;
 
-			kni->stats.tx_bytes += len;
-			kni->stats.rx_bytes += len;
+			q->tx_bytes += len;
+			q->rx_bytes += len;
 		}
 
 		/* Burst enqueue mbufs into tx_q */
-		ret = kni_fifo_put(kni->tx_q, (void **)alloc_va, num);
+		ret = kni_fifo_put(q->tx_q, (void **)alloc_va, num);
 		if (ret != num)
 			/* Failing should not happen */
 			KNI_ERR("Fail to enqueue mbufs into tx_q\n");
 	}
 
 	/* Burst enqueue mbufs into free_q */
-	ret = kni_fifo_put(kni->free_q, (void **)va, num);
+	ret = kni_fifo_put(q->free_q, (void **)va, num);
 	if (ret != num)
 		/* Failing should not happen */
 		KNI_ERR("Fail to enqueue mbufs into free_q\n");
@@ -275,16 +278,17 @@ kni_net_rx_lo_fifo(struct kni_dev *kni)
 	 * Update statistic, and enqueue/dequeue failure is impossible,
 	 * as all queues are checked at first.
 	 */
-	kni->stats.tx_packets += num;
-	kni->stats.rx_packets += num;
+	q->tx_packets += num;
+	q->rx_packets += num;
 }
 
 /*
  * RX: loopback with enqueue/dequeue fifos and sk buffer copies.
  */
 static void
-kni_net_rx_lo_fifo_skb(struct kni_dev *kni)
+kni_net_rx_lo_fifo_skb(struct kni_queue *q)
 {
+	struct kni_dev *kni = q->kni;
 	unsigned ret;
 	uint32_t len;
 	unsigned i, num_rq, num_fq, num;
@@ -296,10 +300,10 @@ kni_net_rx_lo_fifo_skb(struct kni_dev *kni)
 	struct net_device *dev = kni->net_dev;
 
 	/* Get the number of entries in rx_q */
-	num_rq = kni_fifo_count(kni->rx_q);
+	num_rq = kni_fifo_count(q->rx_q);
 
 	/* Get the number of free entries in free_q */
-	num_fq = kni_fifo_free_count(kni->free_q);
+	num_fq = kni_fifo_free_count(q->free_q);
 
 	/* Calculate the number of entries to dequeue from rx_q */
 	num = min(num_rq, num_fq);
@@ -310,7 +314,7 @@ kni_net_rx_lo_fifo_skb(struct kni_dev *kni)
 		return;
 
 	/* Burst dequeue mbufs from rx_q */
-	ret = kni_fifo_get(kni->rx_q, (void **)va, num);
+	ret = kni_fifo_get(q->rx_q, (void **)va, num);
 	if (ret == 0)
 		return;
 
@@ -337,7 +341,7 @@ kni_net_rx_lo_fifo_skb(struct kni_dev *kni)
 		skb = dev_alloc_skb(len + 2);
 		if (skb == NULL) {
 			KNI_ERR("Out of mem, dropping pkts\n");
-			kni->stats.rx_dropped++;
+			q->rx_dropped++;
 		}
 		else {
 			/* Align IP on 16B boundary */
@@ -345,9 +349,10 @@ kni_net_rx_lo_fifo_skb(struct kni_dev *kni)
 			memcpy(skb_put(skb, len), data_kva, len);
 			skb->dev = dev;
 			skb->ip_summed = CHECKSUM_UNNECESSARY;
+			skb_set_queue_mapping(skb, q->id);
 
-			kni->stats.rx_bytes += len;
-			kni->stats.rx_packets++;
+			q->rx_bytes += len;
+			q->rx_packets++;
 
 			/* call tx interface */
 			kni_net_tx(skb, dev);
@@ -355,7 +360,7 @@ kni_net_rx_lo_fifo_skb(struct kni_dev *kni)
 	}
 
 	/* enqueue all the mbufs from rx_q into free_q */
-	ret = kni_fifo_put(kni->free_q, (void **)&va, num);
+	ret = kni_fifo_put(q->free_q, (void **)&va, num);
 	if (ret != num)
 		/* Failing should not happen */
 		KNI_ERR("Fail to enqueue mbufs into free_q\n");
@@ -363,13 +368,13 @@ kni_net_rx_lo_fifo_skb(struct kni_dev *kni)
 
 /* rx interface */
 void
-kni_net_rx(struct kni_dev *kni)
+kni_net_rx(struct kni_queue *q)
 {
 	/**
 	 * It doesn't need to check if it is NULL pointer,
 	 * as it has a default value
 	 */
-	(*kni_net_rx_func)(kni);
+	(*kni_net_rx_func)(q);
 }
 
 /*
@@ -382,7 +387,7 @@ kni_net_tx(struct sk_buff *skb, struct net_device *dev)
 	struct kni_dev *kni = netdev_priv(dev);
 
 	dev_kfree_skb(skb);
-	kni->stats.tx_dropped++;
+	kni->queues[0].tx_dropped++;
 
 	return NETDEV_TX_OK;
 }
@@ -393,6 +398,7 @@ kni_net_tx(struct sk_buff *skb, struct net_device *dev)
 	int len = 0;
 	unsigned ret;
 	struct kni_dev *kni = netdev_priv(dev);
+	struct kni_queue *q = &kni->queues[skb_get_queue_mapping(skb)];
 	struct rte_kni_mbuf *pkt_kva = NULL;
 	struct rte_kni_mbuf *pkt_va = NULL;
 
@@ -406,8 +412,8 @@ kni_net_tx(struct sk_buff *skb, struct net_device *dev)
 	 * Check if it has at least one free entry in tx_q and
 	 * one entry in alloc_q.
 	 */
-	if (kni_fifo_free_count(kni->tx_q) == 0 ||
-			kni_fifo_count(kni->alloc_q) == 0) {
+	if (kni_fifo_free_count(q->tx_q) == 0 ||
+			kni_fifo_count(q->alloc_q) == 0) {
 		/**
 		 * If no free entry in tx_q or no entry in alloc_q,
 		 * drops skb and goes out.
@@ -416,7 +422,7 @@ kni_net_tx(struct sk_buff *skb, struct net_device *dev)
 	}
 
 	/* dequeue a mbuf from alloc_q */
-	ret = kni_fifo_get(kni->alloc_q, (void **)&pkt_va, 1);
+	ret = kni_fifo_get(q->alloc_q, (void **)&pkt_va, 1);
 	if (likely(ret == 1)) {
 		void *data_kva;
 
@@ -434,7 +440,7 @@ kni_net_tx(struct sk_buff *skb, struct net_device *dev)
 		pkt_kva->data_len = len;
 
 		/* enqueue mbuf into tx_q */
-		ret = kni_fifo_put(kni->tx_q, (void **)&pkt_va, 1);
+		ret = kni_fifo_put(q->tx_q, (void **)&pkt_va, 1);
 		if (unlikely(ret != 1)) {
 			/* Failing should not happen */
 			KNI_ERR("Fail to enqueue mbuf into tx_q\n");
@@ -448,15 +454,15 @@ kni_net_tx(struct sk_buff *skb, struct net_device *dev)
 
 	/* Free skb and update statistics */
 	dev_kfree_skb(skb);
-	kni->stats.tx_bytes += len;
-	kni->stats.tx_packets++;
+	q->tx_bytes += len;
+	q->tx_packets++;
 
 	return NETDEV_TX_OK;
 
 drop:
 	/* Free skb and update statistics */
 	dev_kfree_skb(skb);
-	kni->stats.tx_dropped++;
+	q->tx_dropped++;
 
 	return NETDEV_TX_OK;
 }
@@ -474,7 +480,7 @@ kni_net_tx_timeout (struct net_device *dev)
 			jiffies - dev->trans_start);
 
 	kni->stats.tx_errors++;
-	netif_wake_queue(dev);
+	netif_tx_wake_all_queues(dev);
 	return;
 }
 
@@ -574,13 +580,34 @@ fail:
 }
 
 /*
- * Return statistics to the caller
+ * Return statistics to the caller, summing the packet counters of the
+ * queues, each one updated by its own kernel thread or transmit queue.
  */
 static struct net_device_stats *
 kni_net_stats(struct net_device *dev)
 {
 	struct kni_dev *kni = netdev_priv(dev);
-	return &kni->stats;
+	struct net_device_stats *stats = &kni->stats;
+	struct kni_queue *q;
+	unsigned i;
+
+	stats->rx_packets = 0;
+	stats->rx_bytes = 0;
+	stats->rx_dropped = 0;
+	stats->tx_packets = 0;
+	stats->tx_bytes = 0;
+	stats->tx_dropped = 0;
+	for (i = 0; i < kni->nb_queues; i++) {
+		q = &kni->queues[i];
+		stats->rx_packets += q->rx_packets;
+		stats->rx_bytes += q->rx_bytes;
+		stats->rx_dropped += q->rx_dropped;
+		stats->tx_packets += q->tx_packets;
+		stats->tx_bytes += q->tx_bytes;
+		stats->tx_dropped += q->tx_dropped;
+	}
+
+	return stats;
 }
 
 /*
@@ -94,8 +94,8 @@ kni_vhost_net_tx(struct kni_dev *kni, struct msghdr *m,
 	 * Check if it has at least one free entry in tx_q and
 	 * one entry in alloc_q.
 	 */
-	if (kni_fifo_free_count(kni->tx_q) == 0 ||
-	    kni_fifo_count(kni->alloc_q) == 0) {
+	if (kni_fifo_free_count(kni->queues[0].tx_q) == 0 ||
+	    kni_fifo_count(kni->queues[0].alloc_q) == 0) {
 		/**
 		 * If no free entry in tx_q or no entry in alloc_q,
 		 * drops skb and goes out.
@@ -104,7 +104,7 @@ kni_vhost_net_tx(struct kni_dev *kni, struct msghdr *m,
 	}
 
 	/* dequeue a mbuf from alloc_q */
-	ret = kni_fifo_get(kni->alloc_q, (void **)&pkt_va, 1);
+	ret = kni_fifo_get(kni->queues[0].alloc_q, (void **)&pkt_va, 1);
 	if (likely(ret == 1)) {
 		void *data_kva;
 
@@ -126,7 +126,7 @@ kni_vhost_net_tx(struct kni_dev *kni, struct msghdr *m,
 		pkt_kva->data_len = len;
 
 		/* enqueue mbuf into tx_q */
-		ret = kni_fifo_put(kni->tx_q, (void **)&pkt_va, 1);
+		ret = kni_fifo_put(kni->queues[0].tx_q, (void **)&pkt_va, 1);
 		if (unlikely(ret != 1)) {
 			/* Failing should not happen */
 			KNI_ERR("Fail to enqueue mbuf into tx_q\n");
@@ -139,14 +139,14 @@ kni_vhost_net_tx(struct kni_dev *kni, struct msghdr *m,
 	}
 
 	/* update statistics */
-	kni->stats.tx_bytes += len;
-	kni->stats.tx_packets++;
+	kni->queues[0].tx_bytes += len;
+	kni->queues[0].tx_packets++;
 
 	return 0;
 
 drop:
 	/* update statistics */
-	kni->stats.tx_dropped++;
+	kni->queues[0].tx_dropped++;
 
 	return 0;
 }
@@ -166,7 +166,7 @@ kni_vhost_net_rx(struct kni_dev *kni, struct msghdr *m,
 		return 0;
 
 	/* ensure at least one entry in free_q */
-	if (unlikely(kni_fifo_free_count(kni->free_q) == 0))
+	if (unlikely(kni_fifo_free_count(kni->queues[0].free_q) == 0))
 		return 0;
 
 	skb = skb_dequeue(&q->sk.sk_receive_queue);
@@ -201,12 +201,12 @@ kni_vhost_net_rx(struct kni_dev *kni, struct msghdr *m,
 		goto drop;
 
 	/* Update statistics */
-	kni->stats.rx_bytes += pkt_len;
-	kni->stats.rx_packets++;
+	kni->queues[0].rx_bytes += pkt_len;
+	kni->queues[0].rx_packets++;
 
 	/* enqueue mbufs into free_q */
 	va = (void*)kva - kni->mbuf_kva + kni->mbuf_va;
-	if (unlikely(1 != kni_fifo_put(kni->free_q, (void **)&va, 1)))
+	if (unlikely(1 != kni_fifo_put(kni->queues[0].free_q, (void **)&va, 1)))
 		/* Failing should not happen */
 		KNI_ERR("Fail to enqueue entries into free_q\n");
 
@@ -216,7 +216,7 @@ kni_vhost_net_rx(struct kni_dev *kni, struct msghdr *m,
 
 drop:
 	/* Update drop statistics */
-	kni->stats.rx_dropped++;
+	kni->queues[0].rx_dropped++;
 
 	return 0;
 }
@@ -247,7 +247,7 @@ kni_sock_poll(struct file *file, struct socket *sock, poll_table * wait)
 	poll_wait(file, &sock->wait, wait);
 #endif
 
-	if (kni_fifo_count(kni->rx_q) > 0)
+	if (kni_fifo_count(kni->queues[0].rx_q) > 0)
 		mask |= POLLIN | POLLRDNORM;
 
 	if (sock_writeable(&q->sk) ||
@@ -302,7 +302,7 @@ kni_chk_vhost_rx(struct kni_dev *kni)
 		return 0;
 
 	nb_skb = kni_fifo_count(q->fifo);
-	nb_mbuf = kni_fifo_count(kni->rx_q);
+	nb_mbuf = kni_fifo_count(kni->queues[0].rx_q);
 
 	nb_in = min(nb_mbuf, nb_skb);
 	nb_in = min(nb_in, (unsigned)RX_BURST_SZ);
@@ -312,7 +312,7 @@ kni_chk_vhost_rx(struct kni_dev *kni)
 	/* enqueue skb_queue per BURST_SIZE bulk */
 	if (0 != nb_burst) {
 		if (unlikely(RX_BURST_SZ != kni_fifo_get(
-				     kni->rx_q, (void **)&va,
+				     kni->queues[0].rx_q, (void **)&va,
 				     RX_BURST_SZ)))
 			goto except;
 
@@ -327,7 +327,7 @@ kni_chk_vhost_rx(struct kni_dev *kni)
 	/* all leftover, do one by one */
 	for (i = 0; i < nb_backlog; ++i) {
 		if (unlikely(1 != kni_fifo_get(
-				     kni->rx_q,(void **)&va, 1)))
+				     kni->queues[0].rx_q,(void **)&va, 1)))
 			goto except;
 
 		if (unlikely(1 != kni_fifo_get(
@@ -987,17 +987,20 @@ lookup_stage0(unsigned *idx, uint64_t *lookup_mask,
 }
 
 /*
- * Lookup bulk stage 1: Calculate primary/secondary hashes
- * and prefetch primary/secondary buckets
+ * Lookup bulk stage 1: Calculate primary/secondary hashes, or take the
+ * primary hashes of the caller, and prefetch primary/secondary buckets
  */
 static inline void
 lookup_stage1(unsigned idx, hash_sig_t *prim_hash, hash_sig_t *sec_hash,
 		const struct rte_hash_bucket **primary_bkt,
 		const struct rte_hash_bucket **secondary_bkt,
 		hash_sig_t *hash_vals, const void * const *keys,
-		const struct rte_hash *h)
+		const hash_sig_t *sigs, const struct rte_hash *h)
 {
-	*prim_hash = rte_hash_hash(h, keys[idx]);
+	if (sigs != NULL)
+		*prim_hash = sigs[idx];
+	else
+		*prim_hash = rte_hash_hash(h, keys[idx]);
 	hash_vals[idx] = *prim_hash;
 	*sec_hash = rte_hash_secondary_hash(*prim_hash);
 
@@ -1074,8 +1077,8 @@ lookup_stage3(unsigned idx, const struct rte_hash_key *key_slot, const void * co
 
 static inline void
 __rte_hash_lookup_bulk(const struct rte_hash *h, const void **keys,
-			uint32_t num_keys, int32_t *positions,
-			uint64_t *hit_mask, void *data[])
+			const hash_sig_t *sigs, uint32_t num_keys,
+			int32_t *positions, uint64_t *hit_mask, void *data[])
 {
 	uint64_t hits = 0;
 	uint64_t extra_hits_mask = 0;
@@ -1107,9 +1110,9 @@ __rte_hash_lookup_bulk(const struct rte_hash *h, const void **keys,
 	lookup_stage0(&idx00, &lookup_mask, keys);
 	lookup_stage0(&idx01, &lookup_mask, keys);
 	lookup_stage1(idx10, &primary_hash10, &secondary_hash10,
-			&primary_bkt10, &secondary_bkt10, hash_vals, keys, h);
+			&primary_bkt10, &secondary_bkt10, hash_vals, keys, sigs, h);
 	lookup_stage1(idx11, &primary_hash11, &secondary_hash11,
-			&primary_bkt11,	&secondary_bkt11, hash_vals, keys, h);
+			&primary_bkt11,	&secondary_bkt11, hash_vals, keys, sigs, h);
 
 	primary_bkt20 = primary_bkt10;
 	primary_bkt21 = primary_bkt11;
@@ -1125,9 +1128,9 @@ __rte_hash_lookup_bulk(const struct rte_hash *h, const void **keys,
 	lookup_stage0(&idx00, &lookup_mask, keys);
 	lookup_stage0(&idx01, &lookup_mask, keys);
 	lookup_stage1(idx10, &primary_hash10, &secondary_hash10,
-			&primary_bkt10, &secondary_bkt10, hash_vals, keys, h);
+			&primary_bkt10, &secondary_bkt10, hash_vals, keys, sigs, h);
 	lookup_stage1(idx11, &primary_hash11, &secondary_hash11,
-			&primary_bkt11,	&secondary_bkt11, hash_vals, keys, h);
+			&primary_bkt11,	&secondary_bkt11, hash_vals, keys, sigs, h);
 	lookup_stage2(idx20, primary_hash20, secondary_hash20, primary_bkt20,
 			secondary_bkt20, &k_slot20, positions, &extra_hits_mask,
 			key_store, h);
@@ -1152,9 +1155,9 @@ __rte_hash_lookup_bulk(const struct rte_hash *h, const void **keys,
 		lookup_stage0(&idx00, &lookup_mask, keys);
 		lookup_stage0(&idx01, &lookup_mask, keys);
 		lookup_stage1(idx10, &primary_hash10, &secondary_hash10,
-			&primary_bkt10, &secondary_bkt10, hash_vals, keys, h);
+			&primary_bkt10, &secondary_bkt10, hash_vals, keys, sigs, h);
 		lookup_stage1(idx11, &primary_hash11, &secondary_hash11,
-			&primary_bkt11,	&secondary_bkt11, hash_vals, keys, h);
+			&primary_bkt11,	&secondary_bkt11, hash_vals, keys, sigs, h);
 		lookup_stage2(idx20, primary_hash20, secondary_hash20,
 			primary_bkt20, secondary_bkt20, &k_slot20, positions,
 			&extra_hits_mask, key_store, h);
@@ -1179,9 +1182,9 @@ __rte_hash_lookup_bulk(const struct rte_hash *h, const void **keys,
 	idx10 = idx00, idx11 = idx01;
 
 	lookup_stage1(idx10, &primary_hash10, &secondary_hash10,
-		&primary_bkt10, &secondary_bkt10, hash_vals, keys, h);
+		&primary_bkt10, &secondary_bkt10, hash_vals, keys, sigs, h);
 	lookup_stage1(idx11, &primary_hash11, &secondary_hash11,
-		&primary_bkt11,	&secondary_bkt11, hash_vals, keys, h);
+		&primary_bkt11,	&secondary_bkt11, hash_vals, keys, sigs, h);
 	lookup_stage2(idx20, primary_hash20, secondary_hash20, primary_bkt20,
 		secondary_bkt20, &k_slot20, positions, &extra_hits_mask,
 		key_store, h);
@@ -1261,7 +1264,20 @@ rte_hash_lookup_bulk(const struct rte_hash *h, const void **keys,
 			(num_keys > RTE_HASH_LOOKUP_BULK_MAX) ||
 			(positions == NULL)), -EINVAL);
 
-	__rte_hash_lookup_bulk(h, keys, num_keys, positions, NULL, NULL);
+	__rte_hash_lookup_bulk(h, keys, NULL, num_keys, positions, NULL, NULL);
+	return 0;
+}
+
+int
+rte_hash_lookup_bulk_with_hash(const struct rte_hash *h, const void **keys,
+		const hash_sig_t *sigs, uint32_t num_keys, int32_t *positions)
+{
+	RETURN_IF_TRUE(((h == NULL) || (keys == NULL) || (sigs == NULL) ||
+			(num_keys == 0) ||
+			(num_keys > RTE_HASH_LOOKUP_BULK_MAX) ||
+			(positions == NULL)), -EINVAL);
+
+	__rte_hash_lookup_bulk(h, keys, sigs, num_keys, positions, NULL, NULL);
 	return 0;
 }
 
@@ -1275,7 +1291,8 @@ rte_hash_lookup_bulk_data(const struct rte_hash *h, const void **keys,
 
 	int32_t positions[num_keys];
 
-	__rte_hash_lookup_bulk(h, keys, num_keys, positions, hit_mask, data);
+	__rte_hash_lookup_bulk(h, keys, NULL, num_keys, positions, hit_mask,
+		data);
 
 	/* Return number of hits */
 	return __builtin_popcountl(*hit_mask);
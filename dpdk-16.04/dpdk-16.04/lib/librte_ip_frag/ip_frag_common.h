@@ -34,6 +34,9 @@
 #ifndef _IP_FRAG_COMMON_H_
 #define _IP_FRAG_COMMON_H_
 
+#include <string.h>
+#include <errno.h>
+
 #include "rte_ip_frag.h"
 
 /* logging macros. */
@@ -57,28 +60,66 @@ if (!(exp))	{							\
 /* helper macros */
 #define	IP_FRAG_MBUF2DR(dr, mb)	((dr)->row[(dr)->cnt++] = (mb))
 
+/* fragments processed between two death row flushes by the bulk functions */
+#define	IP_FRAG_BULK_SIZE	IP_FRAG_DEATH_ROW_LEN
+#define	IP_FRAG_BULK_PREFETCH	3
+
+/* mbufs taken from a mempool per bulk get by the fragmentation functions */
+#define	IP_FRAG_ALLOC_BULK	32
+
+/* fragment of a burst, parsed before the table lookups */
+struct ip_frag_bulk {
+	struct ip_frag_key key;
+	uint32_t sig[2];
+	struct rte_mbuf *mb;
+	uint16_t ofs;
+	uint16_t len;
+	uint16_t more_frags;
+};
+
 #define IPv6_KEY_BYTES(key) \
 	(key)[0], (key)[1], (key)[2], (key)[3]
 #define IPv6_KEY_BYTES_FMT \
 	"%08" PRIx64 "%08" PRIx64 "%08" PRIx64 "%08" PRIx64
 
 /* internal functions declarations */
-struct rte_mbuf * ip_frag_process(struct ip_frag_pkt *fp,
+struct rte_mbuf * ip_frag_process(struct rte_ip_frag_tbl *tbl,
+		struct ip_frag_pkt *fp,
 		struct rte_ip_frag_death_row *dr, struct rte_mbuf *mb,
 		uint16_t ofs, uint16_t len, uint16_t more_frags);
 
 struct ip_frag_pkt * ip_frag_find(struct rte_ip_frag_tbl *tbl,
 		struct rte_ip_frag_death_row *dr,
-		const struct ip_frag_key *key, uint64_t tms);
+		const struct ip_frag_key *key, const uint32_t *sig, uint64_t tms);
 
 struct ip_frag_pkt * ip_frag_lookup(struct rte_ip_frag_tbl *tbl,
-	const struct ip_frag_key *key, uint64_t tms,
+	const struct ip_frag_key *key, const uint32_t *sig, uint64_t tms,
 	struct ip_frag_pkt **free, struct ip_frag_pkt **stale);
 
+void ip_frag_tbl_del_expired(struct rte_ip_frag_tbl *tbl,
+	struct rte_ip_frag_death_row *dr, uint64_t tms);
+
+struct rte_mbuf *ip_frag_shared_process(struct rte_ip_frag_tbl *tbl,
+	struct rte_ip_frag_death_row *dr, struct rte_mbuf *mb,
+	const struct ip_frag_key *key, const uint32_t *sig, uint64_t tms,
+	uint16_t ofs, uint16_t len, uint16_t more_frags);
+
+void ip_frag_shared_del_expired(struct rte_ip_frag_tbl *tbl,
+	struct rte_ip_frag_death_row *dr, uint64_t tms);
+
+void ip_frag_bulk_prefetch(const struct rte_ip_frag_tbl *tbl,
+	struct ip_frag_bulk *frag, uint32_t n);
+
+struct rte_mbuf *ip_frag_bulk_process(struct rte_ip_frag_tbl *tbl,
+	struct rte_ip_frag_death_row *dr, const struct ip_frag_bulk *frag,
+	uint64_t tms);
+
 /* these functions need to be declared here as ip_frag_process relies on them */
 struct rte_mbuf * ipv4_frag_reassemble(const struct ip_frag_pkt *fp);
 struct rte_mbuf * ipv6_frag_reassemble(const struct ip_frag_pkt *fp);
 
+struct rte_mbuf *ip_frag_chain(const struct ip_frag_pkt *fp);
+
 
 
 /*
@@ -109,31 +150,90 @@ ip_frag_key_invalidate(struct ip_frag_key * key)
 static inline int
 ip_frag_key_cmp(const struct ip_frag_key * k1, const struct ip_frag_key * k2)
 {
-	uint32_t i, val;
-	val = k1->id ^ k2->id;
+	uint32_t i;
+	uint64_t val;
+
+	/* 64-bit accumulator: the upper halves of IPv6 words count too */
+	val = (k1->id ^ k2->id) | (k1->key_len ^ k2->key_len);
 	for (i = 0; i < k1->key_len; i++)
 		val |= k1->src_dst[i] ^ k2->src_dst[i];
-	return val;
+	return val != 0;
 }
 
 /*
  * misc fragment functions
  */
 
+/* take a zeroed overflow block from the table */
+static inline struct ip_frag_ext *
+ip_frag_ext_get(struct rte_ip_frag_tbl *tbl)
+{
+	struct ip_frag_ext *ext;
+
+	if (tbl->shared != 0)
+		rte_spinlock_lock(&tbl->ext_lock);
+
+	ext = tbl->ext_free;
+	if (ext != NULL)
+		tbl->ext_free = ext->next;
+
+	if (tbl->shared != 0)
+		rte_spinlock_unlock(&tbl->ext_lock);
+
+	if (ext != NULL)
+		memset(ext, 0, sizeof(*ext));
+	return ext;
+}
+
+/* give the overflow blocks of the packet back to the table */
+static inline void
+ip_frag_ext_put(struct rte_ip_frag_tbl *tbl, struct ip_frag_pkt *fp)
+{
+	struct ip_frag_ext *ext;
+
+	if (fp->ext == NULL)
+		return;
+
+	for (ext = fp->ext; ext->next != NULL; ext = ext->next)
+		;
+
+	if (tbl->shared != 0)
+		rte_spinlock_lock(&tbl->ext_lock);
+
+	ext->next = tbl->ext_free;
+	tbl->ext_free = fp->ext;
+
+	if (tbl->shared != 0)
+		rte_spinlock_unlock(&tbl->ext_lock);
+
+	fp->ext = NULL;
+}
+
 /* put fragment on death row */
 static inline void
-ip_frag_free(struct ip_frag_pkt *fp, struct rte_ip_frag_death_row *dr)
+ip_frag_free(struct rte_ip_frag_tbl *tbl, struct ip_frag_pkt *fp,
+	struct rte_ip_frag_death_row *dr)
 {
+	struct ip_frag_ext *ext;
 	uint32_t i, k;
 
 	k = dr->cnt;
-	for (i = 0; i != fp->last_idx; i++) {
+	for (i = 0; i != RTE_MIN(fp->last_idx, (uint32_t)IP_INLINE_FRAG_NUM);
+			i++) {
 		if (fp->frags[i].mb != NULL) {
 			dr->row[k++] = fp->frags[i].mb;
 			fp->frags[i].mb = NULL;
 		}
 	}
 
+	for (ext = fp->ext; ext != NULL; ext = ext->next) {
+		for (i = 0; i != IP_FRAG_EXT_NUM; i++) {
+			if (ext->frags[i].mb != NULL)
+				dr->row[k++] = ext->frags[i].mb;
+		}
+	}
+	ip_frag_ext_put(tbl, fp);
+
 	fp->last_idx = 0;
 	dr->cnt = k;
 }
@@ -166,4 +266,104 @@ ip_frag_reset(struct ip_frag_pkt *fp, uint64_t tms)
 	fp->frags[IP_FIRST_FRAG_IDX] = zero_frag;
 }
 
+/* mbufs got in bulk from a mempool and handed out one at a time */
+struct ip_frag_mcache {
+	struct rte_mempool *mp;
+	uint32_t left;  /* upper bound of the mbufs still needed */
+	uint32_t idx;
+	uint32_t cnt;
+	struct rte_mbuf *mb[IP_FRAG_ALLOC_BULK];
+};
+
+static inline void
+ip_frag_mcache_init(struct ip_frag_mcache *mc, struct rte_mempool *mp,
+	uint32_t need)
+{
+	mc->mp = mp;
+	mc->left = need;
+	mc->idx = 0;
+	mc->cnt = 0;
+}
+
+/*
+ * take the next mbuf, refilling the cache with a single bulk get.
+ * The mbuf is not reset: rte_pktmbuf_attach() overwrites all the fields of
+ * an indirect mbuf anyway.
+ */
+static inline struct rte_mbuf *
+ip_frag_mcache_get(struct ip_frag_mcache *mc)
+{
+	struct rte_mbuf *m;
+	uint32_t n;
+
+	if (unlikely(mc->idx == mc->cnt)) {
+		n = RTE_MIN(mc->left, (uint32_t)IP_FRAG_ALLOC_BULK);
+		if (n == 0 ||
+				rte_mempool_get_bulk(mc->mp, (void **)mc->mb, n) != 0)
+			return NULL;
+		mc->left -= n;
+		mc->idx = 0;
+		mc->cnt = n;
+	}
+
+	m = mc->mb[mc->idx++];
+	RTE_MBUF_ASSERT(rte_mbuf_refcnt_read(m) == 0);
+	rte_mbuf_refcnt_set(m, 1);
+	return m;
+}
+
+/* give back the mbufs that were not handed out */
+static inline void
+ip_frag_mcache_flush(struct ip_frag_mcache *mc)
+{
+	if (mc->idx != mc->cnt)
+		rte_mempool_put_bulk(mc->mp, (void **)(mc->mb + mc->idx),
+			mc->cnt - mc->idx);
+	mc->idx = 0;
+	mc->cnt = 0;
+}
+
+/*
+ * Attach the payload of the input packet, from in_seg/in_pos on, to out_pkt
+ * through indirect mbufs, until out_pkt is frag_len bytes long or the input
+ * is consumed. in_seg/in_pos are moved past the attached data.
+ */
+static inline int
+ip_frag_attach_payload(struct rte_mbuf *out_pkt, uint32_t frag_len,
+	struct rte_mbuf **in_seg, uint32_t *in_pos, struct ip_frag_mcache *ind)
+{
+	struct rte_mbuf *seg, *out_seg, *out_seg_prev;
+	uint32_t len, pos;
+
+	seg = *in_seg;
+	pos = *in_pos;
+	out_seg_prev = out_pkt;
+
+	do {
+		out_seg = ip_frag_mcache_get(ind);
+		if (unlikely(out_seg == NULL))
+			return -ENOMEM;
+		out_seg_prev->next = out_seg;
+		out_seg_prev = out_seg;
+
+		rte_pktmbuf_attach(out_seg, seg);
+		len = RTE_MIN(frag_len - out_pkt->pkt_len,
+			(uint32_t)seg->data_len - pos);
+		out_seg->data_off = (uint16_t)(seg->data_off + pos);
+		out_seg->data_len = (uint16_t)len;
+		out_pkt->pkt_len += len;
+		out_pkt->nb_segs++;
+
+		pos += len;
+		if (pos == seg->data_len) {
+			seg = seg->next;
+			pos = 0;
+		}
+	} while (out_pkt->pkt_len < frag_len && seg != NULL);
+
+	*in_seg = seg;
+	*in_pos = pos;
+	return 0;
+}
+
 #endif /* _IP_FRAG_COMMON_H_ */
@@ -33,7 +33,9 @@
 
 #include <stddef.h>
 
+#include <rte_atomic.h>
 #include <rte_jhash.h>
+#include <rte_prefetch.h>
 #ifdef RTE_MACHINE_CPUFLAG_SSE4_2
 #include <rte_hash_crc.h>
 #endif /* RTE_MACHINE_CPUFLAG_SSE4_2 */
@@ -47,8 +49,11 @@
 
 #ifdef RTE_LIBRTE_IP_FRAG_TBL_STAT
 #define	IP_FRAG_TBL_STAT_UPDATE(s, f, v)	((s)->f += (v))
+#define	IP_FRAG_TBL_STAT_UPDATE_MT(s, f, v)	\
+	rte_atomic64_add((rte_atomic64_t *)&(s)->f, (v))
 #else
 #define	IP_FRAG_TBL_STAT_UPDATE(s, f, v)	do {} while (0)
+#define	IP_FRAG_TBL_STAT_UPDATE_MT(s, f, v)	do {} while (0)
 #endif /* IP_FRAG_TBL_STAT */
 
 /* local frag table helper functions */
@@ -56,7 +61,7 @@ static inline void
 ip_frag_tbl_del(struct rte_ip_frag_tbl *tbl, struct rte_ip_frag_death_row *dr,
 	struct ip_frag_pkt *fp)
 {
-	ip_frag_free(fp, dr);
+	ip_frag_free(tbl, fp, dr);
 	ip_frag_key_invalidate(&fp->key);
 	TAILQ_REMOVE(&tbl->lru, fp, lru);
 	tbl->use_entries--;
@@ -78,7 +83,7 @@ static inline void
 ip_frag_tbl_reuse(struct rte_ip_frag_tbl *tbl, struct rte_ip_frag_death_row *dr,
 	struct ip_frag_pkt *fp, uint64_t tms)
 {
-	ip_frag_free(fp, dr);
+	ip_frag_free(tbl, fp, dr);
 	ip_frag_reset(fp, tms);
 	TAILQ_REMOVE(&tbl->lru, fp, lru);
 	TAILQ_INSERT_TAIL(&tbl->lru, fp, lru);
@@ -136,6 +141,70 @@ ipv6_frag_hash(const struct ip_frag_key *key, uint32_t *v1, uint32_t *v2)
 	*v2 = (v << 7) + (v >> 14);
 }
 
+/* different hashing methods for IPv4 and IPv6 */
+static inline void
+ip_frag_key_hash(const struct ip_frag_key *key, uint32_t *v1, uint32_t *v2)
+{
+	if (key->key_len == IPV4_KEYLEN)
+		ipv4_frag_hash(key, v1, v2);
+	else
+		ipv6_frag_hash(key, v1, v2);
+}
+
+/* shared table: take one of the max_entries, if any left */
+static inline int
+ip_frag_shared_use_get(struct rte_ip_frag_tbl *tbl)
+{
+	uint32_t n;
+
+	do {
+		n = *(volatile uint32_t *)&tbl->use_entries;
+		if (n >= tbl->max_entries)
+			return 0;
+	} while (rte_atomic32_cmpset(&tbl->use_entries, n, n + 1) == 0);
+
+	return 1;
+}
+
+/* shared table: give an entry back */
+static inline void
+ip_frag_shared_use_put(struct rte_ip_frag_tbl *tbl)
+{
+	uint32_t n;
+
+	do {
+		n = *(volatile uint32_t *)&tbl->use_entries;
+	} while (rte_atomic32_cmpset(&tbl->use_entries, n, n - 1) == 0);
+}
+
+/* shared table: lock the two buckets of a key, always in the same order */
+static inline void
+ip_frag_shared_lock(struct ip_frag_pkt *b1, struct ip_frag_pkt *b2)
+{
+	if (b1 > b2) {
+		struct ip_frag_pkt *b = b1;
+
+		b1 = b2;
+		b2 = b;
+	}
+
+	rte_spinlock_lock(&b1->lock);
+	if (b2 != b1)
+		rte_spinlock_lock(&b2->lock);
+}
+
+static inline void
+ip_frag_shared_unlock(struct ip_frag_pkt *b1, struct ip_frag_pkt *b2)
+{
+	if (b2 != b1)
+		rte_spinlock_unlock(&b2->lock);
+	rte_spinlock_unlock(&b1->lock);
+}
+
+static struct ip_frag_pkt *ip_frag_bucket_lookup(struct rte_ip_frag_tbl *tbl,
+	const struct ip_frag_key *key, uint32_t sig1, uint32_t sig2,
+	uint64_t tms, struct ip_frag_pkt **free, struct ip_frag_pkt **stale);
+
 
 /*
 	函数通过判断：
@@ -150,38 +219,67 @@ ipv6_frag_hash(const struct ip_frag_key *key, uint32_t *v1, uint32_t *v2)
 	如果重组后，返回的mbuf为NULL，那么释放所有的资源；如果返回的mbuf不为空，那么将此节点的key重置为未使用，并返回重组后的mbuf。
 	
 */
-struct rte_mbuf *
-ip_frag_process(struct ip_frag_pkt *fp, struct rte_ip_frag_death_row *dr,
-	struct rte_mbuf *mb, uint16_t ofs, uint16_t len, uint16_t more_frags)
+/*
+ * Slot for the next middle fragment: in the entry itself, or in its most
+ * recent overflow block, taking a new block from the table when it is full.
+ */
+static inline struct ip_frag *
+ip_frag_next_slot(struct rte_ip_frag_tbl *tbl, struct ip_frag_pkt *fp)
 {
+	struct ip_frag_ext *ext;
 	uint32_t idx;
 
+	idx = fp->last_idx;
+	if (idx < IP_INLINE_FRAG_NUM)
+		return &fp->frags[idx];
+	else if (idx >= IP_MAX_FRAG_NUM)
+		return NULL;
+
+	idx = (idx - IP_INLINE_FRAG_NUM) % IP_FRAG_EXT_NUM;
+	if (idx == 0) {
+		ext = ip_frag_ext_get(tbl);
+		if (ext == NULL)
+			return NULL;
+		ext->next = fp->ext;
+		fp->ext = ext;
+	}
+
+	return &fp->ext->frags[idx];
+}
+
+struct rte_mbuf *
+ip_frag_process(struct rte_ip_frag_tbl *tbl, struct ip_frag_pkt *fp,
+	struct rte_ip_frag_death_row *dr, struct rte_mbuf *mb,
+	uint16_t ofs, uint16_t len, uint16_t more_frags)
+{
+	struct ip_frag *frag;
+
 	//计算所有已经到达分片的大小
 	fp->frag_size += len;
+	frag = NULL;
 
 	//是第一个分片
 	if (ofs == 0) {
-		idx = (fp->frags[IP_FIRST_FRAG_IDX].mb == NULL) ?
-				IP_FIRST_FRAG_IDX : UINT32_MAX;
+		if (fp->frags[IP_FIRST_FRAG_IDX].mb == NULL)
+			frag = &fp->frags[IP_FIRST_FRAG_IDX];
 
 	//是最后一个分片
 	} else if (more_frags == 0) {
 		fp->total_size = ofs + len;
-		idx = (fp->frags[IP_LAST_FRAG_IDX].mb == NULL) ?
-				IP_LAST_FRAG_IDX : UINT32_MAX;
+		if (fp->frags[IP_LAST_FRAG_IDX].mb == NULL)
+			frag = &fp->frags[IP_LAST_FRAG_IDX];
 
 	//这是中间片段
-	} else if ((idx = fp->last_idx) <
-		sizeof (fp->frags) / sizeof (fp->frags[0])) {
+	} else if ((frag = ip_frag_next_slot(tbl, fp)) != NULL) {
 		fp->last_idx++;
 	}
 
 	/*
 	 * errorneous packet: either exceeed max allowed number of fragments,
-	 * or duplicate first/last fragment encountered.
+	 * no overflow block left, or duplicate first/last fragment encountered.
 	 */
 	 //错误：索引大于能够保存分片的缓存数组的大小
-	if (idx >= sizeof (fp->frags) / sizeof (fp->frags[0])) {
+	if (frag == NULL) {
 
 		/* report an error. */
 		if (fp->key.key_len == IPV4_KEYLEN)
@@ -213,7 +311,7 @@ ip_frag_process(struct ip_frag_pkt *fp, struct rte_ip_frag_death_row *dr,
 
 		/* free all fragments, invalidate the entry. */
 		//释放所有分片，并将无效话节点
-		ip_frag_free(fp, dr);
+		ip_frag_free(tbl, fp, dr);
 		ip_frag_key_invalidate(&fp->key);
 		IP_FRAG_MBUF2DR(dr, mb);
 
@@ -221,9 +319,9 @@ ip_frag_process(struct ip_frag_pkt *fp, struct rte_ip_frag_death_row *dr,
 	}
 
 	//赋值
-	fp->frags[idx].ofs = ofs;
-	fp->frags[idx].len = len;
-	fp->frags[idx].mb = mb;
+	frag->ofs = ofs;
+	frag->len = len;
+	frag->mb = mb;
 
 	mb = NULL;
 
@@ -272,7 +370,10 @@ ip_frag_process(struct ip_frag_pkt *fp, struct rte_ip_frag_death_row *dr,
 				fp->frags[IP_LAST_FRAG_IDX].len);
 
 		//释放资源
-		ip_frag_free(fp, dr);
+		ip_frag_free(tbl, fp, dr);
+	} else {
+		/* the fragments now belong to mb. */
+		ip_frag_ext_put(tbl, fp);
 	}
 
 	//充值key为未使用
@@ -281,6 +382,69 @@ ip_frag_process(struct ip_frag_pkt *fp, struct rte_ip_frag_death_row *dr,
 }
 
 
+/*
+ * Link the fragments of a complete packet in offset order, without copying
+ * their data. The middle fragments are sorted first, they usually arrive
+ * in order. Nothing is modified if a fragment is missing or overlaps with
+ * another one, so that they can all be freed separately.
+ * Returns the first fragment, now holding the whole packet, or NULL.
+ */
+struct rte_mbuf *
+ip_frag_chain(const struct ip_frag_pkt *fp)
+{
+	const struct ip_frag *frags[IP_MAX_FRAG_NUM];
+	const struct ip_frag *f;
+	const struct ip_frag_ext *ext;
+	struct rte_mbuf *head, *tail, *m;
+	uint32_t i, j, n, ofs, nb_segs;
+
+	n = 0;
+	for (i = IP_MIN_FRAG_NUM;
+			i < RTE_MIN(fp->last_idx, (uint32_t)IP_INLINE_FRAG_NUM); i++)
+		frags[n++] = &fp->frags[i];
+	for (ext = fp->ext; ext != NULL; ext = ext->next) {
+		for (i = 0; i != IP_FRAG_EXT_NUM; i++) {
+			if (ext->frags[i].mb != NULL)
+				frags[n++] = &ext->frags[i];
+		}
+	}
+
+	/* insertion sort of the middle fragments by offset. */
+	for (i = 1; i < n; i++) {
+		f = frags[i];
+		for (j = i; j != 0 && frags[j - 1]->ofs > f->ofs; j--)
+			frags[j] = frags[j - 1];
+		frags[j] = f;
+	}
+	frags[n++] = &fp->frags[IP_LAST_FRAG_IDX];
+
+	/* check there is no hole or overlap. */
+	head = fp->frags[IP_FIRST_FRAG_IDX].mb;
+	ofs = fp->frags[IP_FIRST_FRAG_IDX].len;
+	nb_segs = head->nb_segs;
+	for (i = 0; i != n; i++) {
+		if (frags[i]->ofs != ofs)
+			return NULL;
+		ofs += frags[i]->len;
+		nb_segs += frags[i]->mb->nb_segs;
+	}
+	if (nb_segs > UINT8_MAX)
+		return NULL;
+
+	/* link each fragment payload after the tail of the packet. */
+	tail = rte_pktmbuf_lastseg(head);
+	for (i = 0; i != n; i++) {
+		m = frags[i]->mb;
+		rte_pktmbuf_adj(m, (uint16_t)(m->l2_len + m->l3_len));
+		tail->next = m;
+		tail = rte_pktmbuf_lastseg(m);
+		head->pkt_len += m->pkt_len;
+	}
+	head->nb_segs = (uint8_t)nb_segs;
+
+	return head;
+}
+
 /*
  * Find an entry in the table for the corresponding fragment.
  * If such entry is not present, then allocate a new one.
@@ -288,7 +452,7 @@ ip_frag_process(struct ip_frag_pkt *fp, struct rte_ip_frag_death_row *dr,
  */
 struct ip_frag_pkt *
 ip_frag_find(struct rte_ip_frag_tbl *tbl, struct rte_ip_frag_death_row *dr,
-	const struct ip_frag_key *key, uint64_t tms)
+	const struct ip_frag_key *key, const uint32_t *sig, uint64_t tms)
 {
 	struct ip_frag_pkt *pkt, *free, *stale, *lru;
 	uint64_t max_cycles;
@@ -304,7 +468,7 @@ ip_frag_find(struct rte_ip_frag_tbl *tbl, struct rte_ip_frag_death_row *dr,
 	IP_FRAG_TBL_STAT_UPDATE(&tbl->stat, find_num, 1);
 
 	//通过key查找hash
-	if ((pkt = ip_frag_lookup(tbl, key, tms, &free, &stale)) == NULL) {
+	if ((pkt = ip_frag_lookup(tbl, key, sig, tms, &free, &stale)) == NULL) {
 
 		/*timed-out entry, free and invalidate it*/
 		if (stale != NULL) {
@@ -349,15 +513,226 @@ ip_frag_find(struct rte_ip_frag_tbl *tbl, struct rte_ip_frag_death_row *dr,
 	return pkt;
 }
 
+/* delete the timed out entries, oldest first, while the death row has room */
+void
+ip_frag_tbl_del_expired(struct rte_ip_frag_tbl *tbl,
+	struct rte_ip_frag_death_row *dr, uint64_t tms)
+{
+	struct ip_frag_pkt *lru;
+	uint64_t max_cycles;
+
+	max_cycles = tbl->max_cycles;
+
+	while ((lru = TAILQ_FIRST(&tbl->lru)) != NULL &&
+			max_cycles + lru->start < tms &&
+			RTE_DIM(dr->row) - dr->cnt >= IP_MAX_FRAG_NUM)
+		ip_frag_tbl_del(tbl, dr, lru);
+}
+
+/*
+ * Find an entry of a shared table for the corresponding fragment, with the
+ * locks of both buckets held. Same as ip_frag_find(), but without LRU list:
+ * when the table is full, only the timed out entries of the buckets can be
+ * reused.
+ */
+static struct ip_frag_pkt *
+ip_frag_shared_find(struct rte_ip_frag_tbl *tbl,
+	struct rte_ip_frag_death_row *dr, const struct ip_frag_key *key,
+	uint32_t sig1, uint32_t sig2, uint64_t tms)
+{
+	struct ip_frag_pkt *pkt, *free, *stale;
+
+	free = NULL;
+	stale = NULL;
+
+	IP_FRAG_TBL_STAT_UPDATE_MT(&tbl->stat, find_num, 1);
+
+	pkt = ip_frag_bucket_lookup(tbl, key, sig1, sig2, tms, &free, &stale);
+	if (pkt == NULL) {
+
+		/* timed-out entry, free and reuse it, still in use. */
+		if (stale != NULL) {
+			ip_frag_free(tbl, stale, dr);
+			IP_FRAG_TBL_STAT_UPDATE_MT(&tbl->stat, del_num, 1);
+			free = stale;
+
+		/* free entry, if the table is not full. */
+		} else if (free != NULL && ip_frag_shared_use_get(tbl) == 0) {
+			free = NULL;
+			IP_FRAG_TBL_STAT_UPDATE_MT(&tbl->stat, fail_nospace, 1);
+		}
+
+		if (free != NULL) {
+			free->key = key[0];
+			ip_frag_reset(free, tms);
+			IP_FRAG_TBL_STAT_UPDATE_MT(&tbl->stat, add_num, 1);
+			pkt = free;
+		}
+
+	/* timed out flow, free associated resources and reuse it. */
+	} else if (tbl->max_cycles + pkt->start < tms) {
+		ip_frag_free(tbl, pkt, dr);
+		ip_frag_reset(pkt, tms);
+		IP_FRAG_TBL_STAT_UPDATE_MT(&tbl->stat, reuse_num, 1);
+	}
+
+	IP_FRAG_TBL_STAT_UPDATE_MT(&tbl->stat, fail_total, (pkt == NULL));
+
+	return pkt;
+}
+
+/*
+ * Process a fragment on a shared table: find its entry and add the
+ * fragment to it, with both buckets of the key locked.
+ * The key is hashed here if sig is NULL.
+ */
+struct rte_mbuf *
+ip_frag_shared_process(struct rte_ip_frag_tbl *tbl,
+	struct rte_ip_frag_death_row *dr, struct rte_mbuf *mb,
+	const struct ip_frag_key *key, const uint32_t *sig, uint64_t tms,
+	uint16_t ofs, uint16_t len, uint16_t more_frags)
+{
+	struct ip_frag_pkt *fp, *b1, *b2;
+	uint32_t sig1, sig2;
+
+	if (sig == NULL)
+		ip_frag_key_hash(key, &sig1, &sig2);
+	else {
+		sig1 = sig[0];
+		sig2 = sig[1];
+	}
+	b1 = IP_FRAG_TBL_POS(tbl, sig1);
+	b2 = IP_FRAG_TBL_POS(tbl, sig2);
+
+	ip_frag_shared_lock(b1, b2);
+
+	fp = ip_frag_shared_find(tbl, dr, key, sig1, sig2, tms);
+	if (fp == NULL) {
+		ip_frag_shared_unlock(b1, b2);
+		IP_FRAG_MBUF2DR(dr, mb);
+		return NULL;
+	}
+
+	mb = ip_frag_process(tbl, fp, dr, mb, ofs, len, more_frags);
+
+	/* reassembled or dropped: the entry is free again. */
+	if (ip_frag_key_is_empty(&fp->key))
+		ip_frag_shared_use_put(tbl);
+
+	ip_frag_shared_unlock(b1, b2);
+
+	return mb;
+}
+
+/*
+ * Delete the timed out entries of a shared table, one bucket at a time with
+ * its lock held, while the death row has room.
+ */
+void
+ip_frag_shared_del_expired(struct rte_ip_frag_tbl *tbl,
+	struct rte_ip_frag_death_row *dr, uint64_t tms)
+{
+	struct ip_frag_pkt *b, *fp;
+	uint32_t i, j;
+
+	for (i = 0; i != tbl->nb_entries; i += tbl->bucket_entries) {
+		b = tbl->pkt + i;
+		rte_spinlock_lock(&b->lock);
+		for (j = 0; j != tbl->bucket_entries; j++) {
+			if (RTE_DIM(dr->row) - dr->cnt < IP_MAX_FRAG_NUM) {
+				rte_spinlock_unlock(&b->lock);
+				return;
+			}
+			fp = b + j;
+			if (ip_frag_key_is_empty(&fp->key) ||
+					tbl->max_cycles + fp->start >= tms)
+				continue;
+			ip_frag_free(tbl, fp, dr);
+			ip_frag_key_invalidate(&fp->key);
+			ip_frag_shared_use_put(tbl);
+			IP_FRAG_TBL_STAT_UPDATE_MT(&tbl->stat, del_num, 1);
+		}
+		rte_spinlock_unlock(&b->lock);
+	}
+}
+
+/*
+ * Hash the keys of a burst and prefetch the first entry of both buckets of
+ * each key, so that the lookups do not wait for the table to be read.
+ */
+void
+ip_frag_bulk_prefetch(const struct rte_ip_frag_tbl *tbl,
+	struct ip_frag_bulk *frag, uint32_t n)
+{
+	uint32_t i;
+
+	for (i = 0; i != n; i++) {
+		ip_frag_key_hash(&frag[i].key, &frag[i].sig[0],
+			&frag[i].sig[1]);
+		rte_prefetch0(IP_FRAG_TBL_POS(tbl, frag[i].sig[0]));
+		rte_prefetch0(IP_FRAG_TBL_POS(tbl, frag[i].sig[1]));
+	}
+}
+
+/* process a fragment of a burst, its key already hashed */
+struct rte_mbuf *
+ip_frag_bulk_process(struct rte_ip_frag_tbl *tbl,
+	struct rte_ip_frag_death_row *dr, const struct ip_frag_bulk *frag,
+	uint64_t tms)
+{
+	struct ip_frag_pkt *fp;
+	struct rte_mbuf *mb;
+
+	if (tbl->shared != 0)
+		return ip_frag_shared_process(tbl, dr, frag->mb, &frag->key,
+			frag->sig, tms, frag->ofs, frag->len,
+			frag->more_frags);
+
+	fp = ip_frag_find(tbl, dr, &frag->key, frag->sig, tms);
+	if (fp == NULL) {
+		IP_FRAG_MBUF2DR(dr, frag->mb);
+		return NULL;
+	}
+
+	mb = ip_frag_process(tbl, fp, dr, frag->mb, frag->ofs, frag->len,
+		frag->more_frags);
+	ip_frag_inuse(tbl, fp);
+
+	return mb;
+}
+
+/* the key is hashed here if sig is NULL and it is not the last one found */
 struct ip_frag_pkt *
 ip_frag_lookup(struct rte_ip_frag_tbl *tbl,
-	const struct ip_frag_key *key, uint64_t tms,
+	const struct ip_frag_key *key, const uint32_t *sig, uint64_t tms,
 	struct ip_frag_pkt **free, struct ip_frag_pkt **stale)
+{
+	uint32_t sig1, sig2;
+
+	//如果有最后一个使用的元素，那么比较最后一个元素的key值是否相等。
+	if (tbl->last != NULL && ip_frag_key_cmp(key, &tbl->last->key) == 0)
+		return tbl->last;
+
+	if (sig == NULL)
+		ip_frag_key_hash(key, &sig1, &sig2);
+	else {
+		sig1 = sig[0];
+		sig2 = sig[1];
+	}
+
+	return ip_frag_bucket_lookup(tbl, key, sig1, sig2, tms, free, stale);
+}
+
+/* look the key up in its two buckets */
+static struct ip_frag_pkt *
+ip_frag_bucket_lookup(struct rte_ip_frag_tbl *tbl,
+	const struct ip_frag_key *key, uint32_t sig1, uint32_t sig2,
+	uint64_t tms, struct ip_frag_pkt **free, struct ip_frag_pkt **stale)
 {
 	struct ip_frag_pkt *p1, *p2;
 	struct ip_frag_pkt *empty, *old;
 	uint64_t max_cycles;
-	uint32_t i, assoc, sig1, sig2;
+	uint32_t i, assoc;
 
 	empty = NULL;
 	old = NULL;
@@ -365,16 +740,6 @@ ip_frag_lookup(struct rte_ip_frag_tbl *tbl,
 	max_cycles = tbl->max_cycles;
 	assoc = tbl->bucket_entries;
 
-	//如果有最后一个使用的元素，那么比较最后一个元素的key值是否相等。
-	if (tbl->last != NULL && ip_frag_key_cmp(key, &tbl->last->key) == 0)
-		return tbl->last;
-
-	/* different hashing methods for IPv4 and IPv6 */
-	if (key->key_len == IPV4_KEYLEN)
-		ipv4_frag_hash(key, &sig1, &sig2);
-	else
-		ipv6_frag_hash(key, &sig1, &sig2);
-
 	p1 = IP_FRAG_TBL_POS(tbl, sig1);
 	p2 = IP_FRAG_TBL_POS(tbl, sig2);
 
@@ -50,6 +50,7 @@ extern "C" {
 
 #include <rte_malloc.h>
 #include <rte_memory.h>
+#include <rte_spinlock.h>
 #include <rte_ip.h>
 #include <rte_byteorder.h>
 
@@ -59,10 +60,14 @@ enum {
 	IP_LAST_FRAG_IDX,    /**< index of last fragment */
 	IP_FIRST_FRAG_IDX,   /**< index of first fragment */
 	IP_MIN_FRAG_NUM,     /**< minimum number of fragments */
+	IP_INLINE_FRAG_NUM = RTE_LIBRTE_IP_FRAG_INLINE_FRAG,
+	/**< number of fragments stored in the table entry */
 	IP_MAX_FRAG_NUM = RTE_LIBRTE_IP_FRAG_MAX_FRAG,
 	/**< maximum number of fragments per packet */
 };
 
+#define IP_FRAG_EXT_NUM 8 /**< number of fragments per overflow block */
+
 /** @internal fragmented mbuf */
 struct ip_frag {
 	uint16_t ofs;          /**< offset into the packet */
@@ -77,9 +82,20 @@ struct ip_frag_key {
 	uint32_t key_len;      /**< src/dst key length */
 };
 
+/**
+ * @internal overflow block, holds the fragments of a packet that do not fit
+ * in its table entry.
+ */
+struct ip_frag_ext {
+	struct ip_frag_ext *next;                /**< next block of the packet */
+	struct ip_frag      frags[IP_FRAG_EXT_NUM]; /**< fragments */
+};
+
 /*
  * @internal Fragmented packet to reassemble.
  * First two entries in the frags[] array are for the last and first fragments.
+ * Fragments past IP_INLINE_FRAG_NUM are stored in the ext blocks, most
+ * recent block first.
  */
 struct ip_frag_pkt {
 	TAILQ_ENTRY(ip_frag_pkt) lru;   /**< LRU list */
@@ -88,11 +104,20 @@ struct ip_frag_pkt {
 	uint32_t             total_size;  /**< expected reassembled size */
 	uint32_t             frag_size;   /**< size of fragments received */
 	uint32_t             last_idx;    /**< index of next entry to fill */
-	struct ip_frag       frags[IP_MAX_FRAG_NUM]; /**< fragments */
+	rte_spinlock_t       lock;        /**< lock of the bucket starting
+					    * at this entry (shared tables) */
+	struct ip_frag_ext  *ext;         /**< overflow blocks */
+	struct ip_frag       frags[IP_INLINE_FRAG_NUM]; /**< fragments */
 } __rte_cache_aligned;
 
 #define IP_FRAG_DEATH_ROW_LEN 32 /**< death row size (in packets) */
 
+/**
+ * Fragmentation flag: leave the IPv4 header checksum to the NIC, the output
+ * fragments get PKT_TX_IP_CKSUM and their l3_len set.
+ */
+#define RTE_IP_FRAG_TX_CKSUM_OFFLOAD (1 << 0)
+
 /** mbuf death row (packets to be freed) */
 struct rte_ip_frag_death_row {
 	uint32_t cnt;          /**< number of mbufs currently on death row */
@@ -121,6 +146,10 @@ struct rte_ip_frag_tbl {
 	uint32_t             bucket_entries;  /**< hash assocaitivity. */
 	uint32_t             nb_entries;      /**< total size of the table. */
 	uint32_t             nb_buckets;      /**< num of associativity lines. */
+	uint32_t             shared;          /**< used by several lcores. */
+	uint32_t             nb_ext;          /**< num of overflow blocks. */
+	rte_spinlock_t       ext_lock;        /**< lock of free overflow blocks. */
+	struct ip_frag_ext  *ext_free;        /**< free overflow blocks. */
 	struct ip_frag_pkt *last;         /**< last used entry. */
 	struct ip_pkt_list lru;           /**< LRU list for table entries. */
 	struct ip_frag_tbl_stat stat;     /**< statistics counters. */
@@ -154,6 +183,12 @@ struct ipv6_extension_fragment {
 /*
  * Create a new IP fragmentation table.
  *
+ * Each entry of the table stores up to RTE_LIBRTE_IP_FRAG_INLINE_FRAG
+ * fragments. The fragments of larger packets, up to
+ * RTE_LIBRTE_IP_FRAG_MAX_FRAG, go to overflow blocks of IP_FRAG_EXT_NUM
+ * fragments, max_entries of which are allocated with the table and
+ * shared by all its entries.
+ *
  * @param bucket_num
  *   Number of buckets in the hash table.
  * @param bucket_entries
@@ -174,6 +209,54 @@ struct rte_ip_frag_tbl * rte_ip_frag_table_create(uint32_t bucket_num,
 		uint32_t bucket_entries,  uint32_t max_entries,
 		uint64_t max_cycles, int socket_id);
 
+/*
+ * Create a new IP fragmentation table shared by several lcores.
+ *
+ * The fragments of a datagram can be passed to the reassembly functions
+ * on any lcore, each lcore using its own death row. Each bucket of the
+ * table has its own lock, held while a fragment is added to one of its
+ * entries, so lcores only contend when their fragments hash to the same
+ * buckets. Entries are never evicted before their TTL expires: when
+ * max_entries are in use, new datagrams are dropped until entries
+ * complete or time out.
+ *
+ * @param bucket_num
+ *   Number of buckets in the hash table.
+ * @param bucket_entries
+ *   Number of entries per bucket (e.g. hash associativity).
+ *   Should be power of two.
+ * @param max_entries
+ *   Maximum number of entries that could be stored in the table.
+ *   The value should be less or equal then bucket_num * bucket_entries.
+ * @param max_cycles
+ *   Maximum TTL in cycles for each fragmented packet.
+ * @param socket_id
+ *   The *socket_id* argument is the socket identifier in the case of
+ *   NUMA. The value can be *SOCKET_ID_ANY* if there is no NUMA constraints.
+ * @return
+ *   The pointer to the new allocated fragmentation table, on success. NULL on error.
+ */
+struct rte_ip_frag_tbl *rte_ip_frag_table_create_shared(uint32_t bucket_num,
+		uint32_t bucket_entries, uint32_t max_entries,
+		uint64_t max_cycles, int socket_id);
+
+/**
+ * Delete the entries of a fragmentation table which timed out at tms,
+ * putting their fragments on the death row. Stops early when the death row
+ * could not hold the fragments of another entry.
+ * Shared tables have no LRU list: their buckets are scanned one at a time,
+ * with the lock of the bucket held.
+ *
+ * @param tbl
+ *   Fragmentation table to delete the expired entries from.
+ * @param dr
+ *   Death row to put the fragments of the deleted entries on.
+ * @param tms
+ *   Current timestamp, in cycles.
+ */
+void rte_ip_frag_table_del_expired_entries(struct rte_ip_frag_tbl *tbl,
+		struct rte_ip_frag_death_row *dr, uint64_t tms);
+
 /*
  * Free allocated IP fragmentation table.
  *
@@ -215,6 +298,41 @@ rte_ipv6_fragment_packet(struct rte_mbuf *pkt_in,
 		struct rte_mempool *pool_direct,
 		struct rte_mempool *pool_indirect);
 
+/**
+ * Same as rte_ipv6_fragment_packet(), but the output mbufs are taken from
+ * the pools with bulk gets and the headers are copied from a template built
+ * once per packet.
+ *
+ * @param pkt_in
+ *   The input packet.
+ * @param pkts_out
+ *   Array storing the output fragments.
+ * @param nb_pkts_out
+ *   Number of fragments.
+ * @param mtu_size
+ *   Size in bytes of the Maximum Transfer Unit (MTU) for the outgoing IPv6
+ *   datagrams. This value includes the size of the IPv6 header.
+ * @param pool_direct
+ *   MBUF pool used for allocating direct buffers for the output fragments.
+ * @param pool_indirect
+ *   MBUF pool used for allocating indirect buffers for the output fragments.
+ * @param flags
+ *   With RTE_IP_FRAG_TX_CKSUM_OFFLOAD the output fragments get PKT_TX_IPV6
+ *   and their l3_len set, for the L2 offloads of the TX queue.
+ * @return
+ *   Upon successful completion - number of output fragments placed
+ *   in the pkts_out array.
+ *   Otherwise - (-1) * errno.
+ */
+int32_t
+rte_ipv6_fragment_packet_bulk(struct rte_mbuf *pkt_in,
+		struct rte_mbuf **pkts_out,
+		uint16_t nb_pkts_out,
+		uint16_t mtu_size,
+		struct rte_mempool *pool_direct,
+		struct rte_mempool *pool_indirect,
+		uint32_t flags);
+
 /*
  * This function implements reassembly of fragmented IPv6 packets.
  * Incoming mbuf should have its l2_len/l3_len fields setup correctly.
@@ -241,6 +359,36 @@ struct rte_mbuf *rte_ipv6_frag_reassemble_packet(struct rte_ip_frag_tbl *tbl,
 		struct rte_mbuf *mb, uint64_t tms, struct ipv6_hdr *ip_hdr,
 		struct ipv6_extension_fragment *frag_hdr);
 
+/*
+ * This function implements reassembly of a burst of IPv6 packets.
+ * Incoming mbufs should have their l2_len/l3_len fields setup correctly,
+ * the fragment header being the extension header right after the IPv6
+ * header. Packets without fragment header are returned as they are.
+ *
+ * The keys of the whole burst are hashed and their buckets prefetched
+ * before the first fragment is looked up in the table. The mbufs put on
+ * the death row are freed before the function returns.
+ *
+ * @param tbl
+ *   Table where to lookup/add the fragmented packets.
+ * @param dr
+ *   Death row to free buffers to
+ * @param pkts_in
+ *   Incoming mbufs.
+ * @param nb_pkts
+ *   Number of incoming mbufs.
+ * @param tms
+ *   Arrival timestamp of the burst.
+ * @param pkts_out
+ *   Array to store the reassembled and not fragmented packets in, at least
+ *   nb_pkts long. It can be the same as pkts_in.
+ * @return
+ *   Number of packets stored in pkts_out.
+ */
+uint16_t rte_ipv6_frag_reassemble_bulk(struct rte_ip_frag_tbl *tbl,
+		struct rte_ip_frag_death_row *dr, struct rte_mbuf **pkts_in,
+		uint16_t nb_pkts, uint64_t tms, struct rte_mbuf **pkts_out);
+
 /*
  * Return a pointer to the packet's fragment header, if found.
  * It only looks at the extension header that's right after the fixed IPv6
@@ -291,6 +439,41 @@ int32_t rte_ipv4_fragment_packet(struct rte_mbuf *pkt_in,
 			struct rte_mempool *pool_direct,
 			struct rte_mempool *pool_indirect);
 
+/**
+ * Same as rte_ipv4_fragment_packet(), but the output mbufs are taken from
+ * the pools with bulk gets and the headers are copied from a template built
+ * once per packet.
+ *
+ * @param pkt_in
+ *   The input packet.
+ * @param pkts_out
+ *   Array storing the output fragments.
+ * @param nb_pkts_out
+ *   Number of fragments.
+ * @param mtu_size
+ *   Size in bytes of the Maximum Transfer Unit (MTU) for the outgoing IPv4
+ *   datagrams. This value includes the size of the IPv4 header.
+ * @param pool_direct
+ *   MBUF pool used for allocating direct buffers for the output fragments.
+ * @param pool_indirect
+ *   MBUF pool used for allocating indirect buffers for the output fragments.
+ * @param flags
+ *   With RTE_IP_FRAG_TX_CKSUM_OFFLOAD the header checksum is left to the
+ *   NIC: the output fragments get PKT_TX_IPV4 | PKT_TX_IP_CKSUM and their
+ *   l3_len set, the application sets l2_len. Otherwise the checksum is
+ *   computed in software and no offload flag is set.
+ * @return
+ *   Upon successful completion - number of output fragments placed
+ *   in the pkts_out array.
+ *   Otherwise - (-1) * errno.
+ */
+int32_t rte_ipv4_fragment_packet_bulk(struct rte_mbuf *pkt_in,
+			struct rte_mbuf **pkts_out,
+			uint16_t nb_pkts_out, uint16_t mtu_size,
+			struct rte_mempool *pool_direct,
+			struct rte_mempool *pool_indirect,
+			uint32_t flags);
+
 /*
  * This function implements reassembly of fragmented IPv4 packets.
  * Incoming mbufs should have its l2_len/l3_len fields setup correclty.
@@ -314,6 +497,35 @@ struct rte_mbuf * rte_ipv4_frag_reassemble_packet(struct rte_ip_frag_tbl *tbl,
 		struct rte_ip_frag_death_row *dr,
 		struct rte_mbuf *mb, uint64_t tms, struct ipv4_hdr *ip_hdr);
 
+/*
+ * This function implements reassembly of a burst of IPv4 packets.
+ * Incoming mbufs should have their l2_len/l3_len fields setup correctly.
+ * Packets that are not fragments are returned as they are.
+ *
+ * The keys of the whole burst are hashed and their buckets prefetched
+ * before the first fragment is looked up in the table. The mbufs put on
+ * the death row are freed before the function returns.
+ *
+ * @param tbl
+ *   Table where to lookup/add the fragmented packets.
+ * @param dr
+ *   Death row to free buffers to
+ * @param pkts_in
+ *   Incoming mbufs.
+ * @param nb_pkts
+ *   Number of incoming mbufs.
+ * @param tms
+ *   Arrival timestamp of the burst.
+ * @param pkts_out
+ *   Array to store the reassembled and not fragmented packets in, at least
+ *   nb_pkts long. It can be the same as pkts_in.
+ * @return
+ *   Number of packets stored in pkts_out.
+ */
+uint16_t rte_ipv4_frag_reassemble_bulk(struct rte_ip_frag_tbl *tbl,
+		struct rte_ip_frag_death_row *dr, struct rte_mbuf **pkts_in,
+		uint16_t nb_pkts, uint64_t tms, struct rte_mbuf **pkts_out);
+
 /*
  * Check if the IPv4 packet is fragmented
  *
@@ -65,14 +65,16 @@ rte_ip_frag_free_death_row(struct rte_ip_frag_death_row *dr,
 	dr->cnt = 0;
 }
 
-/* create fragmentation table */
-struct rte_ip_frag_tbl *
-rte_ip_frag_table_create(uint32_t bucket_num, uint32_t bucket_entries,
-	uint32_t max_entries, uint64_t max_cycles, int socket_id)
+static struct rte_ip_frag_tbl *
+ip_frag_table_create(uint32_t bucket_num, uint32_t bucket_entries,
+	uint32_t max_entries, uint64_t max_cycles, int socket_id,
+	uint32_t shared)
 {
 	struct rte_ip_frag_tbl *tbl;
+	struct ip_frag_ext *ext;
 	size_t sz;
 	uint64_t nb_entries;
+	uint32_t i, nb_ext;
 
 	//计算条目个数
 	nb_entries = rte_align32pow2(bucket_num);
@@ -89,7 +91,9 @@ rte_ip_frag_table_create(uint32_t bucket_num, uint32_t bucket_entries,
 	}
 
 	//计算分配空间大小，并调用函数rte_zmalloc_socket分配空间
-	sz = sizeof (*tbl) + nb_entries * sizeof (tbl->pkt[0]);
+	nb_ext = (IP_MAX_FRAG_NUM > IP_INLINE_FRAG_NUM) ? max_entries : 0;
+	sz = sizeof (*tbl) + nb_entries * sizeof (tbl->pkt[0]) +
+		nb_ext * sizeof (*ext);
 	if ((tbl = rte_zmalloc_socket(__func__, sz, RTE_CACHE_LINE_SIZE,
 			socket_id)) == NULL) {
 		RTE_LOG(ERR, USER1,
@@ -107,11 +111,53 @@ rte_ip_frag_table_create(uint32_t bucket_num, uint32_t bucket_entries,
 	tbl->nb_buckets = bucket_num;                      //篮子的个数
 	tbl->bucket_entries = bucket_entries;              //每个篮子的个数
 	tbl->entry_mask = (tbl->nb_entries - 1) & ~(tbl->bucket_entries  - 1);
+	tbl->shared = shared;
+
+	for (i = 0; i < tbl->nb_entries; i += tbl->bucket_entries)
+		rte_spinlock_init(&tbl->pkt[i].lock);
+
+	/* overflow blocks follow the entries. */
+	tbl->nb_ext = nb_ext;
+	rte_spinlock_init(&tbl->ext_lock);
+	ext = (struct ip_frag_ext *)(tbl->pkt + tbl->nb_entries);
+	for (i = 0; i != nb_ext; i++) {
+		ext[i].next = tbl->ext_free;
+		tbl->ext_free = &ext[i];
+	}
 
 	TAILQ_INIT(&(tbl->lru));
 	return tbl;
 }
 
+/* create fragmentation table */
+struct rte_ip_frag_tbl *
+rte_ip_frag_table_create(uint32_t bucket_num, uint32_t bucket_entries,
+	uint32_t max_entries, uint64_t max_cycles, int socket_id)
+{
+	return ip_frag_table_create(bucket_num, bucket_entries, max_entries,
+		max_cycles, socket_id, 0);
+}
+
+/* create fragmentation table shared by several lcores */
+struct rte_ip_frag_tbl *
+rte_ip_frag_table_create_shared(uint32_t bucket_num, uint32_t bucket_entries,
+	uint32_t max_entries, uint64_t max_cycles, int socket_id)
+{
+	return ip_frag_table_create(bucket_num, bucket_entries, max_entries,
+		max_cycles, socket_id, 1);
+}
+
+/* delete timed out entries of fragmentation table */
+void
+rte_ip_frag_table_del_expired_entries(struct rte_ip_frag_tbl *tbl,
+	struct rte_ip_frag_death_row *dr, uint64_t tms)
+{
+	if (tbl->shared == 0)
+		ip_frag_tbl_del_expired(tbl, dr, tms);
+	else
+		ip_frag_shared_del_expired(tbl, dr, tms);
+}
+
 /* dump frag table statistics to file */
 void
 rte_ip_frag_table_statistics_dump(FILE *f, const struct rte_ip_frag_tbl *tbl)
@@ -216,3 +216,139 @@ rte_ipv4_fragment_packet(struct rte_mbuf *pkt_in,  //分片的结构
 
 	return out_pkt_pos;
 }
+
+/**
+ * IPv4 fragmentation, with bulk allocation of the output mbufs.
+ *
+ * The number of fragments is known upfront, so the direct and indirect
+ * mbufs are taken from their pools IP_FRAG_ALLOC_BULK at a time. The
+ * output header is copied from a template, only its length and offset
+ * differ between the fragments, and the software checksum is updated from
+ * the partial sum of the template.
+ *
+ * @param pkt_in
+ *   The input packet.
+ * @param pkts_out
+ *   Array storing the output fragments.
+ * @param nb_pkts_out
+ *   Number of entries in the pkts_out array.
+ * @param mtu_size
+ *   Size in bytes of the Maximum Transfer Unit (MTU) for the outgoing IPv4
+ *   datagrams. This value includes the size of the IPv4 header.
+ * @param pool_direct
+ *   MBUF pool used for allocating direct buffers for the output fragments.
+ * @param pool_indirect
+ *   MBUF pool used for allocating indirect buffers for the output fragments.
+ * @param flags
+ *   RTE_IP_FRAG_TX_CKSUM_OFFLOAD to leave the header checksum to the NIC.
+ * @return
+ *   Upon successful completion - number of output fragments placed
+ *   in the pkts_out array.
+ *   Otherwise - (-1) * <errno>.
+ */
+int32_t
+rte_ipv4_fragment_packet_bulk(struct rte_mbuf *pkt_in,
+	struct rte_mbuf **pkts_out,
+	uint16_t nb_pkts_out,
+	uint16_t mtu_size,
+	struct rte_mempool *pool_direct,
+	struct rte_mempool *pool_indirect,
+	uint32_t flags)
+{
+	struct ip_frag_mcache dir, ind;
+	struct rte_mbuf *in_seg, *out_pkt;
+	struct ipv4_hdr tmpl, *out_hdr;
+	uint64_t ol_flags;
+	uint32_t i, nb_frags, payload, in_seg_data_pos, sum;
+	uint16_t fragment_offset, flag_offset, frag_size, fofs, cksum;
+
+	if (unlikely(mtu_size < sizeof(struct ipv4_hdr)))
+		return -EINVAL;
+
+	/* payload of all fragments but the last, a multiple of 8 bytes */
+	frag_size = (uint16_t)(mtu_size - sizeof(struct ipv4_hdr));
+	frag_size &= ~IPV4_HDR_FO_MASK;
+	if (unlikely(frag_size == 0))
+		return -EINVAL;
+
+	tmpl = *rte_pktmbuf_mtod(pkt_in, struct ipv4_hdr *);
+	flag_offset = rte_be_to_cpu_16(tmpl.fragment_offset);
+	if (unlikely((flag_offset & IPV4_HDR_DF_MASK) != 0))
+		return -ENOTSUP;
+
+	payload = pkt_in->pkt_len - sizeof(struct ipv4_hdr);
+	nb_frags = (payload + frag_size - 1) / frag_size;
+	nb_frags += (nb_frags == 0);
+	if (unlikely(nb_frags > nb_pkts_out))
+		return -EINVAL;
+
+	/* header template, and its sum without the per fragment fields */
+	tmpl.total_length = 0;
+	tmpl.fragment_offset = 0;
+	tmpl.hdr_checksum = 0;
+	sum = __rte_raw_cksum(&tmpl, sizeof(tmpl), 0);
+
+	ol_flags = (flags & RTE_IP_FRAG_TX_CKSUM_OFFLOAD) ?
+		PKT_TX_IPV4 | PKT_TX_IP_CKSUM : 0;
+
+	/* every input segment boundary may add an indirect mbuf */
+	ip_frag_mcache_init(&dir, pool_direct, nb_frags);
+	ip_frag_mcache_init(&ind, pool_indirect,
+		nb_frags + pkt_in->nb_segs - 1);
+
+	in_seg = pkt_in;
+	in_seg_data_pos = sizeof(struct ipv4_hdr);
+	fragment_offset = 0;
+
+	for (i = 0; i != nb_frags; i++) {
+
+		out_pkt = ip_frag_mcache_get(&dir);
+		if (unlikely(out_pkt == NULL))
+			goto nomem;
+		rte_pktmbuf_reset(out_pkt);
+		out_pkt->data_len = sizeof(struct ipv4_hdr);
+		out_pkt->pkt_len = sizeof(struct ipv4_hdr);
+
+		if (unlikely(ip_frag_attach_payload(out_pkt,
+				sizeof(struct ipv4_hdr) + frag_size,
+				&in_seg, &in_seg_data_pos, &ind) != 0)) {
+			rte_pktmbuf_free(out_pkt);
+			goto nomem;
+		}
+
+		fofs = (uint16_t)(flag_offset +
+			(fragment_offset >> IPV4_HDR_FO_SHIFT));
+		if (i != nb_frags - 1)
+			fofs |= IPV4_HDR_MF_MASK;
+
+		out_hdr = rte_pktmbuf_mtod(out_pkt, struct ipv4_hdr *);
+		*out_hdr = tmpl;
+		out_hdr->total_length = rte_cpu_to_be_16(out_pkt->pkt_len);
+		out_hdr->fragment_offset = rte_cpu_to_be_16(fofs);
+
+		if (ol_flags == 0) {
+			cksum = __rte_raw_cksum_reduce(sum +
+				out_hdr->total_length +
+				out_hdr->fragment_offset);
+			out_hdr->hdr_checksum = (cksum == 0xffff) ?
+				cksum : (uint16_t)~cksum;
+		}
+
+		out_pkt->ol_flags = ol_flags;
+		out_pkt->l3_len = sizeof(struct ipv4_hdr);
+
+		fragment_offset = (uint16_t)(fragment_offset +
+			out_pkt->pkt_len - sizeof(struct ipv4_hdr));
+		pkts_out[i] = out_pkt;
+	}
+
+	/* unused indirect mbufs, if input segments ended on fragment ends */
+	ip_frag_mcache_flush(&ind);
+	return nb_frags;
+
+nomem:
+	ip_frag_mcache_flush(&dir);
+	ip_frag_mcache_flush(&ind);
+	__free_fragments(pkts_out, i);
+	return -ENOMEM;
+}
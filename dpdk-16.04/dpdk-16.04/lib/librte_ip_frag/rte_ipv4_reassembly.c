@@ -44,45 +44,12 @@ struct rte_mbuf *
 ipv4_frag_reassemble(const struct ip_frag_pkt *fp)
 {
 	struct ipv4_hdr *ip_hdr;
-	struct rte_mbuf *m, *prev;
-	uint32_t i, n, ofs, first_len;
+	struct rte_mbuf *m;
 
-	first_len = fp->frags[IP_FIRST_FRAG_IDX].len;
-	n = fp->last_idx - 1;
-
-	/*start from the last fragment. */
-	m = fp->frags[IP_LAST_FRAG_IDX].mb;
-	ofs = fp->frags[IP_LAST_FRAG_IDX].ofs;
-
-	while (ofs != first_len) {
-
-		prev = m;
-
-		for (i = n; i != IP_FIRST_FRAG_IDX && ofs != first_len; i--) {
-
-			/* previous fragment found. */
-			if(fp->frags[i].ofs + fp->frags[i].len == ofs) {
-
-				/* adjust start of the last fragment data. */
-				rte_pktmbuf_adj(m, (uint16_t)(m->l2_len + m->l3_len));
-				rte_pktmbuf_chain(fp->frags[i].mb, m);
-
-				/* update our last fragment and offset. */
-				m = fp->frags[i].mb;
-				ofs = fp->frags[i].ofs;
-			}
-		}
-
-		/* error - hole in the packet. */
-		if (m == prev) {
-			return NULL;
-		}
-	}
-
-	/* chain with the first fragment. */
-	rte_pktmbuf_adj(m, (uint16_t)(m->l2_len + m->l3_len));
-	rte_pktmbuf_chain(fp->frags[IP_FIRST_FRAG_IDX].mb, m);
-	m = fp->frags[IP_FIRST_FRAG_IDX].mb;
+	/* chain all fragments after the first one. */
+	m = ip_frag_chain(fp);
+	if (m == NULL)
+		return NULL;
 
 	/* update mbuf fields for reassembled packet. */
 	m->ol_flags |= PKT_TX_IP_CKSUM;
@@ -99,6 +66,31 @@ ipv4_frag_reassemble(const struct ip_frag_pkt *fp)
 	return m;
 }
 
+/*
+ * Build the key of an IPv4 fragment, get its offset, length and MF flag.
+ */
+static inline void
+ipv4_frag_parse(const struct rte_mbuf *mb, const struct ipv4_hdr *ip_hdr,
+	struct ip_frag_key *key, uint16_t *ofs, uint16_t *len, uint16_t *flag)
+{
+	const unaligned_uint64_t *psd;
+	uint16_t flag_offset;
+
+	flag_offset = rte_be_to_cpu_16(ip_hdr->fragment_offset);
+	*ofs = (uint16_t)(flag_offset & IPV4_HDR_OFFSET_MASK);//偏移
+	*flag = (uint16_t)(flag_offset & IPV4_HDR_MF_FLAG);//MF字段
+
+	psd = (const unaligned_uint64_t *)&ip_hdr->src_addr;
+	/* use first 8 bytes only */
+	key->src_dst[0] = psd[0];
+	key->id = ip_hdr->packet_id;
+	key->key_len = IPV4_KEYLEN;
+
+	*ofs *= IPV4_HDR_OFFSET_UNITS; //剩以8表示真实偏移
+	*len = (uint16_t)(rte_be_to_cpu_16(ip_hdr->total_length) -
+		mb->l3_len);//IP负载的大小
+}
+
 /*
  * Process new mbuf with fragment of IPV4 packet.
  * Incoming mbuf should have it's l2_len/l3_len fields setuped correclty.
@@ -122,23 +114,10 @@ rte_ipv4_frag_reassemble_packet(struct rte_ip_frag_tbl *tbl,
 {
 	struct ip_frag_pkt *fp;
 	struct ip_frag_key key;
-	const unaligned_uint64_t *psd;
 	uint16_t ip_len;
-	uint16_t flag_offset, ip_ofs, ip_flag;
-
-	flag_offset = rte_be_to_cpu_16(ip_hdr->fragment_offset);
-	ip_ofs = (uint16_t)(flag_offset & IPV4_HDR_OFFSET_MASK);//偏移
-	ip_flag = (uint16_t)(flag_offset & IPV4_HDR_MF_FLAG);//MF字段
-
-	psd = (unaligned_uint64_t *)&ip_hdr->src_addr;
-	/* use first 8 bytes only */
-	key.src_dst[0] = psd[0];
-	key.id = ip_hdr->packet_id;
-	key.key_len = IPV4_KEYLEN;
+	uint16_t ip_ofs, ip_flag;
 
-	ip_ofs *= IPV4_HDR_OFFSET_UNITS; //剩以8表示真实偏移
-	ip_len = (uint16_t)(rte_be_to_cpu_16(ip_hdr->total_length) -
-		mb->l3_len);//IP负载的大小
+	ipv4_frag_parse(mb, ip_hdr, &key, &ip_ofs, &ip_len, &ip_flag);
 
 	IP_FRAG_LOG(DEBUG, "%s:%d:\n"
 		"mbuf: %p, tms: %" PRIu64
@@ -150,8 +129,13 @@ rte_ipv4_frag_reassemble_packet(struct rte_ip_frag_tbl *tbl,
 		tbl, tbl->max_cycles, tbl->entry_mask, tbl->max_entries,
 		tbl->use_entries);
 
+	/* shared table: find the entry and process under the bucket locks. */
+	if (tbl->shared != 0)
+		return ip_frag_shared_process(tbl, dr, mb, &key, NULL, tms,
+			ip_ofs, ip_len, ip_flag);
+
 	//通过Cuckoo hash算法得到分片的ip_frag_pkt结构体，或者得到一个空的结构体
-	if ((fp = ip_frag_find(tbl, dr, &key, tms)) == NULL) {
+	if ((fp = ip_frag_find(tbl, dr, &key, NULL, tms)) == NULL) {
 		IP_FRAG_MBUF2DR(dr, mb);
 		return NULL;
 	}
@@ -167,7 +151,7 @@ rte_ipv4_frag_reassemble_packet(struct rte_ip_frag_tbl *tbl,
 
 
 	//如果能够重组所有分配，那么重组如果不能，那么将新的分片存储到结构体中
-	mb = ip_frag_process(fp, dr, mb, ip_ofs, ip_len, ip_flag);
+	mb = ip_frag_process(tbl, fp, dr, mb, ip_ofs, ip_len, ip_flag);
 	ip_frag_inuse(tbl, fp);
 
 	IP_FRAG_LOG(DEBUG, "%s:%d:\n"
@@ -182,3 +166,54 @@ rte_ipv4_frag_reassemble_packet(struct rte_ip_frag_tbl *tbl,
 
 	return mb;
 }
+
+/*
+ * Process a burst of mbufs with IPv4 fragments.
+ * The fragments are processed IP_FRAG_BULK_SIZE at a time: their keys are
+ * hashed and their buckets prefetched, then they are added to the table and
+ * the death row is freed.
+ */
+uint16_t
+rte_ipv4_frag_reassemble_bulk(struct rte_ip_frag_tbl *tbl,
+	struct rte_ip_frag_death_row *dr, struct rte_mbuf **pkts_in,
+	uint16_t nb_pkts, uint64_t tms, struct rte_mbuf **pkts_out)
+{
+	struct ip_frag_bulk frag[IP_FRAG_BULK_SIZE];
+	struct ipv4_hdr *ip_hdr;
+	struct rte_mbuf *mb;
+	uint32_t i, j, k, n, nb_out;
+
+	nb_out = 0;
+	for (i = 0; i < nb_pkts; i += n) {
+		n = RTE_MIN(nb_pkts - i, (uint32_t)IP_FRAG_BULK_SIZE);
+
+		/* not fragmented packets go out first. */
+		k = 0;
+		for (j = 0; j != n; j++) {
+			mb = pkts_in[i + j];
+			ip_hdr = rte_pktmbuf_mtod_offset(mb, struct ipv4_hdr *,
+				mb->l2_len);
+			if (rte_ipv4_frag_pkt_is_fragmented(ip_hdr) == 0) {
+				pkts_out[nb_out++] = mb;
+				continue;
+			}
+
+			frag[k].mb = mb;
+			ipv4_frag_parse(mb, ip_hdr, &frag[k].key, &frag[k].ofs,
+				&frag[k].len, &frag[k].more_frags);
+			k++;
+		}
+
+		ip_frag_bulk_prefetch(tbl, frag, k);
+
+		for (j = 0; j != k; j++) {
+			mb = ip_frag_bulk_process(tbl, dr, &frag[j], tms);
+			if (mb != NULL)
+				pkts_out[nb_out++] = mb;
+		}
+
+		rte_ip_frag_free_death_row(dr, IP_FRAG_BULK_PREFETCH);
+	}
+
+	return nb_out;
+}
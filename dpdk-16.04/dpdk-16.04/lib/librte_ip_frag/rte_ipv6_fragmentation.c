@@ -205,3 +205,129 @@ rte_ipv6_fragment_packet(struct rte_mbuf *pkt_in,
 
 	return out_pkt_pos;
 }
+
+/* IPv6 header followed by the fragment header, as put in every fragment */
+struct ipv6_frag_hdr {
+	struct ipv6_hdr ip;
+	struct ipv6_extension_fragment fh;
+};
+
+/**
+ * IPv6 fragmentation, with bulk allocation of the output mbufs.
+ *
+ * The direct and indirect mbufs are taken from their pools
+ * IP_FRAG_ALLOC_BULK at a time, and the IPv6 and fragment headers are
+ * copied from a template where only the length and offset change.
+ *
+ * @param pkt_in
+ *   The input packet.
+ * @param pkts_out
+ *   Array storing the output fragments.
+ * @param nb_pkts_out
+ *   Number of entries in the pkts_out array.
+ * @param mtu_size
+ *   Size in bytes of the Maximum Transfer Unit (MTU) for the outgoing IPv6
+ *   datagrams. This value includes the size of the IPv6 header.
+ * @param pool_direct
+ *   MBUF pool used for allocating direct buffers for the output fragments.
+ * @param pool_indirect
+ *   MBUF pool used for allocating indirect buffers for the output fragments.
+ * @param flags
+ *   RTE_IP_FRAG_TX_CKSUM_OFFLOAD to set PKT_TX_IPV6 on the fragments.
+ * @return
+ *   Upon successful completion - number of output fragments placed
+ *   in the pkts_out array.
+ *   Otherwise - (-1) * <errno>.
+ */
+int32_t
+rte_ipv6_fragment_packet_bulk(struct rte_mbuf *pkt_in,
+	struct rte_mbuf **pkts_out,
+	uint16_t nb_pkts_out,
+	uint16_t mtu_size,
+	struct rte_mempool *pool_direct,
+	struct rte_mempool *pool_indirect,
+	uint32_t flags)
+{
+	struct ip_frag_mcache dir, ind;
+	struct rte_mbuf *in_seg, *out_pkt;
+	struct ipv6_frag_hdr tmpl, *out_hdr;
+	uint64_t ol_flags;
+	uint32_t i, nb_frags, payload, in_seg_data_pos, mf;
+	uint16_t fragment_offset, frag_size;
+
+	if (unlikely(mtu_size < sizeof(struct ipv6_frag_hdr)))
+		return -EINVAL;
+
+	/* payload of all fragments but the last, a multiple of 8 bytes */
+	frag_size = (uint16_t)(mtu_size - sizeof(struct ipv6_frag_hdr));
+	frag_size &= RTE_IPV6_EHDR_FO_MASK;
+	if (unlikely(frag_size == 0))
+		return -EINVAL;
+
+	payload = pkt_in->pkt_len - sizeof(struct ipv6_hdr);
+	nb_frags = (payload + frag_size - 1) / frag_size;
+	nb_frags += (nb_frags == 0);
+	if (unlikely(nb_frags > nb_pkts_out))
+		return -EINVAL;
+
+	tmpl.ip = *rte_pktmbuf_mtod(pkt_in, struct ipv6_hdr *);
+	tmpl.fh.next_header = tmpl.ip.proto;
+	tmpl.fh.reserved = 0;
+	tmpl.fh.frag_data = 0;
+	tmpl.fh.id = 0;
+	tmpl.ip.proto = IPPROTO_FRAGMENT;
+
+	ol_flags = (flags & RTE_IP_FRAG_TX_CKSUM_OFFLOAD) ? PKT_TX_IPV6 : 0;
+
+	/* every input segment boundary may add an indirect mbuf */
+	ip_frag_mcache_init(&dir, pool_direct, nb_frags);
+	ip_frag_mcache_init(&ind, pool_indirect,
+		nb_frags + pkt_in->nb_segs - 1);
+
+	in_seg = pkt_in;
+	in_seg_data_pos = sizeof(struct ipv6_hdr);
+	fragment_offset = 0;
+
+	for (i = 0; i != nb_frags; i++) {
+
+		out_pkt = ip_frag_mcache_get(&dir);
+		if (unlikely(out_pkt == NULL))
+			goto nomem;
+		rte_pktmbuf_reset(out_pkt);
+		out_pkt->data_len = sizeof(struct ipv6_frag_hdr);
+		out_pkt->pkt_len = sizeof(struct ipv6_frag_hdr);
+
+		if (unlikely(ip_frag_attach_payload(out_pkt,
+				sizeof(struct ipv6_frag_hdr) + frag_size,
+				&in_seg, &in_seg_data_pos, &ind) != 0)) {
+			rte_pktmbuf_free(out_pkt);
+			goto nomem;
+		}
+
+		mf = (i != nb_frags - 1);
+
+		out_hdr = rte_pktmbuf_mtod(out_pkt, struct ipv6_frag_hdr *);
+		*out_hdr = tmpl;
+		out_hdr->ip.payload_len = rte_cpu_to_be_16(out_pkt->pkt_len -
+			sizeof(struct ipv6_hdr));
+		out_hdr->fh.frag_data = rte_cpu_to_be_16(
+			RTE_IPV6_SET_FRAG_DATA(fragment_offset, mf));
+
+		out_pkt->ol_flags = ol_flags;
+		out_pkt->l3_len = sizeof(struct ipv6_frag_hdr);
+
+		fragment_offset = (uint16_t)(fragment_offset +
+			out_pkt->pkt_len - sizeof(struct ipv6_frag_hdr));
+		pkts_out[i] = out_pkt;
+	}
+
+	/* unused indirect mbufs, if input segments ended on fragment ends */
+	ip_frag_mcache_flush(&ind);
+	return nb_frags;
+
+nomem:
+	ip_frag_mcache_flush(&dir);
+	ip_frag_mcache_flush(&ind);
+	__free_fragments(pkts_out, i);
+	return -ENOMEM;
+}
@@ -63,49 +63,16 @@ ipv6_frag_reassemble(const struct ip_frag_pkt *fp)
 {
 	struct ipv6_hdr *ip_hdr;
 	struct ipv6_extension_fragment *frag_hdr;
-	struct rte_mbuf *m, *prev;
-	uint32_t i, n, ofs, first_len;
-	uint32_t last_len, move_len, payload_len;
+	struct rte_mbuf *m;
+	uint32_t move_len, payload_len;
 
-	first_len = fp->frags[IP_FIRST_FRAG_IDX].len;
-	n = fp->last_idx - 1;
+	payload_len = fp->frags[IP_LAST_FRAG_IDX].ofs +
+		fp->frags[IP_LAST_FRAG_IDX].len;
 
-	/*start from the last fragment. */
-	m = fp->frags[IP_LAST_FRAG_IDX].mb;
-	ofs = fp->frags[IP_LAST_FRAG_IDX].ofs;
-	last_len = fp->frags[IP_LAST_FRAG_IDX].len;
-
-	payload_len = ofs + last_len;
-
-	while (ofs != first_len) {
-
-		prev = m;
-
-		for (i = n; i != IP_FIRST_FRAG_IDX && ofs != first_len; i--) {
-
-			/* previous fragment found. */
-			if (fp->frags[i].ofs + fp->frags[i].len == ofs) {
-
-				/* adjust start of the last fragment data. */
-				rte_pktmbuf_adj(m, (uint16_t)(m->l2_len + m->l3_len));
-				rte_pktmbuf_chain(fp->frags[i].mb, m);
-
-				/* update our last fragment and offset. */
-				m = fp->frags[i].mb;
-				ofs = fp->frags[i].ofs;
-			}
-		}
-
-		/* error - hole in the packet. */
-		if (m == prev) {
-			return NULL;
-		}
-	}
-
-	/* chain with the first fragment. */
-	rte_pktmbuf_adj(m, (uint16_t)(m->l2_len + m->l3_len));
-	rte_pktmbuf_chain(fp->frags[IP_FIRST_FRAG_IDX].mb, m);
-	m = fp->frags[IP_FIRST_FRAG_IDX].mb;
+	/* chain all fragments after the first one. */
+	m = ip_frag_chain(fp);
+	if (m == NULL)
+		return NULL;
 
 	/* update mbuf fields for reassembled packet. */
 	m->ol_flags |= PKT_TX_IP_CKSUM;
@@ -154,29 +121,41 @@ ipv6_frag_reassemble(const struct ip_frag_pkt *fp)
  */
 #define MORE_FRAGS(x) (((x) & 0x100) >> 8)
 #define FRAG_OFFSET(x) (rte_cpu_to_be_16(x) >> 3)
-struct rte_mbuf *
-rte_ipv6_frag_reassemble_packet(struct rte_ip_frag_tbl *tbl,
-		struct rte_ip_frag_death_row *dr, struct rte_mbuf *mb, uint64_t tms,
-		struct ipv6_hdr *ip_hdr, struct ipv6_extension_fragment *frag_hdr)
-{
-	struct ip_frag_pkt *fp;
-	struct ip_frag_key key;
-	uint16_t ip_len, ip_ofs;
 
-	rte_memcpy(&key.src_dst[0], ip_hdr->src_addr, 16);
-	rte_memcpy(&key.src_dst[2], ip_hdr->dst_addr, 16);
+/*
+ * Build the key of an IPv6 fragment, get its offset and length.
+ */
+static inline void
+ipv6_frag_parse(const struct ipv6_hdr *ip_hdr,
+	const struct ipv6_extension_fragment *frag_hdr,
+	struct ip_frag_key *key, uint16_t *ofs, uint16_t *len)
+{
+	rte_memcpy(&key->src_dst[0], ip_hdr->src_addr, 16);
+	rte_memcpy(&key->src_dst[2], ip_hdr->dst_addr, 16);
 
-	key.id = frag_hdr->id;
-	key.key_len = IPV6_KEYLEN;
+	key->id = frag_hdr->id;
+	key->key_len = IPV6_KEYLEN;
 
-	ip_ofs = FRAG_OFFSET(frag_hdr->frag_data) * 8;
+	*ofs = FRAG_OFFSET(frag_hdr->frag_data) * 8;
 
 	/*
 	 * as per RFC2460, payload length contains all extension headers as well.
 	 * since we don't support anything but frag headers, this is what we remove
 	 * from the payload len.
 	 */
-	ip_len = rte_be_to_cpu_16(ip_hdr->payload_len) - sizeof(*frag_hdr);
+	*len = rte_be_to_cpu_16(ip_hdr->payload_len) - sizeof(*frag_hdr);
+}
+
+struct rte_mbuf *
+rte_ipv6_frag_reassemble_packet(struct rte_ip_frag_tbl *tbl,
+		struct rte_ip_frag_death_row *dr, struct rte_mbuf *mb, uint64_t tms,
+		struct ipv6_hdr *ip_hdr, struct ipv6_extension_fragment *frag_hdr)
+{
+	struct ip_frag_pkt *fp;
+	struct ip_frag_key key;
+	uint16_t ip_len, ip_ofs;
+
+	ipv6_frag_parse(ip_hdr, frag_hdr, &key, &ip_ofs, &ip_len);
 
 	IP_FRAG_LOG(DEBUG, "%s:%d:\n"
 		"mbuf: %p, tms: %" PRIu64
@@ -189,8 +168,13 @@ rte_ipv6_frag_reassemble_packet(struct rte_ip_frag_tbl *tbl,
 		tbl, tbl->max_cycles, tbl->entry_mask, tbl->max_entries,
 		tbl->use_entries);
 
+	/* shared table: find the entry and process under the bucket locks. */
+	if (tbl->shared != 0)
+		return ip_frag_shared_process(tbl, dr, mb, &key, NULL, tms,
+			ip_ofs, ip_len, MORE_FRAGS(frag_hdr->frag_data));
+
 	/* try to find/add entry into the fragment's table. */
-	fp = ip_frag_find(tbl, dr, &key, tms);
+	fp = ip_frag_find(tbl, dr, &key, NULL, tms);
 	if (fp == NULL) {
 		IP_FRAG_MBUF2DR(dr, mb);
 		return NULL;
@@ -207,7 +191,7 @@ rte_ipv6_frag_reassemble_packet(struct rte_ip_frag_tbl *tbl,
 
 
 	/* process the fragmented packet. */
-	mb = ip_frag_process(fp, dr, mb, ip_ofs, ip_len,
+	mb = ip_frag_process(tbl, fp, dr, mb, ip_ofs, ip_len,
 			MORE_FRAGS(frag_hdr->frag_data));
 	ip_frag_inuse(tbl, fp);
 
@@ -223,3 +207,57 @@ rte_ipv6_frag_reassemble_packet(struct rte_ip_frag_tbl *tbl,
 
 	return mb;
 }
+
+/*
+ * Process a burst of mbufs with IPv6 fragments.
+ * The fragments are processed IP_FRAG_BULK_SIZE at a time: their keys are
+ * hashed and their buckets prefetched, then they are added to the table and
+ * the death row is freed.
+ */
+uint16_t
+rte_ipv6_frag_reassemble_bulk(struct rte_ip_frag_tbl *tbl,
+	struct rte_ip_frag_death_row *dr, struct rte_mbuf **pkts_in,
+	uint16_t nb_pkts, uint64_t tms, struct rte_mbuf **pkts_out)
+{
+	struct ip_frag_bulk frag[IP_FRAG_BULK_SIZE];
+	struct ipv6_extension_fragment *frag_hdr;
+	struct ipv6_hdr *ip_hdr;
+	struct rte_mbuf *mb;
+	uint32_t i, j, k, n, nb_out;
+
+	nb_out = 0;
+	for (i = 0; i < nb_pkts; i += n) {
+		n = RTE_MIN(nb_pkts - i, (uint32_t)IP_FRAG_BULK_SIZE);
+
+		/* not fragmented packets go out first. */
+		k = 0;
+		for (j = 0; j != n; j++) {
+			mb = pkts_in[i + j];
+			ip_hdr = rte_pktmbuf_mtod_offset(mb, struct ipv6_hdr *,
+				mb->l2_len);
+			frag_hdr = rte_ipv6_frag_get_ipv6_fragment_header(ip_hdr);
+			if (frag_hdr == NULL) {
+				pkts_out[nb_out++] = mb;
+				continue;
+			}
+
+			frag[k].mb = mb;
+			frag[k].more_frags = MORE_FRAGS(frag_hdr->frag_data);
+			ipv6_frag_parse(ip_hdr, frag_hdr, &frag[k].key,
+				&frag[k].ofs, &frag[k].len);
+			k++;
+		}
+
+		ip_frag_bulk_prefetch(tbl, frag, k);
+
+		for (j = 0; j != k; j++) {
+			mb = ip_frag_bulk_process(tbl, dr, &frag[j], tms);
+			if (mb != NULL)
+				pkts_out[nb_out++] = mb;
+		}
+
+		rte_ip_frag_free_death_row(dr, IP_FRAG_BULK_PREFETCH);
+	}
+
+	return nb_out;
+}
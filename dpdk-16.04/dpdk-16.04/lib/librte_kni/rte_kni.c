@@ -61,6 +61,16 @@
 
 #define KNI_MEM_CHECK(cond) do { if (cond) goto kni_fail; } while (0)
 
+/**
+ * KNI queue, the FIFOs shared with one kernel queue of the KNI device
+ */
+struct rte_kni_queue {
+	struct rte_kni_fifo *tx_q;          /**< TX queue */
+	struct rte_kni_fifo *rx_q;          /**< RX queue */
+	struct rte_kni_fifo *alloc_q;       /**< Allocated mbufs queue */
+	struct rte_kni_fifo *free_q;        /**< To be freed mbufs queue */
+};
+
 /**
  * KNI context
  */
@@ -71,10 +81,8 @@ struct rte_kni {
 	struct rte_mempool *pktmbuf_pool;   /**< pkt mbuf mempool */
 	unsigned mbuf_size;                 /**< mbuf size */
 
-	struct rte_kni_fifo *tx_q;          /**< TX queue */
-	struct rte_kni_fifo *rx_q;          /**< RX queue */
-	struct rte_kni_fifo *alloc_q;       /**< Allocated mbufs queue */
-	struct rte_kni_fifo *free_q;        /**< To be freed mbufs queue */
+	uint16_t nb_queues;                 /**< Number of queues */
+	struct rte_kni_queue queues[RTE_KNI_MAX_QUEUES]; /**< Queues */
 
 	/* For request & response */
 	struct rte_kni_fifo *req_q;         /**< Request queue */
@@ -106,6 +114,8 @@ struct rte_kni_memzone_slot {
 	const struct rte_memzone *m_req_q;     /**< Request queue */
 	const struct rte_memzone *m_resp_q;    /**< Response queue */
 	const struct rte_memzone *m_sync_addr;
+	/** FIFOs of queues 1 and up, reserved when first used */
+	const struct rte_memzone *m_queues[RTE_KNI_MAX_QUEUES];
 
 	/* Free linked list */
 	struct rte_kni_memzone_slot *next;     /**< Next slot link.list */
@@ -127,8 +137,8 @@ struct rte_kni_memzone_pool {
 };
 
 
-static void kni_free_mbufs(struct rte_kni *kni);
-static void kni_allocate_mbufs(struct rte_kni *kni);
+static void kni_free_mbufs(struct rte_kni_queue *q);
+static void kni_allocate_mbufs(struct rte_kni *kni, struct rte_kni_queue *q);
 
 static volatile int kni_fd = -1;
 static struct rte_kni_memzone_pool kni_memzone_pool = {
@@ -172,6 +182,26 @@ kni_memzone_pool_alloc(void)
 	return slot;
 }
 
+/*
+ * Get the memzone holding the tx, rx, alloc and free FIFOs of an extra
+ * queue of a slot, one after the other. As the preallocated memzones of
+ * queue 0, it is kept in the slot once reserved.
+ */
+static const struct rte_memzone *
+kni_memzone_queue(struct rte_kni_memzone_slot *slot, unsigned queue_id)
+{
+	char mz_name[RTE_MEMZONE_NAMESIZE];
+
+	if (slot->m_queues[queue_id] == NULL) {
+		snprintf(mz_name, RTE_MEMZONE_NAMESIZE, "kni_q_%u_%u",
+			 slot->id, queue_id);
+		slot->m_queues[queue_id] = kni_memzone_reserve(mz_name,
+				KNI_FIFO_SIZE * 4, SOCKET_ID_ANY, 0);
+	}
+
+	return slot->m_queues[queue_id];
+}
+
 static void
 kni_memzone_pool_release(struct rte_kni_memzone_slot *slot)
 {
@@ -222,7 +252,7 @@ rte_kni_init(unsigned int max_kni_ifaces)
 
 	/* Allocate slot objects */
 	kni_memzone_pool.slots = (struct rte_kni_memzone_slot *)
-					rte_malloc(NULL,
+					rte_zmalloc(NULL,
 					sizeof(struct rte_kni_memzone_slot) *
 					max_kni_ifaces,
 					0);
@@ -324,10 +354,19 @@ rte_kni_alloc(struct rte_mempool *pktmbuf_pool,
 	char mz_name[RTE_MEMZONE_NAMESIZE];
 	const struct rte_memzone *mz;
 	struct rte_kni_memzone_slot *slot = NULL;
+	struct rte_kni_queue *q;
+	unsigned nb_queues, i;
 
 	if (!pktmbuf_pool || !conf || !conf->name[0])
 		return NULL;
 
+	nb_queues = conf->nb_queues == 0 ? 1 : conf->nb_queues;
+	if (nb_queues > RTE_KNI_MAX_QUEUES) {
+		RTE_LOG(ERR, KNI, "Invalid number of queues %u, max %u\n",
+			nb_queues, RTE_KNI_MAX_QUEUES);
+		return NULL;
+	}
+
 	/* Check if KNI subsystem has been initialized */
 	if (kni_memzone_pool.initialized != 1) {
 		RTE_LOG(ERR, KNI, "KNI subsystem has not been initialized. Invoke rte_kni_init() first\n");
@@ -372,28 +411,52 @@ rte_kni_alloc(struct rte_mempool *pktmbuf_pool,
 		dev_info.bus, dev_info.devid, dev_info.function,
 			dev_info.vendor_id, dev_info.device_id);
 	/* TX RING */
+	q = &ctx->queues[0];
 	mz = slot->m_tx_q;
-	ctx->tx_q = mz->addr;
-	kni_fifo_init(ctx->tx_q, KNI_FIFO_COUNT_MAX);
-	dev_info.tx_phys = mz->phys_addr;
+	q->tx_q = mz->addr;
+	dev_info.queues[0].tx_phys = mz->phys_addr;
 
 	/* RX RING */
 	mz = slot->m_rx_q;
-	ctx->rx_q = mz->addr;
-	kni_fifo_init(ctx->rx_q, KNI_FIFO_COUNT_MAX);
-	dev_info.rx_phys = mz->phys_addr;
+	q->rx_q = mz->addr;
+	dev_info.queues[0].rx_phys = mz->phys_addr;
 
 	/* ALLOC RING */
 	mz = slot->m_alloc_q;
-	ctx->alloc_q = mz->addr;
-	kni_fifo_init(ctx->alloc_q, KNI_FIFO_COUNT_MAX);
-	dev_info.alloc_phys = mz->phys_addr;
+	q->alloc_q = mz->addr;
+	dev_info.queues[0].alloc_phys = mz->phys_addr;
 
 	/* FREE RING */
 	mz = slot->m_free_q;
-	ctx->free_q = mz->addr;
-	kni_fifo_init(ctx->free_q, KNI_FIFO_COUNT_MAX);
-	dev_info.free_phys = mz->phys_addr;
+	q->free_q = mz->addr;
+	dev_info.queues[0].free_phys = mz->phys_addr;
+
+	/* TX, RX, ALLOC and FREE RINGs of the other queues */
+	for (i = 1; i < nb_queues; i++) {
+		q = &ctx->queues[i];
+		mz = kni_memzone_queue(slot, i);
+		KNI_MEM_CHECK(mz == NULL);
+		q->tx_q = mz->addr;
+		dev_info.queues[i].tx_phys = mz->phys_addr;
+		q->rx_q = RTE_PTR_ADD(mz->addr, KNI_FIFO_SIZE);
+		dev_info.queues[i].rx_phys = mz->phys_addr + KNI_FIFO_SIZE;
+		q->alloc_q = RTE_PTR_ADD(mz->addr, KNI_FIFO_SIZE * 2);
+		dev_info.queues[i].alloc_phys = mz->phys_addr +
+						KNI_FIFO_SIZE * 2;
+		q->free_q = RTE_PTR_ADD(mz->addr, KNI_FIFO_SIZE * 3);
+		dev_info.queues[i].free_phys = mz->phys_addr +
+					       KNI_FIFO_SIZE * 3;
+	}
+
+	for (i = 0; i < nb_queues; i++) {
+		q = &ctx->queues[i];
+		kni_fifo_init(q->tx_q, KNI_FIFO_COUNT_MAX);
+		kni_fifo_init(q->rx_q, KNI_FIFO_COUNT_MAX);
+		kni_fifo_init(q->alloc_q, KNI_FIFO_COUNT_MAX);
+		kni_fifo_init(q->free_q, KNI_FIFO_COUNT_MAX);
+	}
+	ctx->nb_queues = nb_queues;
+	dev_info.nb_queues = nb_queues;
 
 	/* Request RING */
 	mz = slot->m_req_q;
@@ -431,8 +494,9 @@ rte_kni_alloc(struct rte_mempool *pktmbuf_pool,
 
 	ctx->in_use = 1;
 
-	/* Allocate mbufs and then put them into alloc_q */
-	kni_allocate_mbufs(ctx);
+	/* Allocate mbufs and then put them into alloc_q of each queue */
+	for (i = 0; i < nb_queues; i++)
+		kni_allocate_mbufs(ctx, &ctx->queues[i]);
 
 	return ctx;
 
@@ -460,7 +524,9 @@ int
 rte_kni_release(struct rte_kni *kni)
 {
 	struct rte_kni_device_info dev_info;
+	struct rte_kni_queue *q;
 	uint32_t slot_id;
+	unsigned i;
 
 	if (!kni || !kni->in_use)
 		return -1;
@@ -472,10 +538,13 @@ rte_kni_release(struct rte_kni *kni)
 	}
 
 	/* mbufs in all fifo should be released, except request/response */
-	kni_free_fifo(kni->tx_q);
-	kni_free_fifo(kni->rx_q);
-	kni_free_fifo(kni->alloc_q);
-	kni_free_fifo(kni->free_q);
+	for (i = 0; i < kni->nb_queues; i++) {
+		q = &kni->queues[i];
+		kni_free_fifo(q->tx_q);
+		kni_free_fifo(q->rx_q);
+		kni_free_fifo(q->alloc_q);
+		kni_free_fifo(q->free_q);
+	}
 
 	slot_id = kni->slot_id;
 
@@ -539,35 +608,63 @@ rte_kni_handle_request(struct rte_kni *kni)
 }
 
 unsigned
-rte_kni_tx_burst(struct rte_kni *kni, struct rte_mbuf **mbufs, unsigned num)
+rte_kni_tx_burst_queue(struct rte_kni *kni, uint16_t queue_id,
+		       struct rte_mbuf **mbufs, unsigned num)
 {
-	unsigned ret = kni_fifo_put(kni->rx_q, (void **)mbufs, num);
+	struct rte_kni_queue *q;
+	unsigned ret;
+
+	if (unlikely(queue_id >= kni->nb_queues))
+		return 0;
+
+	q = &kni->queues[queue_id];
+	ret = kni_fifo_put(q->rx_q, (void **)mbufs, num);
 
 	/* Get mbufs from free_q and then free them */
-	kni_free_mbufs(kni);
+	kni_free_mbufs(q);
 
 	return ret;
 }
 
 unsigned
-rte_kni_rx_burst(struct rte_kni *kni, struct rte_mbuf **mbufs, unsigned num)
+rte_kni_rx_burst_queue(struct rte_kni *kni, uint16_t queue_id,
+		       struct rte_mbuf **mbufs, unsigned num)
 {
-	unsigned ret = kni_fifo_get(kni->tx_q, (void **)mbufs, num);
+	struct rte_kni_queue *q;
+	unsigned ret;
+
+	if (unlikely(queue_id >= kni->nb_queues))
+		return 0;
+
+	q = &kni->queues[queue_id];
+	ret = kni_fifo_get(q->tx_q, (void **)mbufs, num);
 
 	/* If buffers removed, allocate mbufs and then put them into alloc_q */
 	if (ret)
-		kni_allocate_mbufs(kni);
+		kni_allocate_mbufs(kni, q);
 
 	return ret;
 }
 
+unsigned
+rte_kni_tx_burst(struct rte_kni *kni, struct rte_mbuf **mbufs, unsigned num)
+{
+	return rte_kni_tx_burst_queue(kni, 0, mbufs, num);
+}
+
+unsigned
+rte_kni_rx_burst(struct rte_kni *kni, struct rte_mbuf **mbufs, unsigned num)
+{
+	return rte_kni_rx_burst_queue(kni, 0, mbufs, num);
+}
+
 static void
-kni_free_mbufs(struct rte_kni *kni)
+kni_free_mbufs(struct rte_kni_queue *q)
 {
 	int i, ret;
 	struct rte_mbuf *pkts[MAX_MBUF_BURST_NUM];
 
-	ret = kni_fifo_get(kni->free_q, (void **)pkts, MAX_MBUF_BURST_NUM);
+	ret = kni_fifo_get(q->free_q, (void **)pkts, MAX_MBUF_BURST_NUM);
 	if (likely(ret > 0)) {
 		for (i = 0; i < ret; i++)
 			rte_pktmbuf_free(pkts[i]);
@@ -575,9 +672,9 @@ kni_free_mbufs(struct rte_kni *kni)
 }
 
 static void
-kni_allocate_mbufs(struct rte_kni *kni)
+kni_allocate_mbufs(struct rte_kni *kni, struct rte_kni_queue *q)
 {
-	int i, ret;
+	unsigned i, num, ret;
 	struct rte_mbuf *pkts[MAX_MBUF_BURST_NUM];
 
 	RTE_BUILD_BUG_ON(offsetof(struct rte_mbuf, pool) !=
@@ -601,28 +698,31 @@ kni_allocate_mbufs(struct rte_kni *kni)
 		return;
 	}
 
-	for (i = 0; i < MAX_MBUF_BURST_NUM; i++) {
-		pkts[i] = rte_pktmbuf_alloc(kni->pktmbuf_pool);
-		if (unlikely(pkts[i] == NULL)) {
+	/* Only refill the entries the kernel has consumed */
+	num = RTE_MIN(kni_fifo_free_count(q->alloc_q),
+		      (unsigned)MAX_MBUF_BURST_NUM);
+	if (num == 0)
+		return;
+
+	/*
+	 * The bulk get takes all the mbufs or none: when the pool runs low,
+	 * halve the bulk until what is left in the pool can fill it.
+	 */
+	while (unlikely(rte_pktmbuf_alloc_bulk(kni->pktmbuf_pool, pkts,
+					       num) != 0)) {
+		if (num == 1) {
 			/* Out of memory */
 			RTE_LOG(ERR, KNI, "Out of memory\n");
-			break;
+			return;
 		}
+		num /= 2;
 	}
 
-	/* No pkt mbuf alocated */
-	if (i <= 0)
-		return;
-
-	ret = kni_fifo_put(kni->alloc_q, (void **)pkts, i);
+	ret = kni_fifo_put(q->alloc_q, (void **)pkts, num);
 
 	/* Check if any mbufs not put into alloc_q, and then free them */
-	if (ret >= 0 && ret < i && ret < MAX_MBUF_BURST_NUM) {
-		int j;
-
-		for (j = ret; j < i; j++)
-			rte_pktmbuf_free(pkts[j]);
-	}
+	for (i = ret; i < num; i++)
+		rte_pktmbuf_free(pkts[i]);
 }
 
 struct rte_kni *
@@ -89,6 +89,12 @@ struct rte_kni_conf {
 	struct rte_pci_id id;
 
 	uint8_t force_bind : 1; /* Flag to bind kernel thread */
+	/*
+	 * Number of queues, up to RTE_KNI_MAX_QUEUES, 0 meaning 1. In
+	 * multiple kernel thread mode, each queue is polled by its own
+	 * kernel thread, bound to core core_id + queue index if force_bind.
+	 */
+	uint16_t nb_queues;
 };
 
 /**
@@ -195,6 +201,48 @@ unsigned rte_kni_rx_burst(struct rte_kni *kni, struct rte_mbuf **mbufs,
 unsigned rte_kni_tx_burst(struct rte_kni *kni, struct rte_mbuf **mbufs,
 		unsigned num);
 
+/**
+ * Retrieve a burst of packets from a queue of a KNI interface, as
+ * rte_kni_rx_burst() does for queue 0. Each queue can be used by a
+ * different lcore, but a queue must not be used by several lcores
+ * concurrently.
+ *
+ * @param kni
+ *  The KNI interface context.
+ * @param queue_id
+ *  The index of the queue, lower than the nb_queues of its configuration.
+ * @param mbufs
+ *  The array to store the pointers of mbufs.
+ * @param num
+ *  The maximum number per burst.
+ *
+ * @return
+ *  The actual number of packets retrieved, 0 for an invalid queue_id.
+ */
+unsigned rte_kni_rx_burst_queue(struct rte_kni *kni, uint16_t queue_id,
+		struct rte_mbuf **mbufs, unsigned num);
+
+/**
+ * Send a burst of packets to a queue of a KNI interface, as
+ * rte_kni_tx_burst() does for queue 0. Each queue can be used by a
+ * different lcore, but a queue must not be used by several lcores
+ * concurrently.
+ *
+ * @param kni
+ *  The KNI interface context.
+ * @param queue_id
+ *  The index of the queue, lower than the nb_queues of its configuration.
+ * @param mbufs
+ *  The array to store the pointers of mbufs.
+ * @param num
+ *  The maximum number per burst.
+ *
+ * @return
+ *  The actual number of packets sent, 0 for an invalid queue_id.
+ */
+unsigned rte_kni_tx_burst_queue(struct rte_kni *kni, uint16_t queue_id,
+		struct rte_mbuf **mbufs, unsigned num);
+
 /**
  * Get the KNI context of its name.
  *
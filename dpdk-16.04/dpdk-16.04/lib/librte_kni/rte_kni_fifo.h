@@ -51,43 +51,72 @@ kni_fifo_init(struct rte_kni_fifo *fifo, unsigned size)
 
 /**
  * Adds num elements into the fifo. Return the number actually written
+ *
+ * The elements are copied in bulk, in at most two parts when wrapping
+ * around the end of the buffer, and the write index is updated once.
  */
 static inline unsigned
 kni_fifo_put(struct rte_kni_fifo *fifo, void **data, unsigned num)
 {
-	unsigned i = 0;
 	unsigned fifo_write = fifo->write;
 	unsigned fifo_read = fifo->read;
-	unsigned new_write = fifo_write;
+	unsigned mask = fifo->len - 1;
+	void **buffer = (void **)(uintptr_t)fifo->buffer;
+	unsigned n, first;
+
+	/* One entry is always left empty: write == read means empty */
+	n = RTE_MIN((fifo_read - fifo_write - 1) & mask, num);
+	if (n == 0)
+		return 0;
 
-	for (i = 0; i < num; i++) {
-		new_write = (new_write + 1) & (fifo->len - 1);
+	first = RTE_MIN(fifo->len - fifo_write, n);
+	memcpy(buffer + fifo_write, data, first * sizeof(void *));
+	memcpy(buffer, data + first, (n - first) * sizeof(void *));
 
-		if (new_write == fifo_read)
-			break;
-		fifo->buffer[fifo_write] = data[i];
-		fifo_write = new_write;
-	}
-	fifo->write = fifo_write;
-	return i;
+	/* The elements are written before they are published */
+	rte_smp_wmb();
+	fifo->write = (fifo_write + n) & mask;
+
+	return n;
 }
 
 /**
  * Get up to num elements from the fifo. Return the number actully read
+ *
+ * The elements are copied in bulk, in at most two parts when wrapping
+ * around the end of the buffer, and the read index is updated once.
  */
 static inline unsigned
 kni_fifo_get(struct rte_kni_fifo *fifo, void **data, unsigned num)
 {
-	unsigned i = 0;
-	unsigned new_read = fifo->read;
+	unsigned fifo_read = fifo->read;
 	unsigned fifo_write = fifo->write;
-	for (i = 0; i < num; i++) {
-		if (new_read == fifo_write)
-			break;
+	unsigned mask = fifo->len - 1;
+	void **buffer = (void **)(uintptr_t)fifo->buffer;
+	unsigned n, first;
+
+	/* The elements are read after the write index publishing them */
+	rte_smp_rmb();
+	n = RTE_MIN((fifo_write - fifo_read) & mask, num);
+	if (n == 0)
+		return 0;
+
+	first = RTE_MIN(fifo->len - fifo_read, n);
+	memcpy(data, buffer + fifo_read, first * sizeof(void *));
+	memcpy(data + first, buffer, (n - first) * sizeof(void *));
 
-		data[i] = fifo->buffer[new_read];
-		new_read = (new_read + 1) & (fifo->len - 1);
-	}
-	fifo->read = new_read;
-	return i;
+	/* The elements are read before their entries are given back */
+	rte_smp_mb();
+	fifo->read = (fifo_read + n) & mask;
+
+	return n;
+}
+
+/**
+ * Get the num of available elements in the fifo
+ */
+static inline unsigned
+kni_fifo_free_count(struct rte_kni_fifo *fifo)
+{
+	return (fifo->read - fifo->write - 1) & (fifo->len - 1);
 }
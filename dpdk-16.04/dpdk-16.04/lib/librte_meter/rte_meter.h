@@ -50,6 +50,14 @@ extern "C" {
 
 #include <stdint.h>
 
+#include <rte_prefetch.h>
+
+/** Number of meters prefetched ahead by the burst traffic metering functions.
+Compile-time configurable. */
+#ifndef RTE_METER_BURST_PREFETCH
+#define RTE_METER_BURST_PREFETCH 4
+#endif
+
 /*
  * Application Programmer's Interface (API)
  *
@@ -190,6 +198,106 @@ rte_meter_trtcm_color_aware_check(struct rte_meter_trtcm *m,
 	uint32_t pkt_len,
 	enum rte_meter_color pkt_color);
 
+/**
+ * srTCM color blind traffic metering of a burst of packets. All the packets
+ * are metered against the same time stamp, so it only needs to be read once
+ * per burst. Several packets of the burst may use the same meter, they are
+ * metered in array order.
+ *
+ * @param m
+ *    Array of n_pkts handles to srTCM instances, one per packet
+ * @param time
+ *    Current CPU time stamp (measured in CPU cycles)
+ * @param pkt_len
+ *    Array of n_pkts IP packet lengths (measured in bytes)
+ * @param pkt_color
+ *    Array of n_pkts entries where the colors assigned to the packets
+ *    are stored
+ * @param n_pkts
+ *    Number of packets in the burst
+ */
+static inline void
+rte_meter_srtcm_color_blind_check_burst(struct rte_meter_srtcm **m,
+	uint64_t time,
+	const uint32_t *pkt_len,
+	enum rte_meter_color *pkt_color,
+	uint32_t n_pkts);
+
+/**
+ * srTCM color aware traffic metering of a burst of packets. All the packets
+ * are metered against the same time stamp, so it only needs to be read once
+ * per burst. Several packets of the burst may use the same meter, they are
+ * metered in array order.
+ *
+ * @param m
+ *    Array of n_pkts handles to srTCM instances, one per packet
+ * @param time
+ *    Current CPU time stamp (measured in CPU cycles)
+ * @param pkt_len
+ *    Array of n_pkts IP packet lengths (measured in bytes)
+ * @param pkt_color
+ *    Array of n_pkts packet colors, the input colors are replaced by the
+ *    colors assigned to the packets
+ * @param n_pkts
+ *    Number of packets in the burst
+ */
+static inline void
+rte_meter_srtcm_color_aware_check_burst(struct rte_meter_srtcm **m,
+	uint64_t time,
+	const uint32_t *pkt_len,
+	enum rte_meter_color *pkt_color,
+	uint32_t n_pkts);
+
+/**
+ * trTCM color blind traffic metering of a burst of packets. All the packets
+ * are metered against the same time stamp, so it only needs to be read once
+ * per burst. Several packets of the burst may use the same meter, they are
+ * metered in array order.
+ *
+ * @param m
+ *    Array of n_pkts handles to trTCM instances, one per packet
+ * @param time
+ *    Current CPU time stamp (measured in CPU cycles)
+ * @param pkt_len
+ *    Array of n_pkts IP packet lengths (measured in bytes)
+ * @param pkt_color
+ *    Array of n_pkts entries where the colors assigned to the packets
+ *    are stored
+ * @param n_pkts
+ *    Number of packets in the burst
+ */
+static inline void
+rte_meter_trtcm_color_blind_check_burst(struct rte_meter_trtcm **m,
+	uint64_t time,
+	const uint32_t *pkt_len,
+	enum rte_meter_color *pkt_color,
+	uint32_t n_pkts);
+
+/**
+ * trTCM color aware traffic metering of a burst of packets. All the packets
+ * are metered against the same time stamp, so it only needs to be read once
+ * per burst. Several packets of the burst may use the same meter, they are
+ * metered in array order.
+ *
+ * @param m
+ *    Array of n_pkts handles to trTCM instances, one per packet
+ * @param time
+ *    Current CPU time stamp (measured in CPU cycles)
+ * @param pkt_len
+ *    Array of n_pkts IP packet lengths (measured in bytes)
+ * @param pkt_color
+ *    Array of n_pkts packet colors, the input colors are replaced by the
+ *    colors assigned to the packets
+ * @param n_pkts
+ *    Number of packets in the burst
+ */
+static inline void
+rte_meter_trtcm_color_aware_check_burst(struct rte_meter_trtcm **m,
+	uint64_t time,
+	const uint32_t *pkt_len,
+	enum rte_meter_color *pkt_color,
+	uint32_t n_pkts);
+
 /*
  * Inline implementation of run-time methods
  *
@@ -380,6 +488,98 @@ rte_meter_trtcm_color_aware_check(struct rte_meter_trtcm *m,
 	return e_RTE_METER_GREEN;
 }
 
+static inline void
+rte_meter_srtcm_color_blind_check_burst(struct rte_meter_srtcm **m,
+	uint64_t time,
+	const uint32_t *pkt_len,
+	enum rte_meter_color *pkt_color,
+	uint32_t n_pkts)
+{
+	uint32_t i;
+
+	/* The meter contexts are scattered across the flow table, fetch
+	 * them ahead of their turn */
+	for (i = 0; (i < n_pkts) && (i < RTE_METER_BURST_PREFETCH); i++)
+		rte_prefetch0(m[i]);
+
+	for (i = 0; i < n_pkts; i++) {
+		if (i + RTE_METER_BURST_PREFETCH < n_pkts)
+			rte_prefetch0(m[i + RTE_METER_BURST_PREFETCH]);
+
+		pkt_color[i] = rte_meter_srtcm_color_blind_check(m[i],
+			time,
+			pkt_len[i]);
+	}
+}
+
+static inline void
+rte_meter_srtcm_color_aware_check_burst(struct rte_meter_srtcm **m,
+	uint64_t time,
+	const uint32_t *pkt_len,
+	enum rte_meter_color *pkt_color,
+	uint32_t n_pkts)
+{
+	uint32_t i;
+
+	for (i = 0; (i < n_pkts) && (i < RTE_METER_BURST_PREFETCH); i++)
+		rte_prefetch0(m[i]);
+
+	for (i = 0; i < n_pkts; i++) {
+		if (i + RTE_METER_BURST_PREFETCH < n_pkts)
+			rte_prefetch0(m[i + RTE_METER_BURST_PREFETCH]);
+
+		pkt_color[i] = rte_meter_srtcm_color_aware_check(m[i],
+			time,
+			pkt_len[i],
+			pkt_color[i]);
+	}
+}
+
+static inline void
+rte_meter_trtcm_color_blind_check_burst(struct rte_meter_trtcm **m,
+	uint64_t time,
+	const uint32_t *pkt_len,
+	enum rte_meter_color *pkt_color,
+	uint32_t n_pkts)
+{
+	uint32_t i;
+
+	for (i = 0; (i < n_pkts) && (i < RTE_METER_BURST_PREFETCH); i++)
+		rte_prefetch0(m[i]);
+
+	for (i = 0; i < n_pkts; i++) {
+		if (i + RTE_METER_BURST_PREFETCH < n_pkts)
+			rte_prefetch0(m[i + RTE_METER_BURST_PREFETCH]);
+
+		pkt_color[i] = rte_meter_trtcm_color_blind_check(m[i],
+			time,
+			pkt_len[i]);
+	}
+}
+
+static inline void
+rte_meter_trtcm_color_aware_check_burst(struct rte_meter_trtcm **m,
+	uint64_t time,
+	const uint32_t *pkt_len,
+	enum rte_meter_color *pkt_color,
+	uint32_t n_pkts)
+{
+	uint32_t i;
+
+	for (i = 0; (i < n_pkts) && (i < RTE_METER_BURST_PREFETCH); i++)
+		rte_prefetch0(m[i]);
+
+	for (i = 0; i < n_pkts; i++) {
+		if (i + RTE_METER_BURST_PREFETCH < n_pkts)
+			rte_prefetch0(m[i + RTE_METER_BURST_PREFETCH]);
+
+		pkt_color[i] = rte_meter_trtcm_color_aware_check(m[i],
+			time,
+			pkt_len[i],
+			pkt_color[i]);
+	}
+}
+
 #ifdef __cplusplus
 }
 #endif
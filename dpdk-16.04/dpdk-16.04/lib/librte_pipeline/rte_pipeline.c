@@ -45,6 +45,7 @@
 #include <rte_string_fns.h>
 
 #include "rte_pipeline.h"
+#include "pipeline_private.h"
 
 #define RTE_TABLE_INVALID                                 UINT32_MAX
 
@@ -117,6 +118,16 @@ struct rte_table {
 	struct rte_pipeline_table_entry *default_entry;
 	uint32_t entry_size;
 
+	/* Entry size seen by the user, without the entry stats block */
+	uint32_t entry_user_size;
+
+	/* Offset of the entry stats block within each entry, 0 when disabled */
+	uint32_t entry_stats_offset;
+
+	/* Scratch entry with cleared stats, used by the entry add and delete
+	operations when entry stats are enabled */
+	uint8_t *entry_buf;
+
 	uint32_t table_next_id;
 	uint32_t table_next_id_valid;
 
@@ -138,6 +149,9 @@ struct rte_pipeline {
 	int socket_id;
 	uint32_t offset_port_id;
 
+	/* Features of the pipeline run implementation in use */
+	uint32_t run_spec;
+
 	/* Internal tables */
 	struct rte_port_in ports_in[RTE_PIPELINE_PORT_IN_MAX];
 	struct rte_port_out ports_out[RTE_PIPELINE_PORT_OUT_MAX];
@@ -178,6 +192,14 @@ rte_mask_get_prev(uint64_t mask, uint32_t pos)
 	return ((63 - __builtin_clzll(mask_rot)) + pos) & 0x3F;
 }
 
+static inline struct rte_pipeline_table_entry_stats *
+rte_pipeline_table_entry_stats(struct rte_table *table,
+	struct rte_pipeline_table_entry *entry)
+{
+	return (struct rte_pipeline_table_entry_stats *)
+		&((uint8_t *) entry)[table->entry_stats_offset];
+}
+
 static void
 rte_pipeline_table_free(struct rte_table *table);
 
@@ -257,6 +279,7 @@ rte_pipeline_create(struct rte_pipeline_params *params)
 	p->port_in_next = NULL;
 	p->pkts_mask = 0;
 	p->n_pkts_ah_drop = 0;
+	p->run_spec = RTE_PIPELINE_RUN_SPEC_ALL;
 
 	return p;
 }
@@ -300,6 +323,51 @@ rte_pipeline_free(struct rte_pipeline *p)
 	return 0;
 }
 
+int
+rte_pipeline_run_spec_set(struct rte_pipeline *p, uint32_t spec)
+{
+	/* Check input parameters */
+	if (p == NULL) {
+		RTE_LOG(ERR, PIPELINE,
+			"%s: rte_pipeline parameter is NULL\n", __func__);
+		return -EINVAL;
+	}
+
+	if ((spec & ~RTE_PIPELINE_RUN_SPEC_ALL) != 0) {
+		RTE_LOG(ERR, PIPELINE,
+			"%s: Invalid value for spec parameter\n", __func__);
+		return -EINVAL;
+	}
+
+	if (p->num_ports_in || p->num_ports_out || p->num_tables) {
+		RTE_LOG(ERR, PIPELINE,
+			"%s: Pipeline ports or tables already created\n",
+			__func__);
+		return -EINVAL;
+	}
+
+	p->run_spec = spec;
+
+	return 0;
+}
+
+static int
+rte_pipeline_run_spec_check_action(struct rte_pipeline *p,
+	struct rte_pipeline_table_entry *entry)
+{
+	if (((entry->action == RTE_PIPELINE_ACTION_PORT_META) &&
+		((p->run_spec & RTE_PIPELINE_RUN_SPEC_ACTION_PORT_META) == 0)) ||
+		((entry->action == RTE_PIPELINE_ACTION_TABLE) &&
+		((p->run_spec & RTE_PIPELINE_RUN_SPEC_ACTION_TABLE) == 0))) {
+		RTE_LOG(ERR, PIPELINE,
+			"%s: Action %u not in the pipeline run spec\n",
+			__func__, (uint32_t) entry->action);
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
 /*
  * Table
  *
@@ -344,6 +412,24 @@ rte_table_check_params(struct rte_pipeline *p,
 		return -EINVAL;
 	}
 
+	/* Pipeline run spec */
+	if (((params->f_action_hit != NULL) ||
+		(params->f_action_miss != NULL)) &&
+		((p->run_spec & RTE_PIPELINE_RUN_SPEC_AH) == 0)) {
+		RTE_LOG(ERR, PIPELINE,
+			"%s: Action handlers not in the pipeline run spec\n",
+			__func__);
+		return -EINVAL;
+	}
+
+	if (params->entry_stats_en &&
+		((p->run_spec & RTE_PIPELINE_RUN_SPEC_ENTRY_STATS) == 0)) {
+		RTE_LOG(ERR, PIPELINE,
+			"%s: Entry stats not in the pipeline run spec\n",
+			__func__);
+		return -EINVAL;
+	}
+
 	/* De we have room for one more table? */
 	if (p->num_tables == RTE_PIPELINE_TABLE_MAX) {
 		RTE_LOG(ERR, PIPELINE,
@@ -362,8 +448,9 @@ rte_pipeline_table_create(struct rte_pipeline *p,
 {
 	struct rte_table *table;
 	struct rte_pipeline_table_entry *default_entry;
+	uint8_t *entry_buf = NULL;
 	void *h_table;
-	uint32_t entry_size, id;
+	uint32_t entry_size, entry_user_size, entry_stats_offset, id;
 	int status;
 
 	/* Check input arguments */
@@ -374,9 +461,23 @@ rte_pipeline_table_create(struct rte_pipeline *p,
 	id = p->num_tables;
 	table = &p->tables[id];
 
-	/* Allocate space for the default table entry */
-	entry_size = sizeof(struct rte_pipeline_table_entry) +
+	/* Table entry size, with the entry stats block appended after the
+	action data. An entry size that is a power of two is kept a power of two,
+	as some table types require it. */
+	entry_user_size = sizeof(struct rte_pipeline_table_entry) +
 		params->action_data_size;
+	entry_size = entry_user_size;
+	entry_stats_offset = 0;
+	if (params->entry_stats_en) {
+		entry_stats_offset = RTE_ALIGN_CEIL(entry_user_size,
+			sizeof(uint64_t));
+		entry_size = entry_stats_offset +
+			sizeof(struct rte_pipeline_table_entry_stats);
+		if (rte_is_power_of_2(entry_user_size))
+			entry_size = rte_align32pow2(entry_size);
+	}
+
+	/* Allocate space for the default table entry */
 	default_entry = (struct rte_pipeline_table_entry *) rte_zmalloc_socket(
 		"PIPELINE", entry_size, RTE_CACHE_LINE_SIZE, p->socket_id);
 	if (default_entry == NULL) {
@@ -385,10 +486,23 @@ rte_pipeline_table_create(struct rte_pipeline *p,
 		return -EINVAL;
 	}
 
+	if (params->entry_stats_en) {
+		entry_buf = rte_zmalloc_socket("PIPELINE", entry_size,
+			RTE_CACHE_LINE_SIZE, p->socket_id);
+		if (entry_buf == NULL) {
+			rte_free(default_entry);
+			RTE_LOG(ERR, PIPELINE,
+				"%s: Failed to allocate scratch entry\n",
+				__func__);
+			return -EINVAL;
+		}
+	}
+
 	/* Create the table */
 	h_table = params->ops->f_create(params->arg_create, p->socket_id,
 		entry_size);
 	if (h_table == NULL) {
+		rte_free(entry_buf);
 		rte_free(default_entry);
 		RTE_LOG(ERR, PIPELINE, "%s: Table creation failed\n", __func__);
 		return -EINVAL;
@@ -404,6 +518,9 @@ rte_pipeline_table_create(struct rte_pipeline *p,
 	table->f_action_miss = params->f_action_miss;
 	table->arg_ah = params->arg_ah;
 	table->entry_size = entry_size;
+	table->entry_user_size = entry_user_size;
+	table->entry_stats_offset = entry_stats_offset;
+	table->entry_buf = entry_buf;
 
 	/* Clear the lookup miss actions (to be set later through API) */
 	table->default_entry = default_entry;
@@ -417,12 +534,41 @@ rte_pipeline_table_create(struct rte_pipeline *p,
 	return 0;
 }
 
+int
+rte_pipeline_table_free_last(struct rte_pipeline *p, uint32_t table_id)
+{
+	struct rte_table *table;
+
+	if ((p == NULL) || (p->num_tables == 0) ||
+		(table_id != p->num_tables - 1))
+		return -EINVAL;
+
+	table = &p->tables[table_id];
+	rte_pipeline_table_free(table);
+	memset(table, 0, sizeof(*table));
+	p->num_tables--;
+
+	return 0;
+}
+
+static struct rte_pipeline_table_entry *
+rte_pipeline_table_entry_stats_init(struct rte_table *table,
+	struct rte_pipeline_table_entry *entry, uint8_t *buf)
+{
+	memcpy(buf, entry, table->entry_user_size);
+	memset(&buf[table->entry_user_size], 0,
+		table->entry_size - table->entry_user_size);
+
+	return (struct rte_pipeline_table_entry *) buf;
+}
+
 void
 rte_pipeline_table_free(struct rte_table *table)
 {
 	if (table->ops.f_free != NULL)
 		table->ops.f_free(table->h_table);
 
+	rte_free(table->entry_buf);
 	rte_free(table->default_entry);
 }
 
@@ -455,6 +601,9 @@ rte_pipeline_table_default_entry_add(struct rte_pipeline *p,
 
 	table = &p->tables[table_id];
 
+	if (rte_pipeline_run_spec_check_action(p, default_entry))
+		return -EINVAL;
+
 	if ((default_entry->action == RTE_PIPELINE_ACTION_TABLE) &&
 		table->table_next_id_valid &&
 		(default_entry->table_id != table->table_next_id)) {
@@ -470,7 +619,9 @@ rte_pipeline_table_default_entry_add(struct rte_pipeline *p,
 		table->table_next_id_valid = 1;
 	}
 
-	memcpy(table->default_entry, default_entry, table->entry_size);
+	memcpy(table->default_entry, default_entry, table->entry_user_size);
+	memset(&((uint8_t *) table->default_entry)[table->entry_user_size], 0,
+		table->entry_size - table->entry_user_size);
 
 	*default_entry_ptr = table->default_entry;
 	return 0;
@@ -500,7 +651,7 @@ rte_pipeline_table_default_entry_delete(struct rte_pipeline *p,
 
 	/* Save the current contents of the default entry */
 	if (entry)
-		memcpy(entry, table->default_entry, table->entry_size);
+		memcpy(entry, table->default_entry, table->entry_user_size);
 
 	/* Clear the lookup miss actions */
 	memset(table->default_entry, 0, table->entry_size);
@@ -551,6 +702,9 @@ rte_pipeline_table_entry_add(struct rte_pipeline *p,
 		return -EINVAL;
 	}
 
+	if (rte_pipeline_run_spec_check_action(p, entry))
+		return -EINVAL;
+
 	if ((entry->action == RTE_PIPELINE_ACTION_TABLE) &&
 		table->table_next_id_valid &&
 		(entry->table_id != table->table_next_id)) {
@@ -566,6 +720,11 @@ rte_pipeline_table_entry_add(struct rte_pipeline *p,
 		table->table_next_id_valid = 1;
 	}
 
+	/* Add the entry with cleared stats */
+	if (table->entry_stats_offset != 0)
+		entry = rte_pipeline_table_entry_stats_init(table, entry,
+			table->entry_buf);
+
 	return (table->ops.f_add)(table->h_table, key, (void *) entry,
 		key_found, (void **) entry_ptr);
 }
@@ -606,6 +765,18 @@ rte_pipeline_table_entry_delete(struct rte_pipeline *p,
 		return -EINVAL;
 	}
 
+	/* The user buffer has no room for the entry stats */
+	if ((table->entry_stats_offset != 0) && (entry != NULL)) {
+		int status;
+
+		status = (table->ops.f_delete)(table->h_table, key, key_found,
+			table->entry_buf);
+		if ((status == 0) && *key_found)
+			memcpy(entry, table->entry_buf, table->entry_user_size);
+
+		return status;
+	}
+
 	return (table->ops.f_delete)(table->h_table, key, key_found, entry);
 }
 
@@ -653,6 +824,9 @@ int rte_pipeline_table_entry_add_bulk(struct rte_pipeline *p,
 	}
 
 	for (i = 0; i < n_keys; i++) {
+		if (rte_pipeline_run_spec_check_action(p, entries[i]))
+			return -EINVAL;
+
 		if ((entries[i]->action == RTE_PIPELINE_ACTION_TABLE) &&
 			table->table_next_id_valid &&
 			(entries[i]->table_id != table->table_next_id)) {
@@ -671,6 +845,33 @@ int rte_pipeline_table_entry_add_bulk(struct rte_pipeline *p,
 		}
 	}
 
+	/* Add the entries with cleared stats */
+	if (table->entry_stats_offset != 0) {
+		struct rte_pipeline_table_entry **e;
+		uint8_t *buf;
+		int status;
+
+		e = rte_malloc("PIPELINE", n_keys * (sizeof(void *) +
+			table->entry_size), 0);
+		if (e == NULL) {
+			RTE_LOG(ERR, PIPELINE,
+				"%s: Failed to allocate scratch entries\n",
+				__func__);
+			return -ENOMEM;
+		}
+
+		buf = (uint8_t *) &e[n_keys];
+		for (i = 0; i < n_keys; i++)
+			e[i] = rte_pipeline_table_entry_stats_init(table,
+				entries[i], &buf[i * table->entry_size]);
+
+		status = (table->ops.f_add_bulk)(table->h_table, keys,
+			(void **) e, n_keys, key_found, (void **) entries_ptr);
+
+		rte_free(e);
+		return status;
+	}
+
 	return (table->ops.f_add_bulk)(table->h_table, keys, (void **) entries,
 		n_keys, key_found, (void **) entries_ptr);
 }
@@ -711,6 +912,39 @@ int rte_pipeline_table_entry_delete_bulk(struct rte_pipeline *p,
 		return -EINVAL;
 	}
 
+	/* The user buffers have no room for the entry stats */
+	if ((table->entry_stats_offset != 0) && (entries != NULL)) {
+		void **e;
+		uint8_t *buf;
+		uint32_t i;
+		int status;
+
+		e = rte_malloc("PIPELINE", n_keys * (sizeof(void *) +
+			table->entry_size), 0);
+		if (e == NULL) {
+			RTE_LOG(ERR, PIPELINE,
+				"%s: Failed to allocate scratch entries\n",
+				__func__);
+			return -ENOMEM;
+		}
+
+		buf = (uint8_t *) &e[n_keys];
+		for (i = 0; i < n_keys; i++)
+			e[i] = (entries[i] != NULL) ?
+				&buf[i * table->entry_size] : NULL;
+
+		status = (table->ops.f_delete_bulk)(table->h_table, keys,
+			n_keys, key_found, e);
+		if (status == 0)
+			for (i = 0; i < n_keys; i++)
+				if (key_found[i] && (e[i] != NULL))
+					memcpy(entries[i], e[i],
+						table->entry_user_size);
+
+		rte_free(e);
+		return status;
+	}
+
 	return (table->ops.f_delete_bulk)(table->h_table, keys, n_keys, key_found,
 			(void **) entries);
 }
@@ -758,6 +992,15 @@ rte_pipeline_port_in_check_params(struct rte_pipeline *p,
 		return -EINVAL;
 	}
 
+	/* Pipeline run spec */
+	if ((params->f_action != NULL) &&
+		((p->run_spec & RTE_PIPELINE_RUN_SPEC_AH) == 0)) {
+		RTE_LOG(ERR, PIPELINE,
+			"%s: Action handler not in the pipeline run spec\n",
+			__func__);
+		return -EINVAL;
+	}
+
 	/* burst_size */
 	if ((params->burst_size == 0) ||
 		(params->burst_size > RTE_PORT_IN_BURST_SIZE_MAX)) {
@@ -823,6 +1066,15 @@ rte_pipeline_port_out_check_params(struct rte_pipeline *p,
 		return -EINVAL;
 	}
 
+	/* Pipeline run spec */
+	if ((params->f_action != NULL) &&
+		((p->run_spec & RTE_PIPELINE_RUN_SPEC_AH) == 0)) {
+		RTE_LOG(ERR, PIPELINE,
+			"%s: Action handler not in the pipeline run spec\n",
+			__func__);
+		return -EINVAL;
+	}
+
 	/* Do we have room for one more port? */
 	if (p->num_ports_out == RTE_PIPELINE_PORT_OUT_MAX) {
 		RTE_LOG(ERR, PIPELINE,
@@ -1148,14 +1400,14 @@ rte_pipeline_compute_masks(struct rte_pipeline *p, uint64_t pkts_mask)
 
 static inline void
 rte_pipeline_action_handler_port_bulk(struct rte_pipeline *p,
-	uint64_t pkts_mask, uint32_t port_id)
+	uint64_t pkts_mask, uint32_t port_id, uint32_t spec)
 {
 	struct rte_port_out *port_out = &p->ports_out[port_id];
 
 	p->pkts_mask = pkts_mask;
 
 	/* Output port user actions */
-	if (port_out->f_action != NULL) {
+	if ((spec & RTE_PIPELINE_RUN_SPEC_AH) && (port_out->f_action != NULL)) {
 		port_out->f_action(p, p->pkts, pkts_mask, port_out->arg_ah);
 
 		RTE_PIPELINE_STATS_AH_DROP_READ(p,
@@ -1170,7 +1422,8 @@ rte_pipeline_action_handler_port_bulk(struct rte_pipeline *p,
 }
 
 static inline void
-rte_pipeline_action_handler_port(struct rte_pipeline *p, uint64_t pkts_mask)
+rte_pipeline_action_handler_port(struct rte_pipeline *p, uint64_t pkts_mask,
+	uint32_t spec)
 {
 	p->pkts_mask = pkts_mask;
 
@@ -1185,7 +1438,8 @@ rte_pipeline_action_handler_port(struct rte_pipeline *p, uint64_t pkts_mask)
 				&p->ports_out[port_out_id];
 
 			/* Output port user actions */
-			if (port_out->f_action == NULL) /* Output port TX */
+			if (((spec & RTE_PIPELINE_RUN_SPEC_AH) == 0) ||
+				(port_out->f_action == NULL)) /* Output port TX */
 				port_out->ops.f_tx(port_out->h_port, pkt);
 			else {
 				uint64_t pkt_mask = 1LLU << i;
@@ -1221,7 +1475,8 @@ rte_pipeline_action_handler_port(struct rte_pipeline *p, uint64_t pkts_mask)
 			port_out = &p->ports_out[port_out_id];
 
 			/* Output port user actions */
-			if (port_out->f_action == NULL) /* Output port TX */
+			if (((spec & RTE_PIPELINE_RUN_SPEC_AH) == 0) ||
+				(port_out->f_action == NULL)) /* Output port TX */
 				port_out->ops.f_tx(port_out->h_port, pkt);
 			else {
 				port_out->f_action(p,
@@ -1243,7 +1498,7 @@ rte_pipeline_action_handler_port(struct rte_pipeline *p, uint64_t pkts_mask)
 
 static inline void
 rte_pipeline_action_handler_port_meta(struct rte_pipeline *p,
-	uint64_t pkts_mask)
+	uint64_t pkts_mask, uint32_t spec)
 {
 	p->pkts_mask = pkts_mask;
 
@@ -1260,7 +1515,8 @@ rte_pipeline_action_handler_port_meta(struct rte_pipeline *p,
 				port_out_id];
 
 			/* Output port user actions */
-			if (port_out->f_action == NULL) /* Output port TX */
+			if (((spec & RTE_PIPELINE_RUN_SPEC_AH) == 0) ||
+				(port_out->f_action == NULL)) /* Output port TX */
 				port_out->ops.f_tx(port_out->h_port, pkt);
 			else {
 				uint64_t pkt_mask = 1LLU << i;
@@ -1297,7 +1553,8 @@ rte_pipeline_action_handler_port_meta(struct rte_pipeline *p,
 			port_out = &p->ports_out[port_out_id];
 
 			/* Output port user actions */
-			if (port_out->f_action == NULL) /* Output port TX */
+			if (((spec & RTE_PIPELINE_RUN_SPEC_AH) == 0) ||
+				(port_out->f_action == NULL)) /* Output port TX */
 				port_out->ops.f_tx(port_out->h_port, pkt);
 			else {
 				port_out->f_action(p,
@@ -1317,6 +1574,105 @@ rte_pipeline_action_handler_port_meta(struct rte_pipeline *p,
 	}
 }
 
+/*
+ * Lookup hit reserved actions for the pipelines using only the DROP and PORT
+ * actions: the packets are sent as they are looked up, with one bulk TX per
+ * run of consecutive packets going to the same output port, instead of one
+ * TX per packet.
+ */
+static inline void
+rte_pipeline_action_handler_port_direct(struct rte_pipeline *p,
+	uint64_t pkts_mask, uint32_t spec)
+{
+	uint64_t port_mask = 0, drop_mask = 0;
+	uint32_t port_id = 0;
+
+	for ( ; pkts_mask != 0; ) {
+		uint32_t pkt_index = __builtin_ctzll(pkts_mask);
+		uint64_t pkt_mask = 1LLU << pkt_index;
+		struct rte_pipeline_table_entry *e = p->entries[pkt_index];
+
+		pkts_mask &= ~pkt_mask;
+
+		if (e->action != RTE_PIPELINE_ACTION_PORT) {
+			drop_mask |= pkt_mask;
+			continue;
+		}
+
+		if ((e->port_id != port_id) && (port_mask != 0)) {
+			rte_pipeline_action_handler_port_bulk(p, port_mask,
+				port_id, spec);
+			port_mask = 0;
+		}
+
+		port_id = e->port_id;
+		port_mask |= pkt_mask;
+	}
+
+	if (port_mask != 0)
+		rte_pipeline_action_handler_port_bulk(p, port_mask, port_id,
+			spec);
+
+	p->action_mask0[RTE_PIPELINE_ACTION_DROP] |= drop_mask;
+}
+
+static inline void
+rte_pipeline_table_entry_stats_update(struct rte_pipeline *p,
+	struct rte_table *table, uint64_t lookup_hit_mask,
+	uint64_t lookup_miss_mask)
+{
+	struct rte_pipeline_table_entry_stats *stats;
+	struct rte_pipeline_table_entry *entry = NULL;
+	uint64_t n_pkts = 0, n_bytes = 0;
+
+	/* Lookup hit: the consecutive packets hitting the same entry, typically
+	the packets of the same flow, are counted with a single update */
+	for ( ; lookup_hit_mask != 0; ) {
+		uint32_t pkt_index = __builtin_ctzll(lookup_hit_mask);
+		struct rte_pipeline_table_entry *e = p->entries[pkt_index];
+
+		lookup_hit_mask &= ~(1LLU << pkt_index);
+
+		if (e != entry) {
+			if (entry != NULL) {
+				stats = rte_pipeline_table_entry_stats(table,
+					entry);
+				stats->n_pkts += n_pkts;
+				stats->n_bytes += n_bytes;
+			}
+
+			entry = e;
+			n_pkts = 0;
+			n_bytes = 0;
+		}
+
+		n_pkts++;
+		n_bytes += p->pkts[pkt_index]->pkt_len;
+	}
+
+	if (entry != NULL) {
+		stats = rte_pipeline_table_entry_stats(table, entry);
+		stats->n_pkts += n_pkts;
+		stats->n_bytes += n_bytes;
+	}
+
+	/* Lookup miss: all the packets go to the default entry */
+	if (lookup_miss_mask != 0) {
+		n_bytes = 0;
+		for (n_pkts = 0; lookup_miss_mask != 0; n_pkts++) {
+			uint32_t pkt_index = __builtin_ctzll(lookup_miss_mask);
+
+			lookup_miss_mask &= ~(1LLU << pkt_index);
+			n_bytes += p->pkts[pkt_index]->pkt_len;
+		}
+
+		stats = rte_pipeline_table_entry_stats(table,
+			table->default_entry);
+		stats->n_pkts += n_pkts;
+		stats->n_bytes += n_bytes;
+	}
+}
+
 static inline void
 rte_pipeline_action_handler_drop(struct rte_pipeline *p, uint64_t pkts_mask)
 {
@@ -1340,8 +1696,12 @@ rte_pipeline_action_handler_drop(struct rte_pipeline *p, uint64_t pkts_mask)
 	}
 }
 
-int
-rte_pipeline_run(struct rte_pipeline *p)
+/*
+ * Pipeline run template: spec is a compile time constant, so the code of the
+ * features not in the spec is removed by the compiler.
+ */
+static inline __attribute__((always_inline)) int
+rte_pipeline_run_internal(struct rte_pipeline *p, uint32_t spec)
 {
 	struct rte_port_in *port_in = p->port_in_next;
 	uint32_t n_pkts, table_id;
@@ -1364,7 +1724,7 @@ rte_pipeline_run(struct rte_pipeline *p)
 	p->action_mask0[RTE_PIPELINE_ACTION_TABLE] = 0;
 
 	/* Input port user actions */
-	if (port_in->f_action != NULL) {
+	if ((spec & RTE_PIPELINE_RUN_SPEC_AH) && (port_in->f_action != NULL)) {
 		port_in->f_action(p, p->pkts, n_pkts, port_in->arg_ah);
 
 		RTE_PIPELINE_STATS_AH_DROP_READ(p,
@@ -1382,6 +1742,12 @@ rte_pipeline_run(struct rte_pipeline *p)
 			&lookup_hit_mask, (void **) p->entries);
 		lookup_miss_mask = p->pkts_mask & (~lookup_hit_mask);
 
+		/* Table entry stats */
+		if ((spec & RTE_PIPELINE_RUN_SPEC_ENTRY_STATS) &&
+			(table->entry_stats_offset != 0))
+			rte_pipeline_table_entry_stats_update(p, table,
+				lookup_hit_mask, lookup_miss_mask);
+
 		/* Lookup miss */
 		if (lookup_miss_mask != 0) {
 			struct rte_pipeline_table_entry *default_entry =
@@ -1390,7 +1756,8 @@ rte_pipeline_run(struct rte_pipeline *p)
 			p->pkts_mask = lookup_miss_mask;
 
 			/* Table user actions */
-			if (table->f_action_miss != NULL) {
+			if ((spec & RTE_PIPELINE_RUN_SPEC_AH) &&
+				(table->f_action_miss != NULL)) {
 				table->f_action_miss(p,
 					p->pkts,
 					lookup_miss_mask,
@@ -1406,7 +1773,8 @@ rte_pipeline_run(struct rte_pipeline *p)
 				(p->pkts_mask != 0))
 				rte_pipeline_action_handler_port_bulk(p,
 					p->pkts_mask,
-					default_entry->port_id);
+					default_entry->port_id,
+					spec);
 			else {
 				uint32_t pos = default_entry->action;
 
@@ -1424,7 +1792,8 @@ rte_pipeline_run(struct rte_pipeline *p)
 			p->pkts_mask = lookup_hit_mask;
 
 			/* Table user actions */
-			if (table->f_action_hit != NULL) {
+			if ((spec & RTE_PIPELINE_RUN_SPEC_AH) &&
+				(table->f_action_hit != NULL)) {
 				table->f_action_hit(p,
 					p->pkts,
 					lookup_hit_mask,
@@ -1437,6 +1806,16 @@ rte_pipeline_run(struct rte_pipeline *p)
 
 			/* Table reserved actions */
 			RTE_PIPELINE_STATS_TABLE_DROP0(p);
+			if ((spec & (RTE_PIPELINE_RUN_SPEC_ACTION_PORT_META |
+				RTE_PIPELINE_RUN_SPEC_ACTION_TABLE)) == 0) {
+				rte_pipeline_action_handler_port_direct(p,
+					p->pkts_mask, spec);
+
+				RTE_PIPELINE_STATS_TABLE_DROP1(p,
+					table->n_pkts_dropped_lkp_hit);
+				break;
+			}
+
 			rte_pipeline_compute_masks(p, p->pkts_mask);
 			p->action_mask0[RTE_PIPELINE_ACTION_DROP] |=
 				p->action_mask1[
@@ -1462,12 +1841,15 @@ rte_pipeline_run(struct rte_pipeline *p)
 	}
 
 	/* Table reserved action PORT */
-	rte_pipeline_action_handler_port(p,
-		p->action_mask0[RTE_PIPELINE_ACTION_PORT]);
+	if (spec & (RTE_PIPELINE_RUN_SPEC_ACTION_PORT_META |
+		RTE_PIPELINE_RUN_SPEC_ACTION_TABLE))
+		rte_pipeline_action_handler_port(p,
+			p->action_mask0[RTE_PIPELINE_ACTION_PORT], spec);
 
 	/* Table reserved action PORT META */
-	rte_pipeline_action_handler_port_meta(p,
-		p->action_mask0[RTE_PIPELINE_ACTION_PORT_META]);
+	if (spec & RTE_PIPELINE_RUN_SPEC_ACTION_PORT_META)
+		rte_pipeline_action_handler_port_meta(p,
+			p->action_mask0[RTE_PIPELINE_ACTION_PORT_META], spec);
 
 	/* Table reserved action DROP */
 	rte_pipeline_action_handler_drop(p,
@@ -1479,6 +1861,55 @@ rte_pipeline_run(struct rte_pipeline *p)
 	return (int) n_pkts;
 }
 
+#define RTE_PIPELINE_RUN_SPEC(spec)					\
+static int								\
+rte_pipeline_run_spec##spec(struct rte_pipeline *p)			\
+{									\
+	return rte_pipeline_run_internal(p, spec);			\
+}
+
+RTE_PIPELINE_RUN_SPEC(0)
+RTE_PIPELINE_RUN_SPEC(1)
+RTE_PIPELINE_RUN_SPEC(2)
+RTE_PIPELINE_RUN_SPEC(3)
+RTE_PIPELINE_RUN_SPEC(4)
+RTE_PIPELINE_RUN_SPEC(5)
+RTE_PIPELINE_RUN_SPEC(6)
+RTE_PIPELINE_RUN_SPEC(7)
+RTE_PIPELINE_RUN_SPEC(8)
+RTE_PIPELINE_RUN_SPEC(9)
+RTE_PIPELINE_RUN_SPEC(10)
+RTE_PIPELINE_RUN_SPEC(11)
+RTE_PIPELINE_RUN_SPEC(12)
+RTE_PIPELINE_RUN_SPEC(13)
+RTE_PIPELINE_RUN_SPEC(14)
+RTE_PIPELINE_RUN_SPEC(15)
+
+static int (* const rte_pipeline_run_spec[])(struct rte_pipeline *p) = {
+	rte_pipeline_run_spec0,
+	rte_pipeline_run_spec1,
+	rte_pipeline_run_spec2,
+	rte_pipeline_run_spec3,
+	rte_pipeline_run_spec4,
+	rte_pipeline_run_spec5,
+	rte_pipeline_run_spec6,
+	rte_pipeline_run_spec7,
+	rte_pipeline_run_spec8,
+	rte_pipeline_run_spec9,
+	rte_pipeline_run_spec10,
+	rte_pipeline_run_spec11,
+	rte_pipeline_run_spec12,
+	rte_pipeline_run_spec13,
+	rte_pipeline_run_spec14,
+	rte_pipeline_run_spec15,
+};
+
+int
+rte_pipeline_run(struct rte_pipeline *p)
+{
+	return rte_pipeline_run_spec[p->run_spec](p);
+}
+
 int
 rte_pipeline_flush(struct rte_pipeline *p)
 {
@@ -1647,3 +2078,59 @@ int rte_pipeline_table_stats_read(struct rte_pipeline *p, uint32_t table_id,
 
 	return 0;
 }
+
+int rte_pipeline_table_entry_stats_read(struct rte_pipeline *p,
+	uint32_t table_id,
+	struct rte_pipeline_table_entry **entries,
+	uint32_t n_entries,
+	struct rte_pipeline_table_entry_stats *stats,
+	int clear)
+{
+	struct rte_table *table;
+	uint32_t i;
+
+	if (p == NULL) {
+		RTE_LOG(ERR, PIPELINE, "%s: pipeline parameter NULL\n",
+			__func__);
+		return -EINVAL;
+	}
+
+	if (entries == NULL) {
+		RTE_LOG(ERR, PIPELINE, "%s: entries parameter NULL\n",
+			__func__);
+		return -EINVAL;
+	}
+
+	if (table_id >= p->num_tables) {
+		RTE_LOG(ERR, PIPELINE,
+				"%s: table %u is out of range\n", __func__, table_id);
+		return -EINVAL;
+	}
+
+	table = &p->tables[table_id];
+	if (table->entry_stats_offset == 0) {
+		RTE_LOG(ERR, PIPELINE,
+			"%s: table %u has no entry stats\n", __func__, table_id);
+		return -EINVAL;
+	}
+
+	for (i = 0; i < n_entries; i++) {
+		struct rte_pipeline_table_entry_stats *entry_stats;
+
+		if (entries[i] == NULL) {
+			if (stats != NULL)
+				memset(&stats[i], 0, sizeof(stats[i]));
+			continue;
+		}
+
+		entry_stats = rte_pipeline_table_entry_stats(table, entries[i]);
+
+		if (stats != NULL)
+			memcpy(&stats[i], entry_stats, sizeof(stats[i]));
+
+		if (clear != 0)
+			memset(entry_stats, 0, sizeof(*entry_stats));
+	}
+
+	return 0;
+}
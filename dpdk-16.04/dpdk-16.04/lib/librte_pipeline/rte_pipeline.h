@@ -151,6 +151,15 @@ struct rte_pipeline_table_stats {
 	uint64_t n_pkts_dropped_lkp_miss;
 };
 
+/** Pipeline table entry stats. */
+struct rte_pipeline_table_entry_stats {
+	/** Number of packets that hit the table entry. */
+	uint64_t n_pkts;
+
+	/** Number of bytes of the packets that hit the table entry. */
+	uint64_t n_bytes;
+};
+
 /**
  * Pipeline create
  *
@@ -201,6 +210,52 @@ int rte_pipeline_run(struct rte_pipeline *p);
  */
 int rte_pipeline_flush(struct rte_pipeline *p);
 
+/*
+ * Pipeline run specialization
+ *
+ */
+/** Pipeline feature: input port, output port and table action handlers */
+#define RTE_PIPELINE_RUN_SPEC_AH                                (1 << 0)
+
+/** Pipeline feature: table entry statistics */
+#define RTE_PIPELINE_RUN_SPEC_ENTRY_STATS                       (1 << 1)
+
+/** Pipeline feature: reserved action "Send packet to output port read from
+	packet meta-data" */
+#define RTE_PIPELINE_RUN_SPEC_ACTION_PORT_META                  (1 << 2)
+
+/** Pipeline feature: reserved action "Send packet to table" */
+#define RTE_PIPELINE_RUN_SPEC_ACTION_TABLE                      (1 << 3)
+
+/** All the pipeline features, which is the default pipeline run spec */
+#define RTE_PIPELINE_RUN_SPEC_ALL                               0xF
+
+/**
+ * Pipeline run specialization
+ *
+ * Selects the implementation of rte_pipeline_run() that is compiled for the
+ * given set of pipeline features (RTE_PIPELINE_RUN_SPEC_*), with the code
+ * of the features left out of the spec removed and the masks known at
+ * compile time. The reserved actions "Drop the packet" and "Send packet to
+ * output port" are always available. When neither of the PORT_META and TABLE
+ * actions is in the spec, the packets of each lookup hit burst are sent to
+ * their output ports in bulk, one bulk per run of consecutive packets going
+ * to the same output port.
+ *
+ * Once the spec is set, the creation of any port or table, as well as the
+ * addition of any table entry, that needs a feature not in the spec fails.
+ * Therefore, this function has to be called before any port or table is
+ * added to the pipeline.
+ *
+ * @param p
+ *   Handle to pipeline instance
+ * @param spec
+ *   Bitmask of the pipeline features (RTE_PIPELINE_RUN_SPEC_*) to be used
+ * @return
+ *   0 on success, error code otherwise
+ */
+int rte_pipeline_run_spec_set(struct rte_pipeline *p, uint32_t spec);
+
 /*
  * Actions
  *
@@ -349,6 +404,13 @@ struct rte_pipeline_table_params {
 	/** Memory size to be reserved per table entry for storing the user
 	actions and their meta-data */
 	uint32_t action_data_size;
+	/** When non-zero, a block of packet and byte counters is reserved per
+	table entry, after the user actions and their meta-data, and updated by
+	the pipeline on lookup. The counters of the default entry are updated
+	on lookup miss. They are read through
+	rte_pipeline_table_entry_stats_read() and are cleared when the entry is
+	added. */
+	int entry_stats_en;
 };
 
 /**
@@ -555,6 +617,43 @@ int rte_pipeline_table_entry_delete_bulk(struct rte_pipeline *p,
 int rte_pipeline_table_stats_read(struct rte_pipeline *p, uint32_t table_id,
 	struct rte_pipeline_table_stats *stats, int clear);
 
+/**
+ * Read pipeline table entry stats.
+ *
+ * This function reads the per-entry statistics of the table entries
+ * identified by *entries* in the table *table_id* of given pipeline *p*. The
+ * table must have been created with the entry_stats_en parameter set.
+ *
+ * The counters are updated by rte_pipeline_run() without atomic operations,
+ * so this function is meant to be called by the CPU core running the
+ * pipeline, e.g. from its control message handlers, for the counters to be
+ * cleared without losing updates.
+ *
+ * @param p
+ *   Handle to pipeline instance.
+ * @param table_id
+ *   Table ID (returned by previous invocation of pipeline table create)
+ * @param entries
+ *   Array of *n_entries* table entry handles, as returned by the entry add
+ *   and default entry add functions. NULL elements are skipped and get all
+ *   their counters set to zero.
+ * @param n_entries
+ *   Number of table entries.
+ * @param stats
+ *   Array of *n_entries* statistics buffers. When NULL, the counters are only
+ *   cleared (if *clear* is set).
+ * @param clear
+ *   If not 0 clear stats after reading.
+ * @return
+ *   0 on success, error code otherwise
+ */
+int rte_pipeline_table_entry_stats_read(struct rte_pipeline *p,
+	uint32_t table_id,
+	struct rte_pipeline_table_entry **entries,
+	uint32_t n_entries,
+	struct rte_pipeline_table_entry_stats *stats,
+	int clear);
+
 /*
  * Port IN
  *
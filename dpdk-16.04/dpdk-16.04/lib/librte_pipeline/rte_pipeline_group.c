@@ -0,0 +1,790 @@
+/*-
+ *   BSD LICENSE
+ *
+ *   Copyright(c) 2016 Intel Corporation. All rights reserved.
+ *   All rights reserved.
+ *
+ *   Redistribution and use in source and binary forms, with or without
+ *   modification, are permitted provided that the following conditions
+ *   are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ *     * Neither the name of Intel Corporation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *   OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <string.h>
+#include <stdio.h>
+
+#include <rte_common.h>
+#include <rte_memory.h>
+#include <rte_malloc.h>
+#include <rte_log.h>
+#include <rte_atomic.h>
+#include <rte_spinlock.h>
+#include <rte_branch_prediction.h>
+
+#include "rte_pipeline_group.h"
+#include "pipeline_private.h"
+
+#define RTE_PIPELINE_GROUP_MAX_NAME_SZ                     124
+
+enum pipeline_group_req_type {
+	PIPELINE_GROUP_REQ_DEFAULT_ENTRY_ADD = 0,
+	PIPELINE_GROUP_REQ_DEFAULT_ENTRY_DELETE,
+	PIPELINE_GROUP_REQ_ENTRY_ADD,
+	PIPELINE_GROUP_REQ_ENTRY_DELETE,
+};
+
+/* Table update, executed by each shard on its own table */
+struct pipeline_group_req {
+	enum pipeline_group_req_type type;
+	uint32_t table_id;
+	void *key;
+	struct rte_pipeline_table_entry *entry;
+
+	/* Shared table: the running shards pause while the control function
+	 * updates the table for all of them */
+	int shared;
+	rte_atomic32_t n_paused;
+	volatile uint32_t done;
+
+	/* Per shard results */
+	int status[RTE_PIPELINE_GROUP_SHARDS_MAX];
+	int key_found[RTE_PIPELINE_GROUP_SHARDS_MAX];
+	struct rte_pipeline_table_entry *entry_ptr[RTE_PIPELINE_GROUP_SHARDS_MAX];
+};
+
+struct pipeline_group_shard {
+	struct rte_pipeline *p;
+
+	/* Protects the running state against the control functions */
+	rte_spinlock_t lock;
+	volatile uint32_t running;
+
+	/* Table update posted to the shard, NULL once executed */
+	struct pipeline_group_req * volatile req;
+} __rte_cache_aligned;
+
+struct rte_pipeline_group {
+	char name[RTE_PIPELINE_GROUP_MAX_NAME_SZ];
+	uint32_t n_shards;
+
+	/* Serializes the control functions */
+	rte_spinlock_t ctrl_lock;
+
+	/* Tables */
+	uint32_t n_tables;
+	uint8_t table_shared[RTE_PIPELINE_TABLE_MAX];
+
+	struct pipeline_group_shard shards[0];
+} __rte_cache_aligned;
+
+/*
+ * Shared table
+ *
+ * The first shard creates and frees the low-level table, the other shards
+ * create a reference to it, with the entry add and delete operations being
+ * no-ops, as the table is updated through the first shard only. The low-level
+ * table is not thread safe, so it is only updated while none of the shards is
+ * running.
+ */
+struct pipeline_group_table_ref {
+	struct rte_table_ops *ops;
+	void *arg_create;
+	void *h_table;
+};
+
+static void *
+pipeline_group_table_owner_create(void *params, int socket_id,
+	uint32_t entry_size)
+{
+	struct pipeline_group_table_ref *ref = params;
+
+	ref->h_table = ref->ops->f_create(ref->arg_create, socket_id,
+		entry_size);
+
+	return ref->h_table;
+}
+
+static void *
+pipeline_group_table_ref_create(void *params,
+	__rte_unused int socket_id,
+	__rte_unused uint32_t entry_size)
+{
+	struct pipeline_group_table_ref *ref = params;
+
+	return ref->h_table;
+}
+
+static int
+pipeline_group_table_ref_add(__rte_unused void *table,
+	__rte_unused void *key,
+	__rte_unused void *entry,
+	int *key_found,
+	void **entry_ptr)
+{
+	*key_found = 0;
+	*entry_ptr = NULL;
+	return 0;
+}
+
+static int
+pipeline_group_table_ref_delete(__rte_unused void *table,
+	__rte_unused void *key,
+	int *key_found,
+	__rte_unused void *entry)
+{
+	*key_found = 0;
+	return 0;
+}
+
+/*
+ * Pipeline group
+ *
+ */
+struct rte_pipeline_group *
+rte_pipeline_group_create(struct rte_pipeline_group_params *params)
+{
+	struct rte_pipeline_group *g;
+	uint32_t i;
+
+	/* Check input parameters */
+	if (params == NULL) {
+		RTE_LOG(ERR, PIPELINE, "%s: params parameter is NULL\n",
+			__func__);
+		return NULL;
+	}
+
+	if (params->name == NULL) {
+		RTE_LOG(ERR, PIPELINE,
+			"%s: Incorrect value for parameter name\n", __func__);
+		return NULL;
+	}
+
+	if ((params->n_shards == 0) ||
+		(params->n_shards > RTE_PIPELINE_GROUP_SHARDS_MAX)) {
+		RTE_LOG(ERR, PIPELINE,
+			"%s: Incorrect value for parameter n_shards\n",
+			__func__);
+		return NULL;
+	}
+
+	/* Allocate memory for the pipeline group */
+	g = rte_zmalloc_socket("PIPELINE", sizeof(struct rte_pipeline_group) +
+		params->n_shards * sizeof(struct pipeline_group_shard),
+		RTE_CACHE_LINE_SIZE, params->socket_id);
+	if (g == NULL) {
+		RTE_LOG(ERR, PIPELINE,
+			"%s: Pipeline group memory allocation failed\n",
+			__func__);
+		return NULL;
+	}
+
+	snprintf(g->name, RTE_PIPELINE_GROUP_MAX_NAME_SZ, "%s", params->name);
+	g->n_shards = params->n_shards;
+	rte_spinlock_init(&g->ctrl_lock);
+
+	/* Shards */
+	for (i = 0; i < g->n_shards; i++) {
+		struct pipeline_group_shard *shard = &g->shards[i];
+		char name[RTE_PIPELINE_GROUP_MAX_NAME_SZ];
+		struct rte_pipeline_params pipeline_params = {
+			.name = name,
+			.socket_id = params->socket_id,
+			.offset_port_id = params->offset_port_id,
+		};
+
+		snprintf(name, sizeof(name), "%s_%u", params->name, i);
+		shard->p = rte_pipeline_create(&pipeline_params);
+		if (shard->p == NULL) {
+			rte_pipeline_group_free(g);
+			return NULL;
+		}
+
+		rte_spinlock_init(&shard->lock);
+	}
+
+	return g;
+}
+
+int
+rte_pipeline_group_free(struct rte_pipeline_group *g)
+{
+	uint32_t i;
+
+	/* Check input parameters */
+	if (g == NULL) {
+		RTE_LOG(ERR, PIPELINE, "%s: pipeline group parameter is NULL\n",
+			__func__);
+		return -EINVAL;
+	}
+
+	/* The shared tables are freed with the first shard, last */
+	for (i = g->n_shards; i > 0; i--)
+		if (g->shards[i - 1].p != NULL)
+			rte_pipeline_free(g->shards[i - 1].p);
+
+	rte_free(g);
+	return 0;
+}
+
+struct rte_pipeline *
+rte_pipeline_group_shard(struct rte_pipeline_group *g, uint32_t shard_id)
+{
+	if ((g == NULL) || (shard_id >= g->n_shards))
+		return NULL;
+
+	return g->shards[shard_id].p;
+}
+
+/*
+ * Configuration
+ *
+ */
+int
+rte_pipeline_group_port_in_create(struct rte_pipeline_group *g,
+	struct rte_pipeline_port_in_params *params,
+	void **arg_create,
+	uint32_t *port_id)
+{
+	uint32_t i;
+
+	/* Check input parameters */
+	if ((g == NULL) || (params == NULL) || (port_id == NULL)) {
+		RTE_LOG(ERR, PIPELINE, "%s: NULL input parameter\n", __func__);
+		return -EINVAL;
+	}
+
+	for (i = 0; i < g->n_shards; i++) {
+		struct rte_pipeline_port_in_params shard_params = *params;
+		uint32_t id;
+		int status;
+
+		if (arg_create != NULL)
+			shard_params.arg_create = arg_create[i];
+
+		status = rte_pipeline_port_in_create(g->shards[i].p,
+			&shard_params, &id);
+		if (status != 0)
+			return status;
+
+		if (i == 0)
+			*port_id = id;
+		else if (id != *port_id)
+			return -EINVAL;
+	}
+
+	return 0;
+}
+
+int
+rte_pipeline_group_port_out_create(struct rte_pipeline_group *g,
+	struct rte_pipeline_port_out_params *params,
+	void **arg_create,
+	uint32_t *port_id)
+{
+	uint32_t i;
+
+	/* Check input parameters */
+	if ((g == NULL) || (params == NULL) || (port_id == NULL)) {
+		RTE_LOG(ERR, PIPELINE, "%s: NULL input parameter\n", __func__);
+		return -EINVAL;
+	}
+
+	for (i = 0; i < g->n_shards; i++) {
+		struct rte_pipeline_port_out_params shard_params = *params;
+		uint32_t id;
+		int status;
+
+		if (arg_create != NULL)
+			shard_params.arg_create = arg_create[i];
+
+		status = rte_pipeline_port_out_create(g->shards[i].p,
+			&shard_params, &id);
+		if (status != 0)
+			return status;
+
+		if (i == 0)
+			*port_id = id;
+		else if (id != *port_id)
+			return -EINVAL;
+	}
+
+	return 0;
+}
+
+int
+rte_pipeline_group_table_create(struct rte_pipeline_group *g,
+	struct rte_pipeline_table_params *params,
+	int shared,
+	uint32_t *table_id)
+{
+	struct pipeline_group_table_ref ref;
+	struct rte_table_ops owner_ops, ref_ops;
+	uint32_t i;
+
+	/* Check input parameters */
+	if ((g == NULL) || (params == NULL) || (params->ops == NULL) ||
+		(table_id == NULL)) {
+		RTE_LOG(ERR, PIPELINE, "%s: NULL input parameter\n", __func__);
+		return -EINVAL;
+	}
+
+	if (shared && params->entry_stats_en) {
+		RTE_LOG(ERR, PIPELINE,
+			"%s: Shared tables cannot have entry stats\n",
+			__func__);
+		return -EINVAL;
+	}
+
+	if (shared) {
+		ref.ops = params->ops;
+		ref.arg_create = params->arg_create;
+		ref.h_table = NULL;
+
+		owner_ops = *params->ops;
+		owner_ops.f_create = pipeline_group_table_owner_create;
+
+		ref_ops = *params->ops;
+		ref_ops.f_create = pipeline_group_table_ref_create;
+		ref_ops.f_free = NULL;
+		ref_ops.f_add = pipeline_group_table_ref_add;
+		ref_ops.f_delete = pipeline_group_table_ref_delete;
+		ref_ops.f_add_bulk = NULL;
+		ref_ops.f_delete_bulk = NULL;
+	}
+
+	for (i = 0; i < g->n_shards; i++) {
+		struct rte_pipeline_table_params shard_params = *params;
+		uint32_t id;
+		int status;
+
+		if (shared) {
+			shard_params.ops = (i == 0) ? &owner_ops : &ref_ops;
+			shard_params.arg_create = &ref;
+		}
+
+		status = rte_pipeline_table_create(g->shards[i].p,
+			&shard_params, &id);
+		if ((status == 0) && (i != 0) && (id != *table_id)) {
+			rte_pipeline_table_free_last(g->shards[i].p, id);
+			status = -EINVAL;
+		}
+
+		if (status != 0) {
+			/* Roll back, the shared table is freed with shard 0 */
+			while (i > 0) {
+				i--;
+				rte_pipeline_table_free_last(g->shards[i].p,
+					*table_id);
+			}
+			return status;
+		}
+
+		if (i == 0)
+			*table_id = id;
+	}
+
+	g->table_shared[*table_id] = (shared != 0);
+	g->n_tables++;
+
+	return 0;
+}
+
+int
+rte_pipeline_group_port_in_connect_to_table(struct rte_pipeline_group *g,
+	uint32_t port_id,
+	uint32_t table_id)
+{
+	uint32_t i;
+
+	if (g == NULL) {
+		RTE_LOG(ERR, PIPELINE, "%s: pipeline group parameter is NULL\n",
+			__func__);
+		return -EINVAL;
+	}
+
+	for (i = 0; i < g->n_shards; i++) {
+		int status = rte_pipeline_port_in_connect_to_table(
+			g->shards[i].p, port_id, table_id);
+
+		if (status != 0)
+			return status;
+	}
+
+	return 0;
+}
+
+int
+rte_pipeline_group_port_in_enable(struct rte_pipeline_group *g,
+	uint32_t port_id)
+{
+	uint32_t i;
+
+	if (g == NULL) {
+		RTE_LOG(ERR, PIPELINE, "%s: pipeline group parameter is NULL\n",
+			__func__);
+		return -EINVAL;
+	}
+
+	for (i = 0; i < g->n_shards; i++) {
+		int status = rte_pipeline_port_in_enable(g->shards[i].p,
+			port_id);
+
+		if (status != 0)
+			return status;
+	}
+
+	return 0;
+}
+
+int
+rte_pipeline_group_check(struct rte_pipeline_group *g)
+{
+	uint32_t i;
+
+	if (g == NULL) {
+		RTE_LOG(ERR, PIPELINE, "%s: pipeline group parameter is NULL\n",
+			__func__);
+		return -EINVAL;
+	}
+
+	for (i = 0; i < g->n_shards; i++) {
+		int status = rte_pipeline_check(g->shards[i].p);
+
+		if (status != 0)
+			return status;
+	}
+
+	return 0;
+}
+
+/*
+ * Control
+ *
+ */
+static void
+pipeline_group_req_handle(struct rte_pipeline_group *g, uint32_t shard_id,
+	struct pipeline_group_req *req)
+{
+	struct rte_pipeline *p = g->shards[shard_id].p;
+
+	/* The entry read back on delete comes from the first shard */
+	struct rte_pipeline_table_entry *entry =
+		(shard_id == 0) ? req->entry : NULL;
+
+	switch (req->type) {
+	case PIPELINE_GROUP_REQ_DEFAULT_ENTRY_ADD:
+		req->status[shard_id] = rte_pipeline_table_default_entry_add(p,
+			req->table_id, req->entry, &req->entry_ptr[shard_id]);
+		break;
+
+	case PIPELINE_GROUP_REQ_DEFAULT_ENTRY_DELETE:
+		req->status[shard_id] =
+			rte_pipeline_table_default_entry_delete(p,
+				req->table_id, entry);
+		break;
+
+	case PIPELINE_GROUP_REQ_ENTRY_ADD:
+		req->status[shard_id] = rte_pipeline_table_entry_add(p,
+			req->table_id, req->key, req->entry,
+			&req->key_found[shard_id], &req->entry_ptr[shard_id]);
+		break;
+
+	case PIPELINE_GROUP_REQ_ENTRY_DELETE:
+		req->status[shard_id] = rte_pipeline_table_entry_delete(p,
+			req->table_id, req->key, &req->key_found[shard_id],
+			entry);
+		break;
+
+	default:
+		req->status[shard_id] = -EINVAL;
+	}
+}
+
+/* Executes the request posted to a running shard */
+static void
+pipeline_group_req_run(struct rte_pipeline_group *g, uint32_t shard_id,
+	struct pipeline_group_req *req)
+{
+	struct pipeline_group_shard *shard = &g->shards[shard_id];
+
+	rte_smp_rmb();
+	if (req->shared) {
+		/* Pause until the control function has updated the table */
+		rte_atomic32_inc(&req->n_paused);
+		while (req->done == 0)
+			rte_pause();
+		rte_smp_rmb();
+	} else
+		pipeline_group_req_handle(g, shard_id, req);
+
+	rte_smp_wmb();
+	shard->req = NULL;
+}
+
+static int
+pipeline_group_req_send(struct rte_pipeline_group *g,
+	struct pipeline_group_req *req)
+{
+	uint64_t posted = 0;
+	uint32_t n_posted = 0;
+	uint32_t i;
+
+	if (req->table_id >= g->n_tables) {
+		RTE_LOG(ERR, PIPELINE,
+			"%s: table_id %u out of range\n", __func__,
+			req->table_id);
+		return -EINVAL;
+	}
+
+	req->shared = g->table_shared[req->table_id];
+
+	rte_spinlock_lock(&g->ctrl_lock);
+
+	/*
+	 * Post the request to the running shards, execute it for the others.
+	 * For a shared table, the stopped shards are kept stopped (their lock
+	 * held) until the table is updated.
+	 */
+	for (i = 0; i < g->n_shards; i++) {
+		struct pipeline_group_shard *shard = &g->shards[i];
+
+		rte_spinlock_lock(&shard->lock);
+		if (shard->running) {
+			rte_smp_wmb();
+			shard->req = req;
+			posted |= 1LLU << i;
+			n_posted++;
+		} else if (req->shared) {
+			/* Unlocked once the table is updated */
+			continue;
+		} else
+			pipeline_group_req_handle(g, i, req);
+		rte_spinlock_unlock(&shard->lock);
+	}
+
+	/* Shared table: update it once all the running shards are paused */
+	if (req->shared) {
+		while ((uint32_t) rte_atomic32_read(&req->n_paused) != n_posted)
+			rte_pause();
+		rte_smp_rmb();
+
+		for (i = 0; i < g->n_shards; i++)
+			pipeline_group_req_handle(g, i, req);
+
+		rte_smp_wmb();
+		req->done = 1;
+
+		for (i = 0; i < g->n_shards; i++)
+			if ((posted & (1LLU << i)) == 0)
+				rte_spinlock_unlock(&g->shards[i].lock);
+	}
+
+	/* Wait for the running shards */
+	for (i = 0; i < g->n_shards; i++)
+		if (posted & (1LLU << i))
+			while (g->shards[i].req != NULL)
+				rte_pause();
+
+	rte_smp_rmb();
+	rte_spinlock_unlock(&g->ctrl_lock);
+
+	for (i = 0; i < g->n_shards; i++)
+		if (req->status[i] != 0)
+			return req->status[i];
+
+	/* Shared tables are updated by the first shard only */
+	if (g->table_shared[req->table_id])
+		for (i = 1; i < g->n_shards; i++) {
+			req->key_found[i] = req->key_found[0];
+			req->entry_ptr[i] = req->entry_ptr[0];
+		}
+
+	return 0;
+}
+
+int
+rte_pipeline_group_table_default_entry_add(struct rte_pipeline_group *g,
+	uint32_t table_id,
+	struct rte_pipeline_table_entry *default_entry,
+	struct rte_pipeline_table_entry **default_entry_ptr)
+{
+	struct pipeline_group_req req;
+	int status;
+
+	if ((g == NULL) || (default_entry == NULL)) {
+		RTE_LOG(ERR, PIPELINE, "%s: NULL input parameter\n", __func__);
+		return -EINVAL;
+	}
+
+	memset(&req, 0, sizeof(req));
+	req.type = PIPELINE_GROUP_REQ_DEFAULT_ENTRY_ADD;
+	req.table_id = table_id;
+	req.entry = default_entry;
+
+	status = pipeline_group_req_send(g, &req);
+	if (status != 0)
+		return status;
+
+	if (default_entry_ptr != NULL)
+		memcpy(default_entry_ptr, req.entry_ptr,
+			g->n_shards * sizeof(default_entry_ptr[0]));
+
+	return 0;
+}
+
+int
+rte_pipeline_group_table_default_entry_delete(
+	struct rte_pipeline_group *g,
+	uint32_t table_id,
+	struct rte_pipeline_table_entry *entry)
+{
+	struct pipeline_group_req req;
+
+	if (g == NULL) {
+		RTE_LOG(ERR, PIPELINE, "%s: pipeline group parameter is NULL\n",
+			__func__);
+		return -EINVAL;
+	}
+
+	memset(&req, 0, sizeof(req));
+	req.type = PIPELINE_GROUP_REQ_DEFAULT_ENTRY_DELETE;
+	req.table_id = table_id;
+	req.entry = entry;
+
+	return pipeline_group_req_send(g, &req);
+}
+
+int
+rte_pipeline_group_table_entry_add(struct rte_pipeline_group *g,
+	uint32_t table_id,
+	void *key,
+	struct rte_pipeline_table_entry *entry,
+	int *key_found,
+	struct rte_pipeline_table_entry **entry_ptr)
+{
+	struct pipeline_group_req req;
+	int status;
+
+	if ((g == NULL) || (key == NULL) || (entry == NULL) ||
+		(key_found == NULL)) {
+		RTE_LOG(ERR, PIPELINE, "%s: NULL input parameter\n", __func__);
+		return -EINVAL;
+	}
+
+	memset(&req, 0, sizeof(req));
+	req.type = PIPELINE_GROUP_REQ_ENTRY_ADD;
+	req.table_id = table_id;
+	req.key = key;
+	req.entry = entry;
+
+	status = pipeline_group_req_send(g, &req);
+	if (status != 0)
+		return status;
+
+	*key_found = req.key_found[0];
+	if (entry_ptr != NULL)
+		memcpy(entry_ptr, req.entry_ptr,
+			g->n_shards * sizeof(entry_ptr[0]));
+
+	return 0;
+}
+
+int
+rte_pipeline_group_table_entry_delete(struct rte_pipeline_group *g,
+	uint32_t table_id,
+	void *key,
+	int *key_found,
+	struct rte_pipeline_table_entry *entry)
+{
+	struct pipeline_group_req req;
+	int status;
+
+	if ((g == NULL) || (key == NULL) || (key_found == NULL)) {
+		RTE_LOG(ERR, PIPELINE, "%s: NULL input parameter\n", __func__);
+		return -EINVAL;
+	}
+
+	memset(&req, 0, sizeof(req));
+	req.type = PIPELINE_GROUP_REQ_ENTRY_DELETE;
+	req.table_id = table_id;
+	req.key = key;
+	req.entry = entry;
+
+	status = pipeline_group_req_send(g, &req);
+	if (status != 0)
+		return status;
+
+	*key_found = req.key_found[0];
+	return 0;
+}
+
+/*
+ * Run-time
+ *
+ */
+int
+rte_pipeline_group_run(struct rte_pipeline_group *g, uint32_t shard_id)
+{
+	struct pipeline_group_shard *shard = &g->shards[shard_id];
+	struct pipeline_group_req *req;
+
+	if (unlikely(shard->running == 0)) {
+		rte_spinlock_lock(&shard->lock);
+		shard->running = 1;
+		rte_spinlock_unlock(&shard->lock);
+	}
+
+	/* Pending table update */
+	req = shard->req;
+	if (unlikely(req != NULL))
+		pipeline_group_req_run(g, shard_id, req);
+
+	return rte_pipeline_run(shard->p);
+}
+
+int
+rte_pipeline_group_stop(struct rte_pipeline_group *g, uint32_t shard_id)
+{
+	struct pipeline_group_shard *shard;
+	struct pipeline_group_req *req;
+
+	if ((g == NULL) || (shard_id >= g->n_shards)) {
+		RTE_LOG(ERR, PIPELINE, "%s: Invalid input parameter\n",
+			__func__);
+		return -EINVAL;
+	}
+
+	shard = &g->shards[shard_id];
+
+	rte_spinlock_lock(&shard->lock);
+
+	req = shard->req;
+	if (req != NULL)
+		pipeline_group_req_run(g, shard_id, req);
+
+	shard->running = 0;
+	rte_spinlock_unlock(&shard->lock);
+
+	return rte_pipeline_flush(shard->p);
+}
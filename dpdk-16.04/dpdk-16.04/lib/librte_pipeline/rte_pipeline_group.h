@@ -0,0 +1,384 @@
+/*-
+ *   BSD LICENSE
+ *
+ *   Copyright(c) 2016 Intel Corporation. All rights reserved.
+ *   All rights reserved.
+ *
+ *   Redistribution and use in source and binary forms, with or without
+ *   modification, are permitted provided that the following conditions
+ *   are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ *     * Neither the name of Intel Corporation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *   OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __INCLUDE_RTE_PIPELINE_GROUP_H__
+#define __INCLUDE_RTE_PIPELINE_GROUP_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @file
+ * RTE Pipeline Group
+ *
+ * A pipeline group runs one logical pipeline on several CPU cores. The group
+ * is made of one pipeline instance (shard) per CPU core, all of them built
+ * with the same input ports, output ports and tables, so the port and table
+ * IDs are the same in all the shards.
+ *
+ * <B>Input ports.</B> Each input port of the group is created in all the
+ * shards, either with its own low-level port per shard (e.g. the NIC RX queue
+ * of the shard, with the NIC spreading the traffic over the queues through
+ * RSS), or with the same low-level port shared by all the shards (e.g. a SW
+ * ring read through the ring multi-reader port). The output ports are created
+ * in the same way.
+ *
+ * <B>Tables.</B> Each table of the group is either replicated, i.e. each
+ * shard has its own copy of the table, or shared, i.e. the low-level table
+ * created by the first shard is looked up by all the shards. Sharing a table
+ * saves memory and cache space, but stalls all the shards on each update of
+ * the table, so it suits tables that are seldom updated.
+ *
+ * <B>Control.</B> The table entry add and delete functions of the group
+ * update the table in all the shards. When a shard is running, the update is
+ * posted to it and is executed by its own CPU core between two iterations of
+ * rte_pipeline_group_run(), so replicated tables are never updated while
+ * being looked up. A shared table is updated by the control function itself,
+ * once all the running shards have paused, the stopped shards being kept
+ * from running until the update is done. The control functions return once
+ * all the shards have executed the update. They must not be called by a CPU
+ * core that runs one of the shards of the group.
+ *
+ ***/
+
+#include <stdint.h>
+
+#include "rte_pipeline.h"
+
+/** Maximum number of shards of a pipeline group */
+#define RTE_PIPELINE_GROUP_SHARDS_MAX                               64
+
+/** Opaque data type for pipeline group */
+struct rte_pipeline_group;
+
+/** Parameters for pipeline group creation */
+struct rte_pipeline_group_params {
+	/** Pipeline group name, the shard pipelines are named after it */
+	const char *name;
+
+	/** CPU socket ID where memory for the pipeline group and its shards
+	should be allocated */
+	int socket_id;
+
+	/** Offset within packet meta-data to port_id to be used by action
+	"Send packet to output port read from packet meta-data". Has to be
+	4-byte aligned. */
+	uint32_t offset_port_id;
+
+	/** Number of shards, i.e. of CPU cores running the pipeline */
+	uint32_t n_shards;
+};
+
+/**
+ * Pipeline group create
+ *
+ * @param params
+ *   Parameters for pipeline group creation
+ * @return
+ *   Handle to pipeline group instance on success or NULL otherwise
+ */
+struct rte_pipeline_group *
+rte_pipeline_group_create(struct rte_pipeline_group_params *params);
+
+/**
+ * Pipeline group free
+ *
+ * None of the shards should be running.
+ *
+ * @param g
+ *   Handle to pipeline group instance
+ * @return
+ *   0 on success, error code otherwise
+ */
+int rte_pipeline_group_free(struct rte_pipeline_group *g);
+
+/**
+ * Pipeline group shard
+ *
+ * The shard pipeline can be used to read the port and table statistics of the
+ * shard or to flush its output ports from the CPU core running it. It should
+ * not be used to change the configuration of the group.
+ *
+ * @param g
+ *   Handle to pipeline group instance
+ * @param shard_id
+ *   Shard ID
+ * @return
+ *   Handle to the shard pipeline instance on success or NULL otherwise
+ */
+struct rte_pipeline *
+rte_pipeline_group_shard(struct rte_pipeline_group *g, uint32_t shard_id);
+
+/**
+ * Pipeline group input port create
+ *
+ * @param g
+ *   Handle to pipeline group instance
+ * @param params
+ *   Parameters for pipeline input port creation
+ * @param arg_create
+ *   Array of n_shards opaque parameters to be passed to the input port create
+ *   operation, one per shard. When NULL, params->arg_create is used for all
+ *   the shards.
+ * @param port_id
+ *   Input port ID, the same in all the shards. Only returned after a
+ *   successful invocation.
+ * @return
+ *   0 on success, error code otherwise
+ */
+int rte_pipeline_group_port_in_create(struct rte_pipeline_group *g,
+	struct rte_pipeline_port_in_params *params,
+	void **arg_create,
+	uint32_t *port_id);
+
+/**
+ * Pipeline group output port create
+ *
+ * @param g
+ *   Handle to pipeline group instance
+ * @param params
+ *   Parameters for pipeline output port creation
+ * @param arg_create
+ *   Array of n_shards opaque parameters to be passed to the output port
+ *   create operation, one per shard. When NULL, params->arg_create is used
+ *   for all the shards.
+ * @param port_id
+ *   Output port ID, the same in all the shards. Only returned after a
+ *   successful invocation.
+ * @return
+ *   0 on success, error code otherwise
+ */
+int rte_pipeline_group_port_out_create(struct rte_pipeline_group *g,
+	struct rte_pipeline_port_out_params *params,
+	void **arg_create,
+	uint32_t *port_id);
+
+/**
+ * Pipeline group table create
+ *
+ * @param g
+ *   Handle to pipeline group instance
+ * @param params
+ *   Parameters for pipeline table creation
+ * @param shared
+ *   When non-zero, the low-level table is created once and shared by all the
+ *   shards, otherwise each shard has its own replica of the table. Shared
+ *   tables cannot have entry stats.
+ * @param table_id
+ *   Table ID, the same in all the shards. Only returned after a successful
+ *   invocation.
+ * @return
+ *   0 on success, error code otherwise. On error, the table is not created
+ *   in any of the shards.
+ */
+int rte_pipeline_group_table_create(struct rte_pipeline_group *g,
+	struct rte_pipeline_table_params *params,
+	int shared,
+	uint32_t *table_id);
+
+/**
+ * Pipeline group input port connect to table
+ *
+ * @param g
+ *   Handle to pipeline group instance
+ * @param port_id
+ *   Input port ID
+ * @param table_id
+ *   Table ID
+ * @return
+ *   0 on success, error code otherwise
+ */
+int rte_pipeline_group_port_in_connect_to_table(struct rte_pipeline_group *g,
+	uint32_t port_id,
+	uint32_t table_id);
+
+/**
+ * Pipeline group input port enable
+ *
+ * @param g
+ *   Handle to pipeline group instance
+ * @param port_id
+ *   Input port ID
+ * @return
+ *   0 on success, error code otherwise
+ */
+int rte_pipeline_group_port_in_enable(struct rte_pipeline_group *g,
+	uint32_t port_id);
+
+/**
+ * Pipeline group consistency check
+ *
+ * @param g
+ *   Handle to pipeline group instance
+ * @return
+ *   0 on success, error code otherwise
+ */
+int rte_pipeline_group_check(struct rte_pipeline_group *g);
+
+/**
+ * Pipeline group table default entry add
+ *
+ * The default entry of the table is updated in all the shards.
+ *
+ * @param g
+ *   Handle to pipeline group instance
+ * @param table_id
+ *   Table ID
+ * @param default_entry
+ *   New default entry for the table
+ * @param default_entry_ptr
+ *   Array of n_shards handles to the default entry of the table in each
+ *   shard, returned on success. Can be NULL.
+ * @return
+ *   0 on success, error code otherwise
+ */
+int rte_pipeline_group_table_default_entry_add(struct rte_pipeline_group *g,
+	uint32_t table_id,
+	struct rte_pipeline_table_entry *default_entry,
+	struct rte_pipeline_table_entry **default_entry_ptr);
+
+/**
+ * Pipeline group table default entry delete
+ *
+ * @param g
+ *   Handle to pipeline group instance
+ * @param table_id
+ *   Table ID
+ * @param entry
+ *   On successful invocation, when not NULL, it contains the previous default
+ *   entry of the table in the first shard
+ * @return
+ *   0 on success, error code otherwise
+ */
+int rte_pipeline_group_table_default_entry_delete(
+	struct rte_pipeline_group *g,
+	uint32_t table_id,
+	struct rte_pipeline_table_entry *entry);
+
+/**
+ * Pipeline group table entry add
+ *
+ * The entry is added to the table of all the shards, or to the shared table.
+ *
+ * @param g
+ *   Handle to pipeline group instance
+ * @param table_id
+ *   Table ID
+ * @param key
+ *   Table entry key
+ * @param entry
+ *   New table entry
+ * @param key_found
+ *   On successful invocation, set to TRUE (value different than 0) if key was
+ *   found in the table of the first shard before the add operation and to
+ *   FALSE (value 0) if not
+ * @param entry_ptr
+ *   Array of n_shards handles to the table entry in each shard, returned on
+ *   success. For a shared table, all the handles are the same. Can be NULL.
+ * @return
+ *   0 on success, error code otherwise. On error, the table may have been
+ *   updated in some of the shards only.
+ */
+int rte_pipeline_group_table_entry_add(struct rte_pipeline_group *g,
+	uint32_t table_id,
+	void *key,
+	struct rte_pipeline_table_entry *entry,
+	int *key_found,
+	struct rte_pipeline_table_entry **entry_ptr);
+
+/**
+ * Pipeline group table entry delete
+ *
+ * @param g
+ *   Handle to pipeline group instance
+ * @param table_id
+ *   Table ID
+ * @param key
+ *   Table entry key
+ * @param key_found
+ *   On successful invocation, set to TRUE (value different than 0) if key was
+ *   found in the table of the first shard before the delete operation and to
+ *   FALSE (value 0) if not
+ * @param entry
+ *   On successful invocation, when key is found in the table and entry points
+ *   to a valid buffer, the table entry of the first shard is copied to this
+ *   buffer before the delete operation
+ * @return
+ *   0 on success, error code otherwise
+ */
+int rte_pipeline_group_table_entry_delete(struct rte_pipeline_group *g,
+	uint32_t table_id,
+	void *key,
+	int *key_found,
+	struct rte_pipeline_table_entry *entry);
+
+/**
+ * Pipeline group run
+ *
+ * Called by the CPU core running the shard, in a loop. Each call executes the
+ * pending table update of the shard, if any, and then runs the shard pipeline
+ * once (see rte_pipeline_run()). The first call marks the shard as running.
+ *
+ * @param g
+ *   Handle to pipeline group instance
+ * @param shard_id
+ *   Shard ID
+ * @return
+ *   Number of packets read and processed
+ */
+int rte_pipeline_group_run(struct rte_pipeline_group *g, uint32_t shard_id);
+
+/**
+ * Pipeline group stop
+ *
+ * Called by the CPU core running the shard when it stops calling
+ * rte_pipeline_group_run() for this shard. The pending table update of the
+ * shard, if any, is executed and the output ports of the shard are flushed.
+ * The table updates are then executed directly by the control functions
+ * until the shard runs again.
+ *
+ * @param g
+ *   Handle to pipeline group instance
+ * @param shard_id
+ *   Shard ID
+ * @return
+ *   0 on success, error code otherwise
+ */
+int rte_pipeline_group_stop(struct rte_pipeline_group *g, uint32_t shard_id);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -756,6 +756,290 @@ rte_port_ring_writer_nodrop_stats_read(void *port,
 	return 0;
 }
 
+/*
+ * Port RING Writer Zero-Copy
+ */
+#ifdef RTE_PORT_STATS_COLLECT
+
+#define RTE_PORT_RING_WRITER_ZC_STATS_PKTS_IN_ADD(port, val) \
+	port->stats.n_pkts_in += val
+#define RTE_PORT_RING_WRITER_ZC_STATS_PKTS_DROP_ADD(port, val) \
+	port->stats.n_pkts_drop += val
+
+#else
+
+#define RTE_PORT_RING_WRITER_ZC_STATS_PKTS_IN_ADD(port, val)
+#define RTE_PORT_RING_WRITER_ZC_STATS_PKTS_DROP_ADD(port, val)
+
+#endif
+
+struct rte_port_ring_writer_zc {
+	struct rte_port_out_stats stats;
+
+	struct rte_ring *ring;
+	uint32_t tx_burst_sz;
+
+	/* Ring slots currently reserved: index of the first one, number of
+	reserved slots and number of slots already written */
+	uint32_t head;
+	uint32_t n_slots;
+	uint32_t n_slots_used;
+
+	uint64_t n_retries;
+};
+
+static void *
+rte_port_ring_writer_zc_create_internal(void *params, int socket_id,
+	uint32_t is_nodrop)
+{
+	struct rte_port_ring_writer_nodrop_params *conf =
+			(struct rte_port_ring_writer_nodrop_params *) params;
+	struct rte_port_ring_writer_zc *port;
+
+	/* Check input parameters */
+	if ((conf == NULL) ||
+		(conf->ring == NULL) ||
+		(!(conf->ring->prod.sp_enqueue)) ||
+		(conf->tx_burst_sz == 0) ||
+		(conf->tx_burst_sz > RTE_PORT_IN_BURST_SIZE_MAX)) {
+		RTE_LOG(ERR, PORT, "%s: Invalid Parameters\n", __func__);
+		return NULL;
+	}
+
+	/* Memory allocation */
+	port = rte_zmalloc_socket("PORT", sizeof(*port),
+			RTE_CACHE_LINE_SIZE, socket_id);
+	if (port == NULL) {
+		RTE_LOG(ERR, PORT, "%s: Failed to allocate port\n", __func__);
+		return NULL;
+	}
+
+	/* Initialization */
+	port->ring = conf->ring;
+	port->tx_burst_sz = conf->tx_burst_sz;
+	port->n_slots = 0;
+	port->n_slots_used = 0;
+
+	/* Same as for the ring_writer_nodrop port, 0 means no limit */
+	if (is_nodrop)
+		port->n_retries = (conf->n_retries == 0) ?
+			UINT64_MAX : conf->n_retries;
+
+	return port;
+}
+
+static void *
+rte_port_ring_writer_zc_create(void *params, int socket_id)
+{
+	struct rte_port_ring_writer_params *conf =
+			(struct rte_port_ring_writer_params *) params;
+	struct rte_port_ring_writer_nodrop_params conf_nodrop;
+
+	if (conf == NULL) {
+		RTE_LOG(ERR, PORT, "%s: Invalid Parameters\n", __func__);
+		return NULL;
+	}
+
+	conf_nodrop.ring = conf->ring;
+	conf_nodrop.tx_burst_sz = conf->tx_burst_sz;
+	conf_nodrop.n_retries = 0;
+
+	return rte_port_ring_writer_zc_create_internal(&conf_nodrop, socket_id,
+		0);
+}
+
+static void *
+rte_port_ring_writer_zc_nodrop_create(void *params, int socket_id)
+{
+	return rte_port_ring_writer_zc_create_internal(params, socket_id, 1);
+}
+
+static inline void
+rte_port_ring_writer_zc_commit(struct rte_port_ring_writer_zc *p)
+{
+	rte_ring_sp_enqueue_zc_finish(p->ring, p->head, p->n_slots_used);
+	p->n_slots = 0;
+	p->n_slots_used = 0;
+}
+
+/*
+ * Reserve the ring slots for the next burst. For the nodrop port, when the
+ * ring is full, retry up to n_retries times. Returns the number of slots
+ * reserved, 0 when the packets have to be dropped.
+ */
+static inline uint32_t
+rte_port_ring_writer_zc_reserve(struct rte_port_ring_writer_zc *p,
+	uint32_t is_nodrop)
+{
+	uint64_t i;
+
+	p->n_slots = rte_ring_sp_enqueue_zc_start(p->ring, p->tx_burst_sz,
+		&p->head);
+	if (likely(p->n_slots != 0) || !is_nodrop)
+		return p->n_slots;
+
+	for (i = 0; i < p->n_retries; i++) {
+		p->n_slots = rte_ring_sp_enqueue_zc_start(p->ring,
+			p->tx_burst_sz, &p->head);
+		if (p->n_slots != 0)
+			break;
+	}
+
+	return p->n_slots;
+}
+
+static inline int __attribute__((always_inline))
+rte_port_ring_writer_zc_tx_internal(void *port, struct rte_mbuf *pkt,
+	uint32_t is_nodrop)
+{
+	struct rte_port_ring_writer_zc *p =
+		(struct rte_port_ring_writer_zc *) port;
+
+	RTE_PORT_RING_WRITER_ZC_STATS_PKTS_IN_ADD(p, 1);
+
+	if ((p->n_slots == 0) &&
+		(rte_port_ring_writer_zc_reserve(p, is_nodrop) == 0)) {
+		RTE_PORT_RING_WRITER_ZC_STATS_PKTS_DROP_ADD(p, 1);
+		rte_pktmbuf_free(pkt);
+		return 0;
+	}
+
+	rte_ring_enqueue_zc_slot(p->ring, p->head, p->n_slots_used++, pkt);
+	if (p->n_slots_used == p->n_slots)
+		rte_port_ring_writer_zc_commit(p);
+
+	return 0;
+}
+
+static int
+rte_port_ring_writer_zc_tx(void *port, struct rte_mbuf *pkt)
+{
+	return rte_port_ring_writer_zc_tx_internal(port, pkt, 0);
+}
+
+static int
+rte_port_ring_writer_zc_nodrop_tx(void *port, struct rte_mbuf *pkt)
+{
+	return rte_port_ring_writer_zc_tx_internal(port, pkt, 1);
+}
+
+static inline int __attribute__((always_inline))
+rte_port_ring_writer_zc_tx_bulk_internal(void *port,
+		struct rte_mbuf **pkts,
+		uint64_t pkts_mask,
+		uint32_t is_nodrop)
+{
+	struct rte_port_ring_writer_zc *p =
+		(struct rte_port_ring_writer_zc *) port;
+	uint32_t head = p->head;
+	uint32_t n_slots = p->n_slots;
+	uint32_t n_slots_used = p->n_slots_used;
+
+	RTE_PORT_RING_WRITER_ZC_STATS_PKTS_IN_ADD(p,
+		__builtin_popcountll(pkts_mask));
+
+	for ( ; pkts_mask; ) {
+		uint32_t pkt_index = __builtin_ctzll(pkts_mask);
+		uint64_t pkt_mask = 1LLU << pkt_index;
+
+		if (n_slots == 0) {
+			n_slots = rte_port_ring_writer_zc_reserve(p, is_nodrop);
+			if (n_slots == 0)
+				break;
+
+			head = p->head;
+		}
+
+		rte_ring_enqueue_zc_slot(p->ring, head, n_slots_used++,
+			pkts[pkt_index]);
+		pkts_mask &= ~pkt_mask;
+
+		if (n_slots_used == n_slots) {
+			rte_ring_sp_enqueue_zc_finish(p->ring, head,
+				n_slots_used);
+			n_slots = 0;
+			n_slots_used = 0;
+		}
+	}
+
+	p->n_slots = n_slots;
+	p->n_slots_used = n_slots_used;
+
+	/* Ring full */
+	if (unlikely(pkts_mask)) {
+		RTE_PORT_RING_WRITER_ZC_STATS_PKTS_DROP_ADD(p,
+			__builtin_popcountll(pkts_mask));
+		for ( ; pkts_mask; ) {
+			uint32_t pkt_index = __builtin_ctzll(pkts_mask);
+
+			rte_pktmbuf_free(pkts[pkt_index]);
+			pkts_mask &= ~(1LLU << pkt_index);
+		}
+	}
+
+	return 0;
+}
+
+static int
+rte_port_ring_writer_zc_tx_bulk(void *port,
+		struct rte_mbuf **pkts,
+		uint64_t pkts_mask)
+{
+	return rte_port_ring_writer_zc_tx_bulk_internal(port, pkts, pkts_mask,
+		0);
+}
+
+static int
+rte_port_ring_writer_zc_nodrop_tx_bulk(void *port,
+		struct rte_mbuf **pkts,
+		uint64_t pkts_mask)
+{
+	return rte_port_ring_writer_zc_tx_bulk_internal(port, pkts, pkts_mask,
+		1);
+}
+
+static int
+rte_port_ring_writer_zc_flush(void *port)
+{
+	struct rte_port_ring_writer_zc *p =
+		(struct rte_port_ring_writer_zc *) port;
+
+	if (p->n_slots > 0)
+		rte_port_ring_writer_zc_commit(p);
+
+	return 0;
+}
+
+static int
+rte_port_ring_writer_zc_free(void *port)
+{
+	if (port == NULL) {
+		RTE_LOG(ERR, PORT, "%s: Port is NULL\n", __func__);
+		return -EINVAL;
+	}
+
+	rte_port_ring_writer_zc_flush(port);
+	rte_free(port);
+
+	return 0;
+}
+
+static int
+rte_port_ring_writer_zc_stats_read(void *port,
+		struct rte_port_out_stats *stats, int clear)
+{
+	struct rte_port_ring_writer_zc *p =
+		(struct rte_port_ring_writer_zc *) port;
+
+	if (stats != NULL)
+		memcpy(stats, &p->stats, sizeof(p->stats));
+
+	if (clear)
+		memset(&p->stats, 0, sizeof(p->stats));
+
+	return 0;
+}
+
 /*
  * Summary of port operations
  */
@@ -808,3 +1092,21 @@ struct rte_port_out_ops rte_port_ring_multi_writer_nodrop_ops = {
 	.f_flush = rte_port_ring_multi_writer_nodrop_flush,
 	.f_stats = rte_port_ring_writer_nodrop_stats_read,
 };
+
+struct rte_port_out_ops rte_port_ring_writer_zc_ops = {
+	.f_create = rte_port_ring_writer_zc_create,
+	.f_free = rte_port_ring_writer_zc_free,
+	.f_tx = rte_port_ring_writer_zc_tx,
+	.f_tx_bulk = rte_port_ring_writer_zc_tx_bulk,
+	.f_flush = rte_port_ring_writer_zc_flush,
+	.f_stats = rte_port_ring_writer_zc_stats_read,
+};
+
+struct rte_port_out_ops rte_port_ring_writer_zc_nodrop_ops = {
+	.f_create = rte_port_ring_writer_zc_nodrop_create,
+	.f_free = rte_port_ring_writer_zc_free,
+	.f_tx = rte_port_ring_writer_zc_nodrop_tx,
+	.f_tx_bulk = rte_port_ring_writer_zc_nodrop_tx_bulk,
+	.f_flush = rte_port_ring_writer_zc_flush,
+	.f_stats = rte_port_ring_writer_zc_stats_read,
+};
@@ -50,6 +50,9 @@ extern "C" {
  *      input port built on top of pre-initialized multi consumers ring
  * ring_multi_writer:
  *      output port built on top of pre-initialized multi producers ring
+ * ring_writer_zc:
+ *      output port built on top of pre-initialized single producer ring,
+ *      writing the packets directly into the ring slots
  *
  ***/
 
@@ -116,6 +119,34 @@ extern struct rte_port_out_ops rte_port_ring_multi_writer_ops;
 /** ring_multi_writer_nodrop port operations */
 extern struct rte_port_out_ops rte_port_ring_multi_writer_nodrop_ops;
 
+/** ring_writer_zc port parameters */
+#define rte_port_ring_writer_zc_params rte_port_ring_writer_params
+
+/**
+ * ring_writer_zc port operations
+ *
+ * Instead of buffering the output packets before enqueuing them to the ring,
+ * this port reserves up to tx_burst_sz ring slots at a time and writes the
+ * packets straight into them. The packets are made visible to the ring
+ * consumer once all the reserved slots are written or when the port is
+ * flushed. The ring must be single producer and only written through this
+ * port.
+ */
+extern struct rte_port_out_ops rte_port_ring_writer_zc_ops;
+
+/** ring_writer_zc_nodrop port parameters */
+#define rte_port_ring_writer_zc_nodrop_params \
+	rte_port_ring_writer_nodrop_params
+
+/**
+ * ring_writer_zc_nodrop port operations
+ *
+ * Same as the ring_writer_zc port, except that when the ring is full, the
+ * slot reservation is retried up to n_retries times before dropping the
+ * packets.
+ */
+extern struct rte_port_out_ops rte_port_ring_writer_zc_nodrop_ops;
+
 #ifdef __cplusplus
 }
 #endif
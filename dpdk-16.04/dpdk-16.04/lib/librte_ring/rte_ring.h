@@ -1186,6 +1186,87 @@ rte_ring_enqueue_burst(struct rte_ring *r, void * const *obj_table,
 		return rte_ring_mp_enqueue_burst(r, obj_table, n);
 }
 
+/**
+ * Start a zero-copy enqueue on a ring (NOT multi-producers safe).
+ *
+ * Reserve up to n free slots of the ring, which the caller then fills
+ * directly with rte_ring_enqueue_zc_slot() instead of passing a table of
+ * objects to be copied into the ring. The objects are made visible to the
+ * consumers by rte_ring_sp_enqueue_zc_finish(). The reservation can be kept
+ * across several calls of the producer, but no other enqueue can be done on
+ * the ring until it is finished. The ring watermark is not checked.
+ *
+ * @param r
+ *   A pointer to the ring structure.
+ * @param n
+ *   The number of slots to reserve.
+ * @param head
+ *   Returned index of the first reserved slot, to be passed to the other
+ *   zero-copy enqueue functions.
+ * @return
+ *   - n: Actual number of slots reserved, 0 when the ring is full.
+ */
+static inline unsigned __attribute__((always_inline))
+rte_ring_sp_enqueue_zc_start(struct rte_ring *r, unsigned n, uint32_t *head)
+{
+	uint32_t prod_head = r->prod.head;
+	uint32_t free_entries = r->prod.mask + r->cons.tail - prod_head;
+
+	if (unlikely(n > free_entries)) {
+		if (unlikely(free_entries == 0))
+			__RING_STAT_ADD(r, enq_fail, n);
+
+		n = free_entries;
+	}
+
+	r->prod.head = prod_head + n;
+	*head = prod_head;
+	return n;
+}
+
+/**
+ * Write one object into a slot reserved by a zero-copy enqueue.
+ *
+ * @param r
+ *   A pointer to the ring structure.
+ * @param head
+ *   The index of the first reserved slot.
+ * @param i
+ *   The position of the slot within the reserved slots.
+ * @param obj
+ *   The object to write.
+ */
+static inline void __attribute__((always_inline))
+rte_ring_enqueue_zc_slot(struct rte_ring *r, uint32_t head, unsigned i,
+	void *obj)
+{
+	r->ring[(head + i) & r->prod.mask] = obj;
+}
+
+/**
+ * Finish a zero-copy enqueue on a ring (NOT multi-producers safe).
+ *
+ * The objects written into the first n reserved slots are enqueued, while the
+ * remaining reserved slots are released.
+ *
+ * @param r
+ *   A pointer to the ring structure.
+ * @param head
+ *   The index of the first reserved slot.
+ * @param n
+ *   The number of objects written into the reserved slots, not more than
+ *   the number of reserved slots.
+ */
+static inline void __attribute__((always_inline))
+rte_ring_sp_enqueue_zc_finish(struct rte_ring *r, uint32_t head, unsigned n)
+{
+	rte_smp_wmb();
+
+	r->prod.head = head + n;
+	__RING_STAT_ADD(r, enq_success, n);
+	r->prod.tail = head + n;
+}
+
 /**
  * Dequeue several objects from a ring (multi-consumers safe). When the request
  * objects are more than the available objects, only dequeue the actual number
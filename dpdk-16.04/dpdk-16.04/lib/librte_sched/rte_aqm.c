@@ -0,0 +1,167 @@
+/*-
+ *   BSD LICENSE
+ *
+ *   Copyright(c) 2016 Intel Corporation. All rights reserved.
+ *   All rights reserved.
+ *
+ *   Redistribution and use in source and binary forms, with or without
+ *   modification, are permitted provided that the following conditions
+ *   are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ *     * Neither the name of Intel Corporation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *   OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <math.h>
+#include <string.h>
+#include "rte_aqm.h"
+#include <rte_random.h>
+#include <rte_common.h>
+
+static int rte_aqm_init_done = 0;     /**< Flag to indicate that global initialisation is done */
+uint64_t rte_aqm_rand_seed = 0;       /**< Seed for random number generation */
+
+/**
+ * table[n] = 2^32 / n, rounded up
+ */
+uint32_t rte_aqm_recip[RTE_AQM_RECIP_TABLE_SIZE];
+
+/**
+ * table[i] = 10^(i - 6), scaled in 32-bit fixed point format
+ */
+uint32_t rte_pie_tune_prob[RTE_PIE_TUNE_LEVELS];
+
+/**
+ * table[n] = 1 / sqrt(n) * 2^16, n >= 2
+ */
+uint16_t rte_codel_inv_sqrt[RTE_CODEL_INV_SQRT_TABLE_SIZE];
+
+/**
+ * @brief Initialize the tables used to avoid divisions and square roots
+ *        on the enqueue path.
+ */
+static void
+__rte_aqm_init_tables(void)
+{
+	uint32_t i;
+
+	rte_aqm_recip[0] = 0;
+	rte_aqm_recip[1] = UINT32_MAX;
+	for (i = 2; i < RTE_AQM_RECIP_TABLE_SIZE; i++)
+		rte_aqm_recip[i] = (uint32_t) ((((uint64_t) 1 <<
+			RTE_AQM_RECIP_SCALING) + i - 1) / i);
+
+	for (i = 0; i < RTE_PIE_TUNE_LEVELS; i++)
+		rte_pie_tune_prob[i] = RTE_AQM_PROB(pow(10,
+			(double) i - RTE_PIE_TUNE_LEVELS));
+
+	rte_codel_inv_sqrt[0] = 0;
+	rte_codel_inv_sqrt[1] = 0;
+	for (i = 2; i < RTE_CODEL_INV_SQRT_TABLE_SIZE; i++)
+		rte_codel_inv_sqrt[i] = (uint16_t) round((double)
+			(1 << RTE_CODEL_INV_SQRT_SCALING) / sqrt((double) i));
+}
+
+static void
+__rte_aqm_init(void)
+{
+	if (!rte_aqm_init_done) {
+		rte_aqm_rand_seed = rte_rand();
+		__rte_aqm_init_tables();
+		rte_aqm_init_done = 1;
+	}
+}
+
+int
+rte_pie_config_init(struct rte_pie_config *cfg,
+	const uint32_t qdelay_ref,
+	const uint32_t t_update,
+	const uint32_t max_burst,
+	const uint16_t dq_threshold)
+{
+	double scale = (double) (1ULL << (32 + RTE_PIE_GAIN_SCALING));
+
+	if (cfg == NULL)
+		return -1;
+	if (qdelay_ref == 0)
+		return -2;
+	if (t_update == 0)
+		return -3;
+	if (dq_threshold == 0)
+		return -4;
+
+	__rte_aqm_init();
+
+	/* RFC 8033 gains for QDELAY_REF = 15 ms, per unit of qdelay_ref */
+	cfg->alpha = (uint64_t) round(0.125 * 0.015 * scale / qdelay_ref);
+	cfg->beta = (uint64_t) round(1.25 * 0.015 * scale / qdelay_ref);
+	cfg->qdelay_ref = qdelay_ref;
+	cfg->t_update = t_update;
+	cfg->max_burst = max_burst;
+	cfg->dq_threshold = dq_threshold;
+
+	return 0;
+}
+
+int
+rte_pie_rt_data_init(struct rte_pie *pie)
+{
+	if (pie == NULL)
+		return -1;
+
+	memset(pie, 0, sizeof(*pie));
+	return 0;
+}
+
+int
+rte_codel_config_init(struct rte_codel_config *cfg,
+	const uint32_t target,
+	const uint32_t interval,
+	const uint16_t dq_threshold)
+{
+	if (cfg == NULL)
+		return -1;
+	if (target == 0)
+		return -2;
+	if (interval <= target)
+		return -3;
+	if (dq_threshold == 0)
+		return -4;
+
+	__rte_aqm_init();
+
+	cfg->target = target;
+	cfg->interval = interval;
+	cfg->dq_threshold = dq_threshold;
+
+	return 0;
+}
+
+int
+rte_codel_rt_data_init(struct rte_codel *codel)
+{
+	if (codel == NULL)
+		return -1;
+
+	memset(codel, 0, sizeof(*codel));
+	return 0;
+}
@@ -0,0 +1,486 @@
+/*-
+ *   BSD LICENSE
+ *
+ *   Copyright(c) 2016 Intel Corporation. All rights reserved.
+ *   All rights reserved.
+ *
+ *   Redistribution and use in source and binary forms, with or without
+ *   modification, are permitted provided that the following conditions
+ *   are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ *     * Neither the name of Intel Corporation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *   OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __RTE_AQM_H_INCLUDED__
+#define __RTE_AQM_H_INCLUDED__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @file
+ * RTE Active Queue Management (AQM): PIE and CoDel
+ *
+ * Both algorithms keep the queueing delay of a queue close to a target value.
+ * They run when a packet is enqueued, with the queueing delay estimated from
+ * the current queue size and from the departure rate of the queue. The
+ * departure rate is sampled from a free running counter of the packets read
+ * from the queue, so no per packet time stamp is needed.
+ *
+ * All the times are in the units of the time stamps passed by the caller,
+ * i.e. bytes of port time when used by the hierarchical scheduler.
+ *
+ ***/
+
+#include <stdint.h>
+#include <rte_common.h>
+#include <rte_branch_prediction.h>
+
+#define RTE_AQM_DQ_SCALING                  8      /**< Fraction size of the per packet departure time */
+#define RTE_AQM_RECIP_SCALING               32     /**< Fraction size of the reciprocal table entries */
+#define RTE_AQM_RECIP_TABLE_SIZE            256    /**< Departure counts with a precomputed reciprocal */
+#define RTE_PIE_GAIN_SCALING                16     /**< Fraction size of the PIE alpha and beta gains */
+#define RTE_PIE_QDELAY_MAX_RATIO            64     /**< Max queueing delay seen by PIE, in qdelay_ref units */
+#define RTE_PIE_TUNE_LEVELS                 6      /**< PIE auto-tuning levels */
+#define RTE_CODEL_INV_SQRT_SCALING          16     /**< Fraction size of the CoDel inverse square root table entries */
+#define RTE_CODEL_INV_SQRT_TABLE_SIZE       1024   /**< Drop counts with a precomputed inverse square root */
+
+/** Probability p scaled in 32-bit fixed point format */
+#define RTE_AQM_PROB(p)                     ((uint32_t) ((p) * 4294967296.0))
+
+/**
+ * Externs
+ *
+ */
+extern uint64_t rte_aqm_rand_seed;
+extern uint32_t rte_aqm_recip[RTE_AQM_RECIP_TABLE_SIZE];
+extern uint32_t rte_pie_tune_prob[RTE_PIE_TUNE_LEVELS];
+extern uint16_t rte_codel_inv_sqrt[RTE_CODEL_INV_SQRT_TABLE_SIZE];
+
+/**
+ * Departure rate estimator
+ *
+ * A sample is taken every time dq_threshold packets are read from the queue
+ * while the queue never runs empty, the average time between two departures
+ * being filtered with an EWMA of weight 1/8.
+ */
+struct rte_aqm_dq_rate {
+	uint64_t start;    /**< Time stamp of the current measurement start */
+	uint32_t pkt_time; /**< Average departure time per packet, scaled in fixed-point format (0: no sample yet) */
+	uint16_t start_qr; /**< Departure counter at the current measurement start */
+	uint16_t active;   /**< Measurement in progress */
+};
+
+/**
+ * PIE configuration parameters
+ */
+struct rte_pie_config {
+	uint64_t alpha;        /**< Gain on the delay error, scaled in fixed-point format */
+	uint64_t beta;         /**< Gain on the delay trend, scaled in fixed-point format */
+	uint32_t qdelay_ref;   /**< Target queueing delay */
+	uint32_t t_update;     /**< Drop probability update period */
+	uint32_t max_burst;    /**< Burst allowance */
+	uint16_t dq_threshold; /**< Departures per departure rate sample (packets) */
+};
+
+/**
+ * PIE run-time data, all zeroes being a valid initial state
+ */
+struct rte_pie {
+	struct rte_aqm_dq_rate dq; /**< Departure rate estimator */
+	uint64_t update_time;      /**< Time of the next drop probability update */
+	uint64_t qdelay_old;       /**< Queueing delay at the last update */
+	uint32_t prob;             /**< Drop probability, scaled in 32-bit fixed point format */
+	uint32_t burst_allowance;  /**< Burst allowance left */
+};
+
+/**
+ * CoDel configuration parameters
+ */
+struct rte_codel_config {
+	uint32_t target;       /**< Target queueing delay */
+	uint32_t interval;     /**< Time the delay has to stay above target before dropping */
+	uint16_t dq_threshold; /**< Departures per departure rate sample (packets) */
+};
+
+/**
+ * CoDel run-time data, all zeroes being a valid initial state
+ */
+struct rte_codel {
+	struct rte_aqm_dq_rate dq; /**< Departure rate estimator */
+	uint64_t first_above_time; /**< Time the delay can be above target until (0: below target) */
+	uint64_t drop_next;        /**< Time of the next drop in the dropping state */
+	uint32_t count;            /**< Packets dropped since entering the dropping state */
+	uint32_t lastcount;        /**< Value of count when last entering the dropping state */
+	uint32_t dropping;         /**< Dropping state */
+};
+
+/**
+ * @brief Configures a single PIE configuration parameter structure.
+ *
+ * The alpha and beta gains are the ones of RFC 8033 (0.125 Hz and 1.25 Hz
+ * with a 15 ms reference delay), scaled to qdelay_ref.
+ *
+ * @param cfg [in,out] config pointer to a PIE configuration parameter structure
+ * @param qdelay_ref [in] target queueing delay
+ * @param t_update [in] drop probability update period
+ * @param max_burst [in] burst allowance, during which no packet is dropped
+ * @param dq_threshold [in] departures per departure rate sample (packets)
+ *
+ * @return Operation status
+ * @retval 0 success
+ * @retval !0 error
+ */
+int
+rte_pie_config_init(struct rte_pie_config *cfg,
+	const uint32_t qdelay_ref,
+	const uint32_t t_update,
+	const uint32_t max_burst,
+	const uint16_t dq_threshold);
+
+/**
+ * @brief Initialises PIE run-time data
+ *
+ * @param pie [in,out] data pointer to PIE runtime data
+ *
+ * @return Operation status
+ * @retval 0 success
+ * @retval !0 error
+ */
+int
+rte_pie_rt_data_init(struct rte_pie *pie);
+
+/**
+ * @brief Configures a single CoDel configuration parameter structure.
+ *
+ * @param cfg [in,out] config pointer to a CoDel configuration parameter structure
+ * @param target [in] target queueing delay
+ * @param interval [in] time the delay has to stay above target before
+ *   dropping, larger than target
+ * @param dq_threshold [in] departures per departure rate sample (packets)
+ *
+ * @return Operation status
+ * @retval 0 success
+ * @retval !0 error
+ */
+int
+rte_codel_config_init(struct rte_codel_config *cfg,
+	const uint32_t target,
+	const uint32_t interval,
+	const uint16_t dq_threshold);
+
+/**
+ * @brief Initialises CoDel run-time data
+ *
+ * @param codel [in,out] data pointer to CoDel runtime data
+ *
+ * @return Operation status
+ * @retval 0 success
+ * @retval !0 error
+ */
+int
+rte_codel_rt_data_init(struct rte_codel *codel);
+
+/**
+ * @brief Generate random number for the AQM drop decisions
+ *
+ * @return Random number between 0 and (2^32 - 1)
+ */
+static inline uint32_t
+rte_aqm_rand(void)
+{
+	rte_aqm_rand_seed = rte_aqm_rand_seed * 6364136223846793005ULL +
+		1442695040888963407ULL;
+	return (uint32_t) (rte_aqm_rand_seed >> 32);
+}
+
+/**
+ * @brief Updates the departure rate estimate
+ *
+ * @param dq [in,out] departure rate estimator
+ * @param qlen [in] current queue size (measured in packets)
+ * @param qr [in] free running counter of the packets read from the queue
+ * @param time [in] current time stamp
+ * @param dq_threshold [in] departures per sample
+ */
+static inline void
+rte_aqm_dq_rate_update(struct rte_aqm_dq_rate *dq,
+	const uint32_t qlen,
+	const uint16_t qr,
+	const uint64_t time,
+	const uint16_t dq_threshold)
+{
+	if (dq->active) {
+		uint16_t n = (uint16_t) (qr - dq->start_qr);
+
+		if (unlikely(qlen == 0)) {
+			/* Queue drained: idle time is not departure time */
+			dq->active = 0;
+		} else if (n >= dq_threshold) {
+			uint64_t dt = time - dq->start;
+			uint64_t sample;
+
+			/* Divide by n through the reciprocal table */
+			if (likely(n < RTE_AQM_RECIP_TABLE_SIZE &&
+				dt < (1ULL << (64 - RTE_AQM_RECIP_SCALING -
+					RTE_AQM_DQ_SCALING))))
+				sample = ((dt << RTE_AQM_DQ_SCALING) *
+					rte_aqm_recip[n]) >> RTE_AQM_RECIP_SCALING;
+			else
+				sample = (dt << RTE_AQM_DQ_SCALING) / n;
+
+			if (unlikely(sample > UINT32_MAX))
+				sample = UINT32_MAX;
+
+			if (dq->pkt_time == 0)
+				dq->pkt_time = (uint32_t) sample;
+			else
+				dq->pkt_time += ((int64_t) sample -
+					(int64_t) dq->pkt_time) / 8;
+
+			dq->active = 0;
+		}
+	}
+
+	if (dq->active == 0 && qlen >= dq_threshold) {
+		dq->start = time;
+		dq->start_qr = qr;
+		dq->active = 1;
+	}
+}
+
+/**
+ * @brief Estimates the queueing delay
+ *
+ * @param dq [in] departure rate estimator
+ * @param qlen [in] current queue size (measured in packets)
+ *
+ * @return Time to send the packets currently in the queue
+ */
+static inline uint64_t
+rte_aqm_qdelay(const struct rte_aqm_dq_rate *dq, const uint32_t qlen)
+{
+	return ((uint64_t) qlen * dq->pkt_time) >> RTE_AQM_DQ_SCALING;
+}
+
+/**
+ * @brief Updates the PIE drop probability (RFC 8033, section 4.2)
+ *
+ * @param cfg [in] config pointer to a PIE configuration parameter structure
+ * @param pie [in,out] data pointer to PIE runtime data
+ * @param qdelay [in] current queueing delay
+ */
+static inline void
+__rte_pie_prob_update(const struct rte_pie_config *cfg,
+	struct rte_pie *pie,
+	uint64_t qdelay)
+{
+	uint64_t qdelay_max = (uint64_t) cfg->qdelay_ref *
+		RTE_PIE_QDELAY_MAX_RATIO;
+	int64_t p, prob;
+	uint32_t i;
+
+	/* Keep the products below within 64 bits */
+	if (qdelay > qdelay_max)
+		qdelay = qdelay_max;
+
+	p = ((int64_t) cfg->alpha * ((int64_t) qdelay - cfg->qdelay_ref) +
+		(int64_t) cfg->beta * ((int64_t) qdelay -
+			(int64_t) pie->qdelay_old)) /
+		(1LL << RTE_PIE_GAIN_SCALING);
+
+	/* Smaller steps while the drop probability is small */
+	for (i = 0; i < RTE_PIE_TUNE_LEVELS; i++) {
+		if (pie->prob < rte_pie_tune_prob[i]) {
+			p /= 1 << (11 - 2 * i);
+			break;
+		}
+	}
+
+	/* No big step once the drop probability is significant */
+	if (pie->prob >= RTE_AQM_PROB(0.1) && p > RTE_AQM_PROB(0.02))
+		p = RTE_AQM_PROB(0.02);
+
+	prob = (int64_t) pie->prob + p;
+
+	/* Exponential decay when the queue stays empty */
+	if (qdelay == 0 && pie->qdelay_old == 0)
+		prob -= prob / 50;
+
+	if (prob < 0)
+		prob = 0;
+	else if (prob > UINT32_MAX)
+		prob = UINT32_MAX;
+
+	pie->prob = (uint32_t) prob;
+
+	/* Burst allowance */
+	if (pie->burst_allowance > cfg->t_update)
+		pie->burst_allowance -= cfg->t_update;
+	else
+		pie->burst_allowance = 0;
+
+	if (pie->prob == 0 && qdelay < cfg->qdelay_ref / 2 &&
+		pie->qdelay_old < cfg->qdelay_ref / 2)
+		pie->burst_allowance = cfg->max_burst;
+
+	pie->qdelay_old = qdelay;
+}
+
+/**
+ * @brief Decides if new packet should be enqueued or dropped by PIE
+ *
+ * @param cfg [in] config pointer to a PIE configuration parameter structure
+ * @param pie [in,out] data pointer to PIE runtime data
+ * @param qlen [in] current queue size (measured in packets)
+ * @param qr [in] free running counter of the packets read from the queue
+ * @param time [in] current time stamp
+ *
+ * @return Operation status
+ * @retval 0 enqueue the packet
+ * @retval 1 drop the packet
+ */
+static inline int
+rte_pie_enqueue(const struct rte_pie_config *cfg,
+	struct rte_pie *pie,
+	const uint32_t qlen,
+	const uint16_t qr,
+	const uint64_t time)
+{
+	rte_aqm_dq_rate_update(&pie->dq, qlen, qr, time, cfg->dq_threshold);
+
+	if (unlikely(time >= pie->update_time)) {
+		__rte_pie_prob_update(cfg, pie, rte_aqm_qdelay(&pie->dq, qlen));
+		pie->update_time = time + cfg->t_update;
+	}
+
+	/* No drop during a burst, at low delay or with a nearly empty queue */
+	if (pie->burst_allowance != 0 ||
+		(pie->qdelay_old < cfg->qdelay_ref / 2 &&
+			pie->prob < RTE_AQM_PROB(0.2)) ||
+		qlen < 2)
+		return 0;
+
+	return rte_aqm_rand() < pie->prob;
+}
+
+/**
+ * @brief Computes the time of the next CoDel drop: t + interval / sqrt(count)
+ *
+ * @param cfg [in] config pointer to a CoDel configuration parameter structure
+ * @param t [in] time stamp
+ * @param count [in] drop count
+ *
+ * @return Time of the next drop
+ */
+static inline uint64_t
+__rte_codel_control_law(const struct rte_codel_config *cfg,
+	const uint64_t t,
+	uint32_t count)
+{
+	if (count < 2)
+		return t + cfg->interval;
+
+	if (unlikely(count >= RTE_CODEL_INV_SQRT_TABLE_SIZE))
+		count = RTE_CODEL_INV_SQRT_TABLE_SIZE - 1;
+
+	return t + (((uint64_t) cfg->interval * rte_codel_inv_sqrt[count]) >>
+		RTE_CODEL_INV_SQRT_SCALING);
+}
+
+/**
+ * @brief Decides if new packet should be enqueued or dropped by CoDel
+ *
+ * The CoDel state machine (RFC 8289) runs on the enqueued packets instead of
+ * the dequeued ones, with the sojourn time replaced by the queueing delay
+ * estimate, so the packet dropped is the one arriving instead of the one at
+ * the queue head.
+ *
+ * @param cfg [in] config pointer to a CoDel configuration parameter structure
+ * @param codel [in,out] data pointer to CoDel runtime data
+ * @param qlen [in] current queue size (measured in packets)
+ * @param qr [in] free running counter of the packets read from the queue
+ * @param time [in] current time stamp
+ *
+ * @return Operation status
+ * @retval 0 enqueue the packet
+ * @retval 1 drop the packet
+ */
+static inline int
+rte_codel_enqueue(const struct rte_codel_config *cfg,
+	struct rte_codel *codel,
+	const uint32_t qlen,
+	const uint16_t qr,
+	const uint64_t time)
+{
+	uint32_t delta;
+	int ok_to_drop = 0;
+
+	rte_aqm_dq_rate_update(&codel->dq, qlen, qr, time, cfg->dq_threshold);
+
+	if (rte_aqm_qdelay(&codel->dq, qlen) < cfg->target || qlen < 2)
+		codel->first_above_time = 0;
+	else if (codel->first_above_time == 0)
+		codel->first_above_time = time + cfg->interval;
+	else if (time >= codel->first_above_time)
+		ok_to_drop = 1;
+
+	if (codel->dropping) {
+		if (!ok_to_drop) {
+			codel->dropping = 0;
+			return 0;
+		}
+
+		if (time < codel->drop_next)
+			return 0;
+
+		codel->count++;
+		codel->drop_next = __rte_codel_control_law(cfg,
+			codel->drop_next, codel->count);
+		return 1;
+	}
+
+	if (!ok_to_drop)
+		return 0;
+
+	/* Enter the dropping state, resuming the previous drop rate when
+	 * the last dropping state ended recently */
+	codel->dropping = 1;
+	delta = codel->count - codel->lastcount;
+	if (delta > 1 && (int64_t) (time - codel->drop_next) <
+		16 * (int64_t) cfg->interval)
+		codel->count = delta;
+	else
+		codel->count = 1;
+	codel->lastcount = codel->count;
+	codel->drop_next = __rte_codel_control_law(cfg, time, codel->count);
+
+	return 1;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __RTE_AQM_H_INCLUDED__ */
@@ -434,6 +434,77 @@ rte_red_enqueue(const struct rte_red_config *red_cfg,
 	}
 }
 
+/**
+ * @brief Decides which packets of a burst should be enqueued or dropped
+ *
+ * All the packets of the burst go to the same queue and are evaluated back to
+ * back, each packet enqueued increasing by one the queue size seen by the next
+ * one. The verdicts and the run-time data are the same as the ones obtained by
+ * calling rte_red_enqueue() for each packet in turn.
+ *
+ * With wq = 2^(-n), the scaled average avg_s never goes above
+ * max(avg_s, (Q << (N + n)) + 2^n) while the queue size stays below Q. When
+ * this bound is below the min threshold for the whole burst, no packet can be
+ * dropped and only the EWMA filter is run, without any compare or branch per
+ * packet.
+ *
+ * @param red_cfg [in] config pointer to a RED configuration parameter structure
+ * @param red [in,out] data pointer to RED runtime data
+ * @param q [in] queue size (measured in packets) before the burst
+ * @param time [in] current time stamp
+ * @param n_pkts [in] number of packets in the burst, up to 64
+ *
+ * @return Bit mask of the packets to drop (bit i set for packet i)
+ */
+static inline uint64_t
+rte_red_enqueue_bulk(const struct rte_red_config *red_cfg,
+	struct rte_red *red,
+	unsigned q,
+	const uint64_t time,
+	const uint32_t n_pkts)
+{
+	uint64_t drop_mask = 0, avg_max;
+	uint32_t i = 0;
+
+	RTE_RED_ASSERT(red_cfg != NULL);
+	RTE_RED_ASSERT(red != NULL);
+	RTE_RED_ASSERT(n_pkts <= 64);
+
+	if (n_pkts == 0)
+		return 0;
+
+	/* The first packet into an empty queue is never dropped */
+	if (q == 0) {
+		rte_red_enqueue_empty(red_cfg, red, time);
+		q = 1;
+		i = 1;
+	}
+
+	avg_max = ((uint64_t) (q + n_pkts - i) <<
+		(red_cfg->wq_log2 + RTE_RED_SCALING)) +
+		(1 << red_cfg->wq_log2);
+	if (avg_max < red->avg)
+		avg_max = red->avg;
+
+	if (likely(avg_max < red_cfg->min_th)) {
+		red->count += n_pkts - i;
+		for ( ; i < n_pkts; i++, q++)
+			red->avg += (q << RTE_RED_SCALING) -
+				(red->avg >> red_cfg->wq_log2);
+
+		return 0;
+	}
+
+	for ( ; i < n_pkts; i++) {
+		if (rte_red_enqueue_nonempty(red_cfg, red, q) == 0)
+			q++;
+		else
+			drop_mask |= 1LLU << i;
+	}
+
+	return drop_mask;
+}
+
 /**
  * @brief Callback to records time that queue became empty
  *
@@ -31,6 +31,7 @@
  *   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <stddef.h>
 #include <stdio.h>
 #include <string.h>
 
@@ -39,6 +40,7 @@
 #include <rte_memory.h>
 #include <rte_malloc.h>
 #include <rte_cycles.h>
+#include <rte_atomic.h>
 #include <rte_prefetch.h>
 #include <rte_branch_prediction.h>
 #include <rte_mbuf.h>
@@ -48,6 +50,7 @@
 #include "rte_sched_common.h"
 #include "rte_approx.h"
 #include "rte_reciprocal.h"
+#include "rte_aqm.h"
 
 #ifdef __INTEL_COMPILER
 #pragma warning(disable:2259) /* conversion may lose significant bits */
@@ -68,6 +71,9 @@
 #define RTE_SCHED_PIPE_INVALID                UINT32_MAX
 #define RTE_SCHED_BMP_POS_INVALID             UINT32_MAX
 
+/* Pipes prefetched ahead by the bulk pipe configuration */
+#define RTE_SCHED_PIPE_CONFIG_PREFETCH        4
+
 /* Scaling for cycles_per_byte calculation
  * Chosen so that minimum rate is 480 bit/sec
  */
@@ -83,8 +89,8 @@ struct rte_sched_subport {
 
 	/* Traffic classes (TCs) */
 	uint64_t tc_time; /* time of next update */
-	uint32_t tc_credits_per_period[RTE_SCHED_TRAFFIC_CLASSES_PER_PIPE];
-	uint32_t tc_credits[RTE_SCHED_TRAFFIC_CLASSES_PER_PIPE];
+	uint32_t tc_credits_per_period[RTE_SCHED_TRAFFIC_CLASSES_MAX];
+	uint32_t tc_credits[RTE_SCHED_TRAFFIC_CLASSES_MAX];
 	uint32_t tc_period;
 
 	/* TC oversubscription */
@@ -108,11 +114,17 @@ struct rte_sched_pipe_profile {
 
 	/* Pipe traffic classes */
 	uint32_t tc_period;
-	uint32_t tc_credits_per_period[RTE_SCHED_TRAFFIC_CLASSES_PER_PIPE];
 	uint8_t tc_ov_weight;
 
 	/* Pipe queues */
 	uint8_t  wrr_cost[RTE_SCHED_QUEUES_PER_PIPE];
+
+	/* Kept after the fields above, so that the credits of the default
+	 * number of TCs are in the same cache line */
+	uint32_t tc_credits_per_period[RTE_SCHED_TRAFFIC_CLASSES_MAX];
+
+	/* Lowest priority TC rate (fraction of port rate) */
+	double tc_ov_rate;
 };
 
 struct rte_sched_pipe {
@@ -125,7 +137,6 @@ struct rte_sched_pipe {
 
 	/* Traffic classes (TCs) */
 	uint64_t tc_time; /* time of next update */
-	uint32_t tc_credits[RTE_SCHED_TRAFFIC_CLASSES_PER_PIPE];
 
 	/* Weighted Round Robin (WRR) */
 	uint8_t wrr_tokens[RTE_SCHED_QUEUES_PER_PIPE];
@@ -133,8 +144,16 @@ struct rte_sched_pipe {
 	/* TC oversubscription */
 	uint32_t tc_ov_credits;
 	uint8_t tc_ov_period_id;
-	uint8_t reserved[3];
-} __rte_cache_aligned;
+	uint8_t configured;
+	uint8_t reserved[2];
+
+	/* TC credits, kept last so that the ones of the default number of
+	 * TCs share the first cache line with the fields above. The pipes of
+	 * a port are spaced by the size of the TCs in use (see
+	 * rte_sched_pipe_size_log2()), so a port of up to 4 TCs uses one
+	 * cache line per pipe. */
+	uint32_t tc_credits[RTE_SCHED_TRAFFIC_CLASSES_MAX];
+};
 
 struct rte_sched_queue {
 	uint16_t qw;
@@ -146,6 +165,7 @@ struct rte_sched_queue_extra {
 #ifdef RTE_SCHED_RED
 	struct rte_red red;
 #endif
+	uint64_t aqm_data[RTE_SCHED_AQM_DATA_SIZE / sizeof(uint64_t)];
 };
 
 enum grinder_state {
@@ -164,9 +184,9 @@ enum grinder_state {
  */
 struct rte_sched_port_hierarchy {
 	uint16_t queue:2;                /**< Queue ID (0 .. 3) */
-	uint16_t traffic_class:2;        /**< Traffic class ID (0 .. 3)*/
+	uint16_t traffic_class:4;        /**< Traffic class ID (0 .. 15)*/
 	uint32_t color:2;                /**< Color */
-	uint16_t unused:10;
+	uint16_t unused:8;
 	uint16_t subport;                /**< Subport ID */
 	uint32_t pipe;		         /**< Pipe ID */
 };
@@ -187,16 +207,18 @@ struct rte_sched_grinder {
 	struct rte_sched_pipe_profile *pipe_params;
 
 	/* TC cache */
-	uint8_t tccache_qmask[4];
-	uint32_t tccache_qindex[4];
+	uint8_t tccache_qmask[RTE_SCHED_TRAFFIC_CLASSES_MAX];
+	uint32_t tccache_qindex[RTE_SCHED_TRAFFIC_CLASSES_MAX];
 	uint32_t tccache_w;
 	uint32_t tccache_r;
 
-	/* Current TC */
+	/* Current TC. When the TC has less than 4 queues, the entries
+	 * beyond its last queue alias its first queues. */
 	uint32_t tc_index;
-	struct rte_sched_queue *queue[RTE_SCHED_TRAFFIC_CLASSES_PER_PIPE];
-	struct rte_mbuf **qbase[RTE_SCHED_TRAFFIC_CLASSES_PER_PIPE];
-	uint32_t qindex[RTE_SCHED_TRAFFIC_CLASSES_PER_PIPE];
+	uint32_t tc_qpos_mask;
+	struct rte_sched_queue *queue[RTE_SCHED_QUEUES_PER_TRAFFIC_CLASS];
+	struct rte_mbuf **qbase[RTE_SCHED_QUEUES_PER_TRAFFIC_CLASS];
+	uint32_t qindex[RTE_SCHED_QUEUES_PER_TRAFFIC_CLASS];
 	uint16_t qsize;
 	uint32_t qmask;
 	uint32_t qpos;
@@ -215,19 +237,38 @@ struct rte_sched_port {
 	uint32_t rate;
 	uint32_t mtu;
 	uint32_t frame_overhead;
-	uint16_t qsize[RTE_SCHED_TRAFFIC_CLASSES_PER_PIPE];
+	uint16_t qsize[RTE_SCHED_TRAFFIC_CLASSES_MAX];
 	uint32_t n_pipe_profiles;
-	uint32_t pipe_tc3_rate_max;
+	uint32_t pipe_tc_ov_rate_max;
+
+	/* Traffic class layout */
+	uint32_t n_traffic_classes;
+	uint32_t tc_ov_index;       /* lowest priority TC */
+	uint32_t tc_4_queues;       /* all TCs have 4 queues */
+	uint32_t tc_default;        /* 4 TCs of 4 queues */
+	uint8_t tc_n_queues[RTE_SCHED_TRAFFIC_CLASSES_MAX];
+	uint8_t tc_qpos[RTE_SCHED_TRAFFIC_CLASSES_MAX]; /* first queue */
+	uint8_t tc_qmask[RTE_SCHED_TRAFFIC_CLASSES_MAX]; /* n_queues - 1 */
+	uint8_t queue_tc[RTE_SCHED_QUEUES_PER_PIPE];
 #ifdef RTE_SCHED_RED
-	struct rte_red_config red_config[RTE_SCHED_TRAFFIC_CLASSES_PER_PIPE][e_RTE_METER_COLORS];
+	struct rte_red_config red_config[RTE_SCHED_TRAFFIC_CLASSES_MAX][e_RTE_METER_COLORS];
 #endif
 
+	/* Active queue management */
+	uint32_t aqm_tc_mask;         /* Traffic classes with an AQM hook */
+	rte_sched_aqm_enqueue_t aqm_enqueue[RTE_SCHED_TRAFFIC_CLASSES_MAX];
+	void *aqm_cfg[RTE_SCHED_TRAFFIC_CLASSES_MAX];
+
 	/* Timing */
 	uint64_t time_cpu_cycles;     /* Current CPU time measured in CPU cyles */
 	uint64_t time_cpu_bytes;      /* Current CPU time measured in bytes */
 	uint64_t time;                /* Current NIC TX time measured in bytes */
 	struct rte_reciprocal inv_cycles_per_byte; /* CPU cycles per byte */
 
+	/* Port group */
+	struct rte_sched_port_group *group;
+	int64_t group_credits;        /* Credits taken from the group, not used yet */
+
 	/* Scheduling loop detection */
 	uint32_t pipe_loop;
 	uint32_t pipe_exhaustion;
@@ -244,11 +285,13 @@ struct rte_sched_port {
 
 	/* Queue base calculation */
 	uint32_t qsize_add[RTE_SCHED_QUEUES_PER_PIPE];
+	uint16_t queue_qsize[RTE_SCHED_QUEUES_PER_PIPE];
 	uint32_t qsize_sum;
 
 	/* Large data structures */
 	struct rte_sched_subport *subport;
 	struct rte_sched_pipe *pipe;
+	uint32_t pipe_size_log2;
 	struct rte_sched_queue *queue;
 	struct rte_sched_queue_extra *queue_extra;
 	struct rte_sched_pipe_profile *pipe_profiles;
@@ -257,6 +300,21 @@ struct rte_sched_port {
 	uint8_t memory[0] __rte_cache_aligned;
 } __rte_cache_aligned;
 
+struct rte_sched_port_group {
+	/* Shared by all the member ports, on its own cache line. Virtual
+	 * time (in CPU cycles) at which the group bucket is empty again given
+	 * the credits granted so far. */
+	volatile uint64_t tat __rte_cache_aligned;
+
+	/* Read-only after creation */
+	uint32_t rate;
+	uint32_t tb_size;
+	uint32_t credits_grant;
+	uint64_t tb_cycles;           /* Time to fill the bucket in CPU cycles */
+	uint64_t cycles_per_byte;     /* Scaled by RTE_SCHED_TIME_SHIFT */
+	rte_atomic32_t n_ports;
+} __rte_cache_aligned;
+
 enum rte_sched_port_array {
 	e_RTE_SCHED_PORT_ARRAY_SUBPORT = 0,
 	e_RTE_SCHED_PORT_ARRAY_PIPE,
@@ -294,18 +352,129 @@ rte_sched_port_qbase(struct rte_sched_port *port, uint32_t qindex)
 		port->qsize_sum + port->qsize_add[qpos]);
 }
 
+/*
+ * The enqueue and dequeue paths pass tc_default as a constant, chosen once
+ * per port: the default layout of 4 TCs of 4 queues then runs the constant
+ * indexed code, the tables of the TC layout are only read by the ports of
+ * another layout.
+ */
+static inline uint32_t
+rte_sched_port_queue_tc(struct rte_sched_port *port, uint32_t qindex,
+	uint32_t tc_default)
+{
+	if (tc_default)
+		return (qindex >> 2) & 0x3;
+
+	return port->queue_tc[qindex & (RTE_SCHED_QUEUES_PER_PIPE - 1)];
+}
+
+static inline struct rte_sched_pipe *
+rte_sched_port_pipe(struct rte_sched_port *port, uint32_t pindex,
+	uint32_t tc_default)
+{
+	uint32_t size_log2 = tc_default ? RTE_CACHE_LINE_SIZE_LOG2 :
+		port->pipe_size_log2;
+
+	return (struct rte_sched_pipe *) ((uint8_t *) port->pipe +
+		(pindex << size_log2));
+}
+
 static inline uint16_t
-rte_sched_port_qsize(struct rte_sched_port *port, uint32_t qindex)
+rte_sched_port_qsize(struct rte_sched_port *port, uint32_t qindex,
+	uint32_t tc_default)
 {
-	uint32_t tc = (qindex >> 2) & 0x3;
+	if (tc_default)
+		return port->qsize[(qindex >> 2) & 0x3];
+
+	return port->queue_qsize[qindex & (RTE_SCHED_QUEUES_PER_PIPE - 1)];
+}
+
+/* Traffic class layout: number of queues of each TC, default or custom */
+static uint32_t
+rte_sched_port_tc_layout(struct rte_sched_port_params *params,
+	uint8_t *n_queues)
+{
+	uint32_t i;
+
+	if (params->n_queues_per_tc[0] == 0) {
+		for (i = 0; i < RTE_SCHED_TRAFFIC_CLASSES_PER_PIPE; i++)
+			n_queues[i] = RTE_SCHED_QUEUES_PER_TRAFFIC_CLASS;
+
+		return RTE_SCHED_TRAFFIC_CLASSES_PER_PIPE;
+	}
+
+	for (i = 0; i < RTE_SCHED_TRAFFIC_CLASSES_MAX; i++) {
+		if (params->n_queues_per_tc[i] == 0)
+			break;
+
+		n_queues[i] = params->n_queues_per_tc[i];
+	}
+
+	return i;
+}
+
+/* Pipe context size: one cache line when the credits of the TCs in use fit
+ * in it, two otherwise, which then hold the whole structure */
+static uint32_t
+rte_sched_pipe_size_log2(uint32_t n_tcs)
+{
+	uint32_t size = offsetof(struct rte_sched_pipe, tc_credits) +
+		n_tcs * sizeof(uint32_t);
+
+	RTE_BUILD_BUG_ON(sizeof(struct rte_sched_pipe) >
+		2 * RTE_CACHE_LINE_SIZE);
+
+	if (size <= RTE_CACHE_LINE_SIZE)
+		return RTE_CACHE_LINE_SIZE_LOG2;
+
+	return RTE_CACHE_LINE_SIZE_LOG2 + 1;
+}
+
+static int
+rte_sched_pipe_profile_check(struct rte_sched_pipe_params *p,
+	uint32_t rate, uint32_t n_tcs, uint32_t n_queues_per_pipe)
+{
+	uint32_t j;
+
+	/* TB rate: non-zero, not greater than port rate */
+	if (p->tb_rate == 0 || p->tb_rate > rate)
+		return -10;
+
+	/* TB size: non-zero */
+	if (p->tb_size == 0)
+		return -11;
+
+	/* TC rate: non-zero, less than pipe rate */
+	for (j = 0; j < n_tcs; j++) {
+		if (p->tc_rate[j] == 0 || p->tc_rate[j] > p->tb_rate)
+			return -12;
+	}
 
-	return port->qsize[tc];
+	/* TC period: non-zero */
+	if (p->tc_period == 0)
+		return -13;
+
+#ifdef RTE_SCHED_SUBPORT_TC_OV
+	/* Lowest priority TC oversubscription weight: non-zero */
+	if (p->tc_ov_weight == 0)
+		return -14;
+#endif
+
+	/* Queue WRR weights: non-zero */
+	for (j = 0; j < n_queues_per_pipe; j++) {
+		if (p->wrr_weights[j] == 0)
+			return -15;
+	}
+
+	return 0;
 }
 
 static int
 rte_sched_port_check_params(struct rte_sched_port_params *params)
 {
-	uint32_t i, j;
+	uint8_t n_queues[RTE_SCHED_TRAFFIC_CLASSES_MAX];
+	uint32_t n_tcs, n_queues_per_pipe;
+	uint32_t i;
 
 	if (params == NULL)
 		return -1;
@@ -333,10 +502,25 @@ rte_sched_port_check_params(struct rte_sched_port_params *params)
 	    !rte_is_power_of_2(params->n_pipes_per_subport))
 		return -7;
 
+	/* n_queues_per_tc: 1, 2 or 4 queues per TC, no more than
+	 * RTE_SCHED_QUEUES_PER_PIPE queues in total
+	 */
+	n_tcs = rte_sched_port_tc_layout(params, n_queues);
+	n_queues_per_pipe = 0;
+	for (i = 0; i < n_tcs; i++) {
+		if (!rte_is_power_of_2(n_queues[i]) ||
+		    n_queues[i] > RTE_SCHED_QUEUES_PER_TRAFFIC_CLASS)
+			return -16;
+
+		n_queues_per_pipe += n_queues[i];
+	}
+	if (n_queues_per_pipe > RTE_SCHED_QUEUES_PER_PIPE)
+		return -16;
+
 	/* qsize: non-zero, power of 2,
 	 * no bigger than 32K (due to 16-bit read/write pointers)
 	 */
-	for (i = 0; i < RTE_SCHED_TRAFFIC_CLASSES_PER_PIPE; i++) {
+	for (i = 0; i < n_tcs; i++) {
 		uint16_t qsize = params->qsize[i];
 
 		if (qsize == 0 || !rte_is_power_of_2(qsize))
@@ -351,36 +535,12 @@ rte_sched_port_check_params(struct rte_sched_port_params *params)
 
 	for (i = 0; i < params->n_pipe_profiles; i++) {
 		struct rte_sched_pipe_params *p = params->pipe_profiles + i;
+		int status;
 
-		/* TB rate: non-zero, not greater than port rate */
-		if (p->tb_rate == 0 || p->tb_rate > params->rate)
-			return -10;
-
-		/* TB size: non-zero */
-		if (p->tb_size == 0)
-			return -11;
-
-		/* TC rate: non-zero, less than pipe rate */
-		for (j = 0; j < RTE_SCHED_TRAFFIC_CLASSES_PER_PIPE; j++) {
-			if (p->tc_rate[j] == 0 || p->tc_rate[j] > p->tb_rate)
-				return -12;
-		}
-
-		/* TC period: non-zero */
-		if (p->tc_period == 0)
-			return -13;
-
-#ifdef RTE_SCHED_SUBPORT_TC_OV
-		/* TC3 oversubscription weight: non-zero */
-		if (p->tc_ov_weight == 0)
-			return -14;
-#endif
-
-		/* Queue WRR weights: non-zero */
-		for (j = 0; j < RTE_SCHED_QUEUES_PER_PIPE; j++) {
-			if (p->wrr_weights[j] == 0)
-				return -15;
-		}
+		status = rte_sched_pipe_profile_check(p, params->rate,
+			n_tcs, n_queues_per_pipe);
+		if (status != 0)
+			return status;
 	}
 
 	return 0;
@@ -395,7 +555,7 @@ rte_sched_port_get_array_base(struct rte_sched_port_params *params, enum rte_sch
 	uint32_t n_queues_per_port = RTE_SCHED_QUEUES_PER_PIPE * n_pipes_per_subport * n_subports_per_port;
 
 	uint32_t size_subport = n_subports_per_port * sizeof(struct rte_sched_subport);
-	uint32_t size_pipe = n_pipes_per_port * sizeof(struct rte_sched_pipe);
+	uint32_t size_pipe;
 	uint32_t size_queue = n_queues_per_port * sizeof(struct rte_sched_queue);
 	uint32_t size_queue_extra
 		= n_queues_per_port * sizeof(struct rte_sched_queue_extra);
@@ -403,12 +563,16 @@ rte_sched_port_get_array_base(struct rte_sched_port_params *params, enum rte_sch
 		= RTE_SCHED_PIPE_PROFILES_PER_PORT * sizeof(struct rte_sched_pipe_profile);
 	uint32_t size_bmp_array = rte_bitmap_get_memory_footprint(n_queues_per_port);
 	uint32_t size_per_pipe_queue_array, size_queue_array;
+	uint8_t n_queues[RTE_SCHED_TRAFFIC_CLASSES_MAX];
+	uint32_t n_tcs;
 
 	uint32_t base, i;
 
+	n_tcs = rte_sched_port_tc_layout(params, n_queues);
+	size_pipe = n_pipes_per_port << rte_sched_pipe_size_log2(n_tcs);
 	size_per_pipe_queue_array = 0;
-	for (i = 0; i < RTE_SCHED_TRAFFIC_CLASSES_PER_PIPE; i++) {
-		size_per_pipe_queue_array += RTE_SCHED_QUEUES_PER_TRAFFIC_CLASS
+	for (i = 0; i < n_tcs; i++) {
+		size_per_pipe_queue_array += n_queues[i]
 			* params->qsize[i] * sizeof(struct rte_mbuf *);
 	}
 	size_queue_array = n_pipes_per_port * size_per_pipe_queue_array;
@@ -467,45 +631,73 @@ rte_sched_port_get_memory_footprint(struct rte_sched_port_params *params)
 }
 
 static void
-rte_sched_port_config_qsize(struct rte_sched_port *port)
+rte_sched_port_config_tc_layout(struct rte_sched_port *port,
+	struct rte_sched_port_params *params)
 {
-	/* TC 0 */
-	port->qsize_add[0] = 0;
-	port->qsize_add[1] = port->qsize_add[0] + port->qsize[0];
-	port->qsize_add[2] = port->qsize_add[1] + port->qsize[0];
-	port->qsize_add[3] = port->qsize_add[2] + port->qsize[0];
+	uint32_t i, j, qpos;
 
-	/* TC 1 */
-	port->qsize_add[4] = port->qsize_add[3] + port->qsize[0];
-	port->qsize_add[5] = port->qsize_add[4] + port->qsize[1];
-	port->qsize_add[6] = port->qsize_add[5] + port->qsize[1];
-	port->qsize_add[7] = port->qsize_add[6] + port->qsize[1];
+	port->n_traffic_classes = rte_sched_port_tc_layout(params,
+		port->tc_n_queues);
+	port->tc_ov_index = port->n_traffic_classes - 1;
 
-	/* TC 2 */
-	port->qsize_add[8] = port->qsize_add[7] + port->qsize[1];
-	port->qsize_add[9] = port->qsize_add[8] + port->qsize[2];
-	port->qsize_add[10] = port->qsize_add[9] + port->qsize[2];
-	port->qsize_add[11] = port->qsize_add[10] + port->qsize[2];
+	/* Queue positions not used by any TC are mapped to the last TC, they
+	 * never hold any packet */
+	memset(port->queue_tc, port->tc_ov_index, sizeof(port->queue_tc));
 
-	/* TC 3 */
-	port->qsize_add[12] = port->qsize_add[11] + port->qsize[2];
-	port->qsize_add[13] = port->qsize_add[12] + port->qsize[3];
-	port->qsize_add[14] = port->qsize_add[13] + port->qsize[3];
-	port->qsize_add[15] = port->qsize_add[14] + port->qsize[3];
+	port->tc_4_queues = 1;
+	for (i = 0, qpos = 0; i < port->n_traffic_classes; i++) {
+		if (port->tc_n_queues[i] != RTE_SCHED_QUEUES_PER_TRAFFIC_CLASS)
+			port->tc_4_queues = 0;
 
-	port->qsize_sum = port->qsize_add[15] + port->qsize[3];
+		port->tc_qpos[i] = qpos;
+		port->tc_qmask[i] = port->tc_n_queues[i] - 1;
+		for (j = 0; j < port->tc_n_queues[i]; j++)
+			port->queue_tc[qpos++] = i;
+	}
+
+	/* TC IDs beyond the last TC are mapped to the last TC */
+	for ( ; i < RTE_SCHED_TRAFFIC_CLASSES_MAX; i++) {
+		port->tc_qpos[i] = port->tc_qpos[port->tc_ov_index];
+		port->tc_qmask[i] = port->tc_qmask[port->tc_ov_index];
+	}
+
+	port->tc_default = port->tc_4_queues &&
+		port->n_traffic_classes == RTE_SCHED_TRAFFIC_CLASSES_PER_PIPE;
+	port->pipe_size_log2 = rte_sched_pipe_size_log2(port->n_traffic_classes);
+}
+
+static void
+rte_sched_port_config_qsize(struct rte_sched_port *port)
+{
+	uint32_t i, j, qpos, qsize_sum;
+
+	/* Queues of each TC are stored back to back, unused queue positions
+	 * take no space */
+	for (i = 0, qpos = 0, qsize_sum = 0; i < port->n_traffic_classes; i++)
+		for (j = 0; j < port->tc_n_queues[i]; j++) {
+			port->queue_qsize[qpos] = port->qsize[i];
+			port->qsize_add[qpos++] = qsize_sum;
+			qsize_sum += port->qsize[i];
+		}
+
+	for ( ; qpos < RTE_SCHED_QUEUES_PER_PIPE; qpos++) {
+		port->queue_qsize[qpos] = port->qsize[port->tc_ov_index];
+		port->qsize_add[qpos] = qsize_sum;
+	}
+
+	port->qsize_sum = qsize_sum;
 }
 
 static void
 rte_sched_port_log_pipe_profile(struct rte_sched_port *port, uint32_t i)
 {
 	struct rte_sched_pipe_profile *p = port->pipe_profiles + i;
+	uint32_t j;
 
 	RTE_LOG(DEBUG, SCHED, "Low level config for pipe profile %u:\n"
 		"    Token bucket: period = %u, credits per period = %u, size = %u\n"
-		"    Traffic classes: period = %u, credits per period = [%u, %u, %u, %u]\n"
-		"    Traffic class 3 oversubscription: weight = %hhu\n"
-		"    WRR cost: [%hhu, %hhu, %hhu, %hhu], [%hhu, %hhu, %hhu, %hhu], [%hhu, %hhu, %hhu, %hhu], [%hhu, %hhu, %hhu, %hhu]\n",
+		"    Traffic classes: period = %u\n"
+		"    Traffic class %u oversubscription: weight = %hhu\n",
 		i,
 
 		/* Token bucket */
@@ -515,19 +707,24 @@ rte_sched_port_log_pipe_profile(struct rte_sched_port *port, uint32_t i)
 
 		/* Traffic classes */
 		p->tc_period,
-		p->tc_credits_per_period[0],
-		p->tc_credits_per_period[1],
-		p->tc_credits_per_period[2],
-		p->tc_credits_per_period[3],
 
-		/* Traffic class 3 oversubscription */
-		p->tc_ov_weight,
-
-		/* WRR */
-		p->wrr_cost[ 0], p->wrr_cost[ 1], p->wrr_cost[ 2], p->wrr_cost[ 3],
-		p->wrr_cost[ 4], p->wrr_cost[ 5], p->wrr_cost[ 6], p->wrr_cost[ 7],
-		p->wrr_cost[ 8], p->wrr_cost[ 9], p->wrr_cost[10], p->wrr_cost[11],
-		p->wrr_cost[12], p->wrr_cost[13], p->wrr_cost[14], p->wrr_cost[15]);
+		/* Lowest priority traffic class oversubscription */
+		port->tc_ov_index,
+		p->tc_ov_weight);
+
+	for (j = 0; j < port->n_traffic_classes; j++) {
+		uint32_t qpos = port->tc_qpos[j];
+
+		RTE_LOG(DEBUG, SCHED,
+			"    Traffic class %u: credits per period = %u, "
+			"WRR cost: [%hhu, %hhu, %hhu, %hhu]\n",
+			j,
+			p->tc_credits_per_period[j],
+			p->wrr_cost[qpos],
+			port->tc_n_queues[j] > 1 ? p->wrr_cost[qpos + 1] : 0,
+			port->tc_n_queues[j] > 2 ? p->wrr_cost[qpos + 2] : 0,
+			port->tc_n_queues[j] > 3 ? p->wrr_cost[qpos + 3] : 0);
+	}
 }
 
 static inline uint64_t
@@ -541,79 +738,81 @@ rte_sched_time_ms_to_bytes(uint32_t time_ms, uint32_t rate)
 }
 
 static void
-rte_sched_port_config_pipe_profile_table(struct rte_sched_port *port, struct rte_sched_port_params *params)
+rte_sched_pipe_profile_convert(struct rte_sched_port *port,
+	struct rte_sched_pipe_params *src,
+	struct rte_sched_pipe_profile *dst)
 {
-	uint32_t i, j;
+	uint32_t j;
 
-	for (i = 0; i < port->n_pipe_profiles; i++) {
-		struct rte_sched_pipe_params *src = params->pipe_profiles + i;
-		struct rte_sched_pipe_profile *dst = port->pipe_profiles + i;
+	memset(dst, 0, sizeof(*dst));
 
-		/* Token Bucket */
-		if (src->tb_rate == params->rate) {
-			dst->tb_credits_per_period = 1;
-			dst->tb_period = 1;
-		} else {
-			double tb_rate = (double) src->tb_rate
-				/ (double) params->rate;
-			double d = RTE_SCHED_TB_RATE_CONFIG_ERR;
-
-			rte_approx(tb_rate, d,
-				   &dst->tb_credits_per_period, &dst->tb_period);
-		}
-		dst->tb_size = src->tb_size;
+	/* Token Bucket */
+	if (src->tb_rate == port->rate) {
+		dst->tb_credits_per_period = 1;
+		dst->tb_period = 1;
+	} else {
+		double tb_rate = (double) src->tb_rate
+			/ (double) port->rate;
+		double d = RTE_SCHED_TB_RATE_CONFIG_ERR;
 
-		/* Traffic Classes */
-		dst->tc_period = rte_sched_time_ms_to_bytes(src->tc_period,
-							    params->rate);
+		rte_approx(tb_rate, d,
+			   &dst->tb_credits_per_period, &dst->tb_period);
+	}
+	dst->tb_size = src->tb_size;
 
-		for (j = 0; j < RTE_SCHED_TRAFFIC_CLASSES_PER_PIPE; j++)
-			dst->tc_credits_per_period[j]
-				= rte_sched_time_ms_to_bytes(src->tc_period,
-							     src->tc_rate[j]);
+	/* Traffic Classes */
+	dst->tc_period = rte_sched_time_ms_to_bytes(src->tc_period,
+						    port->rate);
+
+	for (j = 0; j < port->n_traffic_classes; j++)
+		dst->tc_credits_per_period[j]
+			= rte_sched_time_ms_to_bytes(src->tc_period,
+						     src->tc_rate[j]);
 
 #ifdef RTE_SCHED_SUBPORT_TC_OV
-		dst->tc_ov_weight = src->tc_ov_weight;
+	dst->tc_ov_weight = src->tc_ov_weight;
 #endif
+	dst->tc_ov_rate = (double)
+		dst->tc_credits_per_period[port->tc_ov_index]
+		/ (double) dst->tc_period;
 
-		/* WRR */
-		for (j = 0; j < RTE_SCHED_TRAFFIC_CLASSES_PER_PIPE; j++) {
-			uint32_t wrr_cost[RTE_SCHED_QUEUES_PER_TRAFFIC_CLASS];
-			uint32_t lcd, lcd1, lcd2;
-			uint32_t qindex;
-
-			qindex = j * RTE_SCHED_QUEUES_PER_TRAFFIC_CLASS;
-
-			wrr_cost[0] = src->wrr_weights[qindex];
-			wrr_cost[1] = src->wrr_weights[qindex + 1];
-			wrr_cost[2] = src->wrr_weights[qindex + 2];
-			wrr_cost[3] = src->wrr_weights[qindex + 3];
-
-			lcd1 = rte_get_lcd(wrr_cost[0], wrr_cost[1]);
-			lcd2 = rte_get_lcd(wrr_cost[2], wrr_cost[3]);
-			lcd = rte_get_lcd(lcd1, lcd2);
+	/* WRR */
+	for (j = 0; j < port->n_traffic_classes; j++) {
+		uint32_t lcd, k;
+		uint32_t qindex = port->tc_qpos[j];
+		uint32_t n_queues = port->tc_n_queues[j];
+
+		lcd = src->wrr_weights[qindex];
+		for (k = 1; k < n_queues; k++)
+			lcd = rte_get_lcd(lcd,
+				src->wrr_weights[qindex + k]);
+
+		for (k = 0; k < n_queues; k++)
+			dst->wrr_cost[qindex + k] = (uint8_t)
+				(lcd / src->wrr_weights[qindex + k]);
+	}
+}
 
-			wrr_cost[0] = lcd / wrr_cost[0];
-			wrr_cost[1] = lcd / wrr_cost[1];
-			wrr_cost[2] = lcd / wrr_cost[2];
-			wrr_cost[3] = lcd / wrr_cost[3];
+static void
+rte_sched_port_config_pipe_profile_table(struct rte_sched_port *port, struct rte_sched_port_params *params)
+{
+	uint32_t i;
 
-			dst->wrr_cost[qindex] = (uint8_t) wrr_cost[0];
-			dst->wrr_cost[qindex + 1] = (uint8_t) wrr_cost[1];
-			dst->wrr_cost[qindex + 2] = (uint8_t) wrr_cost[2];
-			dst->wrr_cost[qindex + 3] = (uint8_t) wrr_cost[3];
-		}
+	for (i = 0; i < port->n_pipe_profiles; i++) {
+		struct rte_sched_pipe_params *src = params->pipe_profiles + i;
+		struct rte_sched_pipe_profile *dst = port->pipe_profiles + i;
 
+		rte_sched_pipe_profile_convert(port, src, dst);
 		rte_sched_port_log_pipe_profile(port, i);
 	}
 
-	port->pipe_tc3_rate_max = 0;
+	port->pipe_tc_ov_rate_max = 0;
 	for (i = 0; i < port->n_pipe_profiles; i++) {
 		struct rte_sched_pipe_params *src = params->pipe_profiles + i;
-		uint32_t pipe_tc3_rate = src->tc_rate[3];
+		uint32_t pipe_tc_ov_rate = src->tc_rate[port->tc_ov_index];
 
-		if (port->pipe_tc3_rate_max < pipe_tc3_rate)
-			port->pipe_tc3_rate_max = pipe_tc3_rate;
+		if (port->pipe_tc_ov_rate_max < pipe_tc_ov_rate)
+			port->pipe_tc_ov_rate_max = pipe_tc_ov_rate;
 	}
 }
 
@@ -636,6 +835,9 @@ rte_sched_port_config(struct rte_sched_port_params *params)
 	/* compile time checks */
 	RTE_BUILD_BUG_ON(RTE_SCHED_PORT_N_GRINDERS == 0);
 	RTE_BUILD_BUG_ON(RTE_SCHED_PORT_N_GRINDERS & (RTE_SCHED_PORT_N_GRINDERS - 1));
+	RTE_BUILD_BUG_ON(offsetof(struct rte_sched_pipe,
+		tc_credits[RTE_SCHED_TRAFFIC_CLASSES_PER_PIPE]) >
+		RTE_CACHE_LINE_SIZE);
 
 	/* User parameters */
 	port->n_subports_per_port = params->n_subports_per_port;
@@ -645,9 +847,10 @@ rte_sched_port_config(struct rte_sched_port_params *params)
 	port->frame_overhead = params->frame_overhead;
 	memcpy(port->qsize, params->qsize, sizeof(params->qsize));
 	port->n_pipe_profiles = params->n_pipe_profiles;
+	rte_sched_port_config_tc_layout(port, params);
 
 #ifdef RTE_SCHED_RED
-	for (i = 0; i < RTE_SCHED_TRAFFIC_CLASSES_PER_PIPE; i++) {
+	for (i = 0; i < port->n_traffic_classes; i++) {
 		uint32_t j;
 
 		for (j = 0; j < e_RTE_METER_COLORS; j++) {
@@ -745,23 +948,157 @@ rte_sched_port_free(struct rte_sched_port *port)
 		struct rte_mbuf **mbufs = rte_sched_port_qbase(port, queue);
 		unsigned int i;
 
-		for (i = 0; i < rte_sched_port_qsize(port, queue); i++)
+		for (i = 0; i < rte_sched_port_qsize(port, queue,
+			port->tc_default); i++)
 			rte_pktmbuf_free(mbufs[i]);
 	}
 
 	rte_bitmap_free(port->bmp);
+	if (port->group != NULL)
+		rte_atomic32_dec(&port->group->n_ports);
 	rte_free(port);
 }
 
+struct rte_sched_port_group *
+rte_sched_port_group_create(struct rte_sched_port_group_params *params)
+{
+	struct rte_sched_port_group *group;
+	uint64_t cycles_per_byte;
+
+	/* Check user parameters */
+	if (params == NULL ||
+	    params->name == NULL ||
+	    params->socket < 0 ||
+	    params->rate == 0 ||
+	    params->tb_size == 0 ||
+	    params->credits_grant == 0 ||
+	    params->credits_grant > params->tb_size)
+		return NULL;
+
+	group = rte_zmalloc_socket(params->name, sizeof(*group),
+		RTE_CACHE_LINE_SIZE, params->socket);
+	if (group == NULL)
+		return NULL;
+
+	group->rate = params->rate;
+	group->tb_size = params->tb_size;
+	group->credits_grant = params->credits_grant;
+
+	cycles_per_byte = (rte_get_tsc_hz() << RTE_SCHED_TIME_SHIFT)
+		/ params->rate;
+	if (cycles_per_byte == 0)
+		cycles_per_byte = 1;
+	group->cycles_per_byte = cycles_per_byte;
+	group->tb_cycles = (((uint64_t) params->tb_size) * cycles_per_byte)
+		>> RTE_SCHED_TIME_SHIFT;
+
+	/* Start with a full bucket */
+	group->tat = rte_get_tsc_cycles() - group->tb_cycles;
+	rte_atomic32_init(&group->n_ports);
+
+	return group;
+}
+
+void
+rte_sched_port_group_free(struct rte_sched_port_group *group)
+{
+	/* Check user parameters */
+	if (group == NULL)
+		return;
+
+	if (rte_atomic32_read(&group->n_ports) != 0) {
+		RTE_LOG(ERR, SCHED,
+			"Port group freed while still having member ports\n");
+		return;
+	}
+
+	rte_free(group);
+}
+
+int
+rte_sched_port_group_add(struct rte_sched_port_group *group,
+	struct rte_sched_port *port)
+{
+	/* Check user parameters */
+	if (group == NULL || port == NULL)
+		return -1;
+
+	if (port->group != NULL)
+		return -2;
+
+	port->group = group;
+	port->group_credits = 0;
+	rte_atomic32_inc(&group->n_ports);
+
+	return 0;
+}
+
+int
+rte_sched_port_aqm_set(struct rte_sched_port *port,
+	uint32_t traffic_class,
+	rte_sched_aqm_enqueue_t f_enqueue,
+	void *cfg)
+{
+	uint32_t n_queues, qindex;
+
+	/* Check user parameters */
+	if (port == NULL)
+		return -1;
+
+	if (traffic_class >= port->n_traffic_classes)
+		return -2;
+
+	if (f_enqueue != NULL && cfg == NULL)
+		return -3;
+
+	/* Start the queues of the traffic class from a clean state */
+	n_queues = rte_sched_port_queues_per_port(port);
+	for (qindex = 0; qindex < n_queues; qindex++) {
+		struct rte_sched_queue_extra *qe = port->queue_extra + qindex;
+
+		if (rte_sched_port_queue_tc(port, qindex,
+			port->tc_default) == traffic_class)
+			memset(qe->aqm_data, 0, sizeof(qe->aqm_data));
+	}
+
+	port->aqm_enqueue[traffic_class] = f_enqueue;
+	port->aqm_cfg[traffic_class] = cfg;
+	if (f_enqueue != NULL)
+		port->aqm_tc_mask |= 1u << traffic_class;
+	else
+		port->aqm_tc_mask &= ~(1u << traffic_class);
+
+	return 0;
+}
+
+int
+rte_sched_aqm_pie(void *cfg, void *data, uint32_t qlen, uint16_t qr,
+	uint64_t time)
+{
+	RTE_BUILD_BUG_ON(sizeof(struct rte_pie) > RTE_SCHED_AQM_DATA_SIZE);
+
+	return rte_pie_enqueue(cfg, data, qlen, qr, time);
+}
+
+int
+rte_sched_aqm_codel(void *cfg, void *data, uint32_t qlen, uint16_t qr,
+	uint64_t time)
+{
+	RTE_BUILD_BUG_ON(sizeof(struct rte_codel) > RTE_SCHED_AQM_DATA_SIZE);
+
+	return rte_codel_enqueue(cfg, data, qlen, qr, time);
+}
+
 static void
 rte_sched_port_log_subport_config(struct rte_sched_port *port, uint32_t i)
 {
 	struct rte_sched_subport *s = port->subport + i;
+	uint32_t j;
 
 	RTE_LOG(DEBUG, SCHED, "Low level config for subport %u:\n"
 		"    Token bucket: period = %u, credits per period = %u, size = %u\n"
-		"    Traffic classes: period = %u, credits per period = [%u, %u, %u, %u]\n"
-		"    Traffic class 3 oversubscription: wm min = %u, wm max = %u\n",
+		"    Traffic classes: period = %u\n"
+		"    Traffic class %u oversubscription: wm min = %u, wm max = %u\n",
 		i,
 
 		/* Token bucket */
@@ -771,23 +1108,61 @@ rte_sched_port_log_subport_config(struct rte_sched_port *port, uint32_t i)
 
 		/* Traffic classes */
 		s->tc_period,
-		s->tc_credits_per_period[0],
-		s->tc_credits_per_period[1],
-		s->tc_credits_per_period[2],
-		s->tc_credits_per_period[3],
 
-		/* Traffic class 3 oversubscription */
+		/* Lowest priority traffic class oversubscription */
+		port->tc_ov_index,
 		s->tc_ov_wm_min,
 		s->tc_ov_wm_max);
+
+	for (j = 0; j < port->n_traffic_classes; j++)
+		RTE_LOG(DEBUG, SCHED,
+			"    Traffic class %u: credits per period = %u\n",
+			j, s->tc_credits_per_period[j]);
+}
+
+static inline uint32_t
+rte_sched_port_n_queues_per_pipe(struct rte_sched_port *port)
+{
+	return port->tc_qpos[port->tc_ov_index] +
+		port->tc_n_queues[port->tc_ov_index];
 }
 
+#ifdef RTE_SCHED_SUBPORT_TC_OV
+
+/* Plug a pipe into (positive rate and weight) or unplug it from (negative
+ * rate and weight) the lowest priority TC oversubscription of its subport */
+static void
+rte_sched_subport_tc_ov_update(struct rte_sched_port *port,
+	uint32_t subport_id, double pipe_tc_ov_rate, int32_t pipe_tc_ov_weight)
+{
+	struct rte_sched_subport *s = port->subport + subport_id;
+	double subport_tc_ov_rate = (double)
+		s->tc_credits_per_period[port->tc_ov_index]
+		/ (double) s->tc_period;
+	uint32_t tc_ov = s->tc_ov;
+
+	s->tc_ov_n += pipe_tc_ov_weight;
+	s->tc_ov_rate += pipe_tc_ov_rate;
+	s->tc_ov = s->tc_ov_rate > subport_tc_ov_rate;
+
+	if (s->tc_ov != tc_ov) {
+		RTE_LOG(DEBUG, SCHED,
+			"Subport %u TC%u oversubscription is %s (%.4lf %s %.4lf)\n",
+			subport_id, port->tc_ov_index, s->tc_ov ? "ON" : "OFF",
+			subport_tc_ov_rate, s->tc_ov ? "<" : ">=",
+			s->tc_ov_rate);
+	}
+}
+
+#endif /* RTE_SCHED_SUBPORT_TC_OV */
+
 int
 rte_sched_subport_config(struct rte_sched_port *port,
 	uint32_t subport_id,
 	struct rte_sched_subport_params *params)
 {
 	struct rte_sched_subport *s;
-	uint32_t i;
+	uint32_t i, reconfig;
 
 	/* Check user parameters */
 	if (port == NULL ||
@@ -801,7 +1176,7 @@ rte_sched_subport_config(struct rte_sched_port *port,
 	if (params->tb_size == 0)
 		return -3;
 
-	for (i = 0; i < RTE_SCHED_TRAFFIC_CLASSES_PER_PIPE; i++) {
+	for (i = 0; i < port->n_traffic_classes; i++) {
 		if (params->tc_rate[i] == 0 ||
 		    params->tc_rate[i] > params->tb_rate)
 			return -4;
@@ -811,6 +1186,7 @@ rte_sched_subport_config(struct rte_sched_port *port,
 		return -5;
 
 	s = port->subport + subport_id;
+	reconfig = (s->tb_period != 0);
 
 	/* Token Bucket (TB) */
 	if (params->tb_rate == port->rate) {
@@ -824,30 +1200,50 @@ rte_sched_subport_config(struct rte_sched_port *port,
 	}
 
 	s->tb_size = params->tb_size;
-	s->tb_time = port->time;
-	s->tb_credits = s->tb_size / 2;
+	if (reconfig) {
+		/* Carry the credits over, within the new limits */
+		s->tb_credits = rte_sched_min_val_2_u32(s->tb_credits, s->tb_size);
+	} else {
+		s->tb_time = port->time;
+		s->tb_credits = s->tb_size / 2;
+	}
 
 	/* Traffic Classes (TCs) */
 	s->tc_period = rte_sched_time_ms_to_bytes(params->tc_period, port->rate);
-	for (i = 0; i < RTE_SCHED_TRAFFIC_CLASSES_PER_PIPE; i++) {
+	for (i = 0; i < port->n_traffic_classes; i++) {
 		s->tc_credits_per_period[i]
 			= rte_sched_time_ms_to_bytes(params->tc_period,
 						     params->tc_rate[i]);
 	}
-	s->tc_time = port->time + s->tc_period;
-	for (i = 0; i < RTE_SCHED_TRAFFIC_CLASSES_PER_PIPE; i++)
-		s->tc_credits[i] = s->tc_credits_per_period[i];
+	if (reconfig) {
+		if (s->tc_time > port->time + s->tc_period)
+			s->tc_time = port->time + s->tc_period;
+		for (i = 0; i < port->n_traffic_classes; i++)
+			s->tc_credits[i] = rte_sched_min_val_2_u32(
+				s->tc_credits[i], s->tc_credits_per_period[i]);
+	} else {
+		s->tc_time = port->time + s->tc_period;
+		for (i = 0; i < port->n_traffic_classes; i++)
+			s->tc_credits[i] = s->tc_credits_per_period[i];
+	}
 
 #ifdef RTE_SCHED_SUBPORT_TC_OV
 	/* TC oversubscription */
 	s->tc_ov_wm_min = port->mtu;
 	s->tc_ov_wm_max = rte_sched_time_ms_to_bytes(params->tc_period,
-						     port->pipe_tc3_rate_max);
-	s->tc_ov_wm = s->tc_ov_wm_max;
-	s->tc_ov_period_id = 0;
-	s->tc_ov = 0;
-	s->tc_ov_n = 0;
-	s->tc_ov_rate = 0;
+						     port->pipe_tc_ov_rate_max);
+	if (reconfig) {
+		/* The pipes stay plugged into the subport */
+		s->tc_ov_wm = rte_sched_min_val_2_u32(s->tc_ov_wm,
+			s->tc_ov_wm_max);
+		rte_sched_subport_tc_ov_update(port, subport_id, 0, 0);
+	} else {
+		s->tc_ov_wm = s->tc_ov_wm_max;
+		s->tc_ov_period_id = 0;
+		s->tc_ov = 0;
+		s->tc_ov_n = 0;
+		s->tc_ov_rate = 0;
+	}
 #endif
 
 	rte_sched_port_log_subport_config(port, subport_id);
@@ -855,6 +1251,90 @@ rte_sched_subport_config(struct rte_sched_port *port,
 	return 0;
 }
 
+/* Keep the pipe credits of the current periods within the profile limits */
+static void
+rte_sched_pipe_credits_carry_over(struct rte_sched_port *port,
+	struct rte_sched_pipe *p,
+	struct rte_sched_pipe_profile *params)
+{
+	uint32_t i;
+
+	p->tb_credits = rte_sched_min_val_2_u32(p->tb_credits,
+		params->tb_size);
+
+	if (p->tc_time > port->time + params->tc_period)
+		p->tc_time = port->time + params->tc_period;
+	for (i = 0; i < port->n_traffic_classes; i++)
+		p->tc_credits[i] = rte_sched_min_val_2_u32(p->tc_credits[i],
+			params->tc_credits_per_period[i]);
+}
+
+static void
+rte_sched_pipe_config_one(struct rte_sched_port *port,
+	uint32_t subport_id,
+	uint32_t pipe_id,
+	int32_t pipe_profile)
+{
+	struct rte_sched_pipe *p;
+	struct rte_sched_pipe_profile *params;
+	uint32_t i;
+
+	p = rte_sched_port_pipe(port,
+		subport_id * port->n_pipes_per_subport + pipe_id,
+		port->tc_default);
+
+	/* Handle the case when pipe already has a valid configuration */
+	if (p->configured) {
+		params = port->pipe_profiles + p->profile;
+
+#ifdef RTE_SCHED_SUBPORT_TC_OV
+		/* Unplug pipe from its subport */
+		rte_sched_subport_tc_ov_update(port, subport_id,
+			-params->tc_ov_rate, -(int32_t) params->tc_ov_weight);
+#endif
+
+		if (pipe_profile < 0) {
+			/* Reset the pipe */
+			memset(p, 0, 1 << port->pipe_size_log2);
+			return;
+		}
+
+		/* Switch to the new profile, carrying the credits over */
+		p->profile = pipe_profile;
+		params = port->pipe_profiles + p->profile;
+		rte_sched_pipe_credits_carry_over(port, p, params);
+	} else {
+		if (pipe_profile < 0)
+			return;
+
+		/* Apply the new pipe configuration */
+		p->profile = pipe_profile;
+		params = port->pipe_profiles + p->profile;
+
+		/* Token Bucket (TB) */
+		p->tb_time = port->time;
+		p->tb_credits = params->tb_size / 2;
+
+		/* Traffic Classes (TCs) */
+		p->tc_time = port->time + params->tc_period;
+		for (i = 0; i < port->n_traffic_classes; i++)
+			p->tc_credits[i] = params->tc_credits_per_period[i];
+
+#ifdef RTE_SCHED_SUBPORT_TC_OV
+		p->tc_ov_period_id = port->subport[subport_id].tc_ov_period_id;
+		p->tc_ov_credits = port->subport[subport_id].tc_ov_wm;
+#endif
+
+		p->configured = 1;
+	}
+
+#ifdef RTE_SCHED_SUBPORT_TC_OV
+	/* Plug pipe into its subport */
+	rte_sched_subport_tc_ov_update(port, subport_id,
+		params->tc_ov_rate, params->tc_ov_weight);
+#endif
+}
+
 int
 rte_sched_pipe_config(struct rte_sched_port *port,
 	uint32_t subport_id,
@@ -862,9 +1342,7 @@ rte_sched_pipe_config(struct rte_sched_port *port,
 	int32_t pipe_profile)
 {
 	struct rte_sched_subport *s;
-	struct rte_sched_pipe *p;
-	struct rte_sched_pipe_profile *params;
-	uint32_t deactivate, profile, i;
+	uint32_t deactivate, profile;
 
 	/* Check user parameters */
 	profile = (uint32_t) pipe_profile;
@@ -882,74 +1360,169 @@ rte_sched_pipe_config(struct rte_sched_port *port,
 	if (s->tb_period == 0)
 		return -2;
 
-	p = port->pipe + (subport_id * port->n_pipes_per_subport + pipe_id);
+	rte_sched_pipe_config_one(port, subport_id, pipe_id, pipe_profile);
 
-	/* Handle the case when pipe already has a valid configuration */
-	if (p->tb_time) {
-		params = port->pipe_profiles + p->profile;
+	return 0;
+}
 
-#ifdef RTE_SCHED_SUBPORT_TC_OV
-		double subport_tc3_rate = (double) s->tc_credits_per_period[3]
-			/ (double) s->tc_period;
-		double pipe_tc3_rate = (double) params->tc_credits_per_period[3]
-			/ (double) params->tc_period;
-		uint32_t tc3_ov = s->tc_ov;
+int
+rte_sched_pipe_config_bulk(struct rte_sched_port *port,
+	uint32_t subport_id,
+	const uint32_t *pipe_ids,
+	const int32_t *pipe_profiles,
+	uint32_t n_pipes)
+{
+	struct rte_sched_subport *s;
+	uint32_t i;
 
-		/* Unplug pipe from its subport */
-		s->tc_ov_n -= params->tc_ov_weight;
-		s->tc_ov_rate -= pipe_tc3_rate;
-		s->tc_ov = s->tc_ov_rate > subport_tc3_rate;
-
-		if (s->tc_ov != tc3_ov) {
-			RTE_LOG(DEBUG, SCHED,
-				"Subport %u TC3 oversubscription is OFF (%.4lf >= %.4lf)\n",
-				subport_id, subport_tc3_rate, s->tc_ov_rate);
-		}
-#endif
+	/* Check user parameters, none of the pipes is changed on error */
+	if (port == NULL ||
+	    subport_id >= port->n_subports_per_port ||
+	    pipe_ids == NULL ||
+	    pipe_profiles == NULL)
+		return -1;
 
-		/* Reset the pipe */
-		memset(p, 0, sizeof(struct rte_sched_pipe));
+	for (i = 0; i < n_pipes; i++) {
+		if (pipe_ids[i] >= port->n_pipes_per_subport ||
+		    (pipe_profiles[i] >= 0 &&
+		     (uint32_t) pipe_profiles[i] >= port->n_pipe_profiles))
+			return -1;
 	}
 
-	if (deactivate)
-		return 0;
+	/* Check that subport configuration is valid */
+	s = port->subport + subport_id;
+	if (s->tb_period == 0)
+		return -2;
 
-	/* Apply the new pipe configuration */
-	p->profile = profile;
-	params = port->pipe_profiles + p->profile;
+	for (i = 0; i < n_pipes; i++) {
+		if (i + RTE_SCHED_PIPE_CONFIG_PREFETCH < n_pipes)
+			rte_prefetch0(rte_sched_port_pipe(port, subport_id *
+				port->n_pipes_per_subport +
+				pipe_ids[i + RTE_SCHED_PIPE_CONFIG_PREFETCH],
+				port->tc_default));
 
-	/* Token Bucket (TB) */
-	p->tb_time = port->time;
-	p->tb_credits = params->tb_size / 2;
+		rte_sched_pipe_config_one(port, subport_id, pipe_ids[i],
+			pipe_profiles[i]);
+	}
 
-	/* Traffic Classes (TCs) */
-	p->tc_time = port->time + params->tc_period;
-	for (i = 0; i < RTE_SCHED_TRAFFIC_CLASSES_PER_PIPE; i++)
-		p->tc_credits[i] = params->tc_credits_per_period[i];
+	return 0;
+}
+
+/* Raise the oversubscription watermark limit of the subports */
+static void
+rte_sched_port_tc_ov_rate_max_raise(struct rte_sched_port *port,
+	uint32_t pipe_tc_ov_rate)
+{
+	uint32_t i;
+
+	if (pipe_tc_ov_rate <= port->pipe_tc_ov_rate_max)
+		return;
+
+	port->pipe_tc_ov_rate_max = pipe_tc_ov_rate;
+
+	for (i = 0; i < port->n_subports_per_port; i++) {
+		struct rte_sched_subport *s = port->subport + i;
+
+		if (s->tb_period == 0)
+			continue;
+
+		s->tc_ov_wm_max = (uint32_t) (((uint64_t) s->tc_period *
+			pipe_tc_ov_rate) / port->rate);
+	}
+}
+
+int
+rte_sched_port_pipe_profile_add(struct rte_sched_port *port,
+	struct rte_sched_pipe_params *params,
+	uint32_t *pipe_profile_id)
+{
+	struct rte_sched_pipe_profile *pp;
+	int status;
+
+	/* Check user parameters */
+	if (port == NULL || params == NULL || pipe_profile_id == NULL)
+		return -1;
+
+	if (port->n_pipe_profiles >= RTE_SCHED_PIPE_PROFILES_PER_PORT)
+		return -2;
+
+	status = rte_sched_pipe_profile_check(params, port->rate,
+		port->n_traffic_classes, rte_sched_port_n_queues_per_pipe(port));
+	if (status != 0)
+		return status;
+
+	/* Append the profile to the table, existing profile IDs are kept */
+	*pipe_profile_id = port->n_pipe_profiles;
+	pp = port->pipe_profiles + port->n_pipe_profiles;
+	rte_sched_pipe_profile_convert(port, params, pp);
+	port->n_pipe_profiles++;
+
+	rte_sched_port_log_pipe_profile(port, *pipe_profile_id);
+
+	rte_sched_port_tc_ov_rate_max_raise(port,
+		params->tc_rate[port->tc_ov_index]);
+
+	return 0;
+}
+
+int
+rte_sched_port_pipe_profile_update(struct rte_sched_port *port,
+	uint32_t pipe_profile_id,
+	struct rte_sched_pipe_params *params)
+{
+	struct rte_sched_pipe_profile *pp;
+	uint32_t n_pipes, i;
+	int status;
+
+	/* Check user parameters */
+	if (port == NULL ||
+	    params == NULL ||
+	    pipe_profile_id >= port->n_pipe_profiles)
+		return -1;
+
+	status = rte_sched_pipe_profile_check(params, port->rate,
+		port->n_traffic_classes, rte_sched_port_n_queues_per_pipe(port));
+	if (status != 0)
+		return status;
+
+	/* Unplug the pipes using the profile */
+	pp = port->pipe_profiles + pipe_profile_id;
+	n_pipes = port->n_subports_per_port * port->n_pipes_per_subport;
 
 #ifdef RTE_SCHED_SUBPORT_TC_OV
-	{
-		/* Subport TC3 oversubscription */
-		double subport_tc3_rate = (double) s->tc_credits_per_period[3]
-			/ (double) s->tc_period;
-		double pipe_tc3_rate = (double) params->tc_credits_per_period[3]
-			/ (double) params->tc_period;
-		uint32_t tc3_ov = s->tc_ov;
-
-		s->tc_ov_n += params->tc_ov_weight;
-		s->tc_ov_rate += pipe_tc3_rate;
-		s->tc_ov = s->tc_ov_rate > subport_tc3_rate;
-
-		if (s->tc_ov != tc3_ov) {
-			RTE_LOG(DEBUG, SCHED,
-				"Subport %u TC3 oversubscription is ON (%.4lf < %.4lf)\n",
-				subport_id, subport_tc3_rate, s->tc_ov_rate);
-		}
-		p->tc_ov_period_id = s->tc_ov_period_id;
-		p->tc_ov_credits = s->tc_ov_wm;
+	for (i = 0; i < n_pipes; i++) {
+		struct rte_sched_pipe *p = rte_sched_port_pipe(port, i,
+			port->tc_default);
+
+		if (p->configured && p->profile == pipe_profile_id)
+			rte_sched_subport_tc_ov_update(port,
+				i / port->n_pipes_per_subport,
+				-pp->tc_ov_rate, -(int32_t) pp->tc_ov_weight);
 	}
 #endif
 
+	rte_sched_pipe_profile_convert(port, params, pp);
+	rte_sched_port_log_pipe_profile(port, pipe_profile_id);
+	rte_sched_port_tc_ov_rate_max_raise(port,
+		params->tc_rate[port->tc_ov_index]);
+
+	/* Plug them back with the new rates, carrying the credits over */
+	for (i = 0; i < n_pipes; i++) {
+		struct rte_sched_pipe *p = rte_sched_port_pipe(port, i,
+			port->tc_default);
+
+		if (!p->configured || p->profile != pipe_profile_id)
+			continue;
+
+		rte_sched_pipe_credits_carry_over(port, p, pp);
+
+#ifdef RTE_SCHED_SUBPORT_TC_OV
+		rte_sched_subport_tc_ov_update(port,
+			i / port->n_pipes_per_subport,
+			pp->tc_ov_rate, pp->tc_ov_weight);
+#endif
+	}
+
 	return 0;
 }
 
@@ -1048,13 +1621,24 @@ rte_sched_queue_read_stats(struct rte_sched_port *port,
 }
 
 static inline uint32_t
-rte_sched_port_qindex(struct rte_sched_port *port, uint32_t subport, uint32_t pipe, uint32_t traffic_class, uint32_t queue)
+rte_sched_port_qindex(struct rte_sched_port *port, uint32_t subport, uint32_t pipe, uint32_t traffic_class, uint32_t queue,
+	uint32_t tc_default)
 {
 	uint32_t result;
 
 	result = subport * port->n_pipes_per_subport + pipe;
-	result = result * RTE_SCHED_TRAFFIC_CLASSES_PER_PIPE + traffic_class;
-	result = result * RTE_SCHED_QUEUES_PER_TRAFFIC_CLASS + queue;
+	if (tc_default) {
+		traffic_class = rte_sched_min_val_2_u32(traffic_class,
+			RTE_SCHED_TRAFFIC_CLASSES_PER_PIPE - 1);
+		result = result * RTE_SCHED_TRAFFIC_CLASSES_PER_PIPE + traffic_class;
+		result = result * RTE_SCHED_QUEUES_PER_TRAFFIC_CLASS + queue;
+
+		return result;
+	}
+
+	result = result * RTE_SCHED_QUEUES_PER_PIPE +
+		port->tc_qpos[traffic_class] +
+		(queue & port->tc_qmask[traffic_class]);
 
 	return result;
 }
@@ -1074,10 +1658,11 @@ rte_sched_port_queue_is_empty(struct rte_sched_port *port, uint32_t qindex)
 #ifdef RTE_SCHED_COLLECT_STATS
 
 static inline void
-rte_sched_port_update_subport_stats(struct rte_sched_port *port, uint32_t qindex, struct rte_mbuf *pkt)
+rte_sched_port_update_subport_stats(struct rte_sched_port *port, uint32_t qindex, struct rte_mbuf *pkt,
+	uint32_t tc_default)
 {
 	struct rte_sched_subport *s = port->subport + (qindex / rte_sched_port_queues_per_subport(port));
-	uint32_t tc_index = (qindex >> 2) & 0x3;
+	uint32_t tc_index = rte_sched_port_queue_tc(port, qindex, tc_default);
 	uint32_t pkt_len = pkt->pkt_len;
 
 	s->stats.n_pkts_tc[tc_index] += 1;
@@ -1087,10 +1672,11 @@ rte_sched_port_update_subport_stats(struct rte_sched_port *port, uint32_t qindex
 static inline void
 rte_sched_port_update_subport_stats_on_drop(struct rte_sched_port *port,
 					    uint32_t qindex,
-					    struct rte_mbuf *pkt, uint32_t red)
+					    struct rte_mbuf *pkt, uint32_t red,
+					    uint32_t tc_default)
 {
 	struct rte_sched_subport *s = port->subport + (qindex / rte_sched_port_queues_per_subport(port));
-	uint32_t tc_index = (qindex >> 2) & 0x3;
+	uint32_t tc_index = rte_sched_port_queue_tc(port, qindex, tc_default);
 	uint32_t pkt_len = pkt->pkt_len;
 
 	s->stats.n_pkts_tc_dropped[tc_index] += 1;
@@ -1130,7 +1716,8 @@ rte_sched_port_update_queue_stats_on_drop(struct rte_sched_port *port,
 #ifdef RTE_SCHED_RED
 
 static inline int
-rte_sched_port_red_drop(struct rte_sched_port *port, struct rte_mbuf *pkt, uint32_t qindex, uint16_t qlen)
+rte_sched_port_red_drop(struct rte_sched_port *port, struct rte_mbuf *pkt, uint32_t qindex, uint16_t qlen,
+	uint32_t tc_default)
 {
 	struct rte_sched_queue_extra *qe;
 	struct rte_red_config *red_cfg;
@@ -1138,7 +1725,7 @@ rte_sched_port_red_drop(struct rte_sched_port *port, struct rte_mbuf *pkt, uint3
 	uint32_t tc_index;
 	enum rte_meter_color color;
 
-	tc_index = (qindex >> 2) & 0x3;
+	tc_index = rte_sched_port_queue_tc(port, qindex, tc_default);
 	color = rte_sched_port_pkt_read_color(pkt);
 	red_cfg = &port->red_config[tc_index][color];
 
@@ -1162,12 +1749,40 @@ rte_sched_port_set_queue_empty_timestamp(struct rte_sched_port *port, uint32_t q
 
 #else
 
-#define rte_sched_port_red_drop(port, pkt, qindex, qlen)             0
+#define rte_sched_port_red_drop(port, pkt, qindex, qlen, tc_default)  0
 
 #define rte_sched_port_set_queue_empty_timestamp(port, qindex)
 
 #endif /* RTE_SCHED_RED */
 
+/*
+ * aqm is a constant of the enqueue path, set when the port has an AQM hook:
+ * the ports without one do not have the indirect call in their enqueue loop.
+ */
+static inline int
+rte_sched_port_aqm_drop(struct rte_sched_port *port, struct rte_mbuf *pkt,
+	uint32_t qindex, uint16_t qlen, uint32_t tc_default, uint32_t aqm)
+{
+	struct rte_sched_queue_extra *qe;
+	uint32_t tc_index;
+
+	RTE_SET_USED(pkt);
+
+	if (!aqm)
+		return rte_sched_port_red_drop(port, pkt, qindex, qlen,
+			tc_default);
+
+	tc_index = rte_sched_port_queue_tc(port, qindex, tc_default);
+	if ((port->aqm_tc_mask & (1u << tc_index)) == 0)
+		return rte_sched_port_red_drop(port, pkt, qindex, qlen,
+			tc_default);
+
+	qe = port->queue_extra + qindex;
+
+	return port->aqm_enqueue[tc_index](port->aqm_cfg[tc_index],
+		qe->aqm_data, qlen, port->queue[qindex].qr, port->time);
+}
+
 #ifdef RTE_SCHED_DEBUG
 
 static inline void
@@ -1199,22 +1814,26 @@ debug_check_queue_slab(struct rte_sched_port *port, uint32_t bmp_pos,
 
 static inline uint32_t
 rte_sched_port_enqueue_qptrs_prefetch0(struct rte_sched_port *port,
-				       struct rte_mbuf *pkt)
+				       struct rte_mbuf *pkt, uint32_t tc_default,
+				       uint32_t aqm)
 {
 	struct rte_sched_queue *q;
-#ifdef RTE_SCHED_COLLECT_STATS
 	struct rte_sched_queue_extra *qe;
-#endif
 	uint32_t subport, pipe, traffic_class, queue, qindex;
 
 	rte_sched_port_pkt_read_tree_path(pkt, &subport, &pipe, &traffic_class, &queue);
 
-	qindex = rte_sched_port_qindex(port, subport, pipe, traffic_class, queue);
+	qindex = rte_sched_port_qindex(port, subport, pipe, traffic_class, queue,
+		tc_default);
 	q = port->queue + qindex;
 	rte_prefetch0(q);
-#ifdef RTE_SCHED_COLLECT_STATS
 	qe = port->queue_extra + qindex;
+#ifdef RTE_SCHED_COLLECT_STATS
+	RTE_SET_USED(aqm);
 	rte_prefetch0(qe);
+#else
+	if (aqm)
+		rte_prefetch0(qe);
 #endif
 
 	return qindex;
@@ -1222,14 +1841,15 @@ rte_sched_port_enqueue_qptrs_prefetch0(struct rte_sched_port *port,
 
 static inline void
 rte_sched_port_enqueue_qwa_prefetch0(struct rte_sched_port *port,
-				     uint32_t qindex, struct rte_mbuf **qbase)
+				     uint32_t qindex, struct rte_mbuf **qbase,
+				     uint32_t tc_default)
 {
 	struct rte_sched_queue *q;
 	struct rte_mbuf **q_qw;
 	uint16_t qsize;
 
 	q = port->queue + qindex;
-	qsize = rte_sched_port_qsize(port, qindex);
+	qsize = rte_sched_port_qsize(port, qindex, tc_default);
 	q_qw = qbase + (q->qw & (qsize - 1));
 
 	rte_prefetch0(q_qw);
@@ -1238,23 +1858,26 @@ rte_sched_port_enqueue_qwa_prefetch0(struct rte_sched_port *port,
 
 static inline int
 rte_sched_port_enqueue_qwa(struct rte_sched_port *port, uint32_t qindex,
-			   struct rte_mbuf **qbase, struct rte_mbuf *pkt)
+			   struct rte_mbuf **qbase, struct rte_mbuf *pkt,
+			   uint32_t tc_default, uint32_t aqm)
 {
 	struct rte_sched_queue *q;
 	uint16_t qsize;
 	uint16_t qlen;
 
 	q = port->queue + qindex;
-	qsize = rte_sched_port_qsize(port, qindex);
+	qsize = rte_sched_port_qsize(port, qindex, tc_default);
 	qlen = q->qw - q->qr;
 
 	/* Drop the packet (and update drop stats) when queue is full */
-	if (unlikely(rte_sched_port_red_drop(port, pkt, qindex, qlen) ||
+	if (unlikely(rte_sched_port_aqm_drop(port, pkt, qindex, qlen,
+					     tc_default, aqm) ||
 		     (qlen >= qsize))) {
 		rte_pktmbuf_free(pkt);
 #ifdef RTE_SCHED_COLLECT_STATS
 		rte_sched_port_update_subport_stats_on_drop(port, qindex, pkt,
-							    qlen < qsize);
+							    qlen < qsize,
+							    tc_default);
 		rte_sched_port_update_queue_stats_on_drop(port, qindex, pkt,
 							  qlen < qsize);
 #endif
@@ -1270,7 +1893,7 @@ rte_sched_port_enqueue_qwa(struct rte_sched_port *port, uint32_t qindex,
 
 	/* Statistics */
 #ifdef RTE_SCHED_COLLECT_STATS
-	rte_sched_port_update_subport_stats(port, qindex, pkt);
+	rte_sched_port_update_subport_stats(port, qindex, pkt, tc_default);
 	rte_sched_port_update_queue_stats(port, qindex, pkt);
 #endif
 
@@ -1291,9 +1914,9 @@ rte_sched_port_enqueue_qwa(struct rte_sched_port *port, uint32_t qindex,
  *   p01            p11            p21            p31
  *
  */
-int
-rte_sched_port_enqueue(struct rte_sched_port *port, struct rte_mbuf **pkts,
-		       uint32_t n_pkts)
+static inline int __attribute__((always_inline))
+__rte_sched_port_enqueue(struct rte_sched_port *port, struct rte_mbuf **pkts,
+			 uint32_t n_pkts, uint32_t tc_default, uint32_t aqm)
 {
 	struct rte_mbuf *pkt00, *pkt01, *pkt10, *pkt11, *pkt20, *pkt21,
 		*pkt30, *pkt31, *pkt_last;
@@ -1320,19 +1943,19 @@ rte_sched_port_enqueue(struct rte_sched_port *port, struct rte_mbuf **pkts,
 		/* Prefetch the queue structure for each queue */
 		for (i = 0; i < n_pkts; i++)
 			q[i] = rte_sched_port_enqueue_qptrs_prefetch0(port,
-								      pkts[i]);
+								      pkts[i], tc_default, aqm);
 
 		/* Prefetch the write pointer location of each queue */
 		for (i = 0; i < n_pkts; i++) {
 			q_base[i] = rte_sched_port_qbase(port, q[i]);
 			rte_sched_port_enqueue_qwa_prefetch0(port, q[i],
-							     q_base[i]);
+							     q_base[i], tc_default);
 		}
 
 		/* Write each packet to its queue */
 		for (i = 0; i < n_pkts; i++)
 			result += rte_sched_port_enqueue_qwa(port, q[i],
-							     q_base[i], pkts[i]);
+							     q_base[i], pkts[i], tc_default, aqm);
 
 		return result;
 	}
@@ -1348,21 +1971,21 @@ rte_sched_port_enqueue(struct rte_sched_port *port, struct rte_mbuf **pkts,
 	rte_prefetch0(pkt10);
 	rte_prefetch0(pkt11);
 
-	q20 = rte_sched_port_enqueue_qptrs_prefetch0(port, pkt20);
-	q21 = rte_sched_port_enqueue_qptrs_prefetch0(port, pkt21);
+	q20 = rte_sched_port_enqueue_qptrs_prefetch0(port, pkt20, tc_default, aqm);
+	q21 = rte_sched_port_enqueue_qptrs_prefetch0(port, pkt21, tc_default, aqm);
 
 	pkt00 = pkts[4];
 	pkt01 = pkts[5];
 	rte_prefetch0(pkt00);
 	rte_prefetch0(pkt01);
 
-	q10 = rte_sched_port_enqueue_qptrs_prefetch0(port, pkt10);
-	q11 = rte_sched_port_enqueue_qptrs_prefetch0(port, pkt11);
+	q10 = rte_sched_port_enqueue_qptrs_prefetch0(port, pkt10, tc_default, aqm);
+	q11 = rte_sched_port_enqueue_qptrs_prefetch0(port, pkt11, tc_default, aqm);
 
 	q20_base = rte_sched_port_qbase(port, q20);
 	q21_base = rte_sched_port_qbase(port, q21);
-	rte_sched_port_enqueue_qwa_prefetch0(port, q20, q20_base);
-	rte_sched_port_enqueue_qwa_prefetch0(port, q21, q21_base);
+	rte_sched_port_enqueue_qwa_prefetch0(port, q20, q20_base, tc_default);
+	rte_sched_port_enqueue_qwa_prefetch0(port, q21, q21_base, tc_default);
 
 	/* Run the pipeline */
 	for (i = 6; i < (n_pkts & (~1)); i += 2) {
@@ -1387,18 +2010,18 @@ rte_sched_port_enqueue(struct rte_sched_port *port, struct rte_mbuf **pkts,
 		rte_prefetch0(pkt01);
 
 		/* Stage 1: Prefetch queue structure storing queue pointers */
-		q10 = rte_sched_port_enqueue_qptrs_prefetch0(port, pkt10);
-		q11 = rte_sched_port_enqueue_qptrs_prefetch0(port, pkt11);
+		q10 = rte_sched_port_enqueue_qptrs_prefetch0(port, pkt10, tc_default, aqm);
+		q11 = rte_sched_port_enqueue_qptrs_prefetch0(port, pkt11, tc_default, aqm);
 
 		/* Stage 2: Prefetch queue write location */
 		q20_base = rte_sched_port_qbase(port, q20);
 		q21_base = rte_sched_port_qbase(port, q21);
-		rte_sched_port_enqueue_qwa_prefetch0(port, q20, q20_base);
-		rte_sched_port_enqueue_qwa_prefetch0(port, q21, q21_base);
+		rte_sched_port_enqueue_qwa_prefetch0(port, q20, q20_base, tc_default);
+		rte_sched_port_enqueue_qwa_prefetch0(port, q21, q21_base, tc_default);
 
 		/* Stage 3: Write packet to queue and activate queue */
-		r30 = rte_sched_port_enqueue_qwa(port, q30, q30_base, pkt30);
-		r31 = rte_sched_port_enqueue_qwa(port, q31, q31_base, pkt31);
+		r30 = rte_sched_port_enqueue_qwa(port, q30, q30_base, pkt30, tc_default, aqm);
+		r31 = rte_sched_port_enqueue_qwa(port, q31, q31_base, pkt31, tc_default, aqm);
 		result += r30 + r31;
 	}
 
@@ -1410,48 +2033,81 @@ rte_sched_port_enqueue(struct rte_sched_port *port, struct rte_mbuf **pkts,
 	pkt_last = pkts[n_pkts - 1];
 	rte_prefetch0(pkt_last);
 
-	q00 = rte_sched_port_enqueue_qptrs_prefetch0(port, pkt00);
-	q01 = rte_sched_port_enqueue_qptrs_prefetch0(port, pkt01);
+	q00 = rte_sched_port_enqueue_qptrs_prefetch0(port, pkt00, tc_default, aqm);
+	q01 = rte_sched_port_enqueue_qptrs_prefetch0(port, pkt01, tc_default, aqm);
 
 	q10_base = rte_sched_port_qbase(port, q10);
 	q11_base = rte_sched_port_qbase(port, q11);
-	rte_sched_port_enqueue_qwa_prefetch0(port, q10, q10_base);
-	rte_sched_port_enqueue_qwa_prefetch0(port, q11, q11_base);
+	rte_sched_port_enqueue_qwa_prefetch0(port, q10, q10_base, tc_default);
+	rte_sched_port_enqueue_qwa_prefetch0(port, q11, q11_base, tc_default);
 
-	r20 = rte_sched_port_enqueue_qwa(port, q20, q20_base, pkt20);
-	r21 = rte_sched_port_enqueue_qwa(port, q21, q21_base, pkt21);
+	r20 = rte_sched_port_enqueue_qwa(port, q20, q20_base, pkt20, tc_default, aqm);
+	r21 = rte_sched_port_enqueue_qwa(port, q21, q21_base, pkt21, tc_default, aqm);
 	result += r20 + r21;
 
-	q_last = rte_sched_port_enqueue_qptrs_prefetch0(port, pkt_last);
+	q_last = rte_sched_port_enqueue_qptrs_prefetch0(port, pkt_last, tc_default, aqm);
 
 	q00_base = rte_sched_port_qbase(port, q00);
 	q01_base = rte_sched_port_qbase(port, q01);
-	rte_sched_port_enqueue_qwa_prefetch0(port, q00, q00_base);
-	rte_sched_port_enqueue_qwa_prefetch0(port, q01, q01_base);
+	rte_sched_port_enqueue_qwa_prefetch0(port, q00, q00_base, tc_default);
+	rte_sched_port_enqueue_qwa_prefetch0(port, q01, q01_base, tc_default);
 
-	r10 = rte_sched_port_enqueue_qwa(port, q10, q10_base, pkt10);
-	r11 = rte_sched_port_enqueue_qwa(port, q11, q11_base, pkt11);
+	r10 = rte_sched_port_enqueue_qwa(port, q10, q10_base, pkt10, tc_default, aqm);
+	r11 = rte_sched_port_enqueue_qwa(port, q11, q11_base, pkt11, tc_default, aqm);
 	result += r10 + r11;
 
 	q_last_base = rte_sched_port_qbase(port, q_last);
-	rte_sched_port_enqueue_qwa_prefetch0(port, q_last, q_last_base);
+	rte_sched_port_enqueue_qwa_prefetch0(port, q_last, q_last_base, tc_default);
 
-	r00 = rte_sched_port_enqueue_qwa(port, q00, q00_base, pkt00);
-	r01 = rte_sched_port_enqueue_qwa(port, q01, q01_base, pkt01);
+	r00 = rte_sched_port_enqueue_qwa(port, q00, q00_base, pkt00, tc_default, aqm);
+	r01 = rte_sched_port_enqueue_qwa(port, q01, q01_base, pkt01, tc_default, aqm);
 	result += r00 + r01;
 
 	if (n_pkts & 1) {
-		r_last = rte_sched_port_enqueue_qwa(port, q_last, q_last_base, pkt_last);
+		r_last = rte_sched_port_enqueue_qwa(port, q_last, q_last_base, pkt_last, tc_default, aqm);
 		result += r_last;
 	}
 
 	return result;
 }
 
+int
+rte_sched_port_enqueue(struct rte_sched_port *port, struct rte_mbuf **pkts,
+		       uint32_t n_pkts)
+{
+	if (unlikely(port->aqm_tc_mask != 0))
+		return __rte_sched_port_enqueue(port, pkts, n_pkts, 0, 1);
+
+	if (port->tc_default)
+		return __rte_sched_port_enqueue(port, pkts, n_pkts, 1, 0);
+
+	return __rte_sched_port_enqueue(port, pkts, n_pkts, 0, 0);
+}
+
+static inline void
+grinder_tc_credits_refill(struct rte_sched_port *port, uint32_t *tc_credits,
+	const uint32_t *tc_credits_per_period, uint32_t tc_default)
+{
+	tc_credits[0] = tc_credits_per_period[0];
+	tc_credits[1] = tc_credits_per_period[1];
+	tc_credits[2] = tc_credits_per_period[2];
+	tc_credits[3] = tc_credits_per_period[3];
+
+	/* Fixed size copy, the pipe context of more than 4 TCs has room for
+	 * all of them */
+	if (!tc_default &&
+	    unlikely(port->n_traffic_classes > RTE_SCHED_TRAFFIC_CLASSES_PER_PIPE))
+		memcpy(&tc_credits[RTE_SCHED_TRAFFIC_CLASSES_PER_PIPE],
+			&tc_credits_per_period[RTE_SCHED_TRAFFIC_CLASSES_PER_PIPE],
+			(RTE_SCHED_TRAFFIC_CLASSES_MAX -
+			RTE_SCHED_TRAFFIC_CLASSES_PER_PIPE) * sizeof(uint32_t));
+}
+
 #ifndef RTE_SCHED_SUBPORT_TC_OV
 
 static inline void
-grinder_credits_update(struct rte_sched_port *port, uint32_t pos)
+grinder_credits_update(struct rte_sched_port *port, uint32_t pos,
+	uint32_t tc_default)
 {
 	struct rte_sched_grinder *grinder = port->grinder + pos;
 	struct rte_sched_subport *subport = grinder->subport;
@@ -1473,19 +2129,15 @@ grinder_credits_update(struct rte_sched_port *port, uint32_t pos)
 
 	/* Subport TCs */
 	if (unlikely(port->time >= subport->tc_time)) {
-		subport->tc_credits[0] = subport->tc_credits_per_period[0];
-		subport->tc_credits[1] = subport->tc_credits_per_period[1];
-		subport->tc_credits[2] = subport->tc_credits_per_period[2];
-		subport->tc_credits[3] = subport->tc_credits_per_period[3];
+		grinder_tc_credits_refill(port, subport->tc_credits,
+			subport->tc_credits_per_period, tc_default);
 		subport->tc_time = port->time + subport->tc_period;
 	}
 
 	/* Pipe TCs */
 	if (unlikely(port->time >= pipe->tc_time)) {
-		pipe->tc_credits[0] = params->tc_credits_per_period[0];
-		pipe->tc_credits[1] = params->tc_credits_per_period[1];
-		pipe->tc_credits[2] = params->tc_credits_per_period[2];
-		pipe->tc_credits[3] = params->tc_credits_per_period[3];
+		grinder_tc_credits_refill(port, pipe->tc_credits,
+			params->tc_credits_per_period, tc_default);
 		pipe->tc_time = port->time + params->tc_period;
 	}
 }
@@ -1493,26 +2145,32 @@ grinder_credits_update(struct rte_sched_port *port, uint32_t pos)
 #else
 
 static inline uint32_t
-grinder_tc_ov_credits_update(struct rte_sched_port *port, uint32_t pos)
+grinder_tc_ov_credits_update(struct rte_sched_port *port, uint32_t pos,
+	uint32_t tc_default)
 {
 	struct rte_sched_grinder *grinder = port->grinder + pos;
 	struct rte_sched_subport *subport = grinder->subport;
-	uint32_t tc_ov_consumption[RTE_SCHED_TRAFFIC_CLASSES_PER_PIPE];
-	uint32_t tc_ov_consumption_max;
+	uint32_t tc_ov_index = tc_default ?
+		RTE_SCHED_TRAFFIC_CLASSES_PER_PIPE - 1 : port->tc_ov_index;
+	uint32_t tc_consumption, tc_ov_consumption, tc_ov_consumption_max;
 	uint32_t tc_ov_wm = subport->tc_ov_wm;
+	uint32_t i;
 
 	if (subport->tc_ov == 0)
 		return subport->tc_ov_wm_max;
 
-	tc_ov_consumption[0] = subport->tc_credits_per_period[0] - subport->tc_credits[0];
-	tc_ov_consumption[1] = subport->tc_credits_per_period[1] - subport->tc_credits[1];
-	tc_ov_consumption[2] = subport->tc_credits_per_period[2] - subport->tc_credits[2];
-	tc_ov_consumption[3] = subport->tc_credits_per_period[3] - subport->tc_credits[3];
+	tc_consumption = 0;
+	for (i = 0; i < tc_ov_index; i++)
+		tc_consumption += subport->tc_credits_per_period[i] -
+			subport->tc_credits[i];
+
+	tc_ov_consumption = subport->tc_credits_per_period[tc_ov_index] -
+		subport->tc_credits[tc_ov_index];
 
-	tc_ov_consumption_max = subport->tc_credits_per_period[3] -
-		(tc_ov_consumption[0] + tc_ov_consumption[1] + tc_ov_consumption[2]);
+	tc_ov_consumption_max = subport->tc_credits_per_period[tc_ov_index] -
+		tc_consumption;
 
-	if (tc_ov_consumption[3] > (tc_ov_consumption_max - port->mtu)) {
+	if (tc_ov_consumption > (tc_ov_consumption_max - port->mtu)) {
 		tc_ov_wm  -= tc_ov_wm >> 7;
 		if (tc_ov_wm < subport->tc_ov_wm_min)
 			tc_ov_wm = subport->tc_ov_wm_min;
@@ -1528,7 +2186,8 @@ grinder_tc_ov_credits_update(struct rte_sched_port *port, uint32_t pos)
 }
 
 static inline void
-grinder_credits_update(struct rte_sched_port *port, uint32_t pos)
+grinder_credits_update(struct rte_sched_port *port, uint32_t pos,
+	uint32_t tc_default)
 {
 	struct rte_sched_grinder *grinder = port->grinder + pos;
 	struct rte_sched_subport *subport = grinder->subport;
@@ -1550,12 +2209,11 @@ grinder_credits_update(struct rte_sched_port *port, uint32_t pos)
 
 	/* Subport TCs */
 	if (unlikely(port->time >= subport->tc_time)) {
-		subport->tc_ov_wm = grinder_tc_ov_credits_update(port, pos);
+		subport->tc_ov_wm = grinder_tc_ov_credits_update(port, pos,
+			tc_default);
 
-		subport->tc_credits[0] = subport->tc_credits_per_period[0];
-		subport->tc_credits[1] = subport->tc_credits_per_period[1];
-		subport->tc_credits[2] = subport->tc_credits_per_period[2];
-		subport->tc_credits[3] = subport->tc_credits_per_period[3];
+		grinder_tc_credits_refill(port, subport->tc_credits,
+			subport->tc_credits_per_period, tc_default);
 
 		subport->tc_time = port->time + subport->tc_period;
 		subport->tc_ov_period_id++;
@@ -1563,10 +2221,8 @@ grinder_credits_update(struct rte_sched_port *port, uint32_t pos)
 
 	/* Pipe TCs */
 	if (unlikely(port->time >= pipe->tc_time)) {
-		pipe->tc_credits[0] = params->tc_credits_per_period[0];
-		pipe->tc_credits[1] = params->tc_credits_per_period[1];
-		pipe->tc_credits[2] = params->tc_credits_per_period[2];
-		pipe->tc_credits[3] = params->tc_credits_per_period[3];
+		grinder_tc_credits_refill(port, pipe->tc_credits,
+			params->tc_credits_per_period, tc_default);
 		pipe->tc_time = port->time + params->tc_period;
 	}
 
@@ -1584,7 +2240,8 @@ grinder_credits_update(struct rte_sched_port *port, uint32_t pos)
 #ifndef RTE_SCHED_SUBPORT_TC_OV
 
 static inline int
-grinder_credits_check(struct rte_sched_port *port, uint32_t pos)
+grinder_credits_check(struct rte_sched_port *port, uint32_t pos,
+	uint32_t tc_default)
 {
 	struct rte_sched_grinder *grinder = port->grinder + pos;
 	struct rte_sched_subport *subport = grinder->subport;
@@ -1598,6 +2255,8 @@ grinder_credits_check(struct rte_sched_port *port, uint32_t pos)
 	uint32_t pipe_tc_credits = pipe->tc_credits[tc_index];
 	int enough_credits;
 
+	RTE_SET_USED(tc_default);
+
 	/* Check queue credits */
 	enough_credits = (pkt_len <= subport_tb_credits) &&
 		(pkt_len <= subport_tc_credits) &&
@@ -1619,7 +2278,8 @@ grinder_credits_check(struct rte_sched_port *port, uint32_t pos)
 #else
 
 static inline int
-grinder_credits_check(struct rte_sched_port *port, uint32_t pos)
+grinder_credits_check(struct rte_sched_port *port, uint32_t pos,
+	uint32_t tc_default)
 {
 	struct rte_sched_grinder *grinder = port->grinder + pos;
 	struct rte_sched_subport *subport = grinder->subport;
@@ -1631,9 +2291,10 @@ grinder_credits_check(struct rte_sched_port *port, uint32_t pos)
 	uint32_t subport_tc_credits = subport->tc_credits[tc_index];
 	uint32_t pipe_tb_credits = pipe->tb_credits;
 	uint32_t pipe_tc_credits = pipe->tc_credits[tc_index];
-	uint32_t pipe_tc_ov_mask1[] = {UINT32_MAX, UINT32_MAX, UINT32_MAX, pipe->tc_ov_credits};
-	uint32_t pipe_tc_ov_mask2[] = {0, 0, 0, UINT32_MAX};
-	uint32_t pipe_tc_ov_credits = pipe_tc_ov_mask1[tc_index];
+	uint32_t tc_ov_index = tc_default ?
+		RTE_SCHED_TRAFFIC_CLASSES_PER_PIPE - 1 : port->tc_ov_index;
+	uint32_t pipe_tc_ov_mask = -(uint32_t) (tc_index == tc_ov_index);
+	uint32_t pipe_tc_ov_credits = pipe->tc_ov_credits | ~pipe_tc_ov_mask;
 	int enough_credits;
 
 	/* Check pipe and subport credits */
@@ -1651,7 +2312,7 @@ grinder_credits_check(struct rte_sched_port *port, uint32_t pos)
 	subport->tc_credits[tc_index] -= pkt_len;
 	pipe->tb_credits -= pkt_len;
 	pipe->tc_credits[tc_index] -= pkt_len;
-	pipe->tc_ov_credits -= pipe_tc_ov_mask2[tc_index] & pkt_len;
+	pipe->tc_ov_credits -= pipe_tc_ov_mask & pkt_len;
 
 	return 1;
 }
@@ -1660,14 +2321,14 @@ grinder_credits_check(struct rte_sched_port *port, uint32_t pos)
 
 
 static inline int
-grinder_schedule(struct rte_sched_port *port, uint32_t pos)
+grinder_schedule(struct rte_sched_port *port, uint32_t pos, uint32_t tc_default)
 {
 	struct rte_sched_grinder *grinder = port->grinder + pos;
 	struct rte_sched_queue *queue = grinder->queue[grinder->qpos];
 	struct rte_mbuf *pkt = grinder->pkt;
 	uint32_t pkt_len = pkt->pkt_len + port->frame_overhead;
 
-	if (!grinder_credits_check(port, pos))
+	if (!grinder_credits_check(port, pos, tc_default))
 		return 0;
 
 	/* Advance port time */
@@ -1761,42 +2422,60 @@ grinder_pcache_populate(struct rte_sched_port *port, uint32_t pos, uint32_t bmp_
 }
 
 static inline void
-grinder_tccache_populate(struct rte_sched_port *port, uint32_t pos, uint32_t qindex, uint16_t qmask)
+grinder_tccache_populate(struct rte_sched_port *port, uint32_t pos, uint32_t qindex, uint16_t qmask,
+	uint32_t tc_default)
 {
 	struct rte_sched_grinder *grinder = port->grinder + pos;
-	uint8_t b[4];
+	uint32_t i;
 
 	grinder->tccache_w = 0;
 	grinder->tccache_r = 0;
 
-	b[0] = (uint8_t) (qmask & 0xF);
-	b[1] = (uint8_t) ((qmask >> 4) & 0xF);
-	b[2] = (uint8_t) ((qmask >> 8) & 0xF);
-	b[3] = (uint8_t) ((qmask >> 12) & 0xF);
+	/* One TC per 4 queue positions, as in the default layout */
+	if (tc_default || port->tc_4_queues) {
+		uint8_t b[4];
+
+		b[0] = (uint8_t) (qmask & 0xF);
+		b[1] = (uint8_t) ((qmask >> 4) & 0xF);
+		b[2] = (uint8_t) ((qmask >> 8) & 0xF);
+		b[3] = (uint8_t) ((qmask >> 12) & 0xF);
+
+		grinder->tccache_qmask[grinder->tccache_w] = b[0];
+		grinder->tccache_qindex[grinder->tccache_w] = qindex;
+		grinder->tccache_w += (b[0] != 0);
 
-	grinder->tccache_qmask[grinder->tccache_w] = b[0];
-	grinder->tccache_qindex[grinder->tccache_w] = qindex;
-	grinder->tccache_w += (b[0] != 0);
+		grinder->tccache_qmask[grinder->tccache_w] = b[1];
+		grinder->tccache_qindex[grinder->tccache_w] = qindex + 4;
+		grinder->tccache_w += (b[1] != 0);
 
-	grinder->tccache_qmask[grinder->tccache_w] = b[1];
-	grinder->tccache_qindex[grinder->tccache_w] = qindex + 4;
-	grinder->tccache_w += (b[1] != 0);
+		grinder->tccache_qmask[grinder->tccache_w] = b[2];
+		grinder->tccache_qindex[grinder->tccache_w] = qindex + 8;
+		grinder->tccache_w += (b[2] != 0);
 
-	grinder->tccache_qmask[grinder->tccache_w] = b[2];
-	grinder->tccache_qindex[grinder->tccache_w] = qindex + 8;
-	grinder->tccache_w += (b[2] != 0);
+		grinder->tccache_qmask[grinder->tccache_w] = b[3];
+		grinder->tccache_qindex[grinder->tccache_w] = qindex + 12;
+		grinder->tccache_w += (b[3] != 0);
 
-	grinder->tccache_qmask[grinder->tccache_w] = b[3];
-	grinder->tccache_qindex[grinder->tccache_w] = qindex + 12;
-	grinder->tccache_w += (b[3] != 0);
+		return;
+	}
+
+	for (i = 0; i < port->n_traffic_classes; i++) {
+		uint32_t qpos = port->tc_qpos[i];
+		uint8_t b = (uint8_t) ((qmask >> qpos) &
+			((1 << port->tc_n_queues[i]) - 1));
+
+		grinder->tccache_qmask[grinder->tccache_w] = b;
+		grinder->tccache_qindex[grinder->tccache_w] = qindex + qpos;
+		grinder->tccache_w += (b != 0);
+	}
 }
 
 static inline int
-grinder_next_tc(struct rte_sched_port *port, uint32_t pos)
+grinder_next_tc(struct rte_sched_port *port, uint32_t pos, uint32_t tc_default)
 {
 	struct rte_sched_grinder *grinder = port->grinder + pos;
 	struct rte_mbuf **qbase;
-	uint32_t qindex;
+	uint32_t qindex, tc_index, m;
 	uint16_t qsize;
 
 	if (grinder->tccache_r == grinder->tccache_w)
@@ -1804,33 +2483,38 @@ grinder_next_tc(struct rte_sched_port *port, uint32_t pos)
 
 	qindex = grinder->tccache_qindex[grinder->tccache_r];
 	qbase = rte_sched_port_qbase(port, qindex);
-	qsize = rte_sched_port_qsize(port, qindex);
-
-	grinder->tc_index = (qindex >> 2) & 0x3;
+	qsize = rte_sched_port_qsize(port, qindex, tc_default);
+	tc_index = rte_sched_port_queue_tc(port, qindex, tc_default);
+	m = tc_default ? RTE_SCHED_QUEUES_PER_TRAFFIC_CLASS - 1 :
+		port->tc_qmask[tc_index];
+
+	grinder->tc_index = tc_index;
+	if (!tc_default)
+		grinder->tc_qpos_mask = m;
 	grinder->qmask = grinder->tccache_qmask[grinder->tccache_r];
 	grinder->qsize = qsize;
 
 	grinder->qindex[0] = qindex;
-	grinder->qindex[1] = qindex + 1;
-	grinder->qindex[2] = qindex + 2;
-	grinder->qindex[3] = qindex + 3;
+	grinder->qindex[1] = qindex + (1 & m);
+	grinder->qindex[2] = qindex + (2 & m);
+	grinder->qindex[3] = qindex + (3 & m);
 
 	grinder->queue[0] = port->queue + qindex;
-	grinder->queue[1] = port->queue + qindex + 1;
-	grinder->queue[2] = port->queue + qindex + 2;
-	grinder->queue[3] = port->queue + qindex + 3;
+	grinder->queue[1] = port->queue + qindex + (1 & m);
+	grinder->queue[2] = port->queue + qindex + (2 & m);
+	grinder->queue[3] = port->queue + qindex + (3 & m);
 
 	grinder->qbase[0] = qbase;
-	grinder->qbase[1] = qbase + qsize;
-	grinder->qbase[2] = qbase + 2 * qsize;
-	grinder->qbase[3] = qbase + 3 * qsize;
+	grinder->qbase[1] = qbase + (1 & m) * qsize;
+	grinder->qbase[2] = qbase + (2 & m) * qsize;
+	grinder->qbase[3] = qbase + (3 & m) * qsize;
 
 	grinder->tccache_r++;
 	return 1;
 }
 
 static inline int
-grinder_next_pipe(struct rte_sched_port *port, uint32_t pos)
+grinder_next_pipe(struct rte_sched_port *port, uint32_t pos, uint32_t tc_default)
 {
 	struct rte_sched_grinder *grinder = port->grinder + pos;
 	uint32_t pipe_qindex;
@@ -1870,12 +2554,12 @@ grinder_next_pipe(struct rte_sched_port *port, uint32_t pos)
 	/* Install new pipe in the grinder */
 	grinder->pindex = pipe_qindex >> 4;
 	grinder->subport = port->subport + (grinder->pindex / port->n_pipes_per_subport);
-	grinder->pipe = port->pipe + grinder->pindex;
+	grinder->pipe = rte_sched_port_pipe(port, grinder->pindex, tc_default);
 	grinder->pipe_params = NULL; /* to be set after the pipe structure is prefetched */
 	grinder->productive = 0;
 
-	grinder_tccache_populate(port, pos, pipe_qindex, pipe_qmask);
-	grinder_next_tc(port, pos);
+	grinder_tccache_populate(port, pos, pipe_qindex, pipe_qmask, tc_default);
+	grinder_next_tc(port, pos, tc_default);
 
 	/* Check for pipe exhaustion */
 	if (grinder->pindex == port->pipe_loop) {
@@ -1888,21 +2572,27 @@ grinder_next_pipe(struct rte_sched_port *port, uint32_t pos)
 
 
 static inline void
-grinder_wrr_load(struct rte_sched_port *port, uint32_t pos)
+grinder_wrr_load(struct rte_sched_port *port, uint32_t pos, uint32_t tc_default)
 {
 	struct rte_sched_grinder *grinder = port->grinder + pos;
 	struct rte_sched_pipe *pipe = grinder->pipe;
 	struct rte_sched_pipe_profile *pipe_params = grinder->pipe_params;
-	uint32_t tc_index = grinder->tc_index;
 	uint32_t qmask = grinder->qmask;
+	uint32_t m = tc_default ? RTE_SCHED_QUEUES_PER_TRAFFIC_CLASS - 1 :
+		grinder->tc_qpos_mask;
 	uint32_t qindex;
 
-	qindex = tc_index * 4;
+	if (tc_default)
+		qindex = grinder->tc_index * RTE_SCHED_QUEUES_PER_TRAFFIC_CLASS;
+	else
+		qindex = grinder->qindex[0] & (RTE_SCHED_QUEUES_PER_PIPE - 1);
 
+	/* Aliased positions beyond the last queue of the TC have their mask
+	 * bit clear, so they are never selected */
 	grinder->wrr_tokens[0] = ((uint16_t) pipe->wrr_tokens[qindex]) << RTE_SCHED_WRR_SHIFT;
-	grinder->wrr_tokens[1] = ((uint16_t) pipe->wrr_tokens[qindex + 1]) << RTE_SCHED_WRR_SHIFT;
-	grinder->wrr_tokens[2] = ((uint16_t) pipe->wrr_tokens[qindex + 2]) << RTE_SCHED_WRR_SHIFT;
-	grinder->wrr_tokens[3] = ((uint16_t) pipe->wrr_tokens[qindex + 3]) << RTE_SCHED_WRR_SHIFT;
+	grinder->wrr_tokens[1] = ((uint16_t) pipe->wrr_tokens[qindex + (1 & m)]) << RTE_SCHED_WRR_SHIFT;
+	grinder->wrr_tokens[2] = ((uint16_t) pipe->wrr_tokens[qindex + (2 & m)]) << RTE_SCHED_WRR_SHIFT;
+	grinder->wrr_tokens[3] = ((uint16_t) pipe->wrr_tokens[qindex + (3 & m)]) << RTE_SCHED_WRR_SHIFT;
 
 	grinder->wrr_mask[0] = (qmask & 0x1) * 0xFFFF;
 	grinder->wrr_mask[1] = ((qmask >> 1) & 0x1) * 0xFFFF;
@@ -1910,28 +2600,34 @@ grinder_wrr_load(struct rte_sched_port *port, uint32_t pos)
 	grinder->wrr_mask[3] = ((qmask >> 3) & 0x1) * 0xFFFF;
 
 	grinder->wrr_cost[0] = pipe_params->wrr_cost[qindex];
-	grinder->wrr_cost[1] = pipe_params->wrr_cost[qindex + 1];
-	grinder->wrr_cost[2] = pipe_params->wrr_cost[qindex + 2];
-	grinder->wrr_cost[3] = pipe_params->wrr_cost[qindex + 3];
+	grinder->wrr_cost[1] = pipe_params->wrr_cost[qindex + (1 & m)];
+	grinder->wrr_cost[2] = pipe_params->wrr_cost[qindex + (2 & m)];
+	grinder->wrr_cost[3] = pipe_params->wrr_cost[qindex + (3 & m)];
 }
 
 static inline void
-grinder_wrr_store(struct rte_sched_port *port, uint32_t pos)
+grinder_wrr_store(struct rte_sched_port *port, uint32_t pos, uint32_t tc_default)
 {
 	struct rte_sched_grinder *grinder = port->grinder + pos;
 	struct rte_sched_pipe *pipe = grinder->pipe;
-	uint32_t tc_index = grinder->tc_index;
+	uint32_t m = tc_default ? RTE_SCHED_QUEUES_PER_TRAFFIC_CLASS - 1 :
+		grinder->tc_qpos_mask;
 	uint32_t qindex;
 
-	qindex = tc_index * 4;
+	if (tc_default)
+		qindex = grinder->tc_index * RTE_SCHED_QUEUES_PER_TRAFFIC_CLASS;
+	else
+		qindex = grinder->qindex[0] & (RTE_SCHED_QUEUES_PER_PIPE - 1);
 
-	pipe->wrr_tokens[qindex] = (grinder->wrr_tokens[0] & grinder->wrr_mask[0])
+	/* Reverse order, so that the real queue positions are written last
+	 * when the TC has less than 4 queues */
+	pipe->wrr_tokens[qindex + (3 & m)] = (grinder->wrr_tokens[3] & grinder->wrr_mask[3])
 		>> RTE_SCHED_WRR_SHIFT;
-	pipe->wrr_tokens[qindex + 1] = (grinder->wrr_tokens[1] & grinder->wrr_mask[1])
+	pipe->wrr_tokens[qindex + (2 & m)] = (grinder->wrr_tokens[2] & grinder->wrr_mask[2])
 		>> RTE_SCHED_WRR_SHIFT;
-	pipe->wrr_tokens[qindex + 2] = (grinder->wrr_tokens[2] & grinder->wrr_mask[2])
+	pipe->wrr_tokens[qindex + (1 & m)] = (grinder->wrr_tokens[1] & grinder->wrr_mask[1])
 		>> RTE_SCHED_WRR_SHIFT;
-	pipe->wrr_tokens[qindex + 3] = (grinder->wrr_tokens[3] & grinder->wrr_mask[3])
+	pipe->wrr_tokens[qindex] = (grinder->wrr_tokens[0] & grinder->wrr_mask[0])
 		>> RTE_SCHED_WRR_SHIFT;
 }
 
@@ -1959,16 +2655,21 @@ grinder_wrr(struct rte_sched_port *port, uint32_t pos)
 #define grinder_evict(port, pos)
 
 static inline void
-grinder_prefetch_pipe(struct rte_sched_port *port, uint32_t pos)
+grinder_prefetch_pipe(struct rte_sched_port *port, uint32_t pos,
+	uint32_t tc_default)
 {
 	struct rte_sched_grinder *grinder = port->grinder + pos;
 
 	rte_prefetch0(grinder->pipe);
+	if (!tc_default &&
+	    unlikely(port->pipe_size_log2 > RTE_CACHE_LINE_SIZE_LOG2))
+		rte_prefetch0((uint8_t *) grinder->pipe + RTE_CACHE_LINE_SIZE);
 	rte_prefetch0(grinder->queue[0]);
 }
 
 static inline void
-grinder_prefetch_tc_queue_arrays(struct rte_sched_port *port, uint32_t pos)
+grinder_prefetch_tc_queue_arrays(struct rte_sched_port *port, uint32_t pos,
+	uint32_t tc_default)
 {
 	struct rte_sched_grinder *grinder = port->grinder + pos;
 	uint16_t qsize, qr[4];
@@ -1982,7 +2683,7 @@ grinder_prefetch_tc_queue_arrays(struct rte_sched_port *port, uint32_t pos)
 	rte_prefetch0(grinder->qbase[0] + qr[0]);
 	rte_prefetch0(grinder->qbase[1] + qr[1]);
 
-	grinder_wrr_load(port, pos);
+	grinder_wrr_load(port, pos, tc_default);
 	grinder_wrr(port, pos);
 
 	rte_prefetch0(grinder->qbase[2] + qr[2]);
@@ -2008,16 +2709,16 @@ grinder_prefetch_mbuf(struct rte_sched_port *port, uint32_t pos)
 	}
 }
 
-static inline uint32_t
-grinder_handle(struct rte_sched_port *port, uint32_t pos)
+static inline uint32_t __attribute__((always_inline))
+grinder_handle(struct rte_sched_port *port, uint32_t pos, uint32_t tc_default)
 {
 	struct rte_sched_grinder *grinder = port->grinder + pos;
 
 	switch (grinder->state) {
 	case e_GRINDER_PREFETCH_PIPE:
 	{
-		if (grinder_next_pipe(port, pos)) {
-			grinder_prefetch_pipe(port, pos);
+		if (grinder_next_pipe(port, pos, tc_default)) {
+			grinder_prefetch_pipe(port, pos, tc_default);
 			port->busy_grinders++;
 
 			grinder->state = e_GRINDER_PREFETCH_TC_QUEUE_ARRAYS;
@@ -2032,8 +2733,8 @@ grinder_handle(struct rte_sched_port *port, uint32_t pos)
 		struct rte_sched_pipe *pipe = grinder->pipe;
 
 		grinder->pipe_params = port->pipe_profiles + pipe->profile;
-		grinder_prefetch_tc_queue_arrays(port, pos);
-		grinder_credits_update(port, pos);
+		grinder_prefetch_tc_queue_arrays(port, pos, tc_default);
+		grinder_credits_update(port, pos, tc_default);
 
 		grinder->state = e_GRINDER_PREFETCH_MBUF;
 		return 0;
@@ -2051,7 +2752,7 @@ grinder_handle(struct rte_sched_port *port, uint32_t pos)
 	{
 		uint32_t result = 0;
 
-		result = grinder_schedule(port, pos);
+		result = grinder_schedule(port, pos, tc_default);
 
 		/* Look for next packet within the same TC */
 		if (result && grinder->qmask) {
@@ -2060,11 +2761,11 @@ grinder_handle(struct rte_sched_port *port, uint32_t pos)
 
 			return 1;
 		}
-		grinder_wrr_store(port, pos);
+		grinder_wrr_store(port, pos, tc_default);
 
 		/* Look for another active TC within same pipe */
-		if (grinder_next_tc(port, pos)) {
-			grinder_prefetch_tc_queue_arrays(port, pos);
+		if (grinder_next_tc(port, pos, tc_default)) {
+			grinder_prefetch_tc_queue_arrays(port, pos, tc_default);
 
 			grinder->state = e_GRINDER_PREFETCH_MBUF;
 			return result;
@@ -2077,8 +2778,8 @@ grinder_handle(struct rte_sched_port *port, uint32_t pos)
 		grinder_evict(port, pos);
 
 		/* Look for another active pipe */
-		if (grinder_next_pipe(port, pos)) {
-			grinder_prefetch_pipe(port, pos);
+		if (grinder_next_pipe(port, pos, tc_default)) {
+			grinder_prefetch_pipe(port, pos, tc_default);
 
 			grinder->state = e_GRINDER_PREFETCH_TC_QUEUE_ARRAYS;
 			return result;
@@ -2133,19 +2834,87 @@ rte_sched_port_exceptions(struct rte_sched_port *port, int second_pass)
 	return exceptions;
 }
 
-int
-rte_sched_port_dequeue(struct rte_sched_port *port, struct rte_mbuf **pkts, uint32_t n_pkts)
+/*
+ * Top up the port credits from the group bucket. The bucket is a virtual
+ * time (GCRA): granting credits moves it forward, the passing of time
+ * refills it, so a single compare-and-set is enough to take credits.
+ */
+static inline void
+rte_sched_port_group_credits_get(struct rte_sched_port *port)
+{
+	struct rte_sched_port_group *group = port->group;
+	uint64_t now, tat, base, credits, cycles;
+	int64_t n_credits;
+
+	n_credits = (int64_t) group->credits_grant - port->group_credits;
+	if (n_credits <= 0)
+		return;
+
+	now = rte_get_tsc_cycles();
+
+	do {
+		tat = group->tat;
+		base = tat;
+		if (base + group->tb_cycles < now)
+			base = now - group->tb_cycles;
+		if (base >= now)
+			return;
+
+		credits = ((now - base) << RTE_SCHED_TIME_SHIFT) /
+			group->cycles_per_byte;
+		if (credits == 0)
+			return;
+		if (credits > (uint64_t) n_credits)
+			credits = n_credits;
+
+		cycles = (credits * group->cycles_per_byte +
+			(1 << RTE_SCHED_TIME_SHIFT) - 1) >> RTE_SCHED_TIME_SHIFT;
+	} while (rte_atomic64_cmpset(&group->tat, tat, base + cycles) == 0);
+
+	port->group_credits += credits;
+}
+
+static inline int __attribute__((always_inline))
+rte_sched_port_group_dequeue(struct rte_sched_port *port, uint32_t n_pkts,
+	uint32_t tc_default)
 {
+	uint64_t time_start;
 	uint32_t i, count;
 
-	port->pkts_out = pkts;
-	port->n_pkts_out = 0;
+	rte_sched_port_group_credits_get(port);
+	if (port->group_credits <= 0)
+		return 0;
 
-	rte_sched_port_time_resync(port);
+	/* Port time only advances by the length of the packets sent */
+	time_start = port->time;
+
+	for (i = 0, count = 0; ; i++)  {
+		count += grinder_handle(port, i & (RTE_SCHED_PORT_N_GRINDERS - 1),
+			tc_default);
+		if ((count == n_pkts) ||
+		    ((int64_t) (port->time - time_start) >= port->group_credits) ||
+		    rte_sched_port_exceptions(port, i >= RTE_SCHED_PORT_N_GRINDERS)) {
+			break;
+		}
+	}
+
+	/* The last packet may overdraw the credits, the debt is paid on the
+	 * next dequeue */
+	port->group_credits -= port->time - time_start;
+
+	return count;
+}
+
+static inline int __attribute__((always_inline))
+__rte_sched_port_dequeue(struct rte_sched_port *port, uint32_t n_pkts,
+	uint32_t tc_default)
+{
+	uint32_t i, count;
 
 	/* Take each queue in the grinder one step further */
 	for (i = 0, count = 0; ; i++)  {
-		count += grinder_handle(port, i & (RTE_SCHED_PORT_N_GRINDERS - 1));
+		count += grinder_handle(port, i & (RTE_SCHED_PORT_N_GRINDERS - 1),
+			tc_default);
 		if ((count == n_pkts) ||
 		    rte_sched_port_exceptions(port, i >= RTE_SCHED_PORT_N_GRINDERS)) {
 			break;
@@ -2154,3 +2923,42 @@ rte_sched_port_dequeue(struct rte_sched_port *port, struct rte_mbuf **pkts, uint
 
 	return count;
 }
+
+/*
+ * The grinders of the default TC layout and of the other layouts are built
+ * as separate functions, so that the inlining of each one is not limited by
+ * the size of the other.
+ */
+static int __attribute__((noinline))
+rte_sched_port_dequeue_tc_default(struct rte_sched_port *port,
+	uint32_t n_pkts)
+{
+	if (port->group != NULL)
+		return rte_sched_port_group_dequeue(port, n_pkts, 1);
+
+	return __rte_sched_port_dequeue(port, n_pkts, 1);
+}
+
+static int __attribute__((noinline))
+rte_sched_port_dequeue_tc_layout(struct rte_sched_port *port,
+	uint32_t n_pkts)
+{
+	if (port->group != NULL)
+		return rte_sched_port_group_dequeue(port, n_pkts, 0);
+
+	return __rte_sched_port_dequeue(port, n_pkts, 0);
+}
+
+int
+rte_sched_port_dequeue(struct rte_sched_port *port, struct rte_mbuf **pkts, uint32_t n_pkts)
+{
+	port->pkts_out = pkts;
+	port->n_pkts_out = 0;
+
+	rte_sched_port_time_resync(port);
+
+	if (port->tc_default)
+		return rte_sched_port_dequeue_tc_default(port, n_pkts);
+
+	return rte_sched_port_dequeue_tc_layout(port, n_pkts);
+}
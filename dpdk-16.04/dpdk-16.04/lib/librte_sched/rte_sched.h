@@ -72,6 +72,9 @@ extern "C" {
  *     4. Traffic class:
  *           - Traffic classes of the same pipe handled in strict
  *	    priority order;
+ *           - Number of traffic classes per pipe and number of queues
+ *	    per traffic class configurable per port, by default 4
+ *	    traffic classes with 4 queues each;
  *           - Upper limit enforced per traffic class at the pipe level;
  *           - Lower priority traffic classes able to reuse pipe
  *	    bandwidth currently unused by higher priority traffic
@@ -94,18 +97,23 @@ extern "C" {
 #include "rte_red.h"
 #endif
 
-/** Number of traffic classes per pipe (as well as subport).
- * Cannot be changed.
+/** Default number of traffic classes per pipe (as well as subport), used
+ * when the port does not configure its own traffic class layout.
  */
 #define RTE_SCHED_TRAFFIC_CLASSES_PER_PIPE    4
 
-/** Number of queues per pipe traffic class. Cannot be changed. */
+/** Maximum number of queues per pipe traffic class. This is also the
+ * number of queues of each traffic class in the default layout.
+ */
 #define RTE_SCHED_QUEUES_PER_TRAFFIC_CLASS    4
 
-/** Number of queues per pipe. */
-#define RTE_SCHED_QUEUES_PER_PIPE             \
-	(RTE_SCHED_TRAFFIC_CLASSES_PER_PIPE *     \
-	RTE_SCHED_QUEUES_PER_TRAFFIC_CLASS)
+/** Number of queues per pipe. Cannot be changed. */
+#define RTE_SCHED_QUEUES_PER_PIPE             16
+
+/** Maximum number of traffic classes per pipe (as well as subport). All
+ * per traffic class parameter and statistics arrays have this size.
+ */
+#define RTE_SCHED_TRAFFIC_CLASSES_MAX         RTE_SCHED_QUEUES_PER_PIPE
 
 /** Maximum number of pipe profiles that can be defined per port.
  * Compile-time configurable.
@@ -128,6 +136,11 @@ extern "C" {
 #define RTE_SCHED_FRAME_OVERHEAD_DEFAULT      24
 #endif
 
+/** Size (in bytes) of the run-time data each queue keeps for the Active
+ * Queue Management (AQM) hook of its traffic class.
+ */
+#define RTE_SCHED_AQM_DATA_SIZE               48
+
 /*
  * Subport configuration parameters. The period and credits_per_period
  * parameters are measured in bytes, with one byte meaning the time
@@ -143,7 +156,7 @@ struct rte_sched_subport_params {
 	uint32_t tb_size;                /**< Size (measured in credits) */
 
 	/* Subport traffic classes */
-	uint32_t tc_rate[RTE_SCHED_TRAFFIC_CLASSES_PER_PIPE];
+	uint32_t tc_rate[RTE_SCHED_TRAFFIC_CLASSES_MAX];
 	/**< Traffic class rates (measured in bytes per second) */
 	uint32_t tc_period;
 	/**< Enforcement period for rates (measured in milliseconds) */
@@ -152,19 +165,19 @@ struct rte_sched_subport_params {
 /** Subport statistics */
 struct rte_sched_subport_stats {
 	/* Packets */
-	uint32_t n_pkts_tc[RTE_SCHED_TRAFFIC_CLASSES_PER_PIPE];
+	uint32_t n_pkts_tc[RTE_SCHED_TRAFFIC_CLASSES_MAX];
 	/**< Number of packets successfully written */
-	uint32_t n_pkts_tc_dropped[RTE_SCHED_TRAFFIC_CLASSES_PER_PIPE];
+	uint32_t n_pkts_tc_dropped[RTE_SCHED_TRAFFIC_CLASSES_MAX];
 	/**< Number of packets dropped */
 
 	/* Bytes */
-	uint32_t n_bytes_tc[RTE_SCHED_TRAFFIC_CLASSES_PER_PIPE];
+	uint32_t n_bytes_tc[RTE_SCHED_TRAFFIC_CLASSES_MAX];
 	/**< Number of bytes successfully written for each traffic class */
-	uint32_t n_bytes_tc_dropped[RTE_SCHED_TRAFFIC_CLASSES_PER_PIPE];
+	uint32_t n_bytes_tc_dropped[RTE_SCHED_TRAFFIC_CLASSES_MAX];
 	/**< Number of bytes dropped for each traffic class */
 
 #ifdef RTE_SCHED_RED
-	uint32_t n_pkts_red_dropped[RTE_SCHED_TRAFFIC_CLASSES_PER_PIPE];
+	uint32_t n_pkts_red_dropped[RTE_SCHED_TRAFFIC_CLASSES_MAX];
 	/**< Number of packets dropped by red */
 #endif
 };
@@ -184,16 +197,19 @@ struct rte_sched_pipe_params {
 	uint32_t tb_size;                /**< Size (measured in credits) */
 
 	/* Pipe traffic classes */
-	uint32_t tc_rate[RTE_SCHED_TRAFFIC_CLASSES_PER_PIPE];
+	uint32_t tc_rate[RTE_SCHED_TRAFFIC_CLASSES_MAX];
 	/**< Traffic class rates (measured in bytes per second) */
 	uint32_t tc_period;
 	/**< Enforcement period (measured in milliseconds) */
 #ifdef RTE_SCHED_SUBPORT_TC_OV
-	uint8_t tc_ov_weight;		 /**< Weight Traffic class 3 oversubscription */
+	uint8_t tc_ov_weight;
+	/**< Weight of the lowest priority traffic class oversubscription */
 #endif
 
 	/* Pipe queues */
-	uint8_t  wrr_weights[RTE_SCHED_QUEUES_PER_PIPE]; /**< WRR weights */
+	uint8_t  wrr_weights[RTE_SCHED_QUEUES_PER_PIPE];
+	/**< WRR weights, indexed by queue position within the pipe. Only
+	 * the weights of the queues used by the port layout are relevant. */
 };
 
 /** Queue statistics */
@@ -223,20 +239,72 @@ struct rte_sched_port_params {
 					  * (measured in bytes) */
 	uint32_t n_subports_per_port;    /**< Number of subports */
 	uint32_t n_pipes_per_subport;    /**< Number of pipes per subport */
-	uint16_t qsize[RTE_SCHED_TRAFFIC_CLASSES_PER_PIPE];
+	uint16_t qsize[RTE_SCHED_TRAFFIC_CLASSES_MAX];
 	/**< Packet queue size for each traffic class.
 	 * All queues within the same pipe traffic class have the same
 	 * size. Queues from different pipes serving the same traffic
 	 * class have the same size. */
+	uint8_t n_queues_per_tc[RTE_SCHED_TRAFFIC_CLASSES_MAX];
+	/**< Number of queues (1, 2 or 4) for each pipe traffic class, in
+	 * strict priority order. The queues of a traffic class are placed
+	 * in the pipe right after those of the previous traffic class and
+	 * are served by WRR. The traffic class list ends at the first zero
+	 * entry; at most RTE_SCHED_QUEUES_PER_PIPE queues may be used in
+	 * total. When all entries are zero, the default layout of
+	 * RTE_SCHED_TRAFFIC_CLASSES_PER_PIPE traffic classes with
+	 * RTE_SCHED_QUEUES_PER_TRAFFIC_CLASS queues each is used. */
 	struct rte_sched_pipe_params *pipe_profiles;
 	/**< Pipe profile table.
 	 * Every pipe is configured using one of the profiles from this table. */
 	uint32_t n_pipe_profiles;        /**< Profiles in the pipe profile table */
 #ifdef RTE_SCHED_RED
-	struct rte_red_params red_params[RTE_SCHED_TRAFFIC_CLASSES_PER_PIPE][e_RTE_METER_COLORS]; /**< RED parameters */
+	struct rte_red_params red_params[RTE_SCHED_TRAFFIC_CLASSES_MAX][e_RTE_METER_COLORS]; /**< RED parameters */
 #endif
 };
 
+/**
+ * Port group configuration parameters. A port group enforces the rate of
+ * one physical output port whose hierarchy is split across several port
+ * scheduler instances, each one typically owning a subset of the subports
+ * and being run by a different lcore.
+ */
+struct rte_sched_port_group_params {
+	const char *name;                /**< Name of the group, used as the
+					  * type of its memory allocation */
+	int socket;                      /**< CPU socket ID */
+	uint32_t rate;                   /**< Aggregate output rate shared by
+					  * all the member ports
+					  * (measured in bytes per second) */
+	uint32_t tb_size;                /**< Aggregate burst size
+					  * (measured in credits) */
+	uint32_t credits_grant;          /**< Credits a member port takes from
+					  * the group at a time. Should be a
+					  * few times the MTU and no bigger
+					  * than tb_size. */
+};
+
+/**
+ * Active Queue Management (AQM) hook, run for each packet enqueued into one
+ * of the queues of the traffic classes the hook is attached to. The hook
+ * replaces the RED dropper for these traffic classes.
+ *
+ * @param cfg
+ *   Hook configuration, shared by all the queues of the traffic class
+ * @param data
+ *   Run-time data of the queue (RTE_SCHED_AQM_DATA_SIZE bytes, 8-byte
+ *   aligned, zeroed when the hook is attached)
+ * @param qlen
+ *   Queue size before the packet is added (measured in packets)
+ * @param qr
+ *   Free running counter of the packets read from the queue
+ * @param time
+ *   Current port time (measured in bytes)
+ * @return
+ *   0 to enqueue the packet, non-zero to drop it
+ */
+typedef int (*rte_sched_aqm_enqueue_t)(void *cfg, void *data, uint32_t qlen,
+	uint16_t qr, uint64_t time);
+
 /*
  * Configuration
  *
@@ -263,7 +331,10 @@ void
 rte_sched_port_free(struct rte_sched_port *port);
 
 /**
- * Hierarchical scheduler subport configuration
+ * Hierarchical scheduler subport configuration. When the subport is
+ * already configured, its new rates apply right away to the current
+ * periods, while the credits left are carried over (up to the new limits)
+ * and its pipes stay configured.
  *
  * @param port
  *   Handle to port scheduler instance
@@ -280,7 +351,9 @@ rte_sched_subport_config(struct rte_sched_port *port,
 	struct rte_sched_subport_params *params);
 
 /**
- * Hierarchical scheduler pipe configuration
+ * Hierarchical scheduler pipe configuration. When the pipe is already
+ * configured, the credits left are carried over to the new profile (up to
+ * the new limits) and the packets stored in its queues are kept.
  *
  * @param port
  *   Handle to port scheduler instance
@@ -299,6 +372,75 @@ rte_sched_pipe_config(struct rte_sched_port *port,
 	uint32_t pipe_id,
 	int32_t pipe_profile);
 
+/**
+ * Hierarchical scheduler bulk pipe configuration. Same as
+ * rte_sched_pipe_config() for several pipes of the same subport. The
+ * parameters of all the pipes are checked first, so no pipe is changed when
+ * an error code is returned.
+ *
+ * @param port
+ *   Handle to port scheduler instance
+ * @param subport_id
+ *   Subport ID
+ * @param pipe_ids
+ *   Array of n_pipes pipe IDs within subport
+ * @param pipe_profiles
+ *   Array of n_pipes pipe profile IDs, a negative value disables the pipe
+ * @param n_pipes
+ *   Number of pipes to configure
+ * @return
+ *   0 upon success, error code otherwise
+ */
+int
+rte_sched_pipe_config_bulk(struct rte_sched_port *port,
+	uint32_t subport_id,
+	const uint32_t *pipe_ids,
+	const int32_t *pipe_profiles,
+	uint32_t n_pipes);
+
+/**
+ * Hierarchical scheduler pipe profile add. The new profile gets the next
+ * free entry of the port pipe profile table, of up to
+ * RTE_SCHED_PIPE_PROFILES_PER_PORT profiles, so the IDs of the existing
+ * profiles do not change. Like the other configuration functions, it is
+ * not thread safe with the port enqueue and dequeue operations.
+ *
+ * @param port
+ *   Handle to port scheduler instance
+ * @param params
+ *   Pipe profile parameters
+ * @param pipe_profile_id
+ *   Pointer to pre-allocated variable where the ID of the new profile
+ *   should be stored
+ * @return
+ *   0 upon success, error code otherwise
+ */
+int
+rte_sched_port_pipe_profile_add(struct rte_sched_port *port,
+	struct rte_sched_pipe_params *params,
+	uint32_t *pipe_profile_id);
+
+/**
+ * Hierarchical scheduler pipe profile update. The new parameters apply
+ * right away to all the pipes using the profile, with the credits left
+ * carried over (up to the new limits). Like the other configuration
+ * functions, it is not thread safe with the port enqueue and dequeue
+ * operations.
+ *
+ * @param port
+ *   Handle to port scheduler instance
+ * @param pipe_profile_id
+ *   Pipe profile ID
+ * @param params
+ *   New pipe profile parameters
+ * @return
+ *   0 upon success, error code otherwise
+ */
+int
+rte_sched_port_pipe_profile_update(struct rte_sched_port *port,
+	uint32_t pipe_profile_id,
+	struct rte_sched_pipe_params *params);
+
 /**
  * Hierarchical scheduler memory footprint size per port
  *
@@ -310,6 +452,82 @@ rte_sched_pipe_config(struct rte_sched_port *port,
 uint32_t
 rte_sched_port_get_memory_footprint(struct rte_sched_port_params *params);
 
+/**
+ * Hierarchical scheduler port group create
+ *
+ * @param params
+ *   Port group configuration parameters
+ * @return
+ *   Handle to port group instance upon success or NULL otherwise.
+ */
+struct rte_sched_port_group *
+rte_sched_port_group_create(struct rte_sched_port_group_params *params);
+
+/**
+ * Hierarchical scheduler port group free. All the member ports have to be
+ * freed first.
+ *
+ * @param group
+ *   Handle to port group instance
+ */
+void
+rte_sched_port_group_free(struct rte_sched_port_group *group);
+
+/**
+ * Hierarchical scheduler port group member add. From now on, the port
+ * dequeue operation only sends the traffic allowed by the group rate, with
+ * the group credits being shared between the member ports without locks.
+ * The member ports have to be added before any packet is enqueued.
+ *
+ * @param group
+ *   Handle to port group instance
+ * @param port
+ *   Handle to port scheduler instance
+ * @return
+ *   0 upon success, error code otherwise
+ */
+int
+rte_sched_port_group_add(struct rte_sched_port_group *group,
+	struct rte_sched_port *port);
+
+/**
+ * Hierarchical scheduler AQM hook attach. The run-time data of all the
+ * queues of the traffic class is reset. Can be called at any time, but not
+ * concurrently with the port enqueue operation.
+ *
+ * @param port
+ *   Handle to port scheduler instance
+ * @param traffic_class
+ *   Traffic class ID
+ * @param f_enqueue
+ *   AQM hook, NULL to detach the current one
+ * @param cfg
+ *   Hook configuration, has to stay valid while the hook is attached
+ * @return
+ *   0 upon success, error code otherwise
+ */
+int
+rte_sched_port_aqm_set(struct rte_sched_port *port,
+	uint32_t traffic_class,
+	rte_sched_aqm_enqueue_t f_enqueue,
+	void *cfg);
+
+/**
+ * PIE AQM hook, with cfg pointing to a struct rte_pie_config whose times
+ * are measured in bytes (see rte_aqm.h).
+ */
+int
+rte_sched_aqm_pie(void *cfg, void *data, uint32_t qlen, uint16_t qr,
+	uint64_t time);
+
+/**
+ * CoDel AQM hook, with cfg pointing to a struct rte_codel_config whose
+ * times are measured in bytes (see rte_aqm.h).
+ */
+int
+rte_sched_aqm_codel(void *cfg, void *data, uint32_t qlen, uint16_t qr,
+	uint64_t time);
+
 /*
  * Statistics
  *
@@ -326,8 +544,8 @@ rte_sched_port_get_memory_footprint(struct rte_sched_port_params *params);
  *   Pointer to pre-allocated subport statistics structure where the statistics
  *   counters should be stored
  * @param tc_ov
- *   Pointer to pre-allocated 4-entry array where the oversubscription status for
- *   each of the 4 subport traffic classes should be stored.
+ *   Pointer to pre-allocated variable where the oversubscription status of
+ *   the lowest priority subport traffic class should be stored.
  * @return
  *   0 upon success, error code otherwise
  */
@@ -343,7 +561,9 @@ rte_sched_subport_read_stats(struct rte_sched_port *port,
  * @param port
  *   Handle to port scheduler instance
  * @param queue_id
- *   Queue ID within port scheduler
+ *   Queue ID within port scheduler, i.e. the pipe index within the port
+ *   multiplied by RTE_SCHED_QUEUES_PER_PIPE plus the queue position within
+ *   the pipe
  * @param stats
  *   Pointer to pre-allocated subport statistics structure where the statistics
  *   counters should be stored
@@ -370,9 +590,12 @@ rte_sched_queue_read_stats(struct rte_sched_port *port,
  * @param pipe
  *   Pipe ID within subport
  * @param traffic_class
- *   Traffic class ID within pipe (0 .. 3)
+ *   Traffic class ID within pipe (0 .. number of traffic classes - 1). The
+ *   enqueue maps greater IDs to the last traffic class.
  * @param queue
- *   Queue ID within pipe traffic class (0 .. 3)
+ *   Queue ID within pipe traffic class (0 .. number of queues of the
+ *   traffic class - 1). The enqueue only uses the low order bits of the
+ *   queue ID needed by the traffic class.
  * @param color
  *   Packet color set
  */
@@ -394,9 +617,10 @@ rte_sched_port_pkt_write(struct rte_mbuf *pkt,
  * @param pipe
  *   Pipe ID within subport
  * @param traffic_class
- *   Traffic class ID within pipe (0 .. 3)
+ *   Traffic class ID within pipe (0 .. number of traffic classes - 1)
  * @param queue
- *   Queue ID within pipe traffic class (0 .. 3)
+ *   Queue ID within pipe traffic class (0 .. number of queues of the
+ *   traffic class - 1)
  *
  */
 void
@@ -434,6 +658,9 @@ rte_sched_port_enqueue(struct rte_sched_port *port, struct rte_mbuf **pkts, uint
  * number of packets actually read.  The pkts array needs to be
  * pre-allocated by the caller with at least n_pkts entries.
  *
+ * When the port is member of a port group, the number of packets read is
+ * also limited by the credits the port gets from the group.
+ *
  * @param port
  *   Handle to port scheduler instance
  * @param pkts
@@ -74,6 +74,13 @@ extern "C" {
  *        4 keys, potentially until all keys in this bucket are examined. The
  *        extendible bucket logic requires maintaining specific data structures
  *        per table and per each bucket.
+ *     c. Cuckoo: The key is moved to its alternative bucket to make room for
+ *        the new key, and so on for the keys it displaces, until a free slot
+ *        is found. A key is always stored in one of its two candidate buckets,
+ *        so the key lookup operation examines at most two buckets of 4 keys
+ *        while the table can be filled close to its full capacity. This table
+ *        is built on top of the librte_hash cuckoo hash and always computes
+ *        the key signature on lookup.
  * 2. Key signature computation:
  *     a. Pre-computed key signature: The key lookup operation is split between
  *        two CPU cores. The first CPU core (typically the CPU core performing
@@ -174,6 +181,32 @@ extern struct rte_table_ops rte_table_hash_lru_ops;
 /** LRU hash table operations for key signature computed on lookup ("do-sig") */
 extern struct rte_table_ops rte_table_hash_lru_dosig_ops;
 
+/** Cuckoo hash table parameters */
+struct rte_table_hash_cuckoo_params {
+	/** Key size (number of bytes), any value is valid */
+	uint32_t key_size;
+
+	/** Maximum number of keys */
+	uint32_t n_keys;
+
+	/** Hash function, the 32 least significant bits of its result are
+	the key signature */
+	rte_table_hash_op_hash f_hash;
+
+	/** Seed value for the hash function */
+	uint64_t seed;
+
+	/** Byte offset within packet meta-data where the key is located */
+	uint32_t key_offset;
+
+	/** Name of the underlying librte_hash table, must be unique */
+	const char *name;
+};
+
+/** Cuckoo hash table operations for key signature computed on lookup
+	("do-sig") */
+extern struct rte_table_ops rte_table_hash_cuckoo_dosig_ops;
+
 /**
  * 8-byte key hash tables
  *
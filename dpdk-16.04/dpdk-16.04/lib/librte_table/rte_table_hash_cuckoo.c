@@ -0,0 +1,349 @@
+/*-
+ *	 BSD LICENSE
+ *
+ *	 Copyright(c) 2016 Intel Corporation. All rights reserved.
+ *	 All rights reserved.
+ *
+ *	 Redistribution and use in source and binary forms, with or without
+ *	 modification, are permitted provided that the following conditions
+ *	 are met:
+ *
+ *	* Redistributions of source code must retain the above copyright
+ *		 notice, this list of conditions and the following disclaimer.
+ *	* Redistributions in binary form must reproduce the above copyright
+ *		 notice, this list of conditions and the following disclaimer in
+ *		 the documentation and/or other materials provided with the
+ *		 distribution.
+ *	* Neither the name of Intel Corporation nor the names of its
+ *		 contributors may be used to endorse or promote products derived
+ *		 from this software without specific prior written permission.
+ *
+ *	 THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *	 "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *	 LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *	 A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *	 OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *	 SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *	 LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *	 DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *	 THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *	 (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *	 OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <string.h>
+#include <stdio.h>
+
+#include <rte_common.h>
+#include <rte_mbuf.h>
+#include <rte_memory.h>
+#include <rte_malloc.h>
+#include <rte_log.h>
+#include <rte_hash.h>
+
+#include "rte_table_hash.h"
+
+#ifdef RTE_TABLE_STATS_COLLECT
+
+#define RTE_TABLE_HASH_CUCKOO_STATS_PKTS_IN_ADD(table, val) \
+	table->stats.n_pkts_in += val
+#define RTE_TABLE_HASH_CUCKOO_STATS_PKTS_LOOKUP_MISS(table, val) \
+	table->stats.n_pkts_lookup_miss += val
+
+#else
+
+#define RTE_TABLE_HASH_CUCKOO_STATS_PKTS_IN_ADD(table, val)
+#define RTE_TABLE_HASH_CUCKOO_STATS_PKTS_LOOKUP_MISS(table, val)
+
+#endif
+
+struct rte_table_hash {
+	struct rte_table_stats stats;
+
+	/* Input parameters */
+	uint32_t key_size;
+	uint32_t entry_size;
+	uint32_t n_keys;
+	rte_table_hash_op_hash f_hash;
+	uint64_t seed;
+	uint32_t key_offset;
+
+	/* Internal */
+	struct rte_hash *h_table;
+	uint64_t *key_valid; /* Bitmap of the key positions in use */
+
+	/* Table memory: one entry for each rte_hash key position */
+	uint8_t memory[0] __rte_cache_aligned;
+};
+
+/*
+ * Signature of a key, given to the rte_hash functions: the hash function of
+ * the table is called with its full 64-bit seed, which the rte_hash hash
+ * function could not take.
+ */
+static inline hash_sig_t
+cuckoo_sig(struct rte_table_hash *t, const void *key)
+{
+	return (hash_sig_t) t->f_hash((void *)(uintptr_t) key, t->key_size,
+		t->seed);
+}
+
+static int
+check_params_create(struct rte_table_hash_cuckoo_params *params)
+{
+	if (params == NULL) {
+		RTE_LOG(ERR, TABLE, "%s: NULL input parameters\n", __func__);
+		return -EINVAL;
+	}
+
+	/* key_size */
+	if (params->key_size == 0) {
+		RTE_LOG(ERR, TABLE, "%s: key_size invalid value\n", __func__);
+		return -EINVAL;
+	}
+
+	/* n_keys */
+	if (params->n_keys == 0) {
+		RTE_LOG(ERR, TABLE, "%s: n_keys invalid value\n", __func__);
+		return -EINVAL;
+	}
+
+	/* f_hash */
+	if (params->f_hash == NULL) {
+		RTE_LOG(ERR, TABLE, "%s: f_hash invalid value\n", __func__);
+		return -EINVAL;
+	}
+
+	/* name */
+	if (params->name == NULL) {
+		RTE_LOG(ERR, TABLE, "%s: name invalid value\n", __func__);
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+static void *
+rte_table_hash_cuckoo_create(void *params, int socket_id, uint32_t entry_size)
+{
+	struct rte_table_hash_cuckoo_params *p =
+		(struct rte_table_hash_cuckoo_params *) params;
+	struct rte_hash_parameters hash_params;
+	struct rte_table_hash *t;
+	struct rte_hash *h_table;
+	uint32_t entries_size, total_size;
+
+	/* Check input parameters */
+	if ((check_params_create(p) != 0) ||
+		((sizeof(struct rte_table_hash) % RTE_CACHE_LINE_SIZE) != 0))
+		return NULL;
+
+	/* Memory allocation */
+	entries_size = RTE_CACHE_LINE_ROUNDUP(p->n_keys * entry_size);
+	total_size = sizeof(struct rte_table_hash) + entries_size +
+		RTE_CACHE_LINE_ROUNDUP(RTE_ALIGN(p->n_keys, 64) / 8);
+
+	t = rte_zmalloc_socket("TABLE", total_size, RTE_CACHE_LINE_SIZE, socket_id);
+	if (t == NULL) {
+		RTE_LOG(ERR, TABLE,
+			"%s: Cannot allocate %u bytes for cuckoo hash table\n",
+			__func__, total_size);
+		return NULL;
+	}
+
+	/*
+	 * Cuckoo hash table, the key positions index the table entries. Its
+	 * default hash function is not used: all the keys are given with
+	 * their signature, see cuckoo_sig().
+	 */
+	memset(&hash_params, 0, sizeof(hash_params));
+	hash_params.name = p->name;
+	hash_params.entries = p->n_keys;
+	hash_params.key_len = p->key_size;
+	hash_params.socket_id = socket_id;
+
+	h_table = rte_hash_create(&hash_params);
+	if (h_table == NULL) {
+		RTE_LOG(ERR, TABLE, "%s: Cannot create cuckoo hash table %s\n",
+			__func__, p->name);
+		rte_free(t);
+		return NULL;
+	}
+
+	RTE_LOG(INFO, TABLE, "%s (%u-byte key): Hash table memory footprint is "
+		"%u bytes\n", __func__, p->key_size, total_size);
+
+	/* Memory initialization */
+	t->key_size = p->key_size;
+	t->entry_size = entry_size;
+	t->n_keys = p->n_keys;
+	t->f_hash = p->f_hash;
+	t->seed = p->seed;
+	t->key_offset = p->key_offset;
+	t->h_table = h_table;
+	t->key_valid = (uint64_t *) &t->memory[entries_size];
+
+	return t;
+}
+
+static int
+rte_table_hash_cuckoo_free(void *table)
+{
+	struct rte_table_hash *t = (struct rte_table_hash *) table;
+
+	/* Check input parameters */
+	if (t == NULL)
+		return -EINVAL;
+
+	rte_hash_free(t->h_table);
+	rte_free(t);
+	return 0;
+}
+
+static int
+rte_table_hash_cuckoo_entry_add(void *table, void *key, void *entry,
+	int *key_found, void **entry_ptr)
+{
+	struct rte_table_hash *t = (struct rte_table_hash *) table;
+	int pos;
+
+	/* Check input parameters */
+	if ((t == NULL) ||
+		(key == NULL) ||
+		(entry == NULL) ||
+		(key_found == NULL) ||
+		(entry_ptr == NULL))
+		return -EINVAL;
+
+	/* Add the key, or get its position if it is already present */
+	pos = rte_hash_add_key_with_hash(t->h_table, key, cuckoo_sig(t, key));
+	if (pos < 0)
+		return pos;
+
+	{
+		uint8_t *new_entry = &t->memory[pos * t->entry_size];
+		uint64_t bit = 1LLU << (pos & 63);
+
+		memcpy(new_entry, entry, t->entry_size);
+		*key_found = (t->key_valid[pos >> 6] & bit) != 0;
+		*entry_ptr = new_entry;
+		t->key_valid[pos >> 6] |= bit;
+	}
+
+	return 0;
+}
+
+static int
+rte_table_hash_cuckoo_entry_delete(void *table, void *key, int *key_found,
+	void *entry)
+{
+	struct rte_table_hash *t = (struct rte_table_hash *) table;
+	int pos;
+
+	/* Check input parameters */
+	if ((t == NULL) ||
+		(key == NULL) ||
+		(key_found == NULL))
+		return -EINVAL;
+
+	pos = rte_hash_del_key_with_hash(t->h_table, key, cuckoo_sig(t, key));
+	if (pos < 0) {
+		*key_found = 0;
+		return (pos == -ENOENT) ? 0 : pos;
+	}
+
+	{
+		uint8_t *entry_ptr = &t->memory[pos * t->entry_size];
+
+		if (entry)
+			memcpy(entry, entry_ptr, t->entry_size);
+		memset(entry_ptr, 0, t->entry_size);
+		t->key_valid[pos >> 6] &= ~(1LLU << (pos & 63));
+		*key_found = 1;
+	}
+
+	return 0;
+}
+
+static int
+rte_table_hash_cuckoo_lookup_dosig(void *table,
+	struct rte_mbuf **pkts,
+	uint64_t pkts_mask,
+	uint64_t *lookup_hit_mask,
+	void **entries)
+{
+	struct rte_table_hash *t = (struct rte_table_hash *) table;
+	const void *keys[RTE_PORT_IN_BURST_SIZE_MAX];
+	hash_sig_t sigs[RTE_PORT_IN_BURST_SIZE_MAX];
+	int32_t positions[RTE_PORT_IN_BURST_SIZE_MAX];
+	uint32_t pkt_index[RTE_PORT_IN_BURST_SIZE_MAX];
+	uint64_t pkts_mask_out = 0;
+	uint32_t n_keys = 0, i;
+
+	__rte_unused uint32_t n_pkts_in = __builtin_popcountll(pkts_mask);
+	RTE_TABLE_HASH_CUCKOO_STATS_PKTS_IN_ADD(t, n_pkts_in);
+
+	/* Gather the keys of the input packets */
+	for ( ; pkts_mask; ) {
+		uint32_t pkt_idx = __builtin_ctzll(pkts_mask);
+
+		pkts_mask &= ~(1LLU << pkt_idx);
+		keys[n_keys] = RTE_MBUF_METADATA_UINT8_PTR(pkts[pkt_idx],
+			t->key_offset);
+		sigs[n_keys] = cuckoo_sig(t, keys[n_keys]);
+		pkt_index[n_keys] = pkt_idx;
+		n_keys++;
+	}
+
+	if (n_keys == 0) {
+		*lookup_hit_mask = 0;
+		return 0;
+	}
+
+	/* Bulk lookup, the cuckoo hash prefetches the buckets of all keys */
+	rte_hash_lookup_bulk_with_hash(t->h_table, keys, sigs, n_keys,
+		positions);
+
+	for (i = 0; i < n_keys; i++) {
+		int32_t pos = positions[i];
+
+		if (pos >= 0) {
+			uint32_t pkt_idx = pkt_index[i];
+
+			pkts_mask_out |= 1LLU << pkt_idx;
+			entries[pkt_idx] = &t->memory[pos * t->entry_size];
+		}
+	}
+
+	*lookup_hit_mask = pkts_mask_out;
+	RTE_TABLE_HASH_CUCKOO_STATS_PKTS_LOOKUP_MISS(t,
+		n_pkts_in - __builtin_popcountll(pkts_mask_out));
+
+	return 0;
+}
+
+static int
+rte_table_hash_cuckoo_stats_read(void *table, struct rte_table_stats *stats,
+	int clear)
+{
+	struct rte_table_hash *t = (struct rte_table_hash *) table;
+
+	if (stats != NULL)
+		memcpy(stats, &t->stats, sizeof(t->stats));
+
+	if (clear)
+		memset(&t->stats, 0, sizeof(t->stats));
+
+	return 0;
+}
+
+struct rte_table_ops rte_table_hash_cuckoo_dosig_ops = {
+	.f_create = rte_table_hash_cuckoo_create,
+	.f_free = rte_table_hash_cuckoo_free,
+	.f_add = rte_table_hash_cuckoo_entry_add,
+	.f_delete = rte_table_hash_cuckoo_entry_delete,
+	.f_add_bulk = NULL,
+	.f_delete_bulk = NULL,
+	.f_lookup = rte_table_hash_cuckoo_lookup_dosig,
+	.f_stats = rte_table_hash_cuckoo_stats_read,
+};
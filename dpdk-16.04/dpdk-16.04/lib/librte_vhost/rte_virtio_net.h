@@ -40,6 +40,7 @@
  */
 
 #include <stdint.h>
+#include <sys/queue.h>
 #include <linux/vhost.h>
 #include <linux/virtio_ring.h>
 #include <linux/virtio_net.h>
@@ -55,6 +56,9 @@ struct rte_mbuf;
 
 #define VHOST_MEMORY_MAX_NREGIONS 8
 
+/* Flags of rte_vhost_driver_register_flags(). */
+#define RTE_VHOST_USER_DEQUEUE_ZERO_COPY	(1ULL << 0)
+
 /* Used to indicate that the device is running on a data core */
 #define VIRTIO_DEV_RUNNING 1
 
@@ -77,6 +81,9 @@ struct buf_vector {
 	uint32_t desc_idx;
 };
 
+struct zcopy_mbuf;
+TAILQ_HEAD(zcopy_mbuf_list, zcopy_mbuf);
+
 /**
  * Structure contains variables relevant to RX/TX virtqueues.
  */
@@ -95,7 +102,17 @@ struct vhost_virtqueue {
 	int			kickfd;			/**< Currently unused as polling mode is enabled. */
 	int			enabled;
 	uint64_t		log_guest_addr;		/**< Physical address of used ring, for logging */
-	uint64_t		reserved[15];		/**< Reserve some spaces for future extension. */
+	uint16_t		nr_zmbuf;		/**< Number of mbufs attached to guest buffers. */
+	uint16_t		zmbuf_size;		/**< Size of the zmbufs array. */
+	uint16_t		last_zmbuf_idx;		/**< Where to look for a free zmbuf. */
+	struct zcopy_mbuf	*zmbufs;		/**< Mbufs attached in dequeue zero copy mode. */
+	struct zcopy_mbuf_list	zmbuf_list;		/**< Attached mbufs, in dequeue order. */
+	struct virtio_memory_regions *last_region;	/**< Memory region of the last address translated. */
+	uint32_t		notify_max_pkts;	/**< Used buffers coalesced in a guest notification, 0 to notify after each burst. */
+	uint32_t		nr_notify_pending;	/**< Used buffers the guest has not been notified of. */
+	uint64_t		notify_cycles;		/**< Longest delay of a coalesced notification, in TSC cycles. */
+	uint64_t		notify_tsc;		/**< When the first pending used buffer was put in the used ring. */
+	uint64_t		reserved[7];		/**< Reserve some spaces for future extension. */
 	struct buf_vector	buf_vec[BUF_VECTOR_MAX];	/**< for scatter RX. */
 } __rte_cache_aligned;
 
@@ -126,6 +143,8 @@ struct vhost_virtqueue {
  #define VIRTIO_F_VERSION_1 32
 #endif
 
+struct guest_page;
+
 /**
  * Device structure contains all configuration information relating to the device.
  */
@@ -143,7 +162,11 @@ struct virtio_net {
 	uint64_t		log_base;	/**< Where dirty pages are logged */
 	struct ether_addr	mac;		/**< MAC address */
 	rte_atomic16_t		broadcast_rarp;	/**< A flag to tell if we need broadcast rarp packet */
-	uint64_t		reserved[61];	/**< Reserve some spaces for future extension. */
+	uint32_t		dequeue_zero_copy;	/**< Guest buffers are attached to mbufs, not copied */
+	uint32_t		nr_guest_pages;	/**< Number of host physically contiguous guest pages */
+	uint32_t		max_guest_pages;	/**< Size of guest_pages array */
+	struct guest_page	*guest_pages;	/**< Guest to host physical address mapping */
+	uint64_t		reserved[58];	/**< Reserve some spaces for future extension. */
 	struct vhost_virtqueue	*virtqueue[VHOST_MAX_QUEUE_PAIRS * 2];	/**< Contains all virtqueue information. */
 } __rte_cache_aligned;
 
@@ -161,6 +184,7 @@ struct virtio_memory_regions {
 
 /**
  * Memory structure includes region and mapping information.
+ * The regions are sorted by guest physical address.
  */
 struct virtio_memory {
 	uint64_t	base_address;	/**< Base QEMU userspace address of the memory file. */
@@ -195,6 +219,34 @@ rte_vring_available_entries(struct virtio_net *dev, uint16_t queue_id)
 	return *(volatile uint16_t *)&vq->avail->idx - vq->last_used_idx_res;
 }
 
+/**
+ * Function to find the memory region holding a guest physical address,
+ * with a binary search on the sorted regions. Returns NULL if the address
+ * is not mapped.
+ */
+static inline struct virtio_memory_regions * __attribute__((always_inline))
+gpa_to_region(struct virtio_net *dev, uint64_t guest_pa)
+{
+	struct virtio_memory_regions *region = dev->mem->regions;
+	uint32_t n = dev->mem->nregions, half;
+
+	if (n == 0)
+		return NULL;
+
+	/* Branchless: the lookups of several regions are not predictable */
+	while (n > 1) {
+		half = n / 2;
+		region = guest_pa >= region[half].guest_phys_address ?
+			&region[half] : region;
+		n -= half;
+	}
+
+	if (guest_pa - region->guest_phys_address >= region->memory_size)
+		return NULL;
+
+	return region;
+}
+
 /**
  * Function to convert guest physical addresses to vhost virtual addresses.
  * This is used to convert guest virtio buffer addresses.
@@ -203,18 +255,12 @@ static inline uint64_t __attribute__((always_inline))
 gpa_to_vva(struct virtio_net *dev, uint64_t guest_pa)
 {
 	struct virtio_memory_regions *region;
-	uint32_t regionidx;
-	uint64_t vhost_va = 0;
-
-	for (regionidx = 0; regionidx < dev->mem->nregions; regionidx++) {
-		region = &dev->mem->regions[regionidx];
-		if ((guest_pa >= region->guest_phys_address) &&
-			(guest_pa <= region->guest_phys_address_end)) {
-			vhost_va = region->address_offset + guest_pa;
-			break;
-		}
-	}
-	return vhost_va;
+
+	region = gpa_to_region(dev, guest_pa);
+	if (region == NULL)
+		return 0;
+
+	return region->address_offset + guest_pa;
 }
 
 
@@ -233,9 +279,64 @@ uint64_t rte_vhost_feature_get(void);
 
 int rte_vhost_enable_guest_notification(struct virtio_net *dev, uint16_t queue_id, int enable);
 
+/**
+ * Coalesces the notifications sent to the guest for the buffers put in the
+ * used ring of a virtqueue. The guest is notified once max_pkts buffers
+ * have been used since its last notification, or once the first of them
+ * has waited for max_usec microseconds. Both are checked on each enqueue or
+ * dequeue burst of the virtqueue, even when it moves no packet: the
+ * application has to keep polling the virtqueue, from a single core.
+ *
+ * @param dev
+ *  virtio-net device
+ * @param queue_id
+ *  virtio queue index in mq case
+ * @param max_pkts
+ *  number of used buffers to coalesce, 0 to notify the guest after each
+ *  burst, which is the default
+ * @param max_usec
+ *  longest delay of a notification, in microseconds
+ * @return
+ *  0 on success, -1 on failure
+ */
+int rte_vhost_guest_notify_coalesce(struct virtio_net *dev, uint16_t queue_id,
+	uint32_t max_pkts, uint32_t max_usec);
+
+/**
+ * Get the numa node of a virtio-net device. Once the guest memory table is
+ * set, the device and its virtqueues are allocated on the numa node holding
+ * most of the guest memory, so that the cores polling the device can be
+ * chosen on the same node. It requires CONFIG_RTE_LIBRTE_VHOST_NUMA.
+ *
+ * @param dev
+ *  virtio-net device
+ * @return
+ *  The numa node, -1 on failure
+ */
+int rte_vhost_get_numa_node(struct virtio_net *dev);
+
 /* Register vhost driver. dev_name could be different for multiple instance support. */
 int rte_vhost_driver_register(const char *dev_name);
 
+/**
+ * Register vhost driver, with RTE_VHOST_USER_* flags. Only vhost user
+ * supports flags.
+ *
+ * With RTE_VHOST_USER_DEQUEUE_ZERO_COPY, rte_vhost_dequeue_burst() attaches
+ * the mbufs to the guest buffers instead of copying them, when the packet is
+ * held in one buffer contiguous in host physical memory. The guest buffer is
+ * given back to the guest only once its mbuf has been freed, so the mbufs
+ * must not be held for long.
+ *
+ * @param dev_name
+ *  socket path
+ * @param flags
+ *  RTE_VHOST_USER_* flags
+ * @return
+ *  0 on success, -1 on failure
+ */
+int rte_vhost_driver_register_flags(const char *dev_name, uint64_t flags);
+
 /* Unregister vhost driver. This is only meaningful to vhost user. */
 int rte_vhost_driver_unregister(const char *dev_name);
 
@@ -267,6 +368,9 @@ uint16_t rte_vhost_enqueue_burst(struct virtio_net *dev, uint16_t queue_id,
  * This function gets guest buffers from the virtio device TX virtqueue,
  * construct host mbufs, copies guest buffer content to host mbufs and
  * store them in pkts to be processed.
+ * In dequeue zero copy mode, the mbufs are attached to the guest buffers
+ * when possible, and the guest buffers are returned to the guest by a later
+ * call, after their mbufs have been freed.
  * @param dev
  *  virtio-net device
  * @param queue_id
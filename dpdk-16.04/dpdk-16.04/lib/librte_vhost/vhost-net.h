@@ -75,6 +75,31 @@
 #endif
 
 
+/*
+ * Guest memory range which is contiguous in host physical memory, used
+ * to give the guest buffers to the NIC in dequeue zero copy mode.
+ */
+struct guest_page {
+	uint64_t guest_phys_addr;
+	uint64_t host_phys_addr;
+	uint64_t size;
+};
+
+/*
+ * Mbuf attached to a guest buffer in dequeue zero copy mode. The
+ * descriptor is put in the used ring once the mbuf has been freed.
+ */
+struct zcopy_mbuf {
+	struct rte_mbuf *mbuf;
+	void *buf_addr;		/* Own data room of the mbuf, */
+	uint64_t buf_physaddr;	/* restored when it is freed. */
+	uint16_t buf_len;
+	uint16_t in_use;
+	uint32_t desc_idx;
+
+	TAILQ_ENTRY(zcopy_mbuf) next;
+};
+
 /*
  * Structure used to identify device context.
  */
@@ -88,6 +113,8 @@ void vhost_destroy_device(struct vhost_device_ctx);
 
 void vhost_set_ifname(struct vhost_device_ctx,
 	const char *if_name, unsigned int if_len);
+void vhost_enable_dequeue_zero_copy(struct vhost_device_ctx);
+struct virtio_net *vhost_mem_table_changed(struct virtio_net *dev);
 
 int vhost_get_features(struct vhost_device_ctx, uint64_t *);
 int vhost_set_features(struct vhost_device_ctx, uint64_t *);
@@ -106,6 +133,14 @@ int vhost_set_backend(struct vhost_device_ctx, struct vhost_vring_file *);
 int vhost_set_owner(struct vhost_device_ctx);
 int vhost_reset_owner(struct vhost_device_ctx);
 
+/*
+ * Release the mbufs attached to guest buffers, once the application and
+ * the PMD have freed them or after a bounded wait. vhost_flush_zmbufs()
+ * also returns the buffers of the freed mbufs to the guest.
+ */
+void vhost_flush_zmbufs(struct virtio_net *dev, struct vhost_virtqueue *vq);
+void vhost_free_zmbufs(struct virtio_net *dev, struct vhost_virtqueue *vq);
+
 /*
  * Backend-specific cleanup. Defined by vhost-cuse and vhost-user.
  */
@@ -404,6 +404,22 @@ rte_vhost_driver_register(const char *dev_name)
 	return 0;
 }
 
+/**
+ * No flag is supported by vhost cuse.
+ */
+int
+rte_vhost_driver_register_flags(const char *dev_name, uint64_t flags)
+{
+	if (flags != 0) {
+		RTE_LOG(ERR, VHOST_CONFIG,
+			"vhost cuse doesn't support flags 0x%"PRIx64"\n",
+			flags);
+		return -1;
+	}
+
+	return rte_vhost_driver_register(dev_name);
+}
+
 /**
  * An empty function for unregister
  */
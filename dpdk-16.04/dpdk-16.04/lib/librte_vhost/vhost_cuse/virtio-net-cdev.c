@@ -370,6 +370,7 @@ cuse_set_mem_table(struct vhost_device_ctx ctx,
 			pregion[idx].guest_phys_address;
 	}
 	dev->mem->nregions = valid_regions;
+	dev = vhost_mem_table_changed(dev);
 
 	return 0;
 }
@@ -33,10 +33,13 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include <unistd.h>
 #include <linux/virtio_net.h>
 
 #include <rte_mbuf.h>
 #include <rte_memcpy.h>
+#include <rte_cycles.h>
+#include <rte_malloc.h>
 #include <rte_ether.h>
 #include <rte_ip.h>
 #include <rte_virtio_net.h>
@@ -50,6 +53,18 @@
 #define MAX_PKT_BURST 32
 #define VHOST_LOG_PAGE	4096
 
+/*
+ * In dequeue zero copy mode, shorter packets are still copied: their copy
+ * costs less than keeping track of the attached mbufs.
+ */
+#define VHOST_ZCOPY_MIN_LEN	512
+
+/*
+ * Longest wait, on the vhost-user session thread, for the attached mbufs
+ * of a stopped ring to be freed.
+ */
+#define VHOST_ZCOPY_DRAIN_TIMEOUT_MS	100
+
 static inline void __attribute__((always_inline))
 vhost_log_page(uint8_t *log_base, uint64_t page)
 {
@@ -85,6 +100,156 @@ vhost_log_used_vring(struct virtio_net *dev, struct vhost_virtqueue *vq,
 	vhost_log_write(dev, vq->log_guest_addr + offset, len);
 }
 
+/*
+ * The used ring entries of a burst are first written to a shadow ring on
+ * the stack, then copied to the used ring in one go: the used ring, which
+ * the guest is reading, is written once per burst, instead of once per
+ * packet, between the copies of the packets.
+ */
+#define VHOST_SHADOW_USED_MAX	64
+
+struct shadow_used_ring {
+	uint16_t used_idx;	/* used ring index of the first entry */
+	uint16_t count;
+	struct vring_used_elem ring[VHOST_SHADOW_USED_MAX];
+};
+
+/*
+ * Copies the shadow entries to the used ring, used->idx is left to the
+ * caller.
+ */
+static void
+flush_shadow_used_ring(struct virtio_net *dev, struct vhost_virtqueue *vq,
+		       struct shadow_used_ring *shadow)
+{
+	struct vring_used_elem *from = shadow->ring;
+	uint32_t to = shadow->used_idx & (vq->size - 1);
+	uint32_t left = shadow->count;
+	uint32_t n;
+
+	/* in two parts when wrapping around the end of the ring */
+	while (left != 0) {
+		n = RTE_MIN(left, vq->size - to);
+		rte_memcpy(&vq->used->ring[to], from, n * sizeof(*from));
+		vhost_log_used_vring(dev, vq,
+			offsetof(struct vring_used, ring[to]),
+			n * sizeof(*from));
+		from += n;
+		left -= n;
+		to = 0;
+	}
+
+	shadow->used_idx += shadow->count;
+	shadow->count = 0;
+}
+
+static inline void __attribute__((always_inline))
+update_shadow_used_ring(struct virtio_net *dev, struct vhost_virtqueue *vq,
+			struct shadow_used_ring *shadow,
+			uint32_t desc_idx, uint32_t len)
+{
+	if (unlikely(shadow->count == VHOST_SHADOW_USED_MAX))
+		flush_shadow_used_ring(dev, vq, shadow);
+
+	shadow->ring[shadow->count].id = desc_idx;
+	shadow->ring[shadow->count].len = len;
+	shadow->count++;
+}
+
+/*
+ * Notifies the guest of the buffers put in the used ring, used->idx being
+ * already updated. The notification is deferred while the coalescing
+ * limits of the virtqueue are not reached; nr_used may be 0 to only check
+ * them.
+ */
+static inline void __attribute__((always_inline))
+vhost_vring_call(struct vhost_virtqueue *vq, uint32_t nr_used)
+{
+	uint64_t now;
+
+	if (nr_used == 0 && likely(vq->nr_notify_pending == 0))
+		return;
+
+	if (vq->notify_max_pkts != 0) {
+		now = rte_rdtsc();
+		if (vq->nr_notify_pending == 0)
+			vq->notify_tsc = now;
+		vq->nr_notify_pending += nr_used;
+		if (vq->nr_notify_pending < vq->notify_max_pkts &&
+		    now - vq->notify_tsc < vq->notify_cycles)
+			return;
+		vq->nr_notify_pending = 0;
+	}
+
+	if (vq->callfd < 0)
+		return;
+
+	/* flush used->idx update before we read avail->flags. */
+	rte_mb();
+
+	/* Kick the guest if necessary. */
+	if (!(vq->avail->flags & VRING_AVAIL_F_NO_INTERRUPT))
+		eventfd_write(vq->callfd, (eventfd_t)1);
+}
+
+/*
+ * Converts a guest physical address, looking first at the memory region
+ * of the last address converted on this virtqueue. The region is cached
+ * as a single pointer, so the cores sharing a virtqueue don't see a torn
+ * entry.
+ */
+static inline uint64_t __attribute__((always_inline))
+vq_gpa_to_vva(struct virtio_net *dev, struct vhost_virtqueue *vq,
+	      uint64_t gpa)
+{
+	struct virtio_memory_regions *region = vq->last_region;
+
+	if (likely(region != NULL &&
+		   gpa - region->guest_phys_address < region->memory_size))
+		return region->address_offset + gpa;
+
+	region = gpa_to_region(dev, gpa);
+	if (unlikely(region == NULL))
+		return 0;
+
+	vq->last_region = region;
+	return region->address_offset + gpa;
+}
+
+/*
+ * Converts the addresses of all the buffers of a descriptor chain at once
+ * into vec, and prefetches them. Returns the number of buffers, or -1 if
+ * the chain is broken.
+ */
+static inline int __attribute__((always_inline))
+translate_desc_chain(struct virtio_net *dev, struct vhost_virtqueue *vq,
+		     uint16_t desc_idx, struct buf_vector *vec)
+{
+	struct vring_desc *desc;
+	uint32_t nr_vec = 0;
+
+	while (1) {
+		if (unlikely(nr_vec >= BUF_VECTOR_MAX || desc_idx >= vq->size))
+			return -1;
+
+		desc = &vq->desc[desc_idx];
+		vec[nr_vec].buf_addr = vq_gpa_to_vva(dev, vq, desc->addr);
+		if (unlikely(vec[nr_vec].buf_addr == 0))
+			return -1;
+		vec[nr_vec].buf_len  = desc->len;
+		vec[nr_vec].desc_idx = desc_idx;
+		rte_prefetch0((void *)(uintptr_t)vec[nr_vec].buf_addr);
+		nr_vec++;
+
+		if ((desc->flags & VRING_DESC_F_NEXT) == 0)
+			break;
+
+		desc_idx = desc->next;
+	}
+
+	return nr_vec;
+}
+
 static bool
 is_valid_virt_queue_idx(uint32_t idx, int is_tx, uint32_t qp_nb)
 {
@@ -150,7 +315,7 @@ copy_mbuf_to_desc(struct virtio_net *dev, struct vhost_virtqueue *vq,
 	if (unlikely(desc->len < vq->vhost_hlen))
 		return -1;
 
-	desc_addr = gpa_to_vva(dev, desc->addr);
+	desc_addr = vq_gpa_to_vva(dev, vq, desc->addr);
 	rte_prefetch0((void *)(uintptr_t)desc_addr);
 
 	virtio_enqueue_offload(m, &virtio_hdr.hdr);
@@ -183,7 +348,7 @@ copy_mbuf_to_desc(struct virtio_net *dev, struct vhost_virtqueue *vq,
 				return -1;
 
 			desc = &vq->desc[desc->next];
-			desc_addr   = gpa_to_vva(dev, desc->addr);
+			desc_addr   = vq_gpa_to_vva(dev, vq, desc->addr);
 			desc_offset = 0;
 			desc_avail  = desc->len;
 		}
@@ -262,6 +427,7 @@ virtio_dev_rx(struct virtio_net *dev, uint16_t queue_id,
 	struct vhost_virtqueue *vq;
 	uint16_t res_start_idx, res_end_idx;
 	uint16_t desc_indexes[MAX_PKT_BURST];
+	struct shadow_used_ring shadow;
 	uint32_t i;
 
 	LOG_DEBUG(VHOST_DATA, "(%"PRIu64") virtio_dev_rx()\n", dev->device_fh);
@@ -277,8 +443,10 @@ virtio_dev_rx(struct virtio_net *dev, uint16_t queue_id,
 		return 0;
 
 	count = reserve_avail_buf(vq, count, &res_start_idx, &res_end_idx);
-	if (count == 0)
+	if (count == 0) {
+		vhost_vring_call(vq, 0);
 		return 0;
+	}
 
 	LOG_DEBUG(VHOST_DATA,
 		"(%"PRIu64") res_start_idx %d| res_end_idx Index %d\n",
@@ -291,28 +459,28 @@ virtio_dev_rx(struct virtio_net *dev, uint16_t queue_id,
 						  (vq->size - 1)];
 	}
 
+	shadow.used_idx = res_start_idx;
+	shadow.count = 0;
+
 	rte_prefetch0(&vq->desc[desc_indexes[0]]);
 	for (i = 0; i < count; i++) {
 		uint16_t desc_idx = desc_indexes[i];
-		uint16_t used_idx = (res_start_idx + i) & (vq->size - 1);
 		uint32_t copied;
 		int err;
 
 		err = copy_mbuf_to_desc(dev, vq, pkts[i], desc_idx, &copied);
-
-		vq->used->ring[used_idx].id = desc_idx;
 		if (unlikely(err))
-			vq->used->ring[used_idx].len = vq->vhost_hlen;
-		else
-			vq->used->ring[used_idx].len = copied + vq->vhost_hlen;
-		vhost_log_used_vring(dev, vq,
-			offsetof(struct vring_used, ring[used_idx]),
-			sizeof(vq->used->ring[used_idx]));
+			copied = 0;
+		update_shadow_used_ring(dev, vq, &shadow, desc_idx,
+					copied + vq->vhost_hlen);
 
 		if (i + 1 < count)
 			rte_prefetch0(&vq->desc[desc_indexes[i+1]]);
 	}
 
+	/* The reserved entries of the used ring are ours to write */
+	flush_shadow_used_ring(dev, vq, &shadow);
+
 	rte_smp_wmb();
 
 	/* Wait until it's our turn to add our buffer to the used ring. */
@@ -325,19 +493,13 @@ virtio_dev_rx(struct virtio_net *dev, uint16_t queue_id,
 		offsetof(struct vring_used, idx),
 		sizeof(vq->used->idx));
 
-	/* flush used->idx update before we read avail->flags. */
-	rte_mb();
-
-	/* Kick the guest if necessary. */
-	if (!(vq->avail->flags & VRING_AVAIL_F_NO_INTERRUPT)
-			&& (vq->callfd >= 0))
-		eventfd_write(vq->callfd, (eventfd_t)1);
+	vhost_vring_call(vq, count);
 	return count;
 }
 
 static inline int
-fill_vec_buf(struct vhost_virtqueue *vq, uint32_t avail_idx,
-	     uint32_t *allocated, uint32_t *vec_idx)
+fill_vec_buf(struct virtio_net *dev, struct vhost_virtqueue *vq,
+	     uint32_t avail_idx, uint32_t *allocated, uint32_t *vec_idx)
 {
 	uint16_t idx = vq->avail->ring[avail_idx & (vq->size - 1)];
 	uint32_t vec_id = *vec_idx;
@@ -348,7 +510,10 @@ fill_vec_buf(struct vhost_virtqueue *vq, uint32_t avail_idx,
 			return -1;
 
 		len += vq->desc[idx].len;
-		vq->buf_vec[vec_id].buf_addr = vq->desc[idx].addr;
+		vq->buf_vec[vec_id].buf_addr = vq_gpa_to_vva(dev, vq,
+							     vq->desc[idx].addr);
+		if (unlikely(vq->buf_vec[vec_id].buf_addr == 0))
+			return -1;
 		vq->buf_vec[vec_id].buf_len  = vq->desc[idx].len;
 		vq->buf_vec[vec_id].desc_idx = idx;
 		vec_id++;
@@ -366,91 +531,58 @@ fill_vec_buf(struct vhost_virtqueue *vq, uint32_t avail_idx,
 }
 
 /*
- * As many data cores may want to access available buffers concurrently,
- * they need to be reserved.
+ * Takes the available buffers for a packet of "size" bytes, from the avail
+ * ring entry *cur_idx and the buf_vec entry *vec_idx, which are moved past
+ * them. The buffers are reserved by the caller, for the whole burst.
  *
  * Returns -1 on fail, 0 on success
  */
 static inline int
-reserve_avail_buf_mergeable(struct vhost_virtqueue *vq, uint32_t size,
-			    uint16_t *start, uint16_t *end)
+reserve_avail_buf_mergeable(struct virtio_net *dev, struct vhost_virtqueue *vq,
+			    uint32_t size, uint16_t avail_idx,
+			    uint16_t *cur_idx, uint32_t *vec_idx)
 {
-	uint16_t res_start_idx;
-	uint16_t res_cur_idx;
-	uint16_t avail_idx;
-	uint32_t allocated;
-	uint32_t vec_idx;
-	uint16_t tries;
-
-again:
-	res_start_idx = vq->last_used_idx_res;
-	res_cur_idx  = res_start_idx;
+	uint16_t res_cur_idx = *cur_idx;
+	uint32_t allocated = 0;
+	uint32_t vec_id = *vec_idx;
 
-	allocated = 0;
-	vec_idx   = 0;
-	tries     = 0;
-	while (1) {
-		avail_idx = *((volatile uint16_t *)&vq->avail->idx);
+	while (allocated < size) {
 		if (unlikely(res_cur_idx == avail_idx))
 			return -1;
 
-		if (unlikely(fill_vec_buf(vq, res_cur_idx, &allocated,
-					  &vec_idx) < 0))
+		if (unlikely(fill_vec_buf(dev, vq, res_cur_idx, &allocated,
+					  &vec_id) < 0))
 			return -1;
 
 		res_cur_idx++;
-		tries++;
-
-		if (allocated >= size)
-			break;
-
-		/*
-		 * if we tried all available ring items, and still
-		 * can't get enough buf, it means something abnormal
-		 * happened.
-		 */
-		if (unlikely(tries >= vq->size))
-			return -1;
 	}
 
-	/*
-	 * update vq->last_used_idx_res atomically.
-	 * retry again if failed.
-	 */
-	if (rte_atomic16_cmpset(&vq->last_used_idx_res,
-				res_start_idx, res_cur_idx) == 0)
-		goto again;
-
-	*start = res_start_idx;
-	*end   = res_cur_idx;
+	*cur_idx = res_cur_idx;
+	*vec_idx = vec_id;
 	return 0;
 }
 
-static inline uint32_t __attribute__((always_inline))
+static inline int __attribute__((always_inline))
 copy_mbuf_to_desc_mergeable(struct virtio_net *dev, struct vhost_virtqueue *vq,
+			    struct shadow_used_ring *shadow,
 			    uint16_t res_start_idx, uint16_t res_end_idx,
-			    struct rte_mbuf *m)
+			    uint32_t vec_idx, struct rte_mbuf *m)
 {
 	struct virtio_net_hdr_mrg_rxbuf virtio_hdr = {{0, 0, 0, 0, 0, 0}, 0};
-	uint32_t vec_idx = 0;
-	uint16_t cur_idx = res_start_idx;
 	uint64_t desc_addr;
 	uint32_t mbuf_offset, mbuf_avail;
 	uint32_t desc_offset, desc_avail;
 	uint32_t cpy_len;
-	uint16_t desc_idx, used_idx;
-
-	if (unlikely(m == NULL))
-		return 0;
+	uint16_t desc_idx;
 
 	LOG_DEBUG(VHOST_DATA,
 		"(%"PRIu64") Current Index %d| End Index %d\n",
-		dev->device_fh, cur_idx, res_end_idx);
+		dev->device_fh, res_start_idx, res_end_idx);
 
 	if (vq->buf_vec[vec_idx].buf_len < vq->vhost_hlen)
 		return -1;
 
-	desc_addr = gpa_to_vva(dev, vq->buf_vec[vec_idx].buf_addr);
+	desc_addr = vq->buf_vec[vec_idx].buf_addr;
 	rte_prefetch0((void *)(uintptr_t)desc_addr);
 
 	virtio_hdr.num_buffers = res_end_idx - res_start_idx;
@@ -459,7 +591,8 @@ copy_mbuf_to_desc_mergeable(struct virtio_net *dev, struct vhost_virtqueue *vq,
 
 	virtio_enqueue_offload(m, &virtio_hdr.hdr);
 	copy_virtio_net_hdr(vq, desc_addr, virtio_hdr);
-	vhost_log_write(dev, vq->buf_vec[vec_idx].buf_addr, vq->vhost_hlen);
+	vhost_log_write(dev, vq->desc[vq->buf_vec[vec_idx].desc_idx].addr,
+			vq->vhost_hlen);
 	PRINT_PACKET(dev, (uintptr_t)desc_addr, vq->vhost_hlen, 0);
 
 	desc_avail  = vq->buf_vec[vec_idx].buf_len - vq->vhost_hlen;
@@ -472,19 +605,13 @@ copy_mbuf_to_desc_mergeable(struct virtio_net *dev, struct vhost_virtqueue *vq,
 		if (desc_avail == 0) {
 			desc_idx = vq->buf_vec[vec_idx].desc_idx;
 
-			if (!(vq->desc[desc_idx].flags & VRING_DESC_F_NEXT)) {
-				/* Update used ring with desc information */
-				used_idx = cur_idx++ & (vq->size - 1);
-				vq->used->ring[used_idx].id  = desc_idx;
-				vq->used->ring[used_idx].len = desc_offset;
-				vhost_log_used_vring(dev, vq,
-					offsetof(struct vring_used,
-						 ring[used_idx]),
-					sizeof(vq->used->ring[used_idx]));
-			}
+			/* Update used ring with desc information */
+			if (!(vq->desc[desc_idx].flags & VRING_DESC_F_NEXT))
+				update_shadow_used_ring(dev, vq, shadow,
+							desc_idx, desc_offset);
 
 			vec_idx++;
-			desc_addr = gpa_to_vva(dev, vq->buf_vec[vec_idx].buf_addr);
+			desc_addr = vq->buf_vec[vec_idx].buf_addr;
 
 			/* Prefetch buffer address. */
 			rte_prefetch0((void *)(uintptr_t)desc_addr);
@@ -504,8 +631,9 @@ copy_mbuf_to_desc_mergeable(struct virtio_net *dev, struct vhost_virtqueue *vq,
 		rte_memcpy((void *)((uintptr_t)(desc_addr + desc_offset)),
 			rte_pktmbuf_mtod_offset(m, void *, mbuf_offset),
 			cpy_len);
-		vhost_log_write(dev, vq->buf_vec[vec_idx].buf_addr + desc_offset,
-			cpy_len);
+		vhost_log_write(dev,
+			vq->desc[vq->buf_vec[vec_idx].desc_idx].addr +
+			desc_offset, cpy_len);
 		PRINT_PACKET(dev, (uintptr_t)(desc_addr + desc_offset),
 			cpy_len, 0);
 
@@ -515,23 +643,26 @@ copy_mbuf_to_desc_mergeable(struct virtio_net *dev, struct vhost_virtqueue *vq,
 		desc_offset += cpy_len;
 	}
 
-	used_idx = cur_idx & (vq->size - 1);
-	vq->used->ring[used_idx].id = vq->buf_vec[vec_idx].desc_idx;
-	vq->used->ring[used_idx].len = desc_offset;
-	vhost_log_used_vring(dev, vq,
-		offsetof(struct vring_used, ring[used_idx]),
-		sizeof(vq->used->ring[used_idx]));
+	update_shadow_used_ring(dev, vq, shadow,
+				vq->buf_vec[vec_idx].desc_idx, desc_offset);
 
-	return res_end_idx - res_start_idx;
+	return 0;
 }
 
+/*
+ * The buffers of the whole burst are reserved at once, so the used ring
+ * is updated and the guest notified once per burst.
+ */
 static inline uint32_t __attribute__((always_inline))
 virtio_dev_merge_rx(struct virtio_net *dev, uint16_t queue_id,
 	struct rte_mbuf **pkts, uint32_t count)
 {
 	struct vhost_virtqueue *vq;
-	uint32_t pkt_idx = 0, nr_used = 0;
-	uint16_t start, end;
+	struct shadow_used_ring shadow;
+	uint16_t pkt_end[MAX_PKT_BURST];
+	uint32_t pkt_vec[MAX_PKT_BURST];
+	uint32_t pkt_idx, vec_idx, i;
+	uint16_t start, end, avail_idx, idx;
 
 	LOG_DEBUG(VHOST_DATA, "(%"PRIu64") virtio_dev_merge_rx()\n",
 		dev->device_fh);
@@ -547,46 +678,69 @@ virtio_dev_merge_rx(struct virtio_net *dev, uint16_t queue_id,
 		return 0;
 
 	count = RTE_MIN((uint32_t)MAX_PKT_BURST, count);
-	if (count == 0)
-		return 0;
+
+again:
+	start = vq->last_used_idx_res;
+	avail_idx = *((volatile uint16_t *)&vq->avail->idx);
+	end = start;
+	vec_idx = 0;
 
 	for (pkt_idx = 0; pkt_idx < count; pkt_idx++) {
 		uint32_t pkt_len = pkts[pkt_idx]->pkt_len + vq->vhost_hlen;
 
-		if (unlikely(reserve_avail_buf_mergeable(vq, pkt_len,
-							 &start, &end) < 0)) {
+		pkt_vec[pkt_idx] = vec_idx;
+		if (unlikely(reserve_avail_buf_mergeable(dev, vq, pkt_len,
+				avail_idx, &end, &vec_idx) < 0)) {
 			LOG_DEBUG(VHOST_DATA,
 				"(%" PRIu64 ") Failed to get enough desc from vring\n",
 				dev->device_fh);
 			break;
 		}
+		pkt_end[pkt_idx] = end;
+	}
 
-		nr_used = copy_mbuf_to_desc_mergeable(dev, vq, start, end,
-						      pkts[pkt_idx]);
-		rte_smp_wmb();
+	if (unlikely(pkt_idx == 0)) {
+		vhost_vring_call(vq, 0);
+		return 0;
+	}
 
-		/*
-		 * Wait until it's our turn to add our buffer
-		 * to the used ring.
-		 */
-		while (unlikely(vq->last_used_idx != start))
-			rte_pause();
+	/*
+	 * update vq->last_used_idx_res atomically.
+	 * retry again if failed.
+	 */
+	if (rte_atomic16_cmpset(&vq->last_used_idx_res, start, end) == 0)
+		goto again;
 
-		*(volatile uint16_t *)&vq->used->idx += nr_used;
-		vhost_log_used_vring(dev, vq, offsetof(struct vring_used, idx),
-			sizeof(vq->used->idx));
-		vq->last_used_idx = end;
+	shadow.used_idx = start;
+	shadow.count = 0;
+	for (i = 0, idx = start; i < pkt_idx; i++) {
+		if (unlikely(copy_mbuf_to_desc_mergeable(dev, vq, &shadow,
+				idx, pkt_end[i], pkt_vec[i], pkts[i]) < 0)) {
+			/* give the buffers back to the guest, unused */
+			for (; idx != pkt_end[i]; idx++)
+				update_shadow_used_ring(dev, vq, &shadow,
+					vq->avail->ring[idx & (vq->size - 1)],
+					0);
+		}
+		idx = pkt_end[i];
 	}
+	flush_shadow_used_ring(dev, vq, &shadow);
 
-	if (likely(pkt_idx)) {
-		/* flush used->idx update before we read avail->flags. */
-		rte_mb();
+	rte_smp_wmb();
 
-		/* Kick the guest if necessary. */
-		if (!(vq->avail->flags & VRING_AVAIL_F_NO_INTERRUPT)
-				&& (vq->callfd >= 0))
-			eventfd_write(vq->callfd, (eventfd_t)1);
-	}
+	/*
+	 * Wait until it's our turn to add our buffer
+	 * to the used ring.
+	 */
+	while (unlikely(vq->last_used_idx != start))
+		rte_pause();
+
+	*(volatile uint16_t *)&vq->used->idx += end - start;
+	vhost_log_used_vring(dev, vq, offsetof(struct vring_used, idx),
+		sizeof(vq->used->idx));
+	vq->last_used_idx = end;
+
+	vhost_vring_call(vq, end - start);
 
 	return pkt_idx;
 }
@@ -731,50 +885,163 @@ make_rarp_packet(struct rte_mbuf *rarp_mbuf, const struct ether_addr *mac)
 	return 0;
 }
 
+static inline uint64_t __attribute__((always_inline))
+gpa_to_hpa(struct virtio_net *dev, uint64_t gpa, uint64_t size)
+{
+	struct guest_page *page;
+	uint32_t i;
+
+	for (i = 0; i < dev->nr_guest_pages; i++) {
+		page = &dev->guest_pages[i];
+
+		if (gpa >= page->guest_phys_addr &&
+		    gpa + size <= page->guest_phys_addr + page->size)
+			return gpa - page->guest_phys_addr +
+			       page->host_phys_addr;
+	}
+
+	return 0;
+}
+
+static inline struct zcopy_mbuf *__attribute__((always_inline))
+get_zmbuf(struct vhost_virtqueue *vq)
+{
+	uint16_t i;
+	uint16_t idx;
+
+	if (unlikely(vq->nr_zmbuf == vq->zmbuf_size))
+		return NULL;
+
+	idx = vq->last_zmbuf_idx;
+	for (i = 0; i < vq->zmbuf_size; i++) {
+		if (vq->zmbufs[idx].in_use == 0) {
+			vq->last_zmbuf_idx = idx + 1 == vq->zmbuf_size ?
+					     0 : idx + 1;
+			vq->zmbufs[idx].in_use = 1;
+			return &vq->zmbufs[idx];
+		}
+		if (++idx == vq->zmbuf_size)
+			idx = 0;
+	}
+
+	return NULL;
+}
+
+/*
+ * Points the mbuf to the guest buffer holding the packet, instead of
+ * copying it, and keeps track of it until it is freed. Only a packet of at
+ * least VHOST_ZCOPY_MIN_LEN bytes held in one buffer, contiguous in host
+ * physical memory, is attached; the virtio net header may sit in a
+ * descriptor of its own ahead of it.
+ */
+static inline int __attribute__((always_inline))
+attach_desc_to_mbuf(struct virtio_net *dev, struct vhost_virtqueue *vq,
+		    struct rte_mbuf *m, uint16_t desc_idx)
+{
+	struct vring_desc *desc;
+	uint64_t desc_addr;
+	uint64_t buf_gpa, buf_hpa;
+	uint32_t buf_len;
+	struct virtio_net_hdr *hdr;
+	struct zcopy_mbuf *zmbuf;
+
+	desc = &vq->desc[desc_idx];
+	if (unlikely(desc->len < vq->vhost_hlen))
+		return -1;
+
+	desc_addr = vq_gpa_to_vva(dev, vq, desc->addr);
+	hdr = (struct virtio_net_hdr *)((uintptr_t)desc_addr);
+
+	buf_gpa = desc->addr + vq->vhost_hlen;
+	buf_len = desc->len - vq->vhost_hlen;
+	if (buf_len == 0) {
+		if ((desc->flags & VRING_DESC_F_NEXT) == 0 ||
+		    unlikely(desc->next >= vq->size))
+			return -1;
+		desc = &vq->desc[desc->next];
+		buf_gpa = desc->addr;
+		buf_len = desc->len;
+	}
+
+	if ((desc->flags & VRING_DESC_F_NEXT) != 0 ||
+	    buf_len < VHOST_ZCOPY_MIN_LEN || buf_len > UINT16_MAX)
+		return -1;
+
+	buf_hpa = gpa_to_hpa(dev, buf_gpa, buf_len);
+	if (buf_hpa == 0)
+		return -1;
+
+	zmbuf = get_zmbuf(vq);
+	if (unlikely(zmbuf == NULL))
+		return -1;
+
+	zmbuf->mbuf = m;
+	zmbuf->buf_addr = m->buf_addr;
+	zmbuf->buf_physaddr = m->buf_physaddr;
+	zmbuf->buf_len = m->buf_len;
+	zmbuf->desc_idx = desc_idx;
+	TAILQ_INSERT_TAIL(&vq->zmbuf_list, zmbuf, next);
+	vq->nr_zmbuf += 1;
+
+	/*
+	 * Hold a reference, so that the mbuf is not put back in its pool,
+	 * still attached to the guest buffer, once freed. Nobody else
+	 * knows the mbuf yet.
+	 */
+	rte_mbuf_refcnt_set(m, 2);
+
+	m->buf_addr = (void *)(uintptr_t)vq_gpa_to_vva(dev, vq, buf_gpa);
+	m->buf_physaddr = buf_hpa;
+	m->buf_len = buf_len;
+	m->data_off = 0;
+	m->data_len = buf_len;
+	m->pkt_len = buf_len;
+
+	PRINT_PACKET(dev, (uintptr_t)m->buf_addr, buf_len, 0);
+
+	if (hdr->flags != 0 || hdr->gso_type != VIRTIO_NET_HDR_GSO_NONE)
+		vhost_dequeue_offload(hdr, m);
+
+	return 0;
+}
+
 static inline int __attribute__((always_inline))
 copy_desc_to_mbuf(struct virtio_net *dev, struct vhost_virtqueue *vq,
 		  struct rte_mbuf *m, uint16_t desc_idx,
 		  struct rte_mempool *mbuf_pool)
 {
-	struct vring_desc *desc;
+	struct buf_vector *vec = vq->buf_vec;
 	uint64_t desc_addr;
 	uint32_t desc_avail, desc_offset;
 	uint32_t mbuf_avail, mbuf_offset;
 	uint32_t cpy_len;
 	struct rte_mbuf *cur = m, *prev = m;
 	struct virtio_net_hdr *hdr;
-	/* A counter to avoid desc dead loop chain */
-	uint32_t nr_desc = 1;
+	int nr_vec, vec_idx = 0;
 
-	desc = &vq->desc[desc_idx];
-	if (unlikely(desc->len < vq->vhost_hlen))
+	/* Translate and prefetch all the buffers before copying them */
+	nr_vec = translate_desc_chain(dev, vq, desc_idx, vec);
+	if (unlikely(nr_vec < 0 || vec[0].buf_len < vq->vhost_hlen))
 		return -1;
 
-	desc_addr = gpa_to_vva(dev, desc->addr);
-	rte_prefetch0((void *)(uintptr_t)desc_addr);
+	desc_addr = vec[0].buf_addr;
 
 	/* Retrieve virtio net header */
 	hdr = (struct virtio_net_hdr *)((uintptr_t)desc_addr);
-	desc_avail  = desc->len - vq->vhost_hlen;
+	desc_avail  = vec[0].buf_len - vq->vhost_hlen;
 	desc_offset = vq->vhost_hlen;
 
 	mbuf_offset = 0;
 	mbuf_avail  = m->buf_len - RTE_PKTMBUF_HEADROOM;
-	while (desc_avail != 0 || (desc->flags & VRING_DESC_F_NEXT) != 0) {
+	while (desc_avail != 0 || vec_idx + 1 < nr_vec) {
 		/* This desc reaches to its end, get the next one */
 		if (desc_avail == 0) {
-			if (unlikely(desc->next >= vq->size ||
-				     ++nr_desc >= vq->size))
-				return -1;
-			desc = &vq->desc[desc->next];
-
-			desc_addr = gpa_to_vva(dev, desc->addr);
-			rte_prefetch0((void *)(uintptr_t)desc_addr);
-
+			vec_idx++;
+			desc_addr   = vec[vec_idx].buf_addr;
 			desc_offset = 0;
-			desc_avail  = desc->len;
+			desc_avail  = vec[vec_idx].buf_len;
 
-			PRINT_PACKET(dev, (uintptr_t)desc_addr, desc->len, 0);
+			PRINT_PACKET(dev, (uintptr_t)desc_addr, desc_avail, 0);
 		}
 
 		/*
@@ -819,6 +1086,158 @@ copy_desc_to_mbuf(struct virtio_net *dev, struct vhost_virtqueue *vq,
 	return 0;
 }
 
+static inline void __attribute__((always_inline))
+update_used_idx(struct virtio_net *dev, struct vhost_virtqueue *vq,
+		struct shadow_used_ring *shadow, uint32_t count)
+{
+	if (count != 0) {
+		flush_shadow_used_ring(dev, vq, shadow);
+
+		rte_smp_wmb();
+		rte_smp_rmb();
+		vq->used->idx += count;
+		vhost_log_used_vring(dev, vq, offsetof(struct vring_used, idx),
+				sizeof(vq->used->idx));
+	}
+
+	vhost_vring_call(vq, count);
+}
+
+/*
+ * The attached mbuf is held by vhost with one more reference, it has been
+ * consumed once the application and the PMD have dropped theirs.
+ */
+static inline int __attribute__((always_inline))
+mbuf_is_consumed(struct rte_mbuf *m)
+{
+	return rte_mbuf_refcnt_read(m) == 1;
+}
+
+/* Points the mbuf back to its own data room. */
+static inline void __attribute__((always_inline))
+restore_mbuf(struct zcopy_mbuf *zmbuf)
+{
+	struct rte_mbuf *m = zmbuf->mbuf;
+
+	m->buf_addr = zmbuf->buf_addr;
+	m->buf_physaddr = zmbuf->buf_physaddr;
+	m->buf_len = zmbuf->buf_len;
+}
+
+static inline void __attribute__((always_inline))
+put_zmbuf(struct vhost_virtqueue *vq, struct zcopy_mbuf *zmbuf)
+{
+	TAILQ_REMOVE(&vq->zmbuf_list, zmbuf, next);
+	restore_mbuf(zmbuf);
+	rte_pktmbuf_free(zmbuf->mbuf);
+	zmbuf->mbuf = NULL;
+	zmbuf->in_use = 0;
+	vq->nr_zmbuf -= 1;
+}
+
+/*
+ * Puts the descriptors of the consumed attached mbufs in the used ring.
+ * Returns the number of entries added to the used ring, used->idx is left
+ * to the caller.
+ */
+static inline uint32_t __attribute__((always_inline))
+reclaim_zmbufs(struct virtio_net *dev, struct vhost_virtqueue *vq,
+	       struct shadow_used_ring *shadow)
+{
+	struct zcopy_mbuf *zmbuf, *next;
+	uint32_t nr_updated = 0;
+
+	for (zmbuf = TAILQ_FIRST(&vq->zmbuf_list);
+	     zmbuf != NULL; zmbuf = next) {
+		next = TAILQ_NEXT(zmbuf, next);
+
+		if (!mbuf_is_consumed(zmbuf->mbuf))
+			continue;
+
+		vq->last_used_idx++;
+		update_shadow_used_ring(dev, vq, shadow, zmbuf->desc_idx, 0);
+		nr_updated += 1;
+
+		put_zmbuf(vq, zmbuf);
+	}
+
+	return nr_updated;
+}
+
+/*
+ * Waits until the application and the PMD have freed all the attached
+ * mbufs, the guest buffers may still be read by the NIC until then, but
+ * no longer than VHOST_ZCOPY_DRAIN_TIMEOUT_MS. Returns the number of
+ * mbufs still held.
+ */
+static uint32_t
+drain_zmbufs(struct virtio_net *dev, struct vhost_virtqueue *vq)
+{
+	struct zcopy_mbuf *zmbuf;
+	uint32_t ms = 0, nr_held;
+
+	TAILQ_FOREACH(zmbuf, &vq->zmbuf_list, next) {
+		while (!mbuf_is_consumed(zmbuf->mbuf) &&
+		       ms < VHOST_ZCOPY_DRAIN_TIMEOUT_MS) {
+			usleep(1000);
+			ms++;
+		}
+	}
+
+	nr_held = 0;
+	TAILQ_FOREACH(zmbuf, &vq->zmbuf_list, next)
+		nr_held += !mbuf_is_consumed(zmbuf->mbuf);
+
+	if (nr_held != 0)
+		RTE_LOG(ERR, VHOST_CONFIG,
+			"(%"PRIu64") %u mbufs attached to guest buffers "
+			"not freed after %u ms\n",
+			dev->device_fh, nr_held, VHOST_ZCOPY_DRAIN_TIMEOUT_MS);
+
+	return nr_held;
+}
+
+void
+vhost_flush_zmbufs(struct virtio_net *dev, struct vhost_virtqueue *vq)
+{
+	struct shadow_used_ring shadow;
+	uint32_t nr_updated;
+
+	if (vq->nr_zmbuf == 0)
+		return;
+
+	/* The buffers of the mbufs still held stay out of the used ring */
+	drain_zmbufs(dev, vq);
+
+	shadow.used_idx = vq->last_used_idx;
+	shadow.count = 0;
+	nr_updated = reclaim_zmbufs(dev, vq, &shadow);
+	update_used_idx(dev, vq, &shadow, nr_updated);
+}
+
+void
+vhost_free_zmbufs(struct virtio_net *dev, struct vhost_virtqueue *vq)
+{
+	struct zcopy_mbuf *zmbuf;
+
+	if (vq->zmbufs == NULL)
+		return;
+
+	/*
+	 * The mbufs still held after the drain are pointed back to their own
+	 * data room and released by vhost, they go back to their mempool
+	 * once the application frees them.
+	 */
+	drain_zmbufs(dev, vq);
+	while ((zmbuf = TAILQ_FIRST(&vq->zmbuf_list)) != NULL)
+		put_zmbuf(vq, zmbuf);
+
+	rte_free(vq->zmbufs);
+	vq->zmbufs = NULL;
+	vq->zmbuf_size = 0;
+	vq->last_zmbuf_idx = 0;
+}
+
 uint16_t
 rte_vhost_dequeue_burst(struct virtio_net *dev, uint16_t queue_id,
 	struct rte_mempool *mbuf_pool, struct rte_mbuf **pkts, uint16_t count)
@@ -826,7 +1245,8 @@ rte_vhost_dequeue_burst(struct virtio_net *dev, uint16_t queue_id,
 	struct rte_mbuf *rarp_mbuf = NULL;
 	struct vhost_virtqueue *vq;
 	uint32_t desc_indexes[MAX_PKT_BURST];
-	uint32_t used_idx;
+	struct shadow_used_ring shadow;
+	uint32_t nr_used = 0;
 	uint32_t i = 0;
 	uint16_t free_entries;
 	uint16_t avail_idx;
@@ -842,6 +1262,15 @@ rte_vhost_dequeue_burst(struct virtio_net *dev, uint16_t queue_id,
 	if (unlikely(vq->enabled == 0))
 		return 0;
 
+	/*
+	 * Return to the guest the buffers of the attached mbufs which have
+	 * been freed since the last call.
+	 */
+	shadow.used_idx = vq->last_used_idx;
+	shadow.count = 0;
+	if (unlikely(vq->nr_zmbuf != 0))
+		nr_used = reclaim_zmbufs(dev, vq, &shadow);
+
 	/*
 	 * Construct a RARP broadcast packet, and inject it to the "pkts"
 	 * array, to looks like that guest actually send such packet.
@@ -854,7 +1283,7 @@ rte_vhost_dequeue_burst(struct virtio_net *dev, uint16_t queue_id,
 		if (rarp_mbuf == NULL) {
 			RTE_LOG(ERR, VHOST_DATA,
 				"Failed to allocate memory for mbuf.\n");
-			return 0;
+			goto update_used;
 		}
 
 		if (make_rarp_packet(rarp_mbuf, &dev->mac)) {
@@ -865,16 +1294,19 @@ rte_vhost_dequeue_burst(struct virtio_net *dev, uint16_t queue_id,
 		}
 	}
 
+	/*
+	 * Buffers attached to mbufs are still owned by vhost, the next
+	 * available entry is tracked by last_used_idx_res.
+	 */
 	avail_idx =  *((volatile uint16_t *)&vq->avail->idx);
-	free_entries = avail_idx - vq->last_used_idx;
+	free_entries = avail_idx - vq->last_used_idx_res;
 	if (free_entries == 0)
-		goto out;
+		goto update_used;
 
 	LOG_DEBUG(VHOST_DATA, "%s (%"PRIu64")\n", __func__, dev->device_fh);
 
 	/* Prefetch available ring to retrieve head indexes. */
-	used_idx = vq->last_used_idx & (vq->size - 1);
-	rte_prefetch0(&vq->avail->ring[used_idx]);
+	rte_prefetch0(&vq->avail->ring[vq->last_used_idx_res & (vq->size - 1)]);
 
 	count = RTE_MIN(count, MAX_PKT_BURST);
 	count = RTE_MIN(count, free_entries);
@@ -883,22 +1315,18 @@ rte_vhost_dequeue_burst(struct virtio_net *dev, uint16_t queue_id,
 
 	/* Retrieve all of the head indexes first to avoid caching issues. */
 	for (i = 0; i < count; i++) {
-		desc_indexes[i] = vq->avail->ring[(vq->last_used_idx + i) &
+		desc_indexes[i] = vq->avail->ring[(vq->last_used_idx_res + i) &
 					(vq->size - 1)];
 	}
 
 	/* Prefetch descriptor index. */
 	rte_prefetch0(&vq->desc[desc_indexes[0]]);
-	rte_prefetch0(&vq->used->ring[vq->last_used_idx & (vq->size - 1)]);
 
 	for (i = 0; i < count; i++) {
 		int err;
 
-		if (likely(i + 1 < count)) {
+		if (likely(i + 1 < count))
 			rte_prefetch0(&vq->desc[desc_indexes[i + 1]]);
-			rte_prefetch0(&vq->used->ring[(used_idx + 1) &
-						      (vq->size - 1)]);
-		}
 
 		pkts[i] = rte_pktmbuf_alloc(mbuf_pool);
 		if (unlikely(pkts[i] == NULL)) {
@@ -906,6 +1334,14 @@ rte_vhost_dequeue_burst(struct virtio_net *dev, uint16_t queue_id,
 				"Failed to allocate memory for mbuf.\n");
 			break;
 		}
+
+		if (unlikely(dev->dequeue_zero_copy) &&
+		    attach_desc_to_mbuf(dev, vq, pkts[i],
+					desc_indexes[i]) == 0) {
+			vq->last_used_idx_res++;
+			continue;
+		}
+
 		err = copy_desc_to_mbuf(dev, vq, pkts[i], desc_indexes[i],
 					mbuf_pool);
 		if (unlikely(err)) {
@@ -913,26 +1349,15 @@ rte_vhost_dequeue_burst(struct virtio_net *dev, uint16_t queue_id,
 			break;
 		}
 
-		used_idx = vq->last_used_idx++ & (vq->size - 1);
-		vq->used->ring[used_idx].id  = desc_indexes[i];
-		vq->used->ring[used_idx].len = 0;
-		vhost_log_used_vring(dev, vq,
-				offsetof(struct vring_used, ring[used_idx]),
-				sizeof(vq->used->ring[used_idx]));
+		vq->last_used_idx_res++;
+		vq->last_used_idx++;
+		update_shadow_used_ring(dev, vq, &shadow, desc_indexes[i], 0);
+		nr_used += 1;
 	}
 
-	rte_smp_wmb();
-	rte_smp_rmb();
-	vq->used->idx += i;
-	vhost_log_used_vring(dev, vq, offsetof(struct vring_used, idx),
-			sizeof(vq->used->idx));
-
-	/* Kick guest if required. */
-	if (!(vq->avail->flags & VRING_AVAIL_F_NO_INTERRUPT)
-			&& (vq->callfd >= 0))
-		eventfd_write(vq->callfd, (eventfd_t)1);
+update_used:
+	update_used_idx(dev, vq, &shadow, nr_used);
 
-out:
 	if (unlikely(rarp_mbuf != NULL)) {
 		/*
 		 * Inject it to the head of "pkts" array, so that switch's mac
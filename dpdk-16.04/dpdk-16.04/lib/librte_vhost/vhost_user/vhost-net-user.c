@@ -313,6 +313,9 @@ vserver_new_vq_conn(int fd, void *dat, __rte_unused int *remove)
 	vhost_set_ifname(vdev_ctx, vserver->path,
 		size);
 
+	if (vserver->flags & RTE_VHOST_USER_DEQUEUE_ZERO_COPY)
+		vhost_enable_dequeue_zero_copy(vdev_ctx);
+
 	RTE_LOG(INFO, VHOST_CONFIG, "new device, handle is %d\n", fh);
 
 	ctx->vserver = vserver;
@@ -450,10 +453,16 @@ vserver_message_handler(int connfd, void *dat, int *remove)
  * Creates and initialise the vhost server.
  */
 int
-rte_vhost_driver_register(const char *path)
+rte_vhost_driver_register_flags(const char *path, uint64_t flags)
 {
 	struct vhost_server *vserver;
 
+	if (flags & ~RTE_VHOST_USER_DEQUEUE_ZERO_COPY) {
+		RTE_LOG(ERR, VHOST_CONFIG,
+			"error: invalid flags 0x%"PRIx64"\n", flags);
+		return -1;
+	}
+
 	pthread_mutex_lock(&g_vhost_server.server_mutex);
 
 	if (g_vhost_server.vserver_cnt == MAX_VHOST_SERVER) {
@@ -477,6 +486,7 @@ rte_vhost_driver_register(const char *path)
 	}
 
 	vserver->path = strdup(path);
+	vserver->flags = flags;
 
 	fdset_add(&g_vhost_server.fdset, vserver->listenfd,
 		vserver_new_vq_conn, NULL, vserver);
@@ -487,6 +497,12 @@ rte_vhost_driver_register(const char *path)
 	return 0;
 }
 
+int
+rte_vhost_driver_register(const char *path)
+{
+	return rte_vhost_driver_register_flags(path, 0);
+}
+
 
 /**
  * Unregister the specified vhost server
@@ -43,6 +43,7 @@
 struct vhost_server {
 	char *path; /**< The path the uds is bind to. */
 	int listenfd;     /**< The listener sockfd. */
+	uint64_t flags;   /**< RTE_VHOST_USER_* flags. */
 };
 
 /* refer to hw/virtio/vhost-user.c */
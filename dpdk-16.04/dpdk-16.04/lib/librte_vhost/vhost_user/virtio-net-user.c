@@ -42,6 +42,7 @@
 
 #include <rte_common.h>
 #include <rte_log.h>
+#include <rte_memory.h>
 
 #include "virtio-net.h"
 #include "virtio-net-user.h"
@@ -96,6 +97,90 @@ vhost_backend_cleanup(struct virtio_net *dev)
 		free(dev->mem);
 		dev->mem = NULL;
 	}
+	free(dev->guest_pages);
+	dev->guest_pages = NULL;
+	dev->nr_guest_pages = 0;
+	dev->max_guest_pages = 0;
+}
+
+static int
+add_one_guest_page(struct virtio_net *dev, uint64_t guest_phys_addr,
+		   uint64_t host_phys_addr, uint64_t size)
+{
+	struct guest_page *page, *last_page;
+
+	if (dev->nr_guest_pages == dev->max_guest_pages) {
+		uint32_t max = dev->max_guest_pages ?
+			       dev->max_guest_pages * 2 : 8;
+
+		page = realloc(dev->guest_pages, max * sizeof(*page));
+		if (page == NULL)
+			return -1;
+		dev->guest_pages = page;
+		dev->max_guest_pages = max;
+	}
+
+	if (dev->nr_guest_pages > 0) {
+		last_page = &dev->guest_pages[dev->nr_guest_pages - 1];
+		/* merge if the two pages are contiguous on both sides */
+		if (guest_phys_addr == last_page->guest_phys_addr +
+				       last_page->size &&
+		    host_phys_addr == last_page->host_phys_addr +
+				      last_page->size) {
+			last_page->size += size;
+			return 0;
+		}
+	}
+
+	page = &dev->guest_pages[dev->nr_guest_pages++];
+	page->guest_phys_addr = guest_phys_addr;
+	page->host_phys_addr  = host_phys_addr;
+	page->size = size;
+
+	return 0;
+}
+
+/*
+ * Records the host physical address of each page of a region, merging
+ * the contiguous ones, for dequeue zero copy. Pages which cannot be
+ * translated are skipped: their buffers are copied.
+ */
+static int
+add_guest_pages(struct virtio_net *dev, struct virtio_memory_regions *reg,
+		uint64_t page_size)
+{
+	uint64_t reg_size = reg->memory_size;
+	uint64_t host_user_addr = reg->address_offset +
+				  reg->guest_phys_address;
+	uint64_t guest_phys_addr = reg->guest_phys_address;
+	uint64_t host_phys_addr;
+	uint64_t size;
+
+	while (reg_size > 0) {
+		size = page_size - (guest_phys_addr & (page_size - 1));
+		size = RTE_MIN(size, reg_size);
+
+		/* Fault the page in, so that it has a page frame. */
+		*(volatile uint8_t *)(uintptr_t)host_user_addr;
+		host_phys_addr = rte_mem_virt2phy((void *)(uintptr_t)
+						  host_user_addr);
+
+		/*
+		 * A null page frame number is reported when we are not
+		 * allowed to read them.
+		 */
+		if (host_phys_addr != RTE_BAD_PHYS_ADDR &&
+		    host_phys_addr >= (uint64_t)getpagesize() &&
+		    add_one_guest_page(dev, guest_phys_addr,
+				       host_phys_addr, size) < 0)
+			return -1;
+
+		host_user_addr  += size;
+		guest_phys_addr += size;
+		reg_size -= size;
+	}
+
+	return 0;
 }
 
 int
@@ -123,6 +208,7 @@ user_set_mem_table(struct vhost_device_ctx ctx, struct VhostUserMsg *pmsg)
 		free(dev->mem);
 		dev->mem = NULL;
 	}
+	dev->nr_guest_pages = 0;
 
 	dev->mem = calloc(1,
 		sizeof(struct virtio_memory) +
@@ -193,6 +279,15 @@ user_set_mem_table(struct vhost_device_ctx ctx, struct VhostUserMsg *pmsg)
 		pregion->address_offset = mapped_address -
 			pregion->guest_phys_address;
 
+		if (dev->dequeue_zero_copy &&
+		    add_guest_pages(dev, pregion, alignment) < 0) {
+			RTE_LOG(ERR, VHOST_CONFIG,
+				"(%"PRIu64") Failed to allocate memory for "
+				"guest pages\n", dev->device_fh);
+			idx++;
+			goto err_mmap;
+		}
+
 		if (memory.regions[idx].guest_phys_addr == 0) {
 			dev->mem->base_address =
 				memory.regions[idx].userspace_addr;
@@ -208,9 +303,12 @@ user_set_mem_table(struct vhost_device_ctx ctx, struct VhostUserMsg *pmsg)
 			 pregion->memory_size);
 	}
 
+	dev = vhost_mem_table_changed(dev);
+
 	return 0;
 
 err_mmap:
+	dev->nr_guest_pages = 0;
 	while (idx--) {
 		munmap((void *)(uintptr_t)pregion_orig[idx].mapped_address,
 				pregion_orig[idx].mapped_size);
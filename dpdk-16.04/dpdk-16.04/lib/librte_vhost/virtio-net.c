@@ -51,6 +51,7 @@
 #include <rte_memory.h>
 #include <rte_malloc.h>
 #include <rte_virtio_net.h>
+#include <rte_cycles.h>
 
 #include "vhost-net.h"
 #include "virtio-net.h"
@@ -123,12 +124,13 @@ get_device(struct vhost_device_ctx ctx)
 }
 
 static void
-cleanup_vq(struct vhost_virtqueue *vq, int destroy)
+cleanup_vq(struct virtio_net *dev, struct vhost_virtqueue *vq, int destroy)
 {
 	if ((vq->callfd >= 0) && (destroy != 0))
 		close(vq->callfd);
 	if (vq->kickfd >= 0)
 		close(vq->kickfd);
+	vhost_free_zmbufs(dev, vq);
 }
 
 /*
@@ -143,8 +145,10 @@ cleanup_device(struct virtio_net *dev, int destroy)
 	vhost_backend_cleanup(dev);
 
 	for (i = 0; i < dev->virt_qp_nb; i++) {
-		cleanup_vq(dev->virtqueue[i * VIRTIO_QNUM + VIRTIO_RXQ], destroy);
-		cleanup_vq(dev->virtqueue[i * VIRTIO_QNUM + VIRTIO_TXQ], destroy);
+		cleanup_vq(dev, dev->virtqueue[i * VIRTIO_QNUM + VIRTIO_RXQ],
+			   destroy);
+		cleanup_vq(dev, dev->virtqueue[i * VIRTIO_QNUM + VIRTIO_TXQ],
+			   destroy);
 	}
 }
 
@@ -206,6 +210,187 @@ reset_vring_queue_pair(struct virtio_net *dev, uint32_t qp_idx)
 	reset_vring_queue(dev->virtqueue[base_idx + VIRTIO_TXQ], qp_idx);
 }
 
+#ifdef RTE_LIBRTE_VHOST_NUMA
+/*
+ * Returns the numa node of the page at addr, faulting it in if needed,
+ * or -1 if it is unknown.
+ */
+static int
+addr_numa_node(const void *addr)
+{
+	int node;
+
+	if (get_mempolicy(&node, NULL, 0, (void *)(uintptr_t)addr,
+			  MPOL_F_NODE | MPOL_F_ADDR) < 0)
+		return -1;
+
+	return node;
+}
+
+/*
+ * Returns the numa node holding most of the guest memory, looking at the
+ * first page of each region, or -1 if it is unknown.
+ */
+static int
+guest_mem_numa_node(struct virtio_net *dev)
+{
+	struct virtio_memory_regions *reg;
+	uint64_t size[RTE_MAX_NUMA_NODES] = { 0 };
+	int node, best = -1;
+	uint32_t i;
+
+	for (i = 0; i < dev->mem->nregions; i++) {
+		reg = &dev->mem->regions[i];
+		node = addr_numa_node((void *)(uintptr_t)
+				      (reg->guest_phys_address +
+				       reg->address_offset));
+		if (node < 0 || node >= RTE_MAX_NUMA_NODES)
+			continue;
+		size[node] += reg->memory_size;
+		if (best < 0 || size[node] > size[best])
+			best = node;
+	}
+
+	return best;
+}
+
+/*
+ * Reallocate the vhost_virtqueue pair qp_idx on the given numa node.
+ */
+static void
+numa_realloc_vq_pair(struct virtio_net *dev, uint32_t qp_idx, int newnode)
+{
+	struct vhost_virtqueue *old_vq, *vq;
+	int oldnode;
+
+	old_vq = dev->virtqueue[qp_idx * VIRTIO_QNUM];
+	oldnode = addr_numa_node(old_vq);
+	if (oldnode == newnode)
+		return;
+
+	vq = rte_malloc_socket(NULL, sizeof(*vq) * VIRTIO_QNUM, 0, newnode);
+	if (vq == NULL)
+		return;
+
+	RTE_LOG(INFO, VHOST_CONFIG,
+		"(%"PRIu64") reallocate vq pair %u from %d to %d node\n",
+		dev->device_fh, qp_idx, oldnode, newnode);
+
+	memcpy(vq, old_vq, sizeof(*vq) * VIRTIO_QNUM);
+
+	/* The lists of attached mbufs point to their heads. */
+	TAILQ_INIT(&vq[VIRTIO_RXQ].zmbuf_list);
+	TAILQ_CONCAT(&vq[VIRTIO_RXQ].zmbuf_list,
+		     &old_vq[VIRTIO_RXQ].zmbuf_list, next);
+	TAILQ_INIT(&vq[VIRTIO_TXQ].zmbuf_list);
+	TAILQ_CONCAT(&vq[VIRTIO_TXQ].zmbuf_list,
+		     &old_vq[VIRTIO_TXQ].zmbuf_list, next);
+
+	rte_free(old_vq);
+
+	dev->virtqueue[qp_idx * VIRTIO_QNUM + VIRTIO_RXQ] = vq + VIRTIO_RXQ;
+	dev->virtqueue[qp_idx * VIRTIO_QNUM + VIRTIO_TXQ] = vq + VIRTIO_TXQ;
+}
+
+/*
+ * Reallocate virtio_dev and its vhost_virtqueue pairs on the numa node
+ * holding most of the guest memory, once the memory table is set. The
+ * device must not be running: its address changes.
+ */
+static struct virtio_net *
+numa_realloc(struct virtio_net *dev)
+{
+	struct virtio_net *old_dev = dev;
+	int oldnode, newnode;
+	uint32_t i;
+
+	if (dev->flags & VIRTIO_DEV_RUNNING)
+		return dev;
+
+	newnode = guest_mem_numa_node(dev);
+	if (newnode < 0) {
+		RTE_LOG(ERR, VHOST_CONFIG,
+			"(%"PRIu64") Unable to get guest memory numa "
+			"information.\n", dev->device_fh);
+		return dev;
+	}
+
+	for (i = 0; i < dev->virt_qp_nb; i++)
+		numa_realloc_vq_pair(dev, i, newnode);
+
+	oldnode = addr_numa_node(old_dev);
+	if (oldnode == newnode)
+		return dev;
+
+	dev = rte_malloc_socket(NULL, sizeof(*dev), 0, newnode);
+	if (dev == NULL)
+		return old_dev;
+
+	RTE_LOG(INFO, VHOST_CONFIG,
+		"(%"PRIu64") reallocate dev from %d to %d node\n",
+		old_dev->device_fh, oldnode, newnode);
+
+	memcpy(dev, old_dev, sizeof(*dev));
+	rte_free(old_dev);
+	vhost_devices[dev->device_fh] = dev;
+
+	return dev;
+}
+
+/*
+ * Reallocate the vhost_virtqueue pair of a vring on the same numa node as
+ * its descriptors, which may differ from the node of the device when the
+ * guest memory is spread over several nodes.
+ */
+static void
+numa_realloc_vring(struct virtio_net *dev, int index)
+{
+	int newnode;
+
+	/*
+	 * vq is allocated on pairs, we should try to do realloc
+	 * on first queue of one queue pair only.
+	 */
+	if (index % VIRTIO_QNUM != 0 || (dev->flags & VIRTIO_DEV_RUNNING))
+		return;
+
+	newnode = addr_numa_node(dev->virtqueue[index]->desc);
+	if (newnode < 0) {
+		RTE_LOG(ERR, VHOST_CONFIG,
+			"Unable to get vq numa information.\n");
+		return;
+	}
+
+	numa_realloc_vq_pair(dev, index / VIRTIO_QNUM, newnode);
+}
+
+static int
+dev_numa_node(struct virtio_net *dev)
+{
+	int node = addr_numa_node(dev);
+
+	return node < 0 ? SOCKET_ID_ANY : node;
+}
+#else
+static struct virtio_net *
+numa_realloc(struct virtio_net *dev)
+{
+	return dev;
+}
+
+static void
+numa_realloc_vring(struct virtio_net *dev __rte_unused,
+		   int index __rte_unused)
+{
+}
+
+static int
+dev_numa_node(struct virtio_net *dev __rte_unused)
+{
+	return SOCKET_ID_ANY;
+}
+#endif
+
 static int
 alloc_vring_queue_pair(struct virtio_net *dev, uint32_t qp_idx)
 {
@@ -213,8 +398,9 @@ alloc_vring_queue_pair(struct virtio_net *dev, uint32_t qp_idx)
 	uint32_t virt_rx_q_idx = qp_idx * VIRTIO_QNUM + VIRTIO_RXQ;
 	uint32_t virt_tx_q_idx = qp_idx * VIRTIO_QNUM + VIRTIO_TXQ;
 
-	virtqueue = rte_malloc(NULL,
-			       sizeof(struct vhost_virtqueue) * VIRTIO_QNUM, 0);
+	virtqueue = rte_malloc_socket(NULL,
+			       sizeof(struct vhost_virtqueue) * VIRTIO_QNUM, 0,
+			       dev_numa_node(dev));
 	if (virtqueue == NULL) {
 		RTE_LOG(ERR, VHOST_CONFIG,
 			"Failed to allocate memory for virt qp:%d.\n", qp_idx);
@@ -322,6 +508,45 @@ vhost_set_ifname(struct vhost_device_ctx ctx,
 	strncpy(dev->ifname, if_name, len);
 }
 
+/*
+ * Called by the backends once the guest memory table is set: the regions
+ * are sorted by guest physical address for gpa_to_region(), the last
+ * region cached by each virtqueue is forgotten, and the device is moved
+ * to the numa node of the guest memory. Returns the device, which may
+ * have been reallocated.
+ */
+struct virtio_net *
+vhost_mem_table_changed(struct virtio_net *dev)
+{
+	struct virtio_memory_regions *regions = dev->mem->regions;
+	struct virtio_memory_regions tmp;
+	uint32_t i, j;
+
+	for (i = 1; i < dev->mem->nregions; i++) {
+		tmp = regions[i];
+		for (j = i; j > 0 && regions[j - 1].guest_phys_address >
+				     tmp.guest_phys_address; j--)
+			regions[j] = regions[j - 1];
+		regions[j] = tmp;
+	}
+
+	for (i = 0; i < dev->virt_qp_nb * VIRTIO_QNUM; i++)
+		dev->virtqueue[i]->last_region = NULL;
+
+	return numa_realloc(dev);
+}
+
+void
+vhost_enable_dequeue_zero_copy(struct vhost_device_ctx ctx)
+{
+	struct virtio_net *dev = get_device(ctx);
+
+	if (dev == NULL)
+		return;
+
+	dev->dequeue_zero_copy = 1;
+}
+
 
 /*
  * Called from CUSE IOCTL: VHOST_SET_OWNER
@@ -427,99 +652,39 @@ vhost_set_vring_num(struct vhost_device_ctx ctx,
 	struct vhost_vring_state *state)
 {
 	struct virtio_net *dev;
+	struct vhost_virtqueue *vq;
 
 	dev = get_device(ctx);
 	if (dev == NULL)
 		return -1;
 
 	/* State->index refers to the queue index. The txq is 1, rxq is 0. */
-	dev->virtqueue[state->index]->size = state->num;
-
-	return 0;
-}
-
-/*
- * Reallocate virtio_dev and vhost_virtqueue data structure to make them on the
- * same numa node as the memory of vring descriptor.
- */
-#ifdef RTE_LIBRTE_VHOST_NUMA
-static struct virtio_net*
-numa_realloc(struct virtio_net *dev, int index)
-{
-	int oldnode, newnode;
-	struct virtio_net *old_dev;
-	struct vhost_virtqueue *old_vq, *vq;
-	int ret;
+	vq = dev->virtqueue[state->index];
+	vq->size = state->num;
 
 	/*
-	 * vq is allocated on pairs, we should try to do realloc
-	 * on first queue of one queue pair only.
+	 * In dequeue zero copy mode, each buffer of the TX ring can be
+	 * attached to an mbuf.
 	 */
-	if (index % VIRTIO_QNUM != 0)
-		return dev;
-
-	old_dev = dev;
-	vq = old_vq = dev->virtqueue[index];
-
-	ret = get_mempolicy(&newnode, NULL, 0, old_vq->desc,
-			    MPOL_F_NODE | MPOL_F_ADDR);
-
-	/* check if we need to reallocate vq */
-	ret |= get_mempolicy(&oldnode, NULL, 0, old_vq,
-			     MPOL_F_NODE | MPOL_F_ADDR);
-	if (ret) {
-		RTE_LOG(ERR, VHOST_CONFIG,
-			"Unable to get vq numa information.\n");
-		return dev;
-	}
-	if (oldnode != newnode) {
-		RTE_LOG(INFO, VHOST_CONFIG,
-			"reallocate vq from %d to %d node\n", oldnode, newnode);
-		vq = rte_malloc_socket(NULL, sizeof(*vq) * VIRTIO_QNUM, 0,
-				       newnode);
-		if (!vq)
-			return dev;
-
-		memcpy(vq, old_vq, sizeof(*vq) * VIRTIO_QNUM);
-		rte_free(old_vq);
-	}
-
-	/* check if we need to reallocate dev */
-	ret = get_mempolicy(&oldnode, NULL, 0, old_dev,
-			    MPOL_F_NODE | MPOL_F_ADDR);
-	if (ret) {
-		RTE_LOG(ERR, VHOST_CONFIG,
-			"Unable to get dev numa information.\n");
-		goto out;
-	}
-	if (oldnode != newnode) {
-		RTE_LOG(INFO, VHOST_CONFIG,
-			"reallocate dev from %d to %d node\n",
-			oldnode, newnode);
-		dev = rte_malloc_socket(NULL, sizeof(*dev), 0, newnode);
-		if (!dev) {
-			dev = old_dev;
-			goto out;
+	if (dev->dequeue_zero_copy && (state->index & 1) == VIRTIO_TXQ) {
+		vhost_free_zmbufs(dev, vq);
+
+		vq->zmbufs = rte_zmalloc(NULL,
+				vq->size * sizeof(struct zcopy_mbuf), 0);
+		if (vq->zmbufs == NULL) {
+			RTE_LOG(ERR, VHOST_CONFIG,
+				"(%"PRIu64") Failed to allocate zero copy "
+				"mbufs for vq %u\n",
+				dev->device_fh, state->index);
+			return -1;
 		}
-
-		memcpy(dev, old_dev, sizeof(*dev));
-		rte_free(old_dev);
+		vq->zmbuf_size = vq->size;
+		vq->nr_zmbuf = 0;
+		TAILQ_INIT(&vq->zmbuf_list);
 	}
 
-out:
-	dev->virtqueue[index] = vq;
-	dev->virtqueue[index + 1] = vq + 1;
-	vhost_devices[dev->device_fh] = dev;
-
-	return dev;
-}
-#else
-static struct virtio_net*
-numa_realloc(struct virtio_net *dev, int index __rte_unused)
-{
-	return dev;
+	return 0;
 }
-#endif
 
 /*
  * Called from CUSE IOCTL: VHOST_SET_VRING_ADDR
@@ -549,7 +714,7 @@ vhost_set_vring_addr(struct vhost_device_ctx ctx, struct vhost_vring_addr *addr)
 		return -1;
 	}
 
-	dev = numa_realloc(dev, addr->index);
+	numa_realloc_vring(dev, addr->index);
 	vq = dev->virtqueue[addr->index];
 
 	vq->avail = (struct vring_avail *)(uintptr_t)qva_to_vva(dev,
@@ -620,6 +785,15 @@ vhost_get_vring_base(struct vhost_device_ctx ctx, uint32_t index,
 		return -1;
 
 	state->index = index;
+
+	/*
+	 * The ring is stopped: wait for the mbufs still attached to guest
+	 * buffers to be freed and give the buffers back to the guest, so
+	 * that none is left behind.
+	 */
+	if (dev->mem != NULL)
+		vhost_flush_zmbufs(dev, dev->virtqueue[index]);
+
 	/* State->index refers to the queue index. The txq is 1, rxq is 0. */
 	state->num = dev->virtqueue[state->index]->last_used_idx;
 
@@ -740,6 +914,40 @@ int rte_vhost_enable_guest_notification(struct virtio_net *dev,
 	return 0;
 }
 
+int rte_vhost_guest_notify_coalesce(struct virtio_net *dev, uint16_t queue_id,
+	uint32_t max_pkts, uint32_t max_usec)
+{
+	struct vhost_virtqueue *vq;
+
+	if (dev == NULL || queue_id >= dev->virt_qp_nb * VIRTIO_QNUM ||
+	    dev->virtqueue[queue_id] == NULL) {
+		RTE_LOG(ERR, VHOST_CONFIG,
+			"invalid virtqueue %u for notification coalescing.\n",
+			queue_id);
+		return -1;
+	}
+
+	vq = dev->virtqueue[queue_id];
+	vq->notify_max_pkts = max_pkts;
+	vq->notify_cycles = rte_get_tsc_hz() * max_usec / US_PER_S;
+	vq->nr_notify_pending = 0;
+
+	return 0;
+}
+
+int rte_vhost_get_numa_node(struct virtio_net *dev)
+{
+#ifdef RTE_LIBRTE_VHOST_NUMA
+	if (dev == NULL)
+		return -1;
+
+	return addr_numa_node(dev);
+#else
+	RTE_SET_USED(dev);
+	return -1;
+#endif
+}
+
 uint64_t rte_vhost_feature_get(void)
 {
 	return VHOST_FEATURES;